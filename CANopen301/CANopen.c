@@ -92,6 +92,8 @@
             || (CO_NO_RPDO < 1 || CO_NO_RPDO > 0x200)              \
             || (CO_NO_TPDO < 1 || CO_NO_TPDO > 0x200)              \
             || ODL_consumerHeartbeatTime_arrayLength      == 0     \
+            || (CO_NO_LSS_SERVER != 0 && CO_NO_LSS_SERVER != 1)    \
+            || (CO_NO_LSS_CLIENT != 0 && CO_NO_LSS_CLIENT != 1)    \
             || ODL_errorStatusBits_stringLength           < 10
         #error Features from CO_OD.h file are not corectly configured for this project!
     #endif
@@ -110,8 +112,10 @@
     #define CO_RXCAN_SDO_SRV  (CO_RXCAN_RPDO+CO_NO_RPDO)              /*  start index for SDO server message (request) */
     #define CO_RXCAN_SDO_CLI  (CO_RXCAN_SDO_SRV+CO_NO_SDO_SERVER)     /*  start index for SDO client message (response) */
     #define CO_RXCAN_CONS_HB  (CO_RXCAN_SDO_CLI+CO_NO_SDO_CLIENT)     /*  start index for Heartbeat Consumer messages */
+    #define CO_RXCAN_LSS_SLV  (CO_RXCAN_CONS_HB+CO_NO_HB_CONS)        /*  index for LSS slave message (request) */
+    #define CO_RXCAN_LSS_MST  (CO_RXCAN_LSS_SLV+CO_NO_LSS_SERVER)     /*  index for LSS master message (response) */
     /* total number of received CAN messages */
-    #define CO_RXCAN_NO_MSGS (1+CO_NO_SYNC+CO_NO_RPDO+CO_NO_SDO_SERVER+CO_NO_SDO_CLIENT+CO_NO_HB_CONS)
+    #define CO_RXCAN_NO_MSGS (1+CO_NO_SYNC+CO_NO_RPDO+CO_NO_SDO_SERVER+CO_NO_SDO_CLIENT+CO_NO_HB_CONS+CO_NO_LSS_SERVER+CO_NO_LSS_CLIENT)
 
     #define CO_TXCAN_NMT       0                                      /*  index for NMT master message */
     #define CO_TXCAN_SYNC      CO_TXCAN_NMT+CO_NO_NMT_MASTER          /*  index for SYNC message */
@@ -120,8 +124,10 @@
     #define CO_TXCAN_SDO_SRV  (CO_TXCAN_TPDO+CO_NO_TPDO)              /*  start index for SDO server message (response) */
     #define CO_TXCAN_SDO_CLI  (CO_TXCAN_SDO_SRV+CO_NO_SDO_SERVER)     /*  start index for SDO client message (request) */
     #define CO_TXCAN_HB       (CO_TXCAN_SDO_CLI+CO_NO_SDO_CLIENT)     /*  index for Heartbeat message */
+    #define CO_TXCAN_LSS_SLV  (CO_TXCAN_HB+1)                         /*  index for LSS slave message (response) */
+    #define CO_TXCAN_LSS_MST  (CO_TXCAN_LSS_SLV+CO_NO_LSS_SERVER)     /*  index for LSS master message (request) */
     /* total number of transmitted CAN messages */
-    #define CO_TXCAN_NO_MSGS (CO_NO_NMT_MASTER+CO_NO_SYNC+CO_NO_EMERGENCY+CO_NO_TPDO+CO_NO_SDO_SERVER+CO_NO_SDO_CLIENT+1)
+    #define CO_TXCAN_NO_MSGS (CO_NO_NMT_MASTER+CO_NO_SYNC+CO_NO_EMERGENCY+CO_NO_TPDO+CO_NO_SDO_SERVER+CO_NO_SDO_CLIENT+1+CO_NO_LSS_SERVER+CO_NO_LSS_CLIENT)
 
 
 #ifdef CO_USE_GLOBALS
@@ -146,6 +152,12 @@
     static uint32_t             COO_traceTimeBuffers[CO_NO_TRACE][CO_TRACE_BUFFER_SIZE_FIXED];
     static int32_t              COO_traceValueBuffers[CO_NO_TRACE][CO_TRACE_BUFFER_SIZE_FIXED];
 #endif
+#if CO_NO_LSS_SERVER == 1
+    static CO_LSSslave_t        COO_LSSslave;
+#endif
+#if CO_NO_LSS_CLIENT == 1
+    static CO_LSSmaster_t       COO_LSSmaster;
+#endif
 #endif
 
 
@@ -252,6 +264,12 @@ CO_ReturnError_t CO_init(
         CO_traceValueBuffers[i]         = &COO_traceValueBuffers[i][0];
         CO_traceBufferSize[i]           = CO_TRACE_BUFFER_SIZE_FIXED;
     }
+  #endif
+  #if CO_NO_LSS_SERVER == 1
+    CO->LSSslave                        = &COO_LSSslave;
+  #endif
+  #if CO_NO_LSS_CLIENT == 1
+    CO->LSSmaster                       = &COO_LSSmaster;
   #endif
 		CO->UI_Handler	=	pHandle;
 #else
@@ -290,6 +308,12 @@ CO_ReturnError_t CO_init(
                 CO_traceBufferSize[i] = 0;
             }
         }
+      #endif
+      #if CO_NO_LSS_SERVER == 1
+        CO->LSSslave                        = (CO_LSSslave_t *)     calloc(1, sizeof(CO_LSSslave_t));
+      #endif
+      #if CO_NO_LSS_CLIENT == 1
+        CO->LSSmaster                       = (CO_LSSmaster_t *)    calloc(1, sizeof(CO_LSSmaster_t));
       #endif
 				CO->UI_Handler	=	pHandle;
     }
@@ -309,6 +333,12 @@ CO_ReturnError_t CO_init(
                   + sizeof(CO_HBconsNode_t) * CO_NO_HB_CONS
   #if CO_NO_SDO_CLIENT == 1
                   + sizeof(CO_SDOclient_t)
+  #endif
+  #if CO_NO_LSS_SERVER == 1
+                  + sizeof(CO_LSSslave_t)
+  #endif
+  #if CO_NO_LSS_CLIENT == 1
+                  + sizeof(CO_LSSmaster_t)
   #endif
                   + 0;
   #if CO_NO_TRACE > 0
@@ -346,6 +376,12 @@ CO_ReturnError_t CO_init(
         if(CO->trace[i]                 == NULL) errCnt++;
     }
   #endif
+  #if CO_NO_LSS_SERVER == 1
+    if(CO->LSSslave                     == NULL) errCnt++;
+  #endif
+  #if CO_NO_LSS_CLIENT == 1
+    if(CO->LSSmaster                    == NULL) errCnt++;
+  #endif
 
     if(errCnt != 0) return CO_ERROR_OUT_OF_MEMORY;
 #endif
@@ -355,7 +391,12 @@ CO_ReturnError_t CO_init(
 //    CO_CANsetConfigurationMode(CANbaseAddress);
 
     /* Verify CANopen Node-ID */
-    if(nodeId<1 || nodeId>127)
+#if CO_NO_LSS_SERVER == 1
+    CO->nodeIdUnconfigured = (nodeId == CO_LSS_NODE_ID_ASSIGNMENT) ? true : false;
+#else
+    CO->nodeIdUnconfigured = false;
+#endif
+    if((nodeId<1 || nodeId>127) && !CO->nodeIdUnconfigured)
     {
         CO_delete(CANbaseAddress);
         return CO_ERROR_PARAMETERS;
@@ -373,6 +414,54 @@ CO_ReturnError_t CO_init(
 
     if(err){CO_delete(CANbaseAddress); return err;}
 
+
+#if CO_NO_LSS_SERVER == 1
+    {
+        CO_LSS_address_t lssAddress;
+
+        lssAddress.identity.vendorID = OD_identity.vendorID;
+        lssAddress.identity.productCode = OD_identity.productCode;
+        lssAddress.identity.revisionNumber = OD_identity.revisionNumber;
+        lssAddress.identity.serialNumber = OD_identity.serialNumber;
+
+        err = CO_LSSslave_init(
+                CO->LSSslave,
+               &lssAddress,
+                bitRate,
+                nodeId,
+                CO->CANmodule[0],
+                CO_RXCAN_LSS_SLV,
+                CO_CAN_ID_LSS_CLI,
+                CO->CANmodule[0],
+                CO_TXCAN_LSS_SLV,
+                CO_CAN_ID_LSS_SRV);
+    }
+
+    if(err){CO_delete(CANbaseAddress); return err;}
+#endif
+
+
+#if CO_NO_LSS_CLIENT == 1
+    err = CO_LSSmaster_init(
+            CO->LSSmaster,
+            CO_LSSmaster_DEFAULT_TIMEOUT,
+            CO->CANmodule[0],
+            CO_RXCAN_LSS_MST,
+            CO_CAN_ID_LSS_SRV,
+            CO->CANmodule[0],
+            CO_TXCAN_LSS_MST,
+            CO_CAN_ID_LSS_CLI);
+
+    if(err){CO_delete(CANbaseAddress); return err;}
+#endif
+
+
+    /* Other objects need node ID, they are initialized after LSS assignment. */
+    if(CO->nodeIdUnconfigured){
+        return CO_ERROR_NO;
+    }
+
+
     for (i=0; i<CO_NO_SDO_SERVER; i++)
     {
         uint32_t COB_IDClientToServer;
@@ -571,6 +660,12 @@ void CO_delete(int32_t CANbaseAddress){
     CO_CANmodule_disable(CO->CANmodule[0]);
 
 #ifndef CO_USE_GLOBALS
+  #if CO_NO_LSS_CLIENT == 1
+    free(CO->LSSmaster);
+  #endif
+  #if CO_NO_LSS_SERVER == 1
+    free(CO->LSSslave);
+  #endif
   #if CO_NO_TRACE > 0
       for(i=0; i<CO_NO_TRACE; i++) {
           free(CO->trace[i]);
@@ -616,6 +711,16 @@ CO_NMT_reset_cmd_t CO_process(
     CO_NMT_reset_cmd_t reset = CO_RESET_NOT;
     static uint16_t ms50 = 0;
 
+#if CO_NO_LSS_SERVER == 1
+    if(CO_LSSslave_process(CO->LSSslave)){
+        /* LSS master assigned node ID or activated new bit rate */
+        return CO_RESET_COMM;
+    }
+#endif
+    if(CO->nodeIdUnconfigured){
+        return CO_RESET_NOT;
+    }
+
     if(CO->NMT->operatingState == CO_NMT_PRE_OPERATIONAL || CO->NMT->operatingState == CO_NMT_OPERATIONAL)
         NMTisPreOrOperational = true;
 
@@ -731,7 +836,7 @@ void CO_tmr_Task_thread(void)
 
 //        INCREMENT_1MS(CO_timer1ms);			/* move to sys_tick_handler */
 	/* sys_tick run , other process non initilizer */
-        if(CO->CANmodule[0]->CANnormal) {
+        if(CO->CANmodule[0]->CANnormal && !CO->nodeIdUnconfigured) {
             bool_t syncWas;
             /* Process Sync and read inputs */
             syncWas = CO_process_SYNC_RPDO(CO, TMR_TASK_INTERVAL);
@@ -85,6 +85,18 @@ extern "C" {
 #if CO_NO_SDO_CLIENT == 1
     #include "CO_SDOmaster.h"
 #endif
+#ifndef CO_NO_LSS_SERVER
+    #define CO_NO_LSS_SERVER    0
+#endif
+#ifndef CO_NO_LSS_CLIENT
+    #define CO_NO_LSS_CLIENT    0
+#endif
+#if CO_NO_LSS_SERVER == 1
+    #include "CO_LSSslave.h"
+#endif
+#if CO_NO_LSS_CLIENT == 1
+    #include "CO_LSSmaster.h"
+#endif
 #if CO_NO_TRACE > 0
     #include "CO_trace.h"
 #endif
@@ -113,7 +125,9 @@ typedef enum{
      CO_CAN_ID_RPDO_4            = 0x500,   /**< 0x500, Default RPDO5 (+nodeID) */
      CO_CAN_ID_TSDO              = 0x580,   /**< 0x580, SDO response from server (+nodeID) */
      CO_CAN_ID_RSDO              = 0x600,   /**< 0x600, SDO request from client (+nodeID) */
-     CO_CAN_ID_HEARTBEAT         = 0x700    /**< 0x700, Heartbeat message */
+     CO_CAN_ID_HEARTBEAT         = 0x700,   /**< 0x700, Heartbeat message */
+     CO_CAN_ID_LSS_SRV           = 0x7E4,   /**< 0x7E4, LSS response from slave */
+     CO_CAN_ID_LSS_CLI           = 0x7E5    /**< 0x7E5, LSS request from master */
 }CO_Default_CAN_ID_t;
 
 
@@ -136,6 +150,15 @@ typedef struct{
 #if CO_NO_TRACE > 0
     CO_trace_t         *trace[CO_NO_TRACE]; /**< Trace object for monitoring variables */
 #endif
+#if CO_NO_LSS_SERVER == 1
+    CO_LSSslave_t      *LSSslave;       /**< LSS slave object */
+#endif
+#if CO_NO_LSS_CLIENT == 1
+    CO_LSSmaster_t     *LSSmaster;      /**< LSS master object */
+#endif
+    /** True, if node waits for LSS node ID assignment. Then only CAN module and
+        LSS slave are initialized, all other objects are not processed. */
+    bool_t              nodeIdUnconfigured;
 	/* author add control motor	object,date:2019-8-11	*/
 		UI_Handle_t				*UI_Handler;
 	
@@ -171,7 +194,9 @@ typedef struct{
  * Function must be called in the communication reset section.
  *
  * @param CANbaseAddress Address of the CAN module, passed to CO_CANmodule_init().
- * @param nodeId Node ID of the CANopen device (1 ... 127).
+ * @param nodeId Node ID of the CANopen device (1 ... 127). If LSS slave is
+ * enabled, it may be CO_LSS_NODE_ID_ASSIGNMENT. Node then waits for the LSS
+ * master and CO_process() returns CO_RESET_COMM, when node ID is assigned.
  * @param nodeId CAN bit rate.
  *
  * @return #CO_ReturnError_t: CO_ERROR_NO, CO_ERROR_ILLEGAL_ARGUMENT,
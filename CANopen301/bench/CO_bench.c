@@ -0,0 +1,497 @@
+/*
+ * Host micro-benchmarks of the per-frame and per-tick costs of the stack.
+ *
+ * @file        CO_bench.c
+ * @author      Janez Paternoster
+ * @copyright   2015 Janez Paternoster
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/* One node of cosim/CO_simNode.c is linked statically with the simCAN driver.
+ * Benchmark feeds frames into the receive interrupt, calls the processing
+ * functions directly and completes transmitted frames like the bus would.
+ * Every operation verifies the frames it produced, so a broken protocol
+ * fails the benchmark instead of making it faster.
+ *
+ * Result is printed as JSON with fixed names and order: median ns/op of
+ * several repetitions and frames/s for operations, which carry frames.
+ *
+ * CO_CANrxWait() exists only in the socketCAN driver. Receive dispatch is
+ * measured with CO_CANinterrupt_Rx() of simCAN, the same linear filter
+ * search as in STM32F3/CO_driver.c.
+ *
+ * Built twice by "make bench": CO_bench with the stack as in the firmware and
+ * CO_bench_odext with TPDO_CALLS_EXTENSION and RPDO_CALLS_EXTENSION, where
+ * mapped objects have OD extensions registered. */
+
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "CANopen.h"
+#include "crc16-ccitt.h"
+#include "CO_simNode.h"
+
+
+#define BENCH_NODE_ID           1
+#define BENCH_HB_NODES          127
+#define BENCH_HB_PERIOD_MS      100     /* heartbeat of monitored nodes */
+#define BENCH_HB_CONS_TIME_MS   300
+#define BENCH_REPEAT_MAX        31
+
+#ifdef CO_BENCH_OD_EXTENSIONS
+    #define BENCH_OD_EXTENSIONS "true"
+#else
+    #define BENCH_OD_EXTENSIONS "false"
+#endif
+
+
+static CO_CANsimPort_t      port;
+static CO_CANrxMsg_t        benchTx[16];    /* frames sent by the last step */
+static unsigned             benchTxCount;
+
+static CO_CANmodule_t       hbCAN;
+static CO_CANrx_t           hbRx[BENCH_HB_NODES];
+static CO_CANtx_t           hbTx[1];
+static CO_HBconsumer_t      hbCons;
+static CO_HBconsNode_t      hbNodes[BENCH_HB_NODES];
+static uint32_t             hbTime[BENCH_HB_NODES];
+
+static volatile uint32_t    benchSink;      /* keeps results alive */
+
+
+/* Helpers ********************************************************************/
+static void bench_fail(const char *name, const char *what){
+    fprintf(stderr, "CO_bench: %s: %s\n", name, what);
+    exit(EXIT_FAILURE);
+}
+
+/* Complete all requested mailboxes as the bus would, keep the frames */
+static unsigned bench_drain(void){
+    benchTxCount = 0;
+    while(port.txRequest != 0U){
+        unsigned m;
+        for(m = 0; m < CO_CAN_NO_TX_MAILBOXES; m++){
+            if((port.txRequest & (1U << m)) != 0U){
+                if(benchTxCount < sizeof(benchTx) / sizeof(benchTx[0])){
+                    benchTx[benchTxCount] = port.txMailbox[m];
+                }
+                benchTxCount++;
+                port.txRequest &= (uint8_t)~(1U << m);
+                port.txComplete |= (uint8_t)(1U << m);
+            }
+        }
+        CO_CANinterrupt_Tx(CO->CANmodule[0]);
+    }
+    return benchTxCount;
+}
+
+static void bench_rx(CO_CANmodule_t *CANmodule, uint16_t ident, uint8_t DLC, const uint8_t data[]){
+    port.rxMsg.ident = ident;
+    port.rxMsg.DLC = DLC;
+    memcpy(port.rxMsg.data, data, DLC);
+    CO_CANinterrupt_Rx(CANmodule);
+}
+
+/* SDO client request, one pass of the SDO server and its response */
+static unsigned bench_sdo(const uint8_t request[8]){
+    bench_rx(CO->CANmodule[0], CO_CAN_ID_RSDO + BENCH_NODE_ID, 8, request);
+    CO_SDO_process(CO->SDO[0], true, 0, 1000, NULL, NULL);
+    return bench_drain();
+}
+
+/* SDO server pass without new request, block upload sends next segment */
+static unsigned bench_sdoStep(void){
+    CO_SDO_process(CO->SDO[0], true, 0, 1000, NULL, NULL);
+    return bench_drain();
+}
+
+#ifdef CO_BENCH_OD_EXTENSIONS
+static CO_SDO_abortCode_t bench_ODF(CO_ODF_arg_t *ODF_arg){
+    benchSink += ODF_arg->dataLength;
+    return CO_SDO_AB_NONE;
+}
+#endif
+
+
+/* Receive dispatch ***********************************************************/
+static void bench_rxDispatchHit(uint32_t n){
+    static const uint8_t data[CO_SIM_RPDO_LENGTH] = {0xDC, 0x05, CO_SIM_CONTROL_ENABLE};
+    while(n--){
+        bench_rx(CO->CANmodule[0], CO_CAN_ID_RPDO_1 + BENCH_NODE_ID, CO_SIM_RPDO_LENGTH, data);
+    }
+    if(!CO->RPDO[0]->CANrxNew[0]) bench_fail("rx_dispatch_rpdo", "RPDO not received");
+    CO->RPDO[0]->CANrxNew[0] = false;
+}
+
+static void bench_rxDispatchMiss(uint32_t n){
+    static const uint8_t data[8] = {0};
+    /* identifier, which no filter accepts, scans the whole array */
+    while(n--){
+        bench_rx(CO->CANmodule[0], 0x3FF, 8, data);
+    }
+}
+
+
+/* SDO server *****************************************************************/
+/* 1017h, producer heartbeat time, UNSIGNED16 */
+static void bench_sdoUploadExpedited(uint32_t n){
+    static const uint8_t req[8] = {0x40, 0x17, 0x10, 0x00, 0, 0, 0, 0};
+    while(n--){
+        if(bench_sdo(req) != 1 || benchTx[0].data[0] != 0x4B){
+            bench_fail("sdo_upload_expedited", "wrong response");
+        }
+    }
+}
+
+static void bench_sdoDownloadExpedited(uint32_t n){
+    uint8_t req[8] = {0x2B, 0x17, 0x10, 0x00, 0, 0, 0, 0};
+    req[4] = (uint8_t)OD_producerHeartbeatTime;
+    req[5] = (uint8_t)(OD_producerHeartbeatTime >> 8);
+    while(n--){
+        if(bench_sdo(req) != 1 || benchTx[0].data[0] != 0x60){
+            bench_fail("sdo_download_expedited", "wrong response");
+        }
+    }
+}
+
+/* 2130h sub 1, VISIBLE_STRING of 30 bytes: 5 segments */
+static void bench_sdoUploadSegmented(uint32_t n){
+    static const uint8_t init[8] = {0x40, 0x30, 0x21, 0x01, 0, 0, 0, 0};
+    while(n--){
+        uint8_t req[8] = {0x60, 0, 0, 0, 0, 0, 0, 0};
+        if(bench_sdo(init) != 1 || benchTx[0].data[0] != 0x41 || benchTx[0].data[4] != 30){
+            bench_fail("sdo_upload_segmented", "wrong initiate response");
+        }
+        do{
+            if(bench_sdo(req) != 1 || (benchTx[0].data[0] & 0xE0U) != 0x00U){
+                bench_fail("sdo_upload_segmented", "wrong segment");
+            }
+            req[0] ^= 0x10;
+        }while((benchTx[0].data[0] & 0x01U) == 0U);
+    }
+}
+
+/* 2120h sub 1, INTEGER64: segments of 7 and 1 byte */
+static void bench_sdoDownloadSegmented(uint32_t n){
+    static const uint8_t init[8] = {0x21, 0x20, 0x21, 0x01, 8, 0, 0, 0};
+    uint8_t seg1[8] = {0x00, 0, 0, 0, 0, 0, 0, 0};
+    uint8_t seg2[8] = {0x1D, 0, 0, 0, 0, 0, 0, 0};
+    memcpy(&seg1[1], &OD_testVar.I64, 7);
+    memcpy(&seg2[1], (uint8_t*)&OD_testVar.I64 + 7, 1);
+    while(n--){
+        if(bench_sdo(init) != 1 || benchTx[0].data[0] != 0x60
+           || bench_sdo(seg1) != 1 || benchTx[0].data[0] != 0x20
+           || bench_sdo(seg2) != 1 || benchTx[0].data[0] != 0x30){
+            bench_fail("sdo_download_segmented", "wrong response");
+        }
+    }
+}
+
+/* 2130h sub 1 in one sub-block with CRC */
+static void bench_sdoUploadBlock(uint32_t n){
+    static const uint8_t init[8] = {0xA4, 0x30, 0x21, 0x01, 127, 0, 0, 0};
+    static const uint8_t start[8] = {0xA3, 0, 0, 0, 0, 0, 0, 0};
+    static const uint8_t end[8] = {0xA1, 0, 0, 0, 0, 0, 0, 0};
+    while(n--){
+        uint8_t ack[8] = {0xA2, 0, 127, 0, 0, 0, 0, 0};
+        if(bench_sdo(init) != 1 || benchTx[0].data[0] != 0xC6){
+            bench_fail("sdo_upload_block", "wrong initiate response");
+        }
+        if(bench_sdo(start) != 1){
+            bench_fail("sdo_upload_block", "no first segment");
+        }
+        while((benchTx[0].data[0] & 0x80U) == 0U){
+            if(bench_sdoStep() != 1){
+                bench_fail("sdo_upload_block", "no segment");
+            }
+        }
+        ack[1] = benchTx[0].data[0] & 0x7FU;
+        if(bench_sdo(ack) != 1 || (benchTx[0].data[0] & 0xE3U) != 0xC1U){
+            bench_fail("sdo_upload_block", "wrong end");
+        }
+        if(bench_sdo(end) != 0 || CO->SDO[0]->state != CO_SDO_ST_IDLE){
+            bench_fail("sdo_upload_block", "not finished");
+        }
+    }
+}
+
+/* 2120h sub 1 in one sub-block of 2 segments with CRC */
+static void bench_sdoDownloadBlock(uint32_t n){
+    static const uint8_t init[8] = {0xC6, 0x20, 0x21, 0x01, 8, 0, 0, 0};
+    uint8_t seg1[8] = {0x01, 0, 0, 0, 0, 0, 0, 0};
+    uint8_t seg2[8] = {0x82, 0, 0, 0, 0, 0, 0, 0};
+    uint8_t end[8] = {0xC1 | (6 << 2), 0, 0, 0, 0, 0, 0, 0};
+    uint16_t crc;
+
+    memcpy(&seg1[1], &OD_testVar.I64, 7);
+    memcpy(&seg2[1], (uint8_t*)&OD_testVar.I64 + 7, 1);
+    crc = crc16_ccitt((const unsigned char*)&OD_testVar.I64, 8, 0);
+    end[1] = (uint8_t)crc;
+    end[2] = (uint8_t)(crc >> 8);
+
+    while(n--){
+        if(bench_sdo(init) != 1 || benchTx[0].data[0] != 0xA4){
+            bench_fail("sdo_download_block", "wrong initiate response");
+        }
+        bench_rx(CO->CANmodule[0], CO_CAN_ID_RSDO + BENCH_NODE_ID, 8, seg1);
+        if(bench_sdo(seg2) != 1 || benchTx[0].data[0] != 0xA2 || benchTx[0].data[1] != 2){
+            bench_fail("sdo_download_block", "wrong sub-block response");
+        }
+        if(bench_sdo(end) != 1 || benchTx[0].data[0] != 0xA1){
+            bench_fail("sdo_download_block", "wrong end response");
+        }
+    }
+}
+
+
+/* PDO ************************************************************************/
+static void bench_tpdoSend(uint32_t n){
+    while(n--){
+        CO_TPDOsend(CO->TPDO[0]);
+        if(bench_drain() != 1 || benchTx[0].DLC != CO_SIM_TPDO_LENGTH){
+            bench_fail("tpdo_send", "TPDO not sent");
+        }
+    }
+}
+
+static void bench_rpdoProcess(uint32_t n){
+    while(n--){
+        /* as set by the receive interrupt */
+        CO->RPDO[0]->CANrxNew[0] = true;
+        CO_RPDO_process(CO->RPDO[0], false);
+    }
+    if(CO_OD_RAM.ControlWord != CO_SIM_CONTROL_ENABLE){
+        bench_fail("rpdo_process", "RPDO not copied");
+    }
+}
+
+
+/* Object dictionary **********************************************************/
+/* all existing indexes, result is per lookup */
+static void bench_odFind(uint32_t n){
+    CO_SDO_t *SDO = CO->SDO[0];
+    uint16_t i = 0;
+    while(n--){
+        if(CO_OD_find(SDO, SDO->OD[i].index) != i) bench_fail("od_find", "wrong entry");
+        if(++i == SDO->ODSize) i = 0;
+    }
+}
+
+static void bench_odFindMissing(uint32_t n){
+    while(n--){
+        benchSink += CO_OD_find(CO->SDO[0], 0x5FFF);
+    }
+}
+
+
+/* Heartbeat consumer *********************************************************/
+/* 1 ms tick with 127 nodes, each node sends heartbeat every 100 ms */
+static void bench_hbConsumer(uint32_t n){
+    static unsigned tick;
+    while(n--){
+        if(++tick == BENCH_HB_PERIOD_MS){
+            unsigned i;
+            tick = 0;
+            for(i = 0; i < BENCH_HB_NODES; i++) hbNodes[i].CANrxNew = true;
+        }
+        CO_HBconsumer_process(&hbCons, true, 1);
+    }
+    if(hbCons.allMonitoredOperational != CO_NMT_OPERATIONAL){
+        bench_fail("hbconsumer_process_127", "monitored node lost");
+    }
+}
+
+
+/* Emergency ******************************************************************/
+static void bench_emProcess(uint32_t n){
+    while(n--){
+        CO_EM_process(CO->emPr, true, 10, 0);
+    }
+}
+
+static void bench_emReportReset(uint32_t n){
+    while(n--){
+        CO_errorReport(CO->em, CO_EM_GENERIC_ERROR, CO_EMC_GENERIC, n);
+        CO_EM_process(CO->emPr, true, 10, 0);
+        if(bench_drain() != 1 || benchTx[0].data[1] != (CO_EMC_GENERIC >> 8)){
+            bench_fail("em_report_reset", "EMCY not sent");
+        }
+        CO_errorReset(CO->em, CO_EM_GENERIC_ERROR, 0);
+        CO_EM_process(CO->emPr, true, 10, 0);
+        if(bench_drain() != 1 || benchTx[0].data[1] != 0){
+            bench_fail("em_report_reset", "EMCY reset not sent");
+        }
+    }
+}
+
+
+/* Setup **********************************************************************/
+static void bench_init(void){
+    CO_simNodeConfig_t config;
+    static const uint8_t nmtStart[2] = {CO_NMT_ENTER_OPERATIONAL, 0};
+    unsigned i;
+
+    memset(&config, 0, sizeof(config));
+    config.nodeId = BENCH_NODE_ID;
+    config.bitRate = 1000;
+    config.heartbeat_ms = 100;
+    config.rpdoTransmissionType = 255;
+    config.tpdoTransmissionType = 255;
+    config.motorTau_ms = 50;
+
+    port.txOnBus = CO_CAN_SIM_MAILBOX_NONE;
+    if(CO_simNodeApi.init(&port, &config) != CO_ERROR_NO){
+        bench_fail("init", "CO_init() failed");
+    }
+    CO_simNodeApi.process();
+    bench_rx(CO->CANmodule[0], CO_CAN_ID_NMT_SERVICE, 2, nmtStart);
+    bench_drain();
+    if(CO->NMT->operatingState != CO_NMT_OPERATIONAL){
+        bench_fail("init", "node not operational");
+    }
+
+#ifdef CO_BENCH_OD_EXTENSIONS
+    CO_OD_configure(CO->SDO[0], (uint16_t)(CO_SIM_RPDO_MAP1 >> 16), bench_ODF, NULL, NULL, 0);
+    CO_OD_configure(CO->SDO[0], (uint16_t)(CO_SIM_RPDO_MAP2 >> 16), bench_ODF, NULL, NULL, 0);
+    CO_OD_configure(CO->SDO[0], (uint16_t)(CO_SIM_TPDO_MAP1 >> 16), bench_ODF, NULL, NULL, 0);
+    CO_OD_configure(CO->SDO[0], (uint16_t)(CO_SIM_TPDO_MAP2 >> 16), bench_ODF, NULL, NULL, 0);
+#endif
+
+    /* heartbeat consumer with its own receive buffers for 127 nodes */
+    if(CO_CANmodule_init(&hbCAN, NULL, hbRx, BENCH_HB_NODES, hbTx, 1, 1000) != CO_ERROR_NO){
+        bench_fail("init", "CO_CANmodule_init() failed");
+    }
+    for(i = 0; i < BENCH_HB_NODES; i++){
+        hbTime[i] = ((uint32_t)(i + 1) << 16) | BENCH_HB_CONS_TIME_MS;
+    }
+    if(CO_HBconsumer_init(&hbCons, CO->em, CO->SDO[0], hbTime, hbNodes, BENCH_HB_NODES, &hbCAN, 0) != CO_ERROR_NO){
+        bench_fail("init", "CO_HBconsumer_init() failed");
+    }
+    for(i = 0; i < BENCH_HB_NODES; i++){
+        static const uint8_t operational = CO_NMT_OPERATIONAL;
+        bench_rx(&hbCAN, (uint16_t)(CO_CAN_ID_HEARTBEAT + i + 1), 1, &operational);
+    }
+    CO_HBconsumer_process(&hbCons, true, 0);
+}
+
+
+/* Main ***********************************************************************/
+typedef struct{
+    const char         *name;
+    void              (*run)(uint32_t n);
+    uint32_t            iterations;
+    uint8_t             framesPerOp;    /* received and transmitted CAN frames */
+}bench_t;
+
+static const bench_t benchmarks[] = {
+    {"rx_dispatch_rpdo",        bench_rxDispatchHit,        2000000,  1},
+    {"rx_dispatch_miss",        bench_rxDispatchMiss,       2000000,  1},
+    {"sdo_upload_expedited",    bench_sdoUploadExpedited,    500000,  2},
+    {"sdo_download_expedited",  bench_sdoDownloadExpedited,  500000,  2},
+    {"sdo_upload_segmented",    bench_sdoUploadSegmented,    100000, 12},
+    {"sdo_download_segmented",  bench_sdoDownloadSegmented,  200000,  6},
+    {"sdo_upload_block",        bench_sdoUploadBlock,        100000, 11},
+    {"sdo_download_block",      bench_sdoDownloadBlock,      200000,  7},
+    {"tpdo_send",               bench_tpdoSend,             1000000,  1},
+    {"rpdo_process",            bench_rpdoProcess,          2000000,  1},
+    {"od_find",                 bench_odFind,               2000000,  0},
+    {"od_find_missing",         bench_odFindMissing,        2000000,  0},
+    {"hbconsumer_process_127",  bench_hbConsumer,            500000,  0},
+    {"em_process",              bench_emProcess,            2000000,  0},
+    {"em_report_reset",         bench_emReportReset,         200000,  2}
+};
+
+static double bench_now(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static int bench_compare(const void *a, const void *b){
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char *argv[]){
+    unsigned repeat = 5, i, r;
+    double scale = 1.0;
+    const char *filter = NULL;
+    int c, first = 1;
+
+    while((c = getopt(argc, argv, "r:s:f:")) != -1){
+        switch(c){
+            case 'r': repeat = (unsigned)strtoul(optarg, NULL, 0); break;
+            case 's': scale = strtod(optarg, NULL); break;
+            case 'f': filter = optarg; break;
+            default:
+                fprintf(stderr, "Usage: %s [-r repetitions] [-s iteration scale] [-f name filter]\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    if(repeat < 1 || repeat > BENCH_REPEAT_MAX || scale <= 0.0){
+        fprintf(stderr, "%s: repetitions 1..%u, scale > 0\n", argv[0], BENCH_REPEAT_MAX);
+        return EXIT_FAILURE;
+    }
+
+    bench_init();
+
+    printf("{\n");
+    printf("  \"suite\": \"CANopen301/stack\",\n");
+    printf("  \"driver\": \"simCAN\",\n");
+    printf("  \"od_extensions\": %s,\n", BENCH_OD_EXTENSIONS);
+    printf("  \"repetitions\": %u,\n", repeat);
+    printf("  \"results\": [");
+    for(i = 0; i < sizeof(benchmarks) / sizeof(benchmarks[0]); i++){
+        const bench_t *b = &benchmarks[i];
+        uint32_t n = (uint32_t)((double)b->iterations * scale);
+        double ns[BENCH_REPEAT_MAX], median;
+
+        if(filter != NULL && strstr(b->name, filter) == NULL) continue;
+        if(n < 1) n = 1;
+
+        b->run(n / 10 + 1);             /* warm up */
+        for(r = 0; r < repeat; r++){
+            double start = bench_now();
+            b->run(n);
+            ns[r] = (bench_now() - start) / (double)n;
+        }
+        qsort(ns, repeat, sizeof(double), bench_compare);
+        median = ns[repeat / 2];
+
+        printf("%s\n    {\"name\": \"%s\", \"iterations\": %u, \"ns_per_op\": %.1f, ",
+               first ? "" : ",", b->name, (unsigned)n, median);
+        if(b->framesPerOp != 0){
+            printf("\"frames_per_op\": %u, \"frames_per_s\": %.0f}",
+                   b->framesPerOp, (double)b->framesPerOp * 1e9 / median);
+        }
+        else{
+            printf("\"frames_per_op\": 0, \"frames_per_s\": null}");
+        }
+        first = 0;
+    }
+    printf("\n  ]\n}\n");
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,278 @@
+/*
+ * One drive node of the host co-simulation: CANopen stack with its object
+ * dictionary, virtual CAN controller and a simple motor model.
+ *
+ * @file        CO_simNode.c
+ * @author      Janez Paternoster
+ * @copyright   2015 Janez Paternoster
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "CANopen.h"
+#include "CO_motor_interface.h"
+#include "CO_simNode.h"
+
+
+/* Node configuration and main loop state, one copy per node image */
+static CO_simNodeConfig_t   simConfig;
+static uint16_t             timer1msPrevious;
+static float                motorSpeed;
+static uint16_t             simResets;
+static uint32_t             simSetReg;
+static uint32_t             simGetReg;
+static CO_CANmodule_t      *simCANmodule;       /* of the stack or the LSS master */
+
+/* LSS master, used only in the image on the port of the simulation master */
+static CO_CANmodule_t       simLssCANmodule;
+static CO_CANrx_t           simLssRx[1];
+static CO_CANtx_t           simLssTx[1];
+static CO_LSSmaster_t       simLssMaster;
+
+
+/* Write configuration to the object dictionary. Same as the values, which
+ * would be stored in flash of the drive. */
+static void CO_simNode_configOD(const CO_simNodeConfig_t *config){
+    OD_identity.vendorID = config->lssAddress.identity.vendorID;
+    OD_identity.productCode = config->lssAddress.identity.productCode;
+    OD_identity.revisionNumber = config->lssAddress.identity.revisionNumber;
+    OD_identity.serialNumber = config->lssAddress.identity.serialNumber;
+    OD_NMTStartup = 0x04;                       /* wait for NMT master */
+    OD_communicationCyclePeriod = config->syncPeriod_us;
+    OD_synchronousWindowLength = config->syncWindow_us;
+    OD_producerHeartbeatTime = config->heartbeat_ms;
+
+    OD_RPDOCommunicationParameter[0].COB_IDUsedByRPDO = CO_CAN_ID_RPDO_1;
+    OD_RPDOCommunicationParameter[0].transmissionType = config->rpdoTransmissionType;
+    OD_RPDOMappingParameter[0].numberOfMappedObjects = 2;
+    OD_RPDOMappingParameter[0].mappedObject1 = CO_SIM_RPDO_MAP1;
+    OD_RPDOMappingParameter[0].mappedObject2 = CO_SIM_RPDO_MAP2;
+
+    OD_TPDOCommunicationParameter[0].COB_IDUsedByTPDO = CO_CAN_ID_TPDO_1;
+    OD_TPDOCommunicationParameter[0].transmissionType = config->tpdoTransmissionType;
+    OD_TPDOCommunicationParameter[0].inhibitTime = config->tpdoInhibit_100us;
+    OD_TPDOCommunicationParameter[0].eventTimer = 0;
+    OD_TPDOMappingParameter[0].numberOfMappedObjects = 2;
+    OD_TPDOMappingParameter[0].mappedObject1 = CO_SIM_TPDO_MAP1;
+    OD_TPDOMappingParameter[0].mappedObject2 = CO_SIM_TPDO_MAP2;
+}
+
+
+/* Initialize the stack and start CAN, as CANopen_Init() of the firmware */
+static CO_ReturnError_t CO_simNode_start(void){
+    CO_ReturnError_t err;
+
+    err = CO_init(0, simConfig.nodeId, simConfig.bitRate, NULL);
+    if(err != CO_ERROR_NO){
+        return err;
+    }
+    simCANmodule = CO->CANmodule[0];
+    CO_CANsetNormalMode(simCANmodule);
+    timer1msPrevious = CO_timer1ms;
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+static CO_ReturnError_t CO_simNode_init(CO_CANsimPort_t *port, const CO_simNodeConfig_t *config){
+    if(port == NULL || config == NULL){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    simConfig = *config;
+    CO_CANsimPort = port;
+    CO_simNode_configOD(config);
+
+    return CO_simNode_start();
+}
+
+
+/******************************************************************************/
+/* Speed follows the setpoint with first order response, while the control
+ * word enables operation. */
+static void CO_simNode_motor(void){
+    float target = 0.0f;
+
+    if(CO_OD_RAM.ControlWord == CO_SIM_CONTROL_ENABLE){
+        target = (float)CO_OD_RAM.HomingSpeeds;
+        CO_OD_RAM.StatusWord = 0x0627UL;        /* operation enabled */
+    }
+    else{
+        CO_OD_RAM.StatusWord = 0x0621UL;        /* ready to switch on */
+    }
+
+    if(simConfig.motorTau_ms > 0U){
+        motorSpeed += (target - motorSpeed) / (float)simConfig.motorTau_ms;
+    }
+    else{
+        motorSpeed = target;
+    }
+    CO_OD_RAM.CurrentSpeed = (int16_t)motorSpeed;
+}
+
+
+/******************************************************************************/
+static void CO_simNode_tick(void){
+    CO_timer1ms++;
+    CO_tmr_Task_thread();
+    CO_simNode_motor();
+}
+
+
+/******************************************************************************/
+static void CO_simNode_process(void){
+    CO_NMT_reset_cmd_t reset;
+    uint16_t timer1msCopy, timer1msDiff;
+
+    timer1msCopy = CO_timer1ms;
+    timer1msDiff = timer1msCopy - timer1msPrevious;
+    timer1msPrevious = timer1msCopy;
+
+    reset = CO_process(CO, timer1msDiff, NULL);
+    if(reset == CO_RESET_COMM || reset == CO_RESET_APP){
+        /* drive restarts communication, application keeps running. Node ID
+         * may be assigned by the LSS master, as CANopen_CommunicationReset(). */
+        simResets++;
+        simConfig.nodeId = CO->LSSslave->pendingNodeID;
+        simConfig.bitRate = CO->LSSslave->activeBitRate;
+        CO_delete(0);
+        CO_simNode_configOD(&simConfig);
+        CO_simNode_start();
+    }
+}
+
+
+/******************************************************************************/
+static void CO_simNode_canRx(void){
+    CO_CANinterrupt_Rx(simCANmodule);
+}
+
+
+/******************************************************************************/
+static void CO_simNode_canTx(void){
+    CO_CANinterrupt_Tx(simCANmodule);
+}
+
+
+/******************************************************************************/
+static void CO_simNode_status(CO_simNodeStatus_t *status){
+    status->nodeId = simConfig.nodeId;
+    status->operatingState = CO->nodeIdUnconfigured ? CO_NMT_INITIALIZING : CO->NMT->operatingState;
+    status->errorRegister = OD_errorRegister;
+    status->speedRef = CO_OD_RAM.HomingSpeeds;
+    status->speed = CO_OD_RAM.CurrentSpeed;
+    status->resets = simResets;
+    status->motorSetReg = simSetReg;
+    status->motorGetReg = simGetReg;
+}
+
+
+/******************************************************************************/
+static CO_ReturnError_t CO_simNode_lssMasterInit(CO_CANsimPort_t *port, uint16_t timeout_ms){
+    CO_ReturnError_t err;
+
+    if(port == NULL){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    CO_CANsimPort = port;
+    err = CO_CANmodule_init(&simLssCANmodule, port, simLssRx, 1, simLssTx, 1, 0);
+    if(err != CO_ERROR_NO){
+        return err;
+    }
+    err = CO_LSSmaster_init(&simLssMaster, timeout_ms,
+                            &simLssCANmodule, 0, CO_CAN_ID_LSS_SRV,
+                            &simLssCANmodule, 0, CO_CAN_ID_LSS_CLI);
+    if(err != CO_ERROR_NO){
+        return err;
+    }
+    simCANmodule = &simLssCANmodule;
+    CO_CANsetNormalMode(simCANmodule);
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+static CO_LSSmaster_return_t CO_simNode_lssMasterProcess(CO_LSSmaster_assign_t *assign){
+    return CO_LSSmaster_assignNodeIds(&simLssMaster, 1, assign);
+}
+
+
+const CO_simNodeApi_t CO_simNodeApi = {
+    CO_simNode_init,
+    CO_simNode_tick,
+    CO_simNode_process,
+    CO_simNode_canRx,
+    CO_simNode_canTx,
+    CO_simNode_status,
+    CO_simNode_lssMasterInit,
+    CO_simNode_lssMasterProcess
+};
+
+
+/******************************************************************************/
+/* Motor registers accessed by SDO server, replaces CO_motor_interface.c. Data
+ * of the expedited download are little endian in CANrxData[4..7]. */
+bool MI_SetReg(UI_Handle_t *pHandle, CO_SDO_t *pSDO){
+    int32_t wValue = (int32_t)((uint32_t)pSDO->CANrxData[4]
+                             | ((uint32_t)pSDO->CANrxData[5] << 8)
+                             | ((uint32_t)pSDO->CANrxData[6] << 16)
+                             | ((uint32_t)pSDO->CANrxData[7] << 24));
+
+    simSetReg++;
+    switch(pSDO->ODF_arg.index){
+        case CO_Index_RAMP_FINAL_SPEED:
+            CO_OD_RAM.HomingSpeeds = (int16_t)wValue;
+            break;
+        case CO_Index_CMD_START_MOTOR:
+            CO_OD_RAM.ControlWord = CO_SIM_CONTROL_ENABLE;
+            break;
+        case CO_Index_CMD_STOP_MOTOR:
+        case CO_Index_CMD_STOP_RAMP:
+            CO_OD_RAM.ControlWord = CO_SIM_CONTROL_DISABLE;
+            break;
+        default:
+            break;
+    }
+
+    return true;
+}
+
+int32_t MI_GetReg(UI_Handle_t *pHandle, CO_SDO_t *pSDO){
+    int32_t retVal = (int32_t)GUI_ERROR_CODE;
+
+    simGetReg++;
+    switch(pSDO->ODF_arg.index){
+        case CO_Index_SPEED_MEAS:
+            retVal = CO_OD_RAM.CurrentSpeed;
+            break;
+        case CO_Index_Fault_FLAGS:
+            retVal = 0;
+            break;
+        case CO_Index_BUS_VOLTAGE:
+            retVal = 48;
+            break;
+        default:
+            break;
+    }
+
+    return retVal;
+}
@@ -0,0 +1,104 @@
+/*
+ * One drive node of the host co-simulation: CANopen stack with its object
+ * dictionary, virtual CAN controller and a simple motor model.
+ *
+ * @file        CO_simNode.h
+ * @author      Janez Paternoster
+ * @copyright   2015 Janez Paternoster
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef CO_SIM_NODE_H
+#define CO_SIM_NODE_H
+
+
+/* Node image (CO_simNode.so) contains the whole stack with its globals.
+ * Simulator loads one copy of the image per node and reaches it only through
+ * CO_simNodeApi, so the same structures are shared by both sides. */
+
+
+#include "CO_driver.h"
+#include "CO_LSSmaster.h"
+
+
+/* PDO mapping of the node image */
+#define CO_SIM_RPDO_MAP1            0x60990010UL    /* speed setpoint, rpm */
+#define CO_SIM_RPDO_MAP2            0x60400008UL    /* control word */
+#define CO_SIM_TPDO_MAP1            0x60420010UL    /* measured speed, rpm */
+#define CO_SIM_TPDO_MAP2            0x60410020UL    /* status word */
+#define CO_SIM_RPDO_LENGTH          3
+#define CO_SIM_TPDO_LENGTH          6
+
+#define CO_SIM_CONTROL_ENABLE       0x0FU           /* control word, enable operation */
+#define CO_SIM_CONTROL_DISABLE      0x06U           /* control word, shutdown */
+
+
+/* Node configuration, written to the object dictionary before CO_init() */
+typedef struct{
+    uint8_t             nodeId;                 /* or CO_LSS_NODE_ID_ASSIGNMENT */
+    CO_LSS_address_t    lssAddress;             /* 1018h sub 1..4 */
+    uint16_t            bitRate;                /* kbit/s */
+    uint32_t            syncPeriod_us;          /* 1006h, SYNC timeout supervision */
+    uint32_t            syncWindow_us;          /* 1007h, 0 = no window */
+    uint16_t            heartbeat_ms;           /* 1017h */
+    uint8_t             rpdoTransmissionType;   /* 1400h sub 2 */
+    uint8_t             tpdoTransmissionType;   /* 1800h sub 2 */
+    uint16_t            tpdoInhibit_100us;      /* 1800h sub 3 */
+    uint16_t            motorTau_ms;            /* speed loop time constant */
+}CO_simNodeConfig_t;
+
+
+/* Node state for the simulation report */
+typedef struct{
+    uint8_t             nodeId;                 /* active node ID */
+    uint8_t             operatingState;         /* CO_NMT_internalState_t */
+    uint8_t             errorRegister;          /* 1001h */
+    int16_t             speedRef;               /* rpm */
+    int16_t             speed;                  /* rpm */
+    uint16_t            resets;                 /* communication resets */
+    uint32_t            motorSetReg;            /* MI_SetReg() calls from SDO */
+    uint32_t            motorGetReg;            /* MI_GetReg() calls from SDO */
+}CO_simNodeStatus_t;
+
+
+/* Entry points of the node image */
+typedef struct{
+    /* Configure object dictionary, CO_init() and start CAN. */
+    CO_ReturnError_t  (*init)(CO_CANsimPort_t *port, const CO_simNodeConfig_t *config);
+    /* SysTick, 1 ms: CO_tmr_Task_thread() and motor model. */
+    void              (*tick)(void);
+    /* One pass of the main loop: CO_process(). */
+    void              (*process)(void);
+    /* CAN interrupts, see CO_CANinterrupt_Rx() / CO_CANinterrupt_Tx(). */
+    void              (*canRx)(void);
+    void              (*canTx)(void);
+    void              (*status)(CO_simNodeStatus_t *status);
+    /* LSS master instead of the node, on the port of the simulation master.
+     * lssMasterProcess() calls CO_LSSmaster_assignNodeIds() and is called
+     * every millisecond. */
+    CO_ReturnError_t  (*lssMasterInit)(CO_CANsimPort_t *port, uint16_t timeout_ms);
+    CO_LSSmaster_return_t (*lssMasterProcess)(CO_LSSmaster_assign_t *assign);
+}CO_simNodeApi_t;
+
+
+extern const CO_simNodeApi_t CO_simNodeApi;
+
+
+#endif
@@ -0,0 +1,1102 @@
+/*
+ * Deterministic discrete-event co-simulation of many drive nodes on one
+ * virtual CAN bus.
+ *
+ * @file        cosim.c
+ * @author      Janez Paternoster
+ * @copyright   2015 Janez Paternoster
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/* Every drive node is a private copy of CO_simNode.so (stack, object
+ * dictionary, simCAN driver and motor model), so the globals of the stack
+ * are separate per node. Nodes and a simple NMT/SYNC/PDO/SDO master share one
+ * virtual bus:
+ *  - lowest identifier of all requested mailboxes wins arbitration, equal
+ *    frames of several nodes (LSS responses) are sent together,
+ *  - frame lasts its exact bit count with bit stuffing, CRC, ACK, EOF and
+ *    intermission at the configured bit rate,
+ *  - stack code (interrupts, SysTick, main loop) runs in zero virtual time.
+ * Time advances from event to event, nothing depends on the wall clock, so
+ * the same options always give the same bus trace (see "trace hash").
+ *
+ * With option -a nodes start without node ID and the master port runs
+ * CO_LSSmaster_assignNodeIds() from one more copy of the image first. Nodes
+ * get node IDs in order of their random serial numbers, then the simulation
+ * continues as usual for the time of option -t.
+ *
+ * Defaults of 64 nodes at 1000 kbit/s load the bus to about 2/3: SYNC every
+ * 20 ms with one TPDO and one RPDO per node, SDO upload every 2 ms. With SYNC
+ * every 10 ms the PDOs alone need more than the bus can carry. Heartbeats are
+ * not simulated, the stack does not send them (Enable_Send_HeartBeat in
+ * CO_NMT_Heartbeat.h).
+ *
+ * Nodes run CO_simNode.so, option -p loads CO_simNode_prof.so instead, which
+ * is built with -finstrument-functions for the profiler.
+ *
+ * Build and run: make cosim && cosim/cosim -n 64 -t 10
+ *                cosim/cosim -n 64 -t 2 -p
+ *                cosim/cosim -n 64 -a 1 -A 2 -t 1 */
+
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <fcntl.h>
+#include <dlfcn.h>
+#include <link.h>
+#include <elf.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "CANopen.h"          /* identifiers and NMT states only, no stack code */
+#include "CO_simNode.h"
+
+
+#define SIM_MAX_NODES           127
+#define SIM_MASTER              0               /* port index of the master */
+#define SIM_NS_PER_MS           1000000ULL
+#define SIM_SDO_TIMEOUT_NS      (100ULL * SIM_NS_PER_MS)
+#define SIM_SYNC_START_NS       (5ULL * SIM_NS_PER_MS)     /* before SYNC timeout of nodes */
+#define SIM_NMT_START_NS        (100ULL * SIM_NS_PER_MS)
+#define SIM_SPEED_STEP_NS       (1000ULL * SIM_NS_PER_MS)
+#define SIM_LSS_VENDOR_ID       0x000000DEUL    /* 1018h of all nodes, except serial number */
+#define SIM_LSS_PRODUCT_CODE    0x00003020UL
+#define SIM_LSS_REVISION        0x00010000UL
+
+
+/* Options ********************************************************************/
+typedef struct{
+    unsigned            nodes;
+    unsigned            bitRate;            /* kbit/s */
+    unsigned            syncPeriod_us;
+    unsigned            syncWindow_us;
+    unsigned            sdoInterval_us;     /* 0 = no SDO polling */
+    unsigned            processLatency_us;  /* CAN interrupt to main loop */
+    unsigned            driftPpm;           /* max. clock deviation of nodes */
+    unsigned            tpdoType;
+    unsigned            rpdoType;
+    unsigned            lssScan;            /* scanned LSS address subs, 0 = fixed node IDs */
+    unsigned            lssTimeout_ms;      /* Fastscan response timeout */
+    unsigned long long  duration_ns;
+    unsigned long long  seed;
+    int                 profile;
+    int                 verbose;
+    const char         *image;
+}sim_options_t;
+
+static sim_options_t opt = {
+    64, 1000, 20000, 0, 2000, 50, 100, 1, 1, 0, CO_LSSmaster_DEFAULT_TIMEOUT,
+    10000ULL * SIM_NS_PER_MS, 1, 0, 0, NULL
+};
+
+
+/* Events *********************************************************************/
+typedef enum{
+    EV_NODE_TICK,
+    EV_NODE_PROCESS,
+    EV_BUS_END,
+    EV_MASTER_NMT,
+    EV_MASTER_SYNC,
+    EV_MASTER_SDO,
+    EV_MASTER_LSS,
+    EV_BUS_ARBITRATE                        /* last of all events of same time */
+}sim_eventType_t;
+
+typedef struct{
+    unsigned long long  time;
+    unsigned long long  seq;
+    unsigned            type;
+    unsigned            port;
+}sim_event_t;
+
+static sim_event_t     *evHeap;
+static size_t           evCount, evSize;
+static unsigned long long evSeq;
+static unsigned long long simTime;
+
+static int ev_before(const sim_event_t *a, const sim_event_t *b){
+    int aArb = a->type == EV_BUS_ARBITRATE, bArb = b->type == EV_BUS_ARBITRATE;
+    if(a->time != b->time) return a->time < b->time;
+    if(aArb != bArb) return bArb;
+    return a->seq < b->seq;
+}
+
+static void ev_push(unsigned long long time, unsigned type, unsigned port){
+    size_t i;
+    if(evCount == evSize){
+        evSize = evSize ? evSize * 2 : 1024;
+        evHeap = realloc(evHeap, evSize * sizeof(sim_event_t));
+        if(evHeap == NULL){ perror("realloc"); exit(EXIT_FAILURE); }
+    }
+    i = evCount++;
+    evHeap[i].time = time; evHeap[i].seq = evSeq++; evHeap[i].type = type; evHeap[i].port = port;
+    while(i > 0){
+        size_t p = (i - 1) / 2;
+        sim_event_t t;
+        if(!ev_before(&evHeap[i], &evHeap[p])) break;
+        t = evHeap[i]; evHeap[i] = evHeap[p]; evHeap[p] = t;
+        i = p;
+    }
+}
+
+static sim_event_t ev_pop(void){
+    sim_event_t top = evHeap[0];
+    size_t i = 0;
+    evHeap[0] = evHeap[--evCount];
+    for(;;){
+        size_t l = 2 * i + 1, r = l + 1, m = i;
+        sim_event_t t;
+        if(l < evCount && ev_before(&evHeap[l], &evHeap[m])) m = l;
+        if(r < evCount && ev_before(&evHeap[r], &evHeap[m])) m = r;
+        if(m == i) break;
+        t = evHeap[i]; evHeap[i] = evHeap[m]; evHeap[m] = t;
+        i = m;
+    }
+    return top;
+}
+
+
+/* Deterministic pseudo random numbers ****************************************/
+static unsigned long long rngState;
+
+static unsigned long long rng_next(void){
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 7;
+    rngState ^= rngState << 17;
+    return rngState;
+}
+
+
+/* Nodes **********************************************************************/
+typedef struct{
+    void               *handle;
+    const CO_simNodeApi_t *api;
+    uintptr_t           base;               /* load address, for the profiler */
+    unsigned long long  tickPeriod;         /* ns, 1 ms of the node clock */
+    int                 processPending;
+}sim_node_t;
+
+static CO_CANsimPort_t  ports[SIM_MAX_NODES + 1];
+static sim_node_t       nodes[SIM_MAX_NODES + 1];
+static int              simCurrent = -1;    /* node, which runs stack code */
+
+static void node_enter(unsigned n){
+    ports[n].time = simTime;
+    simCurrent = (int)n;
+}
+
+static void node_leave(void){
+    simCurrent = -1;
+}
+
+
+/* Master *********************************************************************/
+/* Host side CAN controller of the master, same transmit policy as the node
+ * driver: pending message with the lowest identifier to a free mailbox. */
+typedef struct{
+    CO_CANrxMsg_t       msg;
+    unsigned long long  queueTime;
+    int                 pending;
+    unsigned            cycle;              /* SYNC cycle, when queued */
+}sim_masterTx_t;
+
+enum{ MTX_NMT, MTX_SYNC, MTX_RPDO, MTX_SDO = MTX_RPDO + SIM_MAX_NODES, MTX_COUNT = MTX_SDO + SIM_MAX_NODES };
+
+static sim_masterTx_t   masterTx[MTX_COUNT];
+static int              masterMailbox[CO_CAN_NO_TX_MAILBOXES] = {-1, -1, -1};
+
+/* Statistics */
+typedef struct{
+    unsigned long long  count, sum, max, min;
+}sim_stat_t;
+
+static void stat_add(sim_stat_t *s, unsigned long long v){
+    if(s->count == 0 || v < s->min) s->min = v;
+    if(v > s->max) s->max = v;
+    s->sum += v;
+    s->count++;
+}
+
+static unsigned           syncCycle;
+static unsigned long long syncTime;         /* end of the last SYNC on the bus */
+static int                syncSeen;
+static int                nodesStarted;     /* NMT start was on the bus */
+static int                tpdoExpected;     /* in the current SYNC cycle */
+static unsigned char      tpdoSeen[SIM_MAX_NODES + 1];
+static unsigned long long lastFrameInCycle;
+static sim_stat_t         tpdoLatency, cycleBusy, sdoLatency;
+static unsigned long long tpdoMissed, rpdoLate, rpdoOverrun, sdoRequests, sdoTimeouts, sdoAborts;
+static unsigned long long sdoSendTime[SIM_MAX_NODES + 1];
+static int                sdoOutstanding[SIM_MAX_NODES + 1];
+static unsigned           sdoNext = 1;
+static unsigned long long emcyCount[SIM_MAX_NODES + 1];
+static unsigned           emcyCodes[16][2];  /* error code, count */
+static unsigned           emcyCodesUsed;
+static CO_LSSmaster_assign_t lssAssign;
+static CO_LSSmaster_return_t lssResult = CO_LSSmaster_WAIT_SLAVE;
+static int                lssActive;        /* LSS master image owns the master port */
+static unsigned long long lssTime;          /* end of node ID assignment */
+
+/* Bus ************************************************************************/
+typedef struct{
+    int                 busy;
+    int                 arbitratePending;
+    unsigned            port, mailbox;
+    CO_CANrxMsg_t       msg;
+    unsigned long long  start;
+    unsigned long long  busyTime;
+    unsigned long long  frames, bits, collisions;
+    unsigned long long  hash;
+    uint8_t             coMailbox[SIM_MAX_NODES + 1];   /* same frame from other ports */
+}sim_bus_t;
+
+static sim_bus_t bus = { 0, 0, 0, 0, {0, 0, {0}}, 0, 0, 0, 0, 0, 0xCBF29CE484222325ULL };
+
+/* Frames by COB class (function code), latency from CO_CANsend() to the end of frame */
+static const char *classNames[16] = {
+    "NMT", "SYNC/EMCY", "TIME", "TPDO1", "RPDO1", "TPDO2", "RPDO2", "TPDO3",
+    "RPDO3", "TPDO4", "RPDO4", "TSDO", "RSDO", "-", "HB/bootup", "LSS"
+};
+static sim_stat_t classLatency[16];
+
+static void bus_kick(void){
+    if(!bus.busy && !bus.arbitratePending){
+        bus.arbitratePending = 1;
+        ev_push(simTime, EV_BUS_ARBITRATE, 0);
+    }
+}
+
+/* Exact length of base format data or remote frame, including stuff bits,
+ * CRC delimiter, ACK, EOF and intermission. */
+static unsigned can_frameBits(const CO_CANrxMsg_t *msg){
+    unsigned char bits[128];
+    unsigned n = 0, i, run, stuffed;
+    unsigned id = msg->ident & 0x7FFU, rtr = (msg->ident >> 11) & 1U, dlc = msg->DLC & 0x0FU;
+    unsigned dataBytes = rtr ? 0 : (dlc > 8 ? 8 : dlc);
+    unsigned crc = 0;
+    int last;
+
+    bits[n++] = 0;                                      /* SOF */
+    for(i = 0; i < 11; i++) bits[n++] = (id >> (10 - i)) & 1U;
+    bits[n++] = (unsigned char)rtr;
+    bits[n++] = 0;                                      /* IDE */
+    bits[n++] = 0;                                      /* r0 */
+    for(i = 0; i < 4; i++) bits[n++] = (dlc >> (3 - i)) & 1U;
+    for(i = 0; i < dataBytes * 8; i++) bits[n++] = (msg->data[i / 8] >> (7 - i % 8)) & 1U;
+    for(i = 0; i < n; i++){
+        unsigned crcNext = bits[i] ^ ((crc >> 14) & 1U);
+        crc = (crc << 1) & 0x7FFFU;
+        if(crcNext) crc ^= 0x4599U;
+    }
+    for(i = 0; i < 15; i++) bits[n++] = (crc >> (14 - i)) & 1U;
+
+    /* after five equal bits a complementary bit is inserted */
+    stuffed = 0; run = 0; last = -1;
+    for(i = 0; i < n; i++){
+        if(bits[i] == last){
+            run++;
+        }
+        else{
+            last = bits[i]; run = 1;
+        }
+        if(run == 5){
+            stuffed++;
+            last = !last; run = 1;
+        }
+    }
+
+    return n + stuffed + 1 + 2 + 7 + 3;
+}
+
+static void bus_arbitrate(void){
+    unsigned p, m, winPort = 0, winMailbox = 0, winIdent = 0xFFFFFFFFU, bits;
+
+    bus.arbitratePending = 0;
+    if(bus.busy) return;
+
+    for(p = 0; p <= opt.nodes; p++){
+        for(m = 0; m < CO_CAN_NO_TX_MAILBOXES; m++){
+            if((ports[p].txRequest & (1U << m)) == 0) continue;
+            if(ports[p].txMailbox[m].ident < winIdent){
+                winIdent = ports[p].txMailbox[m].ident;
+                winPort = p; winMailbox = m;
+            }
+        }
+    }
+    if(winIdent == 0xFFFFFFFFU) return;
+
+    bus.busy = 1;
+    bus.port = winPort;
+    bus.mailbox = winMailbox;
+    bus.msg = ports[winPort].txMailbox[winMailbox];
+    bus.start = simTime;
+    ports[winPort].txOnBus = (uint8_t)winMailbox;
+
+    /* Nodes, which send the same frame, see no error and all succeed. Same
+     * identifier with other data would destroy the frame. */
+    for(p = 0; p <= opt.nodes; p++){
+        bus.coMailbox[p] = CO_CAN_SIM_MAILBOX_NONE;
+        if(p == winPort || p == SIM_MASTER) continue;
+        for(m = 0; m < CO_CAN_NO_TX_MAILBOXES; m++){
+            const CO_CANrxMsg_t *mb = &ports[p].txMailbox[m];
+            if((ports[p].txRequest & (1U << m)) == 0 || mb->ident != winIdent) continue;
+            if(mb->DLC == bus.msg.DLC && memcmp(mb->data, bus.msg.data, mb->DLC > 8 ? 8 : mb->DLC) == 0){
+                bus.coMailbox[p] = (uint8_t)m;
+                ports[p].txOnBus = (uint8_t)m;
+            }
+            else{
+                bus.collisions++;
+            }
+            break;
+        }
+    }
+
+    bits = can_frameBits(&bus.msg);
+    bus.bits += bits;
+    ev_push(simTime + (unsigned long long)bits * 1000000ULL / opt.bitRate, EV_BUS_END, winPort);
+}
+
+
+/* Master *********************************************************************/
+static void master_txSchedule(void){
+    for(;;){
+        int best = -1, i;
+        unsigned m;
+
+        for(m = 0; m < CO_CAN_NO_TX_MAILBOXES; m++){
+            if(masterMailbox[m] < 0) break;
+        }
+        if(m == CO_CAN_NO_TX_MAILBOXES) return;
+
+        for(i = 0; i < MTX_COUNT; i++){
+            if(masterTx[i].pending && (best < 0 || masterTx[i].msg.ident < masterTx[best].msg.ident)){
+                best = i;
+            }
+        }
+        if(best < 0) return;
+
+        masterTx[best].pending = 0;
+        masterMailbox[m] = best;
+        ports[SIM_MASTER].txMailbox[m] = masterTx[best].msg;
+        ports[SIM_MASTER].txQueueTime[m] = masterTx[best].queueTime;
+        ports[SIM_MASTER].txRequest |= (uint8_t)(1U << m);
+    }
+}
+
+static void master_send(unsigned slot, unsigned ident, unsigned dlc, const uint8_t *data){
+    sim_masterTx_t *tx = &masterTx[slot];
+
+    if(tx->pending && slot >= MTX_RPDO && slot < MTX_SDO){
+        rpdoOverrun++;
+    }
+    tx->msg.ident = ident;
+    tx->msg.DLC = (uint8_t)dlc;
+    memset(tx->msg.data, 0, sizeof(tx->msg.data));
+    if(dlc > 0) memcpy(tx->msg.data, data, dlc);
+    tx->queueTime = simTime;
+    tx->cycle = syncCycle;
+    tx->pending = 1;
+    master_txSchedule();
+    bus_kick();
+}
+
+static int16_t master_speedRef(unsigned n){
+    /* speed steps every second, different for each drive */
+    return (int16_t)((((simTime / SIM_SPEED_STEP_NS) & 1U) ? 3000 : 1500) + 10 * (int)n);
+}
+
+static void master_sync(void){
+    unsigned n;
+
+    master_send(MTX_SYNC, CO_CAN_ID_SYNC, 0, NULL);
+
+    /* setpoints for the next SYNC */
+    for(n = 1; n <= opt.nodes; n++){
+        int16_t speed = master_speedRef(n);
+        uint8_t data[CO_SIM_RPDO_LENGTH];
+        data[0] = (uint8_t)speed;
+        data[1] = (uint8_t)((uint16_t)speed >> 8);
+        data[2] = CO_SIM_CONTROL_ENABLE;
+        master_send(MTX_RPDO + n - 1, CO_CAN_ID_RPDO_1 + n, CO_SIM_RPDO_LENGTH, data);
+        masterTx[MTX_RPDO + n - 1].cycle = syncCycle + 1;    /* after this SYNC */
+    }
+}
+
+static void master_sdo(void){
+    unsigned tries;
+
+    /* expedited upload of measured speed, goes through MI_GetReg() */
+    for(tries = 0; tries < opt.nodes; tries++){
+        unsigned n = sdoNext;
+        sdoNext = sdoNext % opt.nodes + 1;
+        if(sdoOutstanding[n] && simTime - sdoSendTime[n] >= SIM_SDO_TIMEOUT_NS){
+            sdoTimeouts++;
+            sdoOutstanding[n] = 0;
+        }
+        if(!sdoOutstanding[n]){
+            uint8_t data[8] = {0x40, 0x42, 0x60, 0x00, 0, 0, 0, 0};
+            sdoOutstanding[n] = 1;
+            sdoSendTime[n] = simTime;
+            sdoRequests++;
+            master_send(MTX_SDO + n - 1, CO_CAN_ID_RSDO + n, 8, data);
+            break;
+        }
+    }
+}
+
+static void master_emcy(unsigned n, const CO_CANrxMsg_t *msg){
+    unsigned code = msg->data[0] | ((unsigned)msg->data[1] << 8), i;
+
+    emcyCount[n]++;
+    for(i = 0; i < emcyCodesUsed; i++){
+        if(emcyCodes[i][0] == code) break;
+    }
+    if(i == emcyCodesUsed){
+        if(emcyCodesUsed == 16) return;
+        emcyCodes[emcyCodesUsed][0] = code;
+        emcyCodes[emcyCodesUsed][1] = 0;
+        emcyCodesUsed++;
+    }
+    emcyCodes[i][1]++;
+}
+
+/* frame seen by the master, sender is a node */
+static void master_rx(const CO_CANrxMsg_t *msg){
+    unsigned ident = msg->ident & 0x7FFU, fc = ident & 0x780U, n = ident & 0x7FU;
+
+    if(n == 0 || n > opt.nodes) return;
+
+    if(fc == CO_CAN_ID_TPDO_1){
+        if(syncSeen && !tpdoSeen[n]){
+            tpdoSeen[n] = 1;
+            stat_add(&tpdoLatency, simTime - syncTime);
+        }
+    }
+    else if(fc == CO_CAN_ID_EMERGENCY){
+        master_emcy(n, msg);
+    }
+    else if(fc == CO_CAN_ID_TSDO){
+        if(sdoOutstanding[n]){
+            sdoOutstanding[n] = 0;
+            if(msg->data[0] == 0x80) sdoAborts++;
+            stat_add(&sdoLatency, simTime - sdoSendTime[n]);
+        }
+    }
+}
+
+/* NMT start, SYNC and SDO polling, after node ID assignment with LSS */
+static void master_start(unsigned long long start){
+    ev_push(start + SIM_NMT_START_NS, EV_MASTER_NMT, SIM_MASTER);
+    ev_push(start + SIM_SYNC_START_NS, EV_MASTER_SYNC, SIM_MASTER);
+    if(opt.sdoInterval_us) ev_push(start + SIM_NMT_START_NS + 1000ULL, EV_MASTER_SDO, SIM_MASTER);
+}
+
+/* one millisecond of the LSS master main loop */
+static void master_lss(void){
+    node_enter(SIM_MASTER);
+    lssResult = nodes[SIM_MASTER].api->lssMasterProcess(&lssAssign);
+    node_leave();
+    if(lssResult == CO_LSSmaster_WAIT_SLAVE){
+        ev_push(simTime + SIM_NS_PER_MS, EV_MASTER_LSS, SIM_MASTER);
+        return;
+    }
+
+    /* simulated time of option -t starts now */
+    lssActive = 0;
+    lssTime = simTime;
+    opt.duration_ns += simTime;
+    master_start(simTime);
+}
+
+/* end of SYNC frame on the bus */
+static void master_syncDone(void){
+    unsigned n;
+
+    if(syncSeen){
+        stat_add(&cycleBusy, lastFrameInCycle - syncTime);
+    }
+    if(tpdoExpected){
+        for(n = 1; n <= opt.nodes; n++){
+            if(!tpdoSeen[n]) tpdoMissed++;
+        }
+    }
+    tpdoExpected = nodesStarted;
+    memset(tpdoSeen, 0, sizeof(tpdoSeen));
+    syncSeen = 1;
+    syncTime = simTime;
+    lastFrameInCycle = simTime;
+    syncCycle++;
+}
+
+
+/* Frame transmitted ***********************************************************/
+static void trace_hash(const void *p, size_t len){
+    const unsigned char *b = p;
+    while(len--){
+        bus.hash ^= *b++;
+        bus.hash *= 0x100000001B3ULL;
+    }
+}
+
+static void node_schedule_process(unsigned n){
+    if(!nodes[n].processPending){
+        nodes[n].processPending = 1;
+        ev_push(simTime + (unsigned long long)opt.processLatency_us * 1000ULL, EV_NODE_PROCESS, n);
+    }
+}
+
+static void bus_end(void){
+    CO_CANsimPort_t *sender = &ports[bus.port];
+    const CO_CANrxMsg_t *msg = &bus.msg;
+    unsigned ident = msg->ident & 0x7FFU, n;
+    unsigned long long queueTime = sender->txQueueTime[bus.mailbox];
+
+    bus.busy = 0;
+    bus.frames++;
+    bus.busyTime += simTime - bus.start;
+    stat_add(&classLatency[ident >> 7], simTime - queueTime);
+
+    trace_hash(&simTime, sizeof(simTime));
+    trace_hash(&bus.port, sizeof(bus.port));
+    trace_hash(&msg->ident, sizeof(msg->ident));
+    trace_hash(&msg->DLC, sizeof(msg->DLC));
+    trace_hash(msg->data, sizeof(msg->data));
+
+    if(opt.verbose){
+        unsigned i;
+        printf("%12.6f  n%-3u %03X [%u]", (double)simTime / 1e9, bus.port, ident, msg->DLC);
+        for(i = 0; i < msg->DLC && i < 8; i++) printf(" %02X", msg->data[i]);
+        printf("%s\n", (msg->ident & 0x800U) ? " RTR" : "");
+    }
+
+    /* release the mailbox of the sender */
+    sender->txRequest &= (uint8_t)~(1U << bus.mailbox);
+    sender->txComplete |= (uint8_t)(1U << bus.mailbox);
+    sender->txOnBus = CO_CAN_SIM_MAILBOX_NONE;
+
+    /* release the mailboxes of the other senders of the same frame */
+    for(n = 1; n <= opt.nodes; n++){
+        unsigned m = bus.coMailbox[n];
+        if(m == CO_CAN_SIM_MAILBOX_NONE) continue;
+        ports[n].txRequest &= (uint8_t)~(1U << m);
+        ports[n].txComplete |= (uint8_t)(1U << m);
+        ports[n].txOnBus = CO_CAN_SIM_MAILBOX_NONE;
+        node_enter(n);
+        nodes[n].api->canTx();
+        node_leave();
+    }
+
+    /* receive interrupts of all other nodes, main loop runs for frames which
+     * pass the filters of the node */
+    for(n = 1; n <= opt.nodes; n++){
+        uint32_t accepted = ports[n].rxAccepted;
+        if(n == bus.port || bus.coMailbox[n] != CO_CAN_SIM_MAILBOX_NONE) continue;
+        ports[n].rxMsg = *msg;
+        node_enter(n);
+        nodes[n].api->canRx();
+        node_leave();
+        if(ports[n].rxAccepted != accepted) node_schedule_process(n);
+    }
+
+    if(bus.port == SIM_MASTER && lssActive){
+        node_enter(SIM_MASTER);
+        nodes[SIM_MASTER].api->canTx();
+        node_leave();
+    }
+    else if(bus.port == SIM_MASTER){
+        int slot = masterMailbox[bus.mailbox];
+        sender->txComplete = 0;
+        masterMailbox[bus.mailbox] = -1;
+        if(slot == MTX_NMT){
+            nodesStarted = 1;
+        }
+        else if(slot == MTX_SYNC){
+            master_syncDone();
+        }
+        else if(slot >= MTX_RPDO && slot < MTX_SDO && masterTx[slot].cycle != syncCycle){
+            /* setpoint arrived after the next SYNC, drive applies it one cycle late */
+            rpdoLate++;
+        }
+        master_txSchedule();
+    }
+    else{
+        if(lssActive){
+            /* LSS master image, its main loop runs every millisecond */
+            ports[SIM_MASTER].rxMsg = *msg;
+            node_enter(SIM_MASTER);
+            nodes[SIM_MASTER].api->canRx();
+            node_leave();
+        }
+        master_rx(msg);
+        node_enter(bus.port);
+        nodes[bus.port].api->canTx();
+        node_leave();
+    }
+
+    lastFrameInCycle = simTime;
+    bus_kick();
+}
+
+
+/* Profiler *******************************************************************/
+/* Node image is compiled with -finstrument-functions. Hooks are resolved to
+ * this executable, time is accumulated per function offset inside the image,
+ * so the same function of all nodes is summed. */
+typedef struct{
+    uintptr_t           offset;
+    unsigned long long  calls, self, total;
+}prof_entry_t;
+
+typedef struct{
+    uintptr_t           offset;
+    unsigned long long  start, child;
+}prof_frame_t;
+
+#define PROF_TABLE_SIZE 4096
+#define PROF_STACK_SIZE 256
+
+static prof_entry_t     profTable[PROF_TABLE_SIZE];
+static prof_frame_t     profStack[PROF_STACK_SIZE];
+static unsigned         profDepth;
+
+static unsigned long long prof_now(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+}
+
+static prof_entry_t *prof_entry(uintptr_t offset){
+    size_t i = (offset * 0x9E3779B1U) % PROF_TABLE_SIZE;
+    while(profTable[i].offset != 0 && profTable[i].offset != offset){
+        i = (i + 1) % PROF_TABLE_SIZE;
+    }
+    profTable[i].offset = offset;
+    return &profTable[i];
+}
+
+void __cyg_profile_func_enter(void *fn, void *site) __attribute__((no_instrument_function));
+void __cyg_profile_func_exit(void *fn, void *site) __attribute__((no_instrument_function));
+
+void __cyg_profile_func_enter(void *fn, void *site){
+    (void)site;
+    if(!opt.profile || simCurrent < 0) return;
+    if(profDepth < PROF_STACK_SIZE){
+        profStack[profDepth].offset = (uintptr_t)fn - nodes[simCurrent].base;
+        profStack[profDepth].child = 0;
+        profStack[profDepth].start = prof_now();
+    }
+    profDepth++;
+}
+
+void __cyg_profile_func_exit(void *fn, void *site){
+    (void)fn; (void)site;
+    if(!opt.profile || simCurrent < 0 || profDepth == 0) return;
+    profDepth--;
+    if(profDepth < PROF_STACK_SIZE){
+        prof_frame_t *f = &profStack[profDepth];
+        unsigned long long total = prof_now() - f->start;
+        prof_entry_t *e = prof_entry(f->offset);
+        e->calls++;
+        e->total += total;
+        e->self += total - (f->child < total ? f->child : total);
+        if(profDepth > 0) profStack[profDepth - 1].child += total;
+    }
+}
+
+/* Function name from the symbol table of the node image */
+static const char *prof_name(const char *image, uintptr_t offset){
+    static void *map;
+    static size_t mapSize;
+    const Elf64_Ehdr *eh;
+    const Elf64_Shdr *sh;
+    unsigned i;
+
+    if(map == NULL){
+        struct stat st;
+        int fd = open(image, O_RDONLY);
+        if(fd < 0) return "?";
+        if(fstat(fd, &st) == 0){
+            mapSize = (size_t)st.st_size;
+            map = mmap(NULL, mapSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        close(fd);
+        if(map == MAP_FAILED || map == NULL){ map = NULL; return "?"; }
+    }
+    eh = map;
+    if(memcmp(eh->e_ident, ELFMAG, SELFMAG) != 0 || eh->e_ident[EI_CLASS] != ELFCLASS64) return "?";
+    sh = (const Elf64_Shdr *)((const char *)map + eh->e_shoff);
+    for(i = 0; i < eh->e_shnum; i++){
+        if(sh[i].sh_type == SHT_SYMTAB){
+            const Elf64_Sym *sym = (const Elf64_Sym *)((const char *)map + sh[i].sh_offset);
+            const char *str = (const char *)map + sh[sh[i].sh_link].sh_offset;
+            size_t j, count = sh[i].sh_size / sizeof(Elf64_Sym);
+            for(j = 0; j < count; j++){
+                if(ELF64_ST_TYPE(sym[j].st_info) == STT_FUNC && sym[j].st_value == offset){
+                    return str + sym[j].st_name;
+                }
+            }
+        }
+    }
+    return "?";
+}
+
+static int prof_compare(const void *a, const void *b){
+    const prof_entry_t *x = a, *y = b;
+    if(x->self != y->self) return x->self < y->self ? 1 : -1;
+    return x->offset < y->offset ? -1 : (x->offset > y->offset);
+}
+
+static void prof_report(unsigned long long wall){
+    prof_entry_t *list = calloc(PROF_TABLE_SIZE, sizeof(prof_entry_t));
+    unsigned long long sum = 0;
+    size_t i, used = 0;
+
+    if(list == NULL) return;
+    for(i = 0; i < PROF_TABLE_SIZE; i++){
+        if(profTable[i].offset != 0){
+            list[used++] = profTable[i];
+            sum += profTable[i].self;
+        }
+    }
+    if(used == 0){
+        printf("\nprofile: no calls, %s is not built with -finstrument-functions\n", opt.image);
+        free(list);
+        return;
+    }
+    qsort(list, used, sizeof(prof_entry_t), prof_compare);
+
+    printf("\nprofile: stack code %.3f s of %.3f s wall, instrumentation included\n",
+           (double)sum / 1e9, (double)wall / 1e9);
+    printf("  %-32s %12s %10s %7s %10s %9s\n", "function", "calls", "self ms", "self %", "total ms", "ns/call");
+    for(i = 0; i < used && i < 25; i++){
+        printf("  %-32s %12llu %10.1f %6.1f%% %10.1f %9.0f\n", prof_name(opt.image, list[i].offset),
+               list[i].calls, (double)list[i].self / 1e6, sum ? 100.0 * (double)list[i].self / (double)sum : 0.0,
+               (double)list[i].total / 1e6, (double)list[i].self / (double)list[i].calls);
+    }
+    free(list);
+}
+
+
+/* Node images ****************************************************************/
+static void nodes_load(void){
+    char dir[] = "/tmp/cosimXXXXXX";
+    unsigned n;
+    void *image;
+    size_t size;
+    FILE *f;
+
+    f = fopen(opt.image, "rb");
+    if(f == NULL){ perror(opt.image); exit(EXIT_FAILURE); }
+    fseek(f, 0, SEEK_END);
+    size = (size_t)ftell(f);
+    fseek(f, 0, SEEK_SET);
+    image = malloc(size);
+    if(image == NULL || fread(image, 1, size, f) != size){ perror(opt.image); exit(EXIT_FAILURE); }
+    fclose(f);
+
+    if(mkdtemp(dir) == NULL){ perror("mkdtemp"); exit(EXIT_FAILURE); }
+
+    /* same file can be loaded only once, so each node gets its own copy, the
+     * LSS master too */
+    for(n = opt.lssScan ? SIM_MASTER : 1; n <= opt.nodes; n++){
+        char path[64];
+        struct link_map *lm;
+
+        snprintf(path, sizeof(path), "%s/node%u.so", dir, n);
+        f = fopen(path, "wb");
+        if(f == NULL || fwrite(image, 1, size, f) != size){ perror(path); exit(EXIT_FAILURE); }
+        fclose(f);
+
+        nodes[n].handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+        unlink(path);
+        if(nodes[n].handle == NULL){ fprintf(stderr, "%s\n", dlerror()); exit(EXIT_FAILURE); }
+        nodes[n].api = dlsym(nodes[n].handle, "CO_simNodeApi");
+        if(nodes[n].api == NULL){ fprintf(stderr, "%s\n", dlerror()); exit(EXIT_FAILURE); }
+        if(dlinfo(nodes[n].handle, RTLD_DI_LINKMAP, &lm) == 0) nodes[n].base = (uintptr_t)lm->l_addr;
+    }
+    rmdir(dir);
+    free(image);
+}
+
+static void nodes_init(void){
+    uint32_t serial[SIM_MAX_NODES + 1];
+    unsigned n, i;
+
+    for(n = 0; n <= opt.nodes; n++){
+        ports[n].txOnBus = CO_CAN_SIM_MAILBOX_NONE;
+    }
+
+    /* unique serial numbers, LSS master finds them in ascending order */
+    for(n = 1; n <= opt.nodes; n++){
+        serial[n] = n;
+        while(opt.lssScan){
+            serial[n] = (uint32_t)(rng_next() >> 32);
+            for(i = 1; i < n && serial[i] != serial[n]; i++);
+            if(i == n) break;
+        }
+    }
+
+    if(opt.lssScan){
+        CO_ReturnError_t err;
+
+        node_enter(SIM_MASTER);
+        err = nodes[SIM_MASTER].api->lssMasterInit(&ports[SIM_MASTER], (uint16_t)opt.lssTimeout_ms);
+        node_leave();
+        if(err != CO_ERROR_NO){
+            fprintf(stderr, "LSS master: CO_LSSmaster_init() failed (%d)\n", err);
+            exit(EXIT_FAILURE);
+        }
+        for(i = 0; i < 4; i++){
+            lssAssign.fastscan.scan[i] = (i + opt.lssScan >= 4) ? CO_LSSmaster_FS_SCAN : CO_LSSmaster_FS_MATCH;
+        }
+        lssAssign.fastscan.match.identity.vendorID = SIM_LSS_VENDOR_ID;
+        lssAssign.fastscan.match.identity.productCode = SIM_LSS_PRODUCT_CODE;
+        lssAssign.fastscan.match.identity.revisionNumber = SIM_LSS_REVISION;
+        lssAssign.nodeIdNext = 1;
+        lssAssign.nodeIdLast = (uint8_t)opt.nodes;
+        lssActive = 1;
+    }
+
+    for(n = 1; n <= opt.nodes; n++){
+        CO_simNodeConfig_t config;
+        CO_ReturnError_t err;
+        long long drift;
+
+        config.nodeId = opt.lssScan ? CO_LSS_NODE_ID_ASSIGNMENT : (uint8_t)n;
+        config.lssAddress.identity.vendorID = SIM_LSS_VENDOR_ID;
+        config.lssAddress.identity.productCode = SIM_LSS_PRODUCT_CODE;
+        config.lssAddress.identity.revisionNumber = SIM_LSS_REVISION;
+        config.lssAddress.identity.serialNumber = serial[n];
+        config.bitRate = (uint16_t)opt.bitRate;
+        config.syncPeriod_us = opt.syncPeriod_us;
+        config.syncWindow_us = opt.syncWindow_us;
+        config.heartbeat_ms = 0;
+        config.rpdoTransmissionType = (uint8_t)opt.rpdoType;
+        config.tpdoTransmissionType = (uint8_t)opt.tpdoType;
+        config.tpdoInhibit_100us = 0;
+        config.motorTau_ms = 50;
+
+        node_enter(n);
+        err = nodes[n].api->init(&ports[n], &config);
+        node_leave();
+        if(err != CO_ERROR_NO){
+            fprintf(stderr, "node %u: CO_init() failed (%d)\n", n, err);
+            exit(EXIT_FAILURE);
+        }
+
+        /* crystal tolerance and random phase of the 1 ms SysTick */
+        drift = opt.driftPpm ? (long long)(rng_next() % (2ULL * opt.driftPpm + 1)) - (long long)opt.driftPpm : 0;
+        nodes[n].tickPeriod = (unsigned long long)((long long)SIM_NS_PER_MS + drift * 1000LL);
+        ev_push(rng_next() % SIM_NS_PER_MS, EV_NODE_TICK, n);
+        node_schedule_process(n);
+    }
+}
+
+
+/* Main ***********************************************************************/
+static void usage(const char *name){
+    fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  -n nodes       drive nodes, 1..127 (64)\n"
+        "  -b kbit/s      bit rate (1000)\n"
+        "  -s us          SYNC period (20000)\n"
+        "  -w us          synchronous window length 1007h, 0 = off (0)\n"
+        "  -q us          SDO upload polling interval, 0 = off (2000)\n"
+        "  -l us          CAN interrupt to main loop latency (50)\n"
+        "  -d ppm         max. clock deviation of nodes (100)\n"
+        "  -T type        TPDO transmission type (1)\n"
+        "  -R type        RPDO transmission type (1)\n"
+        "  -a subs        nodes without node ID, LSS Fastscan scans the last 1..4\n"
+        "                 subs of 1018h, the others are known, 0 = off (0)\n"
+        "  -A ms          LSS Fastscan response timeout (%u)\n"
+        "  -t s           simulated time (10)\n"
+        "  -r seed        seed for clock phases and deviations (1)\n"
+        "  -L file        node image (CO_simNode.so next to this program,\n"
+        "                 CO_simNode_prof.so with -p)\n"
+        "  -p             profile stack functions, image must be instrumented\n"
+        "  -v             print all frames\n", name, CO_LSSmaster_DEFAULT_TIMEOUT);
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[]){
+    unsigned long long wallStart, wall;
+    unsigned n, i, operational = 0, resets = 0, unconfigured = 0, duplicates = 0;
+    unsigned char idUsed[128] = {0};
+    char imagePath[4096];
+    int c;
+
+    while((c = getopt(argc, argv, "n:b:s:w:q:l:d:T:R:a:A:t:r:L:pv")) != -1){
+        switch(c){
+            case 'n': opt.nodes = (unsigned)strtoul(optarg, NULL, 0); break;
+            case 'b': opt.bitRate = (unsigned)strtoul(optarg, NULL, 0); break;
+            case 's': opt.syncPeriod_us = (unsigned)strtoul(optarg, NULL, 0); break;
+            case 'w': opt.syncWindow_us = (unsigned)strtoul(optarg, NULL, 0); break;
+            case 'q': opt.sdoInterval_us = (unsigned)strtoul(optarg, NULL, 0); break;
+            case 'l': opt.processLatency_us = (unsigned)strtoul(optarg, NULL, 0); break;
+            case 'd': opt.driftPpm = (unsigned)strtoul(optarg, NULL, 0); break;
+            case 'T': opt.tpdoType = (unsigned)strtoul(optarg, NULL, 0); break;
+            case 'R': opt.rpdoType = (unsigned)strtoul(optarg, NULL, 0); break;
+            case 'a': opt.lssScan = (unsigned)strtoul(optarg, NULL, 0); break;
+            case 'A': opt.lssTimeout_ms = (unsigned)strtoul(optarg, NULL, 0); break;
+            case 't': opt.duration_ns = (unsigned long long)(strtod(optarg, NULL) * 1e9); break;
+            case 'r': opt.seed = strtoull(optarg, NULL, 0); break;
+            case 'L': opt.image = optarg; break;
+            case 'p': opt.profile = 1; break;
+            case 'v': opt.verbose = 1; break;
+            default: usage(argv[0]);
+        }
+    }
+    if(opt.nodes < 1 || opt.nodes > SIM_MAX_NODES || opt.bitRate == 0 || opt.syncPeriod_us == 0
+       || opt.driftPpm > 10000 || opt.lssScan > 4 || opt.lssTimeout_ms == 0 || opt.lssTimeout_ms > 0xFFFF){
+        usage(argv[0]);
+    }
+    if(opt.image == NULL){
+        const char *slash = strrchr(argv[0], '/');
+        snprintf(imagePath, sizeof(imagePath), "%.*s%s",
+                 slash ? (int)(slash - argv[0] + 1) : 0, argv[0], opt.profile ? "CO_simNode_prof.so" : "CO_simNode.so");
+        opt.image = imagePath;
+    }
+    rngState = opt.seed ? opt.seed : 0x9E3779B97F4A7C15ULL;
+
+    nodes_load();
+    wallStart = prof_now();
+    nodes_init();
+
+    if(opt.lssScan){
+        ev_push(SIM_NS_PER_MS, EV_MASTER_LSS, SIM_MASTER);
+    }
+    else{
+        master_start(0);
+    }
+    bus_kick();
+
+    while(evCount > 0){
+        sim_event_t ev = ev_pop();
+        if(ev.time > opt.duration_ns && !lssActive) break;
+        simTime = ev.time;
+
+        switch(ev.type){
+            case EV_NODE_TICK:
+                node_enter(ev.port);
+                nodes[ev.port].api->tick();
+                nodes[ev.port].api->process();
+                node_leave();
+                ev_push(simTime + nodes[ev.port].tickPeriod, EV_NODE_TICK, ev.port);
+                break;
+            case EV_NODE_PROCESS:
+                nodes[ev.port].processPending = 0;
+                node_enter(ev.port);
+                nodes[ev.port].api->process();
+                node_leave();
+                break;
+            case EV_BUS_END:
+                bus_end();
+                break;
+            case EV_BUS_ARBITRATE:
+                bus_arbitrate();
+                break;
+            case EV_MASTER_NMT:{
+                uint8_t data[2] = {CO_NMT_ENTER_OPERATIONAL, 0};
+                master_send(MTX_NMT, CO_CAN_ID_NMT_SERVICE, 2, data);
+                break;
+            }
+            case EV_MASTER_SYNC:
+                master_sync();
+                ev_push(simTime + (unsigned long long)opt.syncPeriod_us * 1000ULL, EV_MASTER_SYNC, SIM_MASTER);
+                break;
+            case EV_MASTER_SDO:
+                master_sdo();
+                ev_push(simTime + (unsigned long long)opt.sdoInterval_us * 1000ULL, EV_MASTER_SDO, SIM_MASTER);
+                break;
+            case EV_MASTER_LSS:
+                master_lss();
+                break;
+        }
+        /* anything queued by the stack code is arbitrated at this time */
+        if(ev.type != EV_BUS_ARBITRATE) bus_kick();
+    }
+    wall = prof_now() - wallStart;
+
+    /* Report */
+    printf("cosim: %u nodes, %u kbit/s, SYNC %u us, window %u us, SDO %u us, seed %llu\n",
+           opt.nodes, opt.bitRate, opt.syncPeriod_us, opt.syncWindow_us, opt.sdoInterval_us, opt.seed);
+    printf("time: %.3f s virtual, %.3f s wall (%.1fx real time)\n",
+           (double)opt.duration_ns / 1e9, (double)wall / 1e9, (double)opt.duration_ns / (double)(wall ? wall : 1));
+    printf("bus: %llu frames, load %.1f %%, %.1f bits/frame, identifier collisions %llu\n",
+           bus.frames, 100.0 * (double)bus.busyTime / (double)opt.duration_ns,
+           bus.frames ? (double)bus.bits / (double)bus.frames : 0.0, bus.collisions);
+    printf("  %-10s %10s %12s %12s\n", "class", "frames", "avg us", "max us");
+    for(i = 0; i < 16; i++){
+        if(classLatency[i].count == 0) continue;
+        printf("  %-10s %10llu %12.1f %12.1f\n", classNames[i], classLatency[i].count,
+               (double)classLatency[i].sum / (double)classLatency[i].count / 1e3, (double)classLatency[i].max / 1e3);
+    }
+    printf("SYNC: %u cycles, TPDO after SYNC min/avg/max %.1f/%.1f/%.1f us, missed TPDO %llu\n",
+           syncCycle, (double)tpdoLatency.min / 1e3,
+           tpdoLatency.count ? (double)tpdoLatency.sum / (double)tpdoLatency.count / 1e3 : 0.0,
+           (double)tpdoLatency.max / 1e3, tpdoMissed);
+    printf("      cycle traffic avg/max %.1f/%.1f us, RPDO after next SYNC %llu, RPDO overwritten %llu\n",
+           cycleBusy.count ? (double)cycleBusy.sum / (double)cycleBusy.count / 1e3 : 0.0,
+           (double)cycleBusy.max / 1e3, rpdoLate, rpdoOverrun);
+    printf("SDO: %llu requests, %llu responses, %llu aborts, %llu timeouts, latency avg/max %.1f/%.1f us\n",
+           sdoRequests, sdoLatency.count, sdoAborts, sdoTimeouts,
+           sdoLatency.count ? (double)sdoLatency.sum / (double)sdoLatency.count / 1e3 : 0.0,
+           (double)sdoLatency.max / 1e3);
+    printf("EMCY:");
+    for(i = 0; i < emcyCodesUsed; i++){
+        printf(" %04Xh x%u", emcyCodes[i][0], emcyCodes[i][1]);
+    }
+    printf("%s\n", emcyCodesUsed ? "" : " none");
+
+    for(n = 1; n <= opt.nodes; n++){
+        CO_simNodeStatus_t st;
+        node_enter(n);
+        nodes[n].api->status(&st);
+        node_leave();
+        if(st.operatingState == CO_NMT_OPERATIONAL) operational++;
+        resets += st.resets;
+        if(st.nodeId < 1 || st.nodeId > 127) unconfigured++;
+        else if(idUsed[st.nodeId]++) duplicates++;
+        if(opt.verbose || emcyCount[n] != 0 || st.errorRegister != 0){
+            printf("  node %3u: state %u, error register %02Xh, EMCY %llu, speed %d/%d rpm, tx overflow %u, aborted %u\n",
+                   n, st.operatingState, st.errorRegister, emcyCount[n], st.speed, st.speedRef,
+                   ports[n].txOverflow, ports[n].txAborted);
+        }
+    }
+    printf("nodes: %u operational, %u communication resets\n", operational, resets);
+    if(opt.lssScan){
+        printf("LSS: %u node IDs assigned in %.3f s, %u subs scanned, Fastscan timeout %u ms, result %d, "
+               "%u without node ID, %u duplicate node IDs\n",
+               lssAssign.assigned, (double)lssTime / 1e9, opt.lssScan, opt.lssTimeout_ms, lssResult,
+               unconfigured, duplicates);
+    }
+    printf("trace hash: %016llx\n", bus.hash);
+
+    if(opt.profile) prof_report(wall);
+
+    if(opt.lssScan && (lssResult != CO_LSSmaster_SCAN_FINISHED || unconfigured != 0 || duplicates != 0)){
+        return EXIT_FAILURE;
+    }
+    return 0;
+}
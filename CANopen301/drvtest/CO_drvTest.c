@@ -0,0 +1,996 @@
+/*
+ * Host tests of the STM32F3 CAN driver against a register model of bxCAN.
+ *
+ * @file        CO_drvTest.c
+ * @author      Janez Paternoster
+ * @copyright   2015 Janez Paternoster
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/* stack/STM32F3/CO_driver.c, bsp_can.c and the HAL CAN driver are compiled
+ * unchanged, drvtest/CO_drvTestShim.h replaces the core registers, critical
+ * sections and the few register writes, which the model must see at once.
+ * CAN registers are plain memory, the model evaluates them between driver
+ * calls and calls the interrupt functions. Node uses the stack with
+ * example/CO_OD.c, as CANopen_Init() of the firmware. Bus time is virtual,
+ * results do not depend on the host.
+ *
+ * rx_filters: receive buffers get a hook, which records the buffer the driver
+ * delivered the frame to. Every frame is checked against the linear search of
+ * the software filter, so wrong filter banks fail the test.
+ *
+ * tx_latency: transmit mailboxes and arbitration of a loaded bus, every 1 us.
+ * Frames of the drive carry a sequence number, which must reach the bus in
+ * order, SDO segments without gaps. Interrupt of the mailboxes is served by
+ * HAL_CAN_IRQHandler() with the callbacks of bsp_can.c. */
+
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "CANopen.h"
+
+
+#define DRV_NODE_ID             5
+#define DRV_NODES               127
+#define DRV_SYNC_US             50000   /* SYNC, RPDO and TPDO of all drives */
+#define DRV_SDO_POLL_US         5000    /* SDO client polls drives in turn */
+#define DRV_HB_US               1000000 /* heartbeat of all drives */
+#define DRV_BIT_US              1       /* 1000 kbit/s */
+#define DRV_RX_MAX              DRV_NODES
+#define DRV_RX_NONE             0xFFFFU
+
+#define DRV_CPU_MHZ             72      /* CYCCNT of the driver timestamps */
+#define DRV_TX_RUN_US           10000000
+#define DRV_TX_DRAIN_US         100000  /* no new frames, queues must empty */
+#define DRV_TX_SYNC_US          2000
+#define DRV_TX_NODES            4       /* other drives, TPDO1 and TPDO2 after SYNC */
+#define DRV_TX_ERROR_EVERY      211     /* every n-th frame gets an error frame */
+#define DRV_TX_ERROR_BITS       20      /* error flag, delimiter and intermission */
+#define DRV_TX_SDO_CLIENT_US    50      /* PLC requests next segment */
+#define DRV_TX_SDO_SERVER_US    100     /* main loop of the drive answers */
+#define DRV_TX_HB_US            100000
+#define DRV_TX_SEQ_RING         16
+#define DRV_TIR_EMPTY           0xFFFFFFFEU /* driver clears it, before it writes identifier */
+
+
+/* Model of the core and CAN registers */
+DWT_Type                    CO_drvTestDWT;
+CoreDebug_Type              CO_drvTestCoreDebug;
+uint32_t                    CO_drvTestFilterInit;
+CAN_TypeDef                 CO_drvTestCAN;
+
+static CAN_HandleTypeDef    drvCAN;
+static CAN_TypeDef          drvHbCANregs;
+static CAN_HandleTypeDef    drvHbCAN = {.Instance = &drvHbCANregs};
+
+/* Receive buffer hooks */
+typedef struct{
+    void               *object;
+    void              (*pFunct)(void *object, const CO_CANrxMsg_t *message);
+    uint16_t            index;
+}drv_rxHook_t;
+
+static drv_rxHook_t         drvHooks[DRV_RX_MAX];
+static drv_rxHook_t         drvHbHooks[DRV_RX_MAX];
+static uint16_t             drvDelivered;
+static uint32_t             drvRxBufferInits;
+
+/* Heartbeat consumer for all drives, more receive buffers than filters */
+static CO_CANmodule_t       drvHbModule;
+static CO_CANrx_t           drvHbRx[DRV_NODES];
+static CO_CANtx_t           drvHbTx[1];
+static CO_HBconsumer_t      drvHbCons;
+static CO_HBconsNode_t      drvHbNodes[DRV_NODES];
+static uint32_t             drvHbTime[DRV_NODES];
+
+/* Transmit mailboxes, TSR holds drvTsrFlags and empty flags */
+typedef enum{
+    DRV_MB_EMPTY,
+    DRV_MB_CLAIMED,         /* driver writes identifier and data */
+    DRV_MB_PENDING,         /* transmission requested */
+    DRV_MB_TX               /* arbitration or data, abort waits for the result */
+}drv_mbState_t;
+
+static drv_mbState_t        drvMbState[CO_CAN_NO_TX_MAILBOXES];
+static bool_t               drvMbAbort[CO_CAN_NO_TX_MAILBOXES];
+static uint32_t             drvTsrFlags;    /* RQCP, TXOK, ALST, TERR */
+
+/* Transmitter of the other nodes, one frame at a time */
+typedef struct{
+    uint16_t            ident;
+    uint8_t             DLC;
+    bool_t              pending;
+    uint32_t            release;        /* bus time, from which it competes */
+}drv_extTx_t;
+
+/* Transmit buffer of the drive, application sends it at release time */
+typedef struct{
+    const char         *name;
+    CO_CANtx_t         *buffer;
+    bool_t              pending;
+    uint32_t            release;
+    uint32_t            seq;            /* last one sent */
+    uint32_t            seqOnBus;
+    uint32_t            sendTime[DRV_TX_SEQ_RING];
+    uint32_t            skipped;        /* sequence numbers, which were not on the bus */
+    uint32_t            overwritten;    /* sent again, before previous reached the bus */
+    uint32_t            latencyMax;     /* CO_CANsend() to end of frame, us */
+    uint64_t            latencySum;
+    uint32_t            latencyCount;
+}drv_dutTx_t;
+
+enum{DRV_EXT_SYNC, DRV_EXT_SDO, DRV_EXT_TPDO};
+enum{DRV_DUT_TPDO, DRV_DUT_SDO = 4, DRV_DUT_HB, DRV_DUT_NO};
+
+static drv_extTx_t          drvExt[DRV_EXT_TPDO + 2 * DRV_TX_NODES];
+static drv_dutTx_t          drvDut[DRV_DUT_NO];
+
+/* Frame on the bus */
+static struct{
+    bool_t              busy;
+    uint32_t            arbEnd;
+    uint32_t            end;
+    uint32_t            idle;           /* intermission passed */
+    int8_t              mailbox;        /* mailbox of the drive in arbitration, -1 none */
+    bool_t              dutWins;
+    int16_t             ext;            /* winner of other nodes, -1 drive */
+    bool_t              error;
+}drvBus;
+static uint32_t             drvNow;         /* bus time, us */
+
+typedef struct{
+    uint32_t            frames;
+    uint32_t            busBits;
+    uint32_t            errors;
+    uint32_t            aborts;         /* preemptions */
+    uint32_t            abortPending;   /* aborted before arbitration */
+    uint32_t            abortFailed;    /* aborted by arbitration lost or error, error callback */
+    uint32_t            abortTooLate;   /* sent anyway */
+    uint32_t            sdoSegments;
+}drv_txCount_t;
+static drv_txCount_t        drvTxCount;
+
+/* Counters of one second of bus traffic */
+typedef struct{
+    uint32_t            frames;
+    uint32_t            busBits;
+    uint32_t            interrupts[2];  /* FIFO0, FIFO1 */
+    uint32_t            delivered;
+    uint32_t            direct;         /* found by filter match index */
+}drv_count_t;
+
+
+/* Helpers ********************************************************************/
+static void drv_fail(const char *name, const char *what){
+    fprintf(stderr, "CO_drvTest: %s: %s\n", name, what);
+    exit(EXIT_FAILURE);
+}
+
+/* Frame length with worst case bit stuffing, standard identifier */
+static uint32_t drv_frameBits(uint8_t DLC){
+    return 47U + 8U * DLC + (34U + 8U * DLC - 1U) / 4U;
+}
+
+/* Firmware functions, which are not part of the test */
+void _Error_Handler(char *file, int line){
+    drv_fail("HAL", "MX_CAN_Init() failed");
+}
+
+void APP_EventPost(uint32_t wEvents){
+}
+
+/* Master reset of HAL_CAN_DeInit() is done, before HAL_CAN_Init() runs */
+void HAL_CAN_MspInit(CAN_HandleTypeDef *hcan){
+    if(hcan->Instance->MCR & CAN_MCR_RESET){
+        hcan->Instance->MCR = 0x00010002U;  /* reset value, sleep mode */
+    }
+}
+
+/* Initialization and sleep modes follow the requests at once */
+uint32_t HAL_GetTick(void){
+    static uint32_t tick;
+    CAN_TypeDef *CANx = &CO_drvTestCAN;
+
+    CANx->MSR = (CANx->MSR & ~(CAN_MSR_INAK | CAN_MSR_SLAK))
+              | ((CANx->MCR & CAN_MCR_INRQ) ? CAN_MSR_INAK : 0U)
+              | ((CANx->MCR & CAN_MCR_SLEEP) ? CAN_MSR_SLAK : 0U);
+    return tick++;
+}
+
+/* Stack functions, which are not part of the test */
+bool MI_SetReg(UI_Handle_t *pHandle, CO_SDO_t *pSDO){
+    return false;
+}
+
+int32_t MI_GetReg(UI_Handle_t *pHandle, CO_SDO_t *pSDO){
+    return (int32_t)GUI_ERROR_CODE;
+}
+
+/* Counts registrations, called by the stack objects */
+CO_ReturnError_t __real_CO_CANrxBufferInit(CO_CANmodule_t *CANmodule, uint16_t index,
+        uint16_t ident, uint16_t mask, int8_t rtr, void *object,
+        void (*pFunct)(void *object, const CO_CANrxMsg_t *message));
+
+CO_ReturnError_t __wrap_CO_CANrxBufferInit(CO_CANmodule_t *CANmodule, uint16_t index,
+        uint16_t ident, uint16_t mask, int8_t rtr, void *object,
+        void (*pFunct)(void *object, const CO_CANrxMsg_t *message))
+{
+    drvRxBufferInits++;
+    return __real_CO_CANrxBufferInit(CANmodule, index, ident, mask, rtr, object, pFunct);
+}
+
+
+/* bxCAN model ****************************************************************/
+/* Filter, which accepts the frame. Filter match index counts filters of all
+ * banks assigned to the FIFO, active or not. If more filters match, 32-bit
+ * scale wins over 16-bit, list mode over mask mode, then lower filter. */
+static bool_t drv_filterMatch(const CAN_TypeDef *CANx, uint16_t ident, uint8_t rtr,
+        uint8_t *fifo, uint8_t *fmi)
+{
+    uint32_t word32 = ((uint32_t)ident << 21) | (rtr ? 0x02U : 0U);
+    uint16_t word16 = (uint16_t)((ident << 5) | (rtr ? 0x10U : 0U));
+    uint32_t bestRank = UINT32_MAX;
+    uint8_t number[2] = {0, 0};
+    uint8_t bank, k;
+
+    for(bank = 0; bank < CO_CAN_NO_FILTER_BANKS; bank++){
+        uint32_t bit = 1UL << bank;
+        uint8_t f = (CANx->FFA1R & bit) ? 1 : 0;
+        bool_t scale32 = (CANx->FS1R & bit) ? true : false;
+        bool_t list = (CANx->FM1R & bit) ? true : false;
+        uint32_t fr1 = CANx->sFilterRegister[bank].FR1;
+        uint32_t fr2 = CANx->sFilterRegister[bank].FR2;
+        uint16_t reg[4] = {(uint16_t)fr1, (uint16_t)(fr1 >> 16), (uint16_t)fr2, (uint16_t)(fr2 >> 16)};
+        uint8_t n = scale32 ? (list ? 2 : 1) : (list ? 4 : 2);
+
+        for(k = 0; k < n && (CANx->FA1R & bit) != 0; k++){
+            bool_t match;
+            uint32_t rank;
+
+            if(scale32){
+                match = list ? (word32 == (k == 0 ? fr1 : fr2)) : (((word32 ^ fr1) & fr2) == 0);
+            }
+            else{
+                match = list ? (word16 == reg[k]) : (((word16 ^ reg[k * 2]) & reg[k * 2 + 1]) == 0);
+            }
+            rank = ((scale32 ? 0U : 2U) + (list ? 0U : 1U)) * 256U + bank * 4U + k;
+            if(match && rank < bestRank){
+                bestRank = rank;
+                *fifo = f;
+                *fmi = (uint8_t)(number[f] + k);
+            }
+        }
+        number[f] += n;
+    }
+    return (bestRank != UINT32_MAX) ? true : false;
+}
+
+/* Buffer, which the software filter of the driver finds */
+static uint16_t drv_rxExpected(const CO_CANmodule_t *CANmodule, uint16_t ident){
+    uint16_t msg = (uint16_t)(ident << 2);
+    uint16_t i;
+
+    for(i = 0; i < CANmodule->rxSize; i++){
+        const CO_CANrx_t *rxBuffer = &CANmodule->rxArray[i];
+        if(rxBuffer->pFunct != NULL && ((msg ^ rxBuffer->ident) & rxBuffer->mask) == 0){
+            return i;
+        }
+    }
+    return DRV_RX_NONE;
+}
+
+static void drv_rxHook(void *object, const CO_CANrxMsg_t *message){
+    drvDelivered = ((drv_rxHook_t*)object)->index;
+}
+
+/* Replace callbacks of the registered buffers with hooks. Filters depend only
+ * on identifiers, so they are not rebuilt. */
+static void drv_hookRxBuffers(CO_CANmodule_t *CANmodule, drv_rxHook_t hooks[]){
+    uint16_t i;
+
+    for(i = 0; i < CANmodule->rxSize; i++){
+        CO_CANrx_t *rxBuffer = &CANmodule->rxArray[i];
+        if(rxBuffer->pFunct != NULL && rxBuffer->pFunct != drv_rxHook){
+            hooks[i].object = rxBuffer->object;
+            hooks[i].pFunct = rxBuffer->pFunct;
+            hooks[i].index = i;
+            rxBuffer->object = &hooks[i];
+            rxBuffer->pFunct = drv_rxHook;
+        }
+    }
+}
+
+/* Frame from the bus: filter, receive interrupt, check the buffer */
+static void drv_rx(CO_CANmodule_t *CANmodule, drv_count_t *count, uint16_t ident, uint8_t DLC){
+    CAN_TypeDef *CANx = CANmodule->CANbaseAddress->Instance;
+    uint16_t expected = drv_rxExpected(CANmodule, ident);
+    uint8_t fifo, fmi;
+
+    count->frames++;
+    count->busBits += drv_frameBits(DLC);
+    drvDelivered = DRV_RX_NONE;
+
+    if(drv_filterMatch(CANx, ident, 0, &fifo, &fmi)){
+        CAN_FIFOMailBox_TypeDef *rxMbox = &CANx->sFIFOMailBox[fifo];
+
+        rxMbox->RIR = (uint32_t)ident << CAN_RI0R_STID_Pos;
+        rxMbox->RDTR = ((uint32_t)fmi << CAN_RDT0R_FMI_Pos) | DLC;
+        rxMbox->RDLR = 0x01010101U * (uint8_t)ident;
+        rxMbox->RDHR = rxMbox->RDLR;
+        if(fifo == 0) CANx->RF0R = 1U << CAN_RF0R_FMP0_Pos;
+        else          CANx->RF1R = 1U << CAN_RF1R_FMP1_Pos;
+
+        count->interrupts[fifo]++;
+        CO_CANinterrupt_Rx(CANmodule, fifo == 0 ? CAN_RX_FIFO0 : CAN_RX_FIFO1);
+        CANx->RF0R = 0;
+        CANx->RF1R = 0;
+
+        if(drvDelivered != DRV_RX_NONE && fmi < CO_CAN_NO_FILTERS_PER_FIFO
+           && CANmodule->rxFilterMap[fifo][fmi] == drvDelivered)
+        {
+            count->direct++;
+        }
+    }
+
+    if(drvDelivered != expected){
+        static char what[64];
+        snprintf(what, sizeof(what), "frame 0x%03X delivered to %d, expected %d",
+                 ident, (int16_t)drvDelivered, (int16_t)expected);
+        drv_fail("rx_filters", what);
+    }
+    if(drvDelivered != DRV_RX_NONE){
+        count->delivered++;
+    }
+}
+
+/* One second of a line with DRV_NODES drives and a PLC, which is NMT master,
+ * SYNC producer and SDO client. Frames of the tested drive are not received. */
+static void drv_traffic(CO_CANmodule_t *CANmodule, drv_count_t *count){
+    uint32_t t;
+    uint16_t node;
+
+    memset(count, 0, sizeof(*count));
+    drv_rx(CANmodule, count, CO_CAN_ID_NMT_SERVICE, 2);
+
+    for(t = 0; t < 1000000; t += 1000){
+        if(t % DRV_SYNC_US == 0){
+            drv_rx(CANmodule, count, CO_CAN_ID_SYNC, 0);
+            for(node = 1; node <= DRV_NODES; node++){
+                drv_rx(CANmodule, count, (uint16_t)(CO_CAN_ID_RPDO_1 + node), 8);
+                if(node != DRV_NODE_ID){
+                    drv_rx(CANmodule, count, (uint16_t)(CO_CAN_ID_TPDO_1 + node), 8);
+                }
+            }
+        }
+        if(t % DRV_SDO_POLL_US == 0){
+            node = (uint16_t)((t / DRV_SDO_POLL_US) % DRV_NODES + 1);
+            drv_rx(CANmodule, count, (uint16_t)(CO_CAN_ID_RSDO + node), 8);
+            if(node != DRV_NODE_ID){
+                drv_rx(CANmodule, count, (uint16_t)(CO_CAN_ID_TSDO + node), 8);
+            }
+        }
+        node = (uint16_t)((t % DRV_HB_US) / 1000 + 1);
+        if(node <= DRV_NODES && node != DRV_NODE_ID){
+            drv_rx(CANmodule, count, (uint16_t)(CO_CAN_ID_HEARTBEAT + node), 1);
+        }
+    }
+}
+
+static void drv_printCount(const char *name, const drv_count_t *count){
+    printf("  %-22s rx interrupts/s %5u (FIFO0 %5u, FIFO1 %5u), delivered %3u, by filter index %3u\n",
+           name, (unsigned)(count->interrupts[0] + count->interrupts[1]),
+           (unsigned)count->interrupts[0], (unsigned)count->interrupts[1],
+           (unsigned)count->delivered, (unsigned)count->direct);
+}
+
+/* Filter programmings since last call */
+static uint32_t drv_filterProgrammings(void){
+    uint32_t n = CO_drvTestFilterInit / 2U;     /* FINIT is set and cleared */
+    CO_drvTestFilterInit = 0;
+    return n;
+}
+
+
+/* Receive filters ************************************************************/
+static void drv_testRxFilters(void){
+    drv_count_t hw, sw, hb;
+    uint32_t initRegs, initProg, resetProg, changeProg, sameProg;
+    uint16_t i;
+
+    /* CANopen_Init() of the firmware */
+    MX_CAN_Init(&drvCAN, 1000);
+    drvRxBufferInits = 0;
+    drv_filterProgrammings();
+    if(CO_init((int32_t)(intptr_t)&drvCAN, DRV_NODE_ID, 1000, NULL) != CO_ERROR_NO){
+        drv_fail("rx_filters", "CO_init() failed");
+    }
+    CO_CANsetNormalMode(CO->CANmodule[0]);
+    initRegs = drvRxBufferInits;
+    initProg = drv_filterProgrammings();
+
+    /* CANopen_CommunicationReset() of the firmware */
+    CO_delete((int32_t)(intptr_t)&drvCAN);
+    MX_CAN_Init(&drvCAN, 1000);
+    drv_filterProgrammings();
+    if(CO_init((int32_t)(intptr_t)&drvCAN, DRV_NODE_ID, 1000, NULL) != CO_ERROR_NO){
+        drv_fail("rx_filters", "CO_init() after communication reset failed");
+    }
+    CO_CANsetNormalMode(CO->CANmodule[0]);
+    resetProg = drv_filterProgrammings();
+
+    if(!CO->CANmodule[0]->useCANrxFilters){
+        drv_fail("rx_filters", "filters of the node don't fit into banks");
+    }
+    drv_hookRxBuffers(CO->CANmodule[0], drvHooks);
+    drv_traffic(CO->CANmodule[0], &hw);
+
+    /* RPDO COB-ID written by SDO in operational, then the same value again */
+    i = CO->RPDO[1]->CANdevRxIdx;
+    CO_CANrxBufferInit(CO->CANmodule[0], i, 0x1F0, 0x7FF, 0, &drvHooks[i], drv_rxHook);
+    changeProg = drv_filterProgrammings();
+    CO_CANrxBufferInit(CO->CANmodule[0], i, 0x1F0, 0x7FF, 0, &drvHooks[i], drv_rxHook);
+    sameProg = drv_filterProgrammings();
+    {
+        drv_count_t c;
+        memset(&c, 0, sizeof(c));
+        drv_rx(CO->CANmodule[0], &c, 0x1F0, 8);
+        if(c.delivered != 1 || c.direct != 1){
+            drv_fail("rx_filters", "changed COB-ID not received by filter");
+        }
+    }
+    CO_CANrxBufferInit(CO->CANmodule[0], i, CO_CAN_ID_RPDO_2 + DRV_NODE_ID, 0x7FF, 0, &drvHooks[i], drv_rxHook);
+    drv_filterProgrammings();
+
+    /* before hardware filters: catch-all bank 13 of MX_CAN_Init() */
+    CO_drvTestCAN.FA1R = 0;
+    CO_drvTestCAN.FM1R = 0;
+    CO_drvTestCAN.FS1R = 1UL << 13;
+    CO_drvTestCAN.FFA1R = 0;
+    CO_drvTestCAN.sFilterRegister[13].FR1 = 0;
+    CO_drvTestCAN.sFilterRegister[13].FR2 = 0;
+    CO_drvTestCAN.FA1R = 1UL << 13;
+    drv_traffic(CO->CANmodule[0], &sw);
+    CO_CANsetNormalMode(CO->CANmodule[0]);
+    drv_filterProgrammings();
+
+    /* heartbeat consumer of all drives, banks run out */
+    if(CO_CANmodule_init(&drvHbModule, &drvHbCAN, drvHbRx, DRV_NODES, drvHbTx, 1, 1000) != CO_ERROR_NO){
+        drv_fail("rx_filters", "CO_CANmodule_init() failed");
+    }
+    drvHbCAN.State = HAL_CAN_STATE_LISTENING;
+    for(i = 0; i < DRV_NODES; i++){
+        drvHbTime[i] = ((uint32_t)(i + 1) << 16) | 3000U;
+    }
+    if(CO_HBconsumer_init(&drvHbCons, CO->em, CO->SDO[0], drvHbTime, drvHbNodes, DRV_NODES, &drvHbModule, 0) != CO_ERROR_NO){
+        drv_fail("rx_filters", "CO_HBconsumer_init() failed");
+    }
+    CO_CANsetNormalMode(&drvHbModule);
+    drv_filterProgrammings();
+    if(drvHbModule.useCANrxFilters){
+        drv_fail("rx_filters", "heartbeat consumer should use catch-all filter");
+    }
+    drv_hookRxBuffers(&drvHbModule, drvHbHooks);
+    drv_traffic(&drvHbModule, &hb);
+
+    if(initProg != 1 || resetProg != 1 || changeProg != 1 || sameProg != 0){
+        drv_fail("rx_filters", "filters must be programmed once per CO_init() and per COB-ID change");
+    }
+    if(hw.delivered != sw.delivered || hw.direct != hw.delivered){
+        drv_fail("rx_filters", "hardware filters must deliver all frames by filter index");
+    }
+
+    printf("rx_filters: node %u of %u drives, bus load %.1f %%, %u frames/s\n",
+           DRV_NODE_ID, DRV_NODES, (double)hw.busBits * DRV_BIT_US / 1e4, (unsigned)hw.frames);
+    drv_printCount("catch-all filter", &sw);
+    drv_printCount("hardware filters", &hw);
+    drv_printCount("127 heartbeats", &hb);
+    printf("  filter programming     CO_init %u (rx buffer registrations %u), communication reset %u,"
+           " COB-ID change %u, same COB-ID %u\n",
+           (unsigned)initProg, (unsigned)initRegs, (unsigned)resetProg,
+           (unsigned)changeProg, (unsigned)sameProg);
+}
+
+
+/* Transmit mailboxes *********************************************************/
+static bool_t               drvDraining;    /* no new frames at end of run */
+static uint32_t             drvLcg;
+
+/* Application delays, same sequence in every run */
+static uint32_t drv_random(uint32_t range){
+    drvLcg = drvLcg * 1664525U + 1013904223U;
+    return (drvLcg >> 16) % range;
+}
+
+/* TSR as the driver and HAL read it */
+static void drv_tsrWrite(void){
+    uint32_t tsr = drvTsrFlags;
+    uint8_t m;
+
+    for(m = 0; m < CO_CAN_NO_TX_MAILBOXES; m++){
+        if(drvMbState[m] == DRV_MB_EMPTY){
+            tsr |= CAN_TSR_TME0 << m;
+        }
+    }
+    CO_drvTestCAN.TSR = tsr;
+}
+
+/* Mailbox is empty, request completed with status flags */
+static void drv_mbComplete(uint8_t m, uint32_t flags){
+    drvMbState[m] = DRV_MB_EMPTY;
+    drvMbAbort[m] = false;
+    drvTsrFlags |= (CAN_TSR_RQCP0 | flags) << (8U * m);
+    CO_drvTestCAN.sTxMailBox[m].TIR = DRV_TIR_EMPTY;
+    drv_tsrWrite();
+}
+
+/* Driver cleared identifier register of the empty mailbox, it took */
+void CO_drvTestTxClaim(void){
+    uint8_t m;
+
+    for(m = 0; m < CO_CAN_NO_TX_MAILBOXES; m++){
+        if(drvMbState[m] == DRV_MB_EMPTY && CO_drvTestCAN.sTxMailBox[m].TIR == 0){
+            drvMbState[m] = DRV_MB_CLAIMED;
+            drv_tsrWrite();
+            return;
+        }
+    }
+    drv_fail("tx_latency", "driver writes to a busy mailbox");
+}
+
+/* Driver sets requeue flag of the mailbox, before it writes abort request.
+ * Written value is shifted to the mailbox, so the returned value keeps the
+ * empty flags of TSR. */
+uint32_t CO_drvTestAbortRequest(void){
+    CO_CANmodule_t *CANmodule = CO->CANmodule[0];
+    uint8_t m;
+
+    for(m = 0; m < CO_CAN_NO_TX_MAILBOXES; m++){
+        if((CANmodule->txRequeueFlags & (1U << m)) != 0
+           && drvMbState[m] != DRV_MB_EMPTY && !drvMbAbort[m])
+        {
+            break;
+        }
+    }
+    if(m == CO_CAN_NO_TX_MAILBOXES){
+        drv_fail("tx_latency", "abort request without preempted mailbox");
+    }
+
+    drvTxCount.aborts++;
+    if(drvMbState[m] == DRV_MB_PENDING){
+        drvTxCount.abortPending++;
+        drv_mbComplete(m, 0);
+    }
+    else{
+        drvMbAbort[m] = true;
+    }
+    return CO_drvTestCAN.TSR >> (8U * m);
+}
+
+/* Writing 1 clears the flag, RQCP clears also TXOK, ALST and TERR */
+uint32_t CO_drvTestClearFlag(CAN_HandleTypeDef *hcan, uint32_t flag){
+    uint32_t bit = 1UL << (flag & CAN_FLAG_MASK);
+
+    switch(flag >> 8U){
+        case 5U:
+            if((bit & (CAN_TSR_RQCP0 | CAN_TSR_RQCP1 | CAN_TSR_RQCP2)) == 0){
+                drv_fail("tx_latency", "HAL clears unknown TSR flag");
+            }
+            drvTsrFlags &= ~(bit * 0x0FU);
+            drv_tsrWrite();
+            break;
+        case 2U: hcan->Instance->RF0R = bit; break;
+        case 4U: hcan->Instance->RF1R = bit; break;
+        case 1U: hcan->Instance->MSR = bit; break;
+        default: break;
+    }
+    return 0;
+}
+
+/* After the driver or HAL: requested transmissions, then transmit interrupt,
+ * while request completed flags are set */
+static void drv_txSync(void){
+    uint8_t m;
+
+    for(;;){
+        for(m = 0; m < CO_CAN_NO_TX_MAILBOXES; m++){
+            if(drvMbState[m] == DRV_MB_CLAIMED && (CO_drvTestCAN.sTxMailBox[m].TIR & CAN_TI0R_TXRQ) != 0){
+                drvMbState[m] = DRV_MB_PENDING;
+            }
+        }
+        drv_tsrWrite();
+        if((drvTsrFlags & (CAN_TSR_RQCP0 | CAN_TSR_RQCP1 | CAN_TSR_RQCP2)) == 0){
+            break;
+        }
+        HAL_CAN_IRQHandler(&drvCAN);
+    }
+}
+
+/* Application of the drive sends the buffer with next sequence number. New
+ * data may replace the message, which waits in the buffer or was preempted. */
+static void drv_dutSend(drv_dutTx_t *src){
+    CO_CANtx_t *buffer = src->buffer;
+    CO_CANmodule_t *CANmodule = CO->CANmodule[0];
+    uint32_t seq = ++src->seq;
+    uint8_t m;
+
+    if(buffer->bufferFull){
+        src->overwritten++;
+    }
+    else{
+        for(m = 0; m < CO_CAN_NO_TX_MAILBOXES; m++){
+            if(CANmodule->txMailbox[m] == buffer && (CANmodule->txRequeueFlags & (1U << m)) != 0){
+                src->overwritten++;
+            }
+        }
+    }
+
+    buffer->data[0] = (uint8_t)seq;
+    buffer->data[1] = (uint8_t)(seq >> 8);
+    buffer->data[2] = (uint8_t)(seq >> 16);
+    buffer->data[3] = (uint8_t)(seq >> 24);
+    src->sendTime[seq % DRV_TX_SEQ_RING] = drvNow;
+    CO_CANsend(CO->CANmodule[0], buffer);
+    drv_txSync();
+}
+
+/* Frame of the drive on the bus, sequence numbers must increase */
+static void drv_dutOnBus(uint16_t ident, uint32_t seq){
+    drv_dutTx_t *src = NULL;
+    uint32_t latency;
+    uint8_t k;
+
+    for(k = 0; k < DRV_DUT_NO; k++){
+        if(drvDut[k].buffer->ident == ((uint32_t)ident << 21)){
+            src = &drvDut[k];
+        }
+    }
+    if(src == NULL){
+        drv_fail("tx_latency", "unknown frame of the drive");
+    }
+    if(seq <= src->seqOnBus || seq > src->seq){
+        drv_fail("tx_latency", "frame sent twice or out of order");
+    }
+    if(src->seq - seq >= DRV_TX_SEQ_RING){
+        drv_fail("tx_latency", "frame older than DRV_TX_SEQ_RING");
+    }
+    if(src == &drvDut[DRV_DUT_SDO] && seq != src->seqOnBus + 1){
+        drv_fail("tx_latency", "SDO segment lost");
+    }
+
+    src->skipped += seq - src->seqOnBus - 1;
+    src->seqOnBus = seq;
+    latency = drvNow - src->sendTime[seq % DRV_TX_SEQ_RING];
+    if(latency > src->latencyMax){
+        src->latencyMax = latency;
+    }
+    src->latencySum += latency;
+    src->latencyCount++;
+
+    /* PLC requests next segment */
+    if(src == &drvDut[DRV_DUT_SDO]){
+        drvTxCount.sdoSegments++;
+        if(!drvDraining){
+            drvExt[DRV_EXT_SDO].pending = true;
+            drvExt[DRV_EXT_SDO].release = drvNow + DRV_TX_SDO_CLIENT_US;
+        }
+    }
+}
+
+/* Frame of other node on the bus, the drive and other nodes react */
+static void drv_extOnBus(uint16_t i){
+    uint16_t n;
+    uint8_t k;
+
+    if(i == DRV_EXT_SYNC){
+        for(n = 0; n < 2 * DRV_TX_NODES; n++){
+            drvExt[DRV_EXT_TPDO + n].pending = true;
+            drvExt[DRV_EXT_TPDO + n].release = drvNow + 10U * (n + 1U);
+        }
+        drvDut[DRV_DUT_TPDO].pending = true;
+        drvDut[DRV_DUT_TPDO].release = drvNow + drv_random(400);
+        for(k = DRV_DUT_TPDO + 1; k < DRV_DUT_SDO; k++){
+            drvDut[k].pending = true;
+            drvDut[k].release = drvNow + drv_random(300);
+        }
+    }
+    else if(i == DRV_EXT_SDO){
+        drvDut[DRV_DUT_SDO].pending = true;
+        drvDut[DRV_DUT_SDO].release = drvNow + DRV_TX_SDO_SERVER_US;
+    }
+}
+
+/* Transmission failed: retransmission, unless aborted or disabled */
+static void drv_mbFailed(uint8_t m, uint32_t flag){
+    if(drvMbAbort[m]){
+        drvTxCount.abortFailed++;
+        drv_mbComplete(m, flag);
+    }
+    else if(CO_drvTestCAN.MCR & CAN_MCR_NART){
+        drv_mbComplete(m, flag);
+    }
+    else{
+        drvMbState[m] = DRV_MB_PENDING;
+    }
+}
+
+static void drv_mbSent(uint8_t m){
+    CAN_TxMailBox_TypeDef *txMbox = &CO_drvTestCAN.sTxMailBox[m];
+
+    if(drvMbAbort[m]){
+        drvTxCount.abortTooLate++;
+    }
+    drv_dutOnBus((uint16_t)(txMbox->TIR >> CAN_TI0R_STID_Pos), txMbox->TDLR);
+    drv_mbComplete(m, CAN_TSR_TXOK0);
+}
+
+/* End of arbitration and end of frame */
+static void drv_busEvents(void){
+    if(!drvBus.busy){
+        return;
+    }
+    if(drvNow == drvBus.arbEnd && drvBus.mailbox >= 0 && !drvBus.dutWins){
+        drv_mbFailed((uint8_t)drvBus.mailbox, CAN_TSR_ALST0);
+        drvBus.mailbox = -1;
+    }
+    if(drvNow == drvBus.end){
+        drvBus.busy = false;
+        drvBus.idle = drvNow;
+        if(drvBus.dutWins){
+            if(drvBus.error) drv_mbFailed((uint8_t)drvBus.mailbox, CAN_TSR_TERR0);
+            else             drv_mbSent((uint8_t)drvBus.mailbox);
+        }
+        else if(!drvBus.error){
+            drvExt[drvBus.ext].pending = false;
+            drv_extOnBus((uint16_t)drvBus.ext);
+        }
+    }
+}
+
+/* Start of frame: lowest identifier wins, the drive takes part with its
+ * highest priority mailbox */
+static void drv_busArbitrate(void){
+    int16_t ext = -1;
+    int8_t mb = -1;
+    uint32_t bits;
+    uint16_t i;
+    uint8_t m;
+
+    if(drvBus.busy || drvNow < drvBus.idle){
+        return;
+    }
+    for(i = 0; i < sizeof(drvExt) / sizeof(drvExt[0]); i++){
+        if(drvExt[i].pending && drvExt[i].release <= drvNow
+           && (ext < 0 || drvExt[i].ident < drvExt[ext].ident))
+        {
+            ext = (int16_t)i;
+        }
+    }
+    for(m = 0; m < CO_CAN_NO_TX_MAILBOXES; m++){
+        if(drvMbState[m] == DRV_MB_PENDING
+           && (mb < 0 || CO_drvTestCAN.sTxMailBox[m].TIR < CO_drvTestCAN.sTxMailBox[mb].TIR))
+        {
+            mb = (int8_t)m;
+        }
+    }
+    if(ext < 0 && mb < 0){
+        return;
+    }
+
+    drvBus.busy = true;
+    drvBus.mailbox = mb;
+    drvBus.dutWins = (mb >= 0 && (ext < 0
+        || (CO_drvTestCAN.sTxMailBox[mb].TIR >> CAN_TI0R_STID_Pos) < drvExt[ext].ident)) ? true : false;
+    drvBus.ext = drvBus.dutWins ? -1 : ext;
+    if(mb >= 0){
+        drvMbState[mb] = DRV_MB_TX;
+    }
+
+    bits = drv_frameBits(drvBus.dutWins ? (uint8_t)(CO_drvTestCAN.sTxMailBox[mb].TDTR & 0x0FU) : drvExt[ext].DLC);
+    drvBus.error = (++drvTxCount.frames % DRV_TX_ERROR_EVERY) == 0 ? true : false;
+    if(drvBus.error){
+        bits = bits / 2U + DRV_TX_ERROR_BITS;
+        drvTxCount.errors++;
+    }
+    drvBus.arbEnd = drvNow + 12U * DRV_BIT_US;
+    drvBus.end = drvNow + bits * DRV_BIT_US;
+    drvTxCount.busBits += bits;
+}
+
+/* Application of the drive: PDOs after SYNC, SDO server, heartbeat */
+static void drv_appStep(void){
+    uint8_t k;
+
+    if(!drvDraining && drvNow % DRV_TX_SYNC_US == 0){
+        drvExt[DRV_EXT_SYNC].pending = true;
+        drvExt[DRV_EXT_SYNC].release = drvNow;
+    }
+    if(!drvDraining && drvNow % DRV_TX_HB_US == 0){
+        drvDut[DRV_DUT_HB].pending = true;
+        drvDut[DRV_DUT_HB].release = drvNow;
+    }
+
+    for(k = 0; k < DRV_DUT_NO; k++){
+        drv_dutTx_t *src = &drvDut[k];
+
+        if(src->pending && src->release <= drvNow){
+            /* SDO server waits for the free buffer, PDOs overwrite it */
+            if(k == DRV_DUT_SDO && src->buffer->bufferFull){
+                continue;
+            }
+            src->pending = false;
+            drv_dutSend(src);
+        }
+    }
+}
+
+/* Buffer of the drive with identifier, length and synchronous flag */
+static void drv_dutInit(uint8_t k, const char *name, CO_CANtx_t *buffer,
+        uint16_t ident, uint8_t DLC, bool_t syncFlag)
+{
+    CO_CANmodule_t *CANmodule = CO->CANmodule[0];
+
+    memset(&drvDut[k], 0, sizeof(drvDut[k]));
+    drvDut[k].name = name;
+    drvDut[k].buffer = CO_CANtxBufferInit(CANmodule, (uint16_t)(buffer - CANmodule->txArray),
+                                          ident, 0, DLC, syncFlag ? 1 : 0);
+}
+
+/* Ten seconds of the drive on a loaded bus, then queues must empty */
+static void drv_txRun(bool_t syncTpdo){
+    uint16_t n;
+    uint8_t k, m;
+
+    /* CANopen_CommunicationReset() of the firmware */
+    if(CO != NULL){
+        CO_delete((int32_t)(intptr_t)&drvCAN);
+    }
+    MX_CAN_Init(&drvCAN, 1000);
+    if(CO_init((int32_t)(intptr_t)&drvCAN, DRV_NODE_ID, 1000, NULL) != CO_ERROR_NO){
+        drv_fail("tx_latency", "CO_init() failed");
+    }
+    CO_CANsetNormalMode(CO->CANmodule[0]);
+
+    drv_dutInit(DRV_DUT_TPDO + 0, "TPDO1", CO->TPDO[0]->CANtxBuff, CO_CAN_ID_TPDO_1 + DRV_NODE_ID, 8, syncTpdo);
+    drv_dutInit(DRV_DUT_TPDO + 1, "TPDO2", CO->TPDO[1]->CANtxBuff, CO_CAN_ID_TPDO_2 + DRV_NODE_ID, 8, false);
+    drv_dutInit(DRV_DUT_TPDO + 2, "TPDO3", CO->TPDO[2]->CANtxBuff, CO_CAN_ID_TPDO_3 + DRV_NODE_ID, 8, true);
+    drv_dutInit(DRV_DUT_TPDO + 3, "TPDO4", CO->TPDO[3]->CANtxBuff, CO_CAN_ID_TPDO_4 + DRV_NODE_ID, 8, true);
+    drv_dutInit(DRV_DUT_SDO, "SDO", CO->SDO[0]->CANtxBuff, CO_CAN_ID_TSDO + DRV_NODE_ID, 8, false);
+    drv_dutInit(DRV_DUT_HB, "heartbeat", CO->NMT->HB_TXbuff, CO_CAN_ID_HEARTBEAT + DRV_NODE_ID, 1, false);
+
+    memset(drvExt, 0, sizeof(drvExt));
+    drvExt[DRV_EXT_SYNC].ident = CO_CAN_ID_SYNC;
+    drvExt[DRV_EXT_SDO].ident = CO_CAN_ID_RSDO + DRV_NODE_ID;
+    drvExt[DRV_EXT_SDO].DLC = 8;
+    drvExt[DRV_EXT_SDO].pending = true;     /* upload of a large object */
+    for(n = 0; n < DRV_TX_NODES; n++){
+        drvExt[DRV_EXT_TPDO + 2 * n].ident = (uint16_t)(CO_CAN_ID_TPDO_1 + 1 + n);
+        drvExt[DRV_EXT_TPDO + 2 * n].DLC = 8;
+        drvExt[DRV_EXT_TPDO + 2 * n + 1].ident = (uint16_t)(CO_CAN_ID_TPDO_2 + 1 + n);
+        drvExt[DRV_EXT_TPDO + 2 * n + 1].DLC = 8;
+    }
+
+    for(m = 0; m < CO_CAN_NO_TX_MAILBOXES; m++){
+        drvMbState[m] = DRV_MB_EMPTY;
+        drvMbAbort[m] = false;
+        CO_drvTestCAN.sTxMailBox[m].TIR = DRV_TIR_EMPTY;
+    }
+    drvTsrFlags = 0;
+    drv_tsrWrite();
+    memset(&drvBus, 0, sizeof(drvBus));
+    memset(&drvTxCount, 0, sizeof(drvTxCount));
+    drvLcg = 1;
+
+    for(drvNow = 0; drvNow < DRV_TX_RUN_US + DRV_TX_DRAIN_US; drvNow++){
+        drvDraining = (drvNow >= DRV_TX_RUN_US) ? true : false;
+        CO_drvTestDWT.CYCCNT = drvNow * DRV_CPU_MHZ;
+        drv_busEvents();
+        drv_txSync();
+        drv_appStep();
+        drv_busArbitrate();
+    }
+
+    for(k = 0; k < DRV_DUT_NO; k++){
+        if(drvDut[k].seqOnBus != drvDut[k].seq || drvDut[k].skipped > drvDut[k].overwritten){
+            static char what[64];
+            snprintf(what, sizeof(what), "%s lost, %u sent, %u on the bus", drvDut[k].name,
+                     (unsigned)(drvDut[k].seq - drvDut[k].overwritten),
+                     (unsigned)(drvDut[k].seqOnBus - drvDut[k].skipped));
+            drv_fail("tx_latency", what);
+        }
+    }
+    if(CO->CANmodule[0]->CANtxCount != 0 || CO->CANmodule[0]->txRequeueFlags != 0){
+        drv_fail("tx_latency", "driver queue not empty at end");
+    }
+}
+
+static void drv_testTxLatency(void){
+    drv_dutTx_t sync, event;
+    drv_txCount_t syncCount;
+    uint32_t syncQueueMax, eventQueueMax;
+
+    drv_txRun(false);
+    event = drvDut[DRV_DUT_TPDO];
+    eventQueueMax = event.buffer->queueDelayMax / DRV_CPU_MHZ;
+
+    drv_txRun(true);
+    sync = drvDut[DRV_DUT_TPDO];
+    syncQueueMax = sync.buffer->queueDelayMax / DRV_CPU_MHZ;
+    syncCount = drvTxCount;
+    if(syncCount.abortFailed == 0){
+        drv_fail("tx_latency", "no preempted frame failed on the bus, error callback not tested");
+    }
+    if(sync.latencyMax >= event.latencyMax){
+        drv_fail("tx_latency", "preemption must reduce worst case latency");
+    }
+
+    printf("tx_latency: 1000 kbit/s, %u s, SYNC %u us, %u drives and PLC, bus load %.1f %%,"
+           " error frames %u, SDO segments %u\n",
+           (unsigned)(DRV_TX_RUN_US / 1000000), (unsigned)DRV_TX_SYNC_US, DRV_TX_NODES + 1,
+           (double)syncCount.busBits * DRV_BIT_US * 100.0 / (DRV_TX_RUN_US + DRV_TX_DRAIN_US),
+           (unsigned)syncCount.errors, (unsigned)syncCount.sdoSegments);
+    printf("  TPDO1 event driven     latency max %4u us, mean %5.1f us, to mailbox max %4u us\n",
+           (unsigned)event.latencyMax, (double)event.latencySum / event.latencyCount,
+           (unsigned)eventQueueMax);
+    printf("  TPDO1 synchronous      latency max %4u us, mean %5.1f us, to mailbox max %4u us\n",
+           (unsigned)sync.latencyMax, (double)sync.latencySum / sync.latencyCount,
+           (unsigned)syncQueueMax);
+    printf("  preempted frames       %u (before arbitration %u, arbitration lost or error %u,"
+           " sent anyway %u), lost 0\n",
+           (unsigned)syncCount.aborts, (unsigned)syncCount.abortPending,
+           (unsigned)syncCount.abortFailed, (unsigned)syncCount.abortTooLate);
+}
+
+
+/* Main ***********************************************************************/
+typedef struct{
+    const char         *name;
+    void              (*run)(void);
+}drv_test_t;
+
+static const drv_test_t tests[] = {
+    {"rx_filters",      drv_testRxFilters},
+    {"tx_latency",      drv_testTxLatency}
+};
+
+int main(int argc, char *argv[]){
+    const char *filter = NULL;
+    unsigned i;
+    int c;
+
+    while((c = getopt(argc, argv, "f:")) != -1){
+        switch(c){
+            case 'f': filter = optarg; break;
+            default:
+                fprintf(stderr, "Usage: %s [-f name filter]\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    for(i = 0; i < sizeof(tests) / sizeof(tests[0]); i++){
+        if(filter != NULL && strstr(tests[i].name, filter) == NULL) continue;
+        tests[i].run();
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,96 @@
+/*
+ * Host build of stack/STM32F3/CO_driver.c, bsp_can.c and the HAL CAN driver,
+ * included before every source of drvtest/CO_drvTest.c with "-include".
+ *
+ * @file        CO_drvTestShim.h
+ * @author      Janez Paternoster
+ * @copyright   2015 Janez Paternoster
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef CO_DRV_TEST_SHIM_H
+#define CO_DRV_TEST_SHIM_H
+
+
+/* Driver header is included first, its guard keeps the redefinitions below */
+#include "CO_driver.h"
+
+
+/* Critical sections, interrupts of the model run between driver calls */
+#undef CO_LOCK_CAN_SEND
+#undef CO_UNLOCK_CAN_SEND
+#undef CO_LOCK_EMCY
+#undef CO_UNLOCK_EMCY
+#undef CO_LOCK_OD
+#undef CO_UNLOCK_OD
+#define CO_LOCK_CAN_SEND()
+#define CO_UNLOCK_CAN_SEND()
+#define CO_LOCK_EMCY()
+#define CO_UNLOCK_EMCY()
+#define CO_LOCK_OD()
+#define CO_UNLOCK_OD()
+
+
+/* Core debug registers of the cycle counter, CYCCNT is bus time of the model */
+extern DWT_Type             CO_drvTestDWT;
+extern CoreDebug_Type       CO_drvTestCoreDebug;
+#undef DWT
+#undef CoreDebug
+#define DWT                 (&CO_drvTestDWT)
+#define CoreDebug           (&CO_drvTestCoreDebug)
+
+
+/* Filter initialization mode is entered and left with this bit, count both */
+extern uint32_t             CO_drvTestFilterInit;
+#undef CAN_FMR_FINIT
+#define CAN_FMR_FINIT       (CO_drvTestFilterInit++, CAN_FMR_FINIT_Msk)
+
+
+/* CAN peripheral of MX_CAN_Init() */
+extern CAN_TypeDef          CO_drvTestCAN;
+#undef CAN
+#define CAN                 (&CO_drvTestCAN)
+
+
+/* Writes to TSR, which the model must see at once. Abort request is written
+ * without other bits, HAL clears request completed flags by writing 1. */
+uint32_t CO_drvTestAbortRequest(void);
+uint32_t CO_drvTestClearFlag(CAN_HandleTypeDef *hcan, uint32_t flag);
+#undef CAN_TSR_ABRQ0
+#define CAN_TSR_ABRQ0       CO_drvTestAbortRequest()
+#undef __HAL_CAN_CLEAR_FLAG
+#define __HAL_CAN_CLEAR_FLAG(__HANDLE__, __FLAG__) CO_drvTestClearFlag((__HANDLE__), (__FLAG__))
+
+
+/* Driver took an empty mailbox, its identifier register is written next */
+void CO_drvTestTxClaim(void);
+#undef CAN_RTR_DATA
+#define CAN_RTR_DATA        (CO_drvTestTxClaim(), 0x00000000U)
+
+
+/* __RBIT() is an instruction of the core, result for 0 is 32 as __CLZ() */
+static inline uint32_t CO_drvTestPositionVal(uint32_t value){
+    return (uint32_t)__builtin_ctzll((uint64_t)value | (1ULL << 32));
+}
+#undef POSITION_VAL
+#define POSITION_VAL(VAL)   CO_drvTestPositionVal(VAL)
+
+
+#endif
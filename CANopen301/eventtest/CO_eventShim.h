@@ -0,0 +1,53 @@
+/*
+ * Core of the event loop simulation, included before app_event.c and
+ * ui_task.c of the firmware with "-include".
+ *
+ * @file        CO_eventShim.h
+ * @author      Janez Paternoster
+ * @copyright   2015 Janez Paternoster
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef CO_EVENT_SHIM_H
+#define CO_EVENT_SHIM_H
+
+
+/* HAL and core headers are included first, their guards keep the
+ * redefinitions below */
+#include "stm32f3xx_hal.h"
+
+
+/* Interrupt mask, sleep and exclusive access of the core, see
+ * eventtest/CO_eventTest.c. Interrupts, which are due, run when they are
+ * unmasked and while the main loop spends cycles. */
+void CO_eventSimDisableIrq(void);
+void CO_eventSimEnableIrq(void);
+void CO_eventSimWFI(void);
+uint32_t CO_eventSimLDREX(volatile uint32_t *addr);
+uint32_t CO_eventSimSTREX(uint32_t value, volatile uint32_t *addr);
+
+#define __disable_irq()             CO_eventSimDisableIrq()
+#define __enable_irq()              CO_eventSimEnableIrq()
+#define __WFI()                     CO_eventSimWFI()
+#define __LDREXW(addr)              CO_eventSimLDREX(addr)
+#define __STREXW(value, addr)       CO_eventSimSTREX(value, addr)
+
+
+#endif
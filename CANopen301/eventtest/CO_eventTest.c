@@ -0,0 +1,576 @@
+/*
+ * Host simulation of the event driven main loop of the firmware with its
+ * interrupt sources, idle time and event latency.
+ *
+ * @file        CO_eventTest.c
+ * @author      Janez Paternoster
+ * @copyright   2015 Janez Paternoster
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/* app_event.c and the serial timeout of ui_task.c (UI_Scheduler) are
+ * compiled unchanged against eventtest/CO_eventShim.h. Time is counted in
+ * core cycles. The main loop of main.c is modelled by the cycles of its
+ * calls, EV_xxx_CYCLES below, interrupts take the cycles of their handler
+ * when they are due and not masked:
+ *  - FOC (ADC1) at PWM_FREQUENCY / REGULATION_EXECUTION_RATE, posts nothing,
+ *  - SysTick at SYS_TICK_FREQUENCY: safety task and UI_Scheduler on every
+ *    tick, medium frequency task on every MF_TASK_OCCURENCE_TICKS + 1 tick,
+ *    CO_timer1ms and APP_EVENT_TICK on every second tick, one motor fault,
+ *  - CAN rx at a random interval around the mean of the test,
+ *  - USART1 at 9600 baud: a Modbus request of 8 bytes every 100 ms, RXNE
+ *    restarts the frame timeout, the reply is sent byte by byte on TXE.
+ * Exclusive access of APP_EventPost() fails, if an interrupt runs between
+ * LDREX and STREX, as on the core. APP_EventWait() masks interrupts for
+ * EV_MASKED_CYCLES, an interrupt, which gets due there, keeps WFI from
+ * sleeping. Calls of APP_EventPost() are wrapped to record the post time.
+ *
+ * The cycles of the code, which is not run, are assumptions for 72 MHz and
+ * code in RAM, about half of the budgets of Utilities/stack_wcet.py. The
+ * numbers scale with them, the random sequence is fixed, so the results do
+ * not depend on the host.
+ *
+ * polling: main loop before the event loop, it calls the CANopen timer task
+ *     and CO_process on every pass and never sleeps.
+ * events: main.c, sleeps in WFI. All CAN messages and Modbus frames are
+ *     taken, no timer tick is merged, CAN latency is below 1 ms.
+ * events_busy_bus: the same with 8000 CAN messages per second. */
+
+
+#include "app_event.h"
+#include "UITask.h"
+#include "drive_parameters.h"
+#include "parameters_conversion.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+#define EV_CORE_HZ              72000000U
+#define EV_SIM_S                10U
+#define EV_FOC_PERIOD           (EV_CORE_HZ / (PWM_FREQUENCY / REGULATION_EXECUTION_RATE))
+#define EV_SYSTICK_PERIOD       (EV_CORE_HZ / SYS_TICK_FREQUENCY)
+#define EV_MF_TICKS             (MF_TASK_OCCURENCE_TICKS + 1U)
+#define EV_MODBUS_BYTE          (EV_CORE_HZ / 960U)     /* 9600 baud, 8N1 */
+#define EV_MODBUS_PERIOD        (EV_CORE_HZ / 10U)      /* requests of the master */
+#define EV_MODBUS_REQUEST       8U
+#define EV_MODBUS_REPLY         25U
+#define EV_FAULT_AT             (EV_CORE_HZ * 5ULL)
+
+/* Interrupts */
+#define EV_FOC_CYCLES           2500U
+#define EV_SAFETY_CYCLES        600U    /* safety task, UI_Scheduler */
+#define EV_MF_CYCLES            2000U   /* medium frequency task */
+#define EV_CAN_RX_CYCLES        450U    /* HAL, CO_CANinterrupt_Rx */
+#define EV_USART_CYCLES         150U
+/* Main loop */
+#define EV_WAIT_CYCLES          20U     /* APP_EventWait, without the core */
+#define EV_MASKED_CYCLES        6U
+#define EV_EXCLUSIVE_CYCLES     2U
+#define EV_TMR_TASK_CYCLES      900U    /* CO_tmr_Task_thread: SYNC, RPDO, TPDO */
+#define EV_PROCESS_CYCLES       1400U   /* CO_process */
+#define EV_MONITOR_CYCLES       4000U   /* worst CMON_Process step, SMON_Process step */
+#define EV_MODBUS_CYCLES        4000U   /* RtuModbusParse, U1FCP_Send */
+#define EV_FLASH_CYCLES         120U    /* CO_FwUpdateProcess, CO_FlashProcess */
+#define EV_FAULT_CYCLES         80U     /* CANopen_MotorFault */
+#define EV_POLL_CYCLES          20U     /* timeout check of the polling loop */
+
+#define EV_CAN_RING             1024U
+#define EV_EVENTS               5U
+
+
+/* Latency in cycles */
+typedef struct{
+    uint64_t            sum;
+    uint64_t            max;
+    uint32_t            count;
+}ev_latency_t;
+
+/* Interrupt source, sources earlier in evSource[] win when due together */
+typedef struct{
+    uint64_t            due;
+    uint32_t            cycles;
+    void              (*handler)(void);
+}ev_source_t;
+
+enum{EV_FOC, EV_SYSTICK, EV_CAN, EV_USART, EV_SOURCES};
+
+static ev_source_t          evSource[EV_SOURCES];
+static uint64_t             evNow;
+static uint64_t             evEnd;
+static int                  evMasked;
+static int                  evInIsr;
+static int                  evExclusive;
+static uint64_t             evState;
+
+static uint64_t             evIdle;
+static uint64_t             evIsrCycles;
+static uint32_t             evStrexFailed;
+static uint32_t             evPendingAtWfi;
+static uint32_t             evWakeups;
+static uint32_t             evEmptyWakeups;
+
+/* Interrupt side */
+static uint32_t             evTicks;
+static uint16_t             evTimer1ms;
+static uint32_t             evCanMean;
+static uint64_t             evCanArrival[EV_CAN_RING];
+static uint32_t             evCanIn, evCanOut;
+static uint32_t             evModbusRx;
+static uint32_t             evModbusTx;
+static uint64_t             evModbusNext;
+static uint32_t             evModbusRequests;
+static int                  evFaultPosted;
+
+/* Events posted and not taken, post time of the first one */
+static uint64_t             evPostTime[EV_EVENTS];
+static uint32_t             evPending;
+static uint32_t             evMerged[EV_EVENTS];
+
+static ev_latency_t         evCanLatency;
+static ev_latency_t         evTickLatency;
+static ev_latency_t         evModbusLatency;
+static ev_latency_t         evFaultLatency;
+static uint32_t             evTmrCalls;
+
+
+/* Helpers ********************************************************************/
+static void ev_fail(const char *name, const char *what){
+    fprintf(stderr, "CO_eventTest: %s: %s\n", name, what);
+    exit(EXIT_FAILURE);
+}
+
+static uint32_t ev_random(void){
+    evState = evState * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (uint32_t)(evState >> 33);
+}
+
+static void ev_latency(ev_latency_t *latency, uint64_t since){
+    uint64_t cycles = evNow - since;
+
+    latency->sum += cycles;
+    latency->count++;
+    if(cycles > latency->max){
+        latency->max = cycles;
+    }
+}
+
+static double ev_us(uint64_t cycles){
+    return (double)cycles * 1e6 / EV_CORE_HZ;
+}
+
+static int ev_bit(uint32_t event){
+    return __builtin_ctz(event);
+}
+
+
+/* Core ***********************************************************************/
+static ev_source_t *ev_due(void){
+    ev_source_t *first = NULL;
+    int i;
+
+    for(i = 0; i < EV_SOURCES; i++){
+        if(evSource[i].due <= evNow && (first == NULL || evSource[i].due < first->due)){
+            first = &evSource[i];
+        }
+    }
+    return first;
+}
+
+static uint64_t ev_nextDue(void){
+    uint64_t next = UINT64_MAX;
+    int i;
+
+    for(i = 0; i < EV_SOURCES; i++){
+        if(evSource[i].due < next){
+            next = evSource[i].due;
+        }
+    }
+    return next;
+}
+
+/* Run all interrupts, which are due, one after the other */
+static void ev_interrupts(void){
+    ev_source_t *source;
+
+    if(evMasked || evInIsr){
+        return;
+    }
+    while((source = ev_due()) != NULL){
+        evInIsr = 1;
+        evExclusive = 0;
+        evNow += source->cycles;
+        evIsrCycles += source->cycles;
+        source->handler();
+        evInIsr = 0;
+    }
+}
+
+/* Main loop spends cycles, interrupts preempt it */
+static void ev_busy(uint32_t cycles){
+    uint64_t left = cycles;
+
+    if(evInIsr){
+        return;
+    }
+    while(left > 0U){
+        uint64_t next;
+
+        ev_interrupts();
+        next = evMasked ? UINT64_MAX : ev_nextDue();
+        if(next < evNow + left){
+            left -= next - evNow;
+            evNow = next;
+        }
+        else{
+            evNow += left;
+            left = 0;
+        }
+    }
+    ev_interrupts();
+}
+
+void CO_eventSimDisableIrq(void){
+    evMasked = 1;
+    ev_busy(EV_MASKED_CYCLES);
+}
+
+void CO_eventSimEnableIrq(void){
+    evMasked = 0;
+    ev_interrupts();
+}
+
+void CO_eventSimWFI(void){
+    uint64_t next = ev_nextDue();
+
+    if(next <= evNow){
+        evPendingAtWfi++;
+        return;
+    }
+    evIdle += next - evNow;
+    evNow = next;
+}
+
+uint32_t CO_eventSimLDREX(volatile uint32_t *addr){
+    uint32_t value = *addr;
+
+    evExclusive = 1;
+    ev_busy(EV_EXCLUSIVE_CYCLES);
+    return value;
+}
+
+uint32_t CO_eventSimSTREX(uint32_t value, volatile uint32_t *addr){
+    if(!evExclusive){
+        evStrexFailed++;
+        return 1;
+    }
+    evExclusive = 0;
+    *addr = value;
+    return 0;
+}
+
+/* Post time of every event */
+void __real_APP_EventPost(uint32_t wEvents);
+void __wrap_APP_EventPost(uint32_t wEvents){
+    int bit = ev_bit(wEvents);
+
+    if(evPending & wEvents){
+        evMerged[bit]++;
+    }
+    else{
+        evPending |= wEvents;
+        evPostTime[bit] = evNow;
+    }
+    __real_APP_EventPost(wEvents);
+}
+
+/* Events taken by the main loop, post times of them */
+static void ev_taken(uint32_t events, uint64_t *postTime){
+    uint32_t i;
+
+    for(i = 0; i < EV_EVENTS; i++){
+        if(events & (1U << i)){
+            postTime[i] = evPostTime[i];
+        }
+    }
+    evPending &= ~events;
+}
+
+
+/* Interrupts *****************************************************************/
+static void ev_foc(void){
+    evSource[EV_FOC].due += EV_FOC_PERIOD;
+}
+
+static void ev_sysTick(void){
+    evSource[EV_SYSTICK].due += EV_SYSTICK_PERIOD;
+    evTicks++;
+    if((evTicks % EV_MF_TICKS) == 0U){
+        evNow += EV_MF_CYCLES;
+        evIsrCycles += EV_MF_CYCLES;
+    }
+    if(!evFaultPosted && evNow >= EV_FAULT_AT){
+        evFaultPosted = 1;
+        APP_EventPost(APP_EVENT_MOTOR_FAULT);
+    }
+    UI_Scheduler();
+    if((evTicks % (SYS_TICK_FREQUENCY / 1000U)) == 0U){
+        evTimer1ms++;
+        APP_EventPost(APP_EVENT_TICK);
+    }
+}
+
+static void ev_canRx(void){
+    uint32_t interval = evCanMean / 5U + (uint32_t)(((uint64_t)ev_random() * evCanMean * 8U / 5U) >> 31);
+
+    if((evCanIn - evCanOut) >= EV_CAN_RING){
+        ev_fail("can", "rx ring overflow");
+    }
+    evCanArrival[evCanIn++ % EV_CAN_RING] = evNow;
+    evSource[EV_CAN].due += interval;
+    APP_EventPost(APP_EVENT_CAN_RX);
+}
+
+static void ev_usart(void){
+    ev_source_t *usart = &evSource[EV_USART];
+
+    if(evModbusRx == 0U && evModbusTx == 0U){
+        /* first byte of the next request */
+        evModbusRequests++;
+        evModbusRx = EV_MODBUS_REQUEST;
+        evModbusNext = usart->due + EV_MODBUS_PERIOD;
+    }
+    if(evModbusRx > 0U){
+        /* RXNE, U1FCP_RX_IRQ_Handler returns 1, the master waits for the
+         * reply until the next request */
+        evModbusRx--;
+        UI_Serial1CommunicationTimeOutStart();
+        usart->due = (evModbusRx > 0U) ? usart->due + EV_MODBUS_BYTE : evModbusNext;
+    }
+    else{
+        /* TXE */
+        evModbusTx--;
+        usart->due = (evModbusTx > 0U) ? usart->due + EV_MODBUS_BYTE : evModbusNext;
+    }
+}
+
+static void ev_modbusReply(void){
+    evModbusTx = EV_MODBUS_REPLY;
+    evSource[EV_USART].due = evNow + EV_MODBUS_BYTE;
+}
+
+
+/* Main loops *****************************************************************/
+static void ev_canProcess(void){
+    while(evCanOut != evCanIn){
+        ev_latency(&evCanLatency, evCanArrival[evCanOut++ % EV_CAN_RING]);
+    }
+    ev_busy(EV_PROCESS_CYCLES);
+}
+
+/* Main loop before the event loop */
+static void ev_polling(void){
+    while(evNow < evEnd){
+        ev_busy(EV_POLL_CYCLES);
+        if(UI_Serial1CommunicationTimeOutHasElapsed()){
+            uint64_t postTime[EV_EVENTS];
+
+            ev_taken(APP_EVENT_MODBUS_FRAME, postTime);
+            ev_latency(&evModbusLatency, postTime[ev_bit(APP_EVENT_MODBUS_FRAME)]);
+            ev_busy(EV_MODBUS_CYCLES);
+            ev_modbusReply();
+        }
+        evTmrCalls++;
+        ev_busy(EV_TMR_TASK_CYCLES);
+        ev_canProcess();
+        ev_busy(EV_FLASH_CYCLES);
+    }
+    evPending &= ~(APP_EVENT_TICK | APP_EVENT_CAN_RX);
+}
+
+/* Main loop of main.c */
+static void ev_events(void){
+    while(evNow < evEnd){
+        uint64_t postTime[EV_EVENTS];
+        uint32_t events;
+
+        ev_busy(EV_WAIT_CYCLES);
+        events = APP_EventWait();
+        evWakeups++;
+        if(events == 0U){
+            evEmptyWakeups++;
+            continue;
+        }
+        ev_taken(events, postTime);
+
+        if((events & APP_EVENT_MODBUS_FRAME) && UI_Serial1CommunicationTimeOutHasElapsed()){
+            ev_latency(&evModbusLatency, postTime[ev_bit(APP_EVENT_MODBUS_FRAME)]);
+            ev_busy(EV_MODBUS_CYCLES);
+            ev_modbusReply();
+        }
+        if(events & (APP_EVENT_TICK | APP_EVENT_CAN_RX | APP_EVENT_MOTOR_FAULT | APP_EVENT_BACKGROUND)){
+            if(events & APP_EVENT_TICK){
+                ev_latency(&evTickLatency, postTime[ev_bit(APP_EVENT_TICK)]);
+                evTmrCalls++;
+                ev_busy(EV_TMR_TASK_CYCLES);
+                ev_busy(EV_MONITOR_CYCLES);
+            }
+            ev_canProcess();
+            if(events & APP_EVENT_MOTOR_FAULT){
+                ev_latency(&evFaultLatency, postTime[ev_bit(APP_EVENT_MOTOR_FAULT)]);
+            }
+            ev_busy(EV_FAULT_CYCLES);
+            ev_busy(EV_FLASH_CYCLES);
+        }
+    }
+}
+
+
+/* Tests **********************************************************************/
+static void ev_run(const char *name, void (*loop)(void), uint32_t canPerSecond){
+    double total;
+
+    /* events and serial timeout of the test before */
+    memset(evSource, 0, sizeof(evSource));
+    evInIsr = 1;
+    (void)APP_EventWait();
+    UI_Serial1CommunicationTimeOutStop();
+    evNow = evIdle = evIsrCycles = 0;
+    evEnd = (uint64_t)EV_CORE_HZ * EV_SIM_S;
+    evMasked = evInIsr = evExclusive = 0;
+    evState = 0x5EED0003ULL;
+    evStrexFailed = evPendingAtWfi = evWakeups = evEmptyWakeups = 0;
+    evTicks = 0;
+    evTimer1ms = 0;
+    evCanMean = EV_CORE_HZ / canPerSecond;
+    evCanIn = evCanOut = 0;
+    evModbusRx = evModbusTx = 0;
+    evModbusNext = 0;
+    evModbusRequests = 0;
+    evFaultPosted = 0;
+    evPending = 0;
+    memset(evMerged, 0, sizeof(evMerged));
+    memset(&evCanLatency, 0, sizeof(evCanLatency));
+    memset(&evTickLatency, 0, sizeof(evTickLatency));
+    memset(&evModbusLatency, 0, sizeof(evModbusLatency));
+    memset(&evFaultLatency, 0, sizeof(evFaultLatency));
+    evTmrCalls = 0;
+
+    evSource[EV_FOC] = (ev_source_t){EV_FOC_PERIOD / 2U, EV_FOC_CYCLES, ev_foc};
+    evSource[EV_SYSTICK] = (ev_source_t){EV_SYSTICK_PERIOD, EV_SAFETY_CYCLES, ev_sysTick};
+    evSource[EV_CAN] = (ev_source_t){evCanMean, EV_CAN_RX_CYCLES, ev_canRx};
+    evSource[EV_USART] = (ev_source_t){EV_MODBUS_PERIOD, EV_USART_CYCLES, ev_usart};
+
+    loop();
+
+    total = (double)evNow;
+    printf("%s: %u s, FOC %u Hz, SysTick %u Hz, CAN %u messages/s, Modbus %u requests/s at 9600 baud\n",
+           name, (unsigned)EV_SIM_S, (unsigned)(EV_CORE_HZ / EV_FOC_PERIOD), (unsigned)SYS_TICK_FREQUENCY,
+           (unsigned)canPerSecond, (unsigned)(EV_CORE_HZ / EV_MODBUS_PERIOD));
+    printf("  CPU                    interrupts %.1f %%, main loop %.1f %%, idle in WFI %.1f %%\n",
+           100.0 * evIsrCycles / total, 100.0 * (total - evIsrCycles - evIdle) / total, 100.0 * evIdle / total);
+    if(evWakeups != 0U){
+        printf("  wake-ups               %u (no event %u), STREX retried %u, interrupt pending at WFI %u\n",
+               (unsigned)evWakeups, (unsigned)evEmptyWakeups, (unsigned)evStrexFailed, (unsigned)evPendingAtWfi);
+    }
+    printf("  CAN rx to CO_process   mean %6.1f us, max %6.1f us, %u messages\n",
+           ev_us(evCanLatency.sum / (evCanLatency.count ? evCanLatency.count : 1U)), ev_us(evCanLatency.max),
+           (unsigned)evCanLatency.count);
+    if(evTickLatency.count != 0U){
+        printf("  tick to timer task     mean %6.1f us, max %6.1f us, %u ticks, merged %u\n",
+               ev_us(evTickLatency.sum / evTickLatency.count), ev_us(evTickLatency.max),
+               (unsigned)evTickLatency.count, (unsigned)evMerged[ev_bit(APP_EVENT_TICK)]);
+    }
+    printf("  Modbus frame to parse  mean %6.1f us, max %6.1f us, %u frames\n",
+           ev_us(evModbusLatency.sum / (evModbusLatency.count ? evModbusLatency.count : 1U)),
+           ev_us(evModbusLatency.max), (unsigned)evModbusLatency.count);
+    if(evFaultLatency.count != 0U){
+        printf("  fault to CANopen       %6.1f us\n", ev_us(evFaultLatency.max));
+    }
+    printf("  CANopen timer task     %u calls for %u ms\n", (unsigned)evTmrCalls, (unsigned)evTimer1ms);
+
+    /* requests, which are not complete at the end, are not parsed */
+    if(evModbusLatency.count + 1U < evModbusRequests){
+        ev_fail(name, "Modbus frame not parsed");
+    }
+    if(loop == ev_events){
+        if(evCanOut + 1U < evCanIn){
+            ev_fail(name, "CAN message not processed");
+        }
+        if(evMerged[ev_bit(APP_EVENT_TICK)] != 0U || evTmrCalls + 1U < evTimer1ms){
+            ev_fail(name, "timer tick merged");
+        }
+        if(evFaultLatency.count != 1U){
+            ev_fail(name, "motor fault not taken");
+        }
+        if(evCanLatency.max >= EV_CORE_HZ / 1000U){
+            ev_fail(name, "CAN latency 1 ms or more");
+        }
+    }
+}
+
+static void ev_testPolling(void){
+    ev_run("polling", ev_polling, 2000U);
+}
+
+static void ev_testEvents(void){
+    ev_run("events", ev_events, 2000U);
+}
+
+static void ev_testEventsBusyBus(void){
+    ev_run("events_busy_bus", ev_events, 8000U);
+}
+
+
+/* Main ***********************************************************************/
+typedef struct{
+    const char         *name;
+    void              (*run)(void);
+}ev_test_t;
+
+static const ev_test_t tests[] = {
+    {"polling",         ev_testPolling},
+    {"events",          ev_testEvents},
+    {"events_busy_bus", ev_testEventsBusyBus}
+};
+
+int main(int argc, char *argv[]){
+    const char *filter = NULL;
+    unsigned i;
+    int c;
+
+    while((c = getopt(argc, argv, "f:")) != -1){
+        switch(c){
+            case 'f': filter = optarg; break;
+            default:
+                fprintf(stderr, "Usage: %s [-f name filter]\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    for(i = 0; i < sizeof(tests) / sizeof(tests[0]); i++){
+        if(filter != NULL && strstr(tests[i].name, filter) == NULL) continue;
+        tests[i].run();
+    }
+
+    return EXIT_SUCCESS;
+}
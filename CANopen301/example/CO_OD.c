@@ -67,6 +67,9 @@ struct sCO_OD_RAM CO_OD_RAM = {
 /*1003*/ {0x0L, 0x0L, 0x0L, 0x0L, 0x0L, 0x0L, 0x0L, 0x0L},
 /*1010*/ {0x3L},
 /*1011*/ {0x1L},
+/*1F51*/ {0x1},
+/*1F56*/ {0x0L},
+/*1F57*/ {0x0L},
 /*200E*/ 	0x3,																											/*new*/
 /*200F*/ 	0x1,
 /*2100*/ {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},
@@ -78,6 +81,9 @@ struct sCO_OD_RAM CO_OD_RAM = {
 /*2110*/ {0L, 0L, 0L, 0L, 0L, 0L, 0L, 0L, 0L, 0L, 0L, 0L, 0L, 0L, 0L, 0L},
 /*2120*/ {0x5, 0x1234567890ABCDEFLL, 0x234567890ABCDEF1LL, 12.345, 456.789, 0},
 /*2130*/ {0x3, {'-', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' '}, 0, 0x0L},
+/*2140*/ {0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0},
+/*2150*/ {0x0, 0x0},
+/*2151*/ {0x0, 0x0},
 /*6000*/ {0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x18},
 /*6200*/ {0x08, 0x07, 0x06, 0x05, 0x04, 0x03, 0x02, 0x01},
 /*6040*/ 0x15,			/*new*/
@@ -92,8 +98,6 @@ struct sCO_OD_RAM CO_OD_RAM = {
 /*6049  new */ 0x0L,
 /*604a  new */ 0x0L,
 /*604b  new */ 0x0L,
-/*6050*/ HALL_PHASE_SHIFT_N,		/* 	HALL_PHASE_SHIFT_N */
-/*6051*/ HALL_PHASE_SHIFT_P,		/*	HALL_PHASE_SHIFT_P	*/
 /*6060*/ 0x02,		/*NEW*/
 /*6099*/ 0x1388,	/*NEW*/
 /*6401*/ {0x123, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
@@ -122,6 +126,8 @@ struct sCO_OD_EEPROM CO_OD_EEPROM = {
 /*2309*/ 0x64L,			
 /*230A*/ 0x01L,
 /*230B*/ 0x0L,
+/*6050*/ HALL_PHASE_SHIFT_N,		/* 	HALL_PHASE_SHIFT_N */
+/*6051*/ HALL_PHASE_SHIFT_P,		/*	HALL_PHASE_SHIFT_P	*/
 
            CO_OD_FIRST_LAST_WORD,
 };
@@ -376,6 +382,10 @@ const CO_OD_entry_t CO_OD[CO_OD_NoOfElements] = {
 {0x1A01, 0x08, 0x00,  0, (void*)&OD_record1A01},
 {0x1A02, 0x08, 0x00,  0, (void*)&OD_record1A02},
 {0x1A03, 0x08, 0x00,  0, (void*)&OD_record1A03},
+{0x1F50, 0x01, 0x0A,  0, (void*)0},
+{0x1F51, 0x01, 0x0E,  1, (void*)&CO_OD_RAM.programControl[0]},
+{0x1F56, 0x01, 0x86,  4, (void*)&CO_OD_RAM.programSoftwareIdentification[0]},
+{0x1F57, 0x01, 0x86,  4, (void*)&CO_OD_RAM.flashStatusIdentification[0]},
 {0x1F80, 0x00, 0x8D,  4, (void*)&CO_OD_ROM.NMTStartup},
 {0x200E, 0x00, 0x36,  2, (void*)&CO_OD_RAM.BusSupplyVoltage},								/*new add BusSupplyVoltage*/
 {0x200F, 0x00, 0x36,  2, (void*)&CO_OD_RAM.MotorDriverTemperatur},					/*new add MotorDriverTemperatur*/
@@ -393,6 +403,9 @@ const CO_OD_entry_t CO_OD[CO_OD_NoOfElements] = {
 {0x2112, 0x10, 0xFF,  4, (void*)&CO_OD_EEPROM.variableNVInt32[0]},
 {0x2120, 0x05, 0x00,  0, (void*)&OD_record2120},
 {0x2130, 0x03, 0x00,  0, (void*)&OD_record2130},
+{0x2140, 0x07, 0xA6,  2, (void*)&CO_OD_RAM.conditionMonitor[0]},
+{0x2150, 0x02, 0xA6,  2, (void*)&CO_OD_RAM.stackMonitor[0]},
+{0x2151, 0x02, 0xA6,  2, (void*)&CO_OD_RAM.focCycles[0]},
 
 {0x2300, 0x00, 0x8E,  2, (void*)&CO_OD_EEPROM.SPEED_REF},			/*new add 19-08-22,start*/
 {0x2301, 0x00, 0x8E,  2, (void*)&CO_OD_EEPROM.SPEED_KP},
@@ -422,8 +435,8 @@ const CO_OD_entry_t CO_OD[CO_OD_NoOfElements] = {
 {0x604A, 0x00, 0x3E,  1, (void*)&CO_OD_RAM.EncoderAlign},									/*new add  */
 {0x604B, 0x00, 0x3E,  1, (void*)&CO_OD_RAM.IqdRerClear},									/*new add  */
 
-{0x6050, 0x00, 0x3E,  2, (void*)&CO_OD_RAM.HallPhaseN},											/*	Hall_phase_N*/
-{0x6051, 0x00, 0x3E,  2, (void*)&CO_OD_RAM.HallPhaseP},											/*	Hall_phase_P*/
+{0x6050, 0x00, 0x3E,  2, (void*)&CO_OD_EEPROM.HallPhaseN},											/*	Hall_phase_N*/
+{0x6051, 0x00, 0x3E,  2, (void*)&CO_OD_EEPROM.HallPhaseP},											/*	Hall_phase_P*/
 {0x6060, 0x00, 0x3E,  1, (void*)&CO_OD_RAM.ModeOfOpration},									/*new add */
 {0x6099, 0x00, 0x3E,  2, (void*)&CO_OD_RAM.HomingSpeeds},										/*new add */
 {0x6200, 0x08, 0x3E,  1, (void*)&CO_OD_RAM.writeOutput8Bit[0]},							/*	0x3E	write anble*/
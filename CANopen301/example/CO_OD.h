@@ -102,12 +102,14 @@
    #define CO_NO_TPDO                     4   //Associated objects: 1800, 1801, 1802, 1803, 1A00, 1A01, 1A02, 1A03
    #define CO_NO_NMT_MASTER               0   
    #define CO_NO_TRACE                    0   
+   #define CO_NO_LSS_SERVER               1   //Associated objects: 1018
+   #define CO_NO_LSS_CLIENT               0   
 
 
 /*******************************************************************************
    OBJECT DICTIONARY
 *******************************************************************************/
-   #define CO_OD_NoOfElements             55 + 18 + 12
+   #define CO_OD_NoOfElements             55 + 18 + 12 + 4 + 1 + 1 + 1
 
 
 /*******************************************************************************
@@ -198,6 +200,9 @@ struct sCO_OD_RAM{
 /*1003      */ UNSIGNED32     preDefinedErrorField[8];
 /*1010      */ UNSIGNED32     storeParameters[1];
 /*1011      */ UNSIGNED32     restoreDefaultParameters[1];
+/*1F51      */ UNSIGNED8      programControl[1];
+/*1F56      */ UNSIGNED32     programSoftwareIdentification[1];
+/*1F57      */ UNSIGNED32     flashStatusIdentification[1];
 /*200E new  */ UNSIGNED16   	BusSupplyVoltage;
 /*200F new  */ UNSIGNED16   	MotorDriverTemperatur;
 /*2100      */ OCTET_STRING   errorStatusBits[10];
@@ -209,6 +214,9 @@ struct sCO_OD_RAM{
 /*2110      */ INTEGER32      variableInt32[16];
 /*2120      */ OD_testVar_t   testVar;
 /*2130      */ OD_time_t      time;
+/*2140      */ UNSIGNED16     conditionMonitor[7];
+/*2150      */ UNSIGNED16     stackMonitor[2];
+/*2151      */ UNSIGNED16     focCycles[2];
 /*6000      */ UNSIGNED8      readInput8Bit[8];
 /*6200      */ UNSIGNED8      writeOutput8Bit[8];
 /*6040  new */ UNSIGNED8      ControlWord;
@@ -225,8 +233,6 @@ struct sCO_OD_RAM{
 /*604a  new */ UNSIGNED8      EncoderAlign;
 /*604b  new */ UNSIGNED8      IqdRerClear;
 
-/*6050  new */ INTEGER16      HallPhaseN;
-/*6051  new */ INTEGER16      HallPhaseP;
 /*6060  new */ UNSIGNED8      ModeOfOpration;
 /*6099  new */ INTEGER16      HomingSpeeds;
 /*6401      */ INTEGER16      readAnalogueInput16Bit[12];
@@ -253,6 +259,8 @@ struct sCO_OD_EEPROM{
 /*2309      */ INTEGER16      	TORQUE_KP;
 /*230A      */ INTEGER16      	TORQUE_KI;
 /*230B      */ INTEGER16      	TORQUE_KD;
+/*6050  new */ INTEGER16      HallPhaseN;
+/*6051  new */ INTEGER16      HallPhaseP;
 
                UNSIGNED32     LastWord;
 };
@@ -389,6 +397,18 @@ extern struct sCO_OD_ROM CO_OD_ROM;
 /*1A00[4], Data Type: OD_TPDOMappingParameter_t, Array[4] */
       #define OD_TPDOMappingParameter                    CO_OD_ROM.TPDOMappingParameter
 
+/*1F51, Data Type: UNSIGNED8, Array[1] */
+      #define OD_programControl                          CO_OD_RAM.programControl
+      #define ODL_programControl_arrayLength             1
+
+/*1F56, Data Type: UNSIGNED32, Array[1] */
+      #define OD_programSoftwareIdentification           CO_OD_RAM.programSoftwareIdentification
+      #define ODL_programSoftwareIdentification_arrayLength 1
+
+/*1F57, Data Type: UNSIGNED32, Array[1] */
+      #define OD_flashStatusIdentification               CO_OD_RAM.flashStatusIdentification
+      #define ODL_flashStatusIdentification_arrayLength  1
+
 /*1F80, Data Type: UNSIGNED32 */
       #define OD_NMTStartup                              CO_OD_ROM.NMTStartup
 /**************		new add prar	start	***********************/			
@@ -455,6 +475,29 @@ extern struct sCO_OD_ROM CO_OD_ROM;
 /*2130, Data Type: OD_time_t */
       #define OD_time                                    CO_OD_RAM.time
 
+/*2140, Data Type: UNSIGNED16, Array[7] */
+      #define OD_conditionMonitor                        CO_OD_RAM.conditionMonitor
+      #define ODL_conditionMonitor_arrayLength           7
+      #define ODA_conditionMonitor_shaftFrequency        0
+      #define ODA_conditionMonitor_spectralFloor         1
+      #define ODA_conditionMonitor_imbalance             2
+      #define ODA_conditionMonitor_eccentricity          3
+      #define ODA_conditionMonitor_bearingOuterRace      4
+      #define ODA_conditionMonitor_bearingInnerRace      5
+      #define ODA_conditionMonitor_records               6
+
+/*2150, Data Type: UNSIGNED16, Array[2] */
+      #define OD_stackMonitor                            CO_OD_RAM.stackMonitor
+      #define ODL_stackMonitor_arrayLength               2
+      #define ODA_stackMonitor_stackSize                 0
+      #define ODA_stackMonitor_highWater                 1
+
+/*2151, Data Type: UNSIGNED16, Array[2] */
+      #define OD_focCycles                               CO_OD_RAM.focCycles
+      #define ODL_focCycles_arrayLength                  2
+      #define ODA_focCycles_last                         0
+      #define ODA_focCycles_max                          1
+
 /*6000, Data Type: UNSIGNED8, Array[8] */
       #define OD_readInput8Bit                           CO_OD_RAM.readInput8Bit
       #define ODL_readInput8Bit_arrayLength              8
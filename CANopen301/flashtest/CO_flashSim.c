@@ -0,0 +1,327 @@
+/*
+ * Host model of the STM32F3 flash memory and flash interface.
+ *
+ * @file        CO_flashSim.c
+ * @author      Janez Paternoster
+ * @copyright   2015 Janez Paternoster
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/* Flash memory is shared memory at 0x08000000, firmware reads it through
+ * its own pointers. Writes to it are plain stores to read only pages, the
+ * fault handler makes the page writable, until it is not written for
+ * SIM_IDLE_ACCESSES accesses to the flash interface. The model
+ * finds the written halfwords at the next access to the flash interface by
+ * comparing these pages with its copy and applies the rules of the device: a halfword is programmed only,
+ * if it is erased or the new value is 0, otherwise PGERR is set and the
+ * halfword keeps its value. Each operation is busy until the next access.
+ *
+ * Every power cycle runs in its own process, so RAM of the firmware starts
+ * from the state of the test, while flash and statistics are kept. Power cut
+ * inside an erase leaves random bits erased in the page, inside programming
+ * random bits of the halfword programmed. */
+
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+
+#define SIM_HALFWORDS       (CO_FLASH_SIM_SIZE / 2U)
+#define SIM_SR_PUBLISHED    0x80000000U /* reserved bit, cleared by a write of the firmware */
+#define SIM_SR_FLAGS        (FLASH_SR_EOP | FLASH_SR_WRPERR | FLASH_SR_PGERR)
+#define SIM_EXIT_END        64          /* exit status of CO_flashSimEnd_t */
+#define SIM_EXIT_FAULT      72
+#define SIM_IDLE_ACCESSES   256
+
+
+CO_flashSimStats_t         *CO_flashSimStats;
+SCB_Type                    CO_flashSimSCB;
+
+static uint16_t            *simFlash;
+static uint16_t             simCopy[SIM_HALFWORDS];     /* flash after the last access */
+static FLASH_TypeDef        simRegs;
+static uint32_t             simCR;          /* CR after the last access */
+static uint32_t             simSR;          /* status flags */
+static int                  simBusy;
+static uint8_t              simKey;         /* keys written */
+static uint32_t             simLcg = 1;
+static uint32_t             simHostPage;    /* of the host, unit of write protection */
+static volatile uint32_t    simWritable;    /* host pages, one bit each */
+static uint16_t             simIdle[32];    /* accesses without a write to the page */
+
+
+/* Helpers ********************************************************************/
+static void sim_writeFault(int sig, siginfo_t *info, void *context){
+    uintptr_t address = (uintptr_t)info->si_addr;
+    uint32_t page;
+
+    if(address < CO_FLASH_SIM_ADDRESS || address >= (CO_FLASH_SIM_ADDRESS + CO_FLASH_SIM_SIZE)){
+        signal(SIGSEGV, SIG_DFL);   /* fault of the program, crash at return */
+        return;
+    }
+    page = (uint32_t)(address - CO_FLASH_SIM_ADDRESS) / simHostPage;
+    simWritable |= 1UL << page;
+    simIdle[page] = 0;
+    mprotect((void *)(uintptr_t)(CO_FLASH_SIM_ADDRESS + page * simHostPage), simHostPage, PROT_READ | PROT_WRITE);
+}
+
+static void sim_fail(const char *what, uint32_t address){
+    fprintf(stderr, "CO_flashSim: %s at 0x%08X\n", what, (unsigned)address);
+    fflush(stderr);
+    _exit(SIM_EXIT_FAULT);
+}
+
+static uint16_t sim_random(void){
+    simLcg = simLcg * 1103515245U + 12345U;
+    return (uint16_t)(simLcg >> 16);
+}
+
+/* Power is cut, if operation is the one, otherwise it takes its time */
+static void sim_operation(uint32_t us){
+    CO_flashSimStats_t *s = CO_flashSimStats;
+
+    s->ops++;
+    s->time_us += us;
+    simBusy = 1;
+}
+
+static int sim_cut(void){
+    return CO_flashSimStats->ops == CO_flashSimStats->cutAt;
+}
+
+static void sim_powerCut(uint32_t address){
+    CO_flashSimStats->cutAddress = address;
+    fflush(stdout);
+    _exit(SIM_EXIT_END + CO_FLASH_SIM_CUT);
+}
+
+static void sim_erase(uint32_t address){
+    uint32_t first = (address - CO_FLASH_SIM_ADDRESS) / 2U & ~(CO_FLASH_SIM_PAGE_SIZE / 2U - 1U);
+    uint32_t i;
+
+    if(address < CO_FLASH_SIM_ADDRESS || address >= (CO_FLASH_SIM_ADDRESS + CO_FLASH_SIM_SIZE)){
+        sim_fail("erase outside of flash", address);
+    }
+    sim_operation(CO_FLASH_SIM_ERASE_US);
+    CO_flashSimStats->erases++;
+    address = CO_FLASH_SIM_ADDRESS + first * 2U;
+    for(i = first; i < first + CO_FLASH_SIM_PAGE_SIZE / 2U; i++){
+        simFlash[i] = sim_cut() ? (uint16_t)(simCopy[i] | sim_random()) : 0xFFFFU;
+        simCopy[i] = simFlash[i];
+    }
+    if(sim_cut()){
+        sim_powerCut(address);
+    }
+}
+
+static void sim_program(uint32_t i, uint16_t value){
+    uint32_t address = CO_FLASH_SIM_ADDRESS + i * 2U;
+
+    if((simCR & FLASH_CR_LOCK) != 0U || (simCR & FLASH_CR_PG) == 0U){
+        sim_fail("write to flash without PG", address);
+    }
+    if(simCopy[i] != 0xFFFFU && value != 0U){
+        CO_flashSimStats->pgErrors++;
+        simSR |= FLASH_SR_PGERR;
+        simFlash[i] = simCopy[i];
+        return;
+    }
+    sim_operation(CO_FLASH_SIM_PROGRAM_US);
+    CO_flashSimStats->programs++;
+    if(sim_cut()){
+        value = (uint16_t)(simCopy[i] & (value | sim_random()));
+    }
+    simFlash[i] = value;
+    simCopy[i] = value;
+    if(sim_cut()){
+        sim_powerCut(address);
+    }
+}
+
+
+/* Flash interface ************************************************************/
+FLASH_TypeDef *CO_flashSimRegs(void){
+    uint32_t pages, i;
+
+    /* operation started by the last access is finished */
+    if(simBusy){
+        simBusy = 0;
+        simSR |= FLASH_SR_EOP;
+    }
+
+    /* unlock sequence, wrong key locks until reset */
+    if(simRegs.KEYR != 0U){
+        if(simKey == 0U && simRegs.KEYR == FLASH_KEY1){
+            simKey = 1U;
+        }
+        else if(simKey == 1U && simRegs.KEYR == FLASH_KEY2 && (simCR & FLASH_CR_LOCK) != 0U){
+            simKey = 0U;
+            simCR &= ~FLASH_CR_LOCK;
+            simRegs.CR &= ~FLASH_CR_LOCK;
+        }
+        else{
+            sim_fail("wrong key sequence", simRegs.KEYR);
+        }
+        simRegs.KEYR = 0U;
+    }
+
+    /* CR is write protected while locked, LOCK is cleared by the keys only */
+    if((simCR & FLASH_CR_LOCK) != 0U){
+        if(simRegs.CR != simCR){
+            sim_fail("write to locked CR", simRegs.CR);
+        }
+    }
+    else{
+        simCR = simRegs.CR;
+    }
+
+    /* write one to clear */
+    if((simRegs.SR & SIM_SR_PUBLISHED) == 0U){
+        simSR &= ~(simRegs.SR & SIM_SR_FLAGS);
+    }
+
+    /* halfwords written since the last access */
+    for(pages = simWritable; pages != 0U; pages &= pages - 1U){
+        uint32_t page = (uint32_t)__builtin_ctz(pages);
+        uint32_t first = page * simHostPage / 2U;
+
+        if(memcmp(&simFlash[first], &simCopy[first], simHostPage) == 0){
+            if(++simIdle[page] >= SIM_IDLE_ACCESSES){
+                simWritable &= ~(1UL << page);
+                mprotect(&simFlash[first], simHostPage, PROT_READ);
+            }
+            continue;
+        }
+        simIdle[page] = 0;
+        for(i = first; i < first + simHostPage / 2U; i++){
+            if(simFlash[i] != simCopy[i]){
+                sim_program(i, simFlash[i]);
+            }
+        }
+    }
+
+    /* page erase */
+    if((simCR & FLASH_CR_STRT) != 0U){
+        simCR &= ~FLASH_CR_STRT;
+        if((simCR & FLASH_CR_PER) == 0U){
+            sim_fail("erase other than page erase", simRegs.AR);
+        }
+        sim_erase(simRegs.AR);
+    }
+
+    simRegs.CR = simCR;
+    simRegs.SR = simSR | (simBusy ? FLASH_SR_BSY : 0U) | SIM_SR_PUBLISHED;
+    return &simRegs;
+}
+
+void CO_flashSimSync(void){
+    (void)CO_flashSimRegs();
+    (void)CO_flashSimRegs();
+}
+
+
+/* Core ***********************************************************************/
+void CO_flashSimDSB(void){
+    if((CO_flashSimSCB.AIRCR & SCB_AIRCR_SYSRESETREQ_Msk) != 0U){
+        CO_flashSimReset();
+    }
+}
+
+void CO_flashSimReset(void){
+    CO_flashSimSync();
+    fflush(stdout);
+    _exit(SIM_EXIT_END + CO_FLASH_SIM_RESET);
+}
+
+
+/* Test interface *************************************************************/
+void CO_flashSimInit(void){
+    void *flash = mmap((void *)(uintptr_t)CO_FLASH_SIM_ADDRESS, CO_FLASH_SIM_SIZE,
+                       PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+    void *stats = mmap(NULL, sizeof(CO_flashSimStats_t),
+                       PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    struct sigaction sa;
+
+    if(flash != (void *)(uintptr_t)CO_FLASH_SIM_ADDRESS || stats == MAP_FAILED){
+        fprintf(stderr, "CO_flashSim: flash can't be mapped at 0x%08X\n", CO_FLASH_SIM_ADDRESS);
+        exit(EXIT_FAILURE);
+    }
+    simFlash = flash;
+    CO_flashSimStats = stats;
+    simHostPage = (uint32_t)sysconf(_SC_PAGESIZE);
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_sigaction = sim_writeFault;
+    sa.sa_flags = SA_SIGINFO;
+    sigaction(SIGSEGV, &sa, NULL);
+    memset(simFlash, 0xFF, CO_FLASH_SIM_SIZE);
+    memset(CO_flashSimStats, 0, sizeof(*CO_flashSimStats));
+}
+
+void CO_flashSimLoad(uint32_t address, const void *data, uint32_t length){
+    memcpy((void *)(uintptr_t)address, data, length);
+}
+
+void CO_flashSimErase(uint32_t address, uint32_t length){
+    memset((void *)(uintptr_t)address, 0xFF, length);
+}
+
+CO_flashSimEnd_t CO_flashSimRun(void (*function)(void)){
+    pid_t pid;
+    int status;
+
+    fflush(stdout);
+    fflush(stderr);
+    pid = fork();
+    if(pid < 0){
+        perror("CO_flashSim: fork");
+        exit(EXIT_FAILURE);
+    }
+    if(pid == 0){
+        /* power on reset of the flash interface and the core */
+        memcpy(simCopy, simFlash, sizeof(simCopy));
+        mprotect(simFlash, CO_FLASH_SIM_SIZE, PROT_READ);
+        simWritable = 0U;
+        memset(&simRegs, 0, sizeof(simRegs));
+        memset(&CO_flashSimSCB, 0, sizeof(CO_flashSimSCB));
+        simRegs.CR = simCR = FLASH_CR_LOCK;
+        simSR = 0U;
+        simBusy = 0;
+        simKey = 0U;
+        simLcg = CO_flashSimStats->cutSeed * 2654435761U + CO_flashSimStats->ops + 1U;
+        function();
+        CO_flashSimSync();
+        fflush(stdout);
+        _exit(SIM_EXIT_END + CO_FLASH_SIM_DONE);
+    }
+    if(waitpid(pid, &status, 0) != pid || !WIFEXITED(status)){
+        fprintf(stderr, "CO_flashSim: power cycle crashed\n");
+        exit(EXIT_FAILURE);
+    }
+    if(WEXITSTATUS(status) < SIM_EXIT_END || WEXITSTATUS(status) > (SIM_EXIT_END + CO_FLASH_SIM_CUT)){
+        exit(EXIT_FAILURE);
+    }
+    return (CO_flashSimEnd_t)(WEXITSTATUS(status) - SIM_EXIT_END);
+}
@@ -0,0 +1,111 @@
+/*
+ * Host model of the STM32F3 flash memory and flash interface, included before
+ * every source of the flash tests with "-include".
+ *
+ * @file        CO_flashSim.h
+ * @author      Janez Paternoster
+ * @copyright   2015 Janez Paternoster
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef CO_FLASH_SIM_H
+#define CO_FLASH_SIM_H
+
+
+/* HAL and core headers are included first, their guards keep the
+ * redefinitions below */
+#include "stm32f3xx_hal.h"
+
+
+/* Flash of the STM32F302R8 is mapped at its own address */
+#define CO_FLASH_SIM_ADDRESS        0x08000000U
+#define CO_FLASH_SIM_SIZE           0x10000U
+#define CO_FLASH_SIM_PAGE_SIZE      0x800U
+
+/* Maximum times of the datasheet, model time of the operations */
+#define CO_FLASH_SIM_ERASE_US       40000U
+#define CO_FLASH_SIM_PROGRAM_US     60U
+
+/* Power cycle of CO_flashSimRun() ended with */
+typedef enum{
+    CO_FLASH_SIM_DONE,              /* function returned */
+    CO_FLASH_SIM_RESET,             /* system reset, SYSRESETREQ or NVIC_SystemReset() */
+    CO_FLASH_SIM_CUT                /* power cut at CO_flashSimStats.cutAt */
+}CO_flashSimEnd_t;
+
+/* Kept over power cycles */
+typedef struct{
+    uint32_t            ops;        /* erase and program operations */
+    uint32_t            erases;
+    uint32_t            programs;   /* halfwords */
+    uint32_t            pgErrors;   /* program of a halfword, which is not erased */
+    uint32_t            cutAt;      /* power is cut inside this operation, 0 never */
+    uint32_t            cutAddress; /* page or halfword, which is left broken */
+    uint32_t            cutSeed;    /* of the random bits, which are left */
+    uint64_t            time_us;    /* flash busy */
+}CO_flashSimStats_t;
+
+extern CO_flashSimStats_t  *CO_flashSimStats;
+
+/* Map the flash, all erased */
+void CO_flashSimInit(void);
+
+/* Flash content written by the programmer, not counted */
+void CO_flashSimLoad(uint32_t address, const void *data, uint32_t length);
+void CO_flashSimErase(uint32_t address, uint32_t length);
+
+/* Run function in a new process, which has the RAM of the caller and the
+ * flash of the model, like the drive after power on. Test fails, if the
+ * process fails or breaks a rule of the flash interface. */
+CO_flashSimEnd_t CO_flashSimRun(void (*function)(void));
+
+/* Pending operation is finished, called by the test before it reads flash */
+void CO_flashSimSync(void);
+
+
+/* Flash interface. Every access lets the model see the writes since the last
+ * access: key sequence, control bits, write one to clear status flags and
+ * halfwords written to flash memory. */
+FLASH_TypeDef *CO_flashSimRegs(void);
+#undef FLASH
+#define FLASH               (CO_flashSimRegs())
+
+
+/* System reset and critical sections of the core */
+extern SCB_Type             CO_flashSimSCB;
+void CO_flashSimDSB(void);
+void CO_flashSimReset(void);
+#undef SCB
+#define SCB                 (&CO_flashSimSCB)
+#define __DSB()             CO_flashSimDSB()
+#define __disable_irq()
+#define __enable_irq()
+#define __set_PRIMASK(priMask) ((void)(priMask))
+#define NVIC_SystemReset()  CO_flashSimReset()
+
+/* __RBIT() is an instruction of the core, result for 0 is 32 as __CLZ() */
+static inline uint32_t CO_flashSimPositionVal(uint32_t value){
+    return (uint32_t)__builtin_ctzll((uint64_t)value | (1ULL << 32));
+}
+#undef POSITION_VAL
+#define POSITION_VAL(VAL)   CO_flashSimPositionVal(VAL)
+
+
+#endif
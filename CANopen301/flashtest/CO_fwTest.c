@@ -0,0 +1,474 @@
+/*
+ * Host tests of the STM32F3 program download against a model of the flash.
+ *
+ * @file        CO_fwTest.c
+ * @author      Janez Paternoster
+ * @copyright   2015 Janez Paternoster
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/* stack/STM32F3/CO_FwUpdate.c and the HAL flash driver are compiled unchanged
+ * against flashtest/CO_flashSim.h. Node uses the stack with the simCAN driver
+ * and example/CO_OD.c, the program download objects are written as the SDO
+ * server does it, with CO_SDO_writeOD() in chunks of the SDO buffer. Time is
+ * virtual: HAL_GetTick() is one FOC period, which programs a halfword while
+ * the motor runs, like ADC1_2_IRQHandler(). Results do not depend on the host.
+ *
+ * update: old application runs, master clears the staging bank and downloads
+ * the new image while the motor runs, then starts it with the motor stopped.
+ * Drive resets, CO_FwUpdateBoot() swaps the images and resets again.
+ *
+ * power_cut: power is cut inside the flash operations of the update, at all
+ * erases, at the ends of each step and at every FW_CUT_STRIDE-th halfword.
+ * After power on the drive starts, if the application area holds the old or
+ * the new image, and the update is repeated. Cut inside the swap leaves the
+ * application area broken: that window must be the only one. */
+
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "CANopen.h"
+#include "CO_FwUpdate.h"
+#include "crc16-ccitt.h"
+
+
+#define FW_NODE_ID              5
+#define FW_FOC_US               50      /* HAL_GetTick() call */
+#define FW_BLOCK_US             16000   /* SDO block of 127 segments at 1000 kbit/s */
+#define FW_OLD_LENGTH           0x6000U
+#define FW_NEW_LENGTH           0x6801U /* odd, last byte is padded */
+#define FW_STALE_LENGTH         0x2800U /* previous download in the staging bank */
+#define FW_PARAM_ADDRESS        0x0800E800U
+#define FW_PARAM_SIZE           0x1000U
+#define FW_APP_SIZE             (CO_FW_STAGING_ADDRESS - CO_FW_APP_ADDRESS)
+#define FW_PROCESS_MAX          100000  /* main loop calls, before the test fails */
+#define FW_RESET_MS             1000    /* after start, before the test fails */
+#define FW_BOOTS_MAX            3
+#define FW_CUT_STRIDE           199
+#define FW_CUT_EDGE             8       /* every operation at start and end of a step */
+
+
+/* Drive */
+static CO_CANsimPort_t      fwPort;
+static bool_t               fwMotorRunning;
+static uint32_t             fwTime_us;
+
+/* Images and flash content */
+static uint8_t              fwOldImage[FW_OLD_LENGTH];
+static uint8_t              fwNewImage[FW_NEW_LENGTH];
+static uint8_t              fwParam[FW_PARAM_SIZE];
+static uint8_t              fwAppOld[FW_APP_SIZE];  /* application area before the update */
+static uint8_t              fwAppNew[FW_APP_SIZE];  /* and after */
+
+/* Operations of the update steps */
+typedef struct{
+    uint32_t            clear;          /* erases of the staging bank */
+    uint32_t            download;       /* and programs, with the swap record */
+    uint32_t            swapErase;
+    uint32_t            swapProgram;
+    uint32_t            total;          /* with the erase of the swap record */
+    uint64_t            downloadTime_us;
+    uint64_t            swapTime_us;
+}fw_ops_t;
+
+static fw_ops_t             fwOps;
+
+typedef enum{FW_APP_OLD, FW_APP_NEW, FW_APP_BROKEN}fw_app_t;
+
+
+/* Helpers ********************************************************************/
+static void fw_fail(const char *name, const char *what){
+    fprintf(stderr, "CO_fwTest: %s: %s\n", name, what);
+    exit(EXIT_FAILURE);
+}
+
+/* Vector table of an application, then code, same in every run */
+static void fw_image(uint8_t *image, uint32_t length, uint32_t seed){
+    uint32_t i;
+
+    for(i = 0; i < length; i++){
+        seed = seed * 1103515245U + 12345U;
+        image[i] = (uint8_t)(seed >> 16);
+    }
+    image[0] = 0x00; image[1] = 0x40; image[2] = 0x00; image[3] = 0x20;    /* SP 0x20004000 */
+    image[4] = 0xC1; image[5] = 0x01; image[6] = 0x00; image[7] = 0x08;    /* Reset_Handler */
+}
+
+static fw_app_t fw_app(void){
+    if(memcmp((const void *)(uintptr_t)CO_FW_APP_ADDRESS, fwAppOld, FW_APP_SIZE) == 0){
+        return FW_APP_OLD;
+    }
+    if(memcmp((const void *)(uintptr_t)CO_FW_APP_ADDRESS, fwAppNew, FW_APP_SIZE) == 0){
+        return FW_APP_NEW;
+    }
+    return FW_APP_BROKEN;
+}
+
+static bool_t fw_recordErased(void){
+    const uint32_t *p = (const uint32_t *)(uintptr_t)CO_FW_RECORD_ADDRESS;
+    uint32_t i;
+
+    for(i = 0; i < CO_FW_PAGE_SIZE / 4U; i++){
+        if(p[i] != 0xFFFFFFFFU) return false;
+    }
+    return true;
+}
+
+/* Firmware functions, which are not part of the test */
+uint32_t HAL_GetTick(void){
+    fwTime_us += FW_FOC_US;
+    if(fwMotorRunning){
+        CO_FwUpdateProgramStep();
+    }
+    return fwTime_us / 1000U;
+}
+
+bool MI_SetReg(UI_Handle_t *pHandle, CO_SDO_t *pSDO){
+    return false;
+}
+
+int32_t MI_GetReg(UI_Handle_t *pHandle, CO_SDO_t *pSDO){
+    return (int32_t)GUI_ERROR_CODE;
+}
+
+static bool_t fw_idle(void){
+    return !fwMotorRunning;
+}
+
+
+/* Drive **********************************************************************/
+/* CANopen_Init() of the firmware */
+static void fw_init(void){
+    CO_CANsimPort = &fwPort;
+    fwPort.txOnBus = CO_CAN_SIM_MAILBOX_NONE;
+    if(CO_init(0, FW_NODE_ID, 1000, NULL) != CO_ERROR_NO){
+        fw_fail("init", "CO_init() failed");
+    }
+    CO_FwUpdateRegisterODFunctions(CO, fw_idle);
+}
+
+/* Main loop until program download is idle */
+static void fw_process(const char *name){
+    uint32_t n;
+
+    for(n = 0; CO_FwUpdateProcess(1); n++){
+        fwTime_us += 1000U;
+        if(n > FW_PROCESS_MAX){
+            fw_fail(name, "CO_FwUpdateProcess() does not finish");
+        }
+    }
+}
+
+static uint32_t fw_control(uint8_t command){
+    CO_SDO_t *SDO = CO->SDO[0];
+    uint32_t abortCode = CO_SDO_initTransfer(SDO, OD_H1F51_PROGRAM_CONTROL, 1);
+
+    if(abortCode == 0U){
+        SDO->databuffer[0] = command;
+        abortCode = CO_SDO_writeOD(SDO, 1);
+    }
+    return abortCode;
+}
+
+/* Block download to 0x1F50, the SDO server writes the buffer when it is full.
+ * FOC interrupts program the previous chunk, while the next block arrives. */
+static uint32_t fw_download(const uint8_t *image, uint32_t length){
+    CO_SDO_t *SDO = CO->SDO[0];
+    uint32_t abortCode = CO_SDO_initTransfer(SDO, OD_H1F50_PROGRAM_DATA, 1);
+    uint32_t offset = 0, t;
+
+    SDO->ODF_arg.dataLengthTotal = length;
+    while(abortCode == 0U && offset < length){
+        uint16_t len = (uint16_t)(((length - offset) > CO_SDO_BUFFER_SIZE) ? CO_SDO_BUFFER_SIZE : (length - offset));
+
+        for(t = 0; t < FW_BLOCK_US; t += FW_FOC_US){
+            (void)HAL_GetTick();
+        }
+        memcpy(SDO->databuffer, &image[offset], len);
+        SDO->ODF_arg.lastSegment = ((offset + len) == length) ? true : false;
+        abortCode = CO_SDO_writeOD(SDO, len);
+        offset += len;
+    }
+    return abortCode;
+}
+
+/* Reset_Handler() to main() of the application */
+static void fw_boot(void){
+    CO_FwUpdateBoot();
+}
+
+static void fw_update(void){
+    uint32_t t;
+
+    fw_init();
+
+    if(fw_control(CO_FW_CTRL_CLEAR) != 0U){
+        fw_fail("update", "clear rejected");
+    }
+    fw_process("update");
+    if(OD_flashStatusIdentification[0] != CO_FW_STATUS_OK){
+        fw_fail("update", "staging bank not cleared");
+    }
+
+    fwMotorRunning = true;
+    if(fw_download(fwNewImage, FW_NEW_LENGTH) != 0U){
+        fw_fail("update", "download aborted");
+    }
+    if(OD_flashStatusIdentification[0] != CO_FW_STATUS_OK ||
+       OD_programSoftwareIdentification[0] != crc16_ccitt(fwNewImage, FW_NEW_LENGTH, 0)){
+        fw_fail("update", "image not verified");
+    }
+    if(fw_control(CO_FW_CTRL_START) != CO_SDO_AB_DATA_DEV_STATE){
+        fw_fail("update", "start accepted while the motor runs");
+    }
+
+    fwMotorRunning = false;
+    if(fw_control(CO_FW_CTRL_START) != 0U){
+        fw_fail("update", "start rejected");
+    }
+    for(t = 0; t < FW_RESET_MS; t++){
+        CO_FwUpdateProcess(1);
+        fwTime_us += 1000U;
+    }
+    fw_fail("update", "no reset after start");
+}
+
+/* Power on after a cut, until the application runs. Returns false, if the
+ * application area can't start. */
+static bool_t fw_powerOn(const char *name){
+    unsigned boots;
+
+    for(boots = 0; boots < FW_BOOTS_MAX; boots++){
+        if(fw_app() == FW_APP_BROKEN){
+            return false;
+        }
+        if(CO_flashSimRun(fw_boot) == CO_FLASH_SIM_DONE){
+            return true;
+        }
+    }
+    fw_fail(name, "swap repeats after reset");
+    return false;
+}
+
+/* Flash of a drive in the field: old application, part of an earlier download
+ * and parameters */
+static void fw_flashInit(void){
+    CO_flashSimErase(CO_FLASH_SIM_ADDRESS, CO_FLASH_SIM_SIZE);
+    CO_flashSimLoad(CO_FW_APP_ADDRESS, fwOldImage, FW_OLD_LENGTH);
+    CO_flashSimLoad(CO_FW_STAGING_ADDRESS, fwNewImage, FW_STALE_LENGTH);
+    CO_flashSimLoad(FW_PARAM_ADDRESS, fwParam, FW_PARAM_SIZE);
+    memset(CO_flashSimStats, 0, sizeof(*CO_flashSimStats));
+}
+
+static void fw_checkParam(const char *name){
+    if(memcmp((const void *)(uintptr_t)FW_PARAM_ADDRESS, fwParam, FW_PARAM_SIZE) != 0){
+        fw_fail(name, "parameter pages changed");
+    }
+}
+
+
+/* Update *********************************************************************/
+static void fw_testUpdate(void){
+    CO_flashSimStats_t s;
+    uint32_t swapOps;
+
+    fw_flashInit();
+    if(CO_flashSimRun(fw_boot) != CO_FLASH_SIM_DONE || fw_app() != FW_APP_OLD){
+        fw_fail("update", "old application does not start");
+    }
+
+    if(CO_flashSimRun(fw_update) != CO_FLASH_SIM_RESET){
+        fw_fail("update", "download failed");
+    }
+    s = *CO_flashSimStats;
+    fwOps.clear = s.erases;
+    fwOps.download = s.ops;
+    fwOps.downloadTime_us = s.time_us;
+    if(memcmp((const void *)(uintptr_t)CO_FW_STAGING_ADDRESS, fwNewImage, FW_NEW_LENGTH) != 0){
+        fw_fail("update", "staging bank does not hold the image");
+    }
+    if(fw_app() != FW_APP_OLD){
+        fw_fail("update", "application changed by the download");
+    }
+
+    if(CO_flashSimRun(fw_boot) != CO_FLASH_SIM_RESET){
+        fw_fail("update", "no swap after start");
+    }
+    fwOps.total = CO_flashSimStats->ops;
+    fwOps.swapErase = CO_flashSimStats->erases - s.erases - 1U;
+    fwOps.swapProgram = CO_flashSimStats->programs - s.programs;
+    fwOps.swapTime_us = CO_flashSimStats->time_us - s.time_us;
+    swapOps = fwOps.total - fwOps.download;
+    memcpy(fwAppNew, (const void *)(uintptr_t)CO_FW_APP_ADDRESS, FW_APP_SIZE);
+    if(memcmp(fwAppNew, fwNewImage, FW_NEW_LENGTH) != 0 || fwAppNew[FW_NEW_LENGTH] != 0xFF){
+        fw_fail("update", "application area does not hold the image");
+    }
+
+    if(CO_flashSimRun(fw_boot) != CO_FLASH_SIM_DONE || fw_app() != FW_APP_NEW){
+        fw_fail("update", "new application does not start");
+    }
+    if(!fw_recordErased()){
+        fw_fail("update", "swap record not erased");
+    }
+    fw_checkParam("update");
+    if(CO_flashSimStats->pgErrors != 0){
+        fw_fail("update", "program of a halfword, which is not erased");
+    }
+
+    printf("update: image %u bytes, old %u bytes, motor runs during download\n",
+           (unsigned)FW_NEW_LENGTH, (unsigned)FW_OLD_LENGTH);
+    printf("  clear and download     %5u operations (%u page erases), flash busy %6.1f ms\n",
+           (unsigned)fwOps.download, (unsigned)fwOps.clear, (double)fwOps.downloadTime_us / 1000.0);
+    printf("  swap                   %5u operations (%u page erases, %u halfwords, record erase),"
+           " flash busy %6.1f ms\n",
+           (unsigned)swapOps, (unsigned)fwOps.swapErase, (unsigned)fwOps.swapProgram,
+           (double)fwOps.swapTime_us / 1000.0);
+}
+
+
+/* Power cut ******************************************************************/
+/* Update with power cut inside operation k, then power on until the
+ * application runs */
+static fw_app_t fw_cut(uint32_t k){
+    fw_app_t app;
+
+    fw_flashInit();
+    CO_flashSimStats->cutAt = k;
+    if(CO_flashSimRun(fw_update) != CO_FLASH_SIM_CUT){
+        unsigned boots;
+        for(boots = 0; CO_flashSimRun(fw_boot) != CO_FLASH_SIM_CUT; boots++){
+            if(boots >= FW_BOOTS_MAX){
+                fw_fail("power_cut", "operation of the cut not reached");
+            }
+        }
+    }
+    CO_flashSimStats->cutAt = 0;
+
+    if(!fw_powerOn("power_cut")){
+        return FW_APP_BROKEN;
+    }
+    app = fw_app();
+    fw_checkParam("power_cut");
+
+    /* master repeats the update */
+    if(app == FW_APP_OLD){
+        if(CO_flashSimRun(fw_update) != CO_FLASH_SIM_RESET || !fw_powerOn("power_cut") || fw_app() != FW_APP_NEW){
+            fw_fail("power_cut", "update after power cut failed");
+        }
+    }
+    return app;
+}
+
+/* Cuts are placed by the operations of the update test */
+static void fw_testPowerCut(void){
+    uint32_t windowFirst = fwOps.download + 1U;
+    uint32_t windowLast = fwOps.download + fwOps.swapErase + fwOps.swapProgram;
+    uint32_t count[3] = {0, 0, 0};
+    uint32_t cuts = 0, brokenFirst = 0, brokenLast = 0, k;
+
+    if(fwOps.total == 0){
+        fw_testUpdate();
+        windowFirst = fwOps.download + 1U;
+        windowLast = fwOps.download + fwOps.swapErase + fwOps.swapProgram;
+    }
+    for(k = 1; k <= fwOps.total; k++){
+        fw_app_t app;
+
+        if(!(k <= fwOps.clear + FW_CUT_EDGE
+          || (k + FW_CUT_EDGE > fwOps.download && k <= windowFirst + fwOps.swapErase + FW_CUT_EDGE)
+          || k + FW_CUT_EDGE > windowLast
+          || (k % FW_CUT_STRIDE) == 0)){
+            continue;
+        }
+        app = fw_cut(k);
+        count[app]++;
+        cuts++;
+        if(app == FW_APP_BROKEN){
+            if(brokenFirst == 0) brokenFirst = k;
+            brokenLast = k;
+            if(k < windowFirst || k > windowLast){
+                fw_fail("power_cut", "application broken by a cut outside of the swap");
+            }
+        }
+        else if(k >= windowFirst && k < windowLast){
+            fw_fail("power_cut", "application starts after a cut inside the swap");
+        }
+        else if(k > windowLast && app != FW_APP_NEW){
+            fw_fail("power_cut", "swap not finished after a cut at the record erase");
+        }
+    }
+
+    printf("power_cut: %u cuts of %u operations, old application %u, new %u, broken %u\n",
+           (unsigned)cuts, (unsigned)fwOps.total,
+           (unsigned)count[FW_APP_OLD], (unsigned)count[FW_APP_NEW], (unsigned)count[FW_APP_BROKEN]);
+    printf("  broken by cuts         operations %u to %u, first erase of the swap to its last halfword\n",
+           (unsigned)brokenFirst, (unsigned)brokenLast);
+    printf("  failure window         %6.1f ms for %u bytes, %6.1f ms for the staging bank of %u bytes\n",
+           (double)(fwOps.swapErase * CO_FLASH_SIM_ERASE_US + fwOps.swapProgram * CO_FLASH_SIM_PROGRAM_US) / 1000.0,
+           (unsigned)FW_NEW_LENGTH,
+           (double)((CO_FW_STAGING_SIZE / CO_FW_PAGE_SIZE) * CO_FLASH_SIM_ERASE_US
+                    + (CO_FW_STAGING_SIZE / 2U) * CO_FLASH_SIM_PROGRAM_US) / 1000.0,
+           (unsigned)CO_FW_STAGING_SIZE);
+}
+
+
+/* Main ***********************************************************************/
+typedef struct{
+    const char         *name;
+    void              (*run)(void);
+}fw_test_t;
+
+static const fw_test_t tests[] = {
+    {"update",          fw_testUpdate},
+    {"power_cut",       fw_testPowerCut}
+};
+
+int main(int argc, char *argv[]){
+    const char *filter = NULL;
+    unsigned i;
+    int c;
+
+    while((c = getopt(argc, argv, "f:")) != -1){
+        switch(c){
+            case 'f': filter = optarg; break;
+            default:
+                fprintf(stderr, "Usage: %s [-f name filter]\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    CO_flashSimInit();
+    fw_image(fwOldImage, FW_OLD_LENGTH, 1);
+    fw_image(fwNewImage, FW_NEW_LENGTH, 2);
+    fw_image(fwParam, FW_PARAM_SIZE, 3);
+    fw_flashInit();
+    memcpy(fwAppOld, (const void *)(uintptr_t)CO_FW_APP_ADDRESS, FW_APP_SIZE);
+
+    for(i = 0; i < sizeof(tests) / sizeof(tests[0]); i++){
+        if(filter != NULL && strstr(tests[i].name, filter) == NULL) continue;
+        tests[i].run();
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,384 @@
+/*
+ * Host tests of the STM32F3 flash key-value store against a model of the flash.
+ *
+ * @file        CO_kvTest.c
+ * @author      Janez Paternoster
+ * @copyright   2015 Janez Paternoster
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/* stack/STM32F3/CO_FlashKV.c and the HAL flash driver are compiled unchanged
+ * against flashtest/CO_flashSim.h. Values have the sizes of the firmware:
+ * CO_OD_ROM stored by 0x1010 and removed by 0x1011, CO_OD_EEPROM stored by
+ * the autosave of CO_Flash.c, LSS and Modbus configuration. Write n of the
+ * workload stores version n of one key, so the expected content after any
+ * number of writes is known. Results do not depend on the host.
+ *
+ * endurance: workload runs until the pages reach KV_ENDURANCE_ERASES erases,
+ * every value is read back after each write and after each power on. Erases
+ * must be spread over the pages, lifetime is given for the autosave period.
+ *
+ * power_cut: from a store with both pages in use, power is cut inside every
+ * flash operation of KV_CUT_WRITES writes. After power on, every completed
+ * write must be kept, the interrupted one is either complete or ignored, and
+ * the store must accept the following writes. A cut inside a page erase is
+ * repeated KV_CUT_ERASE_SEEDS times with other bits left in the page. */
+
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "CANopen.h"
+#include "CO_Flash.h"
+#include "CO_FlashKV.h"
+
+
+#define KV_ENDURANCE_ERASES     400     /* of all pages */
+#define KV_POWER_CYCLE_WRITES   500     /* writes between power cycles */
+#define KV_FLASH_CYCLES         10000U  /* endurance of the datasheet */
+#define KV_AUTOSAVE_S           60U     /* CO_FLASH_AUTOSAVE_DELAY_MS */
+#define KV_CUT_PRE_WRITES       40      /* both pages in use before the cuts */
+#define KV_CUT_WRITES           20
+#define KV_CUT_ERASE_SEEDS      128     /* cuts inside every erase */
+#define KV_KEYS                 4U
+#define KV_LENGTH_MAX           sizeof(CO_OD_ROM)
+#define KV_AREA_SIZE            (CO_FLASHKV_PAGES * CO_FLASHKV_PAGE_SIZE)
+
+
+/* Shared with the power cycles */
+typedef struct{
+    uint32_t            completed;      /* writes, which returned CO_ERROR_NO */
+    bool_t              interruptedKept;
+    uint32_t            eraseCount[CO_FLASHKV_PAGES];
+}kv_shared_t;
+
+static kv_shared_t         *kvShared;
+
+/* Workload of the power cycle */
+static uint32_t             kvFirst;        /* first write */
+static uint32_t             kvLast;
+static uint32_t             kvTick;
+
+
+/* Helpers ********************************************************************/
+static void kv_fail(const char *name, const char *what, uint32_t n){
+    fprintf(stderr, "CO_kvTest: %s: %s, write %u\n", name, what, (unsigned)n);
+    exit(EXIT_FAILURE);
+}
+
+uint32_t HAL_GetTick(void){
+    return kvTick++;
+}
+
+/* Key and length of write n, length 0 removes the key */
+static uint16_t kv_write(uint32_t n, uint16_t *length){
+    if((n % 97U) == 0U){
+        *length = 0;
+        return CO_FLASH_KEY_OD_ROM;
+    }
+    if((n % 47U) == 0U){
+        *length = sizeof(CO_OD_ROM);
+        return CO_FLASH_KEY_OD_ROM;
+    }
+    if((n % 151U) == 0U){
+        *length = 4;
+        return CO_FLASH_KEY_LSS;
+    }
+    if((n % 263U) == 0U){
+        *length = 2;
+        return CO_FLASH_KEY_MODBUS;
+    }
+    *length = sizeof(CO_OD_EEPROM);
+    return CO_FLASH_KEY_OD_EEPROM;
+}
+
+/* Value of write n */
+static void kv_value(uint32_t n, uint8_t *value, uint16_t length){
+    uint32_t seed = n * 2654435761U;
+    uint16_t i;
+
+    for(i = 0; i < length; i++){
+        seed = seed * 1103515245U + 12345U;
+        value[i] = (uint8_t)(seed >> 16);
+    }
+}
+
+/* Last write of key up to write n, 0 if none */
+static uint32_t kv_lastWrite(uint16_t key, uint32_t n){
+    for(; n > 0; n--){
+        uint16_t length;
+        if(kv_write(n, &length) == key) return n;
+    }
+    return 0;
+}
+
+/* Stored value of key is write n */
+static bool_t kv_equal(uint16_t key, uint32_t n){
+    uint8_t value[KV_LENGTH_MAX];
+    uint16_t length = 0, storedLength;
+    const uint8_t *stored = CO_FlashKV_find(key, &storedLength);
+
+    if(n != 0){
+        kv_write(n, &length);
+        kv_value(n, value, length);
+    }
+    if(length == 0){
+        return (stored == NULL) ? true : false;
+    }
+    return (stored != NULL && storedLength == length && memcmp(stored, value, length) == 0) ? true : false;
+}
+
+static void kv_check(const char *name, uint32_t n){
+    uint16_t key;
+
+    for(key = 0; key < KV_KEYS; key++){
+        if(!kv_equal(key, kv_lastWrite(key, n))){
+            kv_fail(name, "stored value differs", n);
+        }
+    }
+}
+
+/* Erase count of the pages with magic, from the page headers */
+static void kv_eraseCounts(void){
+    uint32_t p;
+
+    for(p = 0; p < CO_FLASHKV_PAGES; p++){
+        const uint32_t *header = (const uint32_t *)(uintptr_t)(CO_FLASHKV_ADDRESS + p * CO_FLASHKV_PAGE_SIZE);
+        kvShared->eraseCount[p] = (header[2] >> 16 == 0x564BU) ? header[0] : 0U;
+    }
+}
+
+
+/* Power cycles ***************************************************************/
+/* CO_FlashInit() of the firmware, then writes kvFirst to kvLast, each read back */
+static void kv_run(void){
+    uint8_t value[KV_LENGTH_MAX];
+    uint32_t n;
+
+    if(CO_FlashKV_init() != CO_ERROR_NO){
+        kv_fail("power_on", "CO_FlashKV_init() failed", kvFirst);
+    }
+    kv_check("power_on", kvFirst - 1U);
+
+    for(n = kvFirst; n <= kvLast; n++){
+        uint16_t length;
+        uint16_t key = kv_write(n, &length);
+
+        kv_value(n, value, length);
+        if(CO_FlashKV_write(key, (length != 0) ? value : NULL, length) != CO_ERROR_NO){
+            kv_fail("write", "CO_FlashKV_write() failed", n);
+        }
+        kvShared->completed = n;
+        kv_check("write", n);
+    }
+    kv_eraseCounts();
+}
+
+/* Power on after a cut inside write n: earlier writes are kept, write n is
+ * complete or ignored */
+static void kv_powerOnAfterCut(void){
+    uint32_t n = kvFirst;
+    uint16_t length, key = kv_write(n, &length);
+    uint16_t k;
+
+    if(CO_FlashKV_init() != CO_ERROR_NO){
+        kv_fail("power_cut", "CO_FlashKV_init() failed", n);
+    }
+    for(k = 0; k < KV_KEYS; k++){
+        if(!kv_equal(k, kv_lastWrite(k, n - 1U)) && (k != key || !kv_equal(k, n))){
+            kv_fail("power_cut", "completed write lost or interrupted write broken", n);
+        }
+    }
+    kvShared->interruptedKept = kv_equal(key, n);
+}
+
+static CO_flashSimEnd_t kv_powerCycle(uint32_t first, uint32_t last){
+    kvFirst = first;
+    kvLast = last;
+    return CO_flashSimRun(kv_run);
+}
+
+
+/* Endurance ******************************************************************/
+static void kv_testEndurance(void){
+    uint32_t n = 1, cycles = 0, p, eraseMin = UINT32_MAX, eraseMax = 0;
+    double writesPerErase, lifetime;
+
+    CO_flashSimErase(CO_FLASHKV_ADDRESS, KV_AREA_SIZE);
+    memset(CO_flashSimStats, 0, sizeof(*CO_flashSimStats));
+
+    while(CO_flashSimStats->erases < KV_ENDURANCE_ERASES){
+        if(kv_powerCycle(n, n + KV_POWER_CYCLE_WRITES - 1U) != CO_FLASH_SIM_DONE){
+            kv_fail("endurance", "power cycle failed", n);
+        }
+        n += KV_POWER_CYCLE_WRITES;
+        cycles++;
+    }
+    if(kv_powerCycle(n, n - 1U) != CO_FLASH_SIM_DONE){
+        kv_fail("endurance", "power on failed", n);
+    }
+    if(CO_flashSimStats->pgErrors != 0){
+        kv_fail("endurance", "program of a halfword, which is not erased", n);
+    }
+
+    for(p = 0; p < CO_FLASHKV_PAGES; p++){
+        if(kvShared->eraseCount[p] < eraseMin) eraseMin = kvShared->eraseCount[p];
+        if(kvShared->eraseCount[p] > eraseMax) eraseMax = kvShared->eraseCount[p];
+    }
+    if(eraseMax - eraseMin > 1U){
+        kv_fail("endurance", "erases are not spread over the pages", n);
+    }
+
+    /* worn out, when the most used page reaches the endurance */
+    writesPerErase = (double)(n - 1U) / CO_flashSimStats->erases;
+    lifetime = writesPerErase * KV_FLASH_CYCLES * CO_FLASHKV_PAGES;
+    printf("endurance: %u writes, %u power cycles, %u pages of %u bytes, values %u, %u, 4 and 2 bytes\n",
+           (unsigned)(n - 1U), (unsigned)cycles, (unsigned)CO_FLASHKV_PAGES, (unsigned)CO_FLASHKV_PAGE_SIZE,
+           (unsigned)sizeof(CO_OD_ROM), (unsigned)sizeof(CO_OD_EEPROM));
+    printf("  page erases           %5u (page headers", (unsigned)CO_flashSimStats->erases);
+    for(p = 0; p < CO_FLASHKV_PAGES; p++){
+        printf(" %u", (unsigned)kvShared->eraseCount[p]);
+    }
+    printf("), %.1f writes per erase, %u halfwords programmed\n",
+           writesPerErase, (unsigned)CO_flashSimStats->programs);
+    printf("  lifetime               %.0f writes at %u erase cycles, %.0f days of autosave every %u s\n",
+           lifetime, (unsigned)KV_FLASH_CYCLES, lifetime * KV_AUTOSAVE_S / 86400.0, (unsigned)KV_AUTOSAVE_S);
+}
+
+
+/* Power cut ******************************************************************/
+static uint8_t              kvArea[KV_AREA_SIZE];   /* before the cuts */
+static uint32_t             kvKept;
+
+/* Cut inside operation k of writes first to last, then power on and the rest
+ * of the writes. Returns erases up to and with operation k. */
+static uint32_t kv_cut(uint32_t k, uint32_t seed, uint32_t first, uint32_t last){
+    uint32_t n, erases;
+
+    CO_flashSimLoad(CO_FLASHKV_ADDRESS, kvArea, KV_AREA_SIZE);
+    memset(CO_flashSimStats, 0, sizeof(*CO_flashSimStats));
+    kvShared->completed = first - 1U;
+    CO_flashSimStats->cutAt = k;
+    CO_flashSimStats->cutSeed = seed;
+    if(kv_powerCycle(first, last) != CO_FLASH_SIM_CUT){
+        kv_fail("power_cut", "operation of the cut not reached", first);
+    }
+    erases = CO_flashSimStats->erases;
+    CO_flashSimStats->cutAt = 0;
+
+    /* interrupted write, then the rest of them */
+    n = kvShared->completed + 1U;
+    kvFirst = n;
+    if(CO_flashSimRun(kv_powerOnAfterCut) != CO_FLASH_SIM_DONE){
+        kv_fail("power_cut", "power on failed", n);
+    }
+    if(kvShared->interruptedKept){
+        kvKept++;
+        n++;
+    }
+    if(kv_powerCycle(n, last) != CO_FLASH_SIM_DONE || kv_powerCycle(last + 1U, last) != CO_FLASH_SIM_DONE){
+        kv_fail("power_cut", "writes after power cut failed", n);
+    }
+    return erases;
+}
+
+static void kv_testPowerCut(void){
+    uint32_t first = KV_CUT_PRE_WRITES + 1U, last = KV_CUT_PRE_WRITES + KV_CUT_WRITES;
+    uint32_t ops, erases, k, seed, cuts = 0, erasesBefore = 0;
+
+    CO_flashSimErase(CO_FLASHKV_ADDRESS, KV_AREA_SIZE);
+    if(kv_powerCycle(1, KV_CUT_PRE_WRITES) != CO_FLASH_SIM_DONE){
+        kv_fail("power_cut", "writes before the cuts failed", 1);
+    }
+    memcpy(kvArea, (const void *)(uintptr_t)CO_FLASHKV_ADDRESS, KV_AREA_SIZE);
+
+    /* operations of the writes */
+    memset(CO_flashSimStats, 0, sizeof(*CO_flashSimStats));
+    if(kv_powerCycle(first, last) != CO_FLASH_SIM_DONE){
+        kv_fail("power_cut", "writes failed", first);
+    }
+    ops = CO_flashSimStats->ops;
+    erases = CO_flashSimStats->erases;
+
+    kvKept = 0;
+    for(k = 1; k <= ops; k++){
+        uint32_t erasesCut = kv_cut(k, 0, first, last);
+
+        cuts++;
+        if(erasesCut > erasesBefore){
+            /* operation k is an erase */
+            for(seed = 1; seed < KV_CUT_ERASE_SEEDS; seed++){
+                kv_cut(k, seed, first, last);
+                cuts++;
+            }
+        }
+        erasesBefore = erasesCut;
+    }
+
+    printf("power_cut: %u operations in %u writes with %u compactions, %u cuts,"
+           " interrupted write complete %u, ignored %u\n",
+           (unsigned)ops, (unsigned)KV_CUT_WRITES, (unsigned)erases, (unsigned)cuts,
+           (unsigned)kvKept, (unsigned)(cuts - kvKept));
+}
+
+
+/* Main ***********************************************************************/
+typedef struct{
+    const char         *name;
+    void              (*run)(void);
+}kv_test_t;
+
+static const kv_test_t tests[] = {
+    {"endurance",       kv_testEndurance},
+    {"power_cut",       kv_testPowerCut}
+};
+
+int main(int argc, char *argv[]){
+    const char *filter = NULL;
+    unsigned i;
+    int c;
+
+    while((c = getopt(argc, argv, "f:")) != -1){
+        switch(c){
+            case 'f': filter = optarg; break;
+            default:
+                fprintf(stderr, "Usage: %s [-f name filter]\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    CO_flashSimInit();
+    kvShared = mmap(NULL, sizeof(*kvShared), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if(kvShared == MAP_FAILED){
+        perror("CO_kvTest: mmap");
+        return EXIT_FAILURE;
+    }
+
+    for(i = 0; i < sizeof(tests) / sizeof(tests[0]); i++){
+        if(filter != NULL && strstr(tests[i].name, filter) == NULL) continue;
+        tests[i].run();
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,401 @@
+/*
+ * Host tests of the Modbus slave address and the synchronized setpoints of a
+ * multi-drop bus, against a model of the flash.
+ *
+ * @file        CO_mbTest.c
+ * @author      Janez Paternoster
+ * @copyright   2015 Janez Paternoster
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/* MotorControl/user/ModbusClient.c, crc16.c and stack/STM32F3/CO_FlashKV.c
+ * are compiled unchanged against flashtest/CO_flashSim.h. Each drive is a
+ * power cycle of the flash model with its own key-value area. It receives
+ * every frame of the bus and answers as main() of the firmware: the reply of
+ * RtuModbusParse() is sent only for MB_NO_ERR. Drives do not see the replies
+ * of each other, so they run one after the other through the same frames,
+ * and the replies of one frame are collected over all of them.
+ *
+ * address: each drive alone on the bus gets its address with a unicast write
+ *     of MB_REG_SLAVE_ADDR to the default address 1. The reply comes from
+ *     address 1, after power on the drive answers at the new address.
+ * multi_drop: MB_SLAVES drives with the addresses of the address test. A
+ *     broadcast vector of setpoints alone starts no ramp, the trigger alone
+ *     starts all staged ramps, one broadcast frame of trigger and vector
+ *     updates and starts all drives. No drive answers a broadcast, one
+ *     drive answers each unicast read. Broadcast of the address, unicast of
+ *     the address with the motor running and a frame with a bad CRC change
+ *     nothing. */
+
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "CANopen.h"
+#include "CO_Flash.h"
+#include "CO_FlashKV.h"
+#include "crc16.h"
+#include "ModbusClient.h"
+#include "frame_communication_link_protocol.h"
+
+
+#define MB_SLAVES               16U
+#define MB_FRAMES_MAX           64U
+#define MB_BAUD                 9600U   /* MX_USART1_UART_Init(), 8N1 */
+#define MB_AREA_SIZE            (CO_FLASHKV_PAGES * CO_FLASHKV_PAGE_SIZE)
+
+
+/* Frame on the bus and the state of the drives, while it is received */
+typedef struct{
+    const char         *what;
+    uint8_t             data[FCLP_MAX_PAYLOAD_SIZE];
+    uint16_t            length;
+    bool_t              running;        /* motor of the drives is running */
+}mb_frame_t;
+
+/* Reply and ramp of each drive to each frame, shared with the power cycles */
+typedef struct{
+    uint8_t             replyFrom[MB_FRAMES_MAX][MB_SLAVES];    /* 0 no reply */
+    bool_t              ramp[MB_FRAMES_MAX][MB_SLAVES];
+    int16_t             rampSpeed[MB_FRAMES_MAX][MB_SLAVES];
+    uint16_t            rampMs[MB_FRAMES_MAX][MB_SLAVES];
+    uint8_t             address[MB_SLAVES];                     /* after power on */
+}mb_shared_t;
+
+static mb_shared_t         *mbShared;
+static mb_frame_t           mbFrames[MB_FRAMES_MAX];
+static unsigned             mbFrameCount;
+static uint8_t              mbArea[MB_SLAVES][MB_AREA_SIZE];    /* flash of each drive */
+
+/* Drive of the power cycle and the frame it receives */
+static unsigned             mbSlave;
+static unsigned             mbFrame;
+static uint32_t             mbTick;
+
+/* Firmware objects used by ModbusClient.c */
+static MCI_Handle_t         mbMCI;
+static MCI_Handle_t        *mbMCIList[1] = {&mbMCI};
+static MCP_Handle_t         mbMCP = {._Super = {.pMCI = mbMCIList}};
+extern uint8_t              mbAddr;
+
+
+/* Helpers ********************************************************************/
+static void mb_fail(const char *name, const char *what, unsigned slave){
+    fprintf(stderr, "CO_mbTest: %s: %s, drive %u\n", name, what, slave + 1U);
+    exit(EXIT_FAILURE);
+}
+
+uint32_t HAL_GetTick(void){
+    return mbTick++;
+}
+
+State_t MCI_GetSTMStateMotor1(void){
+    return mbFrames[mbFrame].running ? RUN : IDLE;
+}
+
+void MCI_ExecSpeedRamp(MCI_Handle_t *pHandle, int16_t hFinalSpeed, uint16_t hDurationms){
+    mbShared->ramp[mbFrame][mbSlave] = true;
+    mbShared->rampSpeed[mbFrame][mbSlave] = hFinalSpeed;
+    mbShared->rampMs[mbFrame][mbSlave] = hDurationms;
+}
+
+int32_t UI_GetReg(UI_Handle_t *pHandle, MC_Protocol_REG_t bRegID){
+    return 0x12345600 + (int32_t)bRegID;
+}
+
+bool UI_SetReg(UI_Handle_t *pHandle, MC_Protocol_REG_t bRegID, int32_t wValue){
+    return true;
+}
+
+/* New frame with the CRC of crc16.c */
+static mb_frame_t *mb_frame(const char *what, bool_t running, const uint8_t *data, uint16_t length){
+    mb_frame_t *frame = &mbFrames[mbFrameCount++];
+    uint16_t crc = crc16(data, length);
+
+    frame->what = what;
+    frame->running = running;
+    memcpy(frame->data, data, length);
+    frame->data[length] = (uint8_t)crc;
+    frame->data[length + 1U] = (uint8_t)(crc >> 8);
+    frame->length = length + 2U;
+    return frame;
+}
+
+/* FC16 of count 32 bit values from register reg */
+static mb_frame_t *mb_write(const char *what, bool_t running, uint8_t address, uint16_t reg,
+                            const uint32_t *values, uint16_t count){
+    uint8_t data[FCLP_MAX_PAYLOAD_SIZE];
+    uint16_t i, length = 7;
+
+    data[0] = address;
+    data[1] = 16;
+    data[2] = (uint8_t)(reg >> 8);
+    data[3] = (uint8_t)reg;
+    data[4] = (uint8_t)((count * 2U) >> 8);
+    data[5] = (uint8_t)(count * 2U);
+    data[6] = (uint8_t)(count * 4U);
+    for(i = 0; i < count; i++){
+        data[length++] = (uint8_t)(values[i] >> 24);
+        data[length++] = (uint8_t)(values[i] >> 16);
+        data[length++] = (uint8_t)(values[i] >> 8);
+        data[length++] = (uint8_t)values[i];
+    }
+    return mb_frame(what, running, data, length);
+}
+
+/* FC03 of one 32 bit value from register reg */
+static mb_frame_t *mb_read(const char *what, uint8_t address, uint16_t reg){
+    uint8_t data[6] = {address, 3, (uint8_t)(reg >> 8), (uint8_t)reg, 0, 2};
+
+    return mb_frame(what, false, data, sizeof(data));
+}
+
+/* Replies to frame n over all drives, *from the last one */
+static unsigned mb_replies(unsigned n, uint8_t *from){
+    unsigned slave, replies = 0;
+
+    for(slave = 0; slave < MB_SLAVES; slave++){
+        if(mbShared->replyFrom[n][slave] != 0){
+            *from = mbShared->replyFrom[n][slave];
+            replies++;
+        }
+    }
+    return replies;
+}
+
+static unsigned mb_ramps(unsigned n){
+    unsigned slave, ramps = 0;
+
+    for(slave = 0; slave < MB_SLAVES; slave++){
+        if(mbShared->ramp[n][slave]) ramps++;
+    }
+    return ramps;
+}
+
+static double mb_frameMs(const mb_frame_t *frame){
+    return frame->length * 10.0 * 1000.0 / MB_BAUD;
+}
+
+
+/* Power cycles ***************************************************************/
+/* main() of the firmware: flash store, ModBus_CFGInit() and the frames */
+static void mb_run(void){
+    uint8_t rx[FCLP_MAX_PAYLOAD_SIZE], tx[FCLP_MAX_PAYLOAD_SIZE];
+
+    if(CO_FlashKV_init() != CO_ERROR_NO){
+        mb_fail("power_on", "CO_FlashKV_init() failed", mbSlave);
+    }
+    ModBus_CFGInit();
+    mbShared->address[mbSlave] = mbAddr;
+
+    for(mbFrame = 0; mbFrame < mbFrameCount; mbFrame++){
+        uint16_t length = mbFrames[mbFrame].length;
+
+        memcpy(rx, mbFrames[mbFrame].data, length);
+        if(RtuModbusParse(&mbMCP, rx, tx, &length, FCLP_MAX_PAYLOAD_SIZE) == MB_NO_ERR){
+            if(length < 4U || crc16(tx, length - 2U) != (uint16_t)(tx[length - 2U] | (tx[length - 1U] << 8))){
+                mb_fail(mbFrames[mbFrame].what, "reply with a bad CRC", mbSlave);
+            }
+            mbShared->replyFrom[mbFrame][mbSlave] = tx[0];
+        }
+    }
+}
+
+/* Drive slave on the bus with the frames of mbFrames, its flash is kept */
+static void mb_powerCycle(unsigned slave){
+    mbSlave = slave;
+    CO_flashSimLoad(CO_FLASHKV_ADDRESS, mbArea[slave], MB_AREA_SIZE);
+    if(CO_flashSimRun(mb_run) != CO_FLASH_SIM_DONE){
+        mb_fail("power_cycle", "drive did not return", slave);
+    }
+    CO_flashSimSync();
+    memcpy(mbArea[slave], (const void *)(uintptr_t)CO_FLASHKV_ADDRESS, MB_AREA_SIZE);
+}
+
+static void mb_clear(void){
+    memset(mbShared, 0, sizeof(*mbShared));
+    mbFrameCount = 0;
+}
+
+
+/* Address ********************************************************************/
+static void mb_testAddress(void){
+    unsigned slave;
+    uint8_t from = 0;
+
+    for(slave = 0; slave < MB_SLAVES; slave++){
+        uint32_t address = slave + 1U;
+
+        memset(mbArea[slave], 0xFF, MB_AREA_SIZE);
+        mb_clear();
+        mb_write("address", false, 1, MB_REG_SLAVE_ADDR, &address, 1);
+        mb_powerCycle(slave);
+        if(mbShared->address[slave] != 1U || mb_replies(0, &from) != 1U || from != 1U){
+            mb_fail("address", "no reply from the default address 1", slave);
+        }
+
+        mb_clear();
+        mb_read("read", (uint8_t)address, 0);
+        mb_powerCycle(slave);
+        if(mbShared->address[slave] != address || mb_replies(0, &from) != 1U || from != address){
+            mb_fail("address", "new address not kept over power on", slave);
+        }
+    }
+    printf("address: %u drives alone on the bus, address 1 -> n, reply from 1,"
+           " after power on at n\n", (unsigned)MB_SLAVES);
+}
+
+
+/* Multi-drop *****************************************************************/
+static void mb_testMultiDrop(void){
+    uint32_t vector[2U + 2U * MB_SLAVES];
+    unsigned slave, n, replies = 0;
+    unsigned stage, trigger, sync, unicast, broadcastAddress, busy, busyRead, badCrc;
+    mb_frame_t *frame;
+    uint8_t from = 0;
+
+    mb_clear();
+    /* vector alone, 100 rpm per address, values and trigger are 32 bit */
+    for(slave = 0; slave < MB_SLAVES; slave++){
+        vector[1U + slave] = 100U * (slave + 1U);
+    }
+    stage = mbFrameCount;
+    mb_write("vector", false, BROADCAST_ADDRESS, MB_REG_SETPOINT_BASE, &vector[1], MB_SLAVES);
+    trigger = mbFrameCount;
+    vector[0] = 500;
+    mb_write("trigger", false, BROADCAST_ADDRESS, MB_REG_SYNC_TRIGGER, vector, 1);
+    /* trigger and vector in one frame, 200 rpm per address */
+    vector[0] = 1000;
+    for(slave = 0; slave < MB_SLAVES; slave++){
+        vector[1U + slave] = 200U * (slave + 1U);
+    }
+    sync = mbFrameCount;
+    frame = mb_write("trigger and vector", true, BROADCAST_ADDRESS, MB_REG_SYNC_TRIGGER, vector, 1U + MB_SLAVES);
+    unicast = mbFrameCount;
+    for(slave = 0; slave < MB_SLAVES; slave++){
+        mb_read("unicast read", (uint8_t)(slave + 1U), 0);
+    }
+    broadcastAddress = mbFrameCount;
+    vector[0] = 5;
+    mb_write("broadcast address", false, BROADCAST_ADDRESS, MB_REG_SLAVE_ADDR, vector, 1);
+    busy = mbFrameCount;
+    vector[0] = 20;
+    mb_write("address while running", true, 3, MB_REG_SLAVE_ADDR, vector, 1);
+    busyRead = mbFrameCount;
+    mb_read("read after busy", 3, 0);
+    badCrc = mbFrameCount;
+    vector[0] = 0;
+    mb_write("bad CRC", false, BROADCAST_ADDRESS, MB_REG_SYNC_TRIGGER, vector, 1U + MB_SLAVES)->data[9] ^= 0x01;
+
+    for(slave = 0; slave < MB_SLAVES; slave++){
+        mb_powerCycle(slave);
+    }
+
+    for(n = 0; n < mbFrameCount; n++){
+        unsigned count = mb_replies(n, &from);
+
+        if(count > 1U){
+            mb_fail(mbFrames[n].what, "replies collide on the bus", 0);
+        }
+        replies += count;
+    }
+    for(slave = 0; slave < MB_SLAVES; slave++){
+        if(mbShared->ramp[stage][slave]){
+            mb_fail("vector", "ramp started without trigger", slave);
+        }
+        if(!mbShared->ramp[trigger][slave] || mbShared->rampMs[trigger][slave] != 500U
+           || mbShared->rampSpeed[trigger][slave] != (int16_t)(100 * (slave + 1U) / 6)){
+            mb_fail("trigger", "staged setpoint not started", slave);
+        }
+        if(!mbShared->ramp[sync][slave] || mbShared->rampMs[sync][slave] != 1000U
+           || mbShared->rampSpeed[sync][slave] != (int16_t)(200 * (slave + 1U) / 6)){
+            mb_fail("trigger and vector", "own setpoint not started", slave);
+        }
+        if(mb_replies(unicast + slave, &from) != 1U || from != slave + 1U){
+            mb_fail("unicast read", "no reply from the addressed drive", slave);
+        }
+        if(mbShared->address[slave] != slave + 1U){
+            mb_fail("multi_drop", "address changed", slave);
+        }
+    }
+    if(mb_replies(broadcastAddress, &from) != 0U || mb_replies(busy, &from) != 0U
+       || mb_replies(busyRead, &from) != 1U || from != 3U || mb_ramps(badCrc) != 0U){
+        mb_fail("multi_drop", "address changed, or a bad frame taken", 0);
+    }
+    for(n = 0; n < mbFrameCount; n++){
+        if(mbFrames[n].data[0] == BROADCAST_ADDRESS && mb_replies(n, &from) != 0U){
+            mb_fail(mbFrames[n].what, "broadcast answered", 0);
+        }
+    }
+
+    printf("multi_drop: %u drives, %u frames, %u replies, none to a broadcast\n",
+           (unsigned)MB_SLAVES, mbFrameCount, replies);
+    printf("  vector alone           %u ramps\n", mb_ramps(stage));
+    printf("  trigger alone          %u ramps of the staged setpoints\n", mb_ramps(trigger));
+    printf("  trigger and vector     %u ramps from one frame of %u bytes, %.1f ms at %u baud\n",
+           mb_ramps(sync), (unsigned)frame->length, mb_frameMs(frame), (unsigned)MB_BAUD);
+    printf("  address write          broadcast and while running refused, addresses kept\n");
+}
+
+
+/* Main ***********************************************************************/
+typedef struct{
+    const char         *name;
+    void              (*run)(void);
+}mb_test_t;
+
+static const mb_test_t tests[] = {
+    {"address",         mb_testAddress},
+    {"multi_drop",      mb_testMultiDrop}
+};
+
+int main(int argc, char *argv[]){
+    const char *filter = NULL;
+    unsigned i;
+    int c;
+
+    while((c = getopt(argc, argv, "f:")) != -1){
+        switch(c){
+            case 'f': filter = optarg; break;
+            default:
+                fprintf(stderr, "Usage: %s [-f name filter]\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    CO_flashSimInit();
+    mbShared = mmap(NULL, sizeof(*mbShared), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if(mbShared == MAP_FAILED){
+        perror("CO_mbTest: mmap");
+        return EXIT_FAILURE;
+    }
+
+    /* multi_drop takes the addresses of address */
+    for(i = 0; i < sizeof(tests) / sizeof(tests[0]); i++){
+        if(filter != NULL && strstr(tests[i].name, filter) == NULL && strcmp(tests[i].name, "address") != 0) continue;
+        tests[i].run();
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,493 @@
+/*
+ * Host test of the vintage LCD user interface on a framebuffer model of the
+ * eval board LCD.
+ *
+ * @file        CO_lcdTest.c
+ * @author      Janez Paternoster
+ * @copyright   2015 Janez Paternoster
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/* lcd_vintage_ui.c is included unchanged, its screen shadow functions are
+ * static. pid_regulator.c is linked, the eval board BSP is
+ * lcdtest/stm32_eval.h. The motor control interface, flux
+ * weakening, sensors, DAC and debounce time base are fakes returning the
+ * values of lcdMotor. A frame is one LCDV_Exec() call.
+ *
+ * The panel is 240 lines of 320 RGB565 pixels. LCD_DisplayChar() draws a
+ * 16 x 24 cell from its Column toward lower columns, a pattern of the
+ * character in the text color on the back color. LCD_DrawRect() draws as
+ * the eval board driver, from Ypos to Ypos - Width + 1 and from Xpos to
+ * Xpos + Height. Every pixel written costs 2 bytes on the LCD bus.
+ *
+ * After each frame the panel must equal the panel after LCDV_UpdateAll()
+ * and one more frame, which sends every cell and decimal point again.
+ *
+ * refresh: pixels and bytes of the welcome screen, of the first frame of
+ *     the speed view, of a frame without change, of a one digit change and
+ *     of LCDV_UpdateAll().
+ * decimal_point: the flux weakening view draws a decimal point in lines 6
+ *     and 7, the I_VOLT menu changes the color of one of them. LEFT goes to
+ *     the flux view with the same digits under both points. Display_LCD()
+ *     writes the labels of a view over these cells first, so they are sent
+ *     anyway. The same digits are then put into the shadow without labels
+ *     and without the points: only the 4 cells under the points are sent. */
+
+
+#include "lcd_vintage_ui.c"
+#include "mc_interface.h"
+#include "mc_tuning.h"
+#include "flux_weakening_ctrl.h"
+#include "stm32_eval.h"
+#include "Timebase.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+#define LCD_PANEL_LINES         240U
+#define LCD_PANEL_COLUMNS       320U
+#define LCD_CHAR_WIDTH          16U
+#define LCD_CHAR_HEIGHT         24U
+#define LCD_BYTES_PER_PIXEL     2U
+
+
+typedef struct{
+    State_t             state;
+    int16_t             speed01Hz;
+    int16_t             targetSpeed01Hz;
+    Curr_Components     iqd;
+    Curr_Components     iqdref;
+    uint16_t            fwVref;
+    uint16_t            fwAvV;
+    uint16_t            busVoltage;
+    int16_t             temperature;
+}lcd_motor_t;
+
+typedef struct{
+    uint32_t            chars;
+    uint32_t            rects;
+    uint32_t            pixels;
+}lcd_stats_t;
+
+
+GPIO_TypeDef            CO_lcdKeyPort;
+
+static uint16_t         lcdPanel[LCD_PANEL_LINES][LCD_PANEL_COLUMNS];
+static uint16_t         lcdShown[LCD_PANEL_LINES][LCD_PANEL_COLUMNS];
+static uint16_t         lcdTextColor;
+static uint16_t         lcdBackColor;
+static lcd_stats_t      lcdStats;
+static Button_TypeDef   lcdButton;
+static lcd_motor_t      lcdMotor;
+
+static LCDV_Handle_t    lcdUI;
+static DAC_UI_Handle_t  lcdDAC;
+static MCI_Handle_t     lcdMCI;
+static MCT_Handle_t     lcdMCT;
+static MCI_Handle_t    *lcdMCIList[1] = {&lcdMCI};
+static MCT_Handle_t    *lcdMCTList[1] = {&lcdMCT};
+static PID_Handle_t     lcdPIDSpeed, lcdPIDIq, lcdPIDId, lcdPIDFW;
+static FW_Handle_t      lcdFW;
+static SpeednTorqCtrl_Handle_t lcdSTC;
+static NTC_Handle_t     lcdNTC;
+static BusVoltageSensor_Handle_t lcdVBS;
+
+
+/* Helpers ********************************************************************/
+static void lcd_fail(const char *name, const char *what){
+    fprintf(stderr, "CO_lcdTest: %s: %s\n", name, what);
+    exit(EXIT_FAILURE);
+}
+
+static void lcd_pixel(int32_t line, int32_t column, uint16_t color){
+    if(line >= 0 && line < (int32_t)LCD_PANEL_LINES && column >= 0 && column < (int32_t)LCD_PANEL_COLUMNS){
+        lcdPanel[line][column] = color;
+    }
+    lcdStats.pixels++;
+}
+
+
+/* Eval board LCD *************************************************************/
+void LCD_HW_Init(void){
+}
+
+void LCD_Clear(uint16_t Color){
+    uint32_t line, column;
+
+    for(line = 0; line < LCD_PANEL_LINES; line++){
+        for(column = 0; column < LCD_PANEL_COLUMNS; column++){
+            lcd_pixel(line, column, Color);
+        }
+    }
+}
+
+void LCD_SetTextColor(uint16_t Color){
+    lcdTextColor = Color;
+}
+
+void LCD_SetBackColor(uint16_t Color){
+    lcdBackColor = Color;
+}
+
+uint8_t LCD_GetXAxesDirection(void){
+    return LCD_X_AXES_INVERTED;
+}
+
+void LCD_DisplayChar(uint16_t Line, uint16_t Column, uint8_t Ascii){
+    uint32_t y, x;
+    int set;
+
+    for(y = 0; y < LCD_CHAR_HEIGHT; y++){
+        for(x = 0; x < LCD_CHAR_WIDTH; x++){
+            set = Ascii != ' ' && (Ascii * 7U + y * 3U + x * 5U) % 4U == 0U;
+            lcd_pixel((int32_t)Line + y, (int32_t)Column - x, set ? lcdTextColor : lcdBackColor);
+        }
+    }
+    lcdStats.chars++;
+}
+
+void LCD_DrawRect(uint16_t Xpos, uint16_t Ypos, uint8_t Height, uint16_t Width){
+    uint32_t i;
+
+    for(i = 0; i < Width; i++){
+        lcd_pixel(Xpos, (int32_t)Ypos - i, lcdTextColor);
+        lcd_pixel(Xpos + Height, (int32_t)Ypos - i, lcdTextColor);
+    }
+    for(i = 0; i < Height; i++){
+        lcd_pixel(Xpos + i, Ypos, lcdTextColor);
+        lcd_pixel(Xpos + i, (int32_t)Ypos - Width + 1, lcdTextColor);
+    }
+    lcdStats.rects++;
+}
+
+
+/* Joystick and time base *****************************************************/
+void STM_EVAL_JOYInit(void){
+}
+
+uint32_t STM_EVAL_PBGetState(Button_TypeDef Button){
+    return (Button == lcdButton) ? JOYSTIK_ACTIVE : 0U;
+}
+
+void TB_Set_DebounceDelay_500us(uint8_t hDelay){
+}
+
+bool TB_DebounceDelay_IsElapsed(void){
+    return true;
+}
+
+
+/* Motor control **************************************************************/
+State_t MCI_GetSTMState(MCI_Handle_t *pHandle){
+    return lcdMotor.state;
+}
+
+uint16_t MCI_GetOccurredFaults(MCI_Handle_t *pHandle){
+    return 0;
+}
+
+uint16_t MCI_GetCurrentFaults(MCI_Handle_t *pHandle){
+    return 0;
+}
+
+STC_Modality_t MCI_GetControlMode(MCI_Handle_t *pHandle){
+    return STC_SPEED_MODE;
+}
+
+int16_t MCI_GetAvrgMecSpeed01Hz(MCI_Handle_t *pHandle){
+    return lcdMotor.speed01Hz;
+}
+
+int16_t MCI_GetLastRampFinalSpeed(MCI_Handle_t *pHandle){
+    return lcdMotor.targetSpeed01Hz;
+}
+
+Curr_Components MCI_GetIqd(MCI_Handle_t *pHandle){
+    return lcdMotor.iqd;
+}
+
+Curr_Components MCI_GetIqdref(MCI_Handle_t *pHandle){
+    return lcdMotor.iqdref;
+}
+
+void MCI_ExecSpeedRamp(MCI_Handle_t *pHandle, int16_t hFinalSpeed, uint16_t hDurationms){
+}
+
+void MCI_SetCurrentReferences(MCI_Handle_t *pHandle, Curr_Components Iqdref){
+}
+
+bool MCI_StartMotor(MCI_Handle_t *pHandle){
+    return true;
+}
+
+bool MCI_StopMotor(MCI_Handle_t *pHandle){
+    return true;
+}
+
+bool MCI_FaultAcknowledged(MCI_Handle_t *pHandle){
+    return true;
+}
+
+Curr_Components STC_GetDefaultIqdref(SpeednTorqCtrl_Handle_t *pHandle){
+    Curr_Components iqdref = {0, 0};
+
+    return iqdref;
+}
+
+uint16_t FW_GetVref(FW_Handle_t *pHandle){
+    return lcdMotor.fwVref;
+}
+
+void FW_SetVref(FW_Handle_t *pHandle, uint16_t hNewVref){
+    lcdMotor.fwVref = hNewVref;
+}
+
+uint16_t FW_GetAvVPercentage(FW_Handle_t *pHandle){
+    return lcdMotor.fwAvV;
+}
+
+uint16_t VBS_GetAvBusVoltage_V(BusVoltageSensor_Handle_t *pHandle){
+    return lcdMotor.busVoltage;
+}
+
+int16_t NTC_GetAvTemp_C(NTC_Handle_t *pHandle){
+    return lcdMotor.temperature;
+}
+
+MC_Protocol_REG_t UI_GetDAC(UI_Handle_t *pHandle, DAC_Channel_t bChannel){
+    return MC_PROTOCOL_REG_UNDEFINED;
+}
+
+void UI_SetDAC(UI_Handle_t *pHandle, DAC_Channel_t bChannel, MC_Protocol_REG_t bVariable){
+}
+
+int32_t UI_GetReg(UI_Handle_t *pHandle, MC_Protocol_REG_t bRegID){
+    return 0;
+}
+
+bool UI_SetReg(UI_Handle_t *pHandle, MC_Protocol_REG_t bRegID, int32_t wValue){
+    return true;
+}
+
+
+/* Frames *********************************************************************/
+static void lcd_init(void){
+    memset(&lcdMotor, 0, sizeof(lcdMotor));
+    lcdMotor.state = IDLE;
+    lcdButton = BUTTON_NONE;
+    CO_lcdKeyPort.IDR = KEY_BUTTON_PIN;
+
+    memset(&lcdMCT, 0, sizeof(lcdMCT));
+    lcdMCT.pPIDSpeed = &lcdPIDSpeed;
+    lcdMCT.pPIDIq = &lcdPIDIq;
+    lcdMCT.pPIDId = &lcdPIDId;
+    lcdMCT.pPIDFluxWeakening = &lcdPIDFW;
+    lcdMCT.pFW = &lcdFW;
+    lcdMCT.pSpeednTorqueCtrl = &lcdSTC;
+    lcdMCT.pTemperatureSensor = &lcdNTC;
+    lcdMCT.pBusVoltageSensor = &lcdVBS;
+    PID_SetKP(&lcdPIDSpeed, 1200);
+    PID_SetKI(&lcdPIDSpeed, 350);
+    PID_SetKP(&lcdPIDIq, 2959);
+    PID_SetKI(&lcdPIDIq, 1000);
+    PID_SetKP(&lcdPIDId, 2959);
+    PID_SetKI(&lcdPIDId, 1000);
+    PID_SetKP(&lcdPIDFW, 3000);
+    PID_SetKI(&lcdPIDFW, 5000);
+
+    memset(&lcdUI, 0, sizeof(lcdUI));
+    lcdUI._Super.bDriveNum = 1;
+    lcdUI._Super.pMCI = lcdMCIList;
+    lcdUI._Super.pMCT = lcdMCTList;
+
+    memset(&lcdStats, 0, sizeof(lcdStats));
+    LCDV_Init(&lcdUI._Super, &lcdDAC._Super, "");
+}
+
+static lcd_stats_t lcd_frame(void){
+    memset(&lcdStats, 0, sizeof(lcdStats));
+    LCDV_Exec(&lcdUI._Super, &lcdDAC._Super);
+    return lcdStats;
+}
+
+/* A frame, which sends every cell and decimal point again, must not change
+ * the panel */
+static void lcd_checkPanel(const char *name){
+    memcpy(lcdShown, lcdPanel, sizeof(lcdPanel));
+    LCDV_UpdateAll(&lcdUI._Super);
+    (void)lcd_frame();
+    if(memcmp(lcdShown, lcdPanel, sizeof(lcdPanel)) != 0){
+        lcd_fail(name, "panel differs from a full repaint");
+    }
+}
+
+/* The key is read after the display, it shows in the frame after release */
+static void lcd_key(const char *name, Button_TypeDef button){
+    lcdButton = button;
+    (void)lcd_frame();
+    lcdButton = BUTTON_NONE;
+    (void)lcd_frame();
+    lcd_checkPanel(name);
+}
+
+static void lcd_print(const char *frame, const lcd_stats_t *stats){
+    printf("  %-22s %4u cells, %u decimal points, %6u pixels, %6u bytes\n", frame,
+           (unsigned)stats->chars, (unsigned)stats->rects, (unsigned)stats->pixels,
+           (unsigned)(stats->pixels * LCD_BYTES_PER_PIXEL));
+}
+
+
+/* Tests **********************************************************************/
+static void lcd_testRefresh(void){
+    const char *name = "refresh";
+    lcd_stats_t stats;
+
+    printf("%s: panel %ux%u, cell %ux%u\n", name, (unsigned)LCD_PANEL_COLUMNS, (unsigned)LCD_PANEL_LINES,
+           (unsigned)LCD_CHAR_WIDTH, (unsigned)LCD_CHAR_HEIGHT);
+    lcd_init();
+    lcd_print("clear and welcome", &lcdStats);
+
+    lcdMotor.targetSpeed01Hz = 1230;
+    lcdMotor.speed01Hz = 1230;
+    stats = lcd_frame();
+    lcd_print("speed view", &stats);
+    lcd_checkPanel(name);
+
+    stats = lcd_frame();
+    lcd_print("no change", &stats);
+    if(stats.chars != 0U || stats.pixels != 0U){
+        lcd_fail(name, "unchanged frame sent to the panel");
+    }
+
+    lcdMotor.speed01Hz = 1231;
+    stats = lcd_frame();
+    lcd_print("one digit", &stats);
+    if(stats.chars != 1U || stats.pixels != LCD_CHAR_WIDTH * LCD_CHAR_HEIGHT){
+        lcd_fail(name, "one digit change not sent as one cell");
+    }
+    lcd_checkPanel(name);
+
+    LCDV_UpdateAll(&lcdUI._Super);
+    stats = lcd_frame();
+    lcd_print("LCDV_UpdateAll", &stats);
+    if(stats.chars != (LCD_PANEL_COLUMNS / LCD_CHAR_WIDTH) * (LCD_PANEL_LINES / LCD_CHAR_HEIGHT)){
+        lcd_fail(name, "LCDV_UpdateAll did not send every cell");
+    }
+}
+
+static void lcd_testDecimalPoint(void){
+    const char *name = "decimal_point";
+    lcd_stats_t stats;
+    int i;
+
+    lcd_init();
+    (void)lcd_frame();
+    lcd_checkPanel(name);
+
+    /* CONTROL_MODE_SPEED to P_VOLT */
+    for(i = 0; i < 8; i++){
+        lcd_key(name, BUTTON_RIGHT);
+    }
+    if(lcdStats.rects != 2U){
+        lcd_fail(name, "flux weakening view without decimal points");
+    }
+    stats = lcd_frame();
+    lcd_print("flux weakening, steady", &stats);
+    if(stats.pixels != 0U){
+        lcd_fail(name, "unchanged decimal points sent to the panel");
+    }
+
+    /* I_VOLT, the point of the target turns blue */
+    lcd_key(name, BUTTON_RIGHT);
+
+    /* I_VOLT to I_FLUX, the cells under the points do not change */
+    lcd_key(name, BUTTON_LEFT);
+    lcd_key(name, BUTTON_LEFT);
+    stats = lcd_frame();
+    lcd_print("flux view, steady", &stats);
+    if(stats.rects != 0U){
+        lcd_fail(name, "decimal point in the flux view");
+    }
+    lcd_checkPanel(name);
+
+    /* Cells under the points do not change, without labels */
+    LCDV_SetTextColor(Blue);
+    Display_5DigitSignedNumber(Line6, CHAR_9, 0);
+    Display_5DigitSignedNumber(Line7, CHAR_9, 0);
+    LCDV_DrawRect(161, 97, 1, 2);
+    LCDV_DrawRect(185, 97, 1, 2);
+    memset(&lcdStats, 0, sizeof(lcdStats));
+    LCDV_Flush();
+    if(lcdStats.chars != 0U || lcdStats.rects != 2U){
+        lcd_fail(name, "new decimal points over unchanged cells not drawn alone");
+    }
+    Display_5DigitSignedNumber(Line6, CHAR_9, 0);
+    Display_5DigitSignedNumber(Line7, CHAR_9, 0);
+    memset(&lcdStats, 0, sizeof(lcdStats));
+    LCDV_Flush();
+    lcd_print("decimal points removed", &lcdStats);
+    if(lcdStats.chars != 4U || lcdStats.rects != 0U){
+        lcd_fail(name, "cells under the removed decimal points not sent");
+    }
+    memcpy(lcdShown, lcdPanel, sizeof(lcdPanel));
+    LCDV_Repaint();
+    LCDV_Flush();
+    if(memcmp(lcdShown, lcdPanel, sizeof(lcdPanel)) != 0){
+        lcd_fail(name, "removed decimal point left on the panel");
+    }
+    printf("decimal_point: panel equal to a full repaint after every frame\n");
+}
+
+
+/* Main ***********************************************************************/
+typedef struct{
+    const char         *name;
+    void              (*run)(void);
+}lcd_test_t;
+
+static const lcd_test_t tests[] = {
+    {"refresh",         lcd_testRefresh},
+    {"decimal_point",   lcd_testDecimalPoint}
+};
+
+int main(int argc, char *argv[]){
+    const char *filter = NULL;
+    unsigned i;
+    int c;
+
+    while((c = getopt(argc, argv, "f:")) != -1){
+        switch(c){
+            case 'f': filter = optarg; break;
+            default:
+                fprintf(stderr, "Usage: %s [-f name filter]\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    for(i = 0; i < sizeof(tests) / sizeof(tests[0]); i++){
+        if(filter != NULL && strstr(tests[i].name, filter) == NULL) continue;
+        tests[i].run();
+    }
+
+    return EXIT_SUCCESS;
+}
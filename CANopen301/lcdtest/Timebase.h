@@ -0,0 +1,40 @@
+/*
+ * Debounce time base of the eval board application as included by the
+ * vintage LCD user interface, see
+ * MotorControl/Applications/Test_MotorApp/Inc/TimeBase.h.
+ *
+ * @file        Timebase.h
+ * @author      Janez Paternoster
+ * @copyright   2015 Janez Paternoster
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+
+#include "mc_type.h"
+
+
+void TB_Set_DebounceDelay_500us(uint8_t hDelay);
+bool TB_DebounceDelay_IsElapsed(void);
+
+
+#endif
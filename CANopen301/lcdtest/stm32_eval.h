@@ -0,0 +1,90 @@
+/*
+ * Eval board LCD, joystick and key button of the vintage LCD user interface
+ * for the host test, see lcdtest/CO_lcdTest.c.
+ *
+ * @file        stm32_eval.h
+ * @author      Janez Paternoster
+ * @copyright   2015 Janez Paternoster
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef STM32_EVAL_H
+#define STM32_EVAL_H
+
+
+#include "stm32f3xx_hal.h"
+
+
+/* LCD, RGB565 colors and text lines of Font16x24 as the eval board
+ * driver */
+#define White                   0xFFFFU
+#define Black                   0x0000U
+#define Red                     0xF800U
+#define Blue                    0x001FU
+
+#define LINE(x)                 ((x) * 24U)
+#define Line0                   LINE(0)
+#define Line1                   LINE(1)
+#define Line2                   LINE(2)
+#define Line3                   LINE(3)
+#define Line4                   LINE(4)
+#define Line5                   LINE(5)
+#define Line6                   LINE(6)
+#define Line7                   LINE(7)
+#define Line8                   LINE(8)
+#define Line9                   LINE(9)
+
+#define LCD_X_AXES_NORMAL       0U
+#define LCD_X_AXES_INVERTED     1U
+
+void LCD_HW_Init(void);
+void LCD_Clear(uint16_t Color);
+void LCD_SetTextColor(uint16_t Color);
+void LCD_SetBackColor(uint16_t Color);
+uint8_t LCD_GetXAxesDirection(void);
+void LCD_DisplayChar(uint16_t Line, uint16_t Column, uint8_t Ascii);
+void LCD_DrawRect(uint16_t Xpos, uint16_t Ypos, uint8_t Height, uint16_t Width);
+
+
+/* Joystick, a pressed button reads JOYSTIK_ACTIVE */
+typedef enum{
+    BUTTON_KEY,
+    BUTTON_SEL,
+    BUTTON_LEFT,
+    BUTTON_RIGHT,
+    BUTTON_UP,
+    BUTTON_DOWN,
+    BUTTON_NONE
+}Button_TypeDef;
+
+#define JOYSTIK_ACTIVE          1U
+
+void STM_EVAL_JOYInit(void);
+uint32_t STM_EVAL_PBGetState(Button_TypeDef Button);
+
+
+/* Key button, active low, on a model of its GPIO port */
+extern GPIO_TypeDef CO_lcdKeyPort;
+
+#define KEY_BUTTON_GPIO_PORT    (&CO_lcdKeyPort)
+#define KEY_BUTTON_PIN          LL_GPIO_PIN_13
+
+
+#endif
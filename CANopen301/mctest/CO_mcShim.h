@@ -0,0 +1,90 @@
+/*
+ * SIMD intrinsics of the Cortex-M4 in C, included before the motor control
+ * components and CMSIS-DSP with "-include".
+ *
+ * @file        CO_mcShim.h
+ * @author      Janez Paternoster
+ * @copyright   2015 Janez Paternoster
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef CO_MC_SHIM_H
+#define CO_MC_SHIM_H
+
+
+/* HAL and core headers are included first, their guards keep the
+ * redefinitions below */
+#include "stm32f3xx_hal.h"
+
+
+/* Intrinsics used by the Cortex-M4 path of arm_biquad_cascade_df1_q15.c,
+ * with the arithmetic of the ARMv7E-M instructions */
+static inline uint32_t CO_mcSimSMUAD(uint32_t op1, uint32_t op2){
+    return (uint32_t)((int32_t)(int16_t)op1 * (int16_t)op2 +
+                      (int32_t)(int16_t)(op1 >> 16) * (int16_t)(op2 >> 16));
+}
+
+static inline uint32_t CO_mcSimSMUADX(uint32_t op1, uint32_t op2){
+    return (uint32_t)((int32_t)(int16_t)op1 * (int16_t)(op2 >> 16) +
+                      (int32_t)(int16_t)(op1 >> 16) * (int16_t)op2);
+}
+
+static inline uint64_t CO_mcSimSMLALD(uint32_t op1, uint32_t op2, uint64_t acc){
+    return (uint64_t)((int64_t)acc + (int32_t)(int16_t)op1 * (int16_t)op2 +
+                      (int32_t)(int16_t)(op1 >> 16) * (int16_t)(op2 >> 16));
+}
+
+static inline int32_t CO_mcSimSSAT(int32_t value, uint32_t bits){
+    int32_t max = (int32_t)((1UL << (bits - 1U)) - 1U);
+
+    return (value > max) ? max : ((value < -max - 1) ? -max - 1 : value);
+}
+
+#define __SMUAD(op1, op2)           CO_mcSimSMUAD(op1, op2)
+#define __SMUADX(op1, op2)          CO_mcSimSMUADX(op1, op2)
+#define __SMLALD(op1, op2, acc)     CO_mcSimSMLALD(op1, op2, acc)
+#undef __SSAT
+#define __SSAT(value, bits)         CO_mcSimSSAT(value, bits)
+#undef __PKHBT
+#define __PKHBT(op1, op2, shift)    ((((uint32_t)(op1)) & 0x0000FFFFUL) | \
+                                     (((uint32_t)(op2) << (shift)) & 0xFFFF0000UL))
+
+/* __RBIT() of the LL register macros of r3_1_f30x_pwm_curr_fdbk.c, result
+ * for 0 is 32 as __CLZ() */
+static inline uint32_t CO_mcSimPositionVal(uint32_t value){
+    return (uint32_t)__builtin_ctzll((uint64_t)value | (1ULL << 32));
+}
+#undef POSITION_VAL
+#define POSITION_VAL(VAL)           CO_mcSimPositionVal(VAL)
+
+/* Cycle counter and main stack pointer of Src/stack_monitor.c, models in
+ * mctest/CO_mcTest.c. The stack itself is CO_mcSimStack, _ebss and _estack
+ * are defined by the linker. */
+extern DWT_Type CO_mcSimDWT;
+extern CoreDebug_Type CO_mcSimCoreDebug;
+extern uint32_t CO_mcSimMSP;
+#undef DWT
+#define DWT                         (&CO_mcSimDWT)
+#undef CoreDebug
+#define CoreDebug                   (&CO_mcSimCoreDebug)
+#define __get_MSP()                 CO_mcSimMSP
+
+
+#endif
@@ -0,0 +1,2123 @@
+/*
+ * Host tests of the motor control components of the firmware, which have
+ * no hardware dependency.
+ *
+ * @file        CO_mcTest.c
+ * @author      Janez Paternoster
+ * @copyright   2015 Janez Paternoster
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/* The components are compiled unchanged from MotorControl/MCSDK and set up
+ * with the parameters of Inc/, as in Src/mc_config.c. Each test drives one
+ * of them with a synthetic profile, prints the figures quoted in the commit
+ * of the component and fails, if they are out of bounds.
+ *
+ * GAP gate driver, gap_gate_driver_ctrl.c, on a model of a daisy chain of
+ * MC_GAP_DEVICES devices. The SPI and the pins of
+ * mctest/gap_f1f3f4_gate_driver_ctrl.h shift 16 bit words through the shift
+ * registers of the devices. At the rising chip select each device executes
+ * the word it holds and loads its answer. Words to the device carry the
+ * inverted CRC-8, answers the CRC-8 as is. A device with CRC_SPI checks the
+ * CRC of each word, bit by bit, and ignores a wrong word with SPI_ERR.
+ * Registers are written in configuration mode only:
+ * gap_crc: GAP_CRCCalculate against the bitwise CRC for all data and
+ *     initial values. GAP_CRCCheck takes each answer and refuses each single
+ *     bit error.
+ * gap_frame: GAP_Configuration with a different setting in each device.
+ *     Each frame has one word per device, within one chip select, the
+ *     commands come in the order of the driver. Each device holds its own
+ *     setting, GAP_IsDevicesProgrammed reads it back.
+ * gap_errors: faults set in the status registers of some devices.
+ *     GAP_CheckErrors reports each of them for its device, GAP_FaultAck
+ *     clears them. A bit error on MISO gives GAP_ERROR_CODE_SPI_CRC, a bit
+ *     error on MOSI in a write makes GAP_Configuration fail.
+ *
+ * Winding thermal model, thermal_model.c, called at
+ * MEDIUM_FREQUENCY_TASK_RATE. The current follows the demand of the
+ * profile, clamped to the limit of the model, as in TSK_MediumFrequencyTaskM1
+ * and FOC_CalcCurrRef:
+ * thermal_reference: open loop duty cycle, 20 s at NOMINAL_CURRENT and 40 s
+ *     at RATED_CURRENT / 2, against a floating point model of the same two
+ *     nodes. Fixed point error below 1 Celsius.
+ * thermal_peak: NOMINAL_CURRENT demanded from cold. Full peak for 20 s or
+ *     more, the limit after 2 h is within 5 % of RATED_CURRENT, winding not
+ *     over WINDING_MAX_TEMP_C.
+ * thermal_duty: the duty cycle of thermal_reference in closed loop for 2 h.
+ *     Share of the peaks served in full, winding not over WINDING_MAX_TEMP_C.
+ * thermal_hot_ntc: thermal_peak with the heat sink NTC at 80 Celsius, half
+ *     of the rated rise. Full peak for 5 s or more.
+ *
+ * Load torque observer, load_torque_observer.c, called at
+ * MEDIUM_FREQUENCY_TASK_RATE, on a rigid shaft accelerated by
+ * MOTOR_ACCEL_01HZ_S at NOMINAL_CURRENT. The speed measure is rounded to
+ * 0.1 Hz, Iq follows its reference:
+ * lto_step: Iq fixed at 5000 digit, load step from 2000 to 8000 digit. The
+ *     estimate is within 5 % of the step in 50 ms or less.
+ * lto_speed_loop: speed PI of Src/mc_config.c at 100 Hz, the same load
+ *     step, with the feed forward of FOC_CalcCurrRef and without. The speed
+ *     dip and the mean speed error are smaller with it.
+ *
+ * Speed loop filters, notch_filter.c with arm_biquad_cascade_df1_q15.c of
+ * CMSIS-DSP, at MEDIUM_FREQUENCY_TASK_RATE. CMSIS-DSP takes its Cortex-M4
+ * path, the SIMD intrinsics are in mctest/CO_mcShim.h:
+ * notch_response: gain of a notch at 117 Hz, Q 2 and a low pass at 100 Hz,
+ *     Q 0.7, for sines of 10000 digit, against the exact biquad. Notch depth
+ *     30 dB or more, within 0.5 dB of the exact response elsewhere.
+ * notch_search: speed error with a 117 Hz tone of 40 digit in random noise
+ *     of 40 digit peak, the search sets a notch within one bin. Noise alone
+ *     sets none.
+ * notch_two_mass: speed PI of Src/mc_config.c on a motor coupled to a load
+ *     of twice its inertia by a shaft resonating at 117 Hz with 2 % damping,
+ *     speed measured as by the hall sensor. The speed error oscillates
+ *     without the filter, the search finds the resonance and the notch cuts
+ *     the speed oscillation to a quarter or less.
+ *
+ * Deadbeat current controller, deadbeat_curr_ctrl.c, called at
+ * TF_REGULATION_RATE in place of the Iq and Id PI, on the dq equations of
+ * the motor at constant speed. Vqd is applied from the update event,
+ * MC_FOC_UPDATE of the FOC period after the sample, for one period, at the
+ * angle of the inverse Park, while the rotor turns on:
+ * dbc_step: Iq step of 1 A at 1000 rpm on a 24 V bus, with the motor Ls and
+ *     with Ls off by 30 %, inverse Park as set by ANGLE_DELAY_COMPENSATION.
+ *     Within 5 % in 8 FOC periods or less, faster than the PI with the
+ *     gains of drive_parameters.h and a PI tuned to 1 kHz.
+ * foc_angle_delay: Iq step of 1.5 A at 1000 and 2000 rpm, the deadbeat
+ *     controller and the PI tuned to 1 kHz, inverse Park at the sampling
+ *     angle and advanced as FOC_CurrController. With the advance the Id
+ *     excursion is smaller and the deadbeat controller keeps 0.995 or more
+ *     of the current on the q axis. At 3000 rpm the 24 V bus is too low for
+ *     the step.
+ *
+ * Current oversampling, R3_1_F30X_GetPhaseCurrents and the sampling point
+ * of the sectors in r3_1_f30x_pwm_curr_fdbk.c, called by PWMC_SetPhaseVoltage
+ * and PWMC_GetPhaseCurrents, on models of the ADC1 and TIM1 registers. The
+ * injected conversions are the phase currents of the channels of JSQR with
+ * Gaussian noise, rounded to 12 bit:
+ * curr_oversampling: rotating voltage vector, modulation 0.3 to 0.9, 2 A of
+ *     current, 2 LSB rms of noise, CURR_OVERSAMPLING_SECTORS off and all
+ *     sectors on. Without noise Ia and Ib are exact to the 12 bit of the ADC
+ *     both ways. At 0.3 every period is oversampled and the Iq noise is 0.75
+ *     of the plain sampling or less.
+ *
+ * PWM frequency change, R3_1_F30X_SetPWMPeriod of r3_1_f30x_pwm_curr_fdbk.c
+ * on the same registers and PID_ScaleKI of pid_regulator.c, as called by
+ * FOC_SetPWMFrequency for the settings of FOC_PWMFrequencyPolicy:
+ * pwm_period: refused with MOE set and for a period shorter than the
+ *     sampling. ARR, RCR and the handle follow each setting, the currents of
+ *     curr_oversampling without noise are exact at the new period.
+ * pwm_ki_rescale: Ki of 2959, as restored from flash, over 1000 random
+ *     changes of the FOC rate. Within 1 of the exact Ki * Ts, back to 2959
+ *     at TF_REGULATION_RATE each time. A gain over int16_t is refused.
+ *
+ * Loss minimization, loss_min_ctrl.c, called at MEDIUM_FREQUENCY_TASK_RATE
+ * at steady speed and load:
+ * lmc_search: motor power convex in Id, 2 W above the minimum at Id 0, with
+ *     1.5 W rms of noise, rounded to whole watts as MPM_GetElMotorPowerW.
+ *     The learned Id is within 0.1 W of the minimum in 120 s or less, the
+ *     mean excess of the last 100 s, steps included, is below 0.1 W.
+ *
+ * Regenerative brake control, regen_brake_ctrl.c, called at
+ * SYS_TICK_FREQUENCY as in TSK_SafetyTask, on a motor with the flux of
+ * Inc/ and the inertia of MOTOR_ACCEL_01HZ_S, a 0.3 ohm winding and a fan
+ * load, fed by a 24 V supply, which does not take current back:
+ * rbc_brake: speed ramp from 3000 to 300 rpm. Without the regulator the
+ *     shortest ramp, which does not reach OV_VOLTAGE_THRESHOLD_V. With it a
+ *     0.1 s ramp, with 470 uF, with a 15 ohm brake resistor and with 220 uF,
+ *     never reaches OV_VOLTAGE_THRESHOLD_V and is within 5 % of 300 rpm in
+ *     less than 2 s.
+ *
+ * Condition monitor, Src/cond_monitor.c, CMON_Sample called at
+ * TF_REGULATION_RATE and CMON_Process on every 1 ms tick, as in mc_tasks.c
+ * and main.c. Calls of MCM_Trig_Functions and MCM_Sqrt are wrapped and
+ * counted per step:
+ * cmon_bpfo: motor in RUN at 25 Hz, Iq of 3000 digit with a 1x tone of 150
+ *     digit, a BPFO tone of 100 digit and 20 digit rms of Gaussian noise.
+ *     The features of the first record are within 3 % and 3 digit of a
+ *     floating point DFT of the recorded samples, the BPFO line is 4 times
+ *     the floor and the BPFI bins or more. No step takes more than 64
+ *     MCM_Trig_Functions or 32 MCM_Sqrt calls. Features copied as in main.c
+ *     are read from OD 0x2140, sub-index 1 to 7, read only and TPDO
+ *     mappable.
+ *
+ * Stack monitor, Src/stack_monitor.c, on a stack of MC_SMON_WORDS words
+ * between _ebss and _estack, with models of MSP and of the DWT and
+ * CoreDebug registers:
+ * smon_paint: words used before SMON_Init. Below MSP and its margin of 16
+ *     words the stack is painted, the rest is left as it was. The cycle
+ *     counter is enabled, the high-water mark is 0.
+ * smon_scan: SMON_Process called until a scan is complete, 64 words per
+ *     call. The first scan stops at the margin below MSP, a word written
+ *     deeper is found by the next scan in the call of its chunk. Words
+ *     used above the mark do not lower the high-water mark, a scan without
+ *     change ends at the mark.
+ * smon_foc_cycles: SMON_FocCycles with CYCCNT over and around its wrap.
+ *     Last and longest interrupt, saturated to 0xFFFF. */
+
+
+#include "parameters_conversion.h"
+#include "gap_f1f3f4_gate_driver_ctrl.h"
+#include "thermal_model.h"
+#include "load_torque_observer.h"
+#include "pid_regulator.h"
+#include "notch_filter.h"
+#include "deadbeat_curr_ctrl.h"
+#include "loss_min_ctrl.h"
+#include "regen_brake_ctrl.h"
+#include "r3_1_f30x_pwm_curr_fdbk.h"
+#include "cond_monitor.h"
+#include "stack_monitor.h"
+#include "mc_api.h"
+#include "CO_driver.h"
+#include "CO_SDO.h"
+#include "CO_OD.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+#define MC_MF_HZ                MEDIUM_FREQUENCY_TASK_RATE
+#define MC_A_DIGIT              (2.0 * MAX_CURRENT / 65536.0)   /* Ampere per digit of current */
+
+
+/* Helpers ********************************************************************/
+static void mc_fail(const char *name, const char *what){
+    fprintf(stderr, "CO_mcTest: %s: %s\n", name, what);
+    exit(EXIT_FAILURE);
+}
+
+static uint32_t mc_random(uint64_t *state){
+    *state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (uint32_t)(*state >> 33);
+}
+
+/* Gaussian noise of 1 rms, Box-Muller */
+static double mc_gauss(uint64_t *state){
+    double u1 = (mc_random(state) + 1.0) / 4294967297.0;
+    double u2 = mc_random(state) / 4294967296.0;
+
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+
+/* GAP gate driver daisy chain ***********************************************/
+#define MC_GAP_DEVICES          4U
+#define MC_GAP_FRAMES           64U
+#define MC_GAP_READ             0xA0U
+#define MC_GAP_WRITE            0x80U
+
+/* Device of the chain, registers by address */
+typedef struct{
+    uint8_t             reg[32];
+    uint16_t            shift;          /* shift register */
+    bool                config;         /* between STARTCONFIG and STOPCONFIG */
+    bool                write;          /* next word is the data of a write */
+    uint8_t             writeReg;
+    uint8_t             writeCrc;       /* CRC after the command word */
+}mc_gapDevice_t;
+
+/* Frame within one chip select */
+typedef struct{
+    uint16_t            mosi[MC_GAP_DEVICES + 1U];
+    unsigned            words;
+    bool                sd;             /* shut down active during the frame */
+}mc_gapFrame_t;
+
+static mc_gapDevice_t mcGapDevice[MC_GAP_DEVICES];
+static mc_gapFrame_t mcGapFrame[MC_GAP_FRAMES];
+static unsigned mcGapFrames;
+static bool mcGapCS, mcGapSD;
+/* Bit flipped in word mcGapErrorWord of frame mcGapErrorFrame */
+static unsigned mcGapErrorFrame = MC_GAP_FRAMES, mcGapErrorWord;
+static bool mcGapErrorMiso;
+
+/* CRC-8 of the GAP, polynomial 0x07, bit by bit */
+static uint8_t mc_gapCrc(uint8_t crc, uint8_t data){
+    unsigned bit;
+
+    crc ^= data;
+    for(bit = 0; bit < 8U; bit++){
+        crc = (crc & 0x80U) ? (uint8_t)((crc << 1) ^ 0x07U) : (uint8_t)(crc << 1);
+    }
+    return crc;
+}
+
+static void mc_gapReset(mc_gapDevice_t *device){
+    memset(device->reg, 0, sizeof(device->reg));
+    device->reg[STATUS2] = GAP_STATUS2_GATE;
+}
+
+static void mc_gapExecute(mc_gapDevice_t *device){
+    uint8_t data = (uint8_t)(device->shift >> 8), crc = (uint8_t)device->shift;
+    bool check = (device->reg[CFG1] & GAP_CFG1_CRC_SPI) != 0U;
+    uint8_t answer = 0;
+
+    if(device->write){
+        device->write = false;
+        if(check && crc != (uint8_t)~mc_gapCrc(device->writeCrc, data)){
+            device->reg[STATUS3] |= GAP_STATUS3_SPI_ERR;
+        }
+        else if(device->config){
+            device->reg[device->writeReg] = data;
+        }
+    }
+    else if(check && crc != (uint8_t)~mc_gapCrc(0xFF, data)){
+        device->reg[STATUS3] |= GAP_STATUS3_SPI_ERR;
+    }
+    else if(data == 0x2AU){                         /* STARTCONFIG */
+        device->config = true;
+    }
+    else if(data == 0x3AU){                         /* STOPCONFIG */
+        device->config = false;
+    }
+    else if(data == 0xEAU){                         /* GLOBALRESET */
+        mc_gapReset(device);
+    }
+    else if(data == 0xD0U){                         /* RESETSTATUS */
+        device->reg[STATUS1] = 0;
+        device->reg[STATUS2] &= GAP_STATUS2_GATE;
+        device->reg[STATUS3] = 0;
+    }
+    else if((data & 0xE0U) == MC_GAP_WRITE){
+        device->write = true;
+        device->writeReg = data & 0x1FU;
+        device->writeCrc = mc_gapCrc(0xFF, data);
+    }
+    else if((data & 0xE0U) == MC_GAP_READ){
+        answer = device->reg[data & 0x1FU];
+    }
+    else if((data & 0xE0U) == 0xC0U){               /* RESETREG */
+        device->reg[data & 0x1FU] = (uint8_t)((data & 0x1FU) == STATUS2 ? GAP_STATUS2_GATE : 0U);
+    }
+    device->shift = (uint16_t)((answer << 8) | mc_gapCrc(0xFF, answer));
+}
+
+void GAP_CS_Activate(GAP_Handle_t *pHandle){
+    mcGapCS = true;
+    if(mcGapFrames < MC_GAP_FRAMES){
+        mcGapFrame[mcGapFrames].words = 0;
+        mcGapFrame[mcGapFrames].sd = mcGapSD;
+    }
+}
+
+void GAP_CS_Deactivate(GAP_Handle_t *pHandle){
+    unsigned i;
+
+    mcGapCS = false;
+    for(i = 0; i < MC_GAP_DEVICES; i++){
+        mc_gapExecute(&mcGapDevice[i]);
+    }
+    mcGapFrames++;
+}
+
+void GAP_SD_Activate(GAP_Handle_t *pHandle){
+    mcGapSD = true;
+}
+
+void GAP_SD_Deactivate(GAP_Handle_t *pHandle){
+    mcGapSD = false;
+}
+
+/* Device 0 takes MOSI, the last device drives MISO */
+uint16_t GAP_SPI_Send(GAP_Handle_t *pHandle, uint16_t value){
+    mc_gapFrame_t *frame = &mcGapFrame[mcGapFrames < MC_GAP_FRAMES ? mcGapFrames : 0U];
+    uint16_t miso = mcGapDevice[MC_GAP_DEVICES - 1U].shift;
+    bool error = mcGapFrames == mcGapErrorFrame && frame->words == mcGapErrorWord;
+    unsigned i;
+
+    if(!mcGapCS){
+        mc_fail("gap", "SPI word without chip select");
+    }
+    if(frame->words <= MC_GAP_DEVICES){
+        frame->mosi[frame->words] = value;
+    }
+    frame->words++;
+    if(error && !mcGapErrorMiso){
+        value ^= 0x0100U;
+    }
+    for(i = MC_GAP_DEVICES - 1U; i > 0U; i--){
+        mcGapDevice[i].shift = mcGapDevice[i - 1U].shift;
+    }
+    mcGapDevice[0].shift = value;
+    return (error && mcGapErrorMiso) ? (uint16_t)(miso ^ 0x0100U) : miso;
+}
+
+/* Setting of device n, CRC_SPI on */
+static GAP_DeviceParams_Handle_t mcGapParams[MC_GAP_DEVICES];
+static GAP_Handle_t mcGap;
+
+static void mc_gapInit(void){
+    unsigned i;
+
+    memset(mcGapDevice, 0, sizeof(mcGapDevice));
+    memset(&mcGap, 0, sizeof(mcGap));
+    mcGap.DeviceNum = MC_GAP_DEVICES;
+    for(i = 0; i < MC_GAP_DEVICES; i++){
+        mc_gapReset(&mcGapDevice[i]);
+        mcGapParams[i].CFG1 = (uint8_t)(GAP_CFG1_CRC_SPI | GAP_CFG1_DIAG_EN | (i & 3U));
+        mcGapParams[i].CFG2 = (uint8_t)(0x10U + i);
+        mcGapParams[i].CFG3 = (uint8_t)(0x20U + i);
+        mcGapParams[i].CFG4 = (uint8_t)((0x30U + i) & 0x3FU);
+        mcGapParams[i].CFG5 = (uint8_t)(GAP_CFG5_DESAT_EN | (i & 1U));
+        mcGapParams[i].DIAG1 = (uint8_t)(0x50U + i);
+        mcGapParams[i].DIAG2 = (uint8_t)(0x60U + i);
+        mcGap.DeviceParams[i] = &mcGapParams[i];
+    }
+    mcGapFrames = 0;
+    mcGapErrorFrame = MC_GAP_FRAMES;
+}
+
+static void mc_testGapCrc(void){
+    unsigned data, init, bit;
+
+    for(init = 0; init < 256U; init++){
+        for(data = 0; data < 256U; data++){
+            if(GAP_CRCCalculate((uint8_t)data, (uint8_t)init)
+               != (uint16_t)((data << 8) | (uint8_t)~mc_gapCrc((uint8_t)init, (uint8_t)data))){
+                mc_fail("gap_crc", "table CRC differs from the bitwise CRC");
+            }
+        }
+    }
+    for(data = 0; data < 256U; data++){
+        uint16_t word = (uint16_t)((data << 8) | mc_gapCrc(0xFF, (uint8_t)data));
+        uint8_t out = 0;
+
+        if(!GAP_CRCCheck(&out, word) || out != data){
+            mc_fail("gap_crc", "answer refused");
+        }
+        for(bit = 0; bit < 16U; bit++){
+            if(GAP_CRCCheck(&out, (uint16_t)(word ^ (1U << bit)))){
+                mc_fail("gap_crc", "bit error taken");
+            }
+        }
+    }
+    printf("gap_crc: table equals the bitwise CRC for 65536 data and initial values, "
+           "4096 single bit errors refused\n");
+}
+
+static void mc_testGapFrame(void){
+    /* Commands of GAP_DevicesConfiguration, then two frames per read of
+     * GAP_IsDevicesProgrammed */
+    static const uint8_t regs[] = {CFG1, CFG2, CFG3, CFG4, CFG5, DIAG1, DIAG2};
+    const unsigned configFrames = 2U + 2U * sizeof(regs) + 2U;
+    uint8_t expected[MC_GAP_FRAMES];
+    unsigned n = 0, i, f;
+
+    expected[n++] = 0x2AU;
+    expected[n++] = 0xEAU;
+    for(i = 0; i < sizeof(regs); i++){
+        expected[n++] = (uint8_t)(MC_GAP_WRITE | regs[i]);
+        expected[n++] = 0;                          /* data */
+    }
+    expected[n++] = 0x3AU;
+    expected[n++] = 0xD0U;
+    for(i = 0; i < sizeof(regs); i++){
+        expected[n++] = (uint8_t)(MC_GAP_READ | regs[i]);
+        expected[n++] = 0x00U;                      /* NOP */
+    }
+
+    mc_gapInit();
+    if(!GAP_Configuration(&mcGap)){
+        mc_fail("gap_frame", "configuration not read back");
+    }
+    if(mcGapFrames != n){
+        mc_fail("gap_frame", "number of frames");
+    }
+    for(f = 0; f < n; f++){
+        const mc_gapFrame_t *frame = &mcGapFrame[f];
+        bool data = f >= 2U && f < 2U + 2U * sizeof(regs) && (f & 1U) != 0U;
+
+        if(frame->words != MC_GAP_DEVICES){
+            mc_fail("gap_frame", "frame without one word per device");
+        }
+        for(i = 0; i < MC_GAP_DEVICES && !data; i++){
+            if((frame->mosi[i] >> 8) != expected[f]){
+                mc_fail("gap_frame", "command out of order");
+            }
+        }
+        if(frame->sd != (f < configFrames)){
+            mc_fail("gap_frame", "shut down not active during the configuration");
+        }
+    }
+    for(i = 0; i < MC_GAP_DEVICES; i++){
+        const mc_gapDevice_t *device = &mcGapDevice[i];
+        const GAP_DeviceParams_Handle_t *params = &mcGapParams[i];
+
+        if(device->reg[CFG1] != params->CFG1 || device->reg[CFG2] != params->CFG2
+           || device->reg[CFG3] != params->CFG3 || device->reg[CFG4] != params->CFG4
+           || device->reg[CFG5] != params->CFG5 || device->reg[DIAG1] != params->DIAG1
+           || device->reg[DIAG2] != params->DIAG2 || device->config){
+            mc_fail("gap_frame", "device holds the setting of another device");
+        }
+    }
+    printf("gap_frame: %u devices configured and read back in %u frames of %u words\n",
+           MC_GAP_DEVICES, n, MC_GAP_DEVICES);
+}
+
+static void mc_testGapErrors(void){
+    uint32_t now[MAX_DEVICES_NUMBER], occurred[MAX_DEVICES_NUMBER];
+    uint32_t expected[MC_GAP_DEVICES] = {0};
+    unsigned i, frames;
+
+    mc_gapInit();
+    if(!GAP_Configuration(&mcGap)){
+        mc_fail("gap_errors", "configuration not read back");
+    }
+    mcGapDevice[0].reg[STATUS1] |= GAP_STATUS1_DESAT;
+    expected[0] = GAP_ERROR_CODE_DESAT;
+    mcGapDevice[2].reg[STATUS1] |= GAP_STATUS1_TSD;
+    mcGapDevice[2].reg[STATUS3] |= GAP_STATUS3_UVLOD;
+    expected[2] = GAP_ERROR_CODE_TSD | GAP_ERROR_CODE_UVLOD;
+    mcGapDevice[3].reg[STATUS2] |= GAP_STATUS2_ASC;
+    expected[3] = GAP_ERROR_CODE_ASC;
+
+    frames = mcGapFrames;
+    if(!GAP_CheckErrors(&mcGap, now, occurred)){
+        mc_fail("gap_errors", "status not read");
+    }
+    frames = mcGapFrames - frames;
+    for(i = 0; i < MC_GAP_DEVICES; i++){
+        if(now[i] != expected[i] || occurred[i] != expected[i]){
+            mc_fail("gap_errors", "fault reported for the wrong device");
+        }
+    }
+    GAP_FaultAck(&mcGap);
+    GAP_CheckErrors(&mcGap, now, occurred);
+    for(i = 0; i < MC_GAP_DEVICES; i++){
+        if(now[i] != GAP_ERROR_CLEAR || occurred[i] != GAP_ERROR_CLEAR){
+            mc_fail("gap_errors", "fault not cleared");
+        }
+    }
+    printf("gap_errors: faults of 3 of %u devices reported for their device, %u frames per check\n",
+           MC_GAP_DEVICES, frames);
+
+    /* Answer of the device before the last, second frame of the first read */
+    mcGapErrorFrame = mcGapFrames + 1U;
+    mcGapErrorWord = 1U;
+    mcGapErrorMiso = true;
+    if(GAP_CheckErrors(&mcGap, now, occurred) || (now[0] & GAP_ERROR_CODE_SPI_CRC) == 0U){
+        mc_fail("gap_errors", "bit error on MISO not detected");
+    }
+
+    /* Data of CFG3 for device 2, word 0 goes to the last device */
+    mc_gapInit();
+    mcGapErrorFrame = 2U + 2U * 2U + 1U;
+    mcGapErrorWord = MC_GAP_DEVICES - 1U - 2U;
+    mcGapErrorMiso = false;
+    if(GAP_Configuration(&mcGap) || (mcGap.GAP_ErrorsNow[0] & GAP_ERROR_CODE_DEVICES_NOT_PROGRAMMABLE) == 0U
+       || mcGapDevice[2].reg[CFG3] == mcGapParams[2].CFG3 || mcGapDevice[1].reg[CFG3] != mcGapParams[1].CFG3){
+        mc_fail("gap_errors", "bit error on MOSI not detected");
+    }
+    printf("  bit error on MISO: SPI CRC error, on MOSI: device 2 not programmable\n");
+}
+
+
+/* Thermal model **************************************************************/
+static NTC_Handle_t mcNTC;
+static TM_Handle_t mcTM;
+
+/* Handle of Src/mc_config.c, virtual heat sink sensor at hNtc_C */
+static void mc_thermalInit(int16_t hNtc_C){
+    memset(&mcNTC, 0, sizeof(mcNTC));
+    mcNTC.bSensorType = VIRTUAL_SENSOR;
+    mcNTC.hExpectedTemp_C = (uint16_t)hNtc_C;
+
+    memset(&mcTM, 0, sizeof(mcTM));
+    mcTM.hRatedCurrent       = (uint16_t)RATED_CURRENT;
+    mcTM.hPeakCurrent        = (uint16_t)NOMINAL_CURRENT;
+    mcTM.hWindingTau_s       = WINDING_THERMAL_TAU_S;
+    mcTM.hHousingTau_s       = HOUSING_THERMAL_TAU_S;
+    mcTM.hWindingShare       = (uint16_t)(WINDING_THERMAL_SHARE * 32768);
+    mcTM.hMaxWindingTemp_C   = WINDING_MAX_TEMP_C;
+    mcTM.hRatedAmbientTemp_C = RATED_AMBIENT_TEMP_C;
+    mcTM.hDerateBand         = (uint16_t)(WINDING_DERATE_BAND * 32768);
+    mcTM.hDecimation         = MEDIUM_FREQUENCY_TASK_RATE/10;
+    mcTM.hMFTaskFrequencyHz  = MEDIUM_FREQUENCY_TASK_RATE;
+    mcTM.pNTC                = &mcNTC;
+    TM_Init(&mcTM);
+}
+
+/* Winding temperature with the fraction of the model */
+static double mc_thermalWinding_C(void){
+    double rise = (double)(mcTM.wWindingRise + mcTM.wHousingRise) / (1 << 24);
+
+    return RATED_AMBIENT_TEMP_C + rise * (WINDING_MAX_TEMP_C - RATED_AMBIENT_TEMP_C);
+}
+
+/* Duty cycle: 20 s at the peak, 40 s at half the rated current */
+static int16_t mc_thermalDuty(uint32_t step){
+    return ((step % (60U * MC_MF_HZ)) < 20U * MC_MF_HZ) ? (int16_t)NOMINAL_CURRENT
+                                                        : (int16_t)(RATED_CURRENT / 2);
+}
+
+/* One call of the medium frequency task, current clamped to the limit */
+static int16_t mc_thermalStep(int16_t hDemand){
+    Curr_Components Iqd;
+    int16_t hLimit = (int16_t)TM_GetCurrentLimit(&mcTM);
+
+    Iqd.qI_Component1 = (hDemand > hLimit) ? hLimit : hDemand;
+    Iqd.qI_Component2 = 0;
+    (void)TM_CalcCurrentLimit(&mcTM, Iqd);
+    return Iqd.qI_Component1;
+}
+
+static void mc_testThermalReference(void){
+    const double share = WINDING_THERMAL_SHARE;
+    const double dt = 1.0 / MC_MF_HZ;
+    double winding = 0.0, housing = 0.0, maxError = 0.0, maxTemp = 0.0;
+    uint32_t step;
+
+    mc_thermalInit(RATED_AMBIENT_TEMP_C);
+    for(step = 0; step < 7200U * MC_MF_HZ; step++){
+        int16_t hIq = mc_thermalDuty(step);
+        double power = ((double)hIq * hIq) / ((double)RATED_CURRENT * RATED_CURRENT);
+        Curr_Components Iqd = {hIq, 0};
+        double reference, error;
+
+        (void)TM_CalcCurrentLimit(&mcTM, Iqd);
+        winding += (share * power - winding) * dt / WINDING_THERMAL_TAU_S;
+        housing += (winding * (1.0 - share) / share - housing) * dt / HOUSING_THERMAL_TAU_S;
+        if(mcTM.hCount != 0U){
+            continue;
+        }
+        reference = RATED_AMBIENT_TEMP_C + (winding + housing) * (WINDING_MAX_TEMP_C - RATED_AMBIENT_TEMP_C);
+        error = fabs(mc_thermalWinding_C() - reference);
+        if(error > maxError) maxError = error;
+        if(reference > maxTemp) maxTemp = reference;
+    }
+
+    printf("thermal_reference: 2 h of 20 s at %d, 40 s at %d digit, open loop\n",
+           (int)NOMINAL_CURRENT, (int)(RATED_CURRENT / 2));
+    printf("  winding max            %.1f C (floating point model)\n", maxTemp);
+    printf("  fixed point error      %.2f C max\n", maxError);
+    if(maxError >= 1.0){
+        mc_fail("thermal_reference", "fixed point model differs by 1 Celsius or more");
+    }
+}
+
+/* Peak demanded from cold, time at full peak, maximum winding temperature */
+static void mc_thermalPeak(const char *name, int16_t hNtc_C, uint32_t minFullPeak_s){
+    uint32_t step, fullPeak = 0;
+    double maxTemp = 0.0;
+    int16_t hIq = 0;
+
+    mc_thermalInit(hNtc_C);
+    for(step = 0; step < 7200U * MC_MF_HZ; step++){
+        hIq = mc_thermalStep((int16_t)NOMINAL_CURRENT);
+        if(hIq == (int16_t)NOMINAL_CURRENT && fullPeak == step){
+            fullPeak = step + 1U;
+        }
+        if(mc_thermalWinding_C() > maxTemp) maxTemp = mc_thermalWinding_C();
+    }
+
+    printf("%s: %d digit (2x rated) demanded from cold, heat sink NTC at %d C\n",
+           name, (int)NOMINAL_CURRENT, hNtc_C);
+    printf("  full peak for          %.1f s\n", (double)fullPeak / MC_MF_HZ);
+    printf("  limit after 2 h        %d digit (%.2f x rated)\n", hIq, (double)hIq / RATED_CURRENT);
+    printf("  winding max            %.1f C\n", maxTemp);
+    if(maxTemp > WINDING_MAX_TEMP_C + 1.0){
+        mc_fail(name, "winding over its maximum temperature");
+    }
+    if(fullPeak < minFullPeak_s * MC_MF_HZ){
+        mc_fail(name, "full peak too short");
+    }
+}
+
+static void mc_testThermalPeak(void){
+    mc_thermalPeak("thermal_peak", RATED_AMBIENT_TEMP_C, 20U);
+    if(abs((int)TM_GetCurrentLimit(&mcTM) - (int)RATED_CURRENT) > RATED_CURRENT / 20){
+        mc_fail("thermal_peak", "limit after 2 h not within 5 % of the rated current");
+    }
+}
+
+static void mc_testThermalHotNtc(void){
+    mc_thermalPeak("thermal_hot_ntc", 80, 5U);
+}
+
+static void mc_testThermalDuty(void){
+    uint32_t step, peaks = 0, served = 0;
+    uint32_t firstDerate = 0;
+    double maxTemp = 0.0;
+
+    mc_thermalInit(RATED_AMBIENT_TEMP_C);
+    for(step = 0; step < 7200U * MC_MF_HZ; step++){
+        int16_t hDemand = mc_thermalDuty(step);
+        int16_t hIq = mc_thermalStep(hDemand);
+
+        if(hDemand == (int16_t)NOMINAL_CURRENT){
+            peaks++;
+            if(hIq == hDemand) served++;
+            else if(firstDerate == 0U) firstDerate = step;
+        }
+        if(mc_thermalWinding_C() > maxTemp) maxTemp = mc_thermalWinding_C();
+    }
+
+    printf("thermal_duty: 2 h of 20 s at %d, 40 s at %d digit, closed loop\n",
+           (int)NOMINAL_CURRENT, (int)(RATED_CURRENT / 2));
+    printf("  peaks served in full   %.1f %%, first derating after %.0f s\n",
+           100.0 * served / peaks, (double)firstDerate / MC_MF_HZ);
+    printf("  winding max            %.1f C\n", maxTemp);
+    if(maxTemp > WINDING_MAX_TEMP_C + 1.0){
+        mc_fail("thermal_duty", "winding over its maximum temperature");
+    }
+}
+
+
+/* Load torque observer *******************************************************/
+#define MC_LTO_OMEGA            (2.0 * 3.14159265 * LTO_BANDWIDTH_HZ)
+#define MC_LTO_ACCEL_DIGIT      ((double)MOTOR_ACCEL_01HZ_S / NOMINAL_CURRENT)
+#define MC_LTO_STEP_AT          (MC_MF_HZ / 2U)
+
+static LTO_Handle_t mcLTO;
+static double mcShaft01Hz;
+
+/* Handle of Src/mc_config.c */
+static void mc_ltoInit(int16_t hFeedForwardGain){
+    memset(&mcLTO, 0, sizeof(mcLTO));
+    mcLTO.wAccelGain       = (int32_t)(MC_LTO_ACCEL_DIGIT * 16777216.0 / MEDIUM_FREQUENCY_TASK_RATE);
+    mcLTO.hSpeedGain       = (int16_t)(2.0 * MC_LTO_OMEGA / MEDIUM_FREQUENCY_TASK_RATE * 32768);
+    mcLTO.wLoadGain        = (int32_t)(MC_LTO_OMEGA * MC_LTO_OMEGA / MEDIUM_FREQUENCY_TASK_RATE /
+                                       MC_LTO_ACCEL_DIGIT * 256);
+    mcLTO.hFeedForwardGain = hFeedForwardGain;
+    mcLTO.hMaxLoad         = (int16_t)IQMAX;
+    LTO_Init(&mcLTO);
+    mcShaft01Hz = 1000.0;
+}
+
+/* Shaft for one period with hIq against the load, returns the measure */
+static int16_t mc_ltoShaft(int16_t hIq, int16_t hLoad){
+    mcShaft01Hz += MC_LTO_ACCEL_DIGIT * (hIq - hLoad) / MC_MF_HZ;
+    return (int16_t)lround(mcShaft01Hz);
+}
+
+static int16_t mc_ltoLoad(uint32_t step){
+    return (step < MC_LTO_STEP_AT) ? 2000 : 8000;
+}
+
+static void mc_testLtoStep(void){
+    uint32_t step, settled = 0;
+    int16_t hSpeed = 1000, hEstimate = 0;
+    int16_t hMin = INT16_MAX, hMax = INT16_MIN;
+
+    mc_ltoInit((int16_t)(LTO_FEEDFORWARD_GAIN * 32767));
+    for(step = 0; step < MC_MF_HZ; step++){
+        hEstimate = LTO_CalcLoadTorque(&mcLTO, 5000, hSpeed);
+        hSpeed = mc_ltoShaft(5000, mc_ltoLoad(step));
+        if(step >= MC_LTO_STEP_AT && abs(hEstimate - 8000) > 6000 / 20){
+            settled = step + 1U;
+        }
+        if(step >= MC_LTO_STEP_AT + MC_MF_HZ / 10U){
+            if(hEstimate < hMin) hMin = hEstimate;
+            if(hEstimate > hMax) hMax = hEstimate;
+        }
+    }
+
+    printf("lto_step: Iq 5000 digit, load 2000 -> 8000 digit, %u Hz bandwidth\n", (unsigned)LTO_BANDWIDTH_HZ);
+    printf("  within 5 %% after       %.0f ms\n", (settled - MC_LTO_STEP_AT) * 1000.0 / MC_MF_HZ);
+    printf("  estimate after 100 ms  %d to %d digit, ripple of the 0.1 Hz speed\n", hMin, hMax);
+    if((settled - MC_LTO_STEP_AT) * 1000U / MC_MF_HZ > 50U){
+        mc_fail("lto_step", "estimate not within 5 % in 50 ms");
+    }
+}
+
+/* Speed loop with the feed forward gain, returns the largest speed dip and
+ * the mean speed error after the step, in 0.1 Hz */
+static int32_t mc_ltoSpeedLoop(int16_t hFeedForwardGain, double *meanError){
+    PID_Handle_t pid;
+    uint32_t step;
+    int32_t dip = 0;
+    int16_t hSpeed = 1000;
+
+    memset(&pid, 0, sizeof(pid));
+    pid.hDefKpGain          = (int16_t)PID_SPEED_KP_DEFAULT;
+    pid.hDefKiGain          = (int16_t)PID_SPEED_KI_DEFAULT;
+    pid.wUpperIntegralLimit = (int32_t)IQMAX * (int32_t)SP_KIDIV;
+    pid.wLowerIntegralLimit = -(int32_t)IQMAX * (int32_t)SP_KIDIV;
+    pid.hUpperOutputLimit   = (int16_t)IQMAX;
+    pid.hLowerOutputLimit   = -(int16_t)IQMAX;
+    pid.hKpDivisor          = (uint16_t)SP_KPDIV;
+    pid.hKiDivisor          = (uint16_t)SP_KIDIV;
+    pid.hKpDivisorPOW2      = (uint16_t)SP_KPDIV_LOG;
+    pid.hKiDivisorPOW2      = (uint16_t)SP_KIDIV_LOG;
+    PID_HandleInit(&pid);
+
+    /* steady state at the load before the step */
+    mc_ltoInit(hFeedForwardGain);
+    mcLTO.wLoadEst = 2000 * 65536;
+    PID_SetIntegralTerm(&pid, (2000 - LTO_GetFeedForward(&mcLTO)) * (int32_t)SP_KIDIV);
+    *meanError = 0.0;
+    for(step = 0; step < MC_MF_HZ; step++){
+        int32_t wIq = PI_Controller(&pid, 1000 - hSpeed);
+
+        wIq += LTO_GetFeedForward(&mcLTO);
+        wIq = (wIq > INT16_MAX) ? INT16_MAX : ((wIq < -INT16_MAX) ? -INT16_MAX : wIq);
+        hSpeed = mc_ltoShaft((int16_t)wIq, mc_ltoLoad(step));
+        (void)LTO_CalcLoadTorque(&mcLTO, (int16_t)wIq, hSpeed);
+        if(step >= MC_LTO_STEP_AT){
+            if(1000 - hSpeed > dip) dip = 1000 - hSpeed;
+            *meanError += (double)abs(1000 - hSpeed) / (MC_MF_HZ - MC_LTO_STEP_AT);
+        }
+    }
+    return dip;
+}
+
+static void mc_testLtoSpeedLoop(void){
+    double error, errorFF;
+    int32_t dip = mc_ltoSpeedLoop(0, &error);
+    int32_t dipFF = mc_ltoSpeedLoop((int16_t)(LTO_FEEDFORWARD_GAIN * 32767), &errorFF);
+
+    printf("lto_speed_loop: 100 Hz, load 2000 -> 8000 digit, speed PI Kp %d Ki %d\n",
+           (int)PID_SPEED_KP_DEFAULT, (int)PID_SPEED_KI_DEFAULT);
+    printf("  without feed forward   dip %.1f Hz, mean error %.3f Hz in 0.5 s\n", dip / 10.0, error / 10.0);
+    printf("  with feed forward      dip %.1f Hz, mean error %.3f Hz in 0.5 s\n", dipFF / 10.0, errorFF / 10.0);
+    if(dipFF >= dip || errorFF >= error){
+        mc_fail("lto_speed_loop", "feed forward does not reduce the speed error");
+    }
+}
+
+
+/* Speed loop filters *********************************************************/
+#define MC_NF_TONE_HZ           117U
+
+static NF_Handle_t mcNF;
+
+/* Handle of Src/mc_config.c with one stage */
+static void mc_nfInit(NF_StageType_t bType, uint16_t hFreqHz, uint16_t hQ10, bool bAutoSearch){
+    memset(&mcNF, 0, sizeof(mcNF));
+    mcNF.Stage[0].bType   = bType;
+    mcNF.Stage[0].hFreqHz = hFreqHz;
+    mcNF.Stage[0].hQ10    = hQ10;
+    mcNF.bNumStages       = 1;
+    mcNF.hSamplingFreqHz  = MEDIUM_FREQUENCY_TASK_RATE;
+    mcNF.bAutoSearch      = bAutoSearch;
+    mcNF.bAutoStage       = 0;
+    mcNF.hSearchMinHz     = SPD_NOTCH_SEARCH_MIN_HZ;
+    mcNF.hSearchRatio     = SPD_NOTCH_SEARCH_RATIO;
+    NF_Init(&mcNF);
+}
+
+/* Gain of the filter for a sine at freq, in dB, after it settled */
+static double mc_nfGain(double freq){
+    double in = 0.0, out = 0.0;
+    uint32_t step;
+
+    NF_Clear(&mcNF);
+    for(step = 0; step < 4U * MC_MF_HZ; step++){
+        double x = 10000.0 * sin(2.0 * M_PI * freq * step / MC_MF_HZ);
+        int16_t hOut = NF_Filter(&mcNF, (int16_t)lround(x));
+
+        if(step >= 2U * MC_MF_HZ){
+            in += x * x;
+            out += (double)hOut * hOut;
+        }
+    }
+    return 10.0 * log10(out / in);
+}
+
+/* Gain of the exact RBJ biquad, in dB */
+static double mc_nfExact(NF_StageType_t bType, double f0, double q, double freq){
+    double w0 = 2.0 * M_PI * f0 / MC_MF_HZ, w = 2.0 * M_PI * freq / MC_MF_HZ;
+    double alpha = sin(w0) / (2.0 * q), c = cos(w0);
+    double b0, b1, b2, a0 = 1.0 + alpha, a1 = -2.0 * c, a2 = 1.0 - alpha;
+    double nr, ni, dr, di;
+
+    if(bType == NF_NOTCH){
+        b0 = 1.0; b1 = -2.0 * c; b2 = 1.0;
+    }
+    else{
+        b0 = (1.0 - c) / 2.0; b1 = 1.0 - c; b2 = b0;
+    }
+    nr = b0 + b1 * cos(w) + b2 * cos(2.0 * w);
+    ni = -b1 * sin(w) - b2 * sin(2.0 * w);
+    dr = a0 + a1 * cos(w) + a2 * cos(2.0 * w);
+    di = -a1 * sin(w) - a2 * sin(2.0 * w);
+    return 10.0 * log10((nr * nr + ni * ni) / (dr * dr + di * di));
+}
+
+static void mc_nfResponse(const char *what, NF_StageType_t bType, uint16_t hFreqHz, uint16_t hQ10,
+                          double *maxError){
+    static const double freqs[] = {10.0, 20.0, 50.0, 80.0, 100.0, 117.0, 150.0, 200.0, 240.0};
+    unsigned i;
+
+    mc_nfInit(bType, hFreqHz, hQ10, false);
+    printf("  %-22s", what);
+    for(i = 0; i < sizeof(freqs) / sizeof(freqs[0]); i++){
+        double gain = mc_nfGain(freqs[i]);
+        double exact = mc_nfExact(bType, hFreqHz, hQ10 / 10.0, freqs[i]);
+
+        printf(" %.0f:%.1f", freqs[i], gain);
+        if(exact > -20.0 && fabs(gain - exact) > *maxError){
+            *maxError = fabs(gain - exact);
+        }
+    }
+    printf("\n");
+}
+
+static void mc_testNotchResponse(void){
+    double maxError = 0.0, depth;
+
+    printf("notch_response: gain in dB at Hz, sines of 10000 digit, %u Hz sampling\n", (unsigned)MC_MF_HZ);
+    mc_nfResponse("notch 117 Hz Q 2", NF_NOTCH, MC_NF_TONE_HZ, 20, &maxError);
+    mc_nfInit(NF_NOTCH, MC_NF_TONE_HZ, 20, false);
+    depth = -mc_nfGain(MC_NF_TONE_HZ);
+    mc_nfResponse("low pass 100 Hz Q 0.7", NF_LOWPASS, 100, 7, &maxError);
+    printf("  notch depth            %.1f dB\n", depth);
+    printf("  error to exact biquad  %.2f dB max, where above -20 dB\n", maxError);
+    if(depth < 30.0){
+        mc_fail("notch_response", "notch depth below 30 dB");
+    }
+    if(maxError > 0.5){
+        mc_fail("notch_response", "response differs from the exact biquad by more than 0.5 dB");
+    }
+}
+
+/* Runs the search on tone plus noise, returns the first frequency found */
+static uint16_t mc_nfSearch(int32_t toneAmplitude, uint32_t *found_ms){
+    uint64_t state = 0x5EED0086ULL;
+    uint32_t step;
+
+    mc_nfInit(NF_BYPASS, 0, SPD_FILTER1_Q10, true);
+    for(step = 0; step < 4U * MC_MF_HZ; step++){
+        double tone = toneAmplitude * sin(2.0 * M_PI * MC_NF_TONE_HZ * step / MC_MF_HZ);
+        int32_t noise = (int32_t)(mc_random(&state) % 81U) - 40;
+        uint16_t hFound = NF_SearchNotch(&mcNF, (int16_t)(lround(tone) + noise));
+
+        if(hFound != 0U){
+            *found_ms = (step + 1U) * 1000U / MC_MF_HZ;
+            return hFound;
+        }
+    }
+    return 0;
+}
+
+static void mc_testNotchSearch(void){
+    uint32_t found_ms = 0, noise_ms = 0;
+    uint16_t hFound = mc_nfSearch(40, &found_ms);
+    uint16_t hNoise = mc_nfSearch(0, &noise_ms);
+    uint16_t hBinHz = MC_MF_HZ / NF_SEARCH_LEN;
+
+    printf("notch_search: %u Hz tone of 40 digit in noise of 40 digit, bins of %.1f Hz\n",
+           (unsigned)MC_NF_TONE_HZ, (double)MC_MF_HZ / NF_SEARCH_LEN);
+    printf("  tone found             %u Hz after %u ms\n", hFound, (unsigned)found_ms);
+    printf("  noise alone            %s in 4 s\n", hNoise == 0U ? "nothing found" : "notch set");
+    if(abs((int)hFound - (int)MC_NF_TONE_HZ) > hBinHz){
+        mc_fail("notch_search", "tone not found within one bin");
+    }
+    if(hNoise != 0U){
+        mc_fail("notch_search", "notch set on noise");
+    }
+}
+
+/* Motor and load speed, shaft twist, all in 0.1 Hz and Iq digit units */
+typedef struct{
+    double motor, load, twist;
+}mc_twoMass_t;
+
+/* Speed PI on the two mass plant for 4 s, rms of the speed oscillation in
+ * the last second in 0.1 Hz, notches set by the search. The speed
+ * measure is the mean motor speed over HALL_AVERAGING_FIFO_DEPTH hall edges
+ * at 100 Hz, as the FIFO of hall_speed_pos_fdbk.c. */
+static double mc_twoMassRun(bool bFilter, char *notches, size_t size){
+    const double b = MC_LTO_ACCEL_DIGIT;                /* 1 / total inertia */
+    const double bm = 3.0 * b, bl = 1.5 * b;            /* motor 1/3, load 2/3 */
+    const double wr = 2.0 * M_PI * MC_NF_TONE_HZ;
+    const double k = wr * wr / (bm + bl);
+    const double c = 2.0 * 0.02 * wr / (bm + bl);
+    const uint32_t sub = 20U;
+    const uint32_t window = (uint32_t)lround((double)MC_MF_HZ * sub * HALL_AVERAGING_FIFO_DEPTH /
+                                             (6.0 * POLE_PAIR_NUM * 100.0));
+    mc_twoMass_t p = {1000.0, 1000.0, 0.0};
+    double hall[64], hallSum = 1000.0 * window;
+    PID_Handle_t pid;
+    double sum = 0.0, sum2 = 0.0;
+    uint32_t step, i, n = 0;
+    int16_t hSpeed = 1000;
+
+    for(i = 0; i < window; i++){
+        hall[i] = 1000.0;
+    }
+
+    memset(&pid, 0, sizeof(pid));
+    pid.hDefKpGain          = (int16_t)PID_SPEED_KP_DEFAULT;
+    pid.hDefKiGain          = (int16_t)PID_SPEED_KI_DEFAULT;
+    pid.wUpperIntegralLimit = (int32_t)IQMAX * (int32_t)SP_KIDIV;
+    pid.wLowerIntegralLimit = -(int32_t)IQMAX * (int32_t)SP_KIDIV;
+    pid.hUpperOutputLimit   = (int16_t)IQMAX;
+    pid.hLowerOutputLimit   = -(int16_t)IQMAX;
+    pid.hKpDivisor          = (uint16_t)SP_KPDIV;
+    pid.hKiDivisor          = (uint16_t)SP_KIDIV;
+    pid.hKpDivisorPOW2      = (uint16_t)SP_KPDIV_LOG;
+    pid.hKiDivisorPOW2      = (uint16_t)SP_KIDIV_LOG;
+    PID_HandleInit(&pid);
+    PID_SetIntegralTerm(&pid, 2000 * (int32_t)SP_KIDIV);
+
+    mc_nfInit(NF_BYPASS, 0, SPD_FILTER1_Q10, bFilter);
+    for(step = 0; step < 4U * MC_MF_HZ; step++){
+        int16_t hError = (int16_t)(1000 - hSpeed);
+        int16_t hIq = PI_Controller(&pid, hError);
+
+        if(bFilter){
+            uint16_t hFound;
+
+            hIq = NF_Filter(&mcNF, hIq);
+            hFound = NF_SearchNotch(&mcNF, hError);
+            if(hFound != 0U){
+                size_t len = strlen(notches);
+
+                snprintf(notches + len, size - len, "%s%u Hz at %u ms", len ? ", " : "",
+                         hFound, (unsigned)((step + 1U) * 1000U / MC_MF_HZ));
+            }
+        }
+        /* a kick of the load starts the oscillation */
+        if(step == MC_MF_HZ / 2U){
+            p.load += 20.0;
+        }
+        for(i = 0; i < sub; i++){
+            double dt = 1.0 / (MC_MF_HZ * sub);
+            double torque = k * p.twist + c * (p.motor - p.load);
+
+            p.motor += bm * (hIq - torque) * dt;
+            p.load += bl * (torque - 2000.0) * dt;
+            p.twist += (p.motor - p.load) * dt;
+            hallSum += p.motor - hall[n % window];
+            hall[n++ % window] = p.motor;
+        }
+        hSpeed = (int16_t)lround(hallSum / window);
+        if(step >= 3U * MC_MF_HZ){
+            sum += p.motor;
+            sum2 += p.motor * p.motor;
+        }
+    }
+    sum /= MC_MF_HZ;
+    return sqrt(sum2 / MC_MF_HZ - sum * sum);
+}
+
+static void mc_testNotchTwoMass(void){
+    char notches[200] = "";
+    double bypass = mc_twoMassRun(false, notches, sizeof(notches));
+    double notch = mc_twoMassRun(true, notches, sizeof(notches));
+
+    printf("notch_two_mass: %u Hz shaft resonance, 2 %% damping, speed PI Kp %d Ki %d\n",
+           (unsigned)MC_NF_TONE_HZ, (int)PID_SPEED_KP_DEFAULT, (int)PID_SPEED_KI_DEFAULT);
+    printf("  without the filter     speed oscillation %.2f Hz rms\n", bypass / 10.0);
+    printf("  with the notch search  speed oscillation %.2f Hz rms\n", notch / 10.0);
+    printf("  notches set            %s\n", notches);
+    if(notch * 4.0 > bypass){
+        mc_fail("notch_two_mass", "notch does not cut the oscillation to a quarter");
+    }
+}
+
+
+/* Deadbeat current controller ***********************************************/
+#define MC_DBC_RPM              1000.0
+#define MC_DBC_BUS_V            24.0
+#define MC_DBC_SUBSTEPS         20U
+#define MC_DBC_STEP_AT          200U
+#define MC_DBC_PERIODS          600U
+#define MC_FOC_DELAY_RPM        2000.0
+#define MC_FOC_DELAY_STEP_A     1.5
+
+/* Volt per bus digit */
+#define MC_DBC_MAX_BUS_V        (MCU_SUPPLY_VOLTAGE / BUS_ADC_CONV_RATIO)
+
+static BusVoltageSensor_Handle_t mcBusSensor;
+static DBC_Handle_t mcDBC;
+
+/* Handle of Src/mc_config.c, bus at MC_DBC_BUS_V */
+static void mc_dbcInit(void){
+    double digitPerOhm = 2.0 * MAX_CURRENT / MC_DBC_MAX_BUS_V * 65536;
+
+    memset(&mcBusSensor, 0, sizeof(mcBusSensor));
+    mcBusSensor.AvBusVoltage_d = (uint16_t)(MC_DBC_BUS_V / MC_DBC_MAX_BUS_V * 65536);
+
+    memset(&mcDBC, 0, sizeof(mcDBC));
+    mcDBC.wResistGain     = (int32_t)(RS * digitPerOhm);
+    mcDBC.wInductGainD    = (int32_t)(LS * TF_REGULATION_RATE * digitPerOhm);
+    mcDBC.wInductGainQ    = (int32_t)(LS * TF_REGULATION_RATE * digitPerOhm);
+    mcDBC.wBemfGain       = (int32_t)(MOTOR_VOLTAGE_CONSTANT * SQRT_2 / SQRT_3 * 60.0 * TF_REGULATION_RATE /
+                                      (1000.0 * POLE_PAIR_NUM * MC_DBC_MAX_BUS_V) * 65536);
+    mcDBC.hDeadbeatGain   = (int16_t)(DBC_DEADBEAT_GAIN * 32767);
+    mcDBC.hFOCFrequencyHz = TF_REGULATION_RATE;
+    DBC_Init(&mcDBC, &mcBusSensor);
+}
+
+/* Current loop case: controller, speed, step and motor */
+typedef struct {
+    bool   bDeadbeat;           /* deadbeat, else the Iq and Id PI */
+    int16_t hKp, hKi;           /* PI gains */
+    double rpm;
+    double stepA;               /* Iq step */
+    double lsFactor;            /* motor Ls over the LS of the controller */
+    double update;              /* sample to PWM update, share of the FOC period */
+    bool   bAdvance;            /* inverse Park advanced as with ANGLE_DELAY_COMPENSATION */
+} mc_focCase_t;
+
+typedef struct {
+    uint32_t settled;           /* FOC periods to stay within 5 % of the step */
+    double overshoot;           /* largest Iq overshoot, % */
+    double finalError;          /* Iq error at the end, % */
+    double idMax;               /* largest Id after the step, A */
+    double torquePerAmp;        /* Iq over the current amplitude at the end */
+} mc_focResult_t;
+
+/* Iq step from 0 at MC_DBC_STEP_AT, on the dq equations of the motor. The
+ * Vqd computed from the currents sampled at period k is turned to alpha
+ * beta at the sampling angle, advanced if bAdvance, and applied from the
+ * update event for one FOC period, while the rotor turns on. */
+static void mc_focStep(const mc_focCase_t *c, mc_focResult_t *r){
+    PID_Handle_t pidIq, pidId;
+    double we = c->rpm / 60.0 * 2.0 * M_PI * POLE_PAIR_NUM;
+    double flux = MOTOR_VOLTAGE_CONSTANT * SQRT_2 / SQRT_3 * 60.0 / (1000.0 * 2.0 * M_PI * POLE_PAIR_NUM);
+    double ls = LS * c->lsFactor, period = 1.0 / TF_REGULATION_RATE;
+    double vDigit = MC_DBC_BUS_V / (SQRT_3 * 32768.0);
+    int16_t hElSpeedDpp = (int16_t)lround(we / (2.0 * M_PI) * 65536.0 / TF_REGULATION_RATE);
+    int32_t wAdvance = 0;
+    double iq = 0.0, id = 0.0;
+    double vq[2], vd[2] = {0.0, 0.0}, angle[2];    /* running and next voltage */
+    uint32_t k, i;
+
+    memset(&pidIq, 0, sizeof(pidIq));
+    pidIq.hDefKpGain          = c->hKp;
+    pidIq.hDefKiGain          = c->hKi;
+    pidIq.wUpperIntegralLimit = (int32_t)INT16_MAX * TF_KIDIV;
+    pidIq.wLowerIntegralLimit = (int32_t)-INT16_MAX * TF_KIDIV;
+    pidIq.hUpperOutputLimit   = INT16_MAX;
+    pidIq.hLowerOutputLimit   = -INT16_MAX;
+    pidIq.hKpDivisor          = (uint16_t)TF_KPDIV;
+    pidIq.hKiDivisor          = (uint16_t)TF_KIDIV;
+    pidIq.hKpDivisorPOW2      = (uint16_t)TF_KPDIV_LOG;
+    pidIq.hKiDivisorPOW2      = (uint16_t)TF_KIDIV_LOG;
+    pidId = pidIq;
+    PID_HandleInit(&pidIq);
+    PID_HandleInit(&pidId);
+    mc_dbcInit();
+
+    /* FOC_CurrController, delay of R3_1_F30X_GetUpdateDelay */
+    if(c->bAdvance){
+        wAdvance = ((int32_t)hElSpeedDpp * ((int32_t)lround(c->update * 32768.0) + 16384)) >> 15;
+    }
+
+    /* zero current before the step: Vq balances the back-EMF */
+    vq[0] = vq[1] = we * flux;
+    angle[0] = angle[1] = we * period;
+    PID_SetIntegralTerm(&pidIq, (int32_t)lround(vq[0] / vDigit) * TF_KIDIV);
+    DBC_SetAppliedVoltage(&mcDBC, (Volt_Components){(int16_t)lround(vq[0] / vDigit), 0});
+
+    memset(r, 0, sizeof(*r));
+    for(k = 0; k < MC_DBC_PERIODS; k++){
+        Curr_Components Iqd, Iqdref;
+        Volt_Components Vqd;
+        double error, module;
+
+        Iqd.qI_Component1 = (int16_t)lround(iq / MC_A_DIGIT);
+        Iqd.qI_Component2 = (int16_t)lround(id / MC_A_DIGIT);
+        Iqdref.qI_Component1 = (k >= MC_DBC_STEP_AT) ? (int16_t)lround(c->stepA / MC_A_DIGIT) : 0;
+        Iqdref.qI_Component2 = 0;
+        if(k >= MC_DBC_STEP_AT){
+            error = (iq - c->stepA) / c->stepA * 100.0;
+            if(fabs(error) > 5.0){
+                r->settled = k - MC_DBC_STEP_AT + 1U;
+            }
+            if(error > r->overshoot){
+                r->overshoot = error;
+            }
+            if(fabs(id) > r->idMax){
+                r->idMax = fabs(id);
+            }
+            r->finalError = error;
+            r->torquePerAmp = iq / hypot(iq, id);
+        }
+
+        if(c->bDeadbeat){
+            Vqd = DBC_Controller(&mcDBC, Iqdref, Iqd, hElSpeedDpp);
+        }
+        else{
+            Vqd.qV_Component1 = PI_Controller(&pidIq,
+                                    (int32_t)Iqdref.qI_Component1 - Iqd.qI_Component1);
+            Vqd.qV_Component2 = PI_Controller(&pidId,
+                                    (int32_t)Iqdref.qI_Component2 - Iqd.qI_Component2);
+        }
+        module = hypot(Vqd.qV_Component1, Vqd.qV_Component2);
+        if(module > MAX_MODULE){
+            Vqd.qV_Component1 = (int16_t)(Vqd.qV_Component1 * MAX_MODULE / module);
+            Vqd.qV_Component2 = (int16_t)(Vqd.qV_Component2 * MAX_MODULE / module);
+        }
+        if(c->bDeadbeat){
+            DBC_SetAppliedVoltage(&mcDBC, Vqd);
+        }
+        vq[1] = Vqd.qV_Component1 * vDigit;
+        vd[1] = Vqd.qV_Component2 * vDigit;
+        angle[1] = wAdvance * 2.0 * M_PI / 65536.0;
+
+        /* angle[] is the rotor angle the voltage was turned at, from the
+         * rotor angle at this sample, it runs behind as the rotor turns */
+        for(i = 0; i < MC_DBC_SUBSTEPS; i++){
+            double tau = (i + 0.5) / MC_DBC_SUBSTEPS;
+            int n = (tau < c->update) ? 0 : 1;
+            double e = angle[n] - we * period * tau;
+            double ud = vd[n] * cos(e) - vq[n] * sin(e);
+            double uq = vd[n] * sin(e) + vq[n] * cos(e);
+            double did = (ud - RS * id + we * ls * iq) / ls;
+            double diq = (uq - RS * iq - we * ls * id - we * flux) / ls;
+
+            id += did * period / MC_DBC_SUBSTEPS;
+            iq += diq * period / MC_DBC_SUBSTEPS;
+        }
+        vq[0] = vq[1];
+        vd[0] = vd[1];
+        angle[0] = angle[1] - we * period;
+    }
+}
+
+/* Sample to update of R3_1_F30X_GetUpdateDelay, the firmware advances the
+ * inverse Park with ANGLE_DELAY_COMPENSATION */
+#define MC_FOC_UPDATE           0.75
+#ifdef ANGLE_DELAY_COMPENSATION
+#define MC_FOC_ADVANCE          true
+#else
+#define MC_FOC_ADVANCE          false
+#endif
+
+static void mc_dbcReport(const char *what, bool bDeadbeat, int16_t hKp, int16_t hKi,
+                         double lsFactor, uint32_t *periods){
+    mc_focCase_t c = {bDeadbeat, hKp, hKi, MC_DBC_RPM, 1.0, lsFactor, MC_FOC_UPDATE, MC_FOC_ADVANCE};
+    mc_focResult_t r;
+
+    mc_focStep(&c, &r);
+    *periods = r.settled;
+    printf("  %-22s within 5 %% after %u periods, overshoot %.1f %%, error %.1f %%\n",
+           what, r.settled, r.overshoot, r.finalError);
+}
+
+/* PI with a 1 kHz bandwidth: Kp = Ls * wc, Ki = Rs * wc * Ts */
+static void mc_dbcTunedPI(int16_t *hKp, int16_t *hKi){
+    double ohmDigit = MC_A_DIGIT * SQRT_3 * 32768.0 / MC_DBC_BUS_V;
+
+    *hKp = (int16_t)lround(LS * 2.0 * M_PI * 1000.0 * ohmDigit * TF_KPDIV);
+    *hKi = (int16_t)lround(RS * 2.0 * M_PI * 1000.0 / TF_REGULATION_RATE * ohmDigit * TF_KIDIV);
+}
+
+static void mc_testDbcStep(void){
+    int16_t hKp, hKi;
+    uint32_t periods, periodsLow, periodsHigh, periodsPI, periodsTuned;
+    char what[32];
+
+    mc_dbcTunedPI(&hKp, &hKi);
+    printf("dbc_step: Iq 0 -> 1 A at %.0f rpm, %.0f V bus, %u Hz FOC, gain %.1f\n",
+           MC_DBC_RPM, MC_DBC_BUS_V, (unsigned)TF_REGULATION_RATE, DBC_DEADBEAT_GAIN);
+    mc_dbcReport("deadbeat", true, 0, 0, 1.0, &periods);
+    mc_dbcReport("deadbeat, Ls 0.7x", true, 0, 0, 0.7, &periodsLow);
+    mc_dbcReport("deadbeat, Ls 1.3x", true, 0, 0, 1.3, &periodsHigh);
+    snprintf(what, sizeof(what), "PI, Kp %d Ki %d", (int)PID_TORQUE_KP_DEFAULT, (int)PID_TORQUE_KI_DEFAULT);
+    mc_dbcReport(what, false, (int16_t)PID_TORQUE_KP_DEFAULT, (int16_t)PID_TORQUE_KI_DEFAULT, 1.0, &periodsPI);
+    mc_dbcReport("PI, 1 kHz bandwidth", false, hKp, hKi, 1.0, &periodsTuned);
+    if(periods > 8U || periodsLow > 8U || periodsHigh > 8U){
+        mc_fail("dbc_step", "deadbeat not within 5 % in 8 periods");
+    }
+    if(periods >= periodsPI || periods >= periodsTuned){
+        mc_fail("dbc_step", "deadbeat not faster than the PI");
+    }
+}
+
+static void mc_delayReport(const char *what, const mc_focResult_t *r){
+    printf("  %-22s within 5 %% after %u periods, Id peak %.2f A, Iq/|I| %.3f, Iq error %.1f %%\n",
+           what, r->settled, r->idMax, r->torquePerAmp, r->finalError);
+}
+
+static void mc_testFocAngleDelay(void){
+    int16_t hKp, hKi;
+    mc_focCase_t c;
+    mc_focResult_t off, on;
+    double rpm;
+
+    mc_dbcTunedPI(&hKp, &hKi);
+    printf("foc_angle_delay: Iq 0 -> %.1f A, update %.2f period after the sample\n",
+           MC_FOC_DELAY_STEP_A, MC_FOC_UPDATE);
+    for(rpm = 1000.0; rpm <= MC_FOC_DELAY_RPM; rpm += 1000.0){
+        int n;
+
+        for(n = 0; n < 2; n++){
+            char what[40];
+
+            c = (mc_focCase_t){n == 0, hKp, hKi, rpm, MC_FOC_DELAY_STEP_A, 1.0, MC_FOC_UPDATE, false};
+            mc_focStep(&c, &off);
+            snprintf(what, sizeof(what), "%s %.0f rpm", (n == 0) ? "deadbeat" : "PI 1 kHz", rpm);
+            mc_delayReport(what, &off);
+            c.bAdvance = true;
+            mc_focStep(&c, &on);
+            snprintf(what, sizeof(what), "  advanced");
+            mc_delayReport(what, &on);
+            /* the Id PI takes the rotation out at steady state, the deadbeat
+             * controller has no integrator */
+            if(on.idMax >= off.idMax){
+                mc_fail("foc_angle_delay", "advance does not reduce the Id excursion");
+            }
+            if(c.bDeadbeat && on.torquePerAmp < 0.995){
+                mc_fail("foc_angle_delay", "deadbeat torque per amp below 0.995 with advance");
+            }
+        }
+    }
+}
+
+
+/* Current oversampling *****************************************************/
+#define MC_OS_NOISE_LSB         2.0     /* ADC noise rms, 12 bit */
+#define MC_OS_CURRENT_A         2.0
+#define MC_OS_PERIODS           20000U
+#define MC_OS_OFFSET            0x8000U /* offset of the phases, JDR left aligned */
+
+static ADC_TypeDef mcADC;
+static TIM_TypeDef mcTIM;
+
+/* JSQR with the channels of the phases A, B and C as 1, 2 and 3, the pair
+ * is repeated in JSQ3 and JSQ4, JL selects two or four conversions */
+#define MC_OS_JSQR(first, second, length) \
+    (((uint32_t)(first) << ADC_JSQR_JSQ1_Pos) | ((uint32_t)(second) << ADC_JSQR_JSQ2_Pos) | \
+     ((uint32_t)(first) << ADC_JSQR_JSQ3_Pos) | ((uint32_t)(second) << ADC_JSQR_JSQ4_Pos) | ((length) - 1U))
+
+#define MC_OS_ALL_SECTORS       ((1u << SECTOR_1) | (1u << SECTOR_2) | (1u << SECTOR_3) | \
+                                 (1u << SECTOR_4) | (1u << SECTOR_5) | (1u << SECTOR_6))
+
+/* R3_1_F30XParamsM1 of Src/mc_config.c, oversampling off and in all sectors */
+#define MC_OS_PARAMS(sectors) { \
+    .ADCx                 = &mcADC, \
+    .bRepetitionCounter   = REP_COUNTER, \
+    .hTafter              = TW_AFTER, \
+    .hTbefore             = TW_BEFORE_R3_1, \
+    .bOversamplingSectors = (sectors), \
+    .hToversampling       = TW_OVERSAMPLING_R3_1, \
+    .TIMx                 = &mcTIM}
+
+static R3_1_F30XParams_t mcOsParamsOff = MC_OS_PARAMS(0u);
+static R3_1_F30XParams_t mcOsParamsAll = MC_OS_PARAMS(MC_OS_ALL_SECTORS);
+
+/* Handle of Src/mc_config.c */
+static void mc_osInit(PWMC_R3_1_F3_Handle_t *pHandle, pR3_1_F30XParams_t pParams){
+    memset(pHandle, 0, sizeof(*pHandle));
+    pHandle->_Super.pFctGetPhaseCurrents      = &R3_1_F30X_GetPhaseCurrents;
+    pHandle->_Super.pFctSetADCSampPointSect1  = &R3_1_F30X_SetADCSampPointSect1;
+    pHandle->_Super.pFctSetADCSampPointSect2  = &R3_1_F30X_SetADCSampPointSect2;
+    pHandle->_Super.pFctSetADCSampPointSect3  = &R3_1_F30X_SetADCSampPointSect3;
+    pHandle->_Super.pFctSetADCSampPointSect4  = &R3_1_F30X_SetADCSampPointSect4;
+    pHandle->_Super.pFctSetADCSampPointSect5  = &R3_1_F30X_SetADCSampPointSect5;
+    pHandle->_Super.pFctSetADCSampPointSect6  = &R3_1_F30X_SetADCSampPointSect6;
+    pHandle->_Super.hT_Sqrt3                  = (PWM_PERIOD_CYCLES*SQRT3FACTOR)/16384u;
+    pHandle->_Super.hPWMperiod                = PWM_PERIOD_CYCLES;
+    pHandle->Half_PWMPeriod                   = PWM_PERIOD_CYCLES/2u;
+    pHandle->wPhaseAOffset = pHandle->wPhaseBOffset = pHandle->wPhaseCOffset = MC_OS_OFFSET;
+    /* R3_1_F30X_Init: the pair of each sector and A, B twice */
+    pHandle->wADC_JSQR_phAB   = MC_OS_JSQR(1U, 2U, 2U);
+    pHandle->wADC_JSQR_phBA   = MC_OS_JSQR(2U, 1U, 2U);
+    pHandle->wADC_JSQR_phAC   = MC_OS_JSQR(1U, 3U, 2U);
+    pHandle->wADC_JSQR_phCA   = MC_OS_JSQR(3U, 1U, 2U);
+    pHandle->wADC_JSQR_phBC   = MC_OS_JSQR(2U, 3U, 2U);
+    pHandle->wADC_JSQR_phCB   = MC_OS_JSQR(3U, 2U, 2U);
+    pHandle->wADC_JSQR_phABAB = MC_OS_JSQR(1U, 2U, 4U);
+    pHandle->pParams_str = pParams;
+}
+
+/* Conversion of the phase current i, digit, of channel 1 to 3 */
+static uint32_t mc_osConvert(const double i[3], uint32_t channel, double noise, uint64_t *seed){
+    double value = MC_OS_OFFSET - i[channel - 1U] + noise * 16.0 * mc_gauss(seed);
+
+    value = floor(value / 16.0 + 0.5) * 16.0;
+    return (uint32_t)((value < 0.0) ? 0.0 : ((value > 65520.0) ? 65520.0 : value));
+}
+
+/* Iq error rms, digit, largest error of Ia and Ib and the share of the
+ * periods with four conversions. Iq is taken in floating point from Ia and
+ * Ib, the sine table of MCM_Park would add its own ripple. */
+static double mc_osRun(pR3_1_F30XParams_t pParams, uint16_t hPWMPeriod, double modulation,
+                       double noise, double *oversampled, double *maxError){
+    PWMC_R3_1_F3_Handle_t handle;
+    uint64_t seed = 7;
+    double sum = 0.0, amplitude = MC_OS_CURRENT_A / MC_A_DIGIT;
+    uint32_t k, count = 0;
+
+    mc_osInit(&handle, pParams);
+    if(hPWMPeriod != PWM_PERIOD_CYCLES){
+        mcTIM.BDTR = 0U;
+        if(!R3_1_F30X_SetPWMPeriod(&handle._Super, hPWMPeriod, REP_COUNTER)){
+            mc_fail("curr_oversampling", "PWM period refused");
+        }
+    }
+    *maxError = 0.0;
+    for(k = 0; k < MC_OS_PERIODS; k++){
+        int16_t hAngle = (int16_t)(k * 37U);
+        double theta = hAngle * M_PI / 32768.0;
+        Volt_Components Vqd = {(int16_t)(modulation * 32767.0), 0};
+        Curr_Components Iab;
+        double i[3], error, iq;
+        uint32_t jsqr;
+
+        PWMC_SetPhaseVoltage(&handle._Super, MCM_Rev_Park(Vqd, hAngle));
+        /* Iq only, MCM_Clarke and MCM_Park */
+        i[0] = amplitude * cos(theta);
+        i[1] = amplitude * cos(theta - 2.0 * M_PI / 3.0);
+        i[2] = -i[0] - i[1];
+        jsqr = (uint32_t)mcADC.JSQR;
+        mcADC.JDR1 = mc_osConvert(i, (jsqr & ADC_JSQR_JSQ1_Msk) >> ADC_JSQR_JSQ1_Pos, noise, &seed);
+        mcADC.JDR2 = mc_osConvert(i, (jsqr & ADC_JSQR_JSQ2_Msk) >> ADC_JSQR_JSQ2_Pos, noise, &seed);
+        mcADC.JDR3 = mc_osConvert(i, (jsqr & ADC_JSQR_JSQ3_Msk) >> ADC_JSQR_JSQ3_Pos, noise, &seed);
+        mcADC.JDR4 = mc_osConvert(i, (jsqr & ADC_JSQR_JSQ4_Msk) >> ADC_JSQR_JSQ4_Pos, noise, &seed);
+        if((jsqr & ADC_JSQR_JL) == 3U){
+            count++;
+        }
+        PWMC_GetPhaseCurrents(&handle._Super, &Iab);
+        iq = Iab.qI_Component1 * cos(theta)
+             + (Iab.qI_Component1 + 2.0 * Iab.qI_Component2) / SQRT_3 * sin(theta);
+        error = iq - amplitude;
+        sum += error * error;
+        error = fmax(fabs(Iab.qI_Component1 - i[0]), fabs(Iab.qI_Component2 - i[1]));
+        if(error > *maxError){
+            *maxError = error;
+        }
+    }
+    *oversampled = 100.0 * count / MC_OS_PERIODS;
+    return sqrt(sum / MC_OS_PERIODS);
+}
+
+static void mc_testCurrOversampling(void){
+    const double modulation[] = {0.3, 0.6, 0.75, 0.9};
+    unsigned n;
+
+    printf("curr_oversampling: %.0f A, noise %.0f LSB rms of 12 bit, %.1f mA per LSB\n",
+           MC_OS_CURRENT_A, MC_OS_NOISE_LSB, 16.0 * MC_A_DIGIT * 1000.0);
+    for(n = 0; n < sizeof(modulation) / sizeof(modulation[0]); n++){
+        double plain, over, share, shareOff, maxPlain, maxOver;
+
+        mc_osRun(&mcOsParamsOff, PWM_PERIOD_CYCLES, modulation[n], 0.0, &shareOff, &maxPlain);
+        mc_osRun(&mcOsParamsAll, PWM_PERIOD_CYCLES, modulation[n], 0.0, &share, &maxOver);
+        if(shareOff != 0.0 || maxPlain > 16.0 || maxOver > 16.0){
+            mc_fail("curr_oversampling", "currents wrong without noise");
+        }
+        plain = mc_osRun(&mcOsParamsOff, PWM_PERIOD_CYCLES, modulation[n], MC_OS_NOISE_LSB,
+                         &shareOff, &maxPlain);
+        over = mc_osRun(&mcOsParamsAll, PWM_PERIOD_CYCLES, modulation[n], MC_OS_NOISE_LSB,
+                        &share, &maxOver);
+        printf("  modulation %.2f        %5.1f %% oversampled, Iq noise %.1f -> %.1f mA rms (%.2f)\n",
+               modulation[n], share, plain * MC_A_DIGIT * 1000.0, over * MC_A_DIGIT * 1000.0, over / plain);
+        if(n == 0 && (share < 100.0 || over > 0.75 * plain)){
+            mc_fail("curr_oversampling", "noise not reduced at low modulation");
+        }
+    }
+}
+
+
+/* PWM frequency ************************************************************/
+#define MC_PWM_KI_TUNED         2959    /* Ki restored from flash, at TF_REGULATION_RATE */
+#define MC_PWM_CHANGES          1000U
+
+/* Settings of FOC_PWMFrequencyPolicy, the default last */
+static const struct{
+    uint16_t    hPWMFrequencyHz;
+    uint8_t     bRegulationRate;
+}mcPwmSettings[] = {
+    {PWM_FREQUENCY_HOT,         REGULATION_EXECUTION_RATE_HOT},
+    {PWM_FREQUENCY_LOW_SPEED,   REGULATION_EXECUTION_RATE_LOW_SPEED},
+    {PWM_FREQUENCY,             REGULATION_EXECUTION_RATE}
+};
+
+/* Timer period of FOC_SetPWMFrequency */
+static uint16_t mc_pwmPeriod(uint16_t hPWMFrequencyHz){
+    return (uint16_t)(((ADV_TIM_CLK_MHz * 1000000uL) / hPWMFrequencyHz) & ~1uL);
+}
+
+static void mc_testPwmPeriod(void){
+    const double modulation[] = {0.3, 0.6, 0.9};
+    PWMC_R3_1_F3_Handle_t handle;
+    unsigned n, m;
+
+    mc_osInit(&handle, &mcOsParamsAll);
+    mcTIM.ARR = PWM_PERIOD_CYCLES / 2U;
+    mcTIM.RCR = REP_COUNTER;
+    mcTIM.BDTR = TIM_BDTR_MOE;
+    if(R3_1_F30X_SetPWMPeriod(&handle._Super, mc_pwmPeriod(PWM_FREQUENCY_HOT), 3U)
+       || mcTIM.ARR != PWM_PERIOD_CYCLES / 2U || mcTIM.RCR != REP_COUNTER
+       || handle.Half_PWMPeriod != PWM_PERIOD_CYCLES / 2U || handle.bRepetitionCounter != 0U){
+        mc_fail("pwm_period", "period changed with the outputs on");
+    }
+    mcTIM.BDTR = 0U;
+    if(R3_1_F30X_SetPWMPeriod(&handle._Super, 2U * (TW_AFTER + TW_BEFORE_R3_1), 3U)
+       || mcTIM.ARR != PWM_PERIOD_CYCLES / 2U){
+        mc_fail("pwm_period", "period shorter than the sampling accepted");
+    }
+    printf("pwm_period: refused with MOE set and below %u counts\n", 2U * (TW_AFTER + TW_BEFORE_R3_1) + 2U);
+
+    for(n = 0; n < sizeof(mcPwmSettings) / sizeof(mcPwmSettings[0]); n++){
+        uint16_t hPeriod = mc_pwmPeriod(mcPwmSettings[n].hPWMFrequencyHz);
+        uint8_t bRepetition = (uint8_t)((2u * mcPwmSettings[n].bRegulationRate) - 1u);
+        double share, maxError, worst = 0.0;
+        uint32_t arr, rcr;
+
+        if(!R3_1_F30X_SetPWMPeriod(&handle._Super, hPeriod, bRepetition)
+           || mcTIM.ARR != hPeriod / 2U || mcTIM.RCR != bRepetition
+           || (mcTIM.CR1 & TIM_CR1_ARPE) == 0U
+           || handle._Super.hPWMperiod != hPeriod || handle.Half_PWMPeriod != hPeriod / 2U
+           || handle._Super.hT_Sqrt3 != (uint16_t)(((uint32_t)hPeriod * SQRT3FACTOR) / 16384u)
+           || handle.bRepetitionCounter != bRepetition){
+            mc_fail("pwm_period", "timer registers or handle wrong");
+        }
+        arr = mcTIM.ARR;
+        rcr = mcTIM.RCR;
+        /* Sampling points follow the period, currents exact without noise */
+        for(m = 0; m < sizeof(modulation) / sizeof(modulation[0]); m++){
+            mc_osRun(&mcOsParamsAll, hPeriod, modulation[m], 0.0, &share, &maxError);
+            worst = fmax(worst, maxError);
+        }
+        printf("  %5u Hz / %u: ARR %u, RCR %u, largest current error %.0f digit\n",
+               mcPwmSettings[n].hPWMFrequencyHz, mcPwmSettings[n].bRegulationRate,
+               (unsigned)arr, (unsigned)rcr, worst);
+        if(worst > 16.0){
+            mc_fail("pwm_period", "currents wrong at the new period");
+        }
+    }
+}
+
+static void mc_testPwmKiRescale(void){
+    PID_Handle_t pid = {.hDefKiGain = PID_TORQUE_KI_DEFAULT, .hKiDivisor = TF_KIDIV,
+                        .hKiDivisorPOW2 = TF_KIDIV_LOG};
+    uint64_t seed = 3;
+    uint16_t hRate = TF_REGULATION_RATE;
+    double exact = (double)MC_PWM_KI_TUNED * TF_REGULATION_RATE, worst = 0.0;
+    int16_t hKiDefault;
+    unsigned k;
+
+    PID_HandleInit(&pid);
+    PID_SetKI(&pid, MC_PWM_KI_TUNED);
+    for(k = 0; k < MC_PWM_CHANGES; k++){
+        unsigned n = mc_random(&seed) % (sizeof(mcPwmSettings) / sizeof(mcPwmSettings[0]));
+        uint16_t hNewRate = mcPwmSettings[n].hPWMFrequencyHz / mcPwmSettings[n].bRegulationRate;
+
+        if(!PID_ScaleKI(&pid, hRate, hNewRate)){
+            mc_fail("pwm_ki_rescale", "rescale refused");
+        }
+        hRate = hNewRate;
+        worst = fmax(worst, fabs(PID_GetKI(&pid) - exact / hRate));
+        if(hRate == TF_REGULATION_RATE && PID_GetKI(&pid) != MC_PWM_KI_TUNED){
+            mc_fail("pwm_ki_rescale", "tuned gain not given back at the default rate");
+        }
+    }
+    /* Gain of the default Ki, as before the rescale of the gain in use */
+    hKiDefault = (int16_t)(((int32_t)PID_GetDefaultKI(&pid) * TF_REGULATION_RATE + hRate / 2) / hRate);
+    printf("pwm_ki_rescale: Ki %d at %u Hz after %u rate changes, within %.2f of Ki * Ts, "
+           "the default gain gives %d\n", PID_GetKI(&pid), hRate, MC_PWM_CHANGES, worst, hKiDefault);
+    if(worst >= 1.0){
+        mc_fail("pwm_ki_rescale", "gain drifted");
+    }
+
+    PID_SetKI(&pid, INT16_MAX / 2 + 1);
+    if(PID_ScaleKI(&pid, TF_REGULATION_RATE, TF_REGULATION_RATE / 2U) || PID_GetKI(&pid) != INT16_MAX / 2 + 1){
+        mc_fail("pwm_ki_rescale", "gain over int16_t not refused");
+    }
+}
+
+
+/* Loss minimization ********************************************************/
+#define MC_LMC_SPEED_01HZ       500
+#define MC_LMC_POWER_W          50.0
+#define MC_LMC_EXCESS_W         2.0
+#define MC_LMC_ID_OPT           (-6 * LMC_ID_STEP)
+#define MC_LMC_NOISE_W          1.5
+#define MC_LMC_RUN_S            300U
+
+static LMC_Handle_t mcLMC;
+
+/* Handle of Src/mc_config.c */
+static void mc_lmcInit(void){
+    memset(&mcLMC, 0, sizeof(mcLMC));
+    mcLMC.hIdStep        = LMC_ID_STEP;
+    mcLMC.hIdMin         = LMC_ID_MIN;
+    mcLMC.hBandWidth01Hz = (uint16_t)((MAX_APPLICATION_SPEED / 6u) / LMC_SPEED_BANDS + 1u);
+    mcLMC.hSettleTicks   = (uint16_t)((uint32_t)LMC_SETTLE_MS * MEDIUM_FREQUENCY_TASK_RATE / 1000);
+    mcLMC.hAverageTicks  = (uint16_t)((uint32_t)LMC_AVERAGE_MS * MEDIUM_FREQUENCY_TASK_RATE / 1000);
+    mcLMC.hHoldWindows   = LMC_HOLD_WINDOWS;
+    mcLMC.hMinGain_dW    = LMC_MIN_GAIN_DW;
+    mcLMC.hIqTolerance   = LMC_IQ_TOLERANCE;
+    LMC_Init(&mcLMC);
+}
+
+/* Power above the minimum at hId, convex, MC_LMC_EXCESS_W at Id = 0 */
+static double mc_lmcExcess(int16_t hId){
+    double d = (double)(hId - MC_LMC_ID_OPT) / MC_LMC_ID_OPT;
+
+    return MC_LMC_EXCESS_W * d * d;
+}
+
+static void mc_testLmcSearch(void){
+    uint64_t seed = 1;
+    uint32_t step, reached = 0;
+    double mean = 0.0, maxLearned = 0.0;
+    int16_t hId = 0;
+
+    mc_lmcInit();
+    for(step = 0; step < MC_LMC_RUN_S * MC_MF_HZ; step++){
+        double power = MC_LMC_POWER_W + mc_lmcExcess(hId) + MC_LMC_NOISE_W * mc_gauss(&seed);
+        double learned = mc_lmcExcess(LMC_GetBandIdref(&mcLMC, MC_LMC_SPEED_01HZ / mcLMC.hBandWidth01Hz));
+
+        hId = LMC_CalcIdref(&mcLMC, MC_LMC_SPEED_01HZ, 5000, (int16_t)lround(power), true);
+        if(reached == 0U && learned < 0.1){
+            reached = step;
+        }
+        if(step >= (MC_LMC_RUN_S - 100U) * MC_MF_HZ){
+            mean += mc_lmcExcess(hId) / (100.0 * MC_MF_HZ);
+            if(learned > maxLearned) maxLearned = learned;
+        }
+    }
+
+    printf("lmc_search: %.0f W excess at Id 0, minimum at Id %d, noise %.1f W rms, 1 W steps\n",
+           MC_LMC_EXCESS_W, MC_LMC_ID_OPT, MC_LMC_NOISE_W);
+    printf("  learned within 0.1 W   after %.0f s\n", (double)reached / MC_MF_HZ);
+    printf("  last 100 s             excess %.3f W mean, learned Id %.2f W above the minimum at most\n",
+           mean, maxLearned);
+    if(reached == 0U || reached > 120U * MC_MF_HZ || mean > 0.1){
+        mc_fail("lmc_search", "minimum not found or not held");
+    }
+}
+
+
+/* Regenerative brake control ***********************************************/
+#define MC_RBC_SAFETY_HZ        SYS_TICK_FREQUENCY
+#define MC_RBC_SUBSTEPS         10U
+#define MC_RBC_SUPPLY_V         24.0
+#define MC_RBC_RS               0.3     /* low resistance winding, the stock one absorbs the energy */
+#define MC_RBC_FAN_W            10.0    /* fan load at 3000 rpm, quadratic torque */
+#define MC_RBC_AUX_W            1.0
+#define MC_RBC_FROM_RPM         3000.0
+#define MC_RBC_TO_RPM           300.0
+#define MC_RBC_MAX_BUS_V        (MCU_SUPPLY_VOLTAGE / VBUS_PARTITIONING_FACTOR)
+
+/* Flux of the motor, torque per A of Iq, inertia from MOTOR_ACCEL_01HZ_S */
+#define MC_RBC_FLUX             (MOTOR_VOLTAGE_CONSTANT * SQRT_2 / SQRT_3 * 60.0 / \
+                                 (1000.0 * 2.0 * M_PI * POLE_PAIR_NUM))
+#define MC_RBC_KT               (1.5 * POLE_PAIR_NUM * MC_RBC_FLUX)
+#define MC_RBC_J                (MC_RBC_KT * NOMINAL_CURRENT * MC_A_DIGIT / \
+                                 (MOTOR_ACCEL_01HZ_S / 10.0 * 2.0 * M_PI))
+
+typedef struct {
+    double capacitance;         /* DC link, F */
+    double resistor;            /* brake resistor, ohm, 0 if not fitted */
+    double ramp_s;              /* speed ramp from MC_RBC_FROM_RPM to MC_RBC_TO_RPM */
+    bool   bRegulator;          /* RegenBrakeCtrl in the safety task */
+} mc_rbcCase_t;
+
+static DOUT_handle_t mcBrakeResistor;
+
+/* Brake resistor output of the firmware, the state only */
+void DOUT_SetOutputState(DOUT_handle_t *pHandle, DOutputState_t State){
+    pHandle->OutputState = State;
+}
+
+DOutputState_t DOUT_GetOutputState(DOUT_handle_t *pHandle){
+    return pHandle->OutputState;
+}
+
+/* Deceleration with the speed PI of Src/mc_config.c at MC_MF_HZ, limited
+ * and frozen at the braking limit as in TSK_MediumFrequencyTaskM1, and the
+ * RegenBrakeCtrl of Src/mc_config.c in the safety task. The current loop follows the references, the supply
+ * only sources current. Returns the time to reach MC_RBC_TO_RPM in s, 0 if
+ * the bus reached OV_VOLTAGE_THRESHOLD_V, and the peak bus voltage. */
+static double mc_rbcRun(const mc_rbcCase_t *c, double *peak){
+    PID_Handle_t pidSpeed, pidRegen;
+    RBC_Handle_t rbc;
+    Curr_Components Iqdref = {0, 0};
+    double fan = MC_RBC_FAN_W / pow(MC_RBC_FROM_RPM / 60.0 * 2.0 * M_PI, 3.0);
+    double omega = MC_RBC_FROM_RPM / 60.0 * 2.0 * M_PI, bus = MC_RBC_SUPPLY_V;
+    double dt = 1.0 / MC_RBC_SAFETY_HZ / MC_RBC_SUBSTEPS;
+    uint32_t tick, i;
+
+    memset(&pidSpeed, 0, sizeof(pidSpeed));
+    pidSpeed.hDefKpGain          = (int16_t)PID_SPEED_KP_DEFAULT;
+    pidSpeed.hDefKiGain          = (int16_t)PID_SPEED_KI_DEFAULT;
+    pidSpeed.hKpDivisor          = (uint16_t)SP_KPDIV;
+    pidSpeed.hKiDivisor          = (uint16_t)SP_KIDIV;
+    pidSpeed.hKpDivisorPOW2      = (uint16_t)SP_KPDIV_LOG;
+    pidSpeed.hKiDivisorPOW2      = (uint16_t)SP_KIDIV_LOG;
+    PID_HandleInit(&pidSpeed);
+
+    memset(&pidRegen, 0, sizeof(pidRegen));
+    pidRegen.hDefKpGain          = (int16_t)PID_REGEN_KP_DEFAULT;
+    pidRegen.hDefKiGain          = (int16_t)PID_REGEN_KI_DEFAULT;
+    pidRegen.wUpperIntegralLimit = (int32_t)IQMAX * REGEN_KIDIV;
+    pidRegen.wLowerIntegralLimit = 0;
+    pidRegen.hUpperOutputLimit   = (int16_t)IQMAX;
+    pidRegen.hLowerOutputLimit   = 0;
+    pidRegen.hKpDivisor          = (uint16_t)REGEN_KPDIV;
+    pidRegen.hKiDivisor          = (uint16_t)REGEN_KIDIV;
+    pidRegen.hKpDivisorPOW2      = (uint16_t)REGEN_KPDIV_LOG;
+    pidRegen.hKiDivisorPOW2      = (uint16_t)REGEN_KIDIV_LOG;
+    pidRegen.hDefKdGain          = (int16_t)PID_REGEN_KD_DEFAULT;
+    pidRegen.hKdDivisor          = (uint16_t)REGEN_KDDIV;
+    pidRegen.hKdDivisorPOW2      = (uint16_t)REGEN_KDDIV_LOG;
+
+    memset(&rbc, 0, sizeof(rbc));
+    rbc.hVbusRef_d     = REGEN_VBUS_REF_d;
+    rbc.hIdStart_d     = REGEN_ID_START_d;
+    rbc.hBrakeStart_d  = R_BRAKE_SWITCH_OFF_THRES_d;
+    rbc.hIdBrakeMax    = REGEN_ID_MAX;
+    rbc.hMaxRegenIq    = (int16_t)IQMAX;
+    rbc.wNominalSqCurr = (int32_t)NOMINAL_CURRENT * NOMINAL_CURRENT;
+    memset(&mcBrakeResistor, 0, sizeof(mcBrakeResistor));
+    RBC_Init(&rbc, &pidRegen, (c->resistor > 0.0) ? &mcBrakeResistor : MC_NULL);
+
+    /* steady state at MC_RBC_FROM_RPM against the fan */
+    Iqdref.qI_Component1 = (int16_t)lround(fan * omega * omega / MC_RBC_KT / MC_A_DIGIT);
+    PID_SetIntegralTerm(&pidSpeed, (int32_t)Iqdref.qI_Component1 * (int32_t)SP_KIDIV);
+
+    *peak = bus;
+    for(tick = 0; tick < 20U * MC_RBC_SAFETY_HZ; tick++){
+        double t = (double)tick / MC_RBC_SAFETY_HZ;
+        int16_t hSpeed = (int16_t)lround(omega / (2.0 * M_PI) * 10.0);
+
+        if(tick % (MC_RBC_SAFETY_HZ / MC_MF_HZ) == 0U){
+            double target = MC_RBC_FROM_RPM - (MC_RBC_FROM_RPM - MC_RBC_TO_RPM) * fmin(t / c->ramp_s, 1.0);
+            int16_t hUpperLimit = (int16_t)IQMAX, hLowerLimit = -(int16_t)IQMAX;
+            int32_t wIntegral = PID_GetIntegralTerm(&pidSpeed);
+
+            if(c->bRegulator && hSpeed > 0 && RBC_GetRegenIqLimit(&rbc) < hUpperLimit){
+                hLowerLimit = -RBC_GetRegenIqLimit(&rbc);
+            }
+            PID_SetUpperOutputLimit(&pidSpeed, hUpperLimit);
+            PID_SetLowerOutputLimit(&pidSpeed, hLowerLimit);
+            PID_SetUpperIntegralTermLimit(&pidSpeed, (int32_t)hUpperLimit * (int32_t)SP_KIDIV);
+            PID_SetLowerIntegralTermLimit(&pidSpeed, (int32_t)hLowerLimit * (int32_t)SP_KIDIV);
+            Iqdref.qI_Component1 = PI_Controller(&pidSpeed, (int32_t)lround(target / 6.0) - hSpeed);
+            if(c->bRegulator && hSpeed > 0 && Iqdref.qI_Component1 <= hLowerLimit){
+                PID_SetIntegralTerm(&pidSpeed, wIntegral);
+            }
+        }
+        if(c->bRegulator){
+            RBC_CalcBusVoltageCtrl(&rbc, (uint16_t)(bus / MC_RBC_MAX_BUS_V * 65535));
+            Iqdref = RBC_CalcCurrRef(&rbc, Iqdref, hSpeed);
+        }
+
+        for(i = 0; i < MC_RBC_SUBSTEPS; i++){
+            double iq = Iqdref.qI_Component1 * MC_A_DIGIT, id = Iqdref.qI_Component2 * MC_A_DIGIT;
+            double drawn = 1.5 * MC_RBC_RS * (iq * iq + id * id) + MC_RBC_KT * iq * omega + MC_RBC_AUX_W;
+
+            if(mcBrakeResistor.OutputState == ACTIVE){
+                drawn += bus * bus / c->resistor;
+            }
+            omega += (MC_RBC_KT * iq - fan * omega * omega) / MC_RBC_J * dt;
+            bus = sqrt(fmax(bus * bus - 2.0 * drawn * dt / c->capacitance, 0.0));
+            bus = fmax(bus, MC_RBC_SUPPLY_V);
+        }
+        if(bus > *peak){
+            *peak = bus;
+        }
+        if(bus >= OV_VOLTAGE_THRESHOLD_V){
+            return 0.0;
+        }
+        if(omega <= MC_RBC_TO_RPM / 60.0 * 2.0 * M_PI * 1.05){
+            return t;
+        }
+    }
+    return 20.0;
+}
+
+static void mc_testRbcBrake(void){
+    static const mc_rbcCase_t cases[] = {
+        {470e-6, 0.0,  0.1, true},
+        {470e-6, 15.0, 0.1, true},
+        {220e-6, 0.0,  0.1, true}
+    };
+    static const char *what[] = {"470 uF", "470 uF, 15 ohm", "220 uF"};
+    mc_rbcCase_t open = {470e-6, 0.0, 0.1, false};
+    double peak, time;
+    unsigned n;
+
+    printf("rbc_brake: %.0f to %.0f rpm, %.0f V supply, %.1f ohm winding, %.0f W fan, OV at %d V\n",
+           MC_RBC_FROM_RPM, MC_RBC_TO_RPM, MC_RBC_SUPPLY_V, MC_RBC_RS, MC_RBC_FAN_W,
+           (int)OV_VOLTAGE_THRESHOLD_V);
+    while(open.ramp_s < 20.0 && mc_rbcRun(&open, &peak) == 0.0){
+        open.ramp_s += 0.1;
+    }
+    printf("  without the regulator  overvoltage with a ramp under %.1f s\n", open.ramp_s);
+    for(n = 0; n < sizeof(cases) / sizeof(cases[0]); n++){
+        time = mc_rbcRun(&cases[n], &peak);
+        printf("  0.1 s ramp, %-14s ", what[n]);
+        if(time == 0.0){
+            printf("overvoltage, peak %.1f V\n", peak);
+            mc_fail("rbc_brake", "overvoltage with the regulator");
+        }
+        printf("done in %.2f s, peak %.1f V\n", time, peak);
+        if(time >= 2.0){
+            mc_fail("rbc_brake", "deceleration not done in 2 s");
+        }
+    }
+}
+
+
+/* Condition monitor *********************************************************/
+#define MC_CMON_SHAFT_01HZ      250
+#define MC_CMON_IQ              3000.0
+#define MC_CMON_1X              150.0
+#define MC_CMON_BPFO            100.0
+#define MC_CMON_NOISE           20.0
+#define MC_CMON_DECIMATION      (TF_REGULATION_RATE / 1000U)
+#define MC_CMON_FS              (TF_REGULATION_RATE / MC_CMON_DECIMATION)
+
+extern const CO_OD_entry_t CO_OD[CO_OD_NoOfElements];  /* Object Dictionary array */
+
+static uint32_t mcCmonTrig, mcCmonSqrt;
+
+Trig_Components __real_MCM_Trig_Functions(int16_t hAngle);
+int32_t __real_MCM_Sqrt(int32_t wInput);
+
+Trig_Components __wrap_MCM_Trig_Functions(int16_t hAngle){
+    mcCmonTrig++;
+    return __real_MCM_Trig_Functions(hAngle);
+}
+
+int32_t __wrap_MCM_Sqrt(int32_t wInput){
+    mcCmonSqrt++;
+    return __real_MCM_Sqrt(wInput);
+}
+
+State_t MCI_GetSTMStateMotor1(void){
+    return RUN;
+}
+
+int16_t MC_GetMecSpeedAverageMotor1(void){
+    return MC_CMON_SHAFT_01HZ;
+}
+
+/* Iq at FOC cycle n */
+static int16_t mc_cmonIq(uint32_t n, uint64_t *seed){
+    double t = (double)n / TF_REGULATION_RATE;
+    double shaft = MC_CMON_SHAFT_01HZ / 10.0;
+
+    return (int16_t)lround(MC_CMON_IQ + MC_CMON_1X * sin(2.0 * M_PI * shaft * t) +
+                           MC_CMON_BPFO * sin(2.0 * M_PI * shaft * BEARING_BPFO_RATIO * t + 1.0) +
+                           MC_CMON_NOISE * mc_gauss(seed));
+}
+
+/* Magnitudes of the record as CMON_Process: mean removed, gain of 8, Hann
+ * window, DFT scaled down by CMON_FFT_LEN */
+static void mc_cmonSpectrum(const int16_t *x, double *mag){
+    int32_t sum = 0;
+    double re, im, w;
+    unsigned k, n;
+
+    for(n = 0; n < CMON_FFT_LEN; n++){
+        sum += x[n];
+    }
+    for(k = 0; k < CMON_FFT_LEN / 2U; k++){
+        re = im = 0.0;
+        for(n = 0; n < CMON_FFT_LEN; n++){
+            w = (1.0 - cos(2.0 * M_PI * n / CMON_FFT_LEN)) / 2.0;
+            re += (x[n] - sum / (int32_t)CMON_FFT_LEN) * 8.0 * w * cos(2.0 * M_PI * k * n / CMON_FFT_LEN);
+            im -= (x[n] - sum / (int32_t)CMON_FFT_LEN) * 8.0 * w * sin(2.0 * M_PI * k * n / CMON_FFT_LEN);
+        }
+        mag[k] = sqrt(re * re + im * im) / CMON_FFT_LEN;
+    }
+}
+
+/* Highest magnitude within one bin of frequency f */
+static double mc_cmonPeak(const double *mag, double f){
+    unsigned bin = (unsigned)lround(f * CMON_FFT_LEN / MC_CMON_FS);
+    double peak = 0.0;
+    unsigned k;
+
+    for(k = bin - 1U; k <= bin + 1U; k++){
+        peak = (mag[k] > peak) ? mag[k] : peak;
+    }
+    return peak;
+}
+
+static void mc_cmonCheck(const char *what, uint16_t value, double ref){
+    printf("  %-22s %5u, DFT %7.1f\n", what, value, ref);
+    if(fabs(value - ref) > 0.03 * ref + 3.0){
+        mc_fail("cmon_bpfo", what);
+    }
+}
+
+static void mc_testCmonBpfo(void){
+    static const char *odNames[] = {"shaft frequency", "floor", "imbalance", "eccentricity",
+                                    "BPFO", "BPFI", "records"};
+    int16_t record[CMON_FFT_LEN];
+    double mag[CMON_FFT_LEN / 2U], floor = 0.0, shaft = MC_CMON_SHAFT_01HZ / 10.0;
+    uint16_t features[CMON_FEATURES_NBR];
+    uint32_t maxTrig = 0, maxSqrt = 0, steps = 0, n = 0, records = 0;
+    const CO_OD_entry_t *entry = NULL;
+    uint64_t seed = 87;
+    unsigned i, k;
+
+    printf("cmon_bpfo: %.1f Hz shaft, %.0f digit BPFO at %.1f Hz, %.0f digit rms noise, %u Hz sampling\n",
+           shaft, MC_CMON_BPFO, shaft * BEARING_BPFO_RATIO, MC_CMON_NOISE, MC_CMON_FS);
+    CMON_Init();
+    CMON_SetFOCFrequency(TF_REGULATION_RATE);
+    /* The first tick arms the record, every MC_CMON_DECIMATION-th FOC cycle
+     * after it is recorded */
+    while(records < 2U && steps < 10000U){
+        mcCmonTrig = mcCmonSqrt = 0;
+        if(CMON_Process()){
+            records++;
+            if(records == 1U){
+                CMON_GetFeatures(features);
+            }
+            CMON_GetFeatures(OD_conditionMonitor);
+        }
+        maxTrig = (mcCmonTrig > maxTrig) ? mcCmonTrig : maxTrig;
+        maxSqrt = (mcCmonSqrt > maxSqrt) ? mcCmonSqrt : maxSqrt;
+        steps++;
+        for(i = 0; i < MC_CMON_DECIMATION; i++, n++){
+            int16_t iq = mc_cmonIq(n, &seed);
+
+            if(records == 0U && n % MC_CMON_DECIMATION == MC_CMON_DECIMATION - 1U &&
+               n / MC_CMON_DECIMATION < CMON_FFT_LEN){
+                record[n / MC_CMON_DECIMATION] = iq;
+            }
+            CMON_Sample(iq);
+        }
+    }
+    if(records < 2U){
+        mc_fail("cmon_bpfo", "no record analysed");
+    }
+
+    mc_cmonSpectrum(record, mag);
+    for(k = 1; k < CMON_FFT_LEN / 2U; k++){
+        floor += mag[k] / (CMON_FFT_LEN / 2U - 1U);
+    }
+    printf("  worst step             %u MCM_Trig_Functions, %u MCM_Sqrt, %u ticks for 2 records\n",
+           maxTrig, maxSqrt, steps);
+    if(features[CMON_FEAT_SHAFT_FREQ] != MC_CMON_SHAFT_01HZ){
+        mc_fail("cmon_bpfo", "shaft frequency");
+    }
+    mc_cmonCheck("floor", features[CMON_FEAT_FLOOR], floor);
+    mc_cmonCheck("imbalance", features[CMON_FEAT_IMBALANCE], mc_cmonPeak(mag, shaft));
+    mc_cmonCheck("eccentricity", features[CMON_FEAT_ECCENTRIC], mc_cmonPeak(mag, 2.0 * shaft));
+    mc_cmonCheck("BPFO", features[CMON_FEAT_BPFO], mc_cmonPeak(mag, shaft * BEARING_BPFO_RATIO));
+    mc_cmonCheck("BPFI", features[CMON_FEAT_BPFI], mc_cmonPeak(mag, shaft * BEARING_BPFI_RATIO));
+    if(features[CMON_FEAT_BPFO] < 4U * features[CMON_FEAT_FLOOR] ||
+       features[CMON_FEAT_BPFO] < 4U * features[CMON_FEAT_BPFI]){
+        mc_fail("cmon_bpfo", "BPFO line not over the floor and the BPFI bins");
+    }
+    if(maxTrig > 64U || maxSqrt > 32U){
+        mc_fail("cmon_bpfo", "step not chunked");
+    }
+
+    /* Object dictionary, as read by the SDO server */
+    for(i = 0; i < CO_OD_NoOfElements; i++){
+        if(CO_OD[i].index == 0x2140U){
+            entry = &CO_OD[i];
+        }
+    }
+    if(entry == NULL || entry->maxSubIndex != CMON_FEATURES_NBR || entry->length != 2U ||
+       entry->pData != (void *)&OD_conditionMonitor[0]){
+        mc_fail("cmon_bpfo", "OD 0x2140 not the features");
+    }
+    if((entry->attribute & (CO_ODA_READABLE | CO_ODA_TPDO_MAPABLE)) != (CO_ODA_READABLE | CO_ODA_TPDO_MAPABLE) ||
+       (entry->attribute & CO_ODA_WRITEABLE) != 0U){
+        mc_fail("cmon_bpfo", "OD 0x2140 attributes");
+    }
+    CMON_GetFeatures(features);
+    for(k = 1; k <= CMON_FEATURES_NBR; k++){
+        uint16_t value = ((const uint16_t *)entry->pData)[k - 1U];
+
+        printf("  0x2140,%u %-16s %5u\n", k, odNames[k - 1U], value);
+        if(value != features[k - 1U]){
+            mc_fail("cmon_bpfo", "OD 0x2140 value");
+        }
+    }
+    if(features[CMON_FEAT_RECORDS] != 2U){
+        mc_fail("cmon_bpfo", "records");
+    }
+}
+
+
+/* Stack monitor **************************************************************/
+#define MC_SMON_WORDS           1024U   /* _estack of the Makefile */
+#define MC_SMON_USED            0x11111111UL
+#define MC_SMON_PATTERN         0xC5C5C5C5UL
+
+uint32_t CO_mcSimStack[MC_SMON_WORDS];
+uint32_t CO_mcSimMSP;
+DWT_Type CO_mcSimDWT;
+CoreDebug_Type CO_mcSimCoreDebug;
+
+/* Stack used up to word msp, painted by SMON_Init */
+static void mc_smonInit(unsigned msp){
+    unsigned i;
+
+    for(i = 0; i < MC_SMON_WORDS; i++){
+        CO_mcSimStack[i] = MC_SMON_USED;
+    }
+    CO_mcSimMSP = (uint32_t)(uintptr_t)&CO_mcSimStack[msp];
+    memset(&CO_mcSimDWT, 0, sizeof(CO_mcSimDWT));
+    memset(&CO_mcSimCoreDebug, 0, sizeof(CO_mcSimCoreDebug));
+    SMON_Init();
+}
+
+/* Calls of SMON_Process until a scan is complete */
+static unsigned mc_smonScan(void){
+    unsigned calls = 1;
+
+    while(!SMON_Process()){
+        if(++calls > MC_SMON_WORDS){
+            mc_fail("smon", "scan never complete");
+        }
+    }
+    return calls;
+}
+
+static uint16_t mc_smonHighWater(void){
+    uint16_t marks[SMON_MARKS_NBR];
+
+    SMON_GetMarks(marks);
+    if(marks[SMON_MARK_SIZE] != MC_SMON_WORDS * 4U){
+        mc_fail("smon", "stack size");
+    }
+    return marks[SMON_MARK_HIGH_WATER];
+}
+
+static void mc_testSmonPaint(void){
+    unsigned i, msp = 1000U;
+
+    mc_smonInit(msp);
+    for(i = 0; i < MC_SMON_WORDS; i++){
+        uint32_t expected = (i < msp - 16U) ? MC_SMON_PATTERN : MC_SMON_USED;
+
+        if(CO_mcSimStack[i] != expected){
+            printf("smon_paint: word %u is 0x%08X\n", i, CO_mcSimStack[i]);
+            mc_fail("smon_paint", (i < msp - 16U) ? "free stack not painted" : "stack in use painted");
+        }
+    }
+    if((CO_mcSimCoreDebug.DEMCR & CoreDebug_DEMCR_TRCENA_Msk) == 0U ||
+       (CO_mcSimDWT.CTRL & DWT_CTRL_CYCCNTENA_Msk) == 0U){
+        mc_fail("smon_paint", "cycle counter not enabled");
+    }
+    if(mc_smonHighWater() != 0U){
+        mc_fail("smon_paint", "high-water mark before the first scan");
+    }
+}
+
+static void mc_testSmonScan(void){
+    unsigned calls, msp = 1000U;
+
+    mc_smonInit(msp);
+    calls = mc_smonScan();
+    printf("smon_scan: first scan %u calls, high water %u bytes\n", calls, mc_smonHighWater());
+    if(calls != (msp - 16U + 63U) / 64U || mc_smonHighWater() != (MC_SMON_WORDS - (msp - 16U)) * 4U){
+        mc_fail("smon_scan", "first scan not stopped at the margin below MSP");
+    }
+
+    /* An interrupt went deeper */
+    CO_mcSimStack[500] = 0;
+    calls = mc_smonScan();
+    printf("smon_scan: word 500 found in %u calls, high water %u bytes\n", calls, mc_smonHighWater());
+    if(calls != 500U / 64U + 1U || mc_smonHighWater() != (MC_SMON_WORDS - 500U) * 4U){
+        mc_fail("smon_scan", "deeper word not found in the call of its chunk");
+    }
+
+    /* Above the mark, and the paint back below it */
+    CO_mcSimStack[900] = 0;
+    CO_mcSimStack[500] = MC_SMON_PATTERN;
+    calls = mc_smonScan();
+    if(calls != (500U + 63U) / 64U || mc_smonHighWater() != (MC_SMON_WORDS - 500U) * 4U){
+        mc_fail("smon_scan", "high-water mark lowered or scan not ended at the mark");
+    }
+}
+
+static void mc_testSmonFocCycles(void){
+    static const struct{
+        uint32_t        start;
+        uint32_t        cyccnt;
+        uint16_t        last;
+        uint16_t        max;
+    }steps[] = {
+        {400U,          1000U,          600U,   600U},
+        {1000U,         1100U,          100U,   600U},
+        {0xFFFFFF00UL,  50U,            306U,   600U},     /* wrap of CYCCNT */
+        {0U,            0x20000UL,      0xFFFFU, 0xFFFFU},
+        {0U,            7000U,          7000U,  0xFFFFU}
+    };
+    uint16_t cycles[SMON_CYCLES_NBR];
+    unsigned i;
+
+    for(i = 0; i < sizeof(steps) / sizeof(steps[0]); i++){
+        CO_mcSimDWT.CYCCNT = steps[i].cyccnt;
+        SMON_FocCycles(steps[i].start);
+        SMON_GetCycles(cycles);
+        if(cycles[SMON_CYCLES_LAST] != steps[i].last || cycles[SMON_CYCLES_MAX] != steps[i].max){
+            printf("smon_foc_cycles: step %u, last %u, max %u\n", i, cycles[SMON_CYCLES_LAST],
+                   cycles[SMON_CYCLES_MAX]);
+            mc_fail("smon_foc_cycles", "cycles");
+        }
+    }
+}
+
+
+/* Main ***********************************************************************/
+typedef struct{
+    const char         *name;
+    void              (*run)(void);
+}mc_test_t;
+
+static const mc_test_t tests[] = {
+    {"gap_crc",             mc_testGapCrc},
+    {"gap_frame",           mc_testGapFrame},
+    {"gap_errors",          mc_testGapErrors},
+    {"thermal_reference",   mc_testThermalReference},
+    {"thermal_peak",        mc_testThermalPeak},
+    {"thermal_duty",        mc_testThermalDuty},
+    {"thermal_hot_ntc",     mc_testThermalHotNtc},
+    {"lto_step",            mc_testLtoStep},
+    {"lto_speed_loop",      mc_testLtoSpeedLoop},
+    {"notch_response",      mc_testNotchResponse},
+    {"notch_search",        mc_testNotchSearch},
+    {"notch_two_mass",      mc_testNotchTwoMass},
+    {"dbc_step",            mc_testDbcStep},
+    {"foc_angle_delay",     mc_testFocAngleDelay},
+    {"curr_oversampling",   mc_testCurrOversampling},
+    {"pwm_period",          mc_testPwmPeriod},
+    {"pwm_ki_rescale",      mc_testPwmKiRescale},
+    {"lmc_search",          mc_testLmcSearch},
+    {"rbc_brake",           mc_testRbcBrake},
+    {"cmon_bpfo",           mc_testCmonBpfo},
+    {"smon_paint",          mc_testSmonPaint},
+    {"smon_scan",           mc_testSmonScan},
+    {"smon_foc_cycles",     mc_testSmonFocCycles}
+};
+
+int main(int argc, char *argv[]){
+    const char *filter = NULL;
+    unsigned i;
+    int c;
+
+    while((c = getopt(argc, argv, "f:")) != -1){
+        switch(c){
+            case 'f': filter = optarg; break;
+            default:
+                fprintf(stderr, "Usage: %s [-f name filter]\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    for(i = 0; i < sizeof(tests) / sizeof(tests[0]); i++){
+        if(filter != NULL && strstr(tests[i].name, filter) == NULL) continue;
+        tests[i].run();
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,42 @@
+/*
+ * SPI, chip select and shut down of the GAP gate driver daisy chain, in
+ * place of the F3 glue of the firmware. The functions are the model of the
+ * chain in mctest/CO_mcTest.c.
+ *
+ * @file        gap_f1f3f4_gate_driver_ctrl.h
+ * @author      Janez Paternoster
+ * @copyright   2015 Janez Paternoster
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef GAP_F1F3F4_GATE_DRIVER_CTRL_H
+#define GAP_F1F3F4_GATE_DRIVER_CTRL_H
+
+#include "gap_gate_driver_ctrl.h"
+
+
+void GAP_CS_Activate(GAP_Handle_t *pHandle);
+void GAP_CS_Deactivate(GAP_Handle_t *pHandle);
+void GAP_SD_Activate(GAP_Handle_t *pHandle);
+void GAP_SD_Deactivate(GAP_Handle_t *pHandle);
+uint16_t GAP_SPI_Send(GAP_Handle_t *pHandle, uint16_t value);
+
+
+#endif
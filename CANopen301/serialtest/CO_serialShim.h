@@ -0,0 +1,45 @@
+/*
+ * Host build of the COBS framed serial link of the motor control protocol,
+ * included before every source of serialtest/CO_serialTest.c with "-include".
+ *
+ * @file        CO_serialShim.h
+ * @author      Janez Paternoster
+ * @copyright   2015 Janez Paternoster
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef CO_SERIAL_SHIM_H
+#define CO_SERIAL_SHIM_H
+
+
+/* HAL, LL and core headers are included first, their guards keep the
+ * redefinitions below. LL USART functions work on the USART of the test. */
+#include "stm32f3xx_hal.h"
+#include "stm32f3xx_ll_usart.h"
+
+
+/* USART interrupt of the test runs between calls of the UI task */
+#undef NVIC_DisableIRQ
+#undef NVIC_EnableIRQ
+#define NVIC_DisableIRQ(IRQn) ((void)(IRQn))
+#define NVIC_EnableIRQ(IRQn)  ((void)(IRQn))
+
+
+#endif
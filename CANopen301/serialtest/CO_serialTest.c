@@ -0,0 +1,494 @@
+/*
+ * Host tests of the COBS framed serial link of the motor control protocol
+ * over a pseudo terminal, with byte errors on the line.
+ *
+ * @file        CO_serialTest.c
+ * @author      Janez Paternoster
+ * @copyright   2015 Janez Paternoster
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/* cobs_frame_communication_protocol.c of the UI library is compiled unchanged
+ * against serialtest/CO_serialShim.h and runs in a child process on the slave
+ * side of a pty. Its client answers like MCP_ReceivedFrame() and waits for
+ * the next frame like MCP_WaitNextFrame(). The USART interrupt sends the
+ * whole transmit ring after every received byte.
+ *
+ * The remote on the master side keeps SER_WINDOW requests in flight and
+ * matches answers by sequence number. Answers come in the order of the
+ * requests, so a request is repeated as soon as the answer of a later request
+ * arrives, and all requests in flight are repeated if the line is idle for
+ * SER_IDLE_MS. Requests are GET/SET sized, every SER_LONG_EVERY one has the
+ * maximum payload.
+ *
+ * Errors are injected on both directions, into bytes read from the pty: with
+ * half of the probability a bit is flipped, with the other half the byte is
+ * lost (overrun). Both sides use their own random sequence, so counts and
+ * line times do not depend on the host, only the wall time does. Line time
+ * is for 115200 baud, 8N1, full duplex.
+ *
+ * clean: no errors, no request is repeated and no frame is discarded.
+ * errors_*: all requests complete with the right answer. */
+
+
+/* Firmware headers first, <termios.h> defines CR1 of the LL registers */
+#include "cobs_frame_communication_protocol.h"
+#include "crc16.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <termios.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+
+#define SER_REQUESTS            3000
+#define SER_WINDOW              4       /* requests in flight, CFCP_RX_SLOTS */
+#define SER_IDLE_MS             50 
+#define SER_IDLE_MAX            20      /* idle repeats in a row, then stalled */
+#define SER_LONG_EVERY          50
+#define SER_BAUD                115200U
+#define SER_BITS_PER_BYTE       10U
+
+
+/* Device, shared with the test */
+typedef struct{
+    uint32_t            rxFrames;
+    uint32_t            rxErrors;
+    uint32_t            rxDropped;
+    uint32_t            sendFailures;
+    uint32_t            txBytes;
+}ser_device_t;
+
+static ser_device_t        *serDevice;
+static CFCP_Handle_t        serCfcp;
+static USART_TypeDef        serUsart;
+
+/* Request in flight, by sequence number */
+typedef struct{
+    uint32_t            index;
+    uint32_t            lastSend;       /* send order of the last copy */
+    int                 inFlight;
+}ser_request_t;
+
+static ser_request_t        serRequest[256];
+static uint32_t             serSendCount;
+static uint32_t             serHostTx;
+static uint32_t             serRetries;
+static uint32_t             serCompleted;
+
+
+/* Helpers ********************************************************************/
+static void ser_fail(const char *name, const char *what){
+    fprintf(stderr, "CO_serialTest: %s: %s\n", name, what);
+    exit(EXIT_FAILURE);
+}
+
+static uint32_t ser_random(uint64_t *state){
+    *state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (uint32_t)(*state >> 33);
+}
+
+/* Byte from the line, 0 if it is lost */
+static int ser_line(uint64_t *state, double errorRate, uint8_t *data){
+    double r = (double)ser_random(state) / 2147483648.0;
+
+    if(r < errorRate / 2.0){
+        return 0;
+    }
+    if(r < errorRate){
+        *data ^= (uint8_t)(1U << (ser_random(state) & 7U));
+    }
+    return 1;
+}
+
+/* Request i: code and payload, about one zero in four bytes */
+static uint8_t ser_requestFrame(uint32_t i, uint8_t *payload, uint8_t *size){
+    uint64_t state = i + 1U;
+    uint8_t n;
+
+    *size = ((i % SER_LONG_EVERY) == 0U) ? FCP_MAX_PAYLOAD_SIZE : (uint8_t)(1U + i % 8U);
+    for(n = 0; n < *size; n++){
+        uint32_t r = ser_random(&state);
+        payload[n] = ((r & 3U) == 0U) ? 0U : (uint8_t)(r >> 8);
+    }
+    return (uint8_t)(0x01U + i % 3U);
+}
+
+/* Answer of the client to a request */
+static uint8_t ser_answer(uint8_t code, const uint8_t *request, uint8_t size, uint8_t *answer){
+    uint8_t length = (size > FCP_MAX_PAYLOAD_SIZE / 4) ? FCP_MAX_PAYLOAD_SIZE : (uint8_t)(size * 4U);
+    uint8_t n;
+
+    for(n = 0; n < length; n++){
+        answer[n] = (uint8_t)(request[n % size] ^ code ^ n);
+    }
+    return length;
+}
+
+
+/* Device *********************************************************************/
+static void ser_clientSent(struct MCP_Handle_s *pClient){
+    (void)pClient;
+    CFCP_AbortReceive(&serCfcp._Super);
+    CFCP_Receive(&serCfcp._Super);
+}
+
+static void ser_clientReceived(struct MCP_Handle_s *pClient, uint8_t code, uint8_t *buffer, uint8_t size){
+    uint8_t answer[FCP_MAX_PAYLOAD_SIZE];
+    uint8_t length;
+
+    (void)pClient;
+    if(size == 0U){
+        serDevice->sendFailures++;
+        return;
+    }
+    length = ser_answer(code, buffer, size, answer);
+    if(CFCP_Send(&serCfcp._Super, FCP_CODE_ACK, answer, length) != FCP_STATUS_WAITING_TRANSFER){
+        serDevice->sendFailures++;
+    }
+}
+
+/* Transmit interrupt while it is enabled, sent bytes go to out */
+static size_t ser_deviceTx(uint8_t *out){
+    size_t n = 0;
+
+    while(LL_USART_IsEnabledIT_TXE(&serUsart)){
+        uint16_t tail = serCfcp.TxTail;
+        CFCP_TX_IRQ_Handler(&serCfcp);
+        if(serCfcp.TxTail != tail){
+            out[n++] = (uint8_t)serUsart.TDR;
+        }
+    }
+    return n;
+}
+
+static void ser_device(int fd, double errorRate){
+    uint64_t state = 0x5EED0001ULL;
+    uint8_t in[256], out[CFCP_TX_RING_SIZE];
+    ssize_t length;
+
+    serCfcp.USARTx = &serUsart;
+    serCfcp.USARTIRQn = USART1_IRQn;
+    CFCP_Init(&serCfcp);
+    FCP_SetClient(&serCfcp._Super, NULL, ser_clientSent, ser_clientReceived, NULL);
+    CFCP_Receive(&serCfcp._Super);
+
+    while((length = read(fd, in, sizeof(in))) > 0){
+        ssize_t i;
+        for(i = 0; i < length; i++){
+            uint8_t data = in[i];
+            size_t n;
+
+            if(!ser_line(&state, errorRate, &data)){
+                CFCP_OVR_IRQ_Handler(&serCfcp);
+                continue;
+            }
+            CFCP_RX_IRQ_Handler(&serCfcp, data);
+            n = ser_deviceTx(out);
+            if(n != 0U && write(fd, out, n) != (ssize_t)n){
+                _exit(EXIT_FAILURE);
+            }
+            serDevice->txBytes += (uint32_t)n;
+        }
+    }
+
+    serDevice->rxFrames = serCfcp.RxFrames;
+    serDevice->rxErrors = serCfcp.RxErrors;
+    serDevice->rxDropped = serCfcp.RxDropped;
+    _exit(EXIT_SUCCESS);
+}
+
+
+/* Remote *********************************************************************/
+static void ser_send(int fd, uint32_t i){
+    uint8_t frame[CFCP_MAX_FRAME_SIZE], out[CFCP_MAX_ENCODED_SIZE];
+    uint8_t size, block = 1;
+    size_t length, n, codePos = 0, o = 1;
+    uint16_t crc;
+
+    frame[0] = (uint8_t)i;
+    frame[1] = ser_requestFrame(i, &frame[CFCP_HEADER_SIZE], &size);
+    length = CFCP_HEADER_SIZE + size;
+    crc = crc16(frame, length);
+    frame[length++] = (uint8_t)crc;
+    frame[length++] = (uint8_t)(crc >> 8);
+
+    /* COBS encoding of the remote, independent of the device */
+    for(n = 0; n < length; n++){
+        if(frame[n] != 0U){
+            out[o++] = frame[n];
+            block++;
+        }
+        if(frame[n] == 0U || block == 0xFFU){
+            out[codePos] = block;
+            codePos = o++;
+            block = 1;
+        }
+    }
+    out[codePos] = block;
+    out[o++] = 0;
+
+    if(write(fd, out, o) != (ssize_t)o){
+        ser_fail("remote", "write to pty failed");
+    }
+    serHostTx += (uint32_t)o;
+    serRequest[(uint8_t)i].index = i;
+    serRequest[(uint8_t)i].lastSend = ++serSendCount;
+    serRequest[(uint8_t)i].inFlight = 1;
+}
+
+/* Decoded answer, returns payload of request and answer, if it completes a
+ * request in flight */
+static unsigned ser_answerReceived(const char *name, int fd, const uint8_t *frame, size_t length){
+    uint8_t request[FCP_MAX_PAYLOAD_SIZE], expected[FCP_MAX_PAYLOAD_SIZE];
+    ser_request_t *r;
+    uint8_t code, size, answerLength;
+    unsigned s;
+
+    if(length < CFCP_HEADER_SIZE + CFCP_CRC_SIZE || crc16(frame, length) != 0U){
+        return 0;
+    }
+    r = &serRequest[frame[0]];
+    if(!r->inFlight){
+        return 0;
+    }
+    code = ser_requestFrame(r->index, request, &size);
+    answerLength = ser_answer(code, request, size, expected);
+    if(frame[1] != FCP_CODE_ACK || length != CFCP_HEADER_SIZE + answerLength + CFCP_CRC_SIZE
+       || memcmp(&frame[CFCP_HEADER_SIZE], expected, answerLength) != 0){
+        ser_fail(name, "answer differs from the request");
+    }
+    r->inFlight = 0;
+    serCompleted++;
+
+    /* answers come in order, earlier requests in flight are lost */
+    for(s = 0; s < 256; s++){
+        if(serRequest[s].inFlight && serRequest[s].lastSend < r->lastSend){
+            ser_send(fd, serRequest[s].index);
+            serRetries++;
+        }
+    }
+    return (unsigned)size + answerLength;
+}
+
+static unsigned long long ser_now(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+}
+
+
+/* Tests **********************************************************************/
+static void ser_run(const char *name, double errorRate){
+    uint64_t state = 0x5EED0002ULL;
+    uint8_t frame[CFCP_MAX_FRAME_SIZE + 1];
+    uint32_t next = 0, idle = 0, idleRepeats = 0;
+    size_t length = 0;
+    uint8_t remain = 0, block = 0xFF;
+    int bad = 0, master, slave, status;
+    uint32_t devTx;
+    unsigned long long wall = ser_now(), payload = 0;
+    double lineTime;
+    struct termios tio;
+    pid_t pid;
+
+    memset(serRequest, 0, sizeof(serRequest));
+    memset(serDevice, 0, sizeof(*serDevice));
+    serSendCount = serHostTx = serRetries = serCompleted = 0;
+
+    master = posix_openpt(O_RDWR | O_NOCTTY);
+    if(master < 0 || grantpt(master) != 0 || unlockpt(master) != 0){
+        ser_fail(name, "no pty");
+    }
+    slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+    if(slave < 0 || tcgetattr(slave, &tio) != 0){
+        ser_fail(name, "no pty slave");
+    }
+    cfmakeraw(&tio);
+    tcsetattr(slave, TCSANOW, &tio);
+
+    fflush(stdout);
+    pid = fork();
+    if(pid < 0){
+        ser_fail(name, "fork failed");
+    }
+    if(pid == 0){
+        close(master);
+        ser_device(slave, errorRate);
+    }
+    close(slave);
+
+    /* new requests after each answer, so both sides only depend on the bytes
+     * they received and not on the reads of the pty */
+    while(next < SER_WINDOW){
+        ser_send(master, next++);
+    }
+    while(serCompleted < SER_REQUESTS){
+        struct pollfd p = {master, POLLIN, 0};
+        uint8_t in[256];
+        ssize_t n, i;
+
+        if(poll(&p, 1, SER_IDLE_MS) == 0){
+            unsigned s;
+            uint32_t order[SER_WINDOW], count = 0, a, b;
+
+            if(++idleRepeats > SER_IDLE_MAX){
+                ser_fail(name, "link stalled");
+            }
+            idle++;
+            /* repeat in the order of sending */
+            for(s = 0; s < 256; s++){
+                if(serRequest[s].inFlight && count < SER_WINDOW) order[count++] = s;
+            }
+            for(a = 1; a < count; a++){
+                for(b = a; b > 0 && serRequest[order[b]].lastSend < serRequest[order[b - 1]].lastSend; b--){
+                    uint32_t t = order[b]; order[b] = order[b - 1]; order[b - 1] = t;
+                }
+            }
+            for(a = 0; a < count; a++){
+                ser_send(master, serRequest[order[a]].index);
+                serRetries++;
+            }
+            continue;
+        }
+        idleRepeats = 0;
+        n = read(master, in, sizeof(in));
+        if(n <= 0){
+            ser_fail(name, "device closed the pty");
+        }
+
+        /* COBS decoding of the remote */
+        for(i = 0; i < n; i++){
+            uint8_t data = in[i];
+
+            if(!ser_line(&state, errorRate, &data)){
+                bad = 1;
+                continue;
+            }
+            if(data == 0U){
+                if(!bad && remain == 0U && length > 0U){
+                    payload += ser_answerReceived(name, master, frame, length);
+                    while(next - serCompleted < SER_WINDOW && next < SER_REQUESTS){
+                        ser_send(master, next++);
+                    }
+                }
+                length = 0;
+                remain = 0;
+                block = 0xFF;
+                bad = 0;
+            }
+            else if(!bad){
+                if(remain == 0U){
+                    if(block != 0xFFU) frame[length++] = 0;
+                    block = data;
+                    remain = (uint8_t)(data - 1U);
+                }
+                else{
+                    frame[length++] = data;
+                    remain--;
+                }
+                if(length > CFCP_MAX_FRAME_SIZE) bad = 1;
+            }
+        }
+    }
+    close(master);
+    if(waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS){
+        ser_fail(name, "device failed");
+    }
+    wall = ser_now() - wall;
+
+    if(serDevice->sendFailures != 0 || serDevice->rxDropped != 0){
+        ser_fail(name, "device did not answer a request");
+    }
+    if(errorRate == 0.0 && (serRetries != 0 || serDevice->rxErrors != 0)){
+        ser_fail(name, "frames repeated or discarded without errors");
+    }
+
+    devTx = serDevice->txBytes;
+    lineTime = (double)((serHostTx > devTx) ? serHostTx : devTx) * SER_BITS_PER_BYTE / SER_BAUD;
+    printf("%s: byte error rate %g, %u requests, window %u\n", name, errorRate, (unsigned)SER_REQUESTS,
+           (unsigned)SER_WINDOW);
+    printf("  repeated               %u (after idle line %u), device discarded %u frames of %u\n",
+           (unsigned)serRetries, (unsigned)idle, (unsigned)serDevice->rxErrors,
+           (unsigned)(serDevice->rxFrames + serDevice->rxErrors));
+    printf("  line bytes             remote %u, device %u, payload %llu, payload/line %.2f\n",
+           (unsigned)serHostTx, (unsigned)devTx, payload, (double)payload / (double)(serHostTx + devTx));
+    printf("  at %u baud         %.2f s, %.0f requests/s (pty %.3f s wall)\n",
+           (unsigned)SER_BAUD, lineTime, SER_REQUESTS / lineTime, (double)wall / 1e9);
+}
+
+static void ser_testClean(void){
+    ser_run("clean", 0.0);
+}
+
+static void ser_testErrors3(void){
+    ser_run("errors_1e-3", 1e-3);
+}
+
+static void ser_testErrors2(void){
+    ser_run("errors_1e-2", 1e-2);
+}
+
+
+/* Main ***********************************************************************/
+typedef struct{
+    const char         *name;
+    void              (*run)(void);
+}ser_test_t;
+
+static const ser_test_t tests[] = {
+    {"clean",           ser_testClean},
+    {"errors_1e-3",     ser_testErrors3},
+    {"errors_1e-2",     ser_testErrors2}
+};
+
+int main(int argc, char *argv[]){
+    const char *filter = NULL;
+    unsigned i;
+    int c;
+
+    while((c = getopt(argc, argv, "f:")) != -1){
+        switch(c){
+            case 'f': filter = optarg; break;
+            default:
+                fprintf(stderr, "Usage: %s [-f name filter]\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    serDevice = mmap(NULL, sizeof(*serDevice), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if(serDevice == MAP_FAILED){
+        perror("CO_serialTest: mmap");
+        return EXIT_FAILURE;
+    }
+
+    for(i = 0; i < sizeof(tests) / sizeof(tests[0]); i++){
+        if(filter != NULL && strstr(tests[i].name, filter) == NULL) continue;
+        tests[i].run();
+    }
+
+    return EXIT_SUCCESS;
+}
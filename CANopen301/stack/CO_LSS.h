@@ -0,0 +1,169 @@
+/**
+ * CANopen Layer Setting Services protocol (common).
+ *
+ * @file        CO_LSS.h
+ * @ingroup     CO_LSS
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+#ifndef CO_LSS_H
+#define CO_LSS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup CO_LSS LSS
+ * @ingroup CO_CANopen
+ * @{
+ *
+ * CANopen Layer Setting Services protocol (CiA 305).
+ *
+ * LSS is used to assign node-ID and bit timing to devices, which are
+ * identified only by their LSS address (the four members of the identity
+ * object 0x1018). A node without node-ID (#CO_LSS_NODE_ID_ASSIGNMENT) does
+ * not run any other CANopen services, it only listens to the LSS master.
+ *
+ * Unconfigured nodes are found with the Fastscan service: the master probes
+ * the LSS address bit by bit, starting at the most significant bit, and all
+ * unconfigured slaves whose address matches the probed bits respond with the
+ * same CAN frame. After 4 x 32 probes exactly one slave is left in LSS
+ * configuration state.
+ *
+ * @see @ref CO_LSSslave, @ref CO_LSSmaster
+ */
+
+
+/**
+ * LSS command specifiers (first byte of every LSS message).
+ */
+typedef enum{
+    CO_LSS_SWITCH_STATE_GLOBAL      = 0x04U, /**< Switch state global */
+    CO_LSS_SWITCH_STATE_SEL_VENDOR  = 0x40U, /**< Switch state selective, vendor ID */
+    CO_LSS_SWITCH_STATE_SEL_PRODUCT = 0x41U, /**< Switch state selective, product code */
+    CO_LSS_SWITCH_STATE_SEL_REV     = 0x42U, /**< Switch state selective, revision number */
+    CO_LSS_SWITCH_STATE_SEL_SERIAL  = 0x43U, /**< Switch state selective, serial number */
+    CO_LSS_SWITCH_STATE_SEL         = 0x44U, /**< Switch state selective, slave response */
+    CO_LSS_CFG_NODE_ID              = 0x11U, /**< Configure node ID */
+    CO_LSS_CFG_BIT_TIMING           = 0x13U, /**< Configure bit timing parameter */
+    CO_LSS_CFG_ACTIVATE_BIT_TIMING  = 0x15U, /**< Activate bit timing parameter */
+    CO_LSS_CFG_STORE                = 0x17U, /**< Store configuration */
+    CO_LSS_IDENT_REMOTE_VENDOR      = 0x46U, /**< Identify remote slave, vendor ID */
+    CO_LSS_IDENT_REMOTE_PRODUCT     = 0x47U, /**< Identify remote slave, product code */
+    CO_LSS_IDENT_REMOTE_REV_LOW     = 0x48U, /**< Identify remote slave, revision number low */
+    CO_LSS_IDENT_REMOTE_REV_HIGH    = 0x49U, /**< Identify remote slave, revision number high */
+    CO_LSS_IDENT_REMOTE_SERIAL_LOW  = 0x4AU, /**< Identify remote slave, serial number low */
+    CO_LSS_IDENT_REMOTE_SERIAL_HIGH = 0x4BU, /**< Identify remote slave, serial number high */
+    CO_LSS_IDENT_REMOTE_NON_CONFIG  = 0x4CU, /**< Identify non-configured remote slave */
+    CO_LSS_IDENT_SLAVE              = 0x4FU, /**< Identify slave / Fastscan, slave response */
+    CO_LSS_IDENT_NON_CONFIG_SLAVE   = 0x50U, /**< Identify non-configured slave, slave response */
+    CO_LSS_IDENT_FASTSCAN           = 0x51U, /**< Fastscan */
+    CO_LSS_INQUIRE_VENDOR           = 0x5AU, /**< Inquire identity vendor ID */
+    CO_LSS_INQUIRE_PRODUCT          = 0x5BU, /**< Inquire identity product code */
+    CO_LSS_INQUIRE_REV              = 0x5CU, /**< Inquire identity revision number */
+    CO_LSS_INQUIRE_SERIAL           = 0x5DU, /**< Inquire identity serial number */
+    CO_LSS_INQUIRE_NODE_ID          = 0x5EU  /**< Inquire node ID */
+}CO_LSS_cs_t;
+
+
+/**
+ * LSS state machine.
+ */
+typedef enum{
+    CO_LSS_STATE_WAITING            = 0U,    /**< Only Fastscan and identification services */
+    CO_LSS_STATE_CONFIGURATION      = 1U     /**< All services, slave is selected */
+}CO_LSS_state_t;
+
+
+/**
+ * Error codes of the configure node ID, bit timing and store services.
+ */
+typedef enum{
+    CO_LSS_CFG_OK                   = 0U,    /**< Protocol successfully completed */
+    CO_LSS_CFG_OUT_OF_RANGE         = 1U,    /**< Node ID or bit timing out of range */
+    CO_LSS_CFG_STORE_NOT_SUPPORTED  = 1U,    /**< Store configuration is not supported */
+    CO_LSS_CFG_STORE_FAILED         = 2U     /**< Storage media access error */
+}CO_LSS_cfgError_t;
+
+
+/**
+ * Fastscan: LSS address sub indexes and the confirmation bit check value.
+ */
+typedef enum{
+    CO_LSS_FASTSCAN_VENDOR_ID       = 0U,    /**< Vendor ID */
+    CO_LSS_FASTSCAN_PRODUCT         = 1U,    /**< Product code */
+    CO_LSS_FASTSCAN_REV             = 2U,    /**< Revision number */
+    CO_LSS_FASTSCAN_SERIAL          = 3U,    /**< Serial number */
+    CO_LSS_FASTSCAN_CONFIRM         = 0x80U  /**< bitChecked: reset Fastscan, all unconfigured slaves respond */
+}CO_LSS_fastscan_t;
+
+
+#define CO_LSS_NODE_ID_ASSIGNMENT   0xFFU   /**< Node ID of a node, which waits for LSS assignment */
+#define CO_LSS_BIT_TIMING_TABLE     0U      /**< The only supported bit timing table (CiA 305) */
+#define CO_LSS_BIT_TIMING_AUTO      9U      /**< Table index for automatic bit rate detection */
+
+/** Initializer for CiA 305 standard bit timing table in kbit/s, 0 is reserved. */
+#define CO_LSS_BIT_TIMING_TABLE_INIT {1000U, 800U, 500U, 250U, 125U, 0U, 50U, 20U, 10U, 0U}
+#define CO_LSS_BIT_TIMING_TABLE_SIZE 10U
+
+/** Valid node ID for configure node ID service (1...127 or unconfigured). */
+#define CO_LSS_NODE_ID_VALID(nid)   (((nid) >= 1U && (nid) <= 0x7FU) || (nid) == CO_LSS_NODE_ID_ASSIGNMENT)
+
+
+/**
+ * LSS address, same layout as the identity object 0x1018 sub 1...4.
+ */
+typedef union{
+    uint32_t addr[4];                        /**< Indexed by #CO_LSS_fastscan_t */
+    struct{
+        uint32_t vendorID;                   /**< Vendor ID */
+        uint32_t productCode;                /**< Product code */
+        uint32_t revisionNumber;             /**< Revision number */
+        uint32_t serialNumber;               /**< Serial number */
+    }identity;
+}CO_LSS_address_t;
+
+
+#ifdef __cplusplus
+}
+#endif /*__cplusplus*/
+
+/** @} */
+#endif
@@ -0,0 +1,606 @@
+/*
+ * CANopen Layer Setting Services protocol (master).
+ *
+ * @file        CO_LSSmaster.c
+ * @ingroup     CO_LSSmaster
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+#include "CO_driver.h"
+#include "CO_SDO.h"
+#include "CO_LSSmaster.h"
+
+
+static const uint16_t CO_LSS_bitTimingTable[CO_LSS_BIT_TIMING_TABLE_SIZE] = CO_LSS_BIT_TIMING_TABLE_INIT;
+
+/* Fastscan internal states */
+#define CO_LSSmaster_FS_STATE_CONFIRM   0U  /* reset all unconfigured slaves */
+#define CO_LSSmaster_FS_STATE_SCAN      1U  /* probe bits of fsSub */
+#define CO_LSSmaster_FS_STATE_VERIFY    2U  /* verify fsSub and move slaves to the next sub */
+
+/* CO_LSSmaster_assignNodeIds() internal states */
+#define CO_LSSmaster_ASSIGN_SCAN        0U
+#define CO_LSSmaster_ASSIGN_NODE_ID     1U
+#define CO_LSSmaster_ASSIGN_STORE       2U
+#define CO_LSSmaster_ASSIGN_BIT_SELECT  3U
+#define CO_LSSmaster_ASSIGN_BIT_TIMING  4U
+#define CO_LSSmaster_ASSIGN_BIT_STORE   5U
+
+
+/*
+ * Read received message from CAN module.
+ *
+ * Function will be called (by CAN receive interrupt) every time, when CAN
+ * message with correct identifier will be received. For more information and
+ * description of parameters see file CO_driver.h.
+ */
+static void CO_LSSmaster_receive(void *object, const CO_CANrxMsg_t *msg);
+static void CO_LSSmaster_receive(void *object, const CO_CANrxMsg_t *msg){
+    CO_LSSmaster_t *LSSmaster;
+    uint8_t i;
+
+    LSSmaster = (CO_LSSmaster_t*) object; /* this is the correct pointer type of the first argument */
+
+    /* verify message length and message overflow (previous message was not processed yet) */
+    if(msg->DLC == 8 && !LSSmaster->CANrxNew && LSSmaster->command != 0){
+        for(i=0; i<8; i++){
+            LSSmaster->CANrxData[i] = msg->data[i];
+        }
+        LSSmaster->CANrxNew = true;
+    }
+}
+
+
+/*
+ * Prepare and send LSS request. Responses to previous requests are discarded.
+ * Bytes 5...7 are used by Fastscan only.
+ */
+static void CO_LSSmaster_send(
+        CO_LSSmaster_t         *LSSmaster,
+        uint8_t                 cs,
+        uint32_t                value,
+        uint8_t                 data5,
+        uint8_t                 data6,
+        uint8_t                 data7)
+{
+    uint8_t *tx = LSSmaster->TXbuff->data;
+
+    tx[0] = cs;
+    CO_setUint32(&tx[1], value);
+    tx[5] = data5;
+    tx[6] = data6;
+    tx[7] = data7;
+
+    LSSmaster->timeoutTimer = 0;
+    LSSmaster->CANrxNew = false;
+    CO_CANsend(LSSmaster->CANdevTx, LSSmaster->TXbuff);
+}
+
+
+/*
+ * True, if previous request is still waiting in the CAN transmit buffer. New
+ * request is then postponed to the next call, it would overwrite the buffer.
+ */
+static bool_t CO_LSSmaster_txBusy(const CO_LSSmaster_t *LSSmaster){
+    return LSSmaster->TXbuff->bufferFull ? true : false;
+}
+
+
+/*
+ * Wait for the response with command specifier csResponse. Other messages are
+ * ignored, they may be late responses of other slaves to previous request.
+ */
+static CO_LSSmaster_return_t CO_LSSmaster_waitResponse(
+        CO_LSSmaster_t         *LSSmaster,
+        uint16_t                timeDifference_ms,
+        uint8_t                 csResponse)
+{
+    if(LSSmaster->CANrxNew){
+        bool_t match = (LSSmaster->CANrxData[0] == csResponse) ? true : false;
+
+        LSSmaster->CANrxNew = false;
+        if(match){
+            LSSmaster->command = 0;
+            return CO_LSSmaster_OK;
+        }
+    }
+
+    LSSmaster->timeoutTimer += timeDifference_ms;
+    if(LSSmaster->timeoutTimer >= LSSmaster->timeout){
+        LSSmaster->command = 0;
+        return CO_LSSmaster_TIMEOUT;
+    }
+
+    return CO_LSSmaster_WAIT_SLAVE;
+}
+
+
+/*
+ * Configuration services: send request on first call, then wait for the error
+ * code in the response.
+ */
+static CO_LSSmaster_return_t CO_LSSmaster_configure(
+        CO_LSSmaster_t         *LSSmaster,
+        uint16_t                timeDifference_ms,
+        uint8_t                 cs,
+        uint32_t                value)
+{
+    CO_LSSmaster_return_t ret;
+
+    if(LSSmaster->command == 0){
+        if(!LSSmaster->configuration){
+            return CO_LSSmaster_INVALID_STATE;
+        }
+        if(!CO_LSSmaster_txBusy(LSSmaster)){
+            LSSmaster->command = cs;
+            CO_LSSmaster_send(LSSmaster, cs, value, 0, 0, 0);
+        }
+        return CO_LSSmaster_WAIT_SLAVE;
+    }
+    if(LSSmaster->command != cs){
+        return CO_LSSmaster_INVALID_STATE;
+    }
+
+    ret = CO_LSSmaster_waitResponse(LSSmaster, timeDifference_ms, cs);
+    if(ret == CO_LSSmaster_OK && LSSmaster->CANrxData[1] != CO_LSS_CFG_OK){
+        ret = CO_LSSmaster_REFUSED;
+    }
+
+    return ret;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_LSSmaster_init(
+        CO_LSSmaster_t         *LSSmaster,
+        uint16_t                timeout_ms,
+        CO_CANmodule_t         *CANdevRx,
+        uint16_t                CANdevRxIdx,
+        uint32_t                CANidLssSlave,
+        CO_CANmodule_t         *CANdevTx,
+        uint16_t                CANdevTxIdx,
+        uint32_t                CANidLssMaster)
+{
+    /* verify arguments */
+    if(LSSmaster==NULL || CANdevRx==NULL || CANdevTx==NULL || timeout_ms==0){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    LSSmaster->timeout = timeout_ms;
+    LSSmaster->command = 0;
+    LSSmaster->configuration = false;
+    LSSmaster->timeoutTimer = 0;
+    LSSmaster->fsState = CO_LSSmaster_FS_STATE_CONFIRM;
+    LSSmaster->assignStep = CO_LSSmaster_ASSIGN_SCAN;
+    LSSmaster->CANrxNew = false;
+
+    /* configure LSS CAN reception */
+    CO_CANrxBufferInit(
+            CANdevRx,           /* CAN device */
+            CANdevRxIdx,        /* rx buffer index */
+            CANidLssSlave,      /* CAN identifier */
+            0x7FF,              /* mask */
+            0,                  /* rtr */
+            (void*)LSSmaster,   /* object passed to receive function */
+            CO_LSSmaster_receive); /* this function will process received message */
+
+    /* configure LSS CAN transmission */
+    LSSmaster->CANdevTx = CANdevTx;
+    LSSmaster->TXbuff = CO_CANtxBufferInit(
+            CANdevTx,           /* CAN device */
+            CANdevTxIdx,        /* index of specific buffer inside CAN module */
+            CANidLssMaster,     /* CAN identifier */
+            0,                  /* rtr */
+            8,                  /* number of data bytes */
+            0);                 /* synchronous message flag bit */
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+CO_LSSmaster_return_t CO_LSSmaster_switchStateSelect(
+        CO_LSSmaster_t         *LSSmaster,
+        uint16_t                timeDifference_ms,
+        const CO_LSS_address_t *lssAddress)
+{
+    if(LSSmaster == NULL){
+        return CO_LSSmaster_ILLEGAL_ARGUMENT;
+    }
+
+    if(lssAddress == NULL){
+        if(LSSmaster->command != 0){
+            return CO_LSSmaster_INVALID_STATE;
+        }
+        if(CO_LSSmaster_txBusy(LSSmaster)){
+            return CO_LSSmaster_WAIT_SLAVE;
+        }
+        CO_LSSmaster_send(LSSmaster, CO_LSS_SWITCH_STATE_GLOBAL, CO_LSS_STATE_CONFIGURATION, 0, 0, 0);
+        LSSmaster->configuration = true;
+        return CO_LSSmaster_OK;
+    }
+
+    if(LSSmaster->command == 0){
+        LSSmaster->command = CO_LSS_SWITCH_STATE_SEL;
+        LSSmaster->fsSub = CO_LSS_FASTSCAN_VENDOR_ID;
+    }
+    if(LSSmaster->command != CO_LSS_SWITCH_STATE_SEL){
+        return CO_LSSmaster_INVALID_STATE;
+    }
+
+    /* four messages, one per call, only the last one is answered by the matching slave */
+    if(LSSmaster->fsSub <= CO_LSS_FASTSCAN_SERIAL){
+        if(!CO_LSSmaster_txBusy(LSSmaster)){
+            CO_LSSmaster_send(LSSmaster, CO_LSS_SWITCH_STATE_SEL_VENDOR + LSSmaster->fsSub,
+                              lssAddress->addr[LSSmaster->fsSub], 0, 0, 0);
+            LSSmaster->fsSub++;
+        }
+        return CO_LSSmaster_WAIT_SLAVE;
+    }
+
+    if(CO_LSSmaster_waitResponse(LSSmaster, timeDifference_ms, CO_LSS_SWITCH_STATE_SEL) == CO_LSSmaster_OK){
+        LSSmaster->configuration = true;
+        return CO_LSSmaster_OK;
+    }
+
+    return (LSSmaster->command == 0) ? CO_LSSmaster_TIMEOUT : CO_LSSmaster_WAIT_SLAVE;
+}
+
+
+/******************************************************************************/
+CO_LSSmaster_return_t CO_LSSmaster_switchStateDeselect(CO_LSSmaster_t *LSSmaster){
+    if(LSSmaster == NULL){
+        return CO_LSSmaster_ILLEGAL_ARGUMENT;
+    }
+    if(LSSmaster->command != 0){
+        return CO_LSSmaster_INVALID_STATE;
+    }
+    if(CO_LSSmaster_txBusy(LSSmaster)){
+        return CO_LSSmaster_WAIT_SLAVE;
+    }
+
+    CO_LSSmaster_send(LSSmaster, CO_LSS_SWITCH_STATE_GLOBAL, CO_LSS_STATE_WAITING, 0, 0, 0);
+    LSSmaster->configuration = false;
+
+    return CO_LSSmaster_OK;
+}
+
+
+/******************************************************************************/
+CO_LSSmaster_return_t CO_LSSmaster_configureNodeId(
+        CO_LSSmaster_t         *LSSmaster,
+        uint16_t                timeDifference_ms,
+        uint8_t                 nodeId)
+{
+    if(LSSmaster == NULL || !CO_LSS_NODE_ID_VALID(nodeId)){
+        return CO_LSSmaster_ILLEGAL_ARGUMENT;
+    }
+
+    return CO_LSSmaster_configure(LSSmaster, timeDifference_ms, CO_LSS_CFG_NODE_ID, nodeId);
+}
+
+
+/******************************************************************************/
+CO_LSSmaster_return_t CO_LSSmaster_configureBitTiming(
+        CO_LSSmaster_t         *LSSmaster,
+        uint16_t                timeDifference_ms,
+        uint16_t                bitRate)
+{
+    uint8_t i;
+
+    if(LSSmaster == NULL || bitRate == 0){
+        return CO_LSSmaster_ILLEGAL_ARGUMENT;
+    }
+    for(i=0; i<CO_LSS_BIT_TIMING_TABLE_SIZE; i++){
+        if(CO_LSS_bitTimingTable[i] == bitRate){
+            break;
+        }
+    }
+    if(i >= CO_LSS_BIT_TIMING_TABLE_SIZE){
+        return CO_LSSmaster_ILLEGAL_ARGUMENT;
+    }
+
+    /* data[1] = table selector, data[2] = table index */
+    return CO_LSSmaster_configure(LSSmaster, timeDifference_ms, CO_LSS_CFG_BIT_TIMING,
+                                  CO_LSS_BIT_TIMING_TABLE | ((uint32_t)i << 8));
+}
+
+
+/******************************************************************************/
+CO_LSSmaster_return_t CO_LSSmaster_configureStore(
+        CO_LSSmaster_t         *LSSmaster,
+        uint16_t                timeDifference_ms)
+{
+    if(LSSmaster == NULL){
+        return CO_LSSmaster_ILLEGAL_ARGUMENT;
+    }
+
+    return CO_LSSmaster_configure(LSSmaster, timeDifference_ms, CO_LSS_CFG_STORE, 0);
+}
+
+
+/******************************************************************************/
+CO_LSSmaster_return_t CO_LSSmaster_ActivateBit(
+        CO_LSSmaster_t         *LSSmaster,
+        uint16_t                switchDelay_ms)
+{
+    if(LSSmaster == NULL){
+        return CO_LSSmaster_ILLEGAL_ARGUMENT;
+    }
+    if(LSSmaster->command != 0 || !LSSmaster->configuration){
+        return CO_LSSmaster_INVALID_STATE;
+    }
+    if(CO_LSSmaster_txBusy(LSSmaster)){
+        return CO_LSSmaster_WAIT_SLAVE;
+    }
+
+    /* switch delay in bytes 1 and 2 */
+    CO_LSSmaster_send(LSSmaster, CO_LSS_CFG_ACTIVATE_BIT_TIMING, switchDelay_ms, 0, 0, 0);
+
+    return CO_LSSmaster_OK;
+}
+
+
+/*
+ * Fastscan: send one probe. lssSub and lssNext are in bytes 6 and 7.
+ */
+static void CO_LSSmaster_fsSend(
+        CO_LSSmaster_t         *LSSmaster,
+        uint32_t                idNumber,
+        uint8_t                 bitCheck,
+        uint8_t                 lssSub,
+        uint8_t                 lssNext)
+{
+    LSSmaster->fsAck = false;
+    CO_LSSmaster_send(LSSmaster, CO_LSS_IDENT_FASTSCAN, idNumber, bitCheck, lssSub, lssNext);
+}
+
+
+/*
+ * Fastscan: start scanning or verification of fsSub.
+ */
+static void CO_LSSmaster_fsStartSub(CO_LSSmaster_t *LSSmaster, CO_LSSmaster_fastscan_t *fastscan){
+    uint8_t sub = LSSmaster->fsSub;
+
+    if(fastscan->scan[sub] == CO_LSSmaster_FS_MATCH){
+        fastscan->found.addr[sub] = fastscan->match.addr[sub];
+        LSSmaster->fsState = CO_LSSmaster_FS_STATE_VERIFY;
+        LSSmaster->fsBit = -1;
+        CO_LSSmaster_fsSend(LSSmaster, fastscan->found.addr[sub], 0, sub,
+                            (sub < CO_LSS_FASTSCAN_SERIAL) ? sub + 1 : CO_LSS_FASTSCAN_VENDOR_ID);
+    }
+    else{
+        fastscan->found.addr[sub] = 0;
+        LSSmaster->fsState = CO_LSSmaster_FS_STATE_SCAN;
+        LSSmaster->fsBit = 31;
+        CO_LSSmaster_fsSend(LSSmaster, 0, 31, sub, sub);
+    }
+}
+
+
+/******************************************************************************/
+CO_LSSmaster_return_t CO_LSSmaster_IdentifyFastscan(
+        CO_LSSmaster_t         *LSSmaster,
+        uint16_t                timeDifference_ms,
+        CO_LSSmaster_fastscan_t *fastscan)
+{
+    uint8_t sub;
+
+    if(LSSmaster == NULL || fastscan == NULL){
+        return CO_LSSmaster_ILLEGAL_ARGUMENT;
+    }
+
+    if(LSSmaster->command == 0){
+        /* unconfigured slaves respond only in waiting state */
+        if(LSSmaster->configuration){
+            return CO_LSSmaster_INVALID_STATE;
+        }
+        if(CO_LSSmaster_txBusy(LSSmaster)){
+            return CO_LSSmaster_WAIT_SLAVE;
+        }
+        LSSmaster->command = CO_LSS_IDENT_FASTSCAN;
+        LSSmaster->fsState = CO_LSSmaster_FS_STATE_CONFIRM;
+        LSSmaster->fsSub = CO_LSS_FASTSCAN_VENDOR_ID;
+        CO_LSSmaster_fsSend(LSSmaster, 0, CO_LSS_FASTSCAN_CONFIRM, 0, 0);
+        return CO_LSSmaster_WAIT_SLAVE;
+    }
+    if(LSSmaster->command != CO_LSS_IDENT_FASTSCAN){
+        return CO_LSSmaster_INVALID_STATE;
+    }
+
+    /* Collect responses for the complete timeout, all matching slaves must answer. */
+    if(LSSmaster->CANrxNew){
+        if(LSSmaster->CANrxData[0] == CO_LSS_IDENT_SLAVE){
+            LSSmaster->fsAck = true;
+        }
+        LSSmaster->CANrxNew = false;
+    }
+    LSSmaster->timeoutTimer += timeDifference_ms;
+    if(LSSmaster->timeoutTimer < LSSmaster->timeout){
+        return CO_LSSmaster_WAIT_SLAVE;
+    }
+
+    sub = LSSmaster->fsSub;
+    switch(LSSmaster->fsState){
+        case CO_LSSmaster_FS_STATE_CONFIRM:
+            if(!LSSmaster->fsAck){
+                LSSmaster->command = 0;
+                return CO_LSSmaster_SCAN_NOACK;
+            }
+            CO_LSSmaster_fsStartSub(LSSmaster, fastscan);
+            break;
+
+        case CO_LSSmaster_FS_STATE_SCAN:
+            /* no slave has this bit cleared, so some slave has it set */
+            if(!LSSmaster->fsAck){
+                fastscan->found.addr[sub] |= 1UL << LSSmaster->fsBit;
+            }
+            LSSmaster->fsBit--;
+            if(LSSmaster->fsBit >= 0){
+                CO_LSSmaster_fsSend(LSSmaster, fastscan->found.addr[sub], (uint8_t)LSSmaster->fsBit, sub, sub);
+            }
+            else{
+                LSSmaster->fsState = CO_LSSmaster_FS_STATE_VERIFY;
+                CO_LSSmaster_fsSend(LSSmaster, fastscan->found.addr[sub], 0, sub,
+                                    (sub < CO_LSS_FASTSCAN_SERIAL) ? sub + 1 : CO_LSS_FASTSCAN_VENDOR_ID);
+            }
+            break;
+
+        case CO_LSSmaster_FS_STATE_VERIFY:
+        default:
+            if(!LSSmaster->fsAck){
+                LSSmaster->command = 0;
+                return CO_LSSmaster_SCAN_FAILED;
+            }
+            if(sub == CO_LSS_FASTSCAN_SERIAL){
+                /* the last matching slave switched into configuration state */
+                LSSmaster->command = 0;
+                LSSmaster->configuration = true;
+                return CO_LSSmaster_OK;
+            }
+            LSSmaster->fsSub++;
+            CO_LSSmaster_fsStartSub(LSSmaster, fastscan);
+            break;
+    }
+
+    return CO_LSSmaster_WAIT_SLAVE;
+}
+
+
+/******************************************************************************/
+CO_LSSmaster_return_t CO_LSSmaster_assignNodeIds(
+        CO_LSSmaster_t         *LSSmaster,
+        uint16_t                timeDifference_ms,
+        CO_LSSmaster_assign_t  *assign)
+{
+    CO_LSSmaster_return_t ret;
+
+    if(LSSmaster == NULL || assign == NULL){
+        return CO_LSSmaster_ILLEGAL_ARGUMENT;
+    }
+
+    switch(LSSmaster->assignStep){
+        case CO_LSSmaster_ASSIGN_SCAN:
+            ret = CO_LSSmaster_IdentifyFastscan(LSSmaster, timeDifference_ms, &assign->fastscan);
+            if(ret == CO_LSSmaster_OK){
+                if(assign->nodeIdNext < 1 || assign->nodeIdNext > assign->nodeIdLast || assign->nodeIdNext > 0x7F){
+                    /* more slaves than free node IDs */
+                    CO_LSSmaster_switchStateDeselect(LSSmaster);
+                    return CO_LSSmaster_ILLEGAL_ARGUMENT;
+                }
+                LSSmaster->assignStep = CO_LSSmaster_ASSIGN_NODE_ID;
+                ret = CO_LSSmaster_WAIT_SLAVE;
+            }
+            else if(ret == CO_LSSmaster_SCAN_NOACK){
+                /* all slaves have node ID, set the bit rate */
+                if(assign->bitRate == 0){
+                    return CO_LSSmaster_SCAN_FINISHED;
+                }
+                LSSmaster->assignStep = CO_LSSmaster_ASSIGN_BIT_SELECT;
+                ret = CO_LSSmaster_WAIT_SLAVE;
+            }
+            break;
+
+        case CO_LSSmaster_ASSIGN_NODE_ID:
+            ret = CO_LSSmaster_configureNodeId(LSSmaster, timeDifference_ms, assign->nodeIdNext);
+            if(ret == CO_LSSmaster_OK){
+                assign->nodeIdNext++;
+                assign->assigned++;
+                /* with new bit rate, node ID is stored together with it at the end */
+                if(assign->store && assign->bitRate == 0){
+                    LSSmaster->assignStep = CO_LSSmaster_ASSIGN_STORE;
+                }
+                else{
+                    CO_LSSmaster_switchStateDeselect(LSSmaster);
+                    LSSmaster->assignStep = CO_LSSmaster_ASSIGN_SCAN;
+                }
+                ret = CO_LSSmaster_WAIT_SLAVE;
+            }
+            break;
+
+        case CO_LSSmaster_ASSIGN_STORE:
+            ret = CO_LSSmaster_configureStore(LSSmaster, timeDifference_ms);
+            if(ret == CO_LSSmaster_OK){
+                CO_LSSmaster_switchStateDeselect(LSSmaster);
+                LSSmaster->assignStep = CO_LSSmaster_ASSIGN_SCAN;
+                ret = CO_LSSmaster_WAIT_SLAVE;
+            }
+            break;
+
+        case CO_LSSmaster_ASSIGN_BIT_SELECT:
+            /* all slaves, also the previously configured ones */
+            ret = CO_LSSmaster_switchStateSelect(LSSmaster, timeDifference_ms, NULL);
+            if(ret == CO_LSSmaster_OK){
+                LSSmaster->assignStep = CO_LSSmaster_ASSIGN_BIT_TIMING;
+                ret = CO_LSSmaster_WAIT_SLAVE;
+            }
+            break;
+
+        case CO_LSSmaster_ASSIGN_BIT_TIMING:
+            ret = CO_LSSmaster_configureBitTiming(LSSmaster, timeDifference_ms, assign->bitRate);
+            if(ret == CO_LSSmaster_OK){
+                LSSmaster->assignStep = assign->store ? CO_LSSmaster_ASSIGN_BIT_STORE : CO_LSSmaster_ASSIGN_SCAN;
+                if(!assign->store){
+                    CO_LSSmaster_ActivateBit(LSSmaster, assign->switchDelay);
+                    LSSmaster->configuration = false;
+                    return CO_LSSmaster_SCAN_FINISHED;
+                }
+                ret = CO_LSSmaster_WAIT_SLAVE;
+            }
+            break;
+
+        case CO_LSSmaster_ASSIGN_BIT_STORE:
+        default:
+            ret = CO_LSSmaster_configureStore(LSSmaster, timeDifference_ms);
+            if(ret == CO_LSSmaster_OK){
+                LSSmaster->assignStep = CO_LSSmaster_ASSIGN_SCAN;
+                CO_LSSmaster_ActivateBit(LSSmaster, assign->switchDelay);
+                LSSmaster->configuration = false;
+                return CO_LSSmaster_SCAN_FINISHED;
+            }
+            break;
+    }
+
+    if(ret != CO_LSSmaster_WAIT_SLAVE){
+        /* error, start from the beginning on the next call */
+        LSSmaster->assignStep = CO_LSSmaster_ASSIGN_SCAN;
+    }
+
+    return ret;
+}
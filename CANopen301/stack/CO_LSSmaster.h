@@ -0,0 +1,310 @@
+/**
+ * CANopen Layer Setting Services protocol (master).
+ *
+ * @file        CO_LSSmaster.h
+ * @ingroup     CO_LSSmaster
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+#ifndef CO_LSSmaster_H
+#define CO_LSSmaster_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "CO_LSS.h"
+
+/**
+ * @defgroup CO_LSSmaster LSS Master
+ * @ingroup CO_CANopen
+ * @{
+ *
+ * CANopen Layer Setting Services protocol (master).
+ *
+ * LSS master is intended for the Linux (socketCAN) port, where a commissioning
+ * tool assigns node IDs and bit rate to a line of identical drives. All
+ * functions are nonblocking: they must be called cyclically with the same
+ * arguments, as long as they return #CO_LSSmaster_WAIT_SLAVE.
+ *
+ * Node IDs can only be assigned one slave after another, because every slave
+ * must be selected by its LSS address first. CO_LSSmaster_assignNodeIds()
+ * repeats Fastscan, configure node ID and store, until no unconfigured slave
+ * responds. The bit rate is then configured and activated for all slaves
+ * with one broadcast.
+ *
+ * Every Fastscan step waits for the complete timeout, because responses of
+ * all unconfigured slaves must be collected before the next bit is probed.
+ * Time to identify one slave is about (1 + 33 * scanned subs + matched subs)
+ * * timeout, so subs common to all drives (vendor ID, product code, revision
+ * number) should use #CO_LSSmaster_FS_MATCH.
+ *
+ * @see @ref CO_LSS
+ */
+
+
+#define CO_LSSmaster_DEFAULT_TIMEOUT 10U  /**< Default response timeout [ms], see CO_LSSmaster_init() */
+
+
+/**
+ * Return values of LSS master functions.
+ */
+typedef enum{
+    CO_LSSmaster_SCAN_FINISHED      = 2,    /**< Assign node IDs: no more unconfigured slaves */
+    CO_LSSmaster_WAIT_SLAVE         = 1,    /**< No response arrived from slave yet, call again */
+    CO_LSSmaster_OK                 = 0,    /**< Success, end of communication */
+    CO_LSSmaster_TIMEOUT            = -1,   /**< No reply received */
+    CO_LSSmaster_ILLEGAL_ARGUMENT   = -2,   /**< Invalid argument */
+    CO_LSSmaster_INVALID_STATE      = -3,   /**< Other service in progress, or no slave selected */
+    CO_LSSmaster_SCAN_NOACK         = -4,   /**< Fastscan: no unconfigured slave responded */
+    CO_LSSmaster_SCAN_FAILED        = -5,   /**< Fastscan: slave was lost during the scan */
+    CO_LSSmaster_REFUSED            = -6    /**< Slave responded with error code */
+}CO_LSSmaster_return_t;
+
+
+/**
+ * Fastscan mode for one LSS address sub.
+ */
+typedef enum{
+    CO_LSSmaster_FS_SCAN            = 0,    /**< Find the value bit by bit */
+    CO_LSSmaster_FS_MATCH           = 1     /**< Value is known, only verify it */
+}CO_LSSmaster_scantype_t;
+
+
+/**
+ * Fastscan configuration and result.
+ */
+typedef struct{
+    CO_LSSmaster_scantype_t scan[4];        /**< Mode for each sub, indexed by #CO_LSS_fastscan_t */
+    CO_LSS_address_t    match;              /**< Known values for #CO_LSSmaster_FS_MATCH subs */
+    CO_LSS_address_t    found;              /**< LSS address of the selected slave */
+}CO_LSSmaster_fastscan_t;
+
+
+/**
+ * Configuration and result of CO_LSSmaster_assignNodeIds().
+ */
+typedef struct{
+    CO_LSSmaster_fastscan_t fastscan;       /**< Fastscan configuration */
+    uint8_t             nodeIdNext;         /**< Node ID, assigned to the next found slave */
+    uint8_t             nodeIdLast;         /**< Last node ID, which may be assigned */
+    uint16_t            bitRate;            /**< New bit rate for all slaves [kbit/s], 0 = unchanged */
+    uint16_t            switchDelay;        /**< Delay for activate bit timing [ms] */
+    bool_t              store;              /**< Store node ID and bit rate in slaves */
+    uint8_t             assigned;           /**< Number of slaves, which got node ID */
+}CO_LSSmaster_assign_t;
+
+
+/**
+ * LSS master object.
+ */
+typedef struct{
+    uint16_t            timeout;            /**< Response timeout [ms] */
+    uint8_t             command;            /**< Command specifier of service in progress, 0 if none */
+    bool_t              configuration;      /**< True, if some slaves are in LSS configuration state */
+    uint16_t            timeoutTimer;       /**< Time since request was sent [ms] */
+    uint8_t             fsState;            /**< Fastscan internal state */
+    uint8_t             fsSub;              /**< Fastscan: current LSS address sub */
+    int8_t              fsBit;              /**< Fastscan: current bit, -1 for verification */
+    bool_t              fsAck;              /**< Fastscan: some slave responded in this step */
+    uint8_t             assignStep;         /**< CO_LSSmaster_assignNodeIds() internal state */
+    volatile bool_t     CANrxNew;           /**< True, if new LSS message received from the CAN bus */
+    uint8_t             CANrxData[8];       /**< 8 data bytes of the received message */
+    CO_CANmodule_t     *CANdevTx;           /**< From CO_LSSmaster_init() */
+    CO_CANtx_t         *TXbuff;             /**< CAN transmit buffer */
+}CO_LSSmaster_t;
+
+
+/**
+ * Initialize LSS master object.
+ *
+ * Function must be called in the communication reset section.
+ *
+ * @param LSSmaster This object will be initialized.
+ * @param timeout_ms Response timeout [ms]. Fastscan waits this time for every
+ * probed bit. It must cover the slowest slave's processing time.
+ * @param CANdevRx CAN device for LSS master reception.
+ * @param CANdevRxIdx Index of receive buffer in the above CAN device.
+ * @param CANidLssSlave COB ID for reception (0x7E4).
+ * @param CANdevTx CAN device for LSS master transmission.
+ * @param CANdevTxIdx Index of transmit buffer in the above CAN device.
+ * @param CANidLssMaster COB ID for transmission (0x7E5).
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_LSSmaster_init(
+        CO_LSSmaster_t         *LSSmaster,
+        uint16_t                timeout_ms,
+        CO_CANmodule_t         *CANdevRx,
+        uint16_t                CANdevRxIdx,
+        uint32_t                CANidLssSlave,
+        CO_CANmodule_t         *CANdevTx,
+        uint16_t                CANdevTxIdx,
+        uint32_t                CANidLssMaster);
+
+
+/**
+ * Switch LSS slaves into configuration state.
+ *
+ * @param LSSmaster This object.
+ * @param timeDifference_ms Time difference from previous function call [ms].
+ * @param lssAddress LSS address of the slave to select. If NULL, all slaves
+ * are switched (switch state global, no response).
+ *
+ * @return #CO_LSSmaster_return_t.
+ */
+CO_LSSmaster_return_t CO_LSSmaster_switchStateSelect(
+        CO_LSSmaster_t         *LSSmaster,
+        uint16_t                timeDifference_ms,
+        const CO_LSS_address_t *lssAddress);
+
+
+/**
+ * Switch all LSS slaves into waiting state.
+ *
+ * Unconfigured slave, which got a node ID, starts CANopen with it now.
+ *
+ * @param LSSmaster This object.
+ *
+ * @return #CO_LSSmaster_return_t.
+ */
+CO_LSSmaster_return_t CO_LSSmaster_switchStateDeselect(CO_LSSmaster_t *LSSmaster);
+
+
+/**
+ * Configure node ID of the selected slave.
+ *
+ * @param LSSmaster This object.
+ * @param timeDifference_ms Time difference from previous function call [ms].
+ * @param nodeId 1...127 or #CO_LSS_NODE_ID_ASSIGNMENT.
+ *
+ * @return #CO_LSSmaster_return_t.
+ */
+CO_LSSmaster_return_t CO_LSSmaster_configureNodeId(
+        CO_LSSmaster_t         *LSSmaster,
+        uint16_t                timeDifference_ms,
+        uint8_t                 nodeId);
+
+
+/**
+ * Configure bit rate of the slaves in configuration state.
+ *
+ * @param LSSmaster This object.
+ * @param timeDifference_ms Time difference from previous function call [ms].
+ * @param bitRate Bit rate from CiA 305 table [kbit/s].
+ *
+ * @return #CO_LSSmaster_return_t.
+ */
+CO_LSSmaster_return_t CO_LSSmaster_configureBitTiming(
+        CO_LSSmaster_t         *LSSmaster,
+        uint16_t                timeDifference_ms,
+        uint16_t                bitRate);
+
+
+/**
+ * Store configured node ID and bit rate in the slaves in configuration state.
+ *
+ * @param LSSmaster This object.
+ * @param timeDifference_ms Time difference from previous function call [ms].
+ *
+ * @return #CO_LSSmaster_return_t.
+ */
+CO_LSSmaster_return_t CO_LSSmaster_configureStore(
+        CO_LSSmaster_t         *LSSmaster,
+        uint16_t                timeDifference_ms);
+
+
+/**
+ * Activate configured bit rate in the slaves in configuration state.
+ *
+ * There is no response. Slaves stay silent for switchDelay_ms, change the bit
+ * rate and stay silent for switchDelay_ms again. The master must change its
+ * own bit rate in the same time window.
+ *
+ * @param LSSmaster This object.
+ * @param switchDelay_ms Switch delay [ms].
+ *
+ * @return #CO_LSSmaster_return_t.
+ */
+CO_LSSmaster_return_t CO_LSSmaster_ActivateBit(
+        CO_LSSmaster_t         *LSSmaster,
+        uint16_t                switchDelay_ms);
+
+
+/**
+ * Select one unconfigured slave with Fastscan.
+ *
+ * @param LSSmaster This object.
+ * @param timeDifference_ms Time difference from previous function call [ms].
+ * @param fastscan Scan configuration. On #CO_LSSmaster_OK _found_ contains
+ * the LSS address of the selected slave.
+ *
+ * @return #CO_LSSmaster_return_t: CO_LSSmaster_OK, CO_LSSmaster_WAIT_SLAVE,
+ * CO_LSSmaster_SCAN_NOACK, CO_LSSmaster_SCAN_FAILED, ...
+ */
+CO_LSSmaster_return_t CO_LSSmaster_IdentifyFastscan(
+        CO_LSSmaster_t         *LSSmaster,
+        uint16_t                timeDifference_ms,
+        CO_LSSmaster_fastscan_t *fastscan);
+
+
+/**
+ * Assign node IDs to all unconfigured slaves, then change bit rate of all slaves.
+ *
+ * @param LSSmaster This object.
+ * @param timeDifference_ms Time difference from previous function call [ms].
+ * @param assign Configuration, _assigned_ and _nodeIdNext_ are updated.
+ *
+ * @return #CO_LSSmaster_return_t: CO_LSSmaster_SCAN_FINISHED when all
+ * unconfigured slaves got node ID and the bit rate is activated,
+ * CO_LSSmaster_WAIT_SLAVE, or error. CO_LSSmaster_ILLEGAL_ARGUMENT is also
+ * returned, if there are more unconfigured slaves than free node IDs.
+ */
+CO_LSSmaster_return_t CO_LSSmaster_assignNodeIds(
+        CO_LSSmaster_t         *LSSmaster,
+        uint16_t                timeDifference_ms,
+        CO_LSSmaster_assign_t  *assign);
+
+
+#ifdef __cplusplus
+}
+#endif /*__cplusplus*/
+
+/** @} */
+#endif
@@ -0,0 +1,371 @@
+/*
+ * CANopen Layer Setting Services protocol (slave).
+ *
+ * @file        CO_LSSslave.c
+ * @ingroup     CO_LSSslave
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+#include "CO_driver.h"
+#include "CO_SDO.h"
+#include "CO_LSSslave.h"
+
+
+static const uint16_t CO_LSS_bitTimingTable[CO_LSS_BIT_TIMING_TABLE_SIZE] = CO_LSS_BIT_TIMING_TABLE_INIT;
+
+
+/*
+ * Read received message from CAN module.
+ *
+ * Function will be called (by CAN receive interrupt) every time, when CAN
+ * message with correct identifier will be received. For more information and
+ * description of parameters see file CO_driver.h.
+ */
+static void CO_LSSslave_receive(void *object, const CO_CANrxMsg_t *msg);
+static void CO_LSSslave_receive(void *object, const CO_CANrxMsg_t *msg){
+    CO_LSSslave_t *LSSslave;
+    uint8_t i;
+
+    LSSslave = (CO_LSSslave_t*) object; /* this is the correct pointer type of the first argument */
+
+    /* verify message length and message overflow (previous message was not processed yet) */
+    if(msg->DLC == 8 && !LSSslave->CANrxNew){
+        for(i=0; i<8; i++){
+            LSSslave->CANrxData[i] = msg->data[i];
+        }
+        LSSslave->CANrxNew = true;
+    }
+}
+
+
+/*
+ * True, if this node is waiting for the node ID assignment. Such node responds
+ * to Fastscan and identify non-configured remote slave.
+ */
+static bool_t CO_LSSslave_isUnconfigured(const CO_LSSslave_t *LSSslave){
+    return (LSSslave->activeNodeID == CO_LSS_NODE_ID_ASSIGNMENT
+         && LSSslave->pendingNodeID == CO_LSS_NODE_ID_ASSIGNMENT) ? true : false;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_LSSslave_init(
+        CO_LSSslave_t          *LSSslave,
+        const CO_LSS_address_t *lssAddress,
+        uint16_t                pendingBitRate,
+        uint8_t                 pendingNodeID,
+        CO_CANmodule_t         *CANdevRx,
+        uint16_t                CANdevRxIdx,
+        uint32_t                CANidLssMaster,
+        CO_CANmodule_t         *CANdevTx,
+        uint16_t                CANdevTxIdx,
+        uint32_t                CANidLssSlave)
+{
+    /* verify arguments */
+    if(LSSslave==NULL || lssAddress==NULL || CANdevRx==NULL || CANdevTx==NULL
+       || !CO_LSS_NODE_ID_VALID(pendingNodeID)){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    LSSslave->lssAddress = *lssAddress;
+    LSSslave->lssState = CO_LSS_STATE_WAITING;
+    LSSslave->fastscanPos = CO_LSS_FASTSCAN_VENDOR_ID;
+    LSSslave->pendingBitRate = pendingBitRate;
+    LSSslave->pendingNodeID = pendingNodeID;
+    LSSslave->activeBitRate = pendingBitRate;
+    LSSslave->activeNodeID = pendingNodeID;
+    LSSslave->switchDelay = 0;
+    LSSslave->pFunctLSScheckBitRate = NULL;
+    LSSslave->functLSScheckBitRateObject = NULL;
+    LSSslave->pFunctLSScfgStore = NULL;
+    LSSslave->functLSScfgStoreObject = NULL;
+    LSSslave->CANrxNew = false;
+
+    /* configure LSS CAN reception */
+    CO_CANrxBufferInit(
+            CANdevRx,           /* CAN device */
+            CANdevRxIdx,        /* rx buffer index */
+            CANidLssMaster,     /* CAN identifier */
+            0x7FF,              /* mask */
+            0,                  /* rtr */
+            (void*)LSSslave,    /* object passed to receive function */
+            CO_LSSslave_receive); /* this function will process received message */
+
+    /* configure LSS CAN transmission */
+    LSSslave->CANdevTx = CANdevTx;
+    LSSslave->TXbuff = CO_CANtxBufferInit(
+            CANdevTx,           /* CAN device */
+            CANdevTxIdx,        /* index of specific buffer inside CAN module */
+            CANidLssSlave,      /* CAN identifier */
+            0,                  /* rtr */
+            8,                  /* number of data bytes */
+            0);                 /* synchronous message flag bit */
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+void CO_LSSslave_initCheckBitRateCallback(
+        CO_LSSslave_t          *LSSslave,
+        void                   *object,
+        bool_t                (*pFunctLSScheckBitRate)(void *object, uint16_t bitRate))
+{
+    if(LSSslave != NULL){
+        LSSslave->functLSScheckBitRateObject = object;
+        LSSslave->pFunctLSScheckBitRate = pFunctLSScheckBitRate;
+    }
+}
+
+
+/******************************************************************************/
+void CO_LSSslave_initCfgStoreCallback(
+        CO_LSSslave_t          *LSSslave,
+        void                   *object,
+        bool_t                (*pFunctLSScfgStore)(void *object, uint8_t id, uint16_t bitRate))
+{
+    if(LSSslave != NULL){
+        LSSslave->functLSScfgStoreObject = object;
+        LSSslave->pFunctLSScfgStore = pFunctLSScfgStore;
+    }
+}
+
+
+/******************************************************************************/
+bool_t CO_LSSslave_process(CO_LSSslave_t *LSSslave){
+    bool_t resetCommunication = false;
+    bool_t respond = false;
+    const uint8_t *data = LSSslave->CANrxData;
+    uint8_t *tx = LSSslave->TXbuff->data;
+    uint8_t cs;
+    uint32_t value;
+    uint8_t i;
+
+    /* response to the previous message is not sent yet, keep the new one */
+    if(!LSSslave->CANrxNew || LSSslave->TXbuff->bufferFull){
+        return false;
+    }
+
+    cs = data[0];
+    value = CO_getUint32(&data[1]);
+    for(i=1; i<8; i++){
+        tx[i] = 0;
+    }
+    tx[0] = cs;
+
+    switch(cs){
+        case CO_LSS_SWITCH_STATE_GLOBAL:
+            if(data[1] == CO_LSS_STATE_WAITING){
+                /* Unconfigured node starts CANopen as soon as it got the node ID. */
+                if(LSSslave->lssState == CO_LSS_STATE_CONFIGURATION
+                   && LSSslave->activeNodeID == CO_LSS_NODE_ID_ASSIGNMENT
+                   && LSSslave->pendingNodeID != CO_LSS_NODE_ID_ASSIGNMENT)
+                {
+                    LSSslave->activeNodeID = LSSslave->pendingNodeID;
+                    resetCommunication = true;
+                }
+                LSSslave->lssState = CO_LSS_STATE_WAITING;
+            }
+            else if(data[1] == CO_LSS_STATE_CONFIGURATION){
+                LSSslave->lssState = CO_LSS_STATE_CONFIGURATION;
+            }
+            break;
+
+        case CO_LSS_SWITCH_STATE_SEL_VENDOR:
+        case CO_LSS_SWITCH_STATE_SEL_PRODUCT:
+        case CO_LSS_SWITCH_STATE_SEL_REV:
+        case CO_LSS_SWITCH_STATE_SEL_SERIAL:
+            LSSslave->lssSelect.addr[cs - CO_LSS_SWITCH_STATE_SEL_VENDOR] = value;
+            if(cs == CO_LSS_SWITCH_STATE_SEL_SERIAL
+               && LSSslave->lssSelect.identity.vendorID == LSSslave->lssAddress.identity.vendorID
+               && LSSslave->lssSelect.identity.productCode == LSSslave->lssAddress.identity.productCode
+               && LSSslave->lssSelect.identity.revisionNumber == LSSslave->lssAddress.identity.revisionNumber
+               && LSSslave->lssSelect.identity.serialNumber == LSSslave->lssAddress.identity.serialNumber)
+            {
+                LSSslave->lssState = CO_LSS_STATE_CONFIGURATION;
+                tx[0] = CO_LSS_SWITCH_STATE_SEL;
+                respond = true;
+            }
+            break;
+
+        case CO_LSS_CFG_NODE_ID:
+            if(LSSslave->lssState != CO_LSS_STATE_CONFIGURATION) break;
+            if(CO_LSS_NODE_ID_VALID(data[1])){
+                LSSslave->pendingNodeID = data[1];
+                tx[1] = CO_LSS_CFG_OK;
+            }
+            else{
+                tx[1] = CO_LSS_CFG_OUT_OF_RANGE;
+            }
+            respond = true;
+            break;
+
+        case CO_LSS_CFG_BIT_TIMING:
+            if(LSSslave->lssState != CO_LSS_STATE_CONFIGURATION) break;
+            tx[1] = CO_LSS_CFG_OUT_OF_RANGE;
+            if(data[1] == CO_LSS_BIT_TIMING_TABLE && data[2] < CO_LSS_BIT_TIMING_TABLE_SIZE){
+                uint16_t bitRate = CO_LSS_bitTimingTable[data[2]];
+
+                if(bitRate != 0 && (LSSslave->pFunctLSScheckBitRate == NULL
+                   || LSSslave->pFunctLSScheckBitRate(LSSslave->functLSScheckBitRateObject, bitRate)))
+                {
+                    LSSslave->pendingBitRate = bitRate;
+                    tx[1] = CO_LSS_CFG_OK;
+                }
+            }
+            respond = true;
+            break;
+
+        case CO_LSS_CFG_ACTIVATE_BIT_TIMING:
+            /* no response, all configured nodes switch at the same time */
+            if(LSSslave->lssState != CO_LSS_STATE_CONFIGURATION) break;
+            if(LSSslave->pendingBitRate != LSSslave->activeBitRate){
+                LSSslave->activeBitRate = LSSslave->pendingBitRate;
+                LSSslave->switchDelay = CO_getUint16(&data[1]);
+                resetCommunication = true;
+            }
+            break;
+
+        case CO_LSS_CFG_STORE:
+            if(LSSslave->lssState != CO_LSS_STATE_CONFIGURATION) break;
+            if(LSSslave->pFunctLSScfgStore == NULL){
+                tx[1] = CO_LSS_CFG_STORE_NOT_SUPPORTED;
+            }
+            else if(LSSslave->pFunctLSScfgStore(LSSslave->functLSScfgStoreObject,
+                        LSSslave->pendingNodeID, LSSslave->pendingBitRate))
+            {
+                tx[1] = CO_LSS_CFG_OK;
+            }
+            else{
+                tx[1] = CO_LSS_CFG_STORE_FAILED;
+            }
+            respond = true;
+            break;
+
+        case CO_LSS_INQUIRE_VENDOR:
+        case CO_LSS_INQUIRE_PRODUCT:
+        case CO_LSS_INQUIRE_REV:
+        case CO_LSS_INQUIRE_SERIAL:
+            if(LSSslave->lssState != CO_LSS_STATE_CONFIGURATION) break;
+            CO_setUint32(&tx[1], LSSslave->lssAddress.addr[cs - CO_LSS_INQUIRE_VENDOR]);
+            respond = true;
+            break;
+
+        case CO_LSS_INQUIRE_NODE_ID:
+            if(LSSslave->lssState != CO_LSS_STATE_CONFIGURATION) break;
+            tx[1] = LSSslave->activeNodeID;
+            respond = true;
+            break;
+
+        case CO_LSS_IDENT_REMOTE_VENDOR:
+        case CO_LSS_IDENT_REMOTE_PRODUCT:
+        case CO_LSS_IDENT_REMOTE_REV_LOW:
+        case CO_LSS_IDENT_REMOTE_REV_HIGH:
+        case CO_LSS_IDENT_REMOTE_SERIAL_LOW:
+        case CO_LSS_IDENT_REMOTE_SERIAL_HIGH:
+            LSSslave->lssIdent[cs - CO_LSS_IDENT_REMOTE_VENDOR] = value;
+            if(cs == CO_LSS_IDENT_REMOTE_SERIAL_HIGH
+               && LSSslave->lssIdent[0] == LSSslave->lssAddress.identity.vendorID
+               && LSSslave->lssIdent[1] == LSSslave->lssAddress.identity.productCode
+               && LSSslave->lssIdent[2] <= LSSslave->lssAddress.identity.revisionNumber
+               && LSSslave->lssIdent[3] >= LSSslave->lssAddress.identity.revisionNumber
+               && LSSslave->lssIdent[4] <= LSSslave->lssAddress.identity.serialNumber
+               && LSSslave->lssIdent[5] >= LSSslave->lssAddress.identity.serialNumber)
+            {
+                tx[0] = CO_LSS_IDENT_SLAVE;
+                respond = true;
+            }
+            break;
+
+        case CO_LSS_IDENT_REMOTE_NON_CONFIG:
+            if(CO_LSSslave_isUnconfigured(LSSslave)){
+                tx[0] = CO_LSS_IDENT_NON_CONFIG_SLAVE;
+                respond = true;
+            }
+            break;
+
+        case CO_LSS_IDENT_FASTSCAN: {
+            uint8_t bitCheck = data[5];
+            uint8_t lssSub = data[6];
+            uint8_t lssNext = data[7];
+
+            if(LSSslave->lssState != CO_LSS_STATE_WAITING || !CO_LSSslave_isUnconfigured(LSSslave)
+               || lssSub > CO_LSS_FASTSCAN_SERIAL || lssNext > CO_LSS_FASTSCAN_SERIAL)
+            {
+                break;
+            }
+
+            if(bitCheck == CO_LSS_FASTSCAN_CONFIRM){
+                /* restart, every unconfigured slave takes part */
+                LSSslave->fastscanPos = CO_LSS_FASTSCAN_VENDOR_ID;
+                respond = true;
+            }
+            else if(bitCheck <= 31 && lssSub == LSSslave->fastscanPos){
+                /* compare bits from 31 down to bitCheck */
+                uint32_t mask = 0xFFFFFFFFUL << bitCheck;
+
+                if(((value ^ LSSslave->lssAddress.addr[lssSub]) & mask) == 0){
+                    respond = true;
+                    if(bitCheck == 0){
+                        /* whole sub matched, it is the only slave left, if lssNext wraps */
+                        LSSslave->fastscanPos = lssNext;
+                        if(lssNext < lssSub){
+                            LSSslave->lssState = CO_LSS_STATE_CONFIGURATION;
+                        }
+                    }
+                }
+            }
+            if(respond){
+                tx[0] = CO_LSS_IDENT_SLAVE;
+            }
+            break;
+        }
+
+        default:
+            break;
+    }
+
+    if(respond){
+        CO_CANsend(LSSslave->CANdevTx, LSSslave->TXbuff);
+    }
+
+    LSSslave->CANrxNew = false;
+
+    return resetCommunication;
+}
@@ -0,0 +1,195 @@
+/**
+ * CANopen Layer Setting Services protocol (slave).
+ *
+ * @file        CO_LSSslave.h
+ * @ingroup     CO_LSSslave
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+
+#ifndef CO_LSSslave_H
+#define CO_LSSslave_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "CO_LSS.h"
+
+/**
+ * @defgroup CO_LSSslave LSS Slave
+ * @ingroup CO_CANopen
+ * @{
+ *
+ * CANopen Layer Setting Services protocol (slave).
+ *
+ * LSS slave answers the LSS master on COB-ID 0x7E4. It supports switch state
+ * global and selective, configure node ID and bit timing, activate bit timing,
+ * store configuration, inquire identity and node ID, identify remote and
+ * non-configured slave and Fastscan.
+ *
+ * Received messages are only copied in the CAN receive interrupt, they are
+ * handled in CO_LSSslave_process(). New node ID and bit rate are not applied
+ * by this object. On every communication reset application must reinitialize
+ * the CANopen objects with _pendingNodeID_ and the CAN interface with
+ * _activeBitRate_. If CO_LSSslave_process() returns true, the communication
+ * reset is requested by the LSS master and the CAN interface must stay silent
+ * for _switchDelay_ milliseconds before and after the bit rate is changed.
+ *
+ * @see @ref CO_LSS
+ */
+
+
+/**
+ * LSS slave object.
+ */
+typedef struct{
+    CO_LSS_address_t    lssAddress;     /**< From CO_LSSslave_init() */
+    CO_LSS_state_t      lssState;       /**< #CO_LSS_state_t */
+    CO_LSS_address_t    lssSelect;      /**< Received address of switch state selective */
+    uint32_t            lssIdent[6];    /**< Received address range of identify remote slave */
+    uint8_t             fastscanPos;    /**< Fastscan: next expected LSS address sub */
+    uint16_t            pendingBitRate; /**< Configured, not yet activated bit rate in kbit/s */
+    uint8_t             pendingNodeID;  /**< Configured, not yet activated node ID */
+    uint16_t            activeBitRate;  /**< Bit rate used on the CAN interface in kbit/s */
+    uint8_t             activeNodeID;   /**< Node ID used by the CANopen objects */
+    /** Activate bit timing: the time in ms, the node must stay silent before
+        and after switching to _activeBitRate_. */
+    uint16_t            switchDelay;
+    /** From CO_LSSslave_initCheckBitRateCallback() or NULL */
+    bool_t            (*pFunctLSScheckBitRate)(void *object, uint16_t bitRate);
+    void               *functLSScheckBitRateObject; /**< Object for the above callback */
+    /** From CO_LSSslave_initCfgStoreCallback() or NULL */
+    bool_t            (*pFunctLSScfgStore)(void *object, uint8_t id, uint16_t bitRate);
+    void               *functLSScfgStoreObject; /**< Object for the above callback */
+    volatile bool_t     CANrxNew;       /**< True, if new LSS message received from the CAN bus */
+    uint8_t             CANrxData[8];   /**< 8 data bytes of the received message */
+    CO_CANmodule_t     *CANdevTx;       /**< From CO_LSSslave_init() */
+    CO_CANtx_t         *TXbuff;         /**< CAN transmit buffer */
+}CO_LSSslave_t;
+
+
+/**
+ * Initialize LSS slave object.
+ *
+ * Function must be called in the communication reset section, before all
+ * other CANopen objects, because node ID is not known yet, if it is
+ * #CO_LSS_NODE_ID_ASSIGNMENT.
+ *
+ * @param LSSslave This object will be initialized.
+ * @param lssAddress LSS address of this node, usually identity object 0x1018.
+ * Serial number must be unique in the network.
+ * @param pendingBitRate Bit rate, the CAN interface currently uses [kbit/s].
+ * @param pendingNodeID Node ID, stored in nonvolatile memory, or
+ * #CO_LSS_NODE_ID_ASSIGNMENT.
+ * @param CANdevRx CAN device for LSS slave reception.
+ * @param CANdevRxIdx Index of receive buffer in the above CAN device.
+ * @param CANidLssMaster COB ID for reception (0x7E5).
+ * @param CANdevTx CAN device for LSS slave transmission.
+ * @param CANdevTxIdx Index of transmit buffer in the above CAN device.
+ * @param CANidLssSlave COB ID for transmission (0x7E4).
+ *
+ * @return #CO_ReturnError_t: CO_ERROR_NO or CO_ERROR_ILLEGAL_ARGUMENT.
+ */
+CO_ReturnError_t CO_LSSslave_init(
+        CO_LSSslave_t          *LSSslave,
+        const CO_LSS_address_t *lssAddress,
+        uint16_t                pendingBitRate,
+        uint8_t                 pendingNodeID,
+        CO_CANmodule_t         *CANdevRx,
+        uint16_t                CANdevRxIdx,
+        uint32_t                CANidLssMaster,
+        CO_CANmodule_t         *CANdevTx,
+        uint16_t                CANdevTxIdx,
+        uint32_t                CANidLssSlave);
+
+
+/**
+ * Initialize verify bit rate callback.
+ *
+ * Function is called on configure bit timing service. If not registered,
+ * every bit rate from the CiA 305 table is accepted.
+ *
+ * @param LSSslave This object.
+ * @param object Pointer to object, which will be passed to pFunctLSScheckBitRate(). Can be NULL
+ * @param pFunctLSScheckBitRate Pointer to the callback function. Returns true,
+ * if CAN interface supports bitRate [kbit/s].
+ */
+void CO_LSSslave_initCheckBitRateCallback(
+        CO_LSSslave_t          *LSSslave,
+        void                   *object,
+        bool_t                (*pFunctLSScheckBitRate)(void *object, uint16_t bitRate));
+
+
+/**
+ * Initialize store configuration callback.
+ *
+ * Function is called on store configuration service. If not registered,
+ * service responds with "not supported".
+ *
+ * @param LSSslave This object.
+ * @param object Pointer to object, which will be passed to pFunctLSScfgStore(). Can be NULL
+ * @param pFunctLSScfgStore Pointer to the callback function. Returns true, if
+ * node ID and bit rate were written into nonvolatile memory.
+ */
+void CO_LSSslave_initCfgStoreCallback(
+        CO_LSSslave_t          *LSSslave,
+        void                   *object,
+        bool_t                (*pFunctLSScfgStore)(void *object, uint8_t id, uint16_t bitRate));
+
+
+/**
+ * Process LSS slave.
+ *
+ * Function must be called cyclically, also if node ID is not configured.
+ *
+ * @param LSSslave This object.
+ *
+ * @return True, if node ID or bit rate was activated by the LSS master. In
+ * that case application must reset communication with _pendingNodeID_ and
+ * _activeBitRate_.
+ */
+bool_t CO_LSSslave_process(CO_LSSslave_t *LSSslave);
+
+
+#ifdef __cplusplus
+}
+#endif /*__cplusplus*/
+
+/** @} */
+#endif
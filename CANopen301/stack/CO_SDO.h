@@ -439,7 +439,11 @@ typedef enum{
     OD_H1A00_TXPDO_1_MAPPING      = 0x1A00U,/**< TXPDO mapping parameters */
     OD_H1A01_TXPDO_2_MAPPING      = 0x1A01U,/**< TXPDO mapping parameters */
     OD_H1A02_TXPDO_3_MAPPING      = 0x1A02U,/**< TXPDO mapping parameters */
-    OD_H1A03_TXPDO_4_MAPPING      = 0x1A03U /**< TXPDO mapping parameters */
+    OD_H1A03_TXPDO_4_MAPPING      = 0x1A03U,/**< TXPDO mapping parameters */
+    OD_H1F50_PROGRAM_DATA         = 0x1F50U,/**< Program download data */
+    OD_H1F51_PROGRAM_CONTROL      = 0x1F51U,/**< Program control */
+    OD_H1F56_PROGRAM_SW_ID        = 0x1F56U,/**< Program software identification */
+    OD_H1F57_FLASH_STATUS         = 0x1F57U /**< Flash status identification */
 }CO_ObjDicId_t;
 
 
@@ -47,7 +47,10 @@
 //============================================================================
 //                                INCLUDES
 //============================================================================
+#include <string.h>
 #include "CANopen.h"
+#include "CO_Flash.h"
+#include "CO_FlashKV.h"
 #include "stm32f3xx.h"
 
 //============================================================================
@@ -56,13 +59,7 @@
 #define PARAM_STORE_PASSWORD   0x65766173
 #define PARAM_RESTORE_PASSWORD 0x64616F6C
 
-#define DEBUG 0
-
-#define LAST_PAGE_ADDRESS           0x0800F800
-#define PAGES_PER_FLASH_AREA        1
-#define FLASH_PAGE_SIZE             0x800
-#define CO_OD_FLASH_PARAM_DEFAULT   LAST_PAGE_ADDRESS - (1*PAGES_PER_FLASH_AREA*FLASH_PAGE_SIZE)
-#define CO_OD_FLASH_PARAM_RUNTIME   LAST_PAGE_ADDRESS - (2*PAGES_PER_FLASH_AREA*FLASH_PAGE_SIZE)
+#define CO_FLASH_AUTOSAVE_DELAY_MS  60000U
 
 #define CO_UNUSED(v)  (void)(v)
 
@@ -70,6 +67,7 @@
 //                                LOCAL DATA
 //============================================================================
 extern struct sCO_OD_ROM CO_OD_ROM;
+extern struct sCO_OD_EEPROM CO_OD_EEPROM;
 
 enum CO_OD_H1010_StoreParam_Sub
 {
@@ -102,87 +100,68 @@ enum CO_RestoreFunctionality_Flags
     RESTORES_PARAMETERS   = 0x01
 };
 
-extern void FLASH_PageErase(uint32_t PageAddress);
+static bool_t (*CO_FlashIdle)(void);
+static uint32_t CO_FlashAutoSaveTimer;
+static bool_t CO_FlashRestorePending;   /* defaults are loaded after reset, autosave stops */
+
 //============================================================================
 /**
 * Store parameters of object dictionary into flash memory.
-* \param[in] FlashAddress Use CO_OD_Flash_Adress for the normal parameter
-*                         block and CO_OD_Flash_Default_Param for the
-*                         default parameters
 */
-static CO_SDO_abortCode_t storeParameters(uint32_t FlashAddress, uint8_t ParametersSub)
+static CO_SDO_abortCode_t storeParameters(uint8_t ParametersSub)
 {
-    uint32_t addressPtr = 0x00;
-    uint32_t addressFinal = 0x00;
-    uint32_t* chunk;
-		uint64_t	U64;
     CO_UNUSED(ParametersSub);
 
-    /* Unlock flash*/
-    HAL_FLASH_Unlock();
-
-    /* Check flash allocation */
-    int32_t bytes_to_write = sizeof(CO_OD_ROM);
-    if ((uint32_t)bytes_to_write > (FLASH_PAGE_SIZE*PAGES_PER_FLASH_AREA)) {
+    if (CO_FlashKV_write(CO_FLASH_KEY_OD_ROM, &CO_OD_ROM, sizeof(CO_OD_ROM)) != CO_ERROR_NO) {
         return CO_SDO_AB_HW;
     }
-
-    addressFinal = FlashAddress + bytes_to_write;
-    /* Clear pending flakgs (if any) */  
-    //FLASH_ClearFlag(FLASH_FLAG_EOP | FLASH_FLAG_PGERR | FLASH_FLAG_WRPERR); 
-
-    /* Erase page */
-    //FLASH_ErasePage(FlashAddress);
-		FLASH_PageErase(FlashAddress);
-		
-    /* Program data into flash word by word */
-    chunk = (uint32_t*) &CO_OD_ROM;
-		U64	=(uint64_t)*chunk;
-		
-    for (addressPtr = FlashAddress; addressPtr < addressFinal; addressPtr += 4) {
-			/*
-        if (FLASH_ProgramWord(addressPtr, *chunk) != FLASH_COMPLETE) {
-            return CO_SDO_AB_HW;
-        }
-			*/
-				if( HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, addressPtr, U64) != HAL_OK ){
-					return CO_SDO_AB_HW;
-				}
-        chunk++;
-				U64	=(uint64_t)*chunk;
+    if (CO_FlashKV_write(CO_FLASH_KEY_OD_EEPROM, &CO_OD_EEPROM, sizeof(CO_OD_EEPROM)) != CO_ERROR_NO) {
+        return CO_SDO_AB_HW;
     }
-    HAL_FLASH_Lock();
+    CO_FlashRestorePending = false;
 
     return CO_SDO_AB_NONE;
 }
 
 //============================================================================
 /**
-* Restore parameters of object dictionary from flash memory.
-* \param[in] FlashAddress Use CO_OD_Flash_Adress for the normal parameter
-*                         block and CO_OD_Flash_Default_Param for the
-*                         default parameters
+* Remove stored parameters, compiled defaults are used after next reset.
 */
-void flash_read(uint32_t FlashAddress, void* RamAddress, size_t len)
+static CO_SDO_abortCode_t restoreParameters(uint8_t ParametersSub)
 {
-    uint8_t* p_flash = (uint8_t *) FlashAddress;
-    uint8_t* p_ram = (uint8_t *) RamAddress;
-    uint32_t idx;
-
-    for (idx = 0; idx < len; idx++) {
-        *p_ram = *(__IO uint8_t *)p_flash;
-        p_ram++;
-        p_flash++;
+    CO_UNUSED(ParametersSub);
+
+    if (CO_FlashKV_write(CO_FLASH_KEY_OD_ROM, NULL, 0) != CO_ERROR_NO) {
+        return CO_SDO_AB_HW;
+    }
+    if (CO_FlashKV_write(CO_FLASH_KEY_OD_EEPROM, NULL, 0) != CO_ERROR_NO) {
+        return CO_SDO_AB_HW;
     }
+    CO_FlashRestorePending = true;
+
+    return CO_SDO_AB_NONE;
 }
 
-static CO_SDO_abortCode_t restoreParameters(uint32_t FlashAddress, uint8_t ParametersSub)
+//============================================================================
+/**
+* Load a block of object dictionary. Block is only accepted, if it has the
+* same size and FirstWord/LastWord as the compiled one.
+*/
+static CO_ReturnError_t loadParameters(uint16_t key, void* block, size_t len)
 {
-    CO_UNUSED(ParametersSub);
+    uint16_t storedLength;
+    const uint8_t* stored = CO_FlashKV_find(key, &storedLength);
 
-    flash_read(FlashAddress, &CO_OD_ROM, sizeof(CO_OD_ROM));
+    if (stored == NULL) {
+        return CO_ERROR_PARAMETERS;
+    }
+    if ((storedLength != len) ||
+        (stored[0] != CO_OD_FIRST_LAST_WORD) || (stored[len - 4U] != CO_OD_FIRST_LAST_WORD)) {
+        return CO_ERROR_DATA_CORRUPT;
+    }
 
-    return CO_SDO_AB_NONE;
+    memcpy(block, stored, len);
+    return CO_ERROR_NO;
 }
 
 //============================================================================
@@ -196,7 +175,7 @@ static CO_SDO_abortCode_t CO_ODF_1010_StoreParam(CO_ODF_arg_t *ODF_arg)
 
     if (ODF_arg->reading) {
         if(OD_H1010_STORE_PARAM_ALL == ODF_arg->subIndex) {
-            *value = SAVES_PARAM_ON_COMMAND;
+            *value = SAVES_PARAM_ON_COMMAND | SAVES_PARAM_AUTONOMOUSLY;
         }
         return CO_SDO_AB_NONE;
     }
@@ -209,12 +188,16 @@ static CO_SDO_abortCode_t CO_ODF_1010_StoreParam(CO_ODF_arg_t *ODF_arg)
         return CO_SDO_AB_DATA_TRANSF;
     }
 
-    return storeParameters(CO_OD_FLASH_PARAM_RUNTIME, ODF_arg->subIndex);
+    if (!CO_FlashIdle()) {
+        return CO_SDO_AB_DATA_DEV_STATE;
+    }
+
+    return storeParameters(ODF_arg->subIndex);
 }
 
 //============================================================================
 /**
-* Access to object dictionary OD_H1010_STORE_PARAM_FUNC
+* Access to object dictionary OD_H1011_REST_PARAM_FUNC
 */
 static CO_SDO_abortCode_t CO_ODF_1011_RestoreParam(CO_ODF_arg_t *ODF_arg)
 {
@@ -235,52 +218,53 @@ static CO_SDO_abortCode_t CO_ODF_1011_RestoreParam(CO_ODF_arg_t *ODF_arg)
         return CO_SDO_AB_DATA_TRANSF;
     }
 
-    CO_SDO_abortCode_t Result = restoreParameters(CO_OD_FLASH_PARAM_DEFAULT, ODF_arg->subIndex);
-    
-    if (Result != CO_SDO_AB_NONE) {
-        return Result;
+    if (!CO_FlashIdle()) {
+        return CO_SDO_AB_DATA_DEV_STATE;
     }
 
-    return storeParameters(CO_OD_FLASH_PARAM_RUNTIME, OD_H1011_RESTORE_PARAM_ALL);
+    return restoreParameters(ODF_arg->subIndex);
 }
 
 //===========================================================================
-/**
-* Initialize flash library and data storage in flash
-* We use two blocks in flash for data storage. One block is used for the
-* default data that will be restored. The default parameters are stored
-* at address CO_OD_Flash_Default_Param. The data that will be loaded at
-* startup or saved if user modifies data is store at CO_OD_Flash_Adress.
-*/
-void CO_FlashInit(void)
+CO_ReturnError_t CO_FlashInit(void)
 {
-    /* Before we can access the data, we need to make sure, that the flash
-    block are properly initialized. We do this by reading the block into
-    a local sCO_OD_ROM variable and verifying the FirstWord and LastWord
-    members. */
-
-    struct sCO_OD_ROM DefaultObjDicParam;
-    flash_read(CO_OD_FLASH_PARAM_DEFAULT, &DefaultObjDicParam, sizeof(DefaultObjDicParam));
+    if (CO_FlashKV_init() != CO_ERROR_NO) {
+        return CO_ERROR_DATA_CORRUPT;
+    }
 
-    /* If the default parameters are not present in flash, then we know that
-    we need to create them for later restore. */
+    loadParameters(CO_FLASH_KEY_OD_ROM, &CO_OD_ROM, sizeof(CO_OD_ROM));
 
-    if ((DefaultObjDicParam.FirstWord != CO_OD_FIRST_LAST_WORD) ||
-    (DefaultObjDicParam.LastWord  != CO_OD_FIRST_LAST_WORD)) {
-        storeParameters(CO_OD_FLASH_PARAM_RUNTIME, OD_H1010_STORE_PARAM_ALL);
-        storeParameters(CO_OD_FLASH_PARAM_DEFAULT, OD_H1010_STORE_PARAM_ALL);
-    }
-    else {
-        restoreParameters(CO_OD_FLASH_PARAM_RUNTIME, OD_H1010_STORE_PARAM_ALL);
-    }
+    return loadParameters(CO_FLASH_KEY_OD_EEPROM, &CO_OD_EEPROM, sizeof(CO_OD_EEPROM));
 }
 
 //===========================================================================
-void CO_FlashRegisterODFunctions(CO_t* CO)
+void CO_FlashRegisterODFunctions(CO_t* CO, bool_t (*pFunctIdle)(void))
 {
+    CO_FlashIdle = pFunctIdle;
+
     CO_OD_configure(*(CO->SDO), OD_H1010_STORE_PARAM_FUNC,
     CO_ODF_1010_StoreParam, (void*)0, 0, 0);
 
     CO_OD_configure(*(CO->SDO), OD_H1011_REST_PARAM_FUNC,
     CO_ODF_1011_RestoreParam, (void*)0, 0, 0);
 }
+
+//===========================================================================
+void CO_FlashProcess(uint16_t timeDifference_ms)
+{
+    if ((CO_FlashIdle == NULL) || CO_FlashRestorePending) {
+        return;
+    }
+
+    if (CO_FlashAutoSaveTimer < CO_FLASH_AUTOSAVE_DELAY_MS) {
+        CO_FlashAutoSaveTimer += timeDifference_ms;
+        return;
+    }
+    if (!CO_FlashIdle()) {
+        return;
+    }
+    CO_FlashAutoSaveTimer = 0;
+
+    /* nothing is written, if CO_OD_EEPROM is unchanged */
+    CO_FlashKV_write(CO_FLASH_KEY_OD_EEPROM, &CO_OD_EEPROM, sizeof(CO_OD_EEPROM));
+}
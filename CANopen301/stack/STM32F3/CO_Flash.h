@@ -52,20 +52,40 @@
 //============================================================================
 #include "CANopen.h"
 
+/* Keys of the flash key-value store, see CO_FlashKV.h */
+#define CO_FLASH_KEY_OD_ROM         0U  /* CO_OD_ROM, stored by 0x1010 */
+#define CO_FLASH_KEY_OD_EEPROM      1U  /* CO_OD_EEPROM, stored automatically */
+#define CO_FLASH_KEY_LSS            2U  /* node ID and bit rate from the LSS master */
+#define CO_FLASH_KEY_MODBUS         3U  /* Modbus slave address */
+
 /**
- * Initialize flash library and data storage in flash
- * We use two blocks in flash for data storage. One block is used for the
- * default data that will be restored. The default parameters are stored
- * at address CO_OD_Flash_Default_Param. The data that will be loaded at
- * startup or saved if user modifies data.
+ * Initialize flash library and load the object dictionary.
+ * CO_OD_ROM and CO_OD_EEPROM are overwritten with the values from the flash
+ * key-value store, if they were stored with the same object dictionary
+ * layout. Otherwise the compiled defaults are kept.
+ *
+ * @return CO_ERROR_NO if CO_OD_EEPROM was loaded from flash, CO_ERROR_PARAMETERS
+ * if defaults are used or CO_ERROR_DATA_CORRUPT if flash can not be used.
  */
-void CO_FlashInit(void);
+CO_ReturnError_t CO_FlashInit(void);
 
 /**
  * Register object dictionary functions for parameter storage and restoring
  * parameters (Object dictionary index 0x1010 Store Param and 0x1011 Restore
  * default param.
+ *
+ * Flash stalls the CPU while it is written, so parameters are only stored
+ * while pFunctIdle() returns true (motor stopped).
+ */
+void CO_FlashRegisterODFunctions(CO_t* CO, bool_t (*pFunctIdle)(void));
+
+/**
+ * Store CO_OD_EEPROM, if it was changed. Changes are collected for
+ * CO_FLASH_AUTOSAVE_DELAY_MS to limit flash wear. Must be called cyclically
+ * from the main loop.
+ *
+ * @param timeDifference_ms Time difference from previous function call.
  */
-void CO_FlashRegisterODFunctions(CO_t* CO);
+void CO_FlashProcess(uint16_t timeDifference_ms);
 
 #endif
@@ -0,0 +1,395 @@
+/*
+ * STM32F3 flash key-value store for CANopen stack
+ *
+ * @file        CO_FlashKV.c
+ * @author      Janez Paternoster
+ * @copyright   2014 Janez Paternoster
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+//============================================================================
+//                                INCLUDES
+//============================================================================
+#include <string.h>
+#include "CO_FlashKV.h"
+#include "crc16-ccitt.h"
+#include "stm32f3xx.h"
+
+//============================================================================
+//                                DEFINES
+//============================================================================
+#define KV_PAGE_MAGIC       0x564BU     /* "KV" */
+#define KV_COMMIT           0x0000U
+#define KV_ERASED           0xFFFFU
+#define KV_PAGE_HEADER      12U
+#define KV_RECORD_HEADER    8U
+#define KV_RECORD_SIZE(len) (KV_RECORD_HEADER + (((uint32_t)(len) + 1U) & ~1U))
+
+#if CO_FLASHKV_PAGES < 2
+#error CO_FLASHKV_PAGES: at least two pages are required for compaction
+#endif
+
+//============================================================================
+//                                LOCAL DATA
+//============================================================================
+typedef struct
+{
+    uint32_t eraseCount;
+    uint32_t sequence;
+    uint16_t crc;
+    uint16_t magic;
+} CO_FlashKV_page_t;
+
+typedef struct
+{
+    uint16_t key;
+    uint16_t length;
+    uint16_t crc;
+    uint16_t commit;
+} CO_FlashKV_record_t;
+
+static struct
+{
+    uint32_t    page;                       /* address of the active page */
+    uint32_t    sequence;
+    uint32_t    writeOffset;
+    uint16_t    index[CO_FLASHKV_KEYS];     /* record offsets in the active page, 0 if not stored */
+} CO_KV;
+
+//============================================================================
+static const CO_FlashKV_page_t* kvPageHeader(uint32_t page)
+{
+    return (const CO_FlashKV_page_t*) page;
+}
+
+/* Erase interrupted by a power loss may leave magic and raise the sequence,
+ * crc of the header rejects such a page */
+static uint16_t kvPageCrc(uint32_t eraseCount, uint32_t sequence)
+{
+    uint8_t header[8];
+    uint8_t i;
+
+    for (i = 0; i < 4U; i++) {
+        header[i] = (uint8_t)(eraseCount >> (8U * i));
+        header[i + 4U] = (uint8_t)(sequence >> (8U * i));
+    }
+
+    return crc16_ccitt(header, 8, 0);
+}
+
+static bool_t kvPageValid(const CO_FlashKV_page_t* header)
+{
+    return ((header->magic == KV_PAGE_MAGIC)
+        && (header->crc == kvPageCrc(header->eraseCount, header->sequence))) ? true : false;
+}
+
+static const CO_FlashKV_record_t* kvRecord(uint32_t offset)
+{
+    return (const CO_FlashKV_record_t*) (CO_KV.page + offset);
+}
+
+static uint16_t kvCrc(uint16_t key, uint16_t length, const uint8_t* data)
+{
+    uint8_t header[4];
+
+    header[0] = (uint8_t)key;
+    header[1] = (uint8_t)(key >> 8);
+    header[2] = (uint8_t)length;
+    header[3] = (uint8_t)(length >> 8);
+
+    return crc16_ccitt(data, length, crc16_ccitt(header, 4, 0));
+}
+
+//============================================================================
+static bool_t kvErasePage(uint32_t page)
+{
+    FLASH_EraseInitTypeDef erase;
+    uint32_t pageError = 0;
+
+    erase.TypeErase = FLASH_TYPEERASE_PAGES;
+    erase.PageAddress = page;
+    erase.NbPages = 1;
+
+    return (HAL_FLASHEx_Erase(&erase, &pageError) == HAL_OK) ? true : false;
+}
+
+/* Program bytes halfword by halfword, odd length is padded with 0xFF */
+static bool_t kvProgram(uint32_t address, const uint8_t* data, uint32_t length)
+{
+    uint32_t i;
+
+    for (i = 0; i < length; i += 2U) {
+        uint16_t hw = data[i];
+        hw |= (i + 1U < length) ? (uint16_t)((uint16_t)data[i + 1U] << 8) : (uint16_t)0xFF00U;
+        if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, address + i, hw) != HAL_OK) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool_t kvProgramHalfword(uint32_t address, uint16_t hw)
+{
+    return (HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, address, hw) == HAL_OK) ? true : false;
+}
+
+//============================================================================
+/**
+* Write page header, crc and magic last.
+*/
+static bool_t kvFormat(uint32_t page, uint32_t eraseCount, uint32_t sequence)
+{
+    const CO_FlashKV_page_t* header = kvPageHeader(page);
+
+    return kvProgramHalfword((uint32_t)&header->eraseCount, (uint16_t)eraseCount)
+        && kvProgramHalfword((uint32_t)&header->eraseCount + 2U, (uint16_t)(eraseCount >> 16))
+        && kvProgramHalfword((uint32_t)&header->sequence, (uint16_t)sequence)
+        && kvProgramHalfword((uint32_t)&header->sequence + 2U, (uint16_t)(sequence >> 16))
+        && kvProgramHalfword((uint32_t)&header->crc, kvPageCrc(eraseCount, sequence))
+        && kvProgramHalfword((uint32_t)&header->magic, KV_PAGE_MAGIC);
+}
+
+//============================================================================
+/**
+* Build the index from the active page. Records without commit or with wrong
+* CRC are skipped. If a record header is incomplete, the rest of the page is
+* unusable and the page is marked full.
+*/
+static void kvScan(void)
+{
+    uint32_t offset = KV_PAGE_HEADER;
+
+    memset(CO_KV.index, 0, sizeof(CO_KV.index));
+
+    while ((offset + KV_RECORD_HEADER) <= CO_FLASHKV_PAGE_SIZE) {
+        const CO_FlashKV_record_t* rec = kvRecord(offset);
+
+        if (rec->key == KV_ERASED) {
+            break;
+        }
+        if ((rec->length == KV_ERASED) || ((offset + KV_RECORD_SIZE(rec->length)) > CO_FLASHKV_PAGE_SIZE)) {
+            offset = CO_FLASHKV_PAGE_SIZE;
+            break;
+        }
+        if ((rec->commit == KV_COMMIT) && (rec->key < CO_FLASHKV_KEYS) &&
+            (kvCrc(rec->key, rec->length, (const uint8_t*)(rec + 1)) == rec->crc)) {
+            CO_KV.index[rec->key] = (rec->length == 0U) ? 0U : (uint16_t)offset;
+        }
+        offset += KV_RECORD_SIZE(rec->length);
+    }
+
+    CO_KV.writeOffset = offset;
+}
+
+//============================================================================
+/**
+* Copy the newest record of every key into the next page of the ring. The old
+* page stays valid until the magic of the new page is written.
+*/
+static bool_t kvCompact(void)
+{
+    uint32_t next = CO_KV.page + CO_FLASHKV_PAGE_SIZE;
+    const CO_FlashKV_page_t* header;
+    uint32_t eraseCount;
+    uint32_t offset = KV_PAGE_HEADER;
+    uint16_t index[CO_FLASHKV_KEYS];
+    uint16_t key;
+
+    if (next >= (CO_FLASHKV_ADDRESS + (CO_FLASHKV_PAGES * CO_FLASHKV_PAGE_SIZE))) {
+        next = CO_FLASHKV_ADDRESS;
+    }
+    header = kvPageHeader(next);
+    if (kvPageValid(header)) {
+        eraseCount = header->eraseCount;
+    }
+    else {
+        /* pages are erased in turn, the active page has about the same count */
+        eraseCount = kvPageHeader(CO_KV.page)->eraseCount;
+    }
+
+    if (!kvErasePage(next)) {
+        return false;
+    }
+
+    for (key = 0; key < CO_FLASHKV_KEYS; key++) {
+        index[key] = 0;
+        if (CO_KV.index[key] != 0U) {
+            const CO_FlashKV_record_t* rec = kvRecord(CO_KV.index[key]);
+            uint32_t size = KV_RECORD_SIZE(rec->length);
+
+            if (!kvProgram(next + offset, (const uint8_t*)rec, size)) {
+                return false;
+            }
+            index[key] = (uint16_t)offset;
+            offset += size;
+        }
+    }
+
+    if (!kvFormat(next, eraseCount + 1U, CO_KV.sequence + 1U)) {
+        return false;
+    }
+
+    CO_KV.page = next;
+    CO_KV.sequence++;
+    CO_KV.writeOffset = offset;
+    memcpy(CO_KV.index, index, sizeof(index));
+
+    return true;
+}
+
+//===========================================================================
+CO_ReturnError_t CO_FlashKV_init(void)
+{
+    uint32_t n;
+    bool_t found = false;
+
+    for (n = 0; n < CO_FLASHKV_PAGES; n++) {
+        uint32_t page = CO_FLASHKV_ADDRESS + (n * CO_FLASHKV_PAGE_SIZE);
+        const CO_FlashKV_page_t* header = kvPageHeader(page);
+
+        if (kvPageValid(header) && (!found || (header->sequence > CO_KV.sequence))) {
+            CO_KV.page = page;
+            CO_KV.sequence = header->sequence;
+            found = true;
+        }
+    }
+
+    if (!found) {
+        bool_t ok;
+
+        CO_KV.page = CO_FLASHKV_ADDRESS;
+        CO_KV.sequence = 1U;
+        HAL_FLASH_Unlock();
+        ok = kvErasePage(CO_KV.page) && kvFormat(CO_KV.page, 1U, CO_KV.sequence);
+        HAL_FLASH_Lock();
+        if (!ok) {
+            return CO_ERROR_DATA_CORRUPT;
+        }
+    }
+
+    kvScan();
+
+    return CO_ERROR_NO;
+}
+
+//===========================================================================
+const uint8_t* CO_FlashKV_find(uint16_t key, uint16_t *length)
+{
+    const CO_FlashKV_record_t* rec;
+
+    *length = 0;
+    if ((key >= CO_FLASHKV_KEYS) || (CO_KV.index[key] == 0U)) {
+        return NULL;
+    }
+
+    rec = kvRecord(CO_KV.index[key]);
+    *length = rec->length;
+    return (const uint8_t*)(rec + 1);
+}
+
+//===========================================================================
+CO_ReturnError_t CO_FlashKV_read(uint16_t key, void *data, uint16_t length)
+{
+    uint16_t storedLength;
+    const uint8_t* value = CO_FlashKV_find(key, &storedLength);
+
+    if (value == NULL) {
+        return CO_ERROR_PARAMETERS;
+    }
+    if (storedLength != length) {
+        return CO_ERROR_DATA_CORRUPT;
+    }
+
+    memcpy(data, value, length);
+    return CO_ERROR_NO;
+}
+
+//===========================================================================
+CO_ReturnError_t CO_FlashKV_write(uint16_t key, const void *data, uint16_t length)
+{
+    uint16_t storedLength;
+    const uint8_t* stored = CO_FlashKV_find(key, &storedLength);
+    uint32_t size = KV_RECORD_SIZE(length);
+    uint32_t offset;
+    uint32_t address;
+    bool_t ok;
+
+    if ((key >= CO_FLASHKV_KEYS) || ((data == NULL) && (length != 0U)) ||
+        (size > (CO_FLASHKV_PAGE_SIZE - KV_PAGE_HEADER))) {
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    /* unchanged value or already removed */
+    if ((stored == NULL) ? (length == 0U) :
+        ((storedLength == length) && (memcmp(stored, data, length) == 0))) {
+        return CO_ERROR_NO;
+    }
+
+    HAL_FLASH_Unlock();
+
+    if ((CO_KV.writeOffset + size) > CO_FLASHKV_PAGE_SIZE) {
+        if (!kvCompact()) {
+            HAL_FLASH_Lock();
+            return CO_ERROR_DATA_CORRUPT;
+        }
+        if ((CO_KV.writeOffset + size) > CO_FLASHKV_PAGE_SIZE) {
+            HAL_FLASH_Lock();
+            return CO_ERROR_OUT_OF_MEMORY;
+        }
+    }
+
+    offset = CO_KV.writeOffset;
+    address = CO_KV.page + offset;
+    CO_KV.writeOffset += size;
+
+    ok = kvProgramHalfword(address, key)
+      && kvProgramHalfword(address + 2U, length)
+      && kvProgramHalfword(address + 4U, kvCrc(key, length, (const uint8_t*)data))
+      && kvProgram(address + KV_RECORD_HEADER, (const uint8_t*)data, length)
+      && kvProgramHalfword(address + 6U, KV_COMMIT);
+
+    HAL_FLASH_Lock();
+
+    if (!ok || ((length != 0U) && (memcmp((const void*)(address + KV_RECORD_HEADER), data, length) != 0))) {
+        return CO_ERROR_DATA_CORRUPT;
+    }
+
+    CO_KV.index[key] = (length == 0U) ? 0U : (uint16_t)offset;
+
+    return CO_ERROR_NO;
+}
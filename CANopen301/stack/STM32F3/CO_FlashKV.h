@@ -0,0 +1,129 @@
+/*
+ * STM32F3 flash key-value store for CANopen stack
+ *
+ * @file        CO_FlashKV.h
+ * @author      Janez Paternoster
+ * @copyright   2014 Janez Paternoster
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+#ifndef CO_FLASHKV_H
+#define CO_FLASHKV_H
+
+//============================================================================
+//                                INCLUDES
+//============================================================================
+#include "CO_driver.h"
+
+//============================================================================
+//                                DEFINES
+//============================================================================
+/*
+ * Values are appended as records to one active flash page. When the page is
+ * full, the newest record of every key is copied into the next page of the
+ * ring, which then becomes active. Pages are used in turn, so erases are
+ * spread over all CO_FLASHKV_PAGES pages.
+ *
+ * Page:   | erase count (32) | sequence (32) | crc (16) | magic (16) | records ...
+ * Record: | key (16) | length (16) | crc (16) | commit (16) | data, padded to 16 bit |
+ *
+ * Commit of a record and magic of a page are programmed last, so a record or
+ * a compacted page is either complete or ignored after a power loss. The
+ * active page is the valid page with the highest sequence, a page is valid
+ * with magic and crc of its header. A RAM index of
+ * record offsets is rebuilt from the active page at startup.
+ */
+#ifndef CO_FLASHKV_ADDRESS
+#define CO_FLASHKV_ADDRESS          0x0800E800U
+#endif
+#ifndef CO_FLASHKV_PAGES
+#define CO_FLASHKV_PAGES            2U
+#endif
+#ifndef CO_FLASHKV_PAGE_SIZE
+#define CO_FLASHKV_PAGE_SIZE        0x800U
+#endif
+#ifndef CO_FLASHKV_KEYS
+#define CO_FLASHKV_KEYS             8U
+#endif
+
+/**
+ * Find the active page and build the RAM index. If no valid page exists, the
+ * first page is formatted.
+ *
+ * @return CO_ERROR_NO or CO_ERROR_DATA_CORRUPT (flash can not be written).
+ */
+CO_ReturnError_t CO_FlashKV_init(void);
+
+/**
+ * Get the stored value of a key, without copying it.
+ *
+ * @param key Key, smaller than CO_FLASHKV_KEYS.
+ * @param length Length of the value is written here, 0 if not stored.
+ *
+ * @return Pointer to the value in flash or NULL.
+ */
+const uint8_t* CO_FlashKV_find(uint16_t key, uint16_t *length);
+
+/**
+ * Copy the stored value of a key.
+ *
+ * @param key Key, smaller than CO_FLASHKV_KEYS.
+ * @param data Destination.
+ * @param length Expected length of the value.
+ *
+ * @return CO_ERROR_NO, CO_ERROR_PARAMETERS (key not stored) or
+ * CO_ERROR_DATA_CORRUPT (stored value has different length).
+ */
+CO_ReturnError_t CO_FlashKV_read(uint16_t key, void *data, uint16_t length);
+
+/**
+ * Store a value. Nothing is written, if the value is unchanged. Function
+ * blocks while flash is programmed (and a page is erased, if the active page
+ * is full), so it must not be called while the motor runs.
+ *
+ * @param key Key, smaller than CO_FLASHKV_KEYS.
+ * @param data Value.
+ * @param length Length of the value, 0 removes the key.
+ *
+ * @return CO_ERROR_NO, CO_ERROR_ILLEGAL_ARGUMENT, CO_ERROR_OUT_OF_MEMORY
+ * (values of all keys do not fit into one page) or CO_ERROR_DATA_CORRUPT
+ * (programming or verification failed).
+ */
+CO_ReturnError_t CO_FlashKV_write(uint16_t key, const void *data, uint16_t length);
+
+#endif
@@ -0,0 +1,542 @@
+/*
+ * STM32F3 program download for CANopen stack
+ *
+ * @file        CO_FwUpdate.c
+ * @author      Janez Paternoster
+ * @copyright   2014 Janez Paternoster
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+//============================================================================
+//                                INCLUDES
+//============================================================================
+#include "CO_FwUpdate.h"
+#include "crc16-ccitt.h"
+#include "stm32f3xx.h"
+
+//============================================================================
+//                                DEFINES
+//============================================================================
+#define CO_FW_RECORD_MAGIC          0x50555746U    /* "FWUP" */
+#define CO_FW_RESET_DELAY_MS        50U             /* SDO response must be sent before reset */
+#define CO_FW_PROGRAM_TIMEOUT_MS    200U
+
+/* Swap runs from RAM, while application flash is erased. The program step
+   runs from RAM, as the rest of the FOC interrupt. Startup code copies
+   .RamFunc with .data, see STM32F302R8Tx_FLASH.ld */
+#if defined (__ICCARM__)
+#define CO_FW_RAMFUNC               __ramfunc
+#else
+#define CO_FW_RAMFUNC               __attribute__((section (".RamFunc"), noinline))
+#endif
+
+//============================================================================
+//                                LOCAL DATA
+//============================================================================
+typedef struct
+{
+    uint32_t magic;
+    uint32_t length;
+    uint32_t crc;
+    uint32_t magicInv;
+} CO_FwRecord_t;
+
+typedef enum
+{
+    FW_STATE_UNKNOWN,       /* staging bank must be cleared */
+    FW_STATE_CLEARING,
+    FW_STATE_CLEARED,
+    FW_STATE_DOWNLOAD,
+    FW_STATE_VERIFIED       /* staged image passed read back CRC */
+} CO_FwState_t;
+
+static struct
+{
+    CO_FwState_t        state;
+    bool_t            (*pFunctIdle)(void);
+    uint32_t            clearAddress;
+    uint32_t            length;         /* bytes received */
+    uint32_t            address;        /* next halfword in staging bank */
+    uint16_t            crc;
+    uint8_t             oddByte;
+    bool_t              oddValid;
+    bool_t              resetPending;
+    uint16_t            resetTimer;
+    /* Program queue, filled from the SDO buffer by the 0x1F50 function and
+       emptied halfword by halfword by CO_FwUpdateProgramStep() */
+    uint16_t            queue[(CO_SDO_BUFFER_SIZE + 2) / 2];
+    volatile uint16_t   queueIdx;
+    volatile uint16_t   queueCount;
+    volatile uint32_t   queueAddress;
+    volatile bool_t     queueError;
+} CO_Fw;
+
+//============================================================================
+/**
+* Copy the staged image over the application and reset. Runs from RAM with
+* interrupts disabled and must not call any function located in flash.
+*/
+CO_FW_RAMFUNC static void CO_FwSwap(uint32_t length)
+{
+    const uint16_t* src = (const uint16_t*) CO_FW_STAGING_ADDRESS;
+    uint32_t addr;
+
+    if ((FLASH->CR & FLASH_CR_LOCK) != 0U) {
+        FLASH->KEYR = FLASH_KEY1;
+        FLASH->KEYR = FLASH_KEY2;
+    }
+
+    for (addr = CO_FW_APP_ADDRESS; addr < (CO_FW_APP_ADDRESS + length); addr += CO_FW_PAGE_SIZE) {
+        FLASH->CR |= FLASH_CR_PER;
+        FLASH->AR = addr;
+        FLASH->CR |= FLASH_CR_STRT;
+        while ((FLASH->SR & FLASH_SR_BSY) != 0U) {}
+        FLASH->CR &= ~FLASH_CR_PER;
+    }
+
+    FLASH->CR |= FLASH_CR_PG;
+    for (addr = CO_FW_APP_ADDRESS; addr < (CO_FW_APP_ADDRESS + length); addr += 2U) {
+        *(__IO uint16_t*)addr = *src++;
+        while ((FLASH->SR & FLASH_SR_BSY) != 0U) {}
+    }
+    FLASH->CR &= ~FLASH_CR_PG;
+
+    /* Swap is done, remove the record */
+    FLASH->CR |= FLASH_CR_PER;
+    FLASH->AR = CO_FW_RECORD_ADDRESS;
+    FLASH->CR |= FLASH_CR_STRT;
+    while ((FLASH->SR & FLASH_SR_BSY) != 0U) {}
+    FLASH->CR &= ~FLASH_CR_PER;
+
+    __DSB();
+    SCB->AIRCR = (0x5FAUL << SCB_AIRCR_VECTKEY_Pos) |
+                 (SCB->AIRCR & SCB_AIRCR_PRIGROUP_Msk) |
+                 SCB_AIRCR_SYSRESETREQ_Msk;
+    __DSB();
+    for (;;) {}
+}
+
+//============================================================================
+static bool_t CO_FwPageBlank(uint32_t pageAddress)
+{
+    const uint32_t* p = (const uint32_t*) pageAddress;
+    uint32_t i;
+
+    for (i = 0; i < (CO_FW_PAGE_SIZE / 4U); i++) {
+        if (p[i] != 0xFFFFFFFFU) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//============================================================================
+/**
+* Drop the program queue, lock flash and report status in 0x1F57.
+*/
+static CO_SDO_abortCode_t CO_FwFail(uint32_t status, CO_SDO_abortCode_t abortCode)
+{
+    __set_PRIMASK(1);
+    CO_Fw.queueIdx = CO_Fw.queueCount;
+    __set_PRIMASK(0);
+
+    while ((FLASH->SR & FLASH_SR_BSY) != 0U) {}
+    CLEAR_BIT(FLASH->CR, (FLASH_CR_PG | FLASH_CR_PER));
+    HAL_FLASH_Lock();
+
+    CO_Fw.state = FW_STATE_UNKNOWN;
+    OD_flashStatusIdentification[0] = status;
+
+    return abortCode;
+}
+
+//============================================================================
+/**
+* Wait until the program queue is written into flash. The FOC interrupt
+* empties the queue while the motor runs, otherwise it is done here.
+*/
+static bool_t CO_FwQueueFlush(void)
+{
+    uint32_t start = HAL_GetTick();
+
+    while ((CO_Fw.queueIdx != CO_Fw.queueCount) || ((FLASH->SR & FLASH_SR_BSY) != 0U)) {
+        if (CO_Fw.pFunctIdle()) {
+            __set_PRIMASK(1);
+            CO_FwUpdateProgramStep();
+            __set_PRIMASK(0);
+        }
+        if ((HAL_GetTick() - start) > CO_FW_PROGRAM_TIMEOUT_MS) {
+            return false;
+        }
+    }
+
+    if ((FLASH->SR & (FLASH_SR_PGERR | FLASH_SR_WRPERR)) != 0U) {
+        FLASH->SR = FLASH_SR_PGERR | FLASH_SR_WRPERR;
+        CO_Fw.queueError = true;
+    }
+
+    return !CO_Fw.queueError;
+}
+
+//============================================================================
+static bool_t CO_FwWriteRecord(void)
+{
+    uint32_t record[4];
+    uint32_t i;
+    bool_t ok = true;
+
+    record[0] = CO_FW_RECORD_MAGIC;
+    record[1] = CO_Fw.length;
+    record[2] = CO_Fw.crc;
+    record[3] = ~CO_FW_RECORD_MAGIC;
+
+    HAL_FLASH_Unlock();
+    for (i = 0; i < 4U; i++) {
+        if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, CO_FW_RECORD_ADDRESS + (i * 4U), record[i]) != HAL_OK) {
+            ok = false;
+            break;
+        }
+    }
+    HAL_FLASH_Lock();
+
+    return ok;
+}
+
+//============================================================================
+/**
+* Next page to clear: staging bank, then the swap record. Returns 0 after the
+* record page.
+*/
+static uint32_t CO_FwNextPage(uint32_t pageAddress)
+{
+    if (pageAddress == CO_FW_RECORD_ADDRESS) {
+        return 0U;
+    }
+    pageAddress += CO_FW_PAGE_SIZE;
+    return (pageAddress < (CO_FW_STAGING_ADDRESS + CO_FW_STAGING_SIZE)) ? pageAddress : CO_FW_RECORD_ADDRESS;
+}
+
+//============================================================================
+/**
+* Erase one page per call, blank pages are skipped. Each erase stalls the
+* CPU, so it is only called with the motor stopped.
+*/
+static void CO_FwClearStep(void)
+{
+    if ((FLASH->SR & FLASH_SR_BSY) != 0U) {
+        return;
+    }
+    CLEAR_BIT(FLASH->CR, FLASH_CR_PER);
+    if ((FLASH->SR & (FLASH_SR_PGERR | FLASH_SR_WRPERR)) != 0U) {
+        FLASH->SR = FLASH_SR_PGERR | FLASH_SR_WRPERR;
+        CO_FwFail(CO_FW_STATUS_WRITE_ERROR, CO_SDO_AB_HW);
+        return;
+    }
+
+    while ((CO_Fw.clearAddress != 0U) && CO_FwPageBlank(CO_Fw.clearAddress)) {
+        CO_Fw.clearAddress = CO_FwNextPage(CO_Fw.clearAddress);
+    }
+    if (CO_Fw.clearAddress == 0U) {
+        HAL_FLASH_Lock();
+        CO_Fw.state = FW_STATE_CLEARED;
+        OD_flashStatusIdentification[0] = CO_FW_STATUS_OK;
+        return;
+    }
+
+    SET_BIT(FLASH->CR, FLASH_CR_PER);
+    FLASH->AR = CO_Fw.clearAddress;
+    SET_BIT(FLASH->CR, FLASH_CR_STRT);
+    CO_Fw.clearAddress = CO_FwNextPage(CO_Fw.clearAddress);
+}
+
+//============================================================================
+/**
+* Access to object dictionary OD_H1F50_PROGRAM_DATA
+* Data arrive in chunks of the SDO buffer size. Each chunk is added to the
+* image CRC and queued for programming, while the SDO server already receives
+* the next block.
+*/
+static CO_SDO_abortCode_t CO_ODF_1F50_ProgramData(CO_ODF_arg_t *ODF_arg)
+{
+    const uint32_t* image = (const uint32_t*) CO_FW_STAGING_ADDRESS;
+    const uint8_t* data = ODF_arg->data;
+    uint16_t len = ODF_arg->dataLength;
+    uint16_t count = 0;
+
+    if (ODF_arg->reading || (ODF_arg->subIndex != 1U)) {
+        return CO_SDO_AB_NONE;
+    }
+
+    if (ODF_arg->firstSegment) {
+        if (CO_Fw.state != FW_STATE_CLEARED) {
+            OD_flashStatusIdentification[0] = CO_FW_STATUS_NOT_CLEARED;
+            return CO_SDO_AB_DATA_DEV_STATE;
+        }
+        if (ODF_arg->dataLengthTotal > CO_FW_STAGING_SIZE) {
+            return CO_SDO_AB_OUT_OF_MEM;
+        }
+        CO_Fw.length = 0;
+        CO_Fw.address = CO_FW_STAGING_ADDRESS;
+        CO_Fw.crc = 0;
+        CO_Fw.oddValid = false;
+        CO_Fw.queueError = false;
+        HAL_FLASH_Unlock();
+        CO_Fw.state = FW_STATE_DOWNLOAD;
+        OD_flashStatusIdentification[0] = CO_FW_STATUS_IN_PROGRESS;
+    }
+    else if (CO_Fw.state != FW_STATE_DOWNLOAD) {
+        return CO_SDO_AB_DATA_DEV_STATE;
+    }
+
+    if ((CO_Fw.length + len) > CO_FW_STAGING_SIZE) {
+        return CO_FwFail(CO_FW_STATUS_ADDRESS_ERROR, CO_SDO_AB_OUT_OF_MEM);
+    }
+
+    /* previous chunk must be in flash, before the queue is refilled */
+    if (!CO_FwQueueFlush()) {
+        return CO_FwFail(CO_FW_STATUS_WRITE_ERROR, CO_SDO_AB_HW);
+    }
+
+    CO_Fw.crc = crc16_ccitt(data, len, CO_Fw.crc);
+    CO_Fw.length += len;
+
+    if (CO_Fw.oddValid && (len > 0U)) {
+        CO_Fw.queue[count++] = (uint16_t)CO_Fw.oddByte | ((uint16_t)data[0] << 8);
+        CO_Fw.oddValid = false;
+        data++;
+        len--;
+    }
+    while (len >= 2U) {
+        CO_Fw.queue[count++] = (uint16_t)data[0] | ((uint16_t)data[1] << 8);
+        data += 2;
+        len -= 2U;
+    }
+    if (len > 0U) {
+        CO_Fw.oddByte = data[0];
+        CO_Fw.oddValid = true;
+    }
+    if (ODF_arg->lastSegment && CO_Fw.oddValid) {
+        CO_Fw.queue[count++] = (uint16_t)CO_Fw.oddByte | 0xFF00U;
+        CO_Fw.oddValid = false;
+    }
+
+    __set_PRIMASK(1);
+    CO_Fw.queueAddress = CO_Fw.address;
+    CO_Fw.queueIdx = 0;
+    CO_Fw.queueCount = count;
+    __set_PRIMASK(0);
+    CO_Fw.address += (uint32_t)count * 2U;
+
+    if (!ODF_arg->lastSegment) {
+        return CO_SDO_AB_NONE;
+    }
+
+    /* last segment: write remaining data and verify the image */
+    if (!CO_FwQueueFlush()) {
+        return CO_FwFail(CO_FW_STATUS_WRITE_ERROR, CO_SDO_AB_HW);
+    }
+    CLEAR_BIT(FLASH->CR, FLASH_CR_PG);
+    HAL_FLASH_Lock();
+
+    /* initial stack pointer in SRAM, reset handler in application area */
+    if ((CO_Fw.length < 8U) || ((image[0] & 0xFFFF0000U) != 0x20000000U) ||
+        ((image[1] & ~1U) < CO_FW_APP_ADDRESS) || ((image[1] & ~1U) >= CO_FW_STAGING_ADDRESS)) {
+        return CO_FwFail(CO_FW_STATUS_FORMAT_ERROR, CO_SDO_AB_DATA_TRANSF);
+    }
+
+    if (crc16_ccitt((const unsigned char*)CO_FW_STAGING_ADDRESS, CO_Fw.length, 0) != CO_Fw.crc) {
+        return CO_FwFail(CO_FW_STATUS_CRC_ERROR, CO_SDO_AB_DATA_TRANSF);
+    }
+
+    CO_Fw.state = FW_STATE_VERIFIED;
+    OD_programSoftwareIdentification[0] = CO_Fw.crc;
+    OD_flashStatusIdentification[0] = CO_FW_STATUS_OK;
+
+    return CO_SDO_AB_NONE;
+}
+
+//============================================================================
+/**
+* Access to object dictionary OD_H1F51_PROGRAM_CONTROL
+*/
+static CO_SDO_abortCode_t CO_ODF_1F51_ProgramControl(CO_ODF_arg_t *ODF_arg)
+{
+    uint8_t* value = (uint8_t*)ODF_arg->data;
+
+    if (ODF_arg->reading || (ODF_arg->subIndex != 1U)) {
+        return CO_SDO_AB_NONE;
+    }
+
+    switch (*value) {
+    case CO_FW_CTRL_STOP:
+        /* application keeps running, download goes to the staging bank */
+        break;
+
+    case CO_FW_CTRL_START:
+        if (CO_Fw.state != FW_STATE_VERIFIED) {
+            OD_flashStatusIdentification[0] = CO_FW_STATUS_NO_PROGRAM;
+            return CO_SDO_AB_DATA_DEV_STATE;
+        }
+        if (!CO_Fw.pFunctIdle() || CO_Fw.resetPending) {
+            return CO_SDO_AB_DATA_DEV_STATE;
+        }
+        if (!CO_FwWriteRecord()) {
+            return CO_FwFail(CO_FW_STATUS_WRITE_ERROR, CO_SDO_AB_HW);
+        }
+        CO_Fw.resetPending = true;
+        CO_Fw.resetTimer = 0;
+        break;
+
+    case CO_FW_CTRL_RESET:
+        if (!CO_Fw.pFunctIdle()) {
+            return CO_SDO_AB_DATA_DEV_STATE;
+        }
+        CO_Fw.resetPending = true;
+        CO_Fw.resetTimer = 0;
+        break;
+
+    case CO_FW_CTRL_CLEAR:
+        if (!CO_Fw.pFunctIdle() || CO_Fw.resetPending) {
+            return CO_SDO_AB_DATA_DEV_STATE;
+        }
+        if (CO_Fw.state != FW_STATE_CLEARING) {
+            /* drop an unfinished download */
+            CO_FwFail(CO_FW_STATUS_IN_PROGRESS, CO_SDO_AB_NONE);
+            HAL_FLASH_Unlock();
+            CO_Fw.clearAddress = CO_FW_STAGING_ADDRESS;
+            CO_Fw.state = FW_STATE_CLEARING;
+        }
+        break;
+
+    default:
+        return CO_SDO_AB_INVALID_VALUE;
+    }
+
+    /* 0x1F51 reads the state of the running program */
+    *value = CO_FW_CTRL_START;
+
+    return CO_SDO_AB_NONE;
+}
+
+//===========================================================================
+void CO_FwUpdateBoot(void)
+{
+    const CO_FwRecord_t* record = (const CO_FwRecord_t*) CO_FW_RECORD_ADDRESS;
+
+    if ((record->magic != CO_FW_RECORD_MAGIC) || (record->magicInv != ~CO_FW_RECORD_MAGIC) ||
+        (record->length == 0U) || (record->length > CO_FW_STAGING_SIZE)) {
+        return;
+    }
+
+    if (crc16_ccitt((const unsigned char*)CO_FW_STAGING_ADDRESS, record->length, 0) != (uint16_t)record->crc) {
+        return;
+    }
+
+    __disable_irq();
+    CO_FwSwap((record->length + 1U) & ~1U);
+}
+
+//===========================================================================
+void CO_FwUpdateRegisterODFunctions(CO_t* CO, bool_t (*pFunctIdle)(void))
+{
+    CO_Fw.pFunctIdle = pFunctIdle;
+
+    CO_OD_configure(CO->SDO[0], OD_H1F50_PROGRAM_DATA,
+    CO_ODF_1F50_ProgramData, (void*)0, 0, 0);
+
+    CO_OD_configure(CO->SDO[0], OD_H1F51_PROGRAM_CONTROL,
+    CO_ODF_1F51_ProgramControl, (void*)0, 0, 0);
+}
+
+//===========================================================================
+CO_FW_RAMFUNC void CO_FwUpdateProgramStep(void)
+{
+    uint32_t sr;
+
+    if (CO_Fw.queueIdx == CO_Fw.queueCount) {
+        return;
+    }
+
+    sr = FLASH->SR;
+    if ((sr & FLASH_SR_BSY) != 0U) {
+        return;
+    }
+    if ((sr & (FLASH_SR_PGERR | FLASH_SR_WRPERR)) != 0U) {
+        FLASH->SR = FLASH_SR_PGERR | FLASH_SR_WRPERR;
+        CO_Fw.queueError = true;
+        CO_Fw.queueIdx = CO_Fw.queueCount;
+        return;
+    }
+
+    SET_BIT(FLASH->CR, FLASH_CR_PG);
+    *(__IO uint16_t*)CO_Fw.queueAddress = CO_Fw.queue[CO_Fw.queueIdx];
+    CO_Fw.queueAddress += 2U;
+    CO_Fw.queueIdx++;
+}
+
+//===========================================================================
+bool_t CO_FwUpdateProcess(uint16_t timeDifference_ms)
+{
+    bool_t pending = false;
+
+    if (CO_Fw.pFunctIdle == NULL) {
+        return false;
+    }
+
+    if (CO_Fw.pFunctIdle()) {
+        if (CO_Fw.state == FW_STATE_CLEARING) {
+            CO_FwClearStep();
+            pending = true;
+        }
+        else if (CO_Fw.queueIdx != CO_Fw.queueCount) {
+            __set_PRIMASK(1);
+            CO_FwUpdateProgramStep();
+            __set_PRIMASK(0);
+            pending = true;
+        }
+    }
+
+    if (CO_Fw.resetPending) {
+        CO_Fw.resetTimer += timeDifference_ms;
+        if (CO_Fw.resetTimer >= CO_FW_RESET_DELAY_MS) {
+            NVIC_SystemReset();
+        }
+    }
+
+    return pending;
+}
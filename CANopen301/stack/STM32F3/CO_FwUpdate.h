@@ -0,0 +1,155 @@
+/*
+ * STM32F3 program download for CANopen stack
+ *
+ * @file        CO_FwUpdate.h
+ * @author      Janez Paternoster
+ * @copyright   2014 Janez Paternoster
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Following clarification and special exception to the GNU General Public
+ * License is included to the distribution terms of CANopenNode:
+ *
+ * Linking this library statically or dynamically with other modules is
+ * making a combined work based on this library. Thus, the terms and
+ * conditions of the GNU General Public License cover the whole combination.
+ *
+ * As a special exception, the copyright holders of this library give
+ * you permission to link this library with independent modules to
+ * produce an executable, regardless of the license terms of these
+ * independent modules, and to copy and distribute the resulting
+ * executable under terms of your choice, provided that you also meet,
+ * for each linked independent module, the terms and conditions of the
+ * license of that module. An independent module is a module which is
+ * not derived from or based on this library. If you modify this
+ * library, you may extend this exception to your version of the
+ * library, but you are not obliged to do so. If you do not wish
+ * to do so, delete this exception statement from your version.
+ */
+
+#ifndef CO_FWUPDATE_H
+#define CO_FWUPDATE_H
+
+//============================================================================
+//                                INCLUDES
+//============================================================================
+#include "CANopen.h"
+
+//============================================================================
+//                                DEFINES
+//============================================================================
+/*
+ * Flash layout of the 64 KB STM32F302R8 (2 KB pages):
+ *
+ *   0x08000000 - 0x080077FF  application (linker must keep it below staging)
+ *   0x08007800 - 0x0800E7FF  staging bank for the downloaded image
+ *   0x0800E800 - 0x0800F7FF  CO_Flash.c parameter pages
+ *   0x0800F800 - 0x0800FFFF  swap record
+ *
+ * On devices with more flash override the defines from the compiler command
+ * line.
+ */
+#ifndef CO_FW_PAGE_SIZE
+#define CO_FW_PAGE_SIZE             0x800U
+#endif
+#ifndef CO_FW_APP_ADDRESS
+#define CO_FW_APP_ADDRESS           0x08000000U
+#endif
+#ifndef CO_FW_STAGING_ADDRESS
+#define CO_FW_STAGING_ADDRESS       0x08007800U
+#endif
+#ifndef CO_FW_STAGING_SIZE
+#define CO_FW_STAGING_SIZE          0x7000U
+#endif
+#ifndef CO_FW_RECORD_ADDRESS
+#define CO_FW_RECORD_ADDRESS        0x0800F800U
+#endif
+
+/* Object 0x1F51, program control */
+#define CO_FW_CTRL_STOP             0U
+#define CO_FW_CTRL_START            1U
+#define CO_FW_CTRL_RESET            2U
+#define CO_FW_CTRL_CLEAR            3U
+
+/* Object 0x1F57, flash status identification (CiA 302-3): bit 0 is set while
+   an operation is in progress, bits 1..7 hold the error code */
+#define CO_FW_STATUS_IN_PROGRESS    0x01U
+#define CO_FW_STATUS_OK             (0U << 1)
+#define CO_FW_STATUS_NO_PROGRAM     (1U << 1)
+#define CO_FW_STATUS_FORMAT_ERROR   (2U << 1)
+#define CO_FW_STATUS_CRC_ERROR      (3U << 1)
+#define CO_FW_STATUS_NOT_CLEARED    (4U << 1)
+#define CO_FW_STATUS_WRITE_ERROR    (5U << 1)
+#define CO_FW_STATUS_ADDRESS_ERROR  (6U << 1)
+
+/**
+ * Swap the application with the staged image, if a verified image is waiting.
+ * Must be called at startup, before interrupts are used. The copy runs from
+ * RAM (section ".RamFunc", copied with .data by the startup code) and ends
+ * with a system reset.
+ *
+ * The STM32F302R8 has a single flash bank and the code, which resumes the
+ * swap, is itself in the application area, so the swap is not power-fail
+ * safe. From the erase of the first application page to the programming of
+ * the last halfword (up to 1.4 s for a full staging bank with the maximum
+ * erase and program times of the datasheet) a power loss leaves the
+ * application area broken: the device does not start and must be recovered
+ * with a debugger or the system memory bootloader (BOOT0 pin). Power loss
+ * at any other time keeps the old application or, during the erase of the
+ * swap record, completes the swap at the next start. See flashtest/CO_fwTest.c.
+ */
+void CO_FwUpdateBoot(void);
+
+/**
+ * Register object dictionary functions for program download (Object
+ * dictionary index 0x1F50 Program data and 0x1F51 Program control).
+ *
+ * Image is downloaded into the staging bank, preferably with SDO block
+ * transfer. The sequence from the master is: write 3 (clear) to 0x1F51,1 and
+ * wait until 0x1F57,1 reads 0, download the image to 0x1F50,1, write 1
+ * (start) to 0x1F51,1. The drive keeps running during the download, clear,
+ * start and reset are only accepted while pFunctIdle() returns true.
+ *
+ * @param CO CANopen object.
+ * @param pFunctIdle Returns true, if motor is stopped (PWM off).
+ */
+void CO_FwUpdateRegisterODFunctions(CO_t* CO, bool_t (*pFunctIdle)(void));
+
+/**
+ * Program one halfword of the downloaded data into the staging bank.
+ * Function does not wait for the flash. It is called from the FOC interrupt
+ * after the current controller, so the flash is busy only between two FOC
+ * cycles (halfword programming is shorter than the FOC period). It runs from
+ * RAM (section ".RamFunc") like the rest of the FOC interrupt.
+ */
+void CO_FwUpdateProgramStep(void);
+
+/**
+ * Process program download. Erases the staging bank page by page, programs
+ * the downloaded data if the FOC interrupt is not running and resets the
+ * device after start or reset command. Must be called cyclically from the
+ * main loop.
+ *
+ * @param timeDifference_ms Time difference from previous function call.
+ *
+ * @return True, if erase or programming is not finished and the function
+ * should be called again without waiting for the next timer tick.
+ */
+bool_t CO_FwUpdateProcess(uint16_t timeDifference_ms);
+
+#endif
@@ -61,6 +61,8 @@
 //static void CO_CANconfigGPIO (void);
 
 static uint8_t CO_CANsendToModule(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer);
+static void CO_CANtxSchedule(CO_CANmodule_t *CANmodule);
+static void CO_CANrxFiltersUpdate(CO_CANmodule_t *CANmodule);
 #define		CAN_TxStatus_NoMailBox		0x05
 /*******************************************************************************
    Macro and Constants - CAN module registers
@@ -74,6 +76,8 @@ void CO_CANsetConfigurationMode(CAN_TypeDef* CANbaseAddress){
 
 /******************************************************************************/
 void CO_CANsetNormalMode(CO_CANmodule_t *CANmodule){
+    /* All receive buffers are registered now, program filters only once */
+    CO_CANrxFiltersUpdate(CANmodule);
     CANmodule->CANnormal = true;
 }
 
@@ -110,22 +114,35 @@ CO_ReturnError_t CO_CANmodule_init(
     CANmodule->txSize = txSize;
     CANmodule->CANnormal = false;
     CANmodule->useCANrxFilters = false;
-    CANmodule->bufferInhibitFlag = 0;
     CANmodule->firstCANtxMessage = 1;
     CANmodule->CANtxCount = 0;
+    for (i = 0; i < CO_CAN_NO_TX_MAILBOXES; i++) {
+        CANmodule->txMailbox[i] = NULL;
+    }
+    CANmodule->txRequeueFlags = 0;
     CANmodule->errOld = 0;
     CANmodule->em = 0;
+    memset(CANmodule->rxFilterMap, CO_CAN_FILTER_NO_MATCH, sizeof(CANmodule->rxFilterMap));
 	
    // CAN_ITConfig(CANmodule->CANbaseAddress, (CAN_IT_TME | CAN_IT_FMP0), DISABLE);
 
+    /* Unused buffer matches no message in the software search, also when
+     * CO_init() stops before other objects, see nodeIdUnconfigured. */
     for (i = 0; i < rxSize; i++) {
-        CANmodule->rxArray[i].ident = 0;
+        CANmodule->rxArray[i].ident = 0xFFFF;
+        CANmodule->rxArray[i].mask = 0xFFFF;
         CANmodule->rxArray[i].pFunct = 0;
     }
     
     for (i = 0; i < txSize; i++) {
         CANmodule->txArray[i].bufferFull = 0;
+        CANmodule->txArray[i].queueDelay = 0;
+        CANmodule->txArray[i].queueDelayMax = 0;
     }
+
+    /* cycle counter for CO_CAN_TX_TIMESTAMP() */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
   
 /*
   pCan->Instance = CAN;
@@ -256,6 +273,13 @@ CO_ReturnError_t CO_CANrxBufferInit(
     if (RXF != rxBuffer->ident || RXM != rxBuffer->mask) {
         rxBuffer->ident = RXF;
         rxBuffer->mask = RXM;
+
+        /* Filters are compiled by CO_CANsetNormalMode(), after CO_init()
+         * registered all buffers. Later changes (PDO or SYNC COB-ID written
+         * by SDO) recompile them, reception stops only for that moment. */
+        if (CANmodule->CANnormal) {
+            CO_CANrxFiltersUpdate(CANmodule);
+        }
     }
 
     return CO_ERROR_NO;
@@ -297,7 +321,6 @@ CO_CANtx_t *CO_CANtxBufferInit(
 CO_ReturnError_t CO_CANsend(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer)
 {
     CO_ReturnError_t err = CO_ERROR_NO;
-    uint8_t txBuff;
 
     /* Verify overflow */
     if (buffer->bufferFull) {
@@ -307,46 +330,44 @@ CO_ReturnError_t CO_CANsend(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer)
     }
 
     CO_LOCK_CAN_SEND();
-    
-    /* First try to transmit the message immediately if mailbox is free.
-     * Only one TX mailbox is used of the three available in the hardware */
-    CANmodule->bufferInhibitFlag = buffer->syncFlag;
-    txBuff = CO_CANsendToModule(CANmodule, buffer);
 
-    /* No free mailbox -> use interrupt for transmission */
-    if (txBuff == CAN_TxStatus_NoMailBox) {
+    /* Queue the message, overwritten message keeps its place in queue. Then
+     * transmit pending messages in priority order, if mailboxes are free. */
+    if (!buffer->bufferFull) {
+        buffer->queueTime = CO_CAN_TX_TIMESTAMP();
         buffer->bufferFull = 1;
         CANmodule->CANtxCount++;
     }
+    CO_CANtxSchedule(CANmodule);
+
     CO_UNLOCK_CAN_SEND();
 
     return err;
 }
 
 /******************************************************************************/
-#define	CAN_TxStatus_Pending	1U
 void CO_CANclearPendingSyncPDOs(CO_CANmodule_t *CANmodule)
 {
+    CAN_TypeDef *CANx = CANmodule->CANbaseAddress->Instance;
     uint32_t tpdoDeleted = 0U;
-			//uint8_t state = 0;
-		uint32_t	state;
-	
+    uint8_t i;
+
     CO_LOCK_CAN_SEND();
     /* Abort message from CAN module, if there is synchronous TPDO. */
-    //state = CAN_TransmitStatus(CANmodule->CANbaseAddress, CO_CAN_TXMAILBOX0);
-		state	=	HAL_CAN_IsTxMessagePending(CANmodule->CANbaseAddress, CO_CAN_TXMAILBOX0);
-    if((state == CAN_TxStatus_Pending) && (CANmodule->bufferInhibitFlag)) {
-        //CAN_CancelTransmit(CANmodule->CANbaseAddress, CO_CAN_TXMAILBOX0);
-				HAL_CAN_AbortTxRequest(CANmodule->CANbaseAddress, CO_CAN_TXMAILBOX0);
-        CANmodule->bufferInhibitFlag = false;
-        tpdoDeleted = 1U;
+    for(i = 0U; i < CO_CAN_NO_TX_MAILBOXES; i++){
+        CO_CANtx_t *buffer = CANmodule->txMailbox[i];
+        if((buffer != NULL) && buffer->syncFlag && ((CANx->TSR & (CAN_TSR_TME0 << i)) == 0U)) {
+            CANmodule->txRequeueFlags &= ~(1U << i);
+            CANx->TSR = CAN_TSR_ABRQ0 << (8U * i);
+            tpdoDeleted = 1U;
+        }
     }
     
     /* delete also pending synchronous TPDOs in TX buffers */
     if(CANmodule->CANtxCount != 0U){
-        uint16_t i;
+        uint16_t j;
         CO_CANtx_t *buffer = &CANmodule->txArray[0];
-        for(i = CANmodule->txSize; i > 0U; i--){
+        for(j = CANmodule->txSize; j > 0U; j--){
             if(buffer->bufferFull){
                 if(buffer->syncFlag){
                     buffer->bufferFull = false;
@@ -415,30 +436,47 @@ void CO_CANverifyErrors(CO_CANmodule_t *CANmodule)
 
 /******************************************************************************/
 /* Interrupt from receiver */
-void CO_CANinterrupt_Rx(CO_CANmodule_t *CANmodule)
+void CO_CANinterrupt_Rx(CO_CANmodule_t *CANmodule, uint32_t RxFifo)
 {
 
     uint16_t index;
+    uint16_t msg;
     uint8_t msgMatched = 0;
     CO_CANrx_t *msgBuff = CANmodule->rxArray;
 		CanRxMsg CAN_RxMsg;
 		CAN_RxHeaderTypeDef	HAL_CanRxMsg;
 		//CAN_Receive(CANmodule->CANbaseAddress, CAN_FILTER_FIFO0, &CAN_RxMsg);
-    HAL_CAN_GetRxMessage(CANmodule->CANbaseAddress, CAN_FILTER_FIFO0, &HAL_CanRxMsg, CAN_RxMsg.Data);
+    HAL_CAN_GetRxMessage(CANmodule->CANbaseAddress, RxFifo, &HAL_CanRxMsg, CAN_RxMsg.Data);
 		CAN_RxMsg.StdId	=	HAL_CanRxMsg.StdId;
 		CAN_RxMsg.ExtId	=	HAL_CanRxMsg.ExtId;
 		CAN_RxMsg.RTR	=	HAL_CanRxMsg.RTR;
 		CAN_RxMsg.DLC	=	HAL_CanRxMsg.DLC;	
 		CAN_RxMsg.FMI	=	(uint8_t)HAL_CanRxMsg.FilterMatchIndex;
-	
-    for (index = 0; index < CANmodule->rxSize; index++) {
-        uint16_t msg = (CAN_RxMsg.StdId << 2) | (CAN_RxMsg.RTR ? 2 : 0);
 
-        if (((msg ^ msgBuff->ident) & msgBuff->mask) == 0) {
-            msgMatched = 1;
-            break;
+    msg = (CAN_RxMsg.StdId << 2) | (CAN_RxMsg.RTR ? 2 : 0);
+
+    /* Filter match index points directly to the receive buffer. Verify the
+     * match, filters may be just being rebuilt. */
+    if (CAN_RxMsg.FMI < CO_CAN_NO_FILTERS_PER_FIFO) {
+        index = CANmodule->rxFilterMap[RxFifo][CAN_RxMsg.FMI];
+        if (index < CANmodule->rxSize) {
+            msgBuff = &CANmodule->rxArray[index];
+            if (((msg ^ msgBuff->ident) & msgBuff->mask) == 0) {
+                msgMatched = 1;
+            }
+        }
+    }
+
+    /* Message passed catch-all filter, search for the buffer in software */
+    if (!msgMatched) {
+        msgBuff = CANmodule->rxArray;
+        for (index = 0; index < CANmodule->rxSize; index++) {
+            if (((msg ^ msgBuff->ident) & msgBuff->mask) == 0) {
+                msgMatched = 1;
+                break;
+            }
+            msgBuff++;
         }
-        msgBuff++;
     }
     
     /* Call specific function, which will process the message */
@@ -449,46 +487,131 @@ void CO_CANinterrupt_Rx(CO_CANmodule_t *CANmodule)
 
 /******************************************************************************/
 /* Interrupt from trasmitter */
-void CO_CANinterrupt_Tx(CO_CANmodule_t *CANmodule)
+void CO_CANinterrupt_Tx(CO_CANmodule_t *CANmodule, uint8_t mailbox)
 {
     /* First CAN message (bootup) was sent successfully */
     CANmodule->firstCANtxMessage = 0;
-    
-    /* clear flag from previous message */
-    CANmodule->bufferInhibitFlag = 0;
-    
+
+    /* Release the mailbox. HAL clears the status of all completed mailboxes
+     * before it calls the callbacks, so only this one is known to be sent.
+     * Abort requested too late: message was sent, it is not requeued. */
+    CANmodule->txMailbox[mailbox] = NULL;
+    CANmodule->txRequeueFlags &= ~(1U << mailbox);
+
     /* Are there any new messages waiting to be send */
-    if (CANmodule->CANtxCount > 0) {
-        uint16_t i;             /* index of transmitting message */
-
-        /* first buffer */
-        CO_CANtx_t *buffer = CANmodule->txArray;
-        /* search through whole array of pointers to transmit message buffers. */
-        for(i = CANmodule->txSize; i > 0; i--) {
-            /* if message buffer is full, send it. */
-            if(buffer->bufferFull) {
-                buffer->bufferFull = 0;
-                CANmodule->CANtxCount--;
-                
-                /* Copy message to CAN buffer */
-                CANmodule->bufferInhibitFlag = buffer->syncFlag;
-                CO_CANsendToModule(CANmodule, buffer);
-                break;                      /* exit for loop */
-            }
-            buffer++;
-        }/* end of for loop */
+    CO_CANtxSchedule(CANmodule);
+}
 
-        /* Clear counter if no more messages */
-        if(i == 0) CANmodule->CANtxCount = 0;
+/******************************************************************************/
+void CO_CANinterrupt_TxAbort(CO_CANmodule_t *CANmodule, uint8_t mailbox)
+{
+    CO_CANtx_t *buffer = CANmodule->txMailbox[mailbox];
+
+    /* message was preempted by critical one, put it back to queue */
+    if ((CANmodule->txRequeueFlags & (1U << mailbox)) != 0) {
+        CANmodule->txRequeueFlags &= ~(1U << mailbox);
+        if (buffer != NULL && !buffer->bufferFull) {
+            buffer->bufferFull = 1;
+            CANmodule->CANtxCount++;
+        }
+    }
+    CANmodule->txMailbox[mailbox] = NULL;
+
+    CO_CANtxSchedule(CANmodule);
+}
+
+/******************************************************************************/
+/* Critical messages may preempt others from tx mailboxes */
+static bool_t CO_CANtxIsCritical(const CO_CANtx_t *buffer)
+{
+    return (buffer->syncFlag || buffer->ident < ((uint32_t)CO_CAN_TX_CRITICAL_IDENT << 21)) ? true : false;
+}
+
+/* Preempted message is requeued from its buffer. Buffer must not hold a newer
+ * message already and no other mailbox may hold the message before it (SDO
+ * segments), otherwise message would be lost or sent out of order. */
+static bool_t CO_CANtxIsRequeueable(const CO_CANmodule_t *CANmodule, const CO_CANtx_t *buffer)
+{
+    uint8_t n = 0;
+    uint8_t i;
+
+    if (buffer->bufferFull) return false;
+
+    for (i = 0; i < CO_CAN_NO_TX_MAILBOXES; i++) {
+        if (CANmodule->txMailbox[i] == buffer) n++;
     }
+    return (n == 1) ? true : false;
 }
 
+/* Abort lowest priority non-critical mailbox with lower priority than buffer */
+static void CO_CANtxPreempt(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer)
+{
+    CAN_TypeDef *CANx = CANmodule->CANbaseAddress->Instance;
+    uint8_t victim = CO_CAN_NO_TX_MAILBOXES;
+    uint32_t victimIdent = buffer->ident;
+    uint8_t i;
+
+    if (!CO_CANtxIsCritical(buffer)) return;
+
+    for (i = 0; i < CO_CAN_NO_TX_MAILBOXES; i++) {
+        CO_CANtx_t *mbBuffer = CANmodule->txMailbox[i];
+
+        /* abort already requested, critical message will get this mailbox */
+        if ((CANmodule->txRequeueFlags & (1U << i)) != 0) return;
+
+        if (mbBuffer != NULL && (CANx->TSR & (CAN_TSR_TME0 << i)) == 0
+            && !CO_CANtxIsCritical(mbBuffer) && mbBuffer->ident > victimIdent
+            && CO_CANtxIsRequeueable(CANmodule, mbBuffer))
+        {
+            victim = i;
+            victimIdent = mbBuffer->ident;
+        }
+    }
+
+    if (victim < CO_CAN_NO_TX_MAILBOXES) {
+        CANmodule->txRequeueFlags |= (1U << victim);
+        /* write only abort bit, other bits in TSR are cleared by writing 1 */
+        CANx->TSR = CAN_TSR_ABRQ0 << (8 * victim);
+    }
+}
+
+/* Load free mailboxes with pending messages, highest priority first */
+static void CO_CANtxSchedule(CO_CANmodule_t *CANmodule)
+{
+    while (CANmodule->CANtxCount > 0) {
+        CO_CANtx_t *buffer = NULL;
+        CO_CANtx_t *candidate = CANmodule->txArray;
+        uint16_t i;
+
+        /* lower identifier has higher priority on the bus */
+        for (i = CANmodule->txSize; i > 0; i--) {
+            if (candidate->bufferFull && (buffer == NULL || candidate->ident < buffer->ident)) {
+                buffer = candidate;
+            }
+            candidate++;
+        }
 
+        /* Clear counter if no more messages */
+        if (buffer == NULL) {
+            CANmodule->CANtxCount = 0;
+            break;
+        }
+
+        if (CO_CANsendToModule(CANmodule, buffer) == CAN_TxStatus_NoMailBox) {
+            CO_CANtxPreempt(CANmodule, buffer);
+            break;
+        }
+        buffer->bufferFull = 0;
+        CANmodule->CANtxCount--;
+    }
+}
 
 /******************************************************************************/
 static uint8_t CO_CANsendToModule(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer)
 {
     CAN_TxMailBox_TypeDef* txMbox;
+    uint32_t delay;
+    uint8_t mailbox;
 	
 //		CAN_TxHeaderTypeDef	TxMsg;
 //		uint32_t				TxFIFONum;
@@ -496,22 +619,27 @@ static uint8_t CO_CANsendToModule(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer)
 	
     /* Checks if the transmit mailbox is available */
 	//lib code has error,author by repair 2019-8-10
-	  if ((CANmodule->CANbaseAddress->Instance->TSR & CAN_TSR_TME0) == CAN_TSR_TME0) {
-        txMbox = &CANmodule->CANbaseAddress->Instance->sTxMailBox[CO_CAN_TXMAILBOX0];
+    /* Mailbox aborted for requeue is reserved, until abort interrupt is processed */
+    for (mailbox = 0; mailbox < CO_CAN_NO_TX_MAILBOXES; mailbox++) {
+        if ((CANmodule->CANbaseAddress->Instance->TSR & (CAN_TSR_TME0 << mailbox)) != 0
+            && (CANmodule->txRequeueFlags & (1U << mailbox)) == 0)
+        {
+            break;
+        }
     }
-    else 
-		if((CANmodule->CANbaseAddress->Instance->TSR & CAN_TSR_TME1) == CAN_TSR_TME1)	{
-			txMbox = &CANmodule->CANbaseAddress->Instance->sTxMailBox[CO_CAN_TXMAILBOX1];
-		}
-    else 
-		if((CANmodule->CANbaseAddress->Instance->TSR & CAN_TSR_TME2) == CAN_TSR_TME2)	{
-			txMbox = &CANmodule->CANbaseAddress->Instance->sTxMailBox[CO_CAN_TXMAILBOX2];
-		}		
-		else
-			{
+    if (mailbox == CO_CAN_NO_TX_MAILBOXES) {
         return CAN_TxStatus_NoMailBox;
-			//return	CAN_IT_TX_MAILBOX_EMPTY;
     }
+    txMbox = &CANmodule->CANbaseAddress->Instance->sTxMailBox[mailbox];
+    CANmodule->txMailbox[mailbox] = buffer;
+
+    /* queuing delay, requeued message keeps its original timestamp */
+    delay = CO_CAN_TX_TIMESTAMP() - buffer->queueTime;
+    buffer->queueDelay = delay;
+    if (delay > buffer->queueDelayMax) {
+        buffer->queueDelayMax = delay;
+    }
+
     /* ID: always assuming standard 11-bit ID */
     txMbox->TIR &= 1;
     txMbox->TIR |= ((buffer->ident) | CAN_RTR_DATA);
@@ -535,7 +663,163 @@ static uint8_t CO_CANsendToModule(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer)
     /* Request transmission */
     txMbox->TIR |= 1;
     
-    return 0;
+    return mailbox;
+}
+
+/******************************************************************************/
+/* Receive buffer is used and not hidden by earlier buffer with the same
+ * identifier (unused buffers are all configured with identifier 0). */
+static bool_t CO_CANrxFilterIsUsed(CO_CANmodule_t *CANmodule, uint16_t index)
+{
+    CO_CANrx_t *rxBuffer = &CANmodule->rxArray[index];
+    uint16_t i;
+
+    if (rxBuffer->pFunct == NULL) return false;
+
+    for (i = 0; i < index; i++) {
+        CO_CANrx_t *prev = &CANmodule->rxArray[i];
+        if (prev->pFunct != NULL && prev->ident == rxBuffer->ident && prev->mask == rxBuffer->mask) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Receive FIFO of the buffer: 0 for high priority identifiers, 1 for others */
+static uint8_t CO_CANrxFilterFifo(const CO_CANrx_t *rxBuffer)
+{
+    return (((rxBuffer->ident >> 2) & 0x07FF) <= CO_CAN_FIFO0_MAX_IDENT) ? 0 : 1;
+}
+
+/* Buffer matches single identifier, so it can be placed into list mode filter */
+static bool_t CO_CANrxFilterIsList(const CO_CANrx_t *rxBuffer)
+{
+    return rxBuffer->mask == (((0x07FF) << 2) | 0x02);
+}
+
+/* Write two 32-bit filter registers of the bank from four 16-bit filters */
+static void CO_CANrxFilterBankWrite(CAN_TypeDef *CANx, uint8_t bank, const uint16_t reg[4])
+{
+    CANx->sFilterRegister[bank].FR1 = ((uint32_t)reg[1] << 16) | reg[0];
+    CANx->sFilterRegister[bank].FR2 = ((uint32_t)reg[3] << 16) | reg[2];
+}
+
+/******************************************************************************/
+static void CO_CANrxFiltersUpdate(CO_CANmodule_t *CANmodule)
+{
+    CAN_TypeDef *CANx = CANmodule->CANbaseAddress->Instance;
+    uint16_t count[2][2] = {{0, 0}, {0, 0}};    /* [fifo][0 = list, 1 = mask] */
+    uint16_t filterNo[2] = {0, 0};              /* next filter match index */
+    uint16_t banksNeeded, banksAvailable;
+    uint32_t fm1r = 0, ffa1r = 0, fa1r = 0;
+    uint32_t ier;
+    uint8_t bank = 0;
+    uint8_t fifo, mode;
+    uint16_t i;
+
+    /* count used buffers for each FIFO and filter mode */
+    for (i = 0; i < CANmodule->rxSize; i++) {
+        if (CO_CANrxFilterIsUsed(CANmodule, i)) {
+            CO_CANrx_t *rxBuffer = &CANmodule->rxArray[i];
+            count[CO_CANrxFilterFifo(rxBuffer)][CO_CANrxFilterIsList(rxBuffer) ? 0 : 1]++;
+        }
+    }
+    banksNeeded = (count[0][0] + 3) / 4 + (count[0][1] + 1) / 2
+                + (count[1][0] + 3) / 4 + (count[1][1] + 1) / 2;
+
+    /* if all filters don't fit, keep last bank for catch-all filter */
+    CANmodule->useCANrxFilters = (banksNeeded <= CO_CAN_NO_FILTER_BANKS) ? true : false;
+    banksAvailable = CANmodule->useCANrxFilters ? CO_CAN_NO_FILTER_BANKS : (CO_CAN_NO_FILTER_BANKS - 1);
+
+    /* don't receive messages while filters and map are inconsistent */
+    ier = CANx->IER & (CAN_IER_FMPIE0 | CAN_IER_FMPIE1);
+    CANx->IER &= ~ier;
+    CANx->FMR |= CAN_FMR_FINIT;
+
+    memset(CANmodule->rxFilterMap, CO_CAN_FILTER_NO_MATCH, sizeof(CANmodule->rxFilterMap));
+
+    /* FIFO0 first, so high priority messages keep hardware filters, if banks run out */
+    for (fifo = 0; fifo < 2; fifo++) {
+        for (mode = 0; mode < 2; mode++) {
+            uint8_t slotsPerBank = (mode == 0) ? 4 : 2;
+            uint8_t firstBank = bank;
+            uint8_t slot = 0;
+            uint16_t reg[4];    /* FR1[15:0], FR1[31:16], FR2[15:0], FR2[31:16] */
+            uint32_t groupBanks;
+
+            for (i = 0; i < CANmodule->rxSize && bank < banksAvailable; i++) {
+                CO_CANrx_t *rxBuffer = &CANmodule->rxArray[i];
+                /* 16-bit filter: STDID[15:5], RTR[4], IDE[3] */
+                uint16_t id16 = (uint16_t)(rxBuffer->ident << 3);
+                uint16_t mask16 = (uint16_t)(rxBuffer->mask << 3) | 0x0008;
+
+                if (!CO_CANrxFilterIsUsed(CANmodule, i)
+                    || CO_CANrxFilterFifo(rxBuffer) != fifo
+                    || (CO_CANrxFilterIsList(rxBuffer) ? 0 : 1) != mode)
+                {
+                    continue;
+                }
+
+                if (mode == 0) {
+                    reg[slot] = id16;
+                }
+                else {
+                    reg[slot * 2] = id16;
+                    reg[slot * 2 + 1] = mask16;
+                }
+                CANmodule->rxFilterMap[fifo][filterNo[fifo] + slot] = (uint8_t)i;
+
+                if (++slot == slotsPerBank) {
+                    CO_CANrxFilterBankWrite(CANx, bank++, reg);
+                    filterNo[fifo] += slotsPerBank;
+                    slot = 0;
+                }
+            }
+
+            /* partially filled bank, repeat the first filter in unused slots */
+            if (slot != 0 && bank < banksAvailable) {
+                for (; slot < slotsPerBank; slot++) {
+                    if (mode == 0) {
+                        reg[slot] = reg[0];
+                    }
+                    else {
+                        reg[slot * 2] = reg[0];
+                        reg[slot * 2 + 1] = reg[1];
+                    }
+                    CANmodule->rxFilterMap[fifo][filterNo[fifo] + slot] =
+                        CANmodule->rxFilterMap[fifo][filterNo[fifo]];
+                }
+                CO_CANrxFilterBankWrite(CANx, bank++, reg);
+                filterNo[fifo] += slotsPerBank;
+            }
+
+            /* banks of one group are contiguous */
+            groupBanks = ((1UL << bank) - 1) & ~((1UL << firstBank) - 1);
+            if (mode == 0) fm1r |= groupBanks;
+            if (fifo == 1) ffa1r |= groupBanks;
+            fa1r |= groupBanks;
+        }
+    }
+
+    /* catch-all filter: two 16-bit mask filters, all bits don't care, FIFO1.
+     * 32-bit filter would win over all list filters, with the same scale list
+     * filters and earlier banks keep priority. Its filter match indexes stay
+     * unmapped, so other messages are matched in software. */
+    if (!CANmodule->useCANrxFilters) {
+        CANx->sFilterRegister[bank].FR1 = 0;
+        CANx->sFilterRegister[bank].FR2 = 0;
+        ffa1r |= (1UL << bank);
+        fa1r |= (1UL << bank);
+    }
+
+    CANx->FA1R = 0;
+    CANx->FM1R = fm1r;
+    CANx->FS1R = 0;                             /* all filters 16-bit */
+    CANx->FFA1R = ffa1r;
+    CANx->FA1R = fa1r;
+    CANx->FMR &= ~CAN_FMR_FINIT;
+
+    CANx->IER |= ier;
 }
 
 /******************************************************************************/
@@ -69,6 +69,9 @@
 #define bool_t bool
 #define CO_LITTLE_ENDIAN
 
+/* general configuration */
+#define CO_SDO_BUFFER_SIZE          889     /* 7*127, full size SDO blocks for program download */
+
 /* Exported define -----------------------------------------------------------*/
 #define PACKED_STRUCT               __attribute__((packed))
 #define ALIGN_STRUCT_DWORD          __attribute__((aligned(4)))
@@ -116,6 +119,28 @@
 #define CO_CAN_TXMAILBOX0   ((uint8_t)0x00)
 #define CO_CAN_TXMAILBOX1   ((uint8_t)0x01)
 #define CO_CAN_TXMAILBOX2   ((uint8_t)0x02)
+
+/* bxCAN acceptance filters. Registered receive buffers are compiled into the
+ * filter banks in 16-bit scale: exact identifiers in list mode (4 per bank),
+ * masked identifiers in mask mode (2 per bank). Identifiers up to
+ * CO_CAN_FIFO0_MAX_IDENT (NMT, SYNC, EMCY, TIME and PDO) are routed to FIFO0,
+ * the rest (SDO, heartbeat) to FIFO1. If the banks run out, the last bank
+ * accepts everything into FIFO1 and such frames are matched in software.
+ * Filters are programmed once by CO_CANsetNormalMode(), after CO_init(). */
+#define CO_CAN_NO_FILTER_BANKS      14
+#define CO_CAN_NO_FILTERS_PER_FIFO  (CO_CAN_NO_FILTER_BANKS * 4)
+#define CO_CAN_FIFO0_MAX_IDENT      0x57F
+#define CO_CAN_FILTER_NO_MATCH      0xFF
+
+/* Transmit scheduling. Pending messages are sent in CAN identifier order. A
+ * critical message (synchronous TPDO or identifier below
+ * CO_CAN_TX_CRITICAL_IDENT: NMT, SYNC, EMCY, TIME) which finds all mailboxes
+ * busy aborts the lowest priority non-critical mailbox, which is requeued. */
+#define CO_CAN_NO_TX_MAILBOXES      3
+#define CO_CAN_TX_CRITICAL_IDENT    0x180
+
+/* Free running timestamp for transmit queue delay, in CPU cycles */
+#define CO_CAN_TX_TIMESTAMP()       (DWT->CYCCNT)
 /* Timeout for initialization */
 
 #define INAK_TIMEOUT        ((uint32_t)0x0000FFFF)
@@ -176,6 +201,9 @@ typedef struct{
     uint8_t             data[8];
     volatile uint8_t    bufferFull;
     volatile uint8_t    syncFlag;
+    uint32_t            queueTime;      /* timestamp of CO_CANsend() */
+    uint32_t            queueDelay;     /* CO_CANsend() to mailbox, last message, CPU cycles */
+    uint32_t            queueDelayMax;  /* CO_CANsend() to mailbox, worst case, CPU cycles */
 }CO_CANtx_t;/* ALIGN_STRUCT_DWORD; */
 
 
@@ -191,11 +219,15 @@ typedef struct{
     volatile bool     CANnormal;
     volatile bool     useCANrxFilters;
     //volatile uint8_t    useCANrxFilters;
-    volatile uint8_t    bufferInhibitFlag;
     volatile uint8_t    firstCANtxMessage;
     volatile uint16_t   CANtxCount;
+    /* message in each tx mailbox and mailboxes aborted for requeue */
+    CO_CANtx_t * volatile txMailbox[CO_CAN_NO_TX_MAILBOXES];
+    volatile uint8_t    txRequeueFlags;
     uint32_t            errOld;
     void               *em;
+    /* rxArray index for each filter match index (FMI) of FIFO0 and FIFO1 */
+    uint8_t             rxFilterMap[2][CO_CAN_NO_FILTERS_PER_FIFO];
 }CO_CANmodule_t;
 
 /* Exported variables -----------------------------------------------------------*/
@@ -253,8 +285,12 @@ void CO_CANclearPendingSyncPDOs(CO_CANmodule_t *CANmodule);
 void CO_CANverifyErrors(CO_CANmodule_t *CANmodule);
 
 
-/* CAN interrupts receives and transmits CAN messages. */
-void CO_CANinterrupt_Rx(CO_CANmodule_t *CANmodule);
-void CO_CANinterrupt_Tx(CO_CANmodule_t *CANmodule);
+/* CAN interrupts receives and transmits CAN messages. RxFifo is
+ * CAN_RX_FIFO0 or CAN_RX_FIFO1, mailbox is the tx mailbox, which was sent. */
+void CO_CANinterrupt_Rx(CO_CANmodule_t *CANmodule, uint32_t RxFifo);
+void CO_CANinterrupt_Tx(CO_CANmodule_t *CANmodule, uint8_t mailbox);
+/* Transmission in tx mailbox was aborted or failed (arbitration lost or error
+ * while abort was requested), requeue message if preempted. */
+void CO_CANinterrupt_TxAbort(CO_CANmodule_t *CANmodule, uint8_t mailbox);
 
 #endif
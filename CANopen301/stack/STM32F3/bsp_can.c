@@ -13,6 +13,7 @@
 
 #include "bsp_can.h"
 #include "CANopen.h"
+#include "app_event.h"
 #include <string.h>
 /* public pertory */
 
@@ -20,6 +21,26 @@ CAN_RxHeaderTypeDef	RxMsg;
 uint8_t					CanRxData[8]={0,0,0,0,0,0,0,0};
 volatile	int8_t					CAN_RxStatus	=	0;
 
+/*
+*	Prescaler for 12 time quanta per bit (SYNC + BS1 5 + BS2 6) at APB1 = 36 MHz,
+*	0 if CANbitRate [kbit/s] can not be set exactly.
+*/
+static uint16_t MX_CAN_Prescaler(uint16_t CANbitRate)
+{
+	if(CANbitRate == 0 || (3000U % CANbitRate) != 0){
+		return 0;
+	}
+	return (uint16_t)(3000U / CANbitRate);
+}
+
+/*
+*	1 if MX_CAN_Init() can set CANbitRate [kbit/s] exactly, used by LSS configure bit timing.
+*/
+uint8_t MX_CAN_BitRateSupported(uint16_t CANbitRate)
+{
+	return (MX_CAN_Prescaler(CANbitRate) != 0) ? 1 : 0;
+}
+
 /*
 *
 */
@@ -39,7 +60,10 @@ void MX_CAN_Init(CAN_HandleTypeDef 		*pCan,uint16_t	CANbitRate)
 	*	BTR-BRP ʷƵ  ʱ䵥Ԫʱ䳤 36 /(2+9+7)/2 = 1 Mbps
 	*/
 	// CAN Baudrate = 500kbps (CAN clocked at 36 MHz),sure  okay 	by lijiabo
-	pCan->Init.Prescaler	= 6;
+	pCan->Init.Prescaler	= MX_CAN_Prescaler(CANbitRate);
+	if(pCan->Init.Prescaler == 0){
+		pCan->Init.Prescaler	= 6;		/* unsupported bit rate, keep 500kbps */
+	}
 	pCan->Init.SyncJumpWidth = CAN_SJW_1TQ;
 	pCan->Init.TimeSeg1 = CAN_BS1_5TQ;
 	pCan->Init.TimeSeg2 = CAN_BS2_6TQ;
@@ -74,7 +98,7 @@ void MX_CAN_Init(CAN_HandleTypeDef 		*pCan,uint16_t	CANbitRate)
 	pCan->Init.TimeTriggeredMode = DISABLE;
 	pCan->Init.AutoBusOff = DISABLE;
 	pCan->Init.AutoWakeUp = DISABLE;
-	pCan->Init.AutoRetransmission = DISABLE;
+	pCan->Init.AutoRetransmission = ENABLE;		/* message, which lost arbitration, is not dropped */
 	pCan->Init.ReceiveFifoLocked = DISABLE;
 	pCan->Init.TransmitFifoPriority = DISABLE;
 
@@ -101,7 +125,8 @@ void MX_CAN_Init(CAN_HandleTypeDef 		*pCan,uint16_t	CANbitRate)
 
 	
     // /* Can_init function of ST Driver puts the controller into the normal mode */
-    CAN_ITConfig(pCan->Instance, (CAN_IT_TX_MAILBOX_EMPTY | CAN_IT_RX_FIFO0_MSG_PENDING), ENABLE);
+    /* FIFO0 receives high priority messages, FIFO1 the others, see CO_CAN_FIFO0_MAX_IDENT */
+    CAN_ITConfig(pCan->Instance, (CAN_IT_TX_MAILBOX_EMPTY | CAN_IT_RX_FIFO0_MSG_PENDING | CAN_IT_RX_FIFO1_MSG_PENDING), ENABLE);
 		//HAL_CAN_ActivateNotification(pCan,CAN_IT_RX_FIFO0_MSG_PENDING);
 		//HAL_CAN_ActivateNotification(pCan,CAN_IT_TX_MAILBOX_EMPTY);					
 		HAL_CAN_Start(pCan);
@@ -188,8 +213,9 @@ void HAL_CAN_RxFifo0MsgPendingCallback(CAN_HandleTypeDef *hcan)
             the HAL_CAN_RxFifo0MsgPendingCallback could be implemented in the
             user file
    */
-	CO_CANinterrupt_Rx(CO->CANmodule[0]);
+	CO_CANinterrupt_Rx(CO->CANmodule[0], CAN_RX_FIFO0);
 	CAN_RxStatus	=	'R';
+	APP_EventPost(APP_EVENT_CAN_RX);
 /*	
 	 hst = HAL_CAN_GetRxMessage(hcan, CAN_RX_FIFO0, &RxMsg, CanRxData);
 	if ( hst == HAL_OK )
@@ -198,6 +224,23 @@ void HAL_CAN_RxFifo0MsgPendingCallback(CAN_HandleTypeDef *hcan)
 	
 }
 
+/**
+  * @brief  Rx FIFO 1 message pending callback.
+  * @param  hcan pointer to a CAN_HandleTypeDef structure that contains
+  *         the configuration information for the specified CAN.
+  * @retval None
+  */
+void HAL_CAN_RxFifo1MsgPendingCallback(CAN_HandleTypeDef *hcan)
+{
+  /* Prevent unused argument(s) compilation warning */
+  UNUSED(hcan);
+
+	/* SDO, heartbeat and messages from the catch-all filter */
+	CO_CANinterrupt_Rx(CO->CANmodule[0], CAN_RX_FIFO1);
+	CAN_RxStatus	=	'R';
+	APP_EventPost(APP_EVENT_CAN_RX);
+}
+
 /**
   * @brief  Transmission Mailbox 0 complete callback.
   * @param  hcan pointer to a CAN_HandleTypeDef structure that contains
@@ -213,10 +256,38 @@ void HAL_CAN_TxMailbox0CompleteCallback(CAN_HandleTypeDef *hcan)
             the HAL_CAN_TxMailbox0CompleteCallback could be implemented in the
             user file
    */
-	CO_CANinterrupt_Tx(CO->CANmodule[0]);
+	CO_CANinterrupt_Tx(CO->CANmodule[0], CO_CAN_TXMAILBOX0);
 	
 }
 
+/**
+  * @brief  Transmission Mailbox 1 complete callback.
+  * @param  hcan pointer to a CAN_HandleTypeDef structure that contains
+  *         the configuration information for the specified CAN.
+  * @retval None
+  */
+void HAL_CAN_TxMailbox1CompleteCallback(CAN_HandleTypeDef *hcan)
+{
+  /* Prevent unused argument(s) compilation warning */
+  UNUSED(hcan);
+
+	CO_CANinterrupt_Tx(CO->CANmodule[0], CO_CAN_TXMAILBOX1);
+}
+
+/**
+  * @brief  Transmission Mailbox 2 complete callback.
+  * @param  hcan pointer to a CAN_HandleTypeDef structure that contains
+  *         the configuration information for the specified CAN.
+  * @retval None
+  */
+void HAL_CAN_TxMailbox2CompleteCallback(CAN_HandleTypeDef *hcan)
+{
+  /* Prevent unused argument(s) compilation warning */
+  UNUSED(hcan);
+
+	CO_CANinterrupt_Tx(CO->CANmodule[0], CO_CAN_TXMAILBOX2);
+}
+
 
 /**
   * @brief  Sleep callback.
@@ -264,6 +335,8 @@ void HAL_CAN_WakeUpFromRxMsgCallback(CAN_HandleTypeDef *hcan)
   */
 void HAL_CAN_ErrorCallback(CAN_HandleTypeDef *hcan)
 {
+	uint8_t	mailbox;
+
   /* Prevent unused argument(s) compilation warning */
   UNUSED(hcan);
 
@@ -272,6 +345,20 @@ void HAL_CAN_ErrorCallback(CAN_HandleTypeDef *hcan)
    */
 	
 	CO_CANverifyErrors(CO->CANmodule[0]);
+
+	/*
+	*	Transmission failed, while abort was requested (arbitration lost or error,
+	*	HAL reports it instead of abort callback). Release mailbox, message is
+	*	requeued, if it was preempted. Error code accumulates, clear handled bits.
+	*/
+	for(mailbox = 0; mailbox < CO_CAN_NO_TX_MAILBOXES; mailbox++){
+		uint32_t	txError	=	(HAL_CAN_ERROR_TX_ALST0 | HAL_CAN_ERROR_TX_TERR0) << (2U * mailbox);
+
+		if(hcan->ErrorCode & txError){
+			hcan->ErrorCode	&=	~txError;
+			CO_CANinterrupt_TxAbort(CO->CANmodule[0], mailbox);
+		}
+	}
 	
 	
 }
@@ -291,6 +378,35 @@ void HAL_CAN_TxMailbox0AbortCallback(CAN_HandleTypeDef *hcan)
             the HAL_CAN_TxMailbox0AbortCallback could be implemented in the
             user file
    */
+	CO_CANinterrupt_TxAbort(CO->CANmodule[0], CO_CAN_TXMAILBOX0);
+}
+
+/**
+  * @brief  Transmission Mailbox 1 Cancellation callback.
+  * @param  hcan pointer to an CAN_HandleTypeDef structure that contains
+  *         the configuration information for the specified CAN.
+  * @retval None
+  */
+void HAL_CAN_TxMailbox1AbortCallback(CAN_HandleTypeDef *hcan)
+{
+  /* Prevent unused argument(s) compilation warning */
+  UNUSED(hcan);
+
+	CO_CANinterrupt_TxAbort(CO->CANmodule[0], CO_CAN_TXMAILBOX1);
+}
+
+/**
+  * @brief  Transmission Mailbox 2 Cancellation callback.
+  * @param  hcan pointer to an CAN_HandleTypeDef structure that contains
+  *         the configuration information for the specified CAN.
+  * @retval None
+  */
+void HAL_CAN_TxMailbox2AbortCallback(CAN_HandleTypeDef *hcan)
+{
+  /* Prevent unused argument(s) compilation warning */
+  UNUSED(hcan);
+
+	CO_CANinterrupt_TxAbort(CO->CANmodule[0], CO_CAN_TXMAILBOX2);
 }
 
 
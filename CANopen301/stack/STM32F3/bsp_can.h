@@ -70,6 +70,7 @@ extern 		uint8_t					CanRxData[8];
 extern	volatile	int8_t					CAN_RxStatus;
 
 void MX_CAN_Init(CAN_HandleTypeDef 		*pCan,uint16_t	CANbitRate);
+uint8_t MX_CAN_BitRateSupported(uint16_t CANbitRate);
 void CAN_SetMsg(CAN_TxHeaderTypeDef *TxMessage);
 void CAN_ITConfig(CAN_TypeDef* CANx, uint32_t CAN_IT, FunctionalState NewState);
 #endif
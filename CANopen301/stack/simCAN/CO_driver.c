@@ -0,0 +1,451 @@
+/*
+ * CAN module object for the virtual CAN bus of the host co-simulation.
+ *
+ * @file        CO_driver.c
+ * @author      Janez Paternoster
+ * @copyright   2015 Janez Paternoster
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "CO_driver.h"
+#include "CO_Emergency.h"
+
+
+CO_CANsimPort_t *CO_CANsimPort = NULL;
+
+static void CO_CANtxSchedule(CO_CANmodule_t *CANmodule);
+
+
+/******************************************************************************/
+void CO_CANsetConfigurationMode(int32_t CANbaseAddress){
+    /* Put CAN module in configuration mode */
+}
+
+
+/******************************************************************************/
+void CO_CANsetNormalMode(CO_CANmodule_t *CANmodule){
+    /* Put CAN module in normal mode */
+
+    CANmodule->CANnormal = true;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_CANmodule_init(
+        CO_CANmodule_t         *CANmodule,
+        void                   *CANbaseAddress,
+        CO_CANrx_t              rxArray[],
+        uint16_t                rxSize,
+        CO_CANtx_t              txArray[],
+        uint16_t                txSize,
+        uint16_t                CANbitRate)
+{
+    CO_CANsimPort_t *port = CO_CANsimPort;
+    uint16_t i;
+
+    /* verify arguments */
+    if(CANmodule==NULL || port==NULL || rxArray==NULL || txArray==NULL){
+        return CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    /* Configure object variables */
+    CANmodule->CANbaseAddress = port;
+    CANmodule->rxArray = rxArray;
+    CANmodule->rxSize = rxSize;
+    CANmodule->txArray = txArray;
+    CANmodule->txSize = txSize;
+    CANmodule->CANnormal = false;
+    CANmodule->useCANrxFilters = false;
+    CANmodule->firstCANtxMessage = true;
+    CANmodule->CANtxCount = 0U;
+    for(i=0U; i<CO_CAN_NO_TX_MAILBOXES; i++){
+        CANmodule->txMailbox[i] = NULL;
+    }
+    CANmodule->errOld = 0U;
+    CANmodule->em = NULL;
+
+    /* Unused buffer matches no message, also when CO_init() stops before
+     * other objects, see nodeIdUnconfigured. */
+    for(i=0U; i<rxSize; i++){
+        rxArray[i].ident = 0xFFFFU;
+        rxArray[i].mask = 0xFFFFU;
+        rxArray[i].pFunct = NULL;
+    }
+    for(i=0U; i<txSize; i++){
+        txArray[i].bufferFull = false;
+    }
+
+    /* Reset the virtual controller. Message, which is just on the bus, is
+     * finished by the bus and released by CO_CANinterrupt_Tx(). */
+    port->txRequest = 0U;
+    port->txComplete = 0U;
+
+    return CO_ERROR_NO;
+}
+
+
+/******************************************************************************/
+void CO_CANmodule_disable(CO_CANmodule_t *CANmodule){
+    /* turn off the module, drop requests, which are not on the bus */
+    if(CANmodule->CANbaseAddress != NULL){
+        CANmodule->CANbaseAddress->txRequest = 0U;
+    }
+    CANmodule->CANnormal = false;
+}
+
+
+/******************************************************************************/
+uint16_t CO_CANrxMsg_readIdent(const CO_CANrxMsg_t *rxMsg){
+    return (uint16_t) (rxMsg->ident & 0x07FFU);
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_CANrxBufferInit(
+        CO_CANmodule_t         *CANmodule,
+        uint16_t                index,
+        uint16_t                ident,
+        uint16_t                mask,
+        bool_t                  rtr,
+        void                   *object,
+        void                  (*pFunct)(void *object, const CO_CANrxMsg_t *message))
+{
+    CO_ReturnError_t ret = CO_ERROR_NO;
+
+    if((CANmodule!=NULL) && (object!=NULL) && (pFunct!=NULL) && (index < CANmodule->rxSize)){
+        /* buffer, which will be configured */
+        CO_CANrx_t *buffer = &CANmodule->rxArray[index];
+
+        /* Configure object variables */
+        buffer->object = object;
+        buffer->pFunct = pFunct;
+
+        /* CAN identifier and CAN mask, aligned with CO_CANrxMsg_t */
+        buffer->ident = ident & 0x07FFU;
+        if(rtr){
+            buffer->ident |= 0x0800U;
+        }
+        buffer->mask = (mask & 0x07FFU) | 0x0800U;
+    }
+    else{
+        ret = CO_ERROR_ILLEGAL_ARGUMENT;
+    }
+
+    return ret;
+}
+
+
+/******************************************************************************/
+CO_CANtx_t *CO_CANtxBufferInit(
+        CO_CANmodule_t         *CANmodule,
+        uint16_t                index,
+        uint16_t                ident,
+        bool_t                  rtr,
+        uint8_t                 noOfBytes,
+        bool_t                  syncFlag)
+{
+    CO_CANtx_t *buffer = NULL;
+
+    if((CANmodule != NULL) && (index < CANmodule->txSize)){
+        /* get specific buffer */
+        buffer = &CANmodule->txArray[index];
+
+        /* CAN identifier and rtr, aligned with CO_CANrxMsg_t */
+        buffer->ident = ((uint32_t)ident & 0x07FFU) | (rtr ? 0x0800U : 0U);
+        buffer->DLC = noOfBytes & 0x0FU;
+
+        buffer->bufferFull = false;
+        buffer->syncFlag = syncFlag;
+    }
+
+    return buffer;
+}
+
+
+/******************************************************************************/
+CO_ReturnError_t CO_CANsend(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer){
+    CO_ReturnError_t err = CO_ERROR_NO;
+
+    /* Verify overflow */
+    if(buffer->bufferFull){
+        if(!CANmodule->firstCANtxMessage){
+            /* don't set error, if bootup message is still on buffers */
+            CO_errorReport((CO_EM_t*)CANmodule->em, CO_EM_CAN_TX_OVERFLOW, CO_EMC_CAN_OVERRUN, buffer->ident);
+        }
+        CANmodule->CANbaseAddress->txOverflow++;
+        err = CO_ERROR_TX_OVERFLOW;
+    }
+
+    CO_LOCK_CAN_SEND();
+    /* Queue the message, overwritten message keeps its place in queue. Then
+     * transmit pending messages in priority order, if mailboxes are free. */
+    if(!buffer->bufferFull){
+        buffer->queueTime = CANmodule->CANbaseAddress->time;
+        buffer->bufferFull = true;
+        CANmodule->CANtxCount++;
+    }
+    CO_CANtxSchedule(CANmodule);
+    CO_UNLOCK_CAN_SEND();
+
+    return err;
+}
+
+
+/******************************************************************************/
+void CO_CANclearPendingSyncPDOs(CO_CANmodule_t *CANmodule){
+    CO_CANsimPort_t *port = CANmodule->CANbaseAddress;
+    uint32_t tpdoDeleted = 0U;
+    uint8_t i;
+
+    CO_LOCK_CAN_SEND();
+    /* Abort synchronous TPDOs from mailboxes, which are not on the bus yet */
+    for(i = 0U; i < CO_CAN_NO_TX_MAILBOXES; i++){
+        CO_CANtx_t *buffer = CANmodule->txMailbox[i];
+        if((buffer != NULL) && buffer->syncFlag && (port->txRequest & (1U << i)) != 0U && port->txOnBus != i){
+            port->txRequest &= (uint8_t)~(1U << i);
+            port->txAborted++;
+            CANmodule->txMailbox[i] = NULL;
+            tpdoDeleted = 1U;
+        }
+    }
+
+    /* delete also pending synchronous TPDOs in TX buffers */
+    if(CANmodule->CANtxCount != 0U){
+        uint16_t j;
+        CO_CANtx_t *buffer = &CANmodule->txArray[0];
+        for(j = CANmodule->txSize; j > 0U; j--){
+            if(buffer->bufferFull){
+                if(buffer->syncFlag){
+                    buffer->bufferFull = false;
+                    CANmodule->CANtxCount--;
+                    tpdoDeleted = 2U;
+                }
+            }
+            buffer++;
+        }
+    }
+    CO_UNLOCK_CAN_SEND();
+
+
+    if(tpdoDeleted != 0U){
+        CO_errorReport((CO_EM_t*)CANmodule->em, CO_EM_TPDO_OUTSIDE_WINDOW, CO_EMC_COMMUNICATION, tpdoDeleted);
+    }
+}
+
+
+/******************************************************************************/
+void CO_CANverifyErrors(CO_CANmodule_t *CANmodule){
+    CO_CANsimPort_t *port = CANmodule->CANbaseAddress;
+    CO_EM_t* em = (CO_EM_t*)CANmodule->em;
+    uint16_t rxErrors, txErrors;
+    uint32_t err;
+
+    rxErrors = port->rxErrors;
+    txErrors = port->txErrors;
+    if(rxErrors > 0xFFU) rxErrors = 0xFFU;
+
+    err = ((uint32_t)txErrors << 16) | ((uint32_t)rxErrors << 8) | (port->rxOverflow ? 1U : 0U);
+
+    if(CANmodule->errOld != err){
+        CANmodule->errOld = err;
+
+        if(txErrors >= 256U){                               /* bus off */
+            CO_errorReport(em, CO_EM_CAN_TX_BUS_OFF, CO_EMC_BUS_OFF_RECOVERED, err);
+        }
+        else{                                               /* not bus off */
+            CO_errorReset(em, CO_EM_CAN_TX_BUS_OFF, err);
+
+            if((rxErrors >= 96U) || (txErrors >= 96U)){     /* bus warning */
+                CO_errorReport(em, CO_EM_CAN_BUS_WARNING, CO_EMC_NO_ERROR, err);
+            }
+
+            if(rxErrors >= 128U){                           /* RX bus passive */
+                CO_errorReport(em, CO_EM_CAN_RX_BUS_PASSIVE, CO_EMC_CAN_PASSIVE, err);
+            }
+            else{
+                CO_errorReset(em, CO_EM_CAN_RX_BUS_PASSIVE, err);
+            }
+
+            if(txErrors >= 128U){                           /* TX bus passive */
+                if(!CANmodule->firstCANtxMessage){
+                    CO_errorReport(em, CO_EM_CAN_TX_BUS_PASSIVE, CO_EMC_CAN_PASSIVE, err);
+                }
+            }
+            else{
+                bool_t isError = CO_isError(em, CO_EM_CAN_TX_BUS_PASSIVE);
+                if(isError){
+                    CO_errorReset(em, CO_EM_CAN_TX_BUS_PASSIVE, err);
+                    CO_errorReset(em, CO_EM_CAN_TX_OVERFLOW, err);
+                }
+            }
+
+            if((rxErrors < 96U) && (txErrors < 96U)){       /* no error */
+                CO_errorReset(em, CO_EM_CAN_BUS_WARNING, err);
+            }
+        }
+
+        if(port->rxOverflow){                               /* CAN RX bus overflow */
+            CO_errorReport(em, CO_EM_CAN_RXB_OVERFLOW, CO_EMC_CAN_OVERRUN, err);
+            port->rxOverflow = false;
+        }
+    }
+}
+
+
+/******************************************************************************/
+/* Interrupt from receiver */
+void CO_CANinterrupt_Rx(CO_CANmodule_t *CANmodule){
+    const CO_CANrxMsg_t *rcvMsg = &CANmodule->CANbaseAddress->rxMsg;
+    uint32_t rcvMsgIdent = rcvMsg->ident;
+    CO_CANrx_t *buffer = &CANmodule->rxArray[0];
+    bool_t msgMatched = false;
+    uint16_t index;
+
+    /* No hardware filters, search rxArray for the same CAN-ID, like the
+     * catch-all path of STM32F3/CO_driver.c. */
+    for(index = CANmodule->rxSize; index > 0U; index--){
+        if(((rcvMsgIdent ^ buffer->ident) & buffer->mask) == 0U){
+            msgMatched = true;
+            break;
+        }
+        buffer++;
+    }
+
+    /* Call specific function, which will process the message */
+    if(msgMatched && (buffer->pFunct != NULL)){
+        CANmodule->CANbaseAddress->rxAccepted++;
+        buffer->pFunct(buffer->object, rcvMsg);
+    }
+}
+
+
+/******************************************************************************/
+/* Interrupt from transmitter */
+void CO_CANinterrupt_Tx(CO_CANmodule_t *CANmodule){
+    CO_CANsimPort_t *port = CANmodule->CANbaseAddress;
+    uint8_t i;
+
+    /* First CAN message (bootup) was sent successfully */
+    CANmodule->firstCANtxMessage = false;
+
+    /* Release finished mailboxes */
+    for(i = 0U; i < CO_CAN_NO_TX_MAILBOXES; i++){
+        if((port->txComplete & (1U << i)) != 0U){
+            port->txComplete &= (uint8_t)~(1U << i);
+            CANmodule->txMailbox[i] = NULL;
+        }
+    }
+
+    /* Are there any new messages waiting to be send */
+    CO_CANtxSchedule(CANmodule);
+}
+
+
+/******************************************************************************/
+/* Critical messages may preempt others from tx mailboxes */
+static bool_t CO_CANtxIsCritical(const CO_CANtx_t *buffer){
+    return (buffer->syncFlag || (buffer->ident & 0x07FFU) < CO_CAN_TX_CRITICAL_IDENT) ? true : false;
+}
+
+/* Abort lowest priority non-critical mailbox with lower priority than buffer.
+ * Mailbox, which is not on the bus, is released immediately. */
+static bool_t CO_CANtxPreempt(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer){
+    CO_CANsimPort_t *port = CANmodule->CANbaseAddress;
+    uint8_t victim = CO_CAN_NO_TX_MAILBOXES;
+    uint32_t victimIdent = buffer->ident;
+    CO_CANtx_t *mbBuffer;
+    uint8_t i;
+
+    if(!CO_CANtxIsCritical(buffer)) return false;
+
+    for(i = 0U; i < CO_CAN_NO_TX_MAILBOXES; i++){
+        mbBuffer = CANmodule->txMailbox[i];
+        if(mbBuffer != NULL && (port->txRequest & (1U << i)) != 0U && port->txOnBus != i
+            && !CO_CANtxIsCritical(mbBuffer) && mbBuffer->ident > victimIdent)
+        {
+            victim = i;
+            victimIdent = mbBuffer->ident;
+        }
+    }
+
+    if(victim == CO_CAN_NO_TX_MAILBOXES) return false;
+
+    port->txRequest &= (uint8_t)~(1U << victim);
+    port->txAborted++;
+    mbBuffer = CANmodule->txMailbox[victim];
+    CANmodule->txMailbox[victim] = NULL;
+
+    /* message was preempted by critical one, put it back to queue */
+    if(!mbBuffer->bufferFull){
+        mbBuffer->bufferFull = true;
+        CANmodule->CANtxCount++;
+    }
+    return true;
+}
+
+/* Load free mailboxes with pending messages, highest priority first */
+static void CO_CANtxSchedule(CO_CANmodule_t *CANmodule){
+    CO_CANsimPort_t *port = CANmodule->CANbaseAddress;
+
+    while(CANmodule->CANtxCount > 0U){
+        CO_CANtx_t *buffer = NULL;
+        CO_CANtx_t *candidate = CANmodule->txArray;
+        CO_CANrxMsg_t *txMbox;
+        uint16_t i;
+        uint8_t mailbox;
+
+        /* lower identifier has higher priority on the bus */
+        for(i = CANmodule->txSize; i > 0U; i--){
+            if(candidate->bufferFull && (buffer == NULL || candidate->ident < buffer->ident)){
+                buffer = candidate;
+            }
+            candidate++;
+        }
+
+        /* Clear counter if no more messages */
+        if(buffer == NULL){
+            CANmodule->CANtxCount = 0U;
+            break;
+        }
+
+        for(mailbox = 0U; mailbox < CO_CAN_NO_TX_MAILBOXES; mailbox++){
+            if(CANmodule->txMailbox[mailbox] == NULL) break;
+        }
+        if(mailbox == CO_CAN_NO_TX_MAILBOXES){
+            if(CO_CANtxPreempt(CANmodule, buffer)) continue;
+            break;
+        }
+
+        /* copy message to the mailbox and request transmission */
+        txMbox = &port->txMailbox[mailbox];
+        txMbox->ident = buffer->ident;
+        txMbox->DLC = buffer->DLC;
+        for(i = 0U; i < 8U; i++){
+            txMbox->data[i] = buffer->data[i];
+        }
+        port->txQueueTime[mailbox] = buffer->queueTime;
+        port->txSyncFlag[mailbox] = buffer->syncFlag;
+        CANmodule->txMailbox[mailbox] = buffer;
+        port->txRequest |= (uint8_t)(1U << mailbox);
+
+        buffer->bufferFull = false;
+        CANmodule->CANtxCount--;
+    }
+}
@@ -0,0 +1,237 @@
+/*
+ * CAN module object for the virtual CAN bus of the host co-simulation.
+ *
+ * @file        CO_driver.h
+ * @author      Janez Paternoster
+ * @copyright   2015 Janez Paternoster
+ *
+ * This file is part of CANopenNode, an opensource CANopen Stack.
+ * Project home page is <https://github.com/CANopenNode/CANopenNode>.
+ * For more information on CANopen see <http://www.can-cia.org/>.
+ *
+ * CANopenNode is free and open source software: you can redistribute
+ * it and/or modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation, either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef CO_DRIVER_H
+#define CO_DRIVER_H
+
+
+/* For documentation see file drvTemplate/CO_driver.h
+ *
+ * The driver runs on a virtual CAN controller (CO_CANsimPort_t), which is
+ * owned by the simulator. Controller has transmit mailboxes like bxCAN of
+ * STM32F3 and transmit queue is scheduled the same way as in
+ * STM32F3/CO_driver.c: pending message with the lowest identifier goes to
+ * the first free mailbox. Simulator arbitrates mailboxes of all nodes, sets
+ * the completion flags and calls CO_CANinterrupt_Rx() / CO_CANinterrupt_Tx(),
+ * which run in zero virtual time.
+ *
+ * Stack keeps its objects in globals, so every simulated node is a separate
+ * copy of the shared library with the stack, see cosim/cosim.c. */
+
+
+#include <stddef.h>         /* for 'NULL' */
+#include <stdint.h>         /* for 'int8_t' to 'uint64_t' */
+#include <stdbool.h>        /* for 'true', 'false' */
+
+
+/* general configuration */
+    #define CO_SDO_BUFFER_SIZE          889     /* 7*127, same as STM32F3 */
+    #define CO_CAN_NO_TX_MAILBOXES      3       /* same as bxCAN */
+    #define CO_CAN_SIM_MAILBOX_NONE     0xFFU
+    #define CO_CAN_TX_CRITICAL_IDENT    0x180   /* NMT, SYNC, EMCY may preempt mailboxes */
+
+
+/* Critical sections, all code of one node runs in one thread */
+    #define CO_LOCK_CAN_SEND()
+    #define CO_UNLOCK_CAN_SEND()
+
+    #define CO_LOCK_EMCY()
+    #define CO_UNLOCK_EMCY()
+
+    #define CO_LOCK_OD()
+    #define CO_UNLOCK_OD()
+
+
+/* Data types */
+    /* int8_t to uint64_t are defined in stdint.h */
+    #define bool_t bool
+    typedef float                   float32_t;
+    typedef long double             float64_t;
+    typedef char                    char_t;
+    typedef unsigned char           oChar_t;
+    typedef unsigned char           domain_t;
+
+
+/* Return values */
+typedef enum{
+    CO_ERROR_NO                 = 0,
+    CO_ERROR_ILLEGAL_ARGUMENT   = -1,
+    CO_ERROR_OUT_OF_MEMORY      = -2,
+    CO_ERROR_TIMEOUT            = -3,
+    CO_ERROR_ILLEGAL_BAUDRATE   = -4,
+    CO_ERROR_RX_OVERFLOW        = -5,
+    CO_ERROR_RX_PDO_OVERFLOW    = -6,
+    CO_ERROR_RX_MSG_LENGTH      = -7,
+    CO_ERROR_RX_PDO_LENGTH      = -8,
+    CO_ERROR_TX_OVERFLOW        = -9,
+    CO_ERROR_TX_PDO_WINDOW      = -10,
+    CO_ERROR_TX_UNCONFIGURED    = -11,
+    CO_ERROR_PARAMETERS         = -12,
+    CO_ERROR_DATA_CORRUPT       = -13,
+    CO_ERROR_CRC                = -14
+}CO_ReturnError_t;
+
+
+/* CAN message as seen on the virtual bus. Identifier has 11-bit CAN-ID in
+ * bits 0..10 and RTR in bit 11, so lower value wins arbitration. */
+typedef struct{
+    uint32_t        ident;
+    uint8_t         DLC;
+    uint8_t         data[8];
+}CO_CANrxMsg_t;
+
+
+/* Received message object */
+typedef struct{
+    uint16_t            ident;
+    uint16_t            mask;
+    void               *object;
+    void              (*pFunct)(void *object, const CO_CANrxMsg_t *message);
+}CO_CANrx_t;
+
+
+/* Transmit message object. */
+typedef struct{
+    uint32_t            ident;
+    uint8_t             DLC;
+    uint8_t             data[8];
+    volatile bool_t     bufferFull;
+    volatile bool_t     syncFlag;
+    uint64_t            queueTime;      /* virtual time of CO_CANsend(), ns */
+}CO_CANtx_t;
+
+
+/* Virtual CAN controller. Driver writes mailboxes and request bits, bus
+ * clears them and sets completion flags. */
+typedef struct{
+    CO_CANrxMsg_t       txMailbox[CO_CAN_NO_TX_MAILBOXES];
+    uint64_t            txQueueTime[CO_CAN_NO_TX_MAILBOXES];
+    bool_t              txSyncFlag[CO_CAN_NO_TX_MAILBOXES];
+    volatile uint8_t    txRequest;      /* mailbox bits, waiting for the bus */
+    volatile uint8_t    txComplete;     /* mailbox bits, sent successfully */
+    volatile uint8_t    txOnBus;        /* mailbox in transmission or CO_CAN_SIM_MAILBOX_NONE */
+    CO_CANrxMsg_t       rxMsg;          /* message for CO_CANinterrupt_Rx() */
+    volatile uint64_t   time;           /* current virtual time, ns */
+    uint16_t            rxErrors;       /* error counters, set by the bus */
+    uint16_t            txErrors;
+    bool_t              rxOverflow;
+    uint32_t            rxAccepted;     /* frames for a receive buffer, set by the driver */
+    uint32_t            txAborted;      /* statistics */
+    uint32_t            txOverflow;
+}CO_CANsimPort_t;
+
+
+/* CAN module object. */
+typedef struct{
+    CO_CANsimPort_t    *CANbaseAddress;
+    CO_CANrx_t         *rxArray;
+    uint16_t            rxSize;
+    CO_CANtx_t         *txArray;
+    uint16_t            txSize;
+    volatile bool_t     CANnormal;
+    volatile bool_t     useCANrxFilters;
+    volatile bool_t     firstCANtxMessage;
+    volatile uint16_t   CANtxCount;
+    CO_CANtx_t * volatile txMailbox[CO_CAN_NO_TX_MAILBOXES];
+    uint32_t            errOld;
+    void               *em;
+}CO_CANmodule_t;
+
+
+/* Endianes */
+    #define CO_LITTLE_ENDIAN
+
+
+/* Virtual controller of this node. Must be set before CO_init(), one CAN
+ * module per loaded copy of the stack. */
+extern CO_CANsimPort_t *CO_CANsimPort;
+
+
+/* Request CAN configuration or normal mode */
+void CO_CANsetConfigurationMode(int32_t CANbaseAddress);
+void CO_CANsetNormalMode(CO_CANmodule_t *CANmodule);
+
+
+/* Initialize CAN module object. CANbaseAddress is not used, module is
+ * connected to CO_CANsimPort. */
+CO_ReturnError_t CO_CANmodule_init(
+        CO_CANmodule_t         *CANmodule,
+        void                   *CANbaseAddress,
+        CO_CANrx_t              rxArray[],
+        uint16_t                rxSize,
+        CO_CANtx_t              txArray[],
+        uint16_t                txSize,
+        uint16_t                CANbitRate);
+
+
+/* Switch off CANmodule. */
+void CO_CANmodule_disable(CO_CANmodule_t *CANmodule);
+
+
+/* Read CAN identifier */
+uint16_t CO_CANrxMsg_readIdent(const CO_CANrxMsg_t *rxMsg);
+
+
+/* Configure CAN message receive buffer. */
+CO_ReturnError_t CO_CANrxBufferInit(
+        CO_CANmodule_t         *CANmodule,
+        uint16_t                index,
+        uint16_t                ident,
+        uint16_t                mask,
+        bool_t                  rtr,
+        void                   *object,
+        void                  (*pFunct)(void *object, const CO_CANrxMsg_t *message));
+
+
+/* Configure CAN message transmit buffer. */
+CO_CANtx_t *CO_CANtxBufferInit(
+        CO_CANmodule_t         *CANmodule,
+        uint16_t                index,
+        uint16_t                ident,
+        bool_t                  rtr,
+        uint8_t                 noOfBytes,
+        bool_t                  syncFlag);
+
+
+/* Send CAN message. */
+CO_ReturnError_t CO_CANsend(CO_CANmodule_t *CANmodule, CO_CANtx_t *buffer);
+
+
+/* Clear all synchronous TPDOs from CAN module transmit buffers. */
+void CO_CANclearPendingSyncPDOs(CO_CANmodule_t *CANmodule);
+
+
+/* Verify all errors of CAN module. */
+void CO_CANverifyErrors(CO_CANmodule_t *CANmodule);
+
+
+/* Virtual CAN interrupts. Receive processes CO_CANsimPort_t.rxMsg, transmit
+ * releases completed mailboxes and loads pending messages. */
+void CO_CANinterrupt_Rx(CO_CANmodule_t *CANmodule);
+void CO_CANinterrupt_Tx(CO_CANmodule_t *CANmodule);
+
+
+#endif
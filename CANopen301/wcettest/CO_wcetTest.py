@@ -0,0 +1,286 @@
+#!/usr/bin/env python3
+#
+# Host test of the worst-case stack and execution time analysis,
+# Utilities/stack_wcet.py, on a fixture of a linked image.
+#
+# @file        CO_wcetTest.py
+# @author      Janez Paternoster
+# @copyright   2015 Janez Paternoster
+#
+# This file is part of CANopenNode, an opensource CANopen Stack.
+# Project home page is <https://github.com/CANopenNode/CANopenNode>.
+# For more information on CANopen see <http://www.can-cia.org/>.
+#
+# CANopenNode is free and open source software: you can redistribute
+# it and/or modify it under the terms of the GNU General Public License
+# as published by the Free Software Foundation, either version 2 of the
+# License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+# FOC.S is the Thumb-2 of some functions of the interrupts as arm-none-eabi-gcc
+# -O2 emits them, linked with STM32F302R8Tx_FLASH.ld: the current loop in RAM,
+# the medium frequency task and USART1 in FLASH. FOC.dis and FOC.sym are the
+# objdump -d and objdump -t output of the image, the commands are in FOC.S.
+# su holds the -fstack-usage output of the same functions, memcpy has none.
+#
+# The expected values are counted by hand from FOC.dis with the cost model of
+# the script (FLASH: literal loads +2, taken branches +5; RAM: loads +1,
+# branches +3):
+#
+#   MCM_Sqrt                     57 per iteration, 6 iterations    342
+#   thunk to MCM_Sqrt (RAM)      movw, movt, bx                      6
+#   ADC1_IRQHandler              20 + TSK_HighFrequencyTask 39
+#                                + PWMC 7 + R3_1_F30X_GetPhaseCurrents 36
+#                                + thunk 348 + CMON_Sample 55      505
+#   SysTick_Handler              24 + HAL_IncTick 22 + HAL_SYSTICK 13
+#                                + TB 6 + MC_Scheduler 34
+#                                + TSK_MediumFrequencyTaskM1 31 + 342   472
+#   USART1_IRQHandler                                               27
+#
+# Stack: ADC1 8 + 16 + max(PWMC 0 + R3 16, MCM_Sqrt 0, CMON 8) = 40,
+# SysTick 8 + 0 + 8 + 48 = 64, main 16 + memcpy 16 = 32; with the exception
+# frames of priorities 2, 3 and 4: 32 + 144 + 168 + 104 = 448 bytes.
+#
+# report: per interrupt stack and cycles, main stack and total, exit status 0.
+# symbols: ADC1_IRQHandler is found at the address of _sdata and _sccmram,
+#     mapping symbols, literal pools and the padding of lld are not code.
+# gnu_format: arm-none-eabi-objdump lines give the same functions as the
+#     LLVM lines of the fixture.
+# incomplete: missing frame, unknown indirect call and loop without bound
+#     are reported, exit status 1.
+# budget: a stack over _Min_Stack_Size fails.
+
+import getopt
+import importlib.util
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+SCRIPT = os.path.join(HERE, "..", "..", "Utilities", "stack_wcet.py")
+DISASM = os.path.join(HERE, "FOC.dis")
+SYMS = os.path.join(HERE, "FOC.sym")
+SU = os.path.join(HERE, "su")
+
+# name: stack [bytes], cycles
+EXPECTED = {
+    "ADC1_IRQHandler":   (40, 505),
+    "SysTick_Handler":   (64, 472),
+    "USART1_IRQHandler": (0, 27),
+}
+EXPECTED_MAIN = 32
+EXPECTED_TOTAL = 448
+
+# SMON_Process and MC_Scheduler of FOC.dis as arm-none-eabi-objdump -d
+# --no-show-raw-insn prints them
+GNU_DISASM = """
+08000088 <MC_Scheduler>:
+ 8000088:\tpush\t{r4, lr}
+ 800008a:\tldr\tr4, [pc, #20]\t; (80000a0 <MC_Scheduler+0x18>)
+ 800008c:\tldrb\tr3, [r4, #0]
+ 800008e:\tcbnz\tr3, 800009c <MC_Scheduler+0x14>
+ 8000090:\tmovs\tr3, #1
+ 8000092:\tstrb\tr3, [r4, #0]
+ 8000094:\tbl\t80000a4 <TSK_MediumFrequencyTaskM1>
+ 8000098:\tmovs\tr3, #0
+ 800009a:\tstrb\tr3, [r4, #0]
+ 800009c:\tpop\t{r4, pc}
+ 800009e:\tnop
+ 80000a0:\t20000020 \t.word\t0x20000020
+
+08000158 <SMON_Process>:
+ 8000158:\tldr\tr3, [pc, #28]\t; (8000178 <SMON_Process+0x20>)
+ 800015a:\tldrd\tr1, r2, [r3, #8]
+ 800015e:\tldr\tr0, [pc, #28]\t; (800017c <SMON_Process+0x24>)
+ 8000160:\tcmp\tr2, r1
+ 8000162:\tbcs.n\t8000170 <SMON_Process+0x18>
+ 8000164:\tldr.w\tip, [r2], #4
+ 8000168:\tcmp\tip, r0
+ 800016a:\tbeq.n\t8000160 <SMON_Process+0x8>
+ 800016c:\tsubs\tr2, #4
+ 800016e:\tstr\tr2, [r3, #8]
+ 8000170:\tldr\tr2, [r3, #0]
+ 8000172:\tstr\tr2, [r3, #12]
+ 8000174:\tmovs\tr0, #1
+ 8000176:\tbx\tlr
+ 8000178:\t20000040 \t.word\t0x20000040
+ 800017c:\tc5c5c5c5 \t.word\t0xc5c5c5c5
+"""
+
+
+def load_script():
+    spec = importlib.util.spec_from_file_location("stack_wcet", SCRIPT)
+    module = importlib.util.module_from_spec(spec)
+    spec.loader.exec_module(module)
+    return module
+
+
+wcet = load_script()
+
+
+# Helpers ######################################################################
+def wcet_fail(name, what):
+    sys.stderr.write("CO_wcetTest: %s: %s\n" % (name, what))
+    sys.exit(1)
+
+
+def wcet_read(path):
+    with open(path) as f:
+        return f.read()
+
+
+def wcet_analysis(su=SU):
+    functions = wcet.parse_disassembly(wcet_read(DISASM), wcet.parse_symbols(wcet_read(SYMS)))
+    frames, unbounded = wcet.parse_su([su])
+    return wcet.Analysis(functions, frames, unbounded)
+
+
+def wcet_run(*extra):
+    args = [sys.executable, SCRIPT, "--disasm", DISASM, "--syms", SYMS] + list(extra)
+    run = subprocess.run(args, stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+    return run.returncode, run.stdout.decode()
+
+
+# Tests ########################################################################
+def wcet_testReport():
+    name = "report"
+    analysis = wcet_analysis()
+    for isr, (stack, cycles) in sorted(EXPECTED.items()):
+        if analysis.stack(isr) != stack:
+            wcet_fail(name, "%s stack %d, expected %d" % (isr, analysis.stack(isr), stack))
+        if analysis.cycles(isr) != cycles:
+            wcet_fail(name, "%s cycles %d, expected %d" % (isr, analysis.cycles(isr), cycles))
+    if analysis.stack("main") != EXPECTED_MAIN:
+        wcet_fail(name, "main stack %d" % analysis.stack("main"))
+    if analysis.errors:
+        wcet_fail(name, "errors: %s" % ", ".join(sorted(analysis.errors)))
+
+    status, output = wcet_run("--su", SU)
+    if status != 0:
+        wcet_fail(name, "exit status %d\n%s" % (status, output))
+    total = "main stack %d + interrupts %d = %d bytes" % (
+        EXPECTED_MAIN, EXPECTED_TOTAL - EXPECTED_MAIN, EXPECTED_TOTAL)
+    if total not in output:
+        wcet_fail(name, "total not reported as '%s'\n%s" % (total, output))
+
+
+def wcet_testSymbols():
+    name = "symbols"
+    functions = wcet.parse_disassembly(wcet_read(DISASM), wcet.parse_symbols(wcet_read(SYMS)))
+    if "ADC1_IRQHandler" not in functions or functions["ADC1_IRQHandler"].address != 0x20000000:
+        wcet_fail(name, "ADC1_IRQHandler at the start of .ccmram not found")
+    for symbol in ("_sdata", "_sccmram", "$d.4", "$t", "_Min_Stack_Size"):
+        if symbol in functions:
+            wcet_fail(name, "%s taken as a function" % symbol)
+    # bmi of the 0xd4d4 padding after the literal pool
+    if functions["MCM_Sqrt"].calls or functions["memcpy"].calls:
+        wcet_fail(name, "padding taken as a call")
+    if functions["MCM_Sqrt"].cycles != 57 or not functions["MCM_Sqrt"].loop:
+        wcet_fail(name, "MCM_Sqrt %d cycles per iteration" % functions["MCM_Sqrt"].cycles)
+    # literal pool word 0xc5c5c5c5, printed as c5 c5 c5 c5
+    if functions["SMON_Process"].cycles != 41:
+        wcet_fail(name, "literal pool of SMON_Process counted as code")
+    thunk = functions["__Thumbv7ABSLongThunk_MCM_Sqrt"]
+    if thunk.calls != ["MCM_Sqrt"] or thunk.cycles != 6 or thunk.indirect:
+        wcet_fail(name, "thunk not counted as a call of MCM_Sqrt")
+
+    # without the symbol table the interrupt is hidden behind _sdata
+    functions = wcet.parse_disassembly(wcet_read(DISASM))
+    if "ADC1_IRQHandler" in functions or "$d.4" in functions:
+        wcet_fail(name, "disassembly alone names ADC1_IRQHandler or a mapping symbol")
+
+
+def wcet_testGnuFormat():
+    name = "gnu_format"
+    gnu = wcet.parse_disassembly(GNU_DISASM)
+    llvm = wcet.parse_disassembly(wcet_read(DISASM), wcet.parse_symbols(wcet_read(SYMS)))
+    for function in ("MC_Scheduler", "SMON_Process"):
+        a, b = gnu[function], llvm[function]
+        if (a.cycles, a.calls, a.indirect, a.loop) != (b.cycles, b.calls, b.indirect, b.loop):
+            wcet_fail(name, "%s: %d cycles, calls %s, loop %d; LLVM %d cycles, calls %s, loop %d" % (
+                function, a.cycles, a.calls, a.loop, b.cycles, b.calls, b.loop))
+
+
+def wcet_testIncomplete():
+    name = "incomplete"
+    tmp = tempfile.mkdtemp()
+    try:
+        su = os.path.join(tmp, "su")
+        shutil.copytree(SU, su)
+        os.remove(os.path.join(su, "mc_math.su"))
+        analysis = wcet_analysis(su)
+        analysis.stack("ADC1_IRQHandler")
+        if "no stack usage: MCM_Sqrt" not in analysis.errors:
+            wcet_fail(name, "missing frame of MCM_Sqrt not reported")
+        status, output = wcet_run("--su", su)
+        if status != 1 or "error: no stack usage: MCM_Sqrt" not in output:
+            wcet_fail(name, "missing frame: exit status %d\n%s" % (status, output))
+    finally:
+        shutil.rmtree(tmp)
+
+    indirect = wcet.INDIRECT_CALLS.pop("PWMC_GetPhaseCurrents")
+    bound = wcet.LOOP_BOUNDS.pop("MCM_Sqrt")
+    try:
+        analysis = wcet_analysis()
+        analysis.stack("ADC1_IRQHandler")
+        analysis.cycles("ADC1_IRQHandler")
+        for error in ("indirect call not in INDIRECT_CALLS: PWMC_GetPhaseCurrents",
+                      "loop without bound in LOOP_BOUNDS: MCM_Sqrt"):
+            if error not in analysis.errors:
+                wcet_fail(name, "'%s' not reported" % error)
+    finally:
+        wcet.INDIRECT_CALLS["PWMC_GetPhaseCurrents"] = indirect
+        wcet.LOOP_BOUNDS["MCM_Sqrt"] = bound
+
+
+def wcet_testBudget():
+    name = "budget"
+    tmp = tempfile.mkdtemp()
+    try:
+        ld = os.path.join(tmp, "small.ld")
+        with open(ld, "w") as f:
+            f.write("_Min_Stack_Size = 0x100; /* required amount of stack */\n")
+        status, output = wcet_run("--su", SU, "--ld", ld)
+        if status != 1 or "_Min_Stack_Size 256  OVER BUDGET" not in output:
+            wcet_fail(name, "448 bytes over 256 not failed, exit status %d\n%s" % (status, output))
+    finally:
+        shutil.rmtree(tmp)
+
+
+# Main #########################################################################
+TESTS = [
+    ("report",      wcet_testReport),
+    ("symbols",     wcet_testSymbols),
+    ("gnu_format",  wcet_testGnuFormat),
+    ("incomplete",  wcet_testIncomplete),
+    ("budget",      wcet_testBudget),
+]
+
+
+def main():
+    try:
+        opts, _args = getopt.getopt(sys.argv[1:], "f:")
+    except getopt.GetoptError:
+        sys.stderr.write("Usage: %s [-f name filter]\n" % sys.argv[0])
+        return 1
+    name_filter = dict(opts).get("-f")
+
+    for test_name, run in TESTS:
+        if name_filter is not None and name_filter not in test_name:
+            continue
+        run()
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
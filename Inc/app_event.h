@@ -0,0 +1,77 @@
+/**
+  ******************************************************************************
+  * @file    app_event.h
+  * @author  Motor Control SDK Team, ST Microelectronics
+  * @brief   Events from interrupts to the main loop.
+  *
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2018 STMicroelectronics International N.V.
+  * All rights reserved.</center></h2>
+  *
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted, provided that the following conditions are met:
+  *
+  * 1. Redistribution of source code must retain the above copyright notice,
+  *    this list of conditions and the following disclaimer.
+  * 2. Redistributions in binary form must reproduce the above copyright notice,
+  *    this list of conditions and the following disclaimer in the documentation
+  *    and/or other materials provided with the distribution.
+  * 3. Neither the name of STMicroelectronics nor the names of other
+  *    contributors to this software may be used to endorse or promote products
+  *    derived from this software without specific written permission.
+  * 4. This software, including modifications and/or derivative works of this
+  *    software, must execute solely and exclusively on microcontroller or
+  *    microprocessor devices manufactured by or for STMicroelectronics.
+  * 5. Redistribution and use of this software other than as permitted under
+  *    this license is void and will automatically terminate your rights under
+  *    this license.
+  *
+  * THIS SOFTWARE IS PROVIDED BY STMICROELECTRONICS AND CONTRIBUTORS "AS IS"
+  * AND ANY EXPRESS, IMPLIED OR STATUTORY WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+  * PARTICULAR PURPOSE AND NON-INFRINGEMENT OF THIRD PARTY INTELLECTUAL PROPERTY
+  * RIGHTS ARE DISCLAIMED TO THE FULLEST EXTENT PERMITTED BY LAW. IN NO EVENT
+  * SHALL STMICROELECTRONICS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+  * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __APP_EVENT_H
+#define __APP_EVENT_H
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Exported constants --------------------------------------------------------*/
+/* Event flags. Events of the same kind, posted before the main loop takes
+   them, are merged into one. */
+#define APP_EVENT_TICK          (uint32_t)(0x00000001u) /*!< 1 ms SysTick, CANopen timers */
+#define APP_EVENT_CAN_RX        (uint32_t)(0x00000002u) /*!< CANopen message received */
+#define APP_EVENT_MODBUS_FRAME  (uint32_t)(0x00000004u) /*!< USART1 frame complete (inter-frame timeout) */
+#define APP_EVENT_MOTOR_FAULT   (uint32_t)(0x00000008u) /*!< Safety task switched the PWM off */
+#define APP_EVENT_BACKGROUND    (uint32_t)(0x00000010u) /*!< Main loop has more work, don't sleep */
+
+/* Exported functions ------------------------------------------------------- */
+void APP_EventPost(uint32_t wEvents);
+uint32_t APP_EventWait(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __APP_EVENT_H */
+
+/************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
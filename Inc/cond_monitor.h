@@ -0,0 +1,85 @@
+/**
+  ******************************************************************************
+  * @file    cond_monitor.h
+  * @author  Motor Control SDK Team, ST Microelectronics
+  * @brief   Condition monitoring from the spectrum of the motor current.
+  *
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2018 STMicroelectronics International N.V.
+  * All rights reserved.</center></h2>
+  *
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted, provided that the following conditions are met:
+  *
+  * 1. Redistribution of source code must retain the above copyright notice,
+  *    this list of conditions and the following disclaimer.
+  * 2. Redistributions in binary form must reproduce the above copyright notice,
+  *    this list of conditions and the following disclaimer in the documentation
+  *    and/or other materials provided with the distribution.
+  * 3. Neither the name of STMicroelectronics nor the names of other
+  *    contributors to this software may be used to endorse or promote products
+  *    derived from this software without specific written permission.
+  * 4. This software, including modifications and/or derivative works of this
+  *    software, must execute solely and exclusively on microcontroller or
+  *    microprocessor devices manufactured by or for STMicroelectronics.
+  * 5. Redistribution and use of this software other than as permitted under
+  *    this license is void and will automatically terminate your rights under
+  *    this license.
+  *
+  * THIS SOFTWARE IS PROVIDED BY STMICROELECTRONICS AND CONTRIBUTORS "AS IS"
+  * AND ANY EXPRESS, IMPLIED OR STATUTORY WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+  * PARTICULAR PURPOSE AND NON-INFRINGEMENT OF THIRD PARTY INTELLECTUAL PROPERTY
+  * RIGHTS ARE DISCLAIMED TO THE FULLEST EXTENT PERMITTED BY LAW. IN NO EVENT
+  * SHALL STMICROELECTRONICS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+  * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __COND_MONITOR_H
+#define __COND_MONITOR_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "mc_type.h"
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Exported constants --------------------------------------------------------*/
+#define CMON_FFT_LEN          256u  /*!< Samples per record */
+#define CMON_DECIMATION       10u   /*!< FOC cycles per sample: 1 kHz at 10 kHz FOC */
+
+/* Index of the exported features, magnitudes are averaged over records */
+#define CMON_FEAT_SHAFT_FREQ  0u    /*!< Shaft frequency of the last record, 0.1 Hz */
+#define CMON_FEAT_FLOOR       1u    /*!< Mean magnitude of the spectrum */
+#define CMON_FEAT_IMBALANCE   2u    /*!< Magnitude at 1x shaft frequency */
+#define CMON_FEAT_ECCENTRIC   3u    /*!< Magnitude at 2x shaft frequency */
+#define CMON_FEAT_BPFO        4u    /*!< Magnitude at the bearing outer race frequency */
+#define CMON_FEAT_BPFI        5u    /*!< Magnitude at the bearing inner race frequency */
+#define CMON_FEAT_RECORDS     6u    /*!< Records analysed since power on */
+#define CMON_FEATURES_NBR     7u
+
+/* Exported functions ------------------------------------------------------- */
+void CMON_Init(void);
+void CMON_Sample(int16_t hIq);
+void CMON_SetFOCFrequency(uint16_t hFOCFrequencyHz);
+bool CMON_Process(void);
+void CMON_GetFeatures(uint16_t *pFeatures);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __COND_MONITOR_H */
+
+/************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
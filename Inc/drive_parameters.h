@@ -223,10 +223,26 @@
                                                            signals are enabled */
 #define HIGH_SIDE_IDLE_STATE              TURN_OFF
 #define LOW_SIDE_IDLE_STATE               TURN_OFF
+#define CURR_OVERSAMPLING_SECTORS         0x00u /*!< Bit SECTOR_x set converts
+                                                     the phase currents twice per
+                                                     PWM period in sector x, 0x3F
+                                                     for all sectors */
                                                                                           
 /* Torque and flux regulation loops */
 #define REGULATION_EXECUTION_RATE     2    /*!< FOC execution rate in 
                                                            number of PWM cycles */     
+/* PWM frequency policy, applied at each start while the PWM is still off.
+   The FOC rate of each setting must not exceed PWM_FREQUENCY/REGULATION_EXECUTION_RATE
+   and should be a multiple of 1 kHz */
+/* #define PWM_POLICY_ENABLED to enable it */
+#define PWM_FREQUENCY_HOT             16000 /*!< Hz, hot heatsink or winding */
+#define REGULATION_EXECUTION_RATE_HOT 2
+#define PWM_FREQUENCY_LOW_SPEED       30000 /*!< Hz, target below PWM_POLICY_LOW_SPEED_RPM */
+#define REGULATION_EXECUTION_RATE_LOW_SPEED 3
+#define PWM_POLICY_HOT_HEATSINK_C     70
+#define PWM_POLICY_HOT_WINDING_C      100
+#define PWM_POLICY_HYSTERESIS_C       10
+#define PWM_POLICY_LOW_SPEED_RPM      600
 /* Gains values for torque and flux control loops */
 #define PID_TORQUE_KP_DEFAULT         100		//2755       
 #define PID_TORQUE_KI_DEFAULT         1			//2959
@@ -241,6 +257,15 @@
 #define TF_KIDIV                      2048
 #define TF_KDDIV                      8192
 #define TFDIFFERENTIAL_TERM_ENABLING  DISABLE
+/* Deadbeat predictive current control in place of the torque and flux PI,
+   it uses RS, LS and MOTOR_VOLTAGE_CONSTANT */
+/* #define DEADBEAT_CURR_CTRL_ENABLED to enable it */
+#define DBC_DEADBEAT_GAIN             0.8  /*!< Share of the current error corrected
+                                                in one FOC period, 1.0 is pure deadbeat */
+/* Inverse Park at the mean angle of the voltage application: the angle is
+   advanced by the electrical speed times the delay up to the PWM update,
+   measured on TIM1, plus half a FOC period */
+#define ANGLE_DELAY_COMPENSATION
 
 /* Speed control loop */ 
 #define SPEED_LOOP_FREQUENCY_HZ       500 /*!<Execution rate of speed   
@@ -257,6 +282,42 @@
 
 /* USER CODE END PID_SPEED_INTEGRAL_INIT_DIV */
 
+/* Load torque observer, its estimate is added to the speed PI output */
+#define LTO_BANDWIDTH_HZ              20   /*!< Observer bandwidth, it must be
+                                                below SPEED_LOOP_FREQUENCY_HZ/12 */
+#define LTO_FEEDFORWARD_GAIN          1.0  /*!< Share of the estimate fed forward,
+                                                0 disables the feed forward */
+
+/* Resonance filters between the speed PI output and the Iq reference.
+   Type is NF_BYPASS, NF_NOTCH or NF_LOWPASS, the frequency must be below
+   SPEED_LOOP_FREQUENCY_HZ/2, Q is given multiplied by 10 */
+#define SPD_FILTER1_TYPE              NF_BYPASS
+#define SPD_FILTER1_FREQ_HZ           0
+#define SPD_FILTER1_Q10               20
+#define SPD_FILTER2_TYPE              NF_BYPASS
+#define SPD_FILTER2_FREQ_HZ           0
+#define SPD_FILTER2_Q10               7
+/* Automatic notch search on the speed error, it retunes filter 1 */
+#define SPD_NOTCH_SEARCH              false
+#define SPD_NOTCH_SEARCH_MIN_HZ       20
+#define SPD_NOTCH_SEARCH_RATIO        16   /*!< Peak over mean bin power, white
+                                                noise exceeds 8 in 1.5 % of the scans */
+
+/* Online minimum loss search: at steady speed the Id reference is stepped and
+   kept where the measured motor power is lowest, one point per speed band */
+#define LOSS_MIN_CTRL_ENABLED
+#define LMC_ID_STEP                   274  /*!< Id perturbation, s16A */
+#define LMC_ID_MIN                    -6851 /*!< Most negative Id reference, s16A */
+#define LMC_SETTLE_MS                 200  /*!< Wait after an Id step */
+#define LMC_AVERAGE_MS                1000 /*!< Power averaging window */
+#define LMC_HOLD_WINDOWS              10   /*!< Windows the minimum is kept
+                                                before it is searched again */
+#define LMC_MIN_GAIN_DW               2    /*!< Power reduction a step must bring,
+                                                tenth of watt */
+#define LMC_SPEED_TOLERANCE_RPM       30   /*!< Speed error seen as steady */
+#define LMC_IQ_TOLERANCE              500  /*!< Iq variation seen as a load change,
+                                                s16A */
+
 #define SPD_DIFFERENTIAL_TERM_ENABLING DISABLE
 
 /* Default settings */
@@ -278,6 +339,26 @@
                                                          TURN_ON_LOW_SIDES */
 #define R_BRAKE_SWITCH_OFF_THRES_V      29
 
+/* DC link regulation while braking. As the bus rises the brake resistor is
+   driven from R_BRAKE_SWITCH_OFF_THRES_V (only with TURN_ON_R_BRAKE, mapped on
+   R_BRAKE_GPIO_PORT/PIN), a negative Id is injected from REGEN_ID_START_V and
+   the regenerative Iq is limited to hold REGEN_VBUS_REF_V. All thresholds must
+   be above the highest supply voltage and below OV_VOLTAGE_THRESHOLD_V */
+#define REGEN_BRAKE_CTRL_ENABLED
+#define REGEN_ID_START_V                30
+#define REGEN_VBUS_REF_V                33
+#define REGEN_ID_MAX                    20554 /*!< Id injected from REGEN_VBUS_REF_V,
+                                                   s16A */
+#define PID_REGEN_KP_DEFAULT            160  /*!< Full regenerative Iq from about
+                                                  3 V below REGEN_VBUS_REF_V */
+#define PID_REGEN_KI_DEFAULT            0    /*!< Below REGEN_VBUS_REF_V the error is
+                                                  positive, an integral only winds up */
+#define PID_REGEN_KD_DEFAULT            320  /*!< Acts on the bus voltage slope,
+                                                  it anticipates the limit */
+#define REGEN_KPDIV                     16
+#define REGEN_KIDIV                     16
+#define REGEN_KDDIV                     16
+
 #define OV_TEMPERATURE_PROT_ENABLING    ENABLE
 #define OV_TEMPERATURE_THRESHOLD_C      70 /*!< Celsius degrees */
 #define OV_TEMPERATURE_HYSTERESIS_C     5 /*!< Celsius degrees */
@@ -404,6 +485,10 @@
 #define SERIAL_COM_CHANNEL1              MC_PROTOCOL_REG_I_A
 #define SERIAL_COM_CHANNEL2              MC_PROTOCOL_REG_I_A
 #define SERIAL_COM_MOTOR                 0
+/* Zero delimited COBS frames with CRC-16 and sequence numbers on the serial
+   link. Off by default, the Motor Control Workbench expects its own framing.
+   Host test on a pty: make serialtest in CANopen301 */
+/* #define SERIAL_COM_COBS_LINK */
 
 /* ##@@_USER_CODE_START_##@@ */
 
@@ -43,11 +43,18 @@
   *
   ******************************************************************************
   */ 
+#include "parameters_conversion.h"
 #include "pid_regulator.h"
 #include "revup_ctrl.h"
 #include "speed_torq_ctrl.h"
 #include "virtual_speed_sensor.h"
 #include "ntc_temperature_sensor.h"
+#include "thermal_model.h"
+#include "load_torque_observer.h"
+#include "notch_filter.h"
+#include "loss_min_ctrl.h"
+#include "deadbeat_curr_ctrl.h"
+#include "regen_brake_ctrl.h"
 #include "pwm_curr_fdbk.h"
 #include "r_divider_bus_voltage_sensor.h"
 #include "virtual_bus_voltage_sensor.h"
@@ -62,6 +69,7 @@
 #include "ramp_ext_mngr.h"
 #include "circle_limitation.h"
 #include "usart_frame_communication_protocol.h"
+#include "cobs_frame_communication_protocol.h"
 extern PID_Handle_t PIDSpeedHandle_M1;
 extern PID_Handle_t PIDIqHandle_M1;
 extern PID_Handle_t PIDIdHandle_M1;
@@ -73,6 +81,16 @@ extern PQD_MotorPowMeas_Handle_t *pPQD_MotorPowMeasM1;
 extern HALL_Handle_t HALL_M1;
 
 extern NTC_Handle_t TempSensorParamsM1;
+extern TM_Handle_t ThermalModelM1;
+extern LTO_Handle_t LoadTorqueObsM1;
+extern NF_Handle_t NotchFilterM1;
+extern LMC_Handle_t LossMinCtrlM1;
+extern DBC_Handle_t DeadbeatCurrCtrlM1;
+extern PID_Handle_t PIDRegenHandle_M1;
+extern RBC_Handle_t RegenBrakeCtrlM1;
+#if (ON_OVER_VOLTAGE == TURN_ON_R_BRAKE)
+extern DOUT_handle_t R_BrakeParamsM1;
+#endif
 
 extern RDivider_Handle_t RealBusVoltageSensorParamsM1;
 extern CircleLimitation_Handle_t CircleLimitationM1;
@@ -80,5 +98,9 @@ extern UI_Handle_t UI_Params;
 
 extern RampExtMngr_Handle_t RampExtMngrHFParamsM1;
 
+#ifdef SERIAL_COM_COBS_LINK
+extern CFCP_Handle_t pUSART;
+#else
 extern UFCP_Handle_t pUSART;
+#endif
 /******************* (C) COPYRIGHT 2018 STMicroelectronics *****END OF FILE****/
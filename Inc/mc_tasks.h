@@ -122,6 +122,16 @@ void TSK_DualDriveFIFOUpdate(void *oDrive);
   */
 void TSK_HardwareFaultTask(void);
 
+/**
+  * @brief  It changes the PWM frequency and the FOC execution rate of a drive
+  *         while it is idle, see mc_tasks.c
+  * @param  bMotor related motor it can be M1 or M2
+  * @param  hPWMFrequencyHz new PWM frequency in Hz
+  * @param  bRegulationRate new FOC execution rate in number of PWM cycles
+  * @retval bool true if the new rate is applied
+  */
+bool FOC_SetPWMFrequency(uint8_t bMotor, uint16_t hPWMFrequencyHz, uint8_t bRegulationRate);
+
  /**
   * @brief  This function locks GPIO pins used for Motor Control. This prevents accidental reconfiguration 
   *
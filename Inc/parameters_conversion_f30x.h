@@ -78,6 +78,7 @@
 
 #define INRUSH_CURRLIMIT_DELAY_COUNTS  (uint16_t)(INRUSH_CURRLIMIT_DELAY_MS * \
                                   ((uint16_t)SPEED_LOOP_FREQUENCY_HZ)/1000u -1u)
+#define LMC_SPEED_TOLERANCE_01HZ    (int16_t)(LMC_SPEED_TOLERANCE_RPM/6u)
 #define SYS_TICK_FREQUENCY          2000
 #define UI_TASK_FREQUENCY_HZ        10
 #define SERIAL_COM_TIMEOUT_INVERSE  25
@@ -126,6 +127,12 @@
 #define UNDERVOLTAGE_THRESHOLD_d  (uint16_t)((UD_VOLTAGE_THRESHOLD_V*65535)/\
                                   ((uint16_t)(MCU_SUPPLY_VOLTAGE/\
                                                            BUS_ADC_CONV_RATIO)))
+#define REGEN_VBUS_REF_d          (uint16_t)(REGEN_VBUS_REF_V*65535/\
+                                  (MCU_SUPPLY_VOLTAGE/VBUS_PARTITIONING_FACTOR))
+#define REGEN_ID_START_d          (uint16_t)(REGEN_ID_START_V*65535/\
+                                  (MCU_SUPPLY_VOLTAGE/VBUS_PARTITIONING_FACTOR))
+#define R_BRAKE_SWITCH_OFF_THRES_d (uint16_t)(R_BRAKE_SWITCH_OFF_THRES_V*65535/\
+                                  (MCU_SUPPLY_VOLTAGE/VBUS_PARTITIONING_FACTOR))
 #define INT_SUPPLY_VOLTAGE          (uint16_t)(65536/MCU_SUPPLY_VOLTAGE)
 
 #define DELTA_TEMP_THRESHOLD        (OV_TEMPERATURE_THRESHOLD_C- T0_C)
@@ -339,6 +346,7 @@
 
 #define ADC_CONV_NB_CK 13u
 #define TW_BEFORE_R3_1 (((uint16_t)(((((uint16_t)(SAMPLING_TIME_NS * 2)))*ADV_TIM_CLK_MHz)/1000ul))+ 1u + ADC_CONV_NB_CK)
+#define TW_OVERSAMPLING_R3_1 TW_BEFORE_R3_1 /* conversion time of the second sample pair */
 
 #define START_INDEX     56
 #define MAX_MODULE      30800   //root(Vd^2+Vq^2) <= MAX_MODULE = 32767*94%
@@ -362,6 +370,9 @@
 #define TF_KDDIV_LOG LOG2(8192)
 #define FW_KPDIV_LOG LOG2(32768)
 #define FW_KIDIV_LOG LOG2(32768)
+#define REGEN_KPDIV_LOG LOG2(REGEN_KPDIV)
+#define REGEN_KIDIV_LOG LOG2(REGEN_KIDIV)
+#define REGEN_KDDIV_LOG LOG2(REGEN_KDDIV)
 #define PLL_KPDIV     16384
 #define PLL_KPDIV_LOG LOG2(PLL_KPDIV)
 #define PLL_KIDIV     65535
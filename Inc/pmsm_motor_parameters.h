@@ -103,6 +103,25 @@
 #define MOTOR_MAX_SPEED_RPM     5000 /*!< Maximum rated speed  */
 
 #define ID_DEMAG                -27405 /*!< Demagnetization current */
+#define BEARING_BPFO_RATIO      2.80 /*!< Bearing outer race defect frequency over
+                                          shaft frequency (7 balls, d/D = 0.2) */
+#define BEARING_BPFI_RATIO      4.20 /*!< Bearing inner race defect frequency over
+                                          shaft frequency */
+#define MOTOR_ACCEL_01HZ_S      3000 /*!< No load mechanical acceleration at
+                                          NOMINAL_CURRENT, tenth of Hz/s. Measure
+                                          it with a torque mode run up */
+
+/* Winding thermal model: NOMINAL_CURRENT is allowed as long as the estimated
+   winding temperature stays below the derating band, then the limit moves
+   towards the current the winding can sustain with the present housing
+   temperature (RATED_CURRENT at rated ambient in steady state). */
+#define RATED_CURRENT           (NOMINAL_CURRENT/2) /*!< Continuous current */
+#define WINDING_THERMAL_TAU_S   30   /*!< Winding to housing time constant, s */
+#define HOUSING_THERMAL_TAU_S   900  /*!< Housing to ambient time constant, s */
+#define WINDING_THERMAL_SHARE   0.4  /*!< Winding share of the steady state rise */
+#define WINDING_MAX_TEMP_C      120  /*!< Winding insulation limit, Celsius */
+#define RATED_AMBIENT_TEMP_C    40   /*!< Ambient of the RATED_CURRENT rating */
+#define WINDING_DERATE_BAND     0.1  /*!< Derating band, share of the rated rise */
 
 /***************** MOTOR SENSORS PARAMETERS  ******************************/
 /* Motor sensors parameters are always generated but really meaningful only
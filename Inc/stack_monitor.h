@@ -0,0 +1,83 @@
+/**
+  ******************************************************************************
+  * @file    stack_monitor.h
+  * @author  Motor Control SDK Team, ST Microelectronics
+  * @brief   Stack painting and high-water mark of the main stack, execution
+  *          cycles of the FOC interrupt.
+  *
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2018 STMicroelectronics International N.V.
+  * All rights reserved.</center></h2>
+  *
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted, provided that the following conditions are met:
+  *
+  * 1. Redistribution of source code must retain the above copyright notice,
+  *    this list of conditions and the following disclaimer.
+  * 2. Redistributions in binary form must reproduce the above copyright notice,
+  *    this list of conditions and the following disclaimer in the documentation
+  *    and/or other materials provided with the distribution.
+  * 3. Neither the name of STMicroelectronics nor the names of other
+  *    contributors to this software may be used to endorse or promote products
+  *    derived from this software without specific written permission.
+  * 4. This software, including modifications and/or derivative works of this
+  *    software, must execute solely and exclusively on microcontroller or
+  *    microprocessor devices manufactured by or for STMicroelectronics.
+  * 5. Redistribution and use of this software other than as permitted under
+  *    this license is void and will automatically terminate your rights under
+  *    this license.
+  *
+  * THIS SOFTWARE IS PROVIDED BY STMICROELECTRONICS AND CONTRIBUTORS "AS IS"
+  * AND ANY EXPRESS, IMPLIED OR STATUTORY WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+  * PARTICULAR PURPOSE AND NON-INFRINGEMENT OF THIRD PARTY INTELLECTUAL PROPERTY
+  * RIGHTS ARE DISCLAIMED TO THE FULLEST EXTENT PERMITTED BY LAW. IN NO EVENT
+  * SHALL STMICROELECTRONICS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+  * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __STACK_MONITOR_H
+#define __STACK_MONITOR_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "mc_type.h"
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Exported constants --------------------------------------------------------*/
+/* Index of the exported marks, in bytes */
+#define SMON_MARK_SIZE        0u    /*!< Painted area between .bss and the top of the stack */
+#define SMON_MARK_HIGH_WATER  1u    /*!< Deepest stack use since power on */
+#define SMON_MARKS_NBR        2u
+
+/* Index of the exported FOC interrupt cycles, measured with DWT->CYCCNT */
+#define SMON_CYCLES_LAST      0u    /*!< Last FOC interrupt */
+#define SMON_CYCLES_MAX       1u    /*!< Longest FOC interrupt since power on */
+#define SMON_CYCLES_NBR       2u
+
+/* Exported functions ------------------------------------------------------- */
+void SMON_Init(void);
+bool SMON_Process(void);
+void SMON_GetMarks(uint16_t *pMarks);
+void SMON_FocCycles(uint32_t wStart);
+void SMON_GetCycles(uint16_t *pCycles);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __STACK_MONITOR_H */
+
+/************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
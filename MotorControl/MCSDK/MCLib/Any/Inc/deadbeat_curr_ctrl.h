@@ -0,0 +1,125 @@
+/**
+  ******************************************************************************
+  * @file    deadbeat_curr_ctrl.h
+  * @author  Motor Control SDK Team, ST Microelectronics
+  * @brief   This file contains all definitions and functions prototypes for the
+  *          Deadbeat Current Controller component of the Motor Control SDK.
+  *
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2018 STMicroelectronics International N.V.
+  * All rights reserved.</center></h2>
+  *
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted, provided that the following conditions are met:
+  *
+  * 1. Redistribution of source code must retain the above copyright notice,
+  *    this list of conditions and the following disclaimer.
+  * 2. Redistributions in binary form must reproduce the above copyright notice,
+  *    this list of conditions and the following disclaimer in the documentation
+  *    and/or other materials provided with the distribution.
+  * 3. Neither the name of STMicroelectronics nor the names of other
+  *    contributors to this software may be used to endorse or promote products
+  *    derived from this software without specific written permission.
+  * 4. This software, including modifications and/or derivative works of this
+  *    software, must execute solely and exclusively on microcontroller or
+  *    microprocessor devices manufactured by or for STMicroelectronics.
+  * 5. Redistribution and use of this software other than as permitted under
+  *    this license is void and will automatically terminate your rights under
+  *    this license.
+  *
+  * THIS SOFTWARE IS PROVIDED BY STMICROELECTRONICS AND CONTRIBUTORS "AS IS"
+  * AND ANY EXPRESS, IMPLIED OR STATUTORY WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+  * PARTICULAR PURPOSE AND NON-INFRINGEMENT OF THIRD PARTY INTELLECTUAL PROPERTY
+  * RIGHTS ARE DISCLAIMED TO THE FULLEST EXTENT PERMITTED BY LAW. IN NO EVENT
+  * SHALL STMICROELECTRONICS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+  * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __DEADBEATCURRCTRL_H
+#define __DEADBEATCURRCTRL_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif /* __cplusplus */
+
+/* Includes ------------------------------------------------------------------*/
+#include "mc_type.h"
+#include "bus_voltage_sensor.h"
+
+/** @addtogroup MCSDK
+  * @{
+  */
+
+/** @addtogroup DeadbeatCurrCtrl
+  * @{
+  */
+
+/**
+  * @brief DeadbeatCurrCtrl handle definition
+  *
+  * Voltages are expressed in bus digit, that is 65536 equals the maximum
+  * measurable bus voltage, currents in s16A digit.
+  */
+typedef struct
+{
+  int32_t  wResistGain;       /**< Rs, bus digit per digit of current, Q16 format.
+                                   wResistGain = 2 * Rs * MAX_CURRENT / MAX_BUS_VOLTAGE * 65536 */
+  int32_t  wInductGainD;      /**< Ld / Ts, bus digit per digit of current, Q16 format.
+                                   wInductGainD = 2 * Ld * fFOC * MAX_CURRENT / MAX_BUS_VOLTAGE * 65536 */
+  int32_t  wInductGainQ;      /**< Lq / Ts, same scaling as wInductGainD */
+  int32_t  wBemfGain;         /**< Back-EMF, bus digit per dpp of electrical speed, Q16 format */
+  int16_t  hDeadbeatGain;     /**< Share of the current error corrected in one period, Q15
+                                   format. 32767 is pure deadbeat, lower values trade the
+                                   response time for robustness against Ls errors */
+  uint16_t hFOCFrequencyHz;   /**< FOC rate the inductance and back-EMF gains refer to */
+
+  int32_t  wInvInductGainD;   /**< 1 / wInductGainD, Q32 format, computed by DBC_Init */
+  int32_t  wInvInductGainQ;   /**< 1 / wInductGainQ, Q32 format, computed by DBC_Init */
+  int32_t  wVqApplied;        /**< q axis voltage applied during the running period, bus digit */
+  int32_t  wVdApplied;        /**< d axis voltage applied during the running period, bus digit */
+  uint16_t hBusVoltage;       /**< Bus voltage used by the last DBC_Controller call, digit */
+  BusVoltageSensor_Handle_t *pBusSensor; /**< Related bus voltage sensor */
+} DBC_Handle_t;
+
+/* Initializes the deadbeat current controller */
+void DBC_Init(DBC_Handle_t *pHandle, BusVoltageSensor_Handle_t *pBusSensor);
+
+/* Clears the controller state */
+void DBC_Clear(DBC_Handle_t *pHandle);
+
+/* Computes the Vqd that brings the currents to Iqdref at the end of the next period */
+Volt_Components DBC_Controller(DBC_Handle_t *pHandle, Curr_Components Iqdref,
+                               Curr_Components Iqd, int16_t hElSpeedDpp);
+
+/* Stores the Vqd actually applied, after the circle limitation */
+void DBC_SetAppliedVoltage(DBC_Handle_t *pHandle, Volt_Components Vqd);
+
+/* Rescales the model gains to a new FOC rate */
+void DBC_SetFOCFrequency(DBC_Handle_t *pHandle, uint16_t hFOCFrequencyHz);
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+#ifdef __cplusplus
+}
+#endif /* __cpluplus */
+
+#endif /* __DEADBEATCURRCTRL_H */
+
+/************************ (C) COPYRIGHT 2018 STMicroelectronics *****END OF FILE****/
@@ -0,0 +1,242 @@
+/**
+  ******************************************************************************
+  * @file    gap_gate_driver_ctrl.h
+  * @author  Motor Control SDK Team, ST Microelectronics
+  * @brief   This file contains all definitions and functions prototypes for the
+  *          GAP_GATE_DRIVER_CTRL component of the Motor Control SDK.
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2018 STMicroelectronics International N.V.
+  * All rights reserved.</center></h2>
+  *
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted, provided that the following conditions are met:
+  *
+  * 1. Redistribution of source code must retain the above copyright notice,
+  *    this list of conditions and the following disclaimer.
+  * 2. Redistributions in binary form must reproduce the above copyright notice,
+  *    this list of conditions and the following disclaimer in the documentation
+  *    and/or other materials provided with the distribution.
+  * 3. Neither the name of STMicroelectronics nor the names of other
+  *    contributors to this software may be used to endorse or promote products
+  *    derived from this software without specific written permission.
+  * 4. This software, including modifications and/or derivative works of this
+  *    software, must execute solely and exclusively on microcontroller or
+  *    microprocessor devices manufactured by or for STMicroelectronics.
+  * 5. Redistribution and use of this software other than as permitted under
+  *    this license is void and will automatically terminate your rights under
+  *    this license.
+  *
+  * THIS SOFTWARE IS PROVIDED BY STMICROELECTRONICS AND CONTRIBUTORS "AS IS"
+  * AND ANY EXPRESS, IMPLIED OR STATUTORY WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+  * PARTICULAR PURPOSE AND NON-INFRINGEMENT OF THIRD PARTY INTELLECTUAL PROPERTY
+  * RIGHTS ARE DISCLAIMED TO THE FULLEST EXTENT PERMITTED BY LAW. IN NO EVENT
+  * SHALL STMICROELECTRONICS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+  * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __GAP_GATE_DRIVER_CTR_H
+#define __GAP_GATE_DRIVER_CTR_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif /* __cplusplus */
+
+/* Includes ------------------------------------------------------------------*/
+#include "mc_type.h"
+
+/** @addtogroup MCSDK
+  * @{
+  */
+
+/** @addtogroup GAP_GATE_DRIVER_CTRL
+  * @{
+  */
+
+#define MAX_DEVICES_NUMBER                       7 /**< Maximum number of GAP devices of the daisy chain */
+
+/** @defgroup GAP_class_error_code GAP error codes
+  * @brief Bitfields of GAP_CheckErrors: STATUS1 in bits 23..16, STATUS2 in
+  *        bits 15..8, STATUS3 in bits 7..0, errors of the driver above.
+  * @{
+  */
+#define GAP_ERROR_CLEAR                          (uint32_t)(0x00000000)
+#define GAP_ERROR_CODE_UVLOD                     (uint32_t)(0x00000001)
+#define GAP_ERROR_CODE_OVLOD                     (uint32_t)(0x00000002)
+#define GAP_ERROR_CODE_REGERRL                   (uint32_t)(0x00000004)
+#define GAP_ERROR_CODE_SPI_ERR                   (uint32_t)(0x00000008)
+#define GAP_ERROR_CODE_DT_ERR                    (uint32_t)(0x00000010)
+#define GAP_ERROR_CODE_CFG                       (uint32_t)(0x00000020)
+#define GAP_ERROR_CODE_GATE                      (uint32_t)(0x00000100)
+#define GAP_ERROR_CODE_ASC                       (uint32_t)(0x00000200)
+#define GAP_ERROR_CODE_REGERRR                   (uint32_t)(0x00000400)
+#define GAP_ERROR_CODE_TWN                       (uint32_t)(0x00010000)
+#define GAP_ERROR_CODE_TSD                       (uint32_t)(0x00020000)
+#define GAP_ERROR_CODE_UVLOL                     (uint32_t)(0x00040000)
+#define GAP_ERROR_CODE_UVLOH                     (uint32_t)(0x00080000)
+#define GAP_ERROR_CODE_SENSE                     (uint32_t)(0x00100000)
+#define GAP_ERROR_CODE_DESAT                     (uint32_t)(0x00200000)
+#define GAP_ERROR_CODE_OVLOL                     (uint32_t)(0x00400000)
+#define GAP_ERROR_CODE_OVLOH                     (uint32_t)(0x00800000)
+#define GAP_ERROR_CODE_SPI_CRC                   (uint32_t)(0x40000000)
+#define GAP_ERROR_CODE_DEVICES_NOT_PROGRAMMABLE  (uint32_t)(0x80000000)
+/**
+  * @}
+  */
+
+/* Register bits ------------------------------------------------------------*/
+#define GAP_CFG1_CRC_SPI                         (uint8_t)(0x80)
+#define GAP_CFG1_UVLOD                           (uint8_t)(0x40)
+#define GAP_CFG1_SD_FLAG                         (uint8_t)(0x20)
+#define GAP_CFG1_DIAG_EN                         (uint8_t)(0x10)
+#define GAP_CFG1_DT_DISABLE                      (uint8_t)(0x00)
+#define GAP_CFG1_DT_250NS                        (uint8_t)(0x04)
+#define GAP_CFG1_DT_800NS                        (uint8_t)(0x08)
+#define GAP_CFG1_DT_1200NS                       (uint8_t)(0x0C)
+#define GAP_CFG1_INFILTER_DISABLE                (uint8_t)(0x00)
+#define GAP_CFG1_INFILTER_210NS                  (uint8_t)(0x01)
+#define GAP_CFG1_INFILTER_560NS                  (uint8_t)(0x02)
+#define GAP_CFG1_INFILTER_70NS                   (uint8_t)(0x03)
+
+#define GAP_CFG5_2LTO_ON_FAULT                   (uint8_t)(0x08)
+#define GAP_CFG5_CLAMP_EN                        (uint8_t)(0x04)
+#define GAP_CFG5_DESAT_EN                        (uint8_t)(0x02)
+#define GAP_CFG5_SENSE_EN                        (uint8_t)(0x01)
+
+#define GAP_STATUS1_OVLOH                        (uint8_t)(0x80)
+#define GAP_STATUS1_OVLOL                        (uint8_t)(0x40)
+#define GAP_STATUS1_DESAT                        (uint8_t)(0x20)
+#define GAP_STATUS1_SENSE                        (uint8_t)(0x10)
+#define GAP_STATUS1_UVLOH                        (uint8_t)(0x08)
+#define GAP_STATUS1_UVLOL                        (uint8_t)(0x04)
+#define GAP_STATUS1_TSD                          (uint8_t)(0x02)
+#define GAP_STATUS1_TWN                          (uint8_t)(0x01)
+
+#define GAP_STATUS2_REGERRR                      (uint8_t)(0x04)
+#define GAP_STATUS2_ASC                          (uint8_t)(0x02)
+#define GAP_STATUS2_GATE                         (uint8_t)(0x01)
+
+#define GAP_STATUS3_CFG                          (uint8_t)(0x20)
+#define GAP_STATUS3_DT_ERR                       (uint8_t)(0x10)
+#define GAP_STATUS3_SPI_ERR                      (uint8_t)(0x08)
+#define GAP_STATUS3_REGERRL                      (uint8_t)(0x04)
+#define GAP_STATUS3_OVLOD                        (uint8_t)(0x02)
+#define GAP_STATUS3_UVLOD                        (uint8_t)(0x01)
+
+#define GAP_TEST1_GOFFCHK                        (uint8_t)(0x10)
+#define GAP_TEST1_GONCHK                         (uint8_t)(0x08)
+#define GAP_TEST1_DESCHK                         (uint8_t)(0x04)
+#define GAP_TEST1_SNSCHK                         (uint8_t)(0x02)
+#define GAP_TEST1_RCHK                           (uint8_t)(0x01)
+
+/** @defgroup GAP_class_private_enum GAP registers
+  * @brief Register addresses of the GAP device
+  * @{
+  */
+typedef enum
+{
+  CFG1    = 0x0C,
+  CFG2    = 0x1D,
+  CFG3    = 0x1E,
+  CFG4    = 0x1F,
+  CFG5    = 0x19,
+  STATUS1 = 0x02,
+  STATUS2 = 0x01,
+  STATUS3 = 0x0A,
+  TEST1   = 0x11,
+  DIAG1   = 0x05,
+  DIAG2   = 0x06
+} GAP_Registers_Handle_t;
+/**
+  * @}
+  */
+
+/** @defgroup GAP_class_testModes GAP test modes
+  * @{
+  */
+typedef enum
+{
+  SENSE_RESISTOR_CHK,
+  SENSE_COMPARATOR_CHK,
+  GON_CHK,
+  GOFF_CHK,
+  DESAT_CHK
+} GAP_TestMode_t;
+/**
+  * @}
+  */
+
+/**
+  * @brief  Configuration of one GAP device, values of its registers
+  */
+typedef struct
+{
+  uint8_t CFG1;   /**< Configuration value for CFG1 register */
+  uint8_t CFG2;   /**< Configuration value for CFG2 register */
+  uint8_t CFG3;   /**< Configuration value for CFG3 register */
+  uint8_t CFG4;   /**< Configuration value for CFG4 register */
+  uint8_t CFG5;   /**< Configuration value for CFG5 register */
+  uint8_t DIAG1;  /**< Configuration value for DIAG1 register */
+  uint8_t DIAG2;  /**< Configuration value for DIAG2 register */
+} GAP_DeviceParams_Handle_t;
+
+/**
+  * @brief  Handle of the GAP component, the devices of one daisy chain.
+  *         Device 0 is the first of the chain, its SDI is driven by the MCU.
+  */
+typedef struct
+{
+  uint8_t DeviceNum;                                          /**< Number of GAP devices of the daisy chain */
+  GAP_DeviceParams_Handle_t *DeviceParams[MAX_DEVICES_NUMBER]; /**< Configuration of each device */
+  uint32_t GAP_ErrorsNow[MAX_DEVICES_NUMBER];                 /**< Errors of each device currently active */
+  uint32_t GAP_ErrorsOccurred[MAX_DEVICES_NUMBER];            /**< Errors of each device since the last GAP_FaultAck */
+  SPI_TypeDef *SPIx;                                          /**< SPI of the daisy chain */
+  GPIO_TypeDef *NCSPort;                                      /**< Port of the chip select */
+  uint16_t NCSPin;                                            /**< Pin of the chip select */
+  GPIO_TypeDef *NSDPort;                                      /**< Port of the shut down */
+  uint16_t NSDPin;                                            /**< Pin of the shut down */
+} GAP_Handle_t;
+
+/* Exported functions ------------------------------------------------------- */
+bool GAP_CheckErrors(GAP_Handle_t *pHandle, uint32_t *error_now, uint32_t *error_occurred);
+void GAP_FaultAck(GAP_Handle_t *pHandle);
+bool GAP_Configuration(GAP_Handle_t *pHandle);
+bool GAP_IsDevicesProgrammed(GAP_Handle_t *pHandle);
+bool GAP_DevicesConfiguration(GAP_Handle_t *pHandle);
+uint16_t GAP_CRCCalculate(uint8_t data, uint8_t crc_initial_value);
+bool GAP_CRCCheck(uint8_t *out, uint16_t data_in);
+void wait(uint16_t count);
+uint8_t GAP_RegMask(GAP_Registers_Handle_t reg);
+bool GAP_ReadRegs(GAP_Handle_t *pHandle, uint8_t *pDataRead, GAP_Registers_Handle_t reg);
+void GAP_StartConfig(GAP_Handle_t *pHandle);
+void GAP_StopConfig(GAP_Handle_t *pHandle);
+bool GAP_WriteRegs(GAP_Handle_t *pHandle, uint8_t *pDataWrite, GAP_Registers_Handle_t reg);
+void GAP_GlobalReset(GAP_Handle_t *pHandle);
+bool GAP_ResetStatus(GAP_Handle_t *pHandle, GAP_Registers_Handle_t reg);
+bool GAP_Test(GAP_Handle_t *pHandle, GAP_TestMode_t testMode);
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+#ifdef __cplusplus
+}
+#endif /* __cpluplus */
+
+#endif /* __GAP_GATE_DRIVER_CTR_H */
+
+/************************ (C) COPYRIGHT 2018 STMicroelectronics *****END OF FILE****/
@@ -238,6 +238,7 @@ void * HALL_TIMx_UP_IRQHandler(void *pHandleVoid);
 void * HALL_TIMx_CC_IRQHandler(void *pHandleVoid);
 void HALL_Init(HALL_Handle_t *pHandle);
 void HALL_Clear(HALL_Handle_t *pHandle);
+void HALL_SetMeasurementFrequency(HALL_Handle_t *pHandle, uint16_t hMeasurementFrequency);
 int16_t HALL_CalcElAngle(HALL_Handle_t *pHandle);
 bool HALL_CalcAvrgMecSpeed01Hz(HALL_Handle_t *pHandle, int16_t *hMecSpeed01Hz);
 
@@ -0,0 +1,118 @@
+/**
+  ******************************************************************************
+  * @file    load_torque_observer.h
+  * @author  Motor Control SDK Team, ST Microelectronics
+  * @brief   This file contains all definitions and functions prototypes for the
+  *          Load Torque Observer component of the Motor Control SDK.
+  *
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2018 STMicroelectronics International N.V.
+  * All rights reserved.</center></h2>
+  *
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted, provided that the following conditions are met:
+  *
+  * 1. Redistribution of source code must retain the above copyright notice,
+  *    this list of conditions and the following disclaimer.
+  * 2. Redistributions in binary form must reproduce the above copyright notice,
+  *    this list of conditions and the following disclaimer in the documentation
+  *    and/or other materials provided with the distribution.
+  * 3. Neither the name of STMicroelectronics nor the names of other
+  *    contributors to this software may be used to endorse or promote products
+  *    derived from this software without specific written permission.
+  * 4. This software, including modifications and/or derivative works of this
+  *    software, must execute solely and exclusively on microcontroller or
+  *    microprocessor devices manufactured by or for STMicroelectronics.
+  * 5. Redistribution and use of this software other than as permitted under
+  *    this license is void and will automatically terminate your rights under
+  *    this license.
+  *
+  * THIS SOFTWARE IS PROVIDED BY STMICROELECTRONICS AND CONTRIBUTORS "AS IS"
+  * AND ANY EXPRESS, IMPLIED OR STATUTORY WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+  * PARTICULAR PURPOSE AND NON-INFRINGEMENT OF THIRD PARTY INTELLECTUAL PROPERTY
+  * RIGHTS ARE DISCLAIMED TO THE FULLEST EXTENT PERMITTED BY LAW. IN NO EVENT
+  * SHALL STMICROELECTRONICS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+  * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __LOADTORQUEOBSERVER_H
+#define __LOADTORQUEOBSERVER_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif /* __cplusplus */
+
+/* Includes ------------------------------------------------------------------*/
+#include "mc_type.h"
+
+/** @addtogroup MCSDK
+  * @{
+  */
+
+/** @addtogroup LoadTorqueObserver
+  * @{
+  */
+
+/**
+  * @brief LoadTorqueObserver handle definition
+  */
+typedef struct
+{
+  int32_t  wAccelGain;        /**< Speed increment per call and per digit of Iq,
+                                   in tenth of mechanical Hertz, Q24 format.
+                                   wAccelGain = accel[0.1Hz/s at NOMINAL_CURRENT] * 2^24 /
+                                   (call rate[Hz] * NOMINAL_CURRENT) */
+  int16_t  hSpeedGain;        /**< Observer speed correction gain L1, Q15 format.
+                                   hSpeedGain = 2 * 2pi * bandwidth[Hz] / call rate[Hz] * 32768 */
+  int32_t  wLoadGain;         /**< Observer load correction gain L2, digit of Iq per tenth
+                                   of Hertz of speed error per call, Q8 format */
+  int16_t  hFeedForwardGain;  /**< Share of the estimate added to the Iq reference, Q15
+                                   format, 0 disables the feed forward */
+  int16_t  hMaxLoad;          /**< Saturation of the load estimate, expressed in digit */
+
+  int32_t  wSpeedEst;         /**< Estimated speed, tenth of mechanical Hertz, Q16 format */
+  int32_t  wLoadEst;          /**< Estimated load torque as Iq, expressed in digit, Q16 format */
+  bool     bFirstCall;        /**< The speed estimate is loaded from the measure */
+} LTO_Handle_t;
+
+/* Initializes the load torque observer */
+void LTO_Init(LTO_Handle_t *pHandle);
+
+/* Clears the observer state */
+void LTO_Clear(LTO_Handle_t *pHandle);
+
+/* Updates the observer with the applied Iq and the measured speed */
+int16_t LTO_CalcLoadTorque(LTO_Handle_t *pHandle, int16_t hIq, int16_t hMecSpeed01Hz);
+
+/* Returns the estimated load torque expressed as Iq digit */
+int16_t LTO_GetLoadTorque(LTO_Handle_t *pHandle);
+
+/* Returns the Iq feed forward to be added to the speed regulator output */
+int16_t LTO_GetFeedForward(LTO_Handle_t *pHandle);
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+#ifdef __cplusplus
+}
+#endif /* __cpluplus */
+
+#endif /* __LOADTORQUEOBSERVER_H */
+
+/************************ (C) COPYRIGHT 2018 STMicroelectronics *****END OF FILE****/
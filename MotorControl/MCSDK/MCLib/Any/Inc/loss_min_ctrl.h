@@ -0,0 +1,125 @@
+/**
+  ******************************************************************************
+  * @file    loss_min_ctrl.h
+  * @author  Motor Control SDK Team, ST Microelectronics
+  * @brief   This file contains all definitions and functions prototypes for the
+  *          Loss Minimization Control component of the Motor Control SDK.
+  *
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2018 STMicroelectronics International N.V.
+  * All rights reserved.</center></h2>
+  *
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted, provided that the following conditions are met:
+  *
+  * 1. Redistribution of source code must retain the above copyright notice,
+  *    this list of conditions and the following disclaimer.
+  * 2. Redistributions in binary form must reproduce the above copyright notice,
+  *    this list of conditions and the following disclaimer in the documentation
+  *    and/or other materials provided with the distribution.
+  * 3. Neither the name of STMicroelectronics nor the names of other
+  *    contributors to this software may be used to endorse or promote products
+  *    derived from this software without specific written permission.
+  * 4. This software, including modifications and/or derivative works of this
+  *    software, must execute solely and exclusively on microcontroller or
+  *    microprocessor devices manufactured by or for STMicroelectronics.
+  * 5. Redistribution and use of this software other than as permitted under
+  *    this license is void and will automatically terminate your rights under
+  *    this license.
+  *
+  * THIS SOFTWARE IS PROVIDED BY STMICROELECTRONICS AND CONTRIBUTORS "AS IS"
+  * AND ANY EXPRESS, IMPLIED OR STATUTORY WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+  * PARTICULAR PURPOSE AND NON-INFRINGEMENT OF THIRD PARTY INTELLECTUAL PROPERTY
+  * RIGHTS ARE DISCLAIMED TO THE FULLEST EXTENT PERMITTED BY LAW. IN NO EVENT
+  * SHALL STMICROELECTRONICS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+  * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __LOSSMINCTRL_H
+#define __LOSSMINCTRL_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif /* __cplusplus */
+
+/* Includes ------------------------------------------------------------------*/
+#include "mc_type.h"
+
+/** @addtogroup MCSDK
+  * @{
+  */
+
+/** @addtogroup LossMinCtrl
+  * @{
+  */
+
+#define LMC_SPEED_BANDS   8u    /**< Speed bands of the learned Id table */
+
+/**
+  * @brief LossMinCtrl handle definition
+  */
+typedef struct
+{
+  int16_t hBandIdref[LMC_SPEED_BANDS];  /**< Learned minimum loss Id per speed band, digit */
+  int16_t hIdref;                       /**< Id reference being evaluated, digit */
+  int16_t hIqStart;                     /**< Iq reference at the start of the window */
+  int32_t wPowerSum;                    /**< Power accumulated in the window, W */
+  int32_t wBestSum;                     /**< Power accumulated at hBandIdref[bBand], W */
+  uint16_t hTick;                       /**< Calls since the start of the window */
+  uint16_t hHoldCnt;                    /**< Windows left before the search resumes */
+  int8_t bDirection;                    /**< Direction of the next Id step, +1 or -1 */
+  uint8_t bBand;                        /**< Speed band being optimized */
+  uint8_t bFailures;                    /**< Consecutive steps that did not reduce the power */
+  bool bBestValid;                      /**< wBestSum holds a measure of the current point */
+
+  int16_t hIdStep;                      /**< Id perturbation, digit */
+  int16_t hIdMin;                       /**< Most negative Id reference allowed, digit */
+  uint16_t hBandWidth01Hz;              /**< Width of a speed band, tenth of Hertz */
+  uint16_t hSettleTicks;                /**< Calls waited after an Id step */
+  uint16_t hAverageTicks;               /**< Calls over which the power is accumulated */
+  uint16_t hHoldWindows;                /**< Windows the minimum is kept before the search resumes */
+  uint16_t hMinGain_dW;                 /**< Power reduction a step must bring to be kept,
+                                             tenth of watt */
+  uint16_t hIqTolerance;                /**< Iq reference variation, in digit, above which
+                                             the window is taken as a load change */
+} LMC_Handle_t;
+
+/* Initializes the learned table and the search */
+void LMC_Init(LMC_Handle_t *pHandle);
+
+/* Restarts the search, the learned table is kept */
+void LMC_Clear(LMC_Handle_t *pHandle);
+
+/* Advances the search, returns the Id reference to be applied */
+int16_t LMC_CalcIdref(LMC_Handle_t *pHandle, int16_t hMecSpeed01Hz, int16_t hIqref,
+                      int16_t hPowerW, bool bSteady);
+
+/* Returns the learned Id reference of a speed band */
+int16_t LMC_GetBandIdref(LMC_Handle_t *pHandle, uint8_t bBand);
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+#ifdef __cplusplus
+}
+#endif /* __cpluplus */
+
+#endif /* __LOSSMINCTRL_H */
+
+/************************ (C) COPYRIGHT 2018 STMicroelectronics *****END OF FILE****/
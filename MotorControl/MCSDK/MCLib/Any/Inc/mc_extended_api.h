@@ -203,6 +203,7 @@ typedef enum {
   MC_PROTOCOL_REG_SC_FOC_REP_RATE,       /* 128 */
   MC_PROTOCOL_REG_PWBDID2,               /* 129 */
   MC_PROTOCOL_REG_SC_COMPLETED,          /* 130 */
+  MC_PROTOCOL_REG_LOAD_TORQUE_EST,       /* 131 */
   MC_PROTOCOL_REG_UNDEFINED,
   /**************user add motor control command start********/
 	USER_MC_PROTOCOL_CMD_START_MOTOR   =	135,	
@@ -75,6 +75,7 @@
 #include "feed_forward_ctrl.h"
 #include "flux_weakening_ctrl.h"
 #include "state_machine.h"
+#include "load_torque_observer.h"
 
 /**
  * @addtogroup MCSDK
@@ -142,6 +143,7 @@ typedef struct
 #endif /* HFINJECTION */
   CSCC  pSCC;
   COTT  pOTT;
+  LTO_Handle_t *pLTO;
 } MCT_Handle_t;
 
 
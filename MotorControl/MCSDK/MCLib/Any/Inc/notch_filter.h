@@ -0,0 +1,150 @@
+/**
+  ******************************************************************************
+  * @file    notch_filter.h
+  * @author  Motor Control SDK Team, ST Microelectronics
+  * @brief   This file contains all definitions and functions prototypes for the
+  *          Speed Loop Notch Filter component of the Motor Control SDK.
+  *
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2018 STMicroelectronics International N.V.
+  * All rights reserved.</center></h2>
+  *
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted, provided that the following conditions are met:
+  *
+  * 1. Redistribution of source code must retain the above copyright notice,
+  *    this list of conditions and the following disclaimer.
+  * 2. Redistributions in binary form must reproduce the above copyright notice,
+  *    this list of conditions and the following disclaimer in the documentation
+  *    and/or other materials provided with the distribution.
+  * 3. Neither the name of STMicroelectronics nor the names of other
+  *    contributors to this software may be used to endorse or promote products
+  *    derived from this software without specific written permission.
+  * 4. This software, including modifications and/or derivative works of this
+  *    software, must execute solely and exclusively on microcontroller or
+  *    microprocessor devices manufactured by or for STMicroelectronics.
+  * 5. Redistribution and use of this software other than as permitted under
+  *    this license is void and will automatically terminate your rights under
+  *    this license.
+  *
+  * THIS SOFTWARE IS PROVIDED BY STMICROELECTRONICS AND CONTRIBUTORS "AS IS"
+  * AND ANY EXPRESS, IMPLIED OR STATUTORY WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+  * PARTICULAR PURPOSE AND NON-INFRINGEMENT OF THIRD PARTY INTELLECTUAL PROPERTY
+  * RIGHTS ARE DISCLAIMED TO THE FULLEST EXTENT PERMITTED BY LAW. IN NO EVENT
+  * SHALL STMICROELECTRONICS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+  * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __NOTCHFILTER_H
+#define __NOTCHFILTER_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif /* __cplusplus */
+
+/* Includes ------------------------------------------------------------------*/
+#include "mc_type.h"
+
+/** @addtogroup MCSDK
+  * @{
+  */
+
+/** @addtogroup NotchFilter
+  * @{
+  */
+
+#define NF_MAX_STAGES   3u    /**< Biquad stages available in the chain */
+#define NF_SEARCH_LEN   128u  /**< Speed error samples analysed by the notch search */
+
+/**
+  * @brief Biquad stage type
+  */
+typedef enum
+{
+  NF_BYPASS,                  /**< Stage passes the input unchanged */
+  NF_NOTCH,                   /**< Notch centered on hFreqHz */
+  NF_LOWPASS                  /**< Second order low pass with cut-off hFreqHz */
+} NF_StageType_t;
+
+/**
+  * @brief Biquad stage configuration
+  */
+typedef struct
+{
+  NF_StageType_t bType;       /**< Stage type */
+  uint16_t hFreqHz;           /**< Notch or cut-off frequency, expressed in Hz. It must be
+                                   lower than half of hSamplingFreqHz */
+  uint16_t hQ10;              /**< Quality factor multiplied by 10 */
+} NF_Stage_t;
+
+/**
+  * @brief NotchFilter handle definition
+  */
+typedef struct
+{
+  int16_t hCoeffs[6u * NF_MAX_STAGES];         /**< {b0, 0, b1, b2, -a1, -a2} per stage, Q14.
+                                                    First member: CMSIS-DSP reads it by words */
+  int16_t hState[4u * NF_MAX_STAGES];          /**< Cascade state */
+  int16_t hSamples[NF_SEARCH_LEN];             /**< Speed error record of the notch search */
+  uint8_t bSampleIdx;                          /**< Next sample of hSamples to be written */
+  uint8_t bBin;                                /**< Next frequency bin to be evaluated */
+  uint8_t bBestBin;                            /**< Bin with the highest power so far */
+  uint64_t dBestPow;                           /**< Power of bBestBin */
+  uint64_t dSumPow;                            /**< Sum of the power of the evaluated bins */
+  uint16_t hSearchedFreqHz;                    /**< Last resonance found, 0 if none */
+
+  NF_Stage_t Stage[NF_MAX_STAGES];             /**< Stage configuration */
+  uint8_t bNumStages;                          /**< Stages used, up to NF_MAX_STAGES */
+  uint16_t hSamplingFreqHz;                    /**< Rate of NF_Filter calls, expressed in Hz */
+  bool bAutoSearch;                            /**< Enables the automatic notch search */
+  uint8_t bAutoStage;                          /**< Stage retuned by the notch search */
+  uint16_t hSearchMinHz;                       /**< Lowest frequency considered by the search */
+  uint16_t hSearchRatio;                       /**< Peak over mean bin power that is
+                                                    taken as a resonance */
+} NF_Handle_t;
+
+/* Designs the configured stages and clears the filter */
+void NF_Init(NF_Handle_t *pHandle);
+
+/* Clears the filter state and restarts the notch search */
+void NF_Clear(NF_Handle_t *pHandle);
+
+/* Changes the configuration of one stage */
+void NF_SetStage(NF_Handle_t *pHandle, uint8_t bStage, NF_StageType_t bType,
+                 uint16_t hFreqHz, uint16_t hQ10);
+
+/* Filters one sample */
+int16_t NF_Filter(NF_Handle_t *pHandle, int16_t hInput);
+
+/* Feeds the notch search with one speed error sample */
+uint16_t NF_SearchNotch(NF_Handle_t *pHandle, int16_t hSpeedError);
+
+/* Returns the last resonance frequency found by the notch search */
+uint16_t NF_GetSearchedFreq(NF_Handle_t *pHandle);
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+#ifdef __cplusplus
+}
+#endif /* __cpluplus */
+
+#endif /* __NOTCHFILTER_H */
+
+/************************ (C) COPYRIGHT 2018 STMicroelectronics *****END OF FILE****/
@@ -119,6 +119,8 @@ typedef struct PID_Handle
                                        must be 9 as 2^9 = 512 */
   int32_t   wPrevProcessVarError; /*!< previous process variable used by the
                                        derivative part of the PID component */
+  int32_t   wKiRemainder;         /*!< Remainder of the last PID_ScaleKI(), in
+                                       units of Ki times the execution rate */
 }PID_Handle_t;
 
 /*
@@ -136,6 +138,11 @@ void PID_SetKP(PID_Handle_t *pHandle, int16_t hKpGain);
  */
 void PID_SetKI(PID_Handle_t *pHandle, int16_t hKiGain);
 
+/*
+ * It rescales the Ki gain to a new execution rate
+ */
+bool PID_ScaleKI(PID_Handle_t *pHandle, uint16_t hRateHz, uint16_t hNewRateHz);
+
 /*
  *  It returns the Kp gain
  */
@@ -161,6 +168,11 @@ int16_t PID_GetDefaultKI(PID_Handle_t *pHandle);
  */
 void PID_SetIntegralTerm(PID_Handle_t *pHandle, int32_t wIntegralTermValue);
 
+/*
+ * It returns the PI integral term
+ */
+int32_t PID_GetIntegralTerm(PID_Handle_t *pHandle);
+
 /*
  * It returns the Kp gain divisor
  */
@@ -0,0 +1,126 @@
+/**
+  ******************************************************************************
+  * @file    regen_brake_ctrl.h
+  * @author  Motor Control SDK Team, ST Microelectronics
+  * @brief   This file contains all definitions and functions prototypes for the
+  *          Regenerative Brake Control component of the Motor Control SDK.
+  *
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2018 STMicroelectronics International N.V.
+  * All rights reserved.</center></h2>
+  *
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted, provided that the following conditions are met:
+  *
+  * 1. Redistribution of source code must retain the above copyright notice,
+  *    this list of conditions and the following disclaimer.
+  * 2. Redistributions in binary form must reproduce the above copyright notice,
+  *    this list of conditions and the following disclaimer in the documentation
+  *    and/or other materials provided with the distribution.
+  * 3. Neither the name of STMicroelectronics nor the names of other
+  *    contributors to this software may be used to endorse or promote products
+  *    derived from this software without specific written permission.
+  * 4. This software, including modifications and/or derivative works of this
+  *    software, must execute solely and exclusively on microcontroller or
+  *    microprocessor devices manufactured by or for STMicroelectronics.
+  * 5. Redistribution and use of this software other than as permitted under
+  *    this license is void and will automatically terminate your rights under
+  *    this license.
+  *
+  * THIS SOFTWARE IS PROVIDED BY STMICROELECTRONICS AND CONTRIBUTORS "AS IS"
+  * AND ANY EXPRESS, IMPLIED OR STATUTORY WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+  * PARTICULAR PURPOSE AND NON-INFRINGEMENT OF THIRD PARTY INTELLECTUAL PROPERTY
+  * RIGHTS ARE DISCLAIMED TO THE FULLEST EXTENT PERMITTED BY LAW. IN NO EVENT
+  * SHALL STMICROELECTRONICS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+  * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __REGENBRAKECTRL_H
+#define __REGENBRAKECTRL_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif /* __cplusplus */
+
+/* Includes ------------------------------------------------------------------*/
+#include "mc_type.h"
+#include "pid_regulator.h"
+#include "digital_output.h"
+
+/** @addtogroup MCSDK
+  * @{
+  */
+
+/** @addtogroup RegenBrakeCtrl
+  * @{
+  */
+
+/**
+  * @brief RegenBrakeCtrl handle definition
+  */
+typedef struct
+{
+  PID_Handle_t *pPIDRegen;          /**< PI on the bus voltage, its output is the
+                                         regenerative Iq allowed */
+  DOUT_handle_t *pBrakeResistor;    /**< Brake resistor output, MC_NULL if not fitted */
+  int16_t hRegenIqLimit;            /**< Regenerative Iq allowed, digit */
+  int16_t hIdBrake;                 /**< Id amplitude to be dissipated in the windings, digit */
+  uint16_t hBrakeDuty;              /**< Brake resistor duty, Q15 */
+  uint16_t hBrakeAcc;               /**< Brake resistor duty modulator, Q15 */
+  int16_t hIdSaved;                 /**< Id reference replaced by the injection */
+  int16_t hIdInjected;              /**< Id reference set by the injection */
+  bool bIdInjected;                 /**< The Id reference is the injected one */
+  bool bRegenerating;               /**< The Iq reference opposes the rotation */
+
+  uint16_t hVbusRef_d;              /**< Bus voltage held by limiting the regenerative Iq,
+                                         u16Volt */
+  uint16_t hIdStart_d;              /**< Bus voltage the Id injection starts at, u16Volt */
+  uint16_t hBrakeStart_d;           /**< Bus voltage the brake resistor starts at, u16Volt */
+  int16_t hIdBrakeMax;              /**< Id amplitude injected from hVbusRef_d, digit */
+  int16_t hMaxRegenIq;              /**< Regenerative Iq allowed below hVbusRef_d, digit */
+  int32_t wNominalSqCurr;           /**< Squared current amplitude the injection keeps
+                                         within, digit^2 */
+} RBC_Handle_t;
+
+/* Initializes the component */
+void RBC_Init(RBC_Handle_t *pHandle, PID_Handle_t *pPIDRegen, DOUT_handle_t *pBrakeResistor);
+
+/* Releases the regenerative limit and switches the brake resistor off */
+void RBC_Clear(RBC_Handle_t *pHandle);
+
+/* Updates the regenerative limit, the Id injection and the brake resistor */
+void RBC_CalcBusVoltageCtrl(RBC_Handle_t *pHandle, uint16_t hBusVoltage_d);
+
+/* Applies the regenerative limit and the Id injection to the current references */
+Curr_Components RBC_CalcCurrRef(RBC_Handle_t *pHandle, Curr_Components Iqdref,
+                                int16_t hMecSpeed01Hz);
+
+/* Returns the regenerative Iq allowed */
+int16_t RBC_GetRegenIqLimit(RBC_Handle_t *pHandle);
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+#ifdef __cplusplus
+}
+#endif /* __cpluplus */
+
+#endif /* __REGENBRAKECTRL_H */
+
+/************************ (C) COPYRIGHT 2018 STMicroelectronics *****END OF FILE****/
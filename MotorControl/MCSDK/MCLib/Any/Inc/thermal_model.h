@@ -0,0 +1,138 @@
+/**
+  ******************************************************************************
+  * @file    thermal_model.h
+  * @author  Motor Control SDK Team, ST Microelectronics
+  * @brief   This file contains all definitions and functions prototypes for the
+  *          Winding Thermal Model component of the Motor Control SDK.
+  *
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2018 STMicroelectronics International N.V.
+  * All rights reserved.</center></h2>
+  *
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted, provided that the following conditions are met:
+  *
+  * 1. Redistribution of source code must retain the above copyright notice,
+  *    this list of conditions and the following disclaimer.
+  * 2. Redistributions in binary form must reproduce the above copyright notice,
+  *    this list of conditions and the following disclaimer in the documentation
+  *    and/or other materials provided with the distribution.
+  * 3. Neither the name of STMicroelectronics nor the names of other
+  *    contributors to this software may be used to endorse or promote products
+  *    derived from this software without specific written permission.
+  * 4. This software, including modifications and/or derivative works of this
+  *    software, must execute solely and exclusively on microcontroller or
+  *    microprocessor devices manufactured by or for STMicroelectronics.
+  * 5. Redistribution and use of this software other than as permitted under
+  *    this license is void and will automatically terminate your rights under
+  *    this license.
+  *
+  * THIS SOFTWARE IS PROVIDED BY STMICROELECTRONICS AND CONTRIBUTORS "AS IS"
+  * AND ANY EXPRESS, IMPLIED OR STATUTORY WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+  * PARTICULAR PURPOSE AND NON-INFRINGEMENT OF THIRD PARTY INTELLECTUAL PROPERTY
+  * RIGHTS ARE DISCLAIMED TO THE FULLEST EXTENT PERMITTED BY LAW. IN NO EVENT
+  * SHALL STMICROELECTRONICS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+  * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __THERMALMODEL_H
+#define __THERMALMODEL_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif /* __cplusplus */
+
+/* Includes ------------------------------------------------------------------*/
+#include "mc_type.h"
+#include "ntc_temperature_sensor.h"
+
+/** @addtogroup MCSDK
+  * @{
+  */
+
+/** @addtogroup ThermalModel
+  * @{
+  */
+
+/**
+  * @brief ThermalModel handle definition
+  */
+typedef struct
+{
+  uint16_t hRatedCurrent;       /**< Current the motor can carry continuously at rated
+                                     ambient temperature, expressed in digit */
+  uint16_t hPeakCurrent;        /**< Current allowed while the thermal headroom lasts,
+                                     expressed in digit. It must be lower than IQMAX */
+  uint16_t hWindingTau_s;       /**< Thermal time constant of the winding to housing
+                                     path, expressed in s */
+  uint16_t hHousingTau_s;       /**< Thermal time constant of the housing to ambient
+                                     path, expressed in s */
+  uint16_t hWindingShare;       /**< Share of the steady state temperature rise taken
+                                     by the winding to housing path, in Q15 format */
+  int16_t  hMaxWindingTemp_C;   /**< Winding temperature the model must not exceed,
+                                     expressed in Celsius */
+  int16_t  hRatedAmbientTemp_C; /**< Ambient temperature at which hRatedCurrent is
+                                     specified, expressed in Celsius */
+  uint16_t hDerateBand;         /**< Fraction of the rated temperature rise, in Q15
+                                     format, over which the limit is moved from
+                                     hPeakCurrent to the sustainable current */
+  uint16_t hDecimation;         /**< Number of TM_CalcCurrentLimit calls per model
+                                     step. It must not exceed 64 */
+  uint16_t hMFTaskFrequencyHz;  /**< Frequency at which TM_CalcCurrentLimit is called,
+                                     expressed in Hz */
+  NTC_Handle_t *pNTC;           /**< Heat sink sensor used to calibrate the housing
+                                     node, MC_NULL if not used */
+
+  uint32_t wSumSq;              /**< Accumulated (Iq^2 + Id^2) / 64 of the current step */
+  uint16_t hCount;              /**< Number of samples in wSumSq */
+  int32_t  wWindingRise;        /**< Winding over housing temperature rise, per unit
+                                     of the rated rise, in Q24 format */
+  int32_t  wHousingRise;        /**< Housing over ambient temperature rise, per unit
+                                     of the rated rise, in Q24 format */
+  int32_t  wWindingCoeff;       /**< Model step over hWindingTau_s, in Q31 format */
+  int32_t  wHousingCoeff;       /**< Model step over hHousingTau_s, in Q31 format */
+  int32_t  wHousingRatio;       /**< (1 - hWindingShare) / hWindingShare, in Q15 format */
+  uint16_t hCurrentLimit;       /**< Latest computed current limit, expressed in digit */
+} TM_Handle_t;
+
+/* Initializes the thermal model */
+void TM_Init(TM_Handle_t *pHandle);
+
+/* Clears the thermal state: the motor is assumed at rated ambient temperature */
+void TM_Clear(TM_Handle_t *pHandle);
+
+/* Integrates the measured currents and returns the current limit */
+uint16_t TM_CalcCurrentLimit(TM_Handle_t *pHandle, Curr_Components Iqd);
+
+/* Returns the latest computed current limit expressed in digit */
+uint16_t TM_GetCurrentLimit(TM_Handle_t *pHandle);
+
+/* Returns the estimated winding temperature expressed in Celsius */
+int16_t TM_GetWindingTemp_C(TM_Handle_t *pHandle);
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+#ifdef __cplusplus
+}
+#endif /* __cpluplus */
+
+#endif /* __THERMALMODEL_H */
+
+/************************ (C) COPYRIGHT 2018 STMicroelectronics *****END OF FILE****/
@@ -83,6 +83,8 @@
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -62,6 +62,15 @@
   * @{
   */
 
+#if defined (CCMRAM)
+#if defined (__ICCARM__)
+#pragma location = ".ccmram"
+#elif defined (__CC_ARM)
+__attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
+#endif
+#endif
 /**
   * @brief Check whether Vqd.qV_Component1^2 + Vqd.qV_Component2^2 <= 32767^2
   *        and if not it applies a limitation keeping constant ratio
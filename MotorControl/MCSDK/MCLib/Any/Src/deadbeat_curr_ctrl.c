@@ -0,0 +1,251 @@
+/**
+  ******************************************************************************
+  * @file    deadbeat_curr_ctrl.c
+  * @author  Motor Control SDK Team, ST Microelectronics
+  * @brief   This file provides firmware functions that implement the features
+  *          of the Deadbeat Current Controller component of the Motor Control SDK.
+  *
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2018 STMicroelectronics International N.V.
+  * All rights reserved.</center></h2>
+  *
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted, provided that the following conditions are met:
+  *
+  * 1. Redistribution of source code must retain the above copyright notice,
+  *    this list of conditions and the following disclaimer.
+  * 2. Redistributions in binary form must reproduce the above copyright notice,
+  *    this list of conditions and the following disclaimer in the documentation
+  *    and/or other materials provided with the distribution.
+  * 3. Neither the name of STMicroelectronics nor the names of other
+  *    contributors to this software may be used to endorse or promote products
+  *    derived from this software without specific written permission.
+  * 4. This software, including modifications and/or derivative works of this
+  *    software, must execute solely and exclusively on microcontroller or
+  *    microprocessor devices manufactured by or for STMicroelectronics.
+  * 5. Redistribution and use of this software other than as permitted under
+  *    this license is void and will automatically terminate your rights under
+  *    this license.
+  *
+  * THIS SOFTWARE IS PROVIDED BY STMICROELECTRONICS AND CONTRIBUTORS "AS IS"
+  * AND ANY EXPRESS, IMPLIED OR STATUTORY WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+  * PARTICULAR PURPOSE AND NON-INFRINGEMENT OF THIRD PARTY INTELLECTUAL PROPERTY
+  * RIGHTS ARE DISCLAIMED TO THE FULLEST EXTENT PERMITTED BY LAW. IN NO EVENT
+  * SHALL STMICROELECTRONICS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+  * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "deadbeat_curr_ctrl.h"
+
+/** @addtogroup MCSDK
+  * @{
+  */
+
+/** @defgroup DeadbeatCurrCtrl Deadbeat Current Controller
+  * @brief Predictive dq current controller based on the motor model
+  *
+  * Alternative to the Iq and Id PI controllers. The stator equations
+  *
+  *   vd = Rs * id + Ld * did/dt - we * Lq * iq
+  *   vq = Rs * iq + Lq * diq/dt + we * Ld * id + we * flux
+  *
+  * are solved for the voltage that moves the currents to their reference in
+  * one FOC period. The voltage computed at period k is applied only from the
+  * next PWM update, while the one computed at period k-1 is still running. The
+  * currents at the end of the running period are therefore predicted first from
+  * the applied voltage and the model, and the new voltage is computed from the
+  * predicted currents (one step delay compensation).
+  *
+  * The voltage is computed in bus digit and then scaled by the measured bus
+  * voltage, so the gains do not depend on the DC link. Without integral action
+  * the steady state error depends on the accuracy of Rs and flux.
+  *
+  * @{
+  */
+
+/* Electrical angle in radians covered in one period: dpp * 2pi / 65536, Q16 */
+#define DBC_TWO_PI_Q12       25736
+/* Vqd digit per bus digit: sqrt(3) * 32768 */
+#define DBC_SQRT3_Q15        56756
+
+#define SATURATION_TO_S16(a)    if ((a) > 32767)                \
+                                {                               \
+                                  (a) = 32767;                  \
+                                }                               \
+                                else if ((a) < -32767)          \
+                                {                               \
+                                  (a) = -32767;                 \
+                                }                               \
+                                else                            \
+                                {}                              \
+
+/**
+  * @brief  Initializes the controller and computes the inverse of the
+  *         inductance gains.
+  * @param  pHandle: handler of the current instance of the DeadbeatCurrCtrl component
+  * @param  pBusSensor: bus voltage sensor used to scale the output voltage
+  * @retval none
+  */
+void DBC_Init(DBC_Handle_t *pHandle, BusVoltageSensor_Handle_t *pBusSensor)
+{
+  pHandle->pBusSensor = pBusSensor;
+  pHandle->wInvInductGainD = (int32_t)(((int64_t)1 << 32) / pHandle->wInductGainD);
+  pHandle->wInvInductGainQ = (int32_t)(((int64_t)1 << 32) / pHandle->wInductGainQ);
+  DBC_Clear(pHandle);
+}
+
+/**
+  * @brief  Clears the applied voltage memory, to be called before each motor
+  *         restart.
+  * @param  pHandle: handler of the current instance of the DeadbeatCurrCtrl component
+  * @retval none
+  */
+void DBC_Clear(DBC_Handle_t *pHandle)
+{
+  pHandle->wVqApplied = 0;
+  pHandle->wVdApplied = 0;
+  pHandle->hBusVoltage = VBS_GetAvBusVoltage_d(pHandle->pBusSensor);
+}
+
+#if defined (CCMRAM)
+#if defined (__ICCARM__)
+#pragma location = ".ccmram"
+#elif defined (__CC_ARM)
+__attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
+#endif
+#endif
+/**
+  * @brief  Computes the Vqd that brings the currents to Iqdref at the end of
+  *         the next FOC period. It must be called once per FOC period, in
+  *         place of the Iq and Id PI controllers.
+  * @param  pHandle: handler of the current instance of the DeadbeatCurrCtrl component
+  * @param  Iqdref: current references, expressed in digit
+  * @param  Iqd: currents measured at the beginning of the running period
+  * @param  hElSpeedDpp: electrical speed, dpp per FOC period
+  * @retval Volt_Components Vqd to be applied, before the circle limitation
+  */
+Volt_Components DBC_Controller(DBC_Handle_t *pHandle, Curr_Components Iqdref,
+                               Curr_Components Iqd, int16_t hElSpeedDpp)
+{
+  Volt_Components Vqd;
+  int32_t wTheta, wCrossD, wCrossQ, wBemf;
+  int32_t wIdPred, wIqPred, wVd, wVq, wAux;
+  uint16_t hBusVoltage = VBS_GetAvBusVoltage_d(pHandle->pBusSensor);
+
+  if (hBusVoltage == 0u)
+  {
+    hBusVoltage = 1u;
+  }
+  pHandle->hBusVoltage = hBusVoltage;
+
+  /* we * L, bus digit per digit of current, Q16 format */
+  wTheta = ((int32_t)hElSpeedDpp * DBC_TWO_PI_Q12) >> 12;
+  wCrossD = (int32_t)(((int64_t)pHandle->wInductGainD * wTheta) >> 16);
+  wCrossQ = (int32_t)(((int64_t)pHandle->wInductGainQ * wTheta) >> 16);
+  wBemf = (int32_t)(((int64_t)pHandle->wBemfGain * hElSpeedDpp) >> 16);
+
+  /* Currents at the end of the running period, from the applied voltage */
+  wAux = pHandle->wVdApplied
+       - (int32_t)(((int64_t)pHandle->wResistGain * Iqd.qI_Component2) >> 16)
+       + (int32_t)(((int64_t)wCrossQ * Iqd.qI_Component1) >> 16);
+  wIdPred = (int32_t)Iqd.qI_Component2
+          + (int32_t)(((int64_t)wAux * pHandle->wInvInductGainD) >> 16);
+
+  wAux = pHandle->wVqApplied
+       - (int32_t)(((int64_t)pHandle->wResistGain * Iqd.qI_Component1) >> 16)
+       - (int32_t)(((int64_t)wCrossD * Iqd.qI_Component2) >> 16)
+       - wBemf;
+  wIqPred = (int32_t)Iqd.qI_Component1
+          + (int32_t)(((int64_t)wAux * pHandle->wInvInductGainQ) >> 16);
+
+  /* Voltages that reach the references at the end of the next period */
+  wAux = (int32_t)(((int64_t)pHandle->wInductGainD *
+                    ((int32_t)Iqdref.qI_Component2 - wIdPred)) >> 16);
+  wVd = (int32_t)(((int64_t)wAux * pHandle->hDeadbeatGain) >> 15)
+      + (int32_t)(((int64_t)pHandle->wResistGain * wIdPred) >> 16)
+      - (int32_t)(((int64_t)wCrossQ * wIqPred) >> 16);
+
+  wAux = (int32_t)(((int64_t)pHandle->wInductGainQ *
+                    ((int32_t)Iqdref.qI_Component1 - wIqPred)) >> 16);
+  wVq = (int32_t)(((int64_t)wAux * pHandle->hDeadbeatGain) >> 15)
+      + (int32_t)(((int64_t)pHandle->wResistGain * wIqPred) >> 16)
+      + (int32_t)(((int64_t)wCrossD * wIdPred) >> 16)
+      + wBemf;
+
+  /* Bus digit to Vqd digit */
+  wVd = (int32_t)(((int64_t)wVd * DBC_SQRT3_Q15) / hBusVoltage);
+  wVq = (int32_t)(((int64_t)wVq * DBC_SQRT3_Q15) / hBusVoltage);
+
+  SATURATION_TO_S16(wVd)
+  SATURATION_TO_S16(wVq)
+
+  Vqd.qV_Component1 = (int16_t)wVq;
+  Vqd.qV_Component2 = (int16_t)wVd;
+  return (Vqd);
+}
+
+#if defined (CCMRAM)
+#if defined (__ICCARM__)
+#pragma location = ".ccmram"
+#elif defined (__CC_ARM)
+__attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
+#endif
+#endif
+/**
+  * @brief  Stores the Vqd actually applied, that is the DBC_Controller output
+  *         after the circle limitation. It is used by the prediction of the
+  *         next DBC_Controller call.
+  * @param  pHandle: handler of the current instance of the DeadbeatCurrCtrl component
+  * @param  Vqd: applied voltages, expressed in digit
+  * @retval none
+  */
+void DBC_SetAppliedVoltage(DBC_Handle_t *pHandle, Volt_Components Vqd)
+{
+  pHandle->wVqApplied = ((int32_t)Vqd.qV_Component1 * pHandle->hBusVoltage) / DBC_SQRT3_Q15;
+  pHandle->wVdApplied = ((int32_t)Vqd.qV_Component2 * pHandle->hBusVoltage) / DBC_SQRT3_Q15;
+}
+
+/**
+  * @brief  Rescales the gains that depend on the FOC period, Ld / Ts, Lq / Ts
+  *         and the back-EMF per dpp, to a new FOC rate. It must be called while
+  *         the controller is not running.
+  * @param  pHandle: handler of the current instance of the DeadbeatCurrCtrl component
+  * @param  hFOCFrequencyHz: new FOC rate in Hz
+  * @retval none
+  */
+void DBC_SetFOCFrequency(DBC_Handle_t *pHandle, uint16_t hFOCFrequencyHz)
+{
+  uint16_t hOldFrequencyHz = pHandle->hFOCFrequencyHz;
+
+  pHandle->wInductGainD = (int32_t)(((int64_t)pHandle->wInductGainD * hFOCFrequencyHz) / hOldFrequencyHz);
+  pHandle->wInductGainQ = (int32_t)(((int64_t)pHandle->wInductGainQ * hFOCFrequencyHz) / hOldFrequencyHz);
+  pHandle->wBemfGain = (int32_t)(((int64_t)pHandle->wBemfGain * hFOCFrequencyHz) / hOldFrequencyHz);
+  pHandle->wInvInductGainD = (int32_t)(((int64_t)1 << 32) / pHandle->wInductGainD);
+  pHandle->wInvInductGainQ = (int32_t)(((int64_t)1 << 32) / pHandle->wInductGainQ);
+  pHandle->hFOCFrequencyHz = hFOCFrequencyHz;
+}
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/************************ (C) COPYRIGHT 2018 STMicroelectronics *****END OF FILE****/
@@ -173,6 +173,8 @@ void FF_VqdffComputation(FF_Handle_t *pHandle, Curr_Components Iqdref,SpeednTorq
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -208,6 +210,8 @@ Volt_Components FF_VqdConditioning(FF_Handle_t *pHandle, Volt_Components Vqd)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -191,6 +191,8 @@ Curr_Components FW_CalcCurrRef(FW_Handle_t *pHandle, Curr_Components Iqdref)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
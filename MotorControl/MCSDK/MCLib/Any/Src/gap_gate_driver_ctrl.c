@@ -121,6 +121,77 @@ uint8_t dataReceived;
 volatile uint16_t wait_cnt;
 GAP_Handle_t GAP_GD_Ctrl;
 
+/* Private variables ---------------------------------------------------------*/
+
+/**
+  * @brief CRC-8 table, polynomial 0x07 (x^8 + x^2 + x + 1), MSB first.
+  */
+static const uint8_t GAP_CRC8Table[256] =
+{
+  0x00, 0x07, 0x0E, 0x09, 0x1C, 0x1B, 0x12, 0x15, 0x38, 0x3F, 0x36, 0x31, 0x24, 0x23, 0x2A, 0x2D,
+  0x70, 0x77, 0x7E, 0x79, 0x6C, 0x6B, 0x62, 0x65, 0x48, 0x4F, 0x46, 0x41, 0x54, 0x53, 0x5A, 0x5D,
+  0xE0, 0xE7, 0xEE, 0xE9, 0xFC, 0xFB, 0xF2, 0xF5, 0xD8, 0xDF, 0xD6, 0xD1, 0xC4, 0xC3, 0xCA, 0xCD,
+  0x90, 0x97, 0x9E, 0x99, 0x8C, 0x8B, 0x82, 0x85, 0xA8, 0xAF, 0xA6, 0xA1, 0xB4, 0xB3, 0xBA, 0xBD,
+  0xC7, 0xC0, 0xC9, 0xCE, 0xDB, 0xDC, 0xD5, 0xD2, 0xFF, 0xF8, 0xF1, 0xF6, 0xE3, 0xE4, 0xED, 0xEA,
+  0xB7, 0xB0, 0xB9, 0xBE, 0xAB, 0xAC, 0xA5, 0xA2, 0x8F, 0x88, 0x81, 0x86, 0x93, 0x94, 0x9D, 0x9A,
+  0x27, 0x20, 0x29, 0x2E, 0x3B, 0x3C, 0x35, 0x32, 0x1F, 0x18, 0x11, 0x16, 0x03, 0x04, 0x0D, 0x0A,
+  0x57, 0x50, 0x59, 0x5E, 0x4B, 0x4C, 0x45, 0x42, 0x6F, 0x68, 0x61, 0x66, 0x73, 0x74, 0x7D, 0x7A,
+  0x89, 0x8E, 0x87, 0x80, 0x95, 0x92, 0x9B, 0x9C, 0xB1, 0xB6, 0xBF, 0xB8, 0xAD, 0xAA, 0xA3, 0xA4,
+  0xF9, 0xFE, 0xF7, 0xF0, 0xE5, 0xE2, 0xEB, 0xEC, 0xC1, 0xC6, 0xCF, 0xC8, 0xDD, 0xDA, 0xD3, 0xD4,
+  0x69, 0x6E, 0x67, 0x60, 0x75, 0x72, 0x7B, 0x7C, 0x51, 0x56, 0x5F, 0x58, 0x4D, 0x4A, 0x43, 0x44,
+  0x19, 0x1E, 0x17, 0x10, 0x05, 0x02, 0x0B, 0x0C, 0x21, 0x26, 0x2F, 0x28, 0x3D, 0x3A, 0x33, 0x34,
+  0x4E, 0x49, 0x40, 0x47, 0x52, 0x55, 0x5C, 0x5B, 0x76, 0x71, 0x78, 0x7F, 0x6A, 0x6D, 0x64, 0x63,
+  0x3E, 0x39, 0x30, 0x37, 0x22, 0x25, 0x2C, 0x2B, 0x06, 0x01, 0x08, 0x0F, 0x1A, 0x1D, 0x14, 0x13,
+  0xAE, 0xA9, 0xA0, 0xA7, 0xB2, 0xB5, 0xBC, 0xBB, 0x96, 0x91, 0x98, 0x9F, 0x8A, 0x8D, 0x84, 0x83,
+  0xDE, 0xD9, 0xD0, 0xD7, 0xC2, 0xC5, 0xCC, 0xCB, 0xE6, 0xE1, 0xE8, 0xEF, 0xFA, 0xFD, 0xF4, 0xF3
+};
+
+/**
+  * @brief Daisy-chain frame: one 16-bit word per device, shifted out within
+  *        one chip select. Received words replace the sent ones.
+  */
+static uint16_t GAP_Frame[MAX_DEVICES_NUMBER];
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Shifts the frame through the daisy chain within one chip select.
+  *         Word 0 is sent first and ends in the last device of the chain.
+  * @param  pHandle related object of class CGAP_GDC
+  * @param  pFrame DeviceNum words to be sent, overwritten with received words.
+  * @retval none
+  */
+static void GAP_TransferFrame(GAP_Handle_t *pHandle, uint16_t *pFrame)
+{
+  uint8_t index;
+
+  GAP_CS_Activate(pHandle);
+  for (index = 0; index < pHandle->DeviceNum; index ++)
+  {
+    pFrame[index] = GAP_SPI_Send(pHandle, pFrame[index]);
+  }
+  GAP_CS_Deactivate(pHandle);
+}
+
+/**
+  * @brief  Sends the same command to every device of the daisy chain.
+  * @param  pHandle related object of class CGAP_GDC
+  * @param  cmd Command byte, CRC is appended.
+  * @retval uint16_t Sent command word, with CRC as LSB.
+  */
+static uint16_t GAP_SendCommand(GAP_Handle_t *pHandle, uint8_t cmd)
+{
+  uint8_t index;
+  uint16_t value = GAP_CRCCalculate(cmd, 0xFF);
+
+  for (index = 0; index < pHandle->DeviceNum; index ++)
+  {
+    GAP_Frame[index] = value;
+  }
+  GAP_TransferFrame(pHandle, GAP_Frame);
+  return value;
+}
+
 
 /**
   * @brief  Check errors of GAP devices
@@ -164,14 +235,21 @@ bool GAP_CheckErrors(GAP_Handle_t *pHandle, uint32_t *error_now,uint32_t *error_
     {
       errorFromDevices[index1] = (ret_read[index1] << 16);
     }
-    ret_val = GAP_ReadRegs(pHandle,ret_read,STATUS2);
+    /* A CRC error in any of the three reads fails the check */
+    if (!GAP_ReadRegs(pHandle,ret_read,STATUS2))
+    {
+      ret_val = false;
+    }
     for (index1 = 0; index1 < index2; index1 ++)
     {
       /* Clear GATE bit from STATUS2 - no error if 1 */
       ret_read[index1] &= 0xFE;
       errorFromDevices[index1] |= (ret_read[index1] << 8);
     }
-    ret_val = GAP_ReadRegs(pHandle,ret_read,STATUS3);
+    if (!GAP_ReadRegs(pHandle,ret_read,STATUS3))
+    {
+      ret_val = false;
+    }
     for (index1 = 0; index1 < index2; index1 ++)
     {
       errorFromDevices[index1] |= ret_read[index1];
@@ -197,18 +275,10 @@ bool GAP_CheckErrors(GAP_Handle_t *pHandle, uint32_t *error_now,uint32_t *error_
 void GAP_FaultAck(GAP_Handle_t *pHandle)
 {
   uint8_t index1,index2;
-  uint16_t value;
 
   GAP_SD_Activate(pHandle);
-  value = GAP_CRCCalculate(GAP_RESETSTATUS, 0xFF);
-  GAP_CS_Activate(pHandle);
+  GAP_SendCommand(pHandle, GAP_RESETSTATUS);
   index2 = pHandle->DeviceNum;
-
-  for (index1 = 0; index1 < index2; index1 ++)
-  {
-    GAP_SPI_Send(pHandle, value);
-  }
-  GAP_CS_Deactivate(pHandle);
   GAP_SD_Deactivate(pHandle);
   wait(WAITTIME);
 
@@ -425,42 +495,17 @@ bool GAP_DevicesConfiguration(GAP_Handle_t *pHandle)
   * @brief  Calculate CRC from data and create 16bit value with data as MSB and
   *         CRC as LSB.
   * @param  data 8bit value used to calculate CRC.
+  * @param  crc_initial_value CRC register before data, 0xFF for a command
+  *         word, the inverted CRC of the command word for the data words of
+  *         a write.
   * @retval uint16_t It returns the 16bit value with data as MSB and
   *         CRC as LSB.
   */
 uint16_t GAP_CRCCalculate(uint8_t data, uint8_t crc_initial_value)
 {
-  uint8_t crc = crc_initial_value;
-  uint8_t poly = 0x07;
-  uint8_t crc_temp;
-  uint8_t crctab[8];
-  uint8_t index1,index2;
-
-  uint16_t value;
-  value = data;
-  value <<= 8;
-
-  for (index2 = 0; index2 < 8; index2 ++)
-  {
-    crctab[index2] = (crc >> index2) & 0x1;
-  }
+  uint8_t crc = GAP_CRC8Table[(uint8_t)(crc_initial_value ^ data)] ^ 0xFF;
 
-  for (index2 = 0; index2 < 8; index2 ++)
-  {
-    crc_temp = (crctab[7] << 7) + (crctab[6] << 6) + (crctab[5] << 5) + (crctab[4] << 4) + (crctab[3] << 3) + (crctab[2] << 2) + (crctab[1] << 1) + (crctab[0]);
-    crctab[0] = ((data >> (7 - index2)) & 0x1 ) ^ crctab[7];
-
-    for (index1 = 1; index1 < 8; index1 ++)
-    {
-      crctab[index1] = (crctab[0] & ((poly >> index1) & 0x1)) ^ ((crc_temp >> (index1 - 1)) & 0x1);
-    }
-  }
-
-  crc = (crctab[7] << 7) + (crctab[6] << 6) + (crctab[5] << 5) + (crctab[4] << 4) + (crctab[3] << 3) + (crctab[2] << 2) + (crctab[1] << 1) + (crctab[0] << 0);
-  crc ^= 0xFF;
-
-  value |= crc;
-  return value;
+  return (uint16_t)(((uint16_t)data << 8) | crc);
 }
 
 /**
@@ -584,22 +629,13 @@ bool GAP_ReadRegs(GAP_Handle_t *pHandle, uint8_t *pDataRead, GAP_Registers_Handl
   bool ret_val = false;
   uint8_t index1;
   uint8_t data;
-  uint16_t value;
 
   if (pDataRead)
   {
-    value = GAP_CRCCalculate(GAP_READREG | reg, 0xFF);
-    GAP_CS_Activate(pHandle);
-
-    for (index1 = 0; index1 < pHandle->DeviceNum; index1 ++)
-    {
-      GAP_SPI_Send(pHandle, value);
-    }
-
-    GAP_CS_Deactivate(pHandle);
+    GAP_SendCommand(pHandle, GAP_READREG | reg);
     wait(WAITTIME);
-    value = GAP_CRCCalculate(GAP_NOP, 0xFF);
-    GAP_CS_Activate(pHandle);
+    /* Registers are shifted out while the chain receives NOPs */
+    GAP_SendCommand(pHandle, GAP_NOP);
 
     ret_val = true;
 
@@ -609,7 +645,7 @@ bool GAP_ReadRegs(GAP_Handle_t *pHandle, uint8_t *pDataRead, GAP_Registers_Handl
 
       if (pHandle->DeviceParams[device]->CFG1 & GAP_CFG1_CRC_SPI)
       {
-        if (GAP_CRCCheck(&data,GAP_SPI_Send(pHandle, value)))
+        if (GAP_CRCCheck(&data, GAP_Frame[index1]))
         {
           pDataRead[device] = data & GAP_RegMask(reg);
         }
@@ -623,46 +659,25 @@ bool GAP_ReadRegs(GAP_Handle_t *pHandle, uint8_t *pDataRead, GAP_Registers_Handl
       }
       else
       {
-        dataReceived = (uint8_t)(GAP_SPI_Send(pHandle, value) >> 8) & GAP_RegMask(reg);
+        dataReceived = (uint8_t)(GAP_Frame[index1] >> 8) & GAP_RegMask(reg);
         pDataRead[device] = dataReceived;
       }
     }
-    GAP_CS_Deactivate(pHandle);
   }
   return ret_val;
 }
 
 void GAP_StartConfig(GAP_Handle_t *pHandle)
 {
-  uint8_t index;
-  uint16_t value;
-
   GAP_SD_Activate(pHandle);
 
-  value = GAP_CRCCalculate(GAP_STARTCONFIG, 0xFF);
-  GAP_CS_Activate(pHandle);
-
-  for (index = 0; index < pHandle->DeviceNum; index ++)
-  {
-    GAP_SPI_Send(pHandle, value);
-  }
-  GAP_CS_Deactivate(pHandle);
+  GAP_SendCommand(pHandle, GAP_STARTCONFIG);
   wait(WAITTIME);
 }
 
 void GAP_StopConfig(GAP_Handle_t *pHandle)
 {
-  uint8_t index;
-  uint16_t value;
-
-  value = GAP_CRCCalculate(GAP_STOPCONFIG, 0xFF);
-  GAP_CS_Activate(pHandle);
-
-  for (index = 0; index < pHandle->DeviceNum; index ++)
-  {
-    GAP_SPI_Send(pHandle, value);
-  }
-  GAP_CS_Deactivate(pHandle);
+  GAP_SendCommand(pHandle, GAP_STOPCONFIG);
   wait(WAITTIME);
   GAP_SD_Deactivate(pHandle);
 }
@@ -685,29 +700,19 @@ bool GAP_WriteRegs(GAP_Handle_t *pHandle, uint8_t *pDataWrite, GAP_Registers_Han
   {
     uint8_t crc;
     uint8_t index;
-    uint16_t value;
-
-    value = GAP_CRCCalculate(GAP_WRITEREG | reg, 0xFF);
-    crc = (uint8_t)(value);
-    GAP_CS_Activate(pHandle);
 
-    for (index = 0; index < pHandle->DeviceNum; index ++)
-    {
-      GAP_SPI_Send(pHandle, value);
-    }
-    GAP_CS_Deactivate(pHandle);
+    crc = (uint8_t)GAP_SendCommand(pHandle, GAP_WRITEREG | reg);
     wait(WAITTIME);
 
-    GAP_CS_Activate(pHandle);
-    ret_val = true;
-
+    /* Data words carry the CRC continued from the command word. Word 0 ends
+       in the last device of the chain, as in GAP_ReadRegs */
     for (index = 0; index < pHandle->DeviceNum; index ++)
     {
-      value = GAP_CRCCalculate(pDataWrite[index], crc ^ 0xFF);
-      GAP_SPI_Send(pHandle, value);
+      device = pHandle->DeviceNum - index - 1;
+      GAP_Frame[index] = GAP_CRCCalculate(pDataWrite[device], crc ^ 0xFF);
     }
-
-    GAP_CS_Deactivate(pHandle);
+    GAP_TransferFrame(pHandle, GAP_Frame);
+    ret_val = true;
     wait(WAITTIME);
   }
   return ret_val;
@@ -720,17 +725,7 @@ bool GAP_WriteRegs(GAP_Handle_t *pHandle, uint8_t *pDataWrite, GAP_Registers_Han
   */
 void GAP_GlobalReset(GAP_Handle_t *pHandle)
 {
-  uint8_t index;
-  uint16_t value;
-
-  value = GAP_CRCCalculate(GAP_GLOBALRESET, 0xFF);
-  GAP_CS_Activate(pHandle);
-
-  for (index = 0; index < pHandle->DeviceNum; index ++)
-  {
-    GAP_SPI_Send(pHandle, value);
-  }
-  GAP_CS_Deactivate(pHandle);
+  GAP_SendCommand(pHandle, GAP_GLOBALRESET);
   wait(WAITTIME);
 }
 
@@ -744,16 +739,8 @@ void GAP_GlobalReset(GAP_Handle_t *pHandle)
 bool GAP_ResetStatus(GAP_Handle_t *pHandle, GAP_Registers_Handle_t reg)
 {
   bool ret_val = false;
-  uint8_t index;
-  uint16_t value;
   GAP_SD_Activate(pHandle);
-  value = GAP_CRCCalculate(GAP_RESETREG | reg, 0xFF);
-  GAP_CS_Activate(pHandle);
-  for (index = 0; index < pHandle->DeviceNum; index ++)
-  {
-    GAP_SPI_Send(pHandle, value);
-  }
-  GAP_CS_Deactivate(pHandle);
+  GAP_SendCommand(pHandle, GAP_RESETREG | reg);
   GAP_SD_Deactivate(pHandle);
   return ret_val;
 }
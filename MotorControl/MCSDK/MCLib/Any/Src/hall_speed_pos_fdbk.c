@@ -251,11 +251,31 @@ void HALL_Clear(HALL_Handle_t *pHandle)
   HALL_Init_Electrical_Angle(pHandle);
 }
 
+/**
+* @brief  Changes the frequency of the HALL_CalcElAngle calls, that is the FOC
+*         rate, and the conversion factors depending on it.
+* @param  pHandle: handler of the current instance of the hall_speed_pos_fdbk component
+* @param  hMeasurementFrequency: new FOC rate in Hz
+* @retval none
+*/
+void HALL_SetMeasurementFrequency(HALL_Handle_t *pHandle, uint16_t hMeasurementFrequency)
+{
+  pHandle->_Super.hMeasurementFrequency = hMeasurementFrequency;
+  
+  pHandle->PseudoFreqConv = ((pHandle->TIMClockFreq / 6u) 
+                     / (pHandle->_Super.hMeasurementFrequency)) * 65536u;
+  
+  pHandle->PWMNbrPSamplingFreq = (pHandle->_Super.hMeasurementFrequency / 
+                pHandle->SpeedSamplingFreqHz) - 1u;
+}
+
 #if defined (CCMRAM)
 #if defined (__ICCARM__)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -385,6 +405,8 @@ bool HALL_CalcAvrgMecSpeed01Hz(HALL_Handle_t *pHandle, int16_t *hMecSpeed01Hz)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -666,6 +688,8 @@ void * HALL_TIMx_CC_IRQHandler(void *pHandleVoid)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -235,6 +235,8 @@ void HFI_FP_Clear(HFI_FP_Ctrl_Handle_t *pHandle)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 
@@ -279,6 +281,8 @@ Curr_Components HFI_FP_PreProcessing(HFI_FP_Ctrl_Handle_t *pHandle, Curr_Compone
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 
@@ -372,6 +376,8 @@ Volt_Components HFI_FP_VqdConditioning(HFI_FP_Ctrl_Handle_t *pHandle, Volt_Compo
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 
@@ -0,0 +1,165 @@
+/**
+  ******************************************************************************
+  * @file    load_torque_observer.c
+  * @author  Motor Control SDK Team, ST Microelectronics
+  * @brief   This file provides firmware functions that implement the features
+  *          of the Load Torque Observer component of the Motor Control SDK.
+  *
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2018 STMicroelectronics International N.V.
+  * All rights reserved.</center></h2>
+  *
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted, provided that the following conditions are met:
+  *
+  * 1. Redistribution of source code must retain the above copyright notice,
+  *    this list of conditions and the following disclaimer.
+  * 2. Redistributions in binary form must reproduce the above copyright notice,
+  *    this list of conditions and the following disclaimer in the documentation
+  *    and/or other materials provided with the distribution.
+  * 3. Neither the name of STMicroelectronics nor the names of other
+  *    contributors to this software may be used to endorse or promote products
+  *    derived from this software without specific written permission.
+  * 4. This software, including modifications and/or derivative works of this
+  *    software, must execute solely and exclusively on microcontroller or
+  *    microprocessor devices manufactured by or for STMicroelectronics.
+  * 5. Redistribution and use of this software other than as permitted under
+  *    this license is void and will automatically terminate your rights under
+  *    this license.
+  *
+  * THIS SOFTWARE IS PROVIDED BY STMICROELECTRONICS AND CONTRIBUTORS "AS IS"
+  * AND ANY EXPRESS, IMPLIED OR STATUTORY WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+  * PARTICULAR PURPOSE AND NON-INFRINGEMENT OF THIRD PARTY INTELLECTUAL PROPERTY
+  * RIGHTS ARE DISCLAIMED TO THE FULLEST EXTENT PERMITTED BY LAW. IN NO EVENT
+  * SHALL STMICROELECTRONICS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+  * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "load_torque_observer.h"
+
+/** @addtogroup MCSDK
+  * @{
+  */
+
+/** @defgroup LoadTorqueObserver Load Torque Observer
+  * @brief Estimates the load torque from the applied Iq and the measured speed
+  *
+  * The mechanical model J * dw/dt = Kt * (Iq - Iload) is driven by the applied
+  * Iq. The difference between the measured and the estimated speed corrects both
+  * the speed and the load estimate (Luenberger observer). With a double pole at
+  * the observer bandwidth w0 the gains are L1 = 2 * w0 and L2 = w0^2 / b, being b
+  * the acceleration produced by one digit of Iq.
+  *
+  * Friction is seen as part of the load. The estimate, expressed as the Iq that
+  * balances it, is added to the speed regulator output so a load step is
+  * compensated within the observer settling time instead of by the integral term.
+  *
+  * @{
+  */
+
+/**
+  * @brief  Initializes the observer.
+  * @param  pHandle: handler of the current instance of the LoadTorqueObserver component
+  * @retval none
+  */
+void LTO_Init(LTO_Handle_t *pHandle)
+{
+  LTO_Clear(pHandle);
+}
+
+/**
+  * @brief  Clears the observer state. The speed estimate is loaded from the
+  *         measure on the next LTO_CalcLoadTorque call.
+  * @param  pHandle: handler of the current instance of the LoadTorqueObserver component
+  * @retval none
+  */
+void LTO_Clear(LTO_Handle_t *pHandle)
+{
+  pHandle->wSpeedEst = 0;
+  pHandle->wLoadEst = 0;
+  pHandle->bFirstCall = true;
+}
+
+/**
+  * @brief  Advances the observer by one step. It must be called at the rate
+  *         wAccelGain and the gains were computed for, while the speed loop runs.
+  * @param  pHandle: handler of the current instance of the LoadTorqueObserver component
+  * @param  hIq: Iq applied during the last period, expressed in digit
+  * @param  hMecSpeed01Hz: measured mechanical speed, tenth of Hertz
+  * @retval int16_t Estimated load torque expressed as Iq digit
+  */
+int16_t LTO_CalcLoadTorque(LTO_Handle_t *pHandle, int16_t hIq, int16_t hMecSpeed01Hz)
+{
+  int32_t wError;
+  int32_t wLoad;
+  int32_t wMaxLoad = (int32_t)pHandle->hMaxLoad * 65536;
+
+  if (pHandle->bFirstCall)
+  {
+    pHandle->wSpeedEst = (int32_t)hMecSpeed01Hz * 65536;
+    pHandle->bFirstCall = false;
+  }
+
+  wError = (int32_t)hMecSpeed01Hz * 65536 - pHandle->wSpeedEst;
+
+  /* Model: acceleration from the torque not spent on the load */
+  wLoad = (int32_t)hIq - (pHandle->wLoadEst / 65536);
+  pHandle->wSpeedEst += (int32_t)(((int64_t)wLoad * pHandle->wAccelGain) >> 8);
+  pHandle->wSpeedEst += (int32_t)(((int64_t)wError * pHandle->hSpeedGain) >> 15);
+
+  /* A speed lower than expected means more load */
+  wLoad = pHandle->wLoadEst - (int32_t)(((int64_t)wError * pHandle->wLoadGain) >> 8);
+  if (wLoad > wMaxLoad)
+  {
+    wLoad = wMaxLoad;
+  }
+  else if (wLoad < -wMaxLoad)
+  {
+    wLoad = -wMaxLoad;
+  }
+  pHandle->wLoadEst = wLoad;
+
+  return ((int16_t)(wLoad / 65536));
+}
+
+/**
+  * @brief  Returns the load torque computed by the last LTO_CalcLoadTorque call.
+  * @param  pHandle: handler of the current instance of the LoadTorqueObserver component
+  * @retval int16_t Estimated load torque expressed as Iq digit
+  */
+int16_t LTO_GetLoadTorque(LTO_Handle_t *pHandle)
+{
+  return ((int16_t)(pHandle->wLoadEst / 65536));
+}
+
+/**
+  * @brief  Returns the Iq feed forward, that is the load estimate scaled by
+  *         hFeedForwardGain.
+  * @param  pHandle: handler of the current instance of the LoadTorqueObserver component
+  * @retval int16_t Iq feed forward expressed in digit
+  */
+int16_t LTO_GetFeedForward(LTO_Handle_t *pHandle)
+{
+  return ((int16_t)(((int64_t)pHandle->wLoadEst * pHandle->hFeedForwardGain) >> 31));
+}
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/************************ (C) COPYRIGHT 2018 STMicroelectronics *****END OF FILE****/
@@ -0,0 +1,248 @@
+/**
+  ******************************************************************************
+  * @file    loss_min_ctrl.c
+  * @author  Motor Control SDK Team, ST Microelectronics
+  * @brief   This file provides firmware functions that implement the features
+  *          of the Loss Minimization Control component of the Motor Control SDK.
+  *
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2018 STMicroelectronics International N.V.
+  * All rights reserved.</center></h2>
+  *
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted, provided that the following conditions are met:
+  *
+  * 1. Redistribution of source code must retain the above copyright notice,
+  *    this list of conditions and the following disclaimer.
+  * 2. Redistributions in binary form must reproduce the above copyright notice,
+  *    this list of conditions and the following disclaimer in the documentation
+  *    and/or other materials provided with the distribution.
+  * 3. Neither the name of STMicroelectronics nor the names of other
+  *    contributors to this software may be used to endorse or promote products
+  *    derived from this software without specific written permission.
+  * 4. This software, including modifications and/or derivative works of this
+  *    software, must execute solely and exclusively on microcontroller or
+  *    microprocessor devices manufactured by or for STMicroelectronics.
+  * 5. Redistribution and use of this software other than as permitted under
+  *    this license is void and will automatically terminate your rights under
+  *    this license.
+  *
+  * THIS SOFTWARE IS PROVIDED BY STMICROELECTRONICS AND CONTRIBUTORS "AS IS"
+  * AND ANY EXPRESS, IMPLIED OR STATUTORY WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+  * PARTICULAR PURPOSE AND NON-INFRINGEMENT OF THIRD PARTY INTELLECTUAL PROPERTY
+  * RIGHTS ARE DISCLAIMED TO THE FULLEST EXTENT PERMITTED BY LAW. IN NO EVENT
+  * SHALL STMICROELECTRONICS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+  * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "loss_min_ctrl.h"
+
+/** @addtogroup MCSDK
+  * @{
+  */
+
+/** @defgroup LossMinCtrl Loss Minimization Control
+  * @brief Online search of the Id reference that minimizes the motor power
+  *
+  * At constant speed and load the mechanical power does not depend on Id, so the
+  * measured electrical power only changes with the losses: copper losses grow
+  * with |Id|, iron losses fall with the flux weakened by a negative Id. The
+  * search steps Id by hIdStep, waits hSettleTicks, accumulates the power over
+  * hAverageTicks and keeps the step if the power fell by at least hMinGain_dW
+  * (perturb and observe). Otherwise the step is taken on the other side of the
+  * learned point; when both sides fail the minimum is bracketed and Id is held
+  * for hHoldWindows windows, then the minimum is measured again and the search
+  * resumes.
+  *
+  * One minimum is learned per speed band of hBandWidth01Hz. When the speed
+  * leaves the band, or the caller reports a non steady condition, the learned
+  * Id of the current band is applied and the window restarts. A window in which
+  * the Iq reference moved by more than hIqTolerance is discarded as a load change.
+  *
+  * @{
+  */
+
+/**
+  * @brief  Initializes the learned table and the search.
+  * @param  pHandle: handler of the current instance of the LossMinCtrl component
+  * @retval none
+  */
+void LMC_Init(LMC_Handle_t *pHandle)
+{
+  uint8_t bBand;
+
+  for (bBand = 0u; bBand < LMC_SPEED_BANDS; bBand++)
+  {
+    pHandle->hBandIdref[bBand] = 0;
+  }
+  pHandle->bBand = 0u;
+  pHandle->bDirection = -1;
+  LMC_Clear(pHandle);
+}
+
+/**
+  * @brief  Restarts the search from the learned Id of the current band. The
+  *         learned table is kept.
+  * @param  pHandle: handler of the current instance of the LossMinCtrl component
+  * @retval none
+  */
+void LMC_Clear(LMC_Handle_t *pHandle)
+{
+  pHandle->hIdref = pHandle->hBandIdref[pHandle->bBand];
+  pHandle->wPowerSum = 0;
+  pHandle->wBestSum = 0;
+  pHandle->hTick = 0u;
+  pHandle->hHoldCnt = 0u;
+  pHandle->bFailures = 0u;
+  pHandle->bBestValid = false;
+}
+
+/**
+  * @brief  Advances the search by one step. It must be called periodically, at
+  *         the rate the tick parameters were computed for.
+  * @param  pHandle: handler of the current instance of the LossMinCtrl component
+  * @param  hMecSpeed01Hz: measured mechanical speed, tenth of Hertz
+  * @param  hIqref: Iq reference applied, digit
+  * @param  hPowerW: last measured motor power, W
+  * @param  bSteady: true if the drive runs in speed mode at the target speed
+  * @retval int16_t Id reference to be applied, digit
+  */
+int16_t LMC_CalcIdref(LMC_Handle_t *pHandle, int16_t hMecSpeed01Hz, int16_t hIqref,
+                      int16_t hPowerW, bool bSteady)
+{
+  int32_t wSpeed = (hMecSpeed01Hz < 0) ? -(int32_t)hMecSpeed01Hz : (int32_t)hMecSpeed01Hz;
+  int32_t wIqDelta;
+  int32_t wMinGain;
+  int32_t wIdref;
+  uint32_t wBand = (uint32_t)wSpeed / pHandle->hBandWidth01Hz;
+
+  if (wBand >= LMC_SPEED_BANDS)
+  {
+    wBand = LMC_SPEED_BANDS - 1u;
+  }
+
+  if ((bSteady == false) || ((uint8_t)wBand != pHandle->bBand))
+  {
+    pHandle->bBand = (uint8_t)wBand;
+    LMC_Clear(pHandle);
+    return (pHandle->hIdref);
+  }
+
+  pHandle->hTick++;
+  if (pHandle->hTick <= pHandle->hSettleTicks)
+  {
+    pHandle->hIqStart = hIqref;
+    pHandle->wPowerSum = 0;
+    return (pHandle->hIdref);
+  }
+
+  pHandle->wPowerSum += hPowerW;
+  if (pHandle->hTick < (pHandle->hSettleTicks + pHandle->hAverageTicks))
+  {
+    return (pHandle->hIdref);
+  }
+
+  /* End of the window */
+  pHandle->hTick = 0u;
+  wIqDelta = (int32_t)hIqref - pHandle->hIqStart;
+  wMinGain = ((int32_t)pHandle->hMinGain_dW * pHandle->hAverageTicks) / 10;
+
+  if ((wIqDelta > pHandle->hIqTolerance) || (wIqDelta < -(int32_t)pHandle->hIqTolerance))
+  {
+    /* Load change: measure the learned point again */
+    pHandle->hIdref = pHandle->hBandIdref[pHandle->bBand];
+    pHandle->bBestValid = false;
+    return (pHandle->hIdref);
+  }
+
+  if (pHandle->bBestValid == false)
+  {
+    /* Reference measure of the learned point */
+    pHandle->wBestSum = pHandle->wPowerSum;
+    pHandle->bBestValid = true;
+  }
+  else if (pHandle->hHoldCnt > 0u)
+  {
+    pHandle->hHoldCnt--;
+    if (pHandle->hHoldCnt == 0u)
+    {
+      /* Losses drift with temperature: measure the minimum again */
+      pHandle->bBestValid = false;
+      pHandle->bFailures = 0u;
+    }
+    return (pHandle->hIdref);
+  }
+  else if ((pHandle->wBestSum - pHandle->wPowerSum) >= wMinGain)
+  {
+    pHandle->wBestSum = pHandle->wPowerSum;
+    pHandle->hBandIdref[pHandle->bBand] = pHandle->hIdref;
+    pHandle->bFailures = 0u;
+  }
+  else
+  {
+    /* No gain: the other side of the learned point is tried */
+    pHandle->bDirection = -pHandle->bDirection;
+    pHandle->bFailures++;
+    if (pHandle->bFailures >= 2u)
+    {
+      pHandle->hIdref = pHandle->hBandIdref[pHandle->bBand];
+      pHandle->hHoldCnt = pHandle->hHoldWindows;
+      if (pHandle->hHoldCnt == 0u)
+      {
+        pHandle->bBestValid = false;
+        pHandle->bFailures = 0u;
+      }
+      return (pHandle->hIdref);
+    }
+  }
+
+  /* Next step from the learned point */
+  wIdref = (int32_t)pHandle->hBandIdref[pHandle->bBand] +
+           ((int32_t)pHandle->bDirection * pHandle->hIdStep);
+  if ((wIdref > 0) || (wIdref < pHandle->hIdMin))
+  {
+    /* Limit reached, the other side is tried */
+    pHandle->bDirection = -pHandle->bDirection;
+    wIdref = (int32_t)pHandle->hBandIdref[pHandle->bBand] +
+             ((int32_t)pHandle->bDirection * pHandle->hIdStep);
+    if ((wIdref > 0) || (wIdref < pHandle->hIdMin))
+    {
+      wIdref = (int32_t)pHandle->hBandIdref[pHandle->bBand];
+    }
+  }
+  pHandle->hIdref = (int16_t)wIdref;
+
+  return (pHandle->hIdref);
+}
+
+/**
+  * @brief  Returns the learned Id reference of a speed band.
+  * @param  pHandle: handler of the current instance of the LossMinCtrl component
+  * @param  bBand: speed band, lower than LMC_SPEED_BANDS
+  * @retval int16_t Learned Id reference, digit
+  */
+int16_t LMC_GetBandIdref(LMC_Handle_t *pHandle, uint8_t bBand)
+{
+  return ((bBand < LMC_SPEED_BANDS) ? pHandle->hBandIdref[bBand] : 0);
+}
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/************************ (C) COPYRIGHT 2018 STMicroelectronics *****END OF FILE****/
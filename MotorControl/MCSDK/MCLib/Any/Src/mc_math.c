@@ -110,6 +110,8 @@ const int16_t hSin_Cos_Table[256] = SIN_COS_TABLE;
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -178,6 +180,8 @@ Curr_Components MCM_Clarke(Curr_Components Curr_Input)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -282,6 +286,8 @@ Curr_Components MCM_Park(Curr_Components Curr_Input, int16_t Theta)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -335,6 +341,8 @@ Volt_Components MCM_Rev_Park(Volt_Components Volt_Input, int16_t Theta)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -389,6 +397,8 @@ Trig_Components MCM_Trig_Functions(int16_t hAngle)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -0,0 +1,308 @@
+/**
+  ******************************************************************************
+  * @file    notch_filter.c
+  * @author  Motor Control SDK Team, ST Microelectronics
+  * @brief   This file provides firmware functions that implement the features
+  *          of the Speed Loop Notch Filter component of the Motor Control SDK.
+  *
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2018 STMicroelectronics International N.V.
+  * All rights reserved.</center></h2>
+  *
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted, provided that the following conditions are met:
+  *
+  * 1. Redistribution of source code must retain the above copyright notice,
+  *    this list of conditions and the following disclaimer.
+  * 2. Redistributions in binary form must reproduce the above copyright notice,
+  *    this list of conditions and the following disclaimer in the documentation
+  *    and/or other materials provided with the distribution.
+  * 3. Neither the name of STMicroelectronics nor the names of other
+  *    contributors to this software may be used to endorse or promote products
+  *    derived from this software without specific written permission.
+  * 4. This software, including modifications and/or derivative works of this
+  *    software, must execute solely and exclusively on microcontroller or
+  *    microprocessor devices manufactured by or for STMicroelectronics.
+  * 5. Redistribution and use of this software other than as permitted under
+  *    this license is void and will automatically terminate your rights under
+  *    this license.
+  *
+  * THIS SOFTWARE IS PROVIDED BY STMICROELECTRONICS AND CONTRIBUTORS "AS IS"
+  * AND ANY EXPRESS, IMPLIED OR STATUTORY WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+  * PARTICULAR PURPOSE AND NON-INFRINGEMENT OF THIRD PARTY INTELLECTUAL PROPERTY
+  * RIGHTS ARE DISCLAIMED TO THE FULLEST EXTENT PERMITTED BY LAW. IN NO EVENT
+  * SHALL STMICROELECTRONICS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+  * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "notch_filter.h"
+#include "mc_math.h"
+#include "arm_math.h"
+
+/** @addtogroup MCSDK
+  * @{
+  */
+
+/** @defgroup NotchFilter Speed Loop Notch Filter
+  * @brief Chain of biquad filters on the speed regulator output
+  *
+  * Up to NF_MAX_STAGES notch or low pass biquads are cascaded with the CMSIS-DSP
+  * arm_biquad_cascade_df1_q15 function. The coefficients are designed in fixed
+  * point (RBJ formulas) and stored in Q14, the cascade post shift being 1.
+  * arm_math.h is only included here: its float64_t clashes with the CANopen
+  * driver one in the application files.
+  *
+  * The optional notch search records NF_SEARCH_LEN speed error samples, then
+  * evaluates one Goertzel bin per call from hSearchMinHz up to the Nyquist
+  * frequency. If the highest bin exceeds hSearchRatio times the mean bin power,
+  * stage bAutoStage is turned into a notch on that frequency and a new record is
+  * started.
+  *
+  * @{
+  */
+
+#define NF_POST_SHIFT   1
+
+/**
+  * @brief  Designs the configured stages and clears the filter.
+  * @param  pHandle: handler of the current instance of the NotchFilter component
+  * @retval none
+  */
+void NF_Init(NF_Handle_t *pHandle)
+{
+  uint8_t bStage;
+
+  for (bStage = 0u; bStage < pHandle->bNumStages; bStage++)
+  {
+    NF_SetStage(pHandle, bStage, pHandle->Stage[bStage].bType,
+                pHandle->Stage[bStage].hFreqHz, pHandle->Stage[bStage].hQ10);
+  }
+  NF_Clear(pHandle);
+}
+
+/**
+  * @brief  Clears the filter state and restarts the notch search.
+  * @param  pHandle: handler of the current instance of the NotchFilter component
+  * @retval none
+  */
+void NF_Clear(NF_Handle_t *pHandle)
+{
+  uint8_t bIdx;
+
+  for (bIdx = 0u; bIdx < (4u * NF_MAX_STAGES); bIdx++)
+  {
+    pHandle->hState[bIdx] = 0;
+  }
+  pHandle->bSampleIdx = 0u;
+  pHandle->bBin = 0u;
+  pHandle->bBestBin = 0u;
+  pHandle->dBestPow = 0u;
+  pHandle->dSumPow = 0u;
+}
+
+/**
+  * @brief  Changes the configuration of one stage and recomputes its
+  *         coefficients. It can be called while the filter runs.
+  * @param  pHandle: handler of the current instance of the NotchFilter component
+  * @param  bStage: stage index, lower than bNumStages
+  * @param  bType: stage type
+  * @param  hFreqHz: notch or cut-off frequency, expressed in Hz
+  * @param  hQ10: quality factor multiplied by 10
+  * @retval none
+  */
+void NF_SetStage(NF_Handle_t *pHandle, uint8_t bStage, NF_StageType_t bType,
+                 uint16_t hFreqHz, uint16_t hQ10)
+{
+  int16_t *pCoeff = &pHandle->hCoeffs[6u * bStage];
+  Trig_Components Trig;
+  int32_t wCos;
+  int32_t wAlpha;
+  int32_t wA0;
+  int32_t wB0;
+  int32_t wB1;
+
+  if (bStage >= pHandle->bNumStages)
+  {
+    return;
+  }
+  if ((2u * (uint32_t)hFreqHz >= pHandle->hSamplingFreqHz) || (hFreqHz == 0u) || (hQ10 == 0u))
+  {
+    bType = NF_BYPASS;
+  }
+  pHandle->Stage[bStage].bType = bType;
+  pHandle->Stage[bStage].hFreqHz = hFreqHz;
+  pHandle->Stage[bStage].hQ10 = hQ10;
+
+  if (bType == NF_BYPASS)
+  {
+    pCoeff[0] = 16384;
+    pCoeff[1] = 0;
+    pCoeff[2] = 0;
+    pCoeff[3] = 0;
+    pCoeff[4] = 0;
+    pCoeff[5] = 0;
+    return;
+  }
+
+  /* w0 = 2pi * f / fs as s16degree */
+  Trig = MCM_Trig_Functions((int16_t)(((uint32_t)hFreqHz * 65536u) / pHandle->hSamplingFreqHz));
+  wCos = Trig.hCos;
+  wAlpha = ((int32_t)Trig.hSin * 5) / (int32_t)hQ10;     /* sin(w0) / (2 * Q) */
+  wA0 = 32768 + wAlpha;
+
+  if (bType == NF_NOTCH)
+  {
+    wB0 = 32768;
+    wB1 = -2 * wCos;
+  }
+  else
+  {
+    wB0 = (32768 - wCos) / 2;
+    wB1 = 32768 - wCos;
+  }
+
+  /* Normalized by a0, Q14; CMSIS expects the feedback coefficients negated */
+  pCoeff[0] = (int16_t)((wB0 * 16384) / wA0);
+  pCoeff[1] = 0;
+  pCoeff[2] = (int16_t)((wB1 * 16384) / wA0);
+  pCoeff[3] = pCoeff[0];
+  pCoeff[4] = (int16_t)((2 * wCos * 16384) / wA0);
+  pCoeff[5] = (int16_t)(((wAlpha - 32768) * 16384) / wA0);
+}
+
+/**
+  * @brief  Filters one sample through the stage chain.
+  * @param  pHandle: handler of the current instance of the NotchFilter component
+  * @param  hInput: sample to be filtered
+  * @retval int16_t Filtered sample
+  */
+int16_t NF_Filter(NF_Handle_t *pHandle, int16_t hInput)
+{
+  arm_biquad_casd_df1_inst_q15 Biquad;
+  q15_t hOutput;
+
+  Biquad.numStages = pHandle->bNumStages;
+  Biquad.pState = pHandle->hState;
+  Biquad.pCoeffs = pHandle->hCoeffs;
+  Biquad.postShift = NF_POST_SHIFT;
+  arm_biquad_cascade_df1_q15(&Biquad, &hInput, &hOutput, 1u);
+  return (hOutput);
+}
+
+/**
+  * @brief  Feeds the notch search with one speed error sample. It must be
+  *         called at hSamplingFreqHz and does nothing if bAutoSearch is false.
+  *         One Goertzel bin is evaluated per call once the record is full.
+  * @param  pHandle: handler of the current instance of the NotchFilter component
+  * @param  hSpeedError: speed reference minus measured speed
+  * @retval uint16_t Resonance frequency set on bAutoStage by this call,
+  *         expressed in Hz, 0 otherwise
+  */
+uint16_t NF_SearchNotch(NF_Handle_t *pHandle, int16_t hSpeedError)
+{
+  uint16_t hFound = 0u;
+  uint8_t bMinBin;
+  uint8_t bIdx;
+  int32_t wCoeff;
+  int32_t wS0;
+  int32_t wS1 = 0;
+  int32_t wS2 = 0;
+  int64_t dPow;
+
+  if (!pHandle->bAutoSearch)
+  {
+    return (0u);
+  }
+
+  if (pHandle->bSampleIdx < NF_SEARCH_LEN)
+  {
+    pHandle->hSamples[pHandle->bSampleIdx] = hSpeedError;
+    pHandle->bSampleIdx++;
+    return (0u);
+  }
+
+  bMinBin = (uint8_t)(((uint32_t)pHandle->hSearchMinHz * NF_SEARCH_LEN) / pHandle->hSamplingFreqHz);
+  if (bMinBin == 0u)
+  {
+    bMinBin = 1u;
+  }
+  if (pHandle->bBin < bMinBin)
+  {
+    pHandle->bBin = bMinBin;
+  }
+
+  /* Goertzel power of bin bBin, coefficient 2 * cos(2pi * k / N) in Q14 */
+  wCoeff = (int32_t)MCM_Trig_Functions((int16_t)((uint32_t)pHandle->bBin * (65536u / NF_SEARCH_LEN))).hCos;
+  for (bIdx = 0u; bIdx < NF_SEARCH_LEN; bIdx++)
+  {
+    wS0 = (int32_t)pHandle->hSamples[bIdx] + ((wCoeff * wS1) >> 14) - wS2;
+    wS2 = wS1;
+    wS1 = wS0;
+  }
+  /* Kept in full: speed errors of a few digit give powers of a few 10^4 */
+  dPow = (int64_t)wS1 * wS1 + (int64_t)wS2 * wS2 - ((((int64_t)wCoeff * wS1) >> 14) * wS2);
+  if (dPow < 0)
+  {
+    dPow = 0;
+  }
+
+  pHandle->dSumPow += (uint64_t)dPow;
+  if ((uint64_t)dPow > pHandle->dBestPow)
+  {
+    pHandle->dBestPow = (uint64_t)dPow;
+    pHandle->bBestBin = pHandle->bBin;
+  }
+  pHandle->bBin++;
+
+  if (pHandle->bBin >= (NF_SEARCH_LEN / 2u))
+  {
+    /* Scan completed: peak over the mean of the evaluated bins */
+    if ((pHandle->dBestPow > 0u) &&
+        ((pHandle->dBestPow * (pHandle->bBin - bMinBin)) / pHandle->hSearchRatio >
+         pHandle->dSumPow))
+    {
+      hFound = (uint16_t)(((uint32_t)pHandle->bBestBin * pHandle->hSamplingFreqHz) / NF_SEARCH_LEN);
+      NF_SetStage(pHandle, pHandle->bAutoStage, NF_NOTCH, hFound,
+                  pHandle->Stage[pHandle->bAutoStage].hQ10);
+      pHandle->hSearchedFreqHz = hFound;
+    }
+    pHandle->bSampleIdx = 0u;
+    pHandle->bBin = 0u;
+    pHandle->bBestBin = 0u;
+    pHandle->dBestPow = 0u;
+    pHandle->dSumPow = 0u;
+  }
+
+  return (hFound);
+}
+
+/**
+  * @brief  Returns the last resonance frequency found by the notch search.
+  * @param  pHandle: handler of the current instance of the NotchFilter component
+  * @retval uint16_t Frequency expressed in Hz, 0 if none was found
+  */
+uint16_t NF_GetSearchedFreq(NF_Handle_t *pHandle)
+{
+  return (pHandle->hSearchedFreqHz);
+}
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/************************ (C) COPYRIGHT 2018 STMicroelectronics *****END OF FILE****/
@@ -98,6 +98,7 @@ void PID_HandleInit(PID_Handle_t *pHandle)
   pHandle->hKdGain =  pHandle->hDefKdGain;
   pHandle->wIntegralTerm = 0x00000000UL;
   pHandle->wPrevProcessVarError = 0x00000000UL;
+  pHandle->wKiRemainder = 0;
 }
 
 /**
@@ -120,6 +121,33 @@ void PID_SetKP(PID_Handle_t *pHandle, int16_t hKpGain)
 void PID_SetKI(PID_Handle_t *pHandle, int16_t hKiGain)
 {
   pHandle->hKiGain = hKiGain;
+  pHandle->wKiRemainder = 0;
+}
+
+/**
+ * @brief  It rescales the Ki gain to a new execution rate of the regulator.
+ *         Ki is the integral gain times the sampling time, so Ki times the
+ *         rate is kept, whatever gain is in use. The remainder of the
+ *         division is kept and added back at the next rescale, so changing
+ *         the rate back and forth gives the gain back exactly.
+ * @param  pHandle: handler of the current instance of the PID component
+ * @param  hRateHz: execution rate the Ki gain in use refers to
+ * @param  hNewRateHz: new execution rate
+ * @retval bool false, and Ki unchanged, if the new gain exceeds int16_t
+ */
+bool PID_ScaleKI(PID_Handle_t *pHandle, uint16_t hRateHz, uint16_t hNewRateHz)
+{
+  int32_t wKiRate = ((int32_t)pHandle->hKiGain * (int32_t)hRateHz) + pHandle->wKiRemainder;
+  int32_t wKi = wKiRate / (int32_t)hNewRateHz;
+  bool bRetVal = false;
+
+  if ((wKi <= INT16_MAX) && (wKi >= -INT16_MAX))
+  {
+    pHandle->hKiGain = (int16_t)wKi;
+    pHandle->wKiRemainder = wKiRate - (wKi * (int32_t)hNewRateHz);
+    bRetVal = true;
+  }
+  return (bRetVal);
 }
 
 /**
@@ -175,6 +203,16 @@ void PID_SetIntegralTerm(PID_Handle_t *pHandle, int32_t wIntegralTermValue)
   return;
 }
 
+/**
+ * @brief  It returns the PI integral term
+ * pHandle: handler of the current instance of the PID component
+ * @retval int32_t integral term value
+ */
+int32_t PID_GetIntegralTerm(PID_Handle_t *pHandle)
+{
+  return (pHandle->wIntegralTerm);
+}
+
 /**
  * @brief  It returns the Kp gain divisor
  * @param  pHandle: handler of the current instance of the PID component
@@ -324,6 +362,8 @@ void PID_SetKDDivisorPOW2( PID_Handle_t *pHandle, uint16_t hKdDivisorPOW2 );
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -417,12 +457,13 @@ int16_t PI_Controller(PID_Handle_t *pHandle, int32_t wProcessVarError)
   return((int16_t)(wOutput_32));
 }
 
-#if 0
 #if defined (CCMRAM)
 #if defined (__ICCARM__)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -476,7 +517,7 @@ int16_t PID_Controller(PID_Handle_t *pHandle, int32_t wProcessVarError)
   }
   return((int16_t) wTemp_output);
 }
-#endif
+
 /**
  * @}
  */
@@ -0,0 +1,267 @@
+/**
+  ******************************************************************************
+  * @file    regen_brake_ctrl.c
+  * @author  Motor Control SDK Team, ST Microelectronics
+  * @brief   This file provides firmware functions that implement the features
+  *          of the Regenerative Brake Control component of the Motor Control SDK.
+  *
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2018 STMicroelectronics International N.V.
+  * All rights reserved.</center></h2>
+  *
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted, provided that the following conditions are met:
+  *
+  * 1. Redistribution of source code must retain the above copyright notice,
+  *    this list of conditions and the following disclaimer.
+  * 2. Redistributions in binary form must reproduce the above copyright notice,
+  *    this list of conditions and the following disclaimer in the documentation
+  *    and/or other materials provided with the distribution.
+  * 3. Neither the name of STMicroelectronics nor the names of other
+  *    contributors to this software may be used to endorse or promote products
+  *    derived from this software without specific written permission.
+  * 4. This software, including modifications and/or derivative works of this
+  *    software, must execute solely and exclusively on microcontroller or
+  *    microprocessor devices manufactured by or for STMicroelectronics.
+  * 5. Redistribution and use of this software other than as permitted under
+  *    this license is void and will automatically terminate your rights under
+  *    this license.
+  *
+  * THIS SOFTWARE IS PROVIDED BY STMICROELECTRONICS AND CONTRIBUTORS "AS IS"
+  * AND ANY EXPRESS, IMPLIED OR STATUTORY WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+  * PARTICULAR PURPOSE AND NON-INFRINGEMENT OF THIRD PARTY INTELLECTUAL PROPERTY
+  * RIGHTS ARE DISCLAIMED TO THE FULLEST EXTENT PERMITTED BY LAW. IN NO EVENT
+  * SHALL STMICROELECTRONICS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+  * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "regen_brake_ctrl.h"
+#include "mc_math.h"
+
+/** @addtogroup MCSDK
+  * @{
+  */
+
+/** @defgroup RegenBrakeCtrl Regenerative Brake Control
+  * @brief DC link voltage regulation while the motor brakes
+  *
+  * The supply cannot take back the braking energy, so it charges the DC link
+  * capacitor. Three actions are taken as the bus voltage rises:
+  * - from hBrakeStart_d the brake resistor, if fitted, is driven with a duty
+  *   proportional to the voltage, reaching 100% at hVbusRef_d. The duty is
+  *   produced by a first order modulator at the RBC_CalcBusVoltageCtrl rate;
+  * - from hIdStart_d a negative Id is injected, proportional to the voltage and
+  *   reaching hIdBrakeMax at hVbusRef_d, so that the windings dissipate more.
+  *   The current amplitude is kept within the square root of wNominalSqCurr;
+  * - a PID regulates the bus voltage at hVbusRef_d by reducing the regenerative
+  *   Iq allowed, from hMaxRegenIq down to zero. The D term acts on the voltage
+  *   slope; with a small DC link the bus rises by volts in one call, so the
+  *   limit must already fall below hVbusRef_d: a proportional band, without
+  *   integral, which below hVbusRef_d would only wind up.
+  * The resistor and the injection only act while the Iq reference opposes the
+  * rotation or the regenerative limit is engaged, so a supply above the
+  * thresholds is not loaded while the motor is driven.
+  *
+  * With the limit in place the speed ramps can be as fast as the application
+  * needs: the deceleration is slowed down only when the bus cannot absorb it.
+  *
+  * @{
+  */
+
+/**
+  * @brief  Initializes the component.
+  * @param  pHandle: handler of the current instance of the RegenBrakeCtrl component
+  * @param  pPIDRegen: PI regulator of the bus voltage. Its output limits must be
+  *         0 and hMaxRegenIq
+  * @param  pBrakeResistor: brake resistor output, MC_NULL if not fitted
+  * @retval none
+  */
+void RBC_Init(RBC_Handle_t *pHandle, PID_Handle_t *pPIDRegen, DOUT_handle_t *pBrakeResistor)
+{
+  pHandle->pPIDRegen = pPIDRegen;
+  pHandle->pBrakeResistor = pBrakeResistor;
+  PID_HandleInit(pPIDRegen);
+  RBC_Clear(pHandle);
+}
+
+/**
+  * @brief  Releases the regenerative limit and switches the brake resistor off.
+  *         It must be called when the motor is stopped.
+  * @param  pHandle: handler of the current instance of the RegenBrakeCtrl component
+  * @retval none
+  */
+void RBC_Clear(RBC_Handle_t *pHandle)
+{
+  PID_SetIntegralTerm(pHandle->pPIDRegen,
+                      (int32_t)pHandle->hMaxRegenIq * (int32_t)PID_GetKIDivisor(pHandle->pPIDRegen));
+  PID_SetPrevError(pHandle->pPIDRegen, 0);
+  pHandle->hRegenIqLimit = pHandle->hMaxRegenIq;
+  pHandle->hIdBrake = 0;
+  pHandle->hBrakeDuty = 0u;
+  pHandle->hBrakeAcc = 0u;
+  pHandle->bIdInjected = false;
+  pHandle->bRegenerating = false;
+  if (pHandle->pBrakeResistor != MC_NULL)
+  {
+    DOUT_SetOutputState(pHandle->pBrakeResistor, INACTIVE);
+  }
+}
+
+/**
+  * @brief  Updates the regenerative limit, the Id injection and the brake
+  *         resistor output. It must be called periodically while the motor runs.
+  * @param  pHandle: handler of the current instance of the RegenBrakeCtrl component
+  * @param  hBusVoltage_d: latest bus voltage measure, u16Volt
+  * @retval none
+  */
+void RBC_CalcBusVoltageCtrl(RBC_Handle_t *pHandle, uint16_t hBusVoltage_d)
+{
+  int32_t wAux;
+  DOutputState_t State = INACTIVE;
+
+  pHandle->hRegenIqLimit = PID_Controller(pHandle->pPIDRegen,
+                                          (int32_t)pHandle->hVbusRef_d - (int32_t)hBusVoltage_d);
+
+  wAux = (int32_t)hBusVoltage_d - (int32_t)pHandle->hIdStart_d;
+  if ((wAux <= 0) || (pHandle->bRegenerating == false))
+  {
+    pHandle->hIdBrake = 0;
+  }
+  else if (hBusVoltage_d >= pHandle->hVbusRef_d)
+  {
+    pHandle->hIdBrake = pHandle->hIdBrakeMax;
+  }
+  else
+  {
+    pHandle->hIdBrake = (int16_t)((wAux * pHandle->hIdBrakeMax) /
+                                  ((int32_t)pHandle->hVbusRef_d - (int32_t)pHandle->hIdStart_d));
+  }
+
+  if (pHandle->pBrakeResistor != MC_NULL)
+  {
+    wAux = (int32_t)hBusVoltage_d - (int32_t)pHandle->hBrakeStart_d;
+    if ((wAux <= 0) || (pHandle->bRegenerating == false))
+    {
+      pHandle->hBrakeDuty = 0u;
+      pHandle->hBrakeAcc = 0u;
+    }
+    else if (hBusVoltage_d >= pHandle->hVbusRef_d)
+    {
+      pHandle->hBrakeDuty = 32768u;
+    }
+    else
+    {
+      pHandle->hBrakeDuty = (uint16_t)((wAux * 32768) /
+                                       ((int32_t)pHandle->hVbusRef_d - (int32_t)pHandle->hBrakeStart_d));
+    }
+
+    pHandle->hBrakeAcc += pHandle->hBrakeDuty;
+    if (pHandle->hBrakeAcc >= 32768u)
+    {
+      pHandle->hBrakeAcc -= 32768u;
+      State = ACTIVE;
+    }
+    if (DOUT_GetOutputState(pHandle->pBrakeResistor) != State)
+    {
+      DOUT_SetOutputState(pHandle->pBrakeResistor, State);
+    }
+  }
+}
+
+/**
+  * @brief  Applies the regenerative Iq limit and the Id injection computed by
+  *         the last RBC_CalcBusVoltageCtrl call to the current references. An
+  *         injection no longer needed is removed, unless the Id reference was
+  *         changed in the meanwhile.
+  * @param  pHandle: handler of the current instance of the RegenBrakeCtrl component
+  * @param  Iqdref: current references to be applied
+  * @param  hMecSpeed01Hz: measured mechanical speed, tenth of Hertz
+  * @retval Curr_Components Limited current references
+  */
+Curr_Components RBC_CalcCurrRef(RBC_Handle_t *pHandle, Curr_Components Iqdref,
+                                int16_t hMecSpeed01Hz)
+{
+  int16_t hLimit = pHandle->hRegenIqLimit;
+  int32_t wIqSq;
+  int32_t wIdMax;
+  int32_t wIdref;
+
+  if ((hMecSpeed01Hz > 0) && (Iqdref.qI_Component1 < 0))
+  {
+    pHandle->bRegenerating = true;
+    if (Iqdref.qI_Component1 < -hLimit)
+    {
+      Iqdref.qI_Component1 = -hLimit;
+    }
+  }
+  else if ((hMecSpeed01Hz < 0) && (Iqdref.qI_Component1 > 0))
+  {
+    pHandle->bRegenerating = true;
+    if (Iqdref.qI_Component1 > hLimit)
+    {
+      Iqdref.qI_Component1 = hLimit;
+    }
+  }
+  else
+  {
+    /* The speed regulator may already be held at zero by the limit */
+    pHandle->bRegenerating = ((hMecSpeed01Hz != 0) && (hLimit < pHandle->hMaxRegenIq));
+  }
+
+  if (pHandle->bIdInjected == true)
+  {
+    if (Iqdref.qI_Component2 == pHandle->hIdInjected)
+    {
+      Iqdref.qI_Component2 = pHandle->hIdSaved;
+    }
+    pHandle->bIdInjected = false;
+  }
+
+  if (pHandle->hIdBrake > 0)
+  {
+    wIqSq = (int32_t)Iqdref.qI_Component1 * Iqdref.qI_Component1;
+    wIdMax = (pHandle->wNominalSqCurr > wIqSq) ? MCM_Sqrt(pHandle->wNominalSqCurr - wIqSq) : 0;
+    wIdref = (pHandle->hIdBrake < wIdMax) ? -(int32_t)pHandle->hIdBrake : -wIdMax;
+    if (wIdref < Iqdref.qI_Component2)
+    {
+      pHandle->hIdSaved = Iqdref.qI_Component2;
+      pHandle->hIdInjected = (int16_t)wIdref;
+      pHandle->bIdInjected = true;
+      Iqdref.qI_Component2 = (int16_t)wIdref;
+    }
+  }
+
+  return (Iqdref);
+}
+
+/**
+  * @brief  Returns the regenerative Iq allowed by the last RBC_CalcBusVoltageCtrl
+  *         call, to be used as limit of the speed regulator.
+  * @param  pHandle: handler of the current instance of the RegenBrakeCtrl component
+  * @retval int16_t Regenerative Iq allowed, digit
+  */
+int16_t RBC_GetRegenIqLimit(RBC_Handle_t *pHandle)
+{
+  return (pHandle->hRegenIqLimit);
+}
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/************************ (C) COPYRIGHT 2018 STMicroelectronics *****END OF FILE****/
@@ -475,6 +475,8 @@ void RUC_Stop(RevUpCtrl_Handle_t *pHandle)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 
@@ -72,6 +72,15 @@
   * @{
   */
 
+#if defined (CCMRAM)
+#if defined (__ICCARM__)
+#pragma location = ".ccmram"
+#elif defined (__CC_ARM)
+__attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
+#endif
+#endif
 /**
   * @brief  It returns the last computed rotor electrical angle, expressed in
   *         s16degrees. 1 s16degree = 360�/65536
@@ -109,6 +118,15 @@ int16_t SPD_GetAvrgMecSpeed01Hz(SpeednPosFdbk_Handle_t *pHandle)
   return ( pHandle->hAvrMecSpeed01Hz);
 }
 
+#if defined (CCMRAM)
+#if defined (__ICCARM__)
+#pragma location = ".ccmram"
+#elif defined (__CC_ARM)
+__attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
+#endif
+#endif
 /**
   * @brief  It returns the last computed electrical speed, expressed in Dpp.
   *         1 Dpp = 1 s16Degree/control Period. The control period is the period
@@ -148,6 +166,8 @@ bool SPD_Check(SpeednPosFdbk_Handle_t *pHandle)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 
@@ -101,6 +101,15 @@ void STC_SetSpeedSensor(SpeednTorqCtrl_Handle_t *pHandle, SpeednPosFdbk_Handle_t
   pHandle->SPD = SPD_Handle;
 }
 
+#if defined (CCMRAM)
+#if defined (__ICCARM__)
+#pragma location = ".ccmram"
+#elif defined (__CC_ARM)
+__attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
+#endif
+#endif
 /**
   * @brief It returns the speed sensor utilized by the FOC. 
   * @param  pHandle: handler of the current instance of the SpeednTorqCtrl component
@@ -138,6 +138,8 @@ void STO_Return(STO_Handle_t *pHandle, uint8_t flag)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -480,6 +482,8 @@ bool STO_CalcAvrgMecSpeed01Hz(STO_Handle_t *pHandle, int16_t *pMecSpeed01Hz)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -864,6 +868,8 @@ void STO_SetMecAngle(STO_Handle_t *pHandle, int16_t hMecAngle)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -0,0 +1,251 @@
+/**
+  ******************************************************************************
+  * @file    thermal_model.c
+  * @author  Motor Control SDK Team, ST Microelectronics
+  * @brief   This file provides firmware functions that implement the features
+  *          of the Winding Thermal Model component of the Motor Control SDK.
+  *
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2018 STMicroelectronics International N.V.
+  * All rights reserved.</center></h2>
+  *
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted, provided that the following conditions are met:
+  *
+  * 1. Redistribution of source code must retain the above copyright notice,
+  *    this list of conditions and the following disclaimer.
+  * 2. Redistributions in binary form must reproduce the above copyright notice,
+  *    this list of conditions and the following disclaimer in the documentation
+  *    and/or other materials provided with the distribution.
+  * 3. Neither the name of STMicroelectronics nor the names of other
+  *    contributors to this software may be used to endorse or promote products
+  *    derived from this software without specific written permission.
+  * 4. This software, including modifications and/or derivative works of this
+  *    software, must execute solely and exclusively on microcontroller or
+  *    microprocessor devices manufactured by or for STMicroelectronics.
+  * 5. Redistribution and use of this software other than as permitted under
+  *    this license is void and will automatically terminate your rights under
+  *    this license.
+  *
+  * THIS SOFTWARE IS PROVIDED BY STMICROELECTRONICS AND CONTRIBUTORS "AS IS"
+  * AND ANY EXPRESS, IMPLIED OR STATUTORY WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+  * PARTICULAR PURPOSE AND NON-INFRINGEMENT OF THIRD PARTY INTELLECTUAL PROPERTY
+  * RIGHTS ARE DISCLAIMED TO THE FULLEST EXTENT PERMITTED BY LAW. IN NO EVENT
+  * SHALL STMICROELECTRONICS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+  * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "thermal_model.h"
+#include "mc_math.h"
+
+/** @addtogroup MCSDK
+  * @{
+  */
+
+/** @defgroup ThermalModel Winding Thermal Model
+  * @brief Estimates the winding temperature and derives a dynamic current limit
+  *
+  * The model has two first order nodes. The winding node rises over the housing
+  * with time constant hWindingTau_s, the housing node rises over the ambient with
+  * time constant hHousingTau_s. Both are driven by the square of the measured
+  * current magnitude and are expressed per unit of the rated temperature rise,
+  * that is hMaxWindingTemp_C - hRatedAmbientTemp_C reached with hRatedCurrent
+  * flowing continuously.
+  *
+  * The housing node is never let below the rise measured by the heat sink NTC, so
+  * a hot environment or a preheated drive is accounted for.
+  *
+  * As long as the estimated winding temperature is below the derating band the
+  * limit is hPeakCurrent. Inside the band it is moved linearly to the current
+  * that keeps the winding at hMaxWindingTemp_C with the housing rise expected
+  * one winding time constant ahead, so the winding does not overshoot while
+  * the housing still heats up.
+  *
+  * @{
+  */
+
+#define TM_ONE_PU   ((int32_t)1 << 24)
+
+/**
+  * @brief  Initializes the thermal model coefficients and clears its state.
+  * @param  pHandle: handler of the current instance of the ThermalModel component
+  * @retval none
+  */
+void TM_Init(TM_Handle_t *pHandle)
+{
+  uint32_t wDen;
+  uint64_t dCoeff;
+
+  wDen = (uint32_t)pHandle->hMFTaskFrequencyHz * pHandle->hWindingTau_s;
+  dCoeff = ((uint64_t)pHandle->hDecimation << 31) / wDen;
+  pHandle->wWindingCoeff = (dCoeff > (uint64_t)INT32_MAX) ? INT32_MAX : (int32_t)dCoeff;
+
+  wDen = (uint32_t)pHandle->hMFTaskFrequencyHz * pHandle->hHousingTau_s;
+  dCoeff = ((uint64_t)pHandle->hDecimation << 31) / wDen;
+  pHandle->wHousingCoeff = (dCoeff > (uint64_t)INT32_MAX) ? INT32_MAX : (int32_t)dCoeff;
+
+  pHandle->wHousingRatio = ((32768 - (int32_t)pHandle->hWindingShare) * 32768) /
+                           (int32_t)pHandle->hWindingShare;
+
+  TM_Clear(pHandle);
+}
+
+/**
+  * @brief  Clears the thermal state. The motor is assumed at rated ambient
+  *         temperature, the NTC calibration lifts the housing node on the
+  *         next model step if needed.
+  * @param  pHandle: handler of the current instance of the ThermalModel component
+  * @retval none
+  */
+void TM_Clear(TM_Handle_t *pHandle)
+{
+  pHandle->wSumSq = 0u;
+  pHandle->hCount = 0u;
+  pHandle->wWindingRise = 0;
+  pHandle->wHousingRise = 0;
+  pHandle->hCurrentLimit = pHandle->hPeakCurrent;
+}
+
+/**
+  * @brief  Accumulates the measured current and, every hDecimation calls,
+  *         advances the model and computes the new current limit. It must be
+  *         called at hMFTaskFrequencyHz, also while the motor is stopped.
+  * @param  pHandle: handler of the current instance of the ThermalModel component
+  * @param  Iqd: measured currents, expressed in digit
+  * @retval uint16_t Current limit expressed in digit
+  */
+uint16_t TM_CalcCurrentLimit(TM_Handle_t *pHandle, Curr_Components Iqd)
+{
+  int32_t wIq = Iqd.qI_Component1;
+  int32_t wId = Iqd.qI_Component2;
+  uint32_t wRated2;
+  int32_t wPower;
+  int32_t wTarget;
+  int32_t wHousing;
+  int32_t wTotal;
+  int32_t wBand;
+  int32_t wSustained;
+  int32_t wLimit;
+
+  pHandle->wSumSq += ((uint32_t)(wIq * wIq) + (uint32_t)(wId * wId)) >> 6;
+  pHandle->hCount++;
+
+  if (pHandle->hCount >= pHandle->hDecimation)
+  {
+    /* Dissipated power per unit of the rated one, Q24 */
+    wRated2 = (uint32_t)pHandle->hRatedCurrent * pHandle->hRatedCurrent;
+    wPower = (int32_t)((((uint64_t)pHandle->wSumSq / pHandle->hCount) << 30) / wRated2);
+    pHandle->wSumSq = 0u;
+    pHandle->hCount = 0u;
+
+    /* Winding node: steady state rise is hWindingShare of the total */
+    wTarget = (int32_t)(((int64_t)wPower * pHandle->hWindingShare) >> 15);
+    pHandle->wWindingRise += (int32_t)(((int64_t)(wTarget - pHandle->wWindingRise) *
+                                        pHandle->wWindingCoeff) >> 31);
+
+    /* Housing node: driven by the heat flowing through the winding node */
+    wTarget = (int32_t)(((int64_t)pHandle->wWindingRise * pHandle->wHousingRatio) >> 15);
+    pHandle->wHousingRise += (int32_t)(((int64_t)(wTarget - pHandle->wHousingRise) *
+                                        pHandle->wHousingCoeff) >> 31);
+
+    /* Housing rise one winding time constant ahead: the winding settles on
+       the sustained current that slowly, while the housing keeps rising */
+    wHousing = pHandle->wHousingRise + (int32_t)(((int64_t)(wTarget - pHandle->wHousingRise) *
+                                                  pHandle->hWindingTau_s) / pHandle->hHousingTau_s);
+
+    if (pHandle->pNTC != MC_NULL)
+    {
+      wTarget = (int32_t)NTC_GetAvTemp_C(pHandle->pNTC) - pHandle->hRatedAmbientTemp_C;
+      wTarget = (wTarget * TM_ONE_PU) /
+                (pHandle->hMaxWindingTemp_C - pHandle->hRatedAmbientTemp_C);
+      if (wTarget > pHandle->wHousingRise)
+      {
+        pHandle->wHousingRise = wTarget;
+      }
+      if (wTarget > wHousing)
+      {
+        wHousing = wTarget;
+      }
+    }
+
+    /* Current keeping the winding at its maximum with the coming housing rise */
+    wTarget = TM_ONE_PU - wHousing;
+    if (wTarget > 0)
+    {
+      wTarget = (int32_t)(((int64_t)wTarget * 32768) / pHandle->hWindingShare);
+      wSustained = (MCM_Sqrt(wTarget) * (int32_t)pHandle->hRatedCurrent) >> 12;
+    }
+    else
+    {
+      wSustained = 0;
+    }
+    if (wSustained > (int32_t)pHandle->hPeakCurrent)
+    {
+      wSustained = (int32_t)pHandle->hPeakCurrent;
+    }
+
+    wTotal = pHandle->wWindingRise + pHandle->wHousingRise;
+    wBand = (int32_t)pHandle->hDerateBand << 9;
+    if (wTotal >= TM_ONE_PU)
+    {
+      wLimit = wSustained;
+    }
+    else if (wTotal <= TM_ONE_PU - wBand)
+    {
+      wLimit = (int32_t)pHandle->hPeakCurrent;
+    }
+    else
+    {
+      wLimit = wSustained + (int32_t)(((int64_t)((int32_t)pHandle->hPeakCurrent - wSustained) *
+                                       (TM_ONE_PU - wTotal)) / wBand);
+    }
+    pHandle->hCurrentLimit = (uint16_t)wLimit;
+  }
+
+  return (pHandle->hCurrentLimit);
+}
+
+/**
+  * @brief  Returns the latest current limit computed by TM_CalcCurrentLimit.
+  * @param  pHandle: handler of the current instance of the ThermalModel component
+  * @retval uint16_t Current limit expressed in digit
+  */
+uint16_t TM_GetCurrentLimit(TM_Handle_t *pHandle)
+{
+  return (pHandle->hCurrentLimit);
+}
+
+/**
+  * @brief  Returns the estimated winding temperature.
+  * @param  pHandle: handler of the current instance of the ThermalModel component
+  * @retval int16_t Winding temperature expressed in Celsius
+  */
+int16_t TM_GetWindingTemp_C(TM_Handle_t *pHandle)
+{
+  int32_t wRise = pHandle->wWindingRise + pHandle->wHousingRise;
+
+  wRise = (int32_t)(((int64_t)wRise *
+                     (pHandle->hMaxWindingTemp_C - pHandle->hRatedAmbientTemp_C)) >> 24);
+  return ((int16_t)(pHandle->hRatedAmbientTemp_C + wRise));
+}
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/************************ (C) COPYRIGHT 2018 STMicroelectronics *****END OF FILE****/
@@ -127,6 +127,8 @@ void VSS_Clear(VirtualSpeedSensor_Handle_t *pHandle)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
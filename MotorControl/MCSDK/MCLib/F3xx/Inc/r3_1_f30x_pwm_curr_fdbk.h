@@ -106,6 +106,12 @@ typedef const struct
                                             express in number of TIM clocks.*/
   uint16_t hTbefore;                   /*!< It is the sampling time express in
                                             number of TIM clocks.*/
+  uint8_t  bOversamplingSectors;       /*!< Bit SECTOR_x set enables the current
+                                            oversampling while the voltage vector
+                                            is in sector x. 0 disables it.*/
+  uint16_t hToversampling;             /*!< It is the conversion time of the second
+                                            sample pair express in number of TIM
+                                            clocks.*/
   TIM_TypeDef*  TIMx;                   /*!< It contains the pointer to the timer 
                                             used for PWM generation. It must 
                                             equal to TIM1 if bInstanceNbr is 
@@ -182,6 +188,8 @@ typedef struct
   uint32_t wPhaseBOffset;   /*!< Offset of Phase B current sensing network  */
   uint32_t wPhaseCOffset;   /*!< Offset of Phase C current sensing network  */
   uint16_t Half_PWMPeriod;  /*!< Half PWM Period in timer clock counts */
+  uint8_t  bRepetitionCounter; /*!< Repetition counter in use, it can differ
+                                 from the parameter after SetPWMPeriod */
   uint16_t hRegConv;        /*!< Variable used to store regular conversions
                                  result*/
   uint32_t wADC1_JSQR;      /*!< Stores the value for JSQR register to select
@@ -209,6 +217,8 @@ typedef struct
                                  phase BC motor currents.*/
   uint32_t wADC_JSQR_phCB;   /*!< Stores the value for JSQR register to select
                                  phase CB motor currents.*/
+  uint32_t wADC_JSQR_phABAB; /*!< Stores the value for JSQR register to select
+                                 phase AB motor currents twice (oversampling).*/
   volatile uint8_t  bIndex;
   uint16_t ADC_ExternalTriggerInjected;
                             /*!< Trigger selection for ADC peripheral.*/
@@ -244,6 +254,18 @@ void R3_1_F30X_SwitchOnPWM(PWMC_Handle_t *pHdl);
   */
 void R3_1_F30X_TurnOnLowSides(PWMC_Handle_t *pHdl);
 
+/**
+  * It changes the PWM period and the repetition counter while the PWM
+  * outputs are off
+  */
+bool R3_1_F30X_SetPWMPeriod(PWMC_Handle_t *pHdl, uint16_t hPWMPeriod, uint8_t bRepetitionCounter);
+
+/**
+  * It returns the time left up to the next update event, when the new duty
+  * cycles are loaded, as a fraction of the FOC period in Q15
+  */
+uint16_t R3_1_F30X_GetUpdateDelay(PWMC_Handle_t *pHdl);
+
 /**
   * It computes and return latest converted motor phase currents motor
   */
@@ -586,6 +586,8 @@ void R1F30X_CurrentReadingCalibration(PWMC_Handle_t *pHdl)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -1037,6 +1039,8 @@ void R1F30X_SwitchOffPWM(PWMC_Handle_t *pHdl)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 
@@ -1056,6 +1060,8 @@ void *R1F30X_TIMx_UP_IRQHandler(PWMC_Handle_t *pHdl)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -1086,6 +1092,8 @@ void *R1F30X_BRK2_IRQHandler(PWMC_Handle_t *pHdl)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -1230,6 +1238,8 @@ static void R1F30X_SetAOReferenceVoltage(uint32_t DAC_Channel, uint16_t hDACVref
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 
@@ -1773,6 +1783,8 @@ void R1F30X_RLDetectionModeDisable(PWMC_Handle_t *pHdl)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 
@@ -1822,6 +1834,8 @@ uint16_t R1F30X_RLDetectionModeSetDuty(PWMC_Handle_t *pHdl, uint16_t hDuty)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 
@@ -142,6 +142,7 @@ static void R3_1_F30X_HFCurrentsCalibrationAB(PWMC_Handle_t *pHdl,Curr_Component
 static void R3_1_F30X_HFCurrentsCalibrationC(PWMC_Handle_t *pHdl,Curr_Components* pStator_Currents);
 static void R3_1_F3XX_StartTimers(void);
 static uint16_t R3_1_F30X_WriteTIMRegisters(PWMC_Handle_t *pHdl);
+static uint32_t R3_1_F30X_CenterJSQR(PWMC_R3_1_F3_Handle_t *pHandle, uint8_t bSector);
 static uint32_t SingleADC_InjectedConfig(ADC_TypeDef* ADCx,
                                          ADC_InjectedInitTypeDef* ADC_InjectedInitStruct);
 
@@ -324,6 +325,15 @@ void R3_1_F30X_Init(PWMC_R3_1_F3_Handle_t *pHandle)
     ADC_InjectedInitStruct.ADC_InjecSequence2 = pHandle->pParams_str->bIbChannel;
 
     pHandle->wADC_JSQR_phCB= SingleADC_InjectedConfig(ADCx, &ADC_InjectedInitStruct);
+
+    /*ABAB currents sequence, oversampling ---------------------------------------------------------------- */
+    ADC_InjectedInitStruct.ADC_NbrOfInjecChannel = 4u;
+    ADC_InjectedInitStruct.ADC_InjecSequence1 = pHandle->pParams_str->bIaChannel;
+    ADC_InjectedInitStruct.ADC_InjecSequence2 = pHandle->pParams_str->bIbChannel;
+    ADC_InjectedInitStruct.ADC_InjecSequence3 = pHandle->pParams_str->bIaChannel;
+    ADC_InjectedInitStruct.ADC_InjecSequence4 = pHandle->pParams_str->bIbChannel;
+
+    pHandle->wADC_JSQR_phABAB= SingleADC_InjectedConfig(ADCx, &ADC_InjectedInitStruct);
     /* ---------------------------------------------------------------------------------------------------- */
 
     /* Configuration of ADC single sequence of single current for the future JSQR register setting*/
@@ -455,7 +465,7 @@ void R3_1_F30X_CurrentReadingCalibration(PWMC_Handle_t *pHdl)
   R3_1_F30X_SwitchOnPWM(&pHandle->_Super);
   
   /* Wait for NB_CONVERSIONS to be executed */
-  hMaxPeriodsNumber=(NB_CONVERSIONS+1u)*(((uint16_t)(pHandle->pParams_str->bRepetitionCounter)+1u)>>1);
+  hMaxPeriodsNumber=(NB_CONVERSIONS+1u)*(((uint16_t)(pHandle->bRepetitionCounter)+1u)>>1);
   TIMx->SR = (uint16_t)~LL_TIM_SR_CC1IF;
   hCalibrationPeriodCounter = 0u;
   while (pHandle->bIndex < NB_CONVERSIONS)
@@ -552,6 +562,8 @@ void R3_1_F30X_CurrentReadingCalibration(PWMC_Handle_t *pHdl)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -565,13 +577,22 @@ void R3_1_F30X_GetPhaseCurrents(PWMC_Handle_t *pHdl, Curr_Components* pStator_Cu
   int32_t wAux;
   uint16_t hReg1;
   uint16_t hReg2;
+  uint32_t wJDR;
+  uint32_t wOversamplingMask;
   PWMC_R3_1_F3_Handle_t *pHandle = (PWMC_R3_1_F3_Handle_t *)pHdl;
+  ADC_TypeDef* ADCx = pHandle->pParams_str->ADCx;
 
   /* Clear the flag to indicate the start of FOC algorithm*/
   LL_TIM_ClearFlag_UPDATE(pHandle->pParams_str->TIMx);
   
-  hReg1 = (uint16_t)(pHandle->pParams_str->ADCx->JDR1);
-  hReg2 = (uint16_t)(pHandle->pParams_str->ADCx->JDR2);
+  /* wADC1_JSQR still holds the sequence of these conversions. With four of them
+     (oversampling) JDR3 and JDR4 are averaged with JDR1 and JDR2, otherwise JDR1
+     and JDR2 are taken twice. No branch, so the ISR duration does not change */
+  wOversamplingMask = 0u - ((pHandle->wADC1_JSQR >> 1) & 1u);
+  wJDR = ADCx->JDR1;
+  hReg1 = (uint16_t)((wJDR + (ADCx->JDR3 & wOversamplingMask) + (wJDR & ~wOversamplingMask)) >> 1);
+  wJDR = ADCx->JDR2;
+  hReg2 = (uint16_t)((wJDR + (ADCx->JDR4 & wOversamplingMask) + (wJDR & ~wOversamplingMask)) >> 1);
   
   bSector = (uint8_t)(pHandle->_Super.hSector);
   
@@ -803,6 +824,76 @@ static void R3_1_F30X_HFCurrentsCalibrationC(PWMC_Handle_t *pHdl, Curr_Component
   }
 }
 
+/**
+  * @brief  It changes the PWM period and the number of PWM half periods per
+  *         update event. Both are preloaded, so the timer keeps running and
+  *         the new values start at the next update event. The sampling points
+  *         are computed from Half_PWMPeriod and follow automatically.
+  *         It must be called while the PWM outputs are off.
+  * @param pHdl: handler of the current instance of the PWM component
+  * @param hPWMPeriod: new PWM period in timer clock counts, center aligned
+  * @param bRepetitionCounter: (2 * PWM periods per FOC execution) - 1
+  * @retval bool false if the PWM outputs are on or the period is too short
+  *         for the current sampling
+  */
+bool R3_1_F30X_SetPWMPeriod(PWMC_Handle_t *pHdl, uint16_t hPWMPeriod, uint8_t bRepetitionCounter)
+{
+  PWMC_R3_1_F3_Handle_t *pHandle = (PWMC_R3_1_F3_Handle_t *)pHdl;
+  TIM_TypeDef*  TIMx = pHandle->pParams_str->TIMx;
+  bool bRetVal = false;
+
+  if (((TIMx->BDTR & TIM_BDTR_MOE) == 0u) &&
+      ((hPWMPeriod / 2u) > (pHandle->pParams_str->hTafter + pHandle->pParams_str->hTbefore)))
+  {
+    pHandle->Half_PWMPeriod = hPWMPeriod / 2u;
+    pHandle->_Super.hPWMperiod = hPWMPeriod;
+    pHandle->_Super.hT_Sqrt3 = (uint16_t)(((uint32_t)hPWMPeriod * SQRT3FACTOR) / 16384u);
+    pHandle->bRepetitionCounter = bRepetitionCounter;
+
+    LL_TIM_EnableARRPreload(TIMx);
+    LL_TIM_SetAutoReload(TIMx, pHandle->Half_PWMPeriod);
+    LL_TIM_SetRepetitionCounter(TIMx, bRepetitionCounter);
+    bRetVal = true;
+  }
+  return bRetVal;
+}
+
+#if defined (CCMRAM)
+#if defined (__ICCARM__)
+#pragma location = ".ccmram"
+#elif defined (__CC_ARM)
+__attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
+#endif
+#endif
+/**
+  * @brief  It returns the time left up to the next update event, that loads
+  *         the duty cycles written by this FOC execution. The ADC trigger is
+  *         armed by the update event, so the FOC runs in the first PWM period
+  *         after it and the remaining periods of the repetition counter are
+  *         still ahead. The update event is at the underflow, see
+  *         R3_1_F30X_SwitchOnPWM.
+  * @param pHdl: handler of the current instance of the PWM component
+  * @retval uint16_t delay as a fraction of the FOC period, Q15
+  */
+uint16_t R3_1_F30X_GetUpdateDelay(PWMC_Handle_t *pHdl)
+{
+  PWMC_R3_1_F3_Handle_t *pHandle = (PWMC_R3_1_F3_Handle_t *)pHdl;
+  TIM_TypeDef*  TIMx = pHandle->pParams_str->TIMx;
+  uint32_t wPeriods = ((uint32_t)pHandle->bRepetitionCounter + 1u) >> 1;
+  uint32_t wCounts = TIMx->CNT;
+
+  if ((TIMx->CR1 & DIR_MASK) != DIR_MASK)
+  {
+    /* Counting up: rest of the way up and the way down */
+    wCounts = (2u * (uint32_t)pHandle->Half_PWMPeriod) - wCounts;
+  }
+  wCounts += (wPeriods - 1u) * (uint32_t)pHandle->_Super.hPWMperiod;
+
+  return ((uint16_t)((wCounts << 15) / (wPeriods * (uint32_t)pHandle->_Super.hPWMperiod)));
+}
+
 /**
   * @brief  It turns on low sides switches. This function is intended to be 
   *         used for charging boot capacitors of driving section. It has to be 
@@ -970,6 +1061,8 @@ void R3_1_F30X_SwitchOffPWM(PWMC_Handle_t *pHdl)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 
@@ -1022,6 +1115,8 @@ static uint16_t R3_1_F30X_WriteTIMRegisters(PWMC_Handle_t *pHdl)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -1032,7 +1127,7 @@ __attribute__((section ("ccmram")))
   * @param pHdl: handler of the current instance of the PWM component
   * @retval none
   */
-static uint16_t R3_1_F30X_SetADCSampPointCalibration(PWMC_Handle_t *pHdl)
+uint16_t R3_1_F30X_SetADCSampPointCalibration(PWMC_Handle_t *pHdl)
 {
   PWMC_R3_1_F3_Handle_t *pHandle = (PWMC_R3_1_F3_Handle_t *)pHdl;
 
@@ -1045,6 +1140,41 @@ static uint16_t R3_1_F30X_SetADCSampPointCalibration(PWMC_Handle_t *pHdl)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
+#endif
+#endif
+/**
+  * @brief  Returns the JSQR value for the sampling in the middle of the PWM
+  *         period. Phase A and B currents are converted twice if the
+  *         oversampling is enabled for bSector and the low side on time of
+  *         every phase leaves room for the second sample pair.
+  * @param pHandle: handler of the current instance of the PWM component
+  * @param bSector: sector of the voltage vector, SECTOR_1 ... SECTOR_6
+  * @retval uint32_t JSQR value
+  */
+static uint32_t R3_1_F30X_CenterJSQR(PWMC_R3_1_F3_Handle_t *pHandle, uint8_t bSector)
+{
+  uint16_t hTmin = pHandle->pParams_str->hTafter + pHandle->pParams_str->hToversampling;
+  uint32_t wJSQR = pHandle->wADC_JSQR_phAB;
+
+  if (((pHandle->pParams_str->bOversamplingSectors & (1u << bSector)) != 0u) &&
+      ((uint16_t)(pHandle->Half_PWMPeriod-pHandle->_Super.hCntPhA) > hTmin) &&
+      ((uint16_t)(pHandle->Half_PWMPeriod-pHandle->_Super.hCntPhB) > hTmin) &&
+      ((uint16_t)(pHandle->Half_PWMPeriod-pHandle->_Super.hCntPhC) > hTmin))
+  {
+    wJSQR = pHandle->wADC_JSQR_phABAB;
+  }
+  return wJSQR;
+}
+
+#if defined (CCMRAM)
+#if defined (__ICCARM__)
+#pragma location = ".ccmram"
+#elif defined (__CC_ARM)
+__attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -1068,7 +1198,7 @@ uint16_t R3_1_F30X_SetADCSampPointSect1(PWMC_Handle_t *pHdl)
     pHandle->pParams_str->TIMx->CCR4 = (uint32_t)(pHandle->Half_PWMPeriod) - 1u;
     pHandle->_Super.hSector = SECTOR_5; /* Dummy just for the GetPhaseCurrent */
     
-    pHandle->wADC1_JSQR = pHandle->wADC_JSQR_phAB;
+    pHandle->wADC1_JSQR = R3_1_F30X_CenterJSQR(pHandle, SECTOR_1);
   }
   else
   { /* In this case it is necessary to convert phases with Maximum and variable complementary duty cycle.*/
@@ -1119,6 +1249,8 @@ uint16_t R3_1_F30X_SetADCSampPointSect1(PWMC_Handle_t *pHdl)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -1141,7 +1273,7 @@ uint16_t R3_1_F30X_SetADCSampPointSect2(PWMC_Handle_t *pHdl)
     pHandle->pParams_str->TIMx->CCR4 = (uint32_t)(pHandle->Half_PWMPeriod) - 1u;
     pHandle->_Super.hSector = SECTOR_5; /* Dummy just for the GetPhaseCurrent */
     
-    pHandle->wADC1_JSQR = pHandle->wADC_JSQR_phAB;
+    pHandle->wADC1_JSQR = R3_1_F30X_CenterJSQR(pHandle, SECTOR_2);
   }
   else
   {
@@ -1203,6 +1335,8 @@ uint16_t R3_1_F30X_SetADCSampPointSect2(PWMC_Handle_t *pHdl)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -1225,7 +1359,7 @@ uint16_t R3_1_F30X_SetADCSampPointSect3(PWMC_Handle_t *pHdl)
     pHandle->pParams_str->TIMx->CCR4 = (uint32_t)(pHandle->Half_PWMPeriod) - 1u;
     pHandle->_Super.hSector = SECTOR_5; /* Dummy just for the GetPhaseCurrent */
 
-    pHandle->wADC1_JSQR = pHandle->wADC_JSQR_phAB;
+    pHandle->wADC1_JSQR = R3_1_F30X_CenterJSQR(pHandle, SECTOR_3);
   }
   else
   {/* In this case it is necessary to convert phases with Maximum and variable complementary duty cycle.*/
@@ -1287,6 +1421,8 @@ uint16_t R3_1_F30X_SetADCSampPointSect3(PWMC_Handle_t *pHdl)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -1309,7 +1445,7 @@ uint16_t R3_1_F30X_SetADCSampPointSect4(PWMC_Handle_t *pHdl)
     pHandle->pParams_str->TIMx->CCR4 = (uint32_t)(pHandle->Half_PWMPeriod) - 1u;
     pHandle->_Super.hSector = SECTOR_5; /* Dummy just for the GetPhaseCurrent */
     
-    pHandle->wADC1_JSQR = pHandle->wADC_JSQR_phAB;
+    pHandle->wADC1_JSQR = R3_1_F30X_CenterJSQR(pHandle, SECTOR_4);
   }
   else
   {
@@ -1373,6 +1509,8 @@ uint16_t R3_1_F30X_SetADCSampPointSect4(PWMC_Handle_t *pHdl)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -1395,7 +1533,7 @@ uint16_t R3_1_F30X_SetADCSampPointSect5(PWMC_Handle_t *pHdl)
     pHandle->pParams_str->TIMx->CCR4 = (uint32_t)(pHandle->Half_PWMPeriod) - 1u;
     pHandle->_Super.hSector = SECTOR_5; /* Dummy just for the GetPhaseCurrent */
 
-    pHandle->wADC1_JSQR = pHandle->wADC_JSQR_phAB;
+    pHandle->wADC1_JSQR = R3_1_F30X_CenterJSQR(pHandle, SECTOR_5);
   }
   else
   {
@@ -1458,6 +1596,8 @@ uint16_t R3_1_F30X_SetADCSampPointSect5(PWMC_Handle_t *pHdl)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -1480,7 +1620,7 @@ uint16_t R3_1_F30X_SetADCSampPointSect6(PWMC_Handle_t *pHdl)
     pHandle->pParams_str->TIMx->CCR4 = (uint32_t)(pHandle->Half_PWMPeriod) - 1u;
     pHandle->_Super.hSector = SECTOR_5; /* Dummy just for the GetPhaseCurrent */
 
-    pHandle->wADC1_JSQR = pHandle->wADC_JSQR_phAB;
+    pHandle->wADC1_JSQR = R3_1_F30X_CenterJSQR(pHandle, SECTOR_6);
   }
   else
   {
@@ -1543,6 +1683,8 @@ uint16_t R3_1_F30X_SetADCSampPointSect6(PWMC_Handle_t *pHdl)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -1561,6 +1703,8 @@ void *R3_1_F30X_TIMx_UP_IRQHandler(PWMC_Handle_t *pHdl)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -1591,6 +1735,8 @@ void *R3_1_F30X_BRK2_IRQHandler(PWMC_Handle_t *pHdl)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -1811,7 +1957,7 @@ void R3_1_F30X_RLDetectionModeDisable(PWMC_Handle_t *pHdl)
     }
     
     /* TIM1 Repetition Counter reactivation to the User Value */
-    TIMx->RCR = pHandle->pParams_str->bRepetitionCounter;
+    TIMx->RCR = pHandle->bRepetitionCounter;
     /* Repetition Counter of TIM1 User value reactivation END*/
     
     
@@ -1933,6 +2079,8 @@ uint16_t R3_1_F30X_RLDetectionModeSetDuty(PWMC_Handle_t *pHdl, uint16_t hDuty)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -1941,7 +2089,7 @@ __attribute__((section ("ccmram")))
   * @param pHdl: handler of the current instance of the PWM component
   * @retval Ia and Ib current in Curr_Components format
   */
-static void R3_1_F30X_RLGetPhaseCurrents(PWMC_Handle_t *pHdl,Curr_Components* pStator_Currents)
+void R3_1_F30X_RLGetPhaseCurrents(PWMC_Handle_t *pHdl,Curr_Components* pStator_Currents)
 {
   int32_t wAux;
   int16_t hCurrA = 0, hCurrB = 0;
@@ -2005,7 +2153,7 @@ static void R3_1_F30X_RLGetPhaseCurrents(PWMC_Handle_t *pHdl,Curr_Components* pS
   * @param pHdl: handler of the current instance of the PWM component
   * @retval none
   */
-static void R3_1_F30X_RLTurnOnLowSides(PWMC_Handle_t *pHdl)
+void R3_1_F30X_RLTurnOnLowSides(PWMC_Handle_t *pHdl)
 {  
   PWMC_R3_1_F3_Handle_t *pHandle = (PWMC_R3_1_F3_Handle_t *)pHdl;
   TIM_TypeDef*  TIMx = pHandle->pParams_str->TIMx;
@@ -2039,7 +2187,7 @@ static void R3_1_F30X_RLTurnOnLowSides(PWMC_Handle_t *pHdl)
   * @param pHdl: handler of the current instance of the PWM component
   * @retval none
   */
-static void R3_1_F30X_RLSwitchOnPWM(PWMC_Handle_t *pHdl)
+void R3_1_F30X_RLSwitchOnPWM(PWMC_Handle_t *pHdl)
 {
   PWMC_R3_1_F3_Handle_t *pHandle = (PWMC_R3_1_F3_Handle_t *)pHdl;
   TIM_TypeDef*  TIMx = pHandle->pParams_str->TIMx;
@@ -2103,7 +2251,7 @@ static void R3_1_F30X_RLSwitchOnPWM(PWMC_Handle_t *pHdl)
   * @param pHdl: handler of the current instance of the PWM component
   * @retval none
   */
-static void R3_1_F30X_RLSwitchOffPWM(PWMC_Handle_t *pHdl)
+void R3_1_F30X_RLSwitchOffPWM(PWMC_Handle_t *pHdl)
 {
   PWMC_R3_1_F3_Handle_t *pHandle = (PWMC_R3_1_F3_Handle_t *)pHdl;
   TIM_TypeDef*  TIMx = pHandle->pParams_str->TIMx;
@@ -590,6 +590,8 @@ void R3_2_F30X_CurrentReadingCalibration(PWMC_Handle_t *pHdl)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -913,6 +915,8 @@ void R3_2_F30X_SwitchOffPWM(PWMC_Handle_t *pHdl)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -956,6 +960,8 @@ static uint16_t R3_2_F30X_WriteTIMRegisters(PWMC_Handle_t *pHdl)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -1054,6 +1060,8 @@ uint16_t R3_2_F30X_SetADCSampPointSect1(PWMC_Handle_t *pHdl)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -1152,6 +1160,8 @@ uint16_t R3_2_F30X_SetADCSampPointSect2(PWMC_Handle_t *pHdl)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -1250,6 +1260,8 @@ uint16_t R3_2_F30X_SetADCSampPointSect3(PWMC_Handle_t *pHdl)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -1348,6 +1360,8 @@ uint16_t R3_2_F30X_SetADCSampPointSect4(PWMC_Handle_t *pHdl)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -1446,6 +1460,8 @@ uint16_t R3_2_F30X_SetADCSampPointSect5(PWMC_Handle_t *pHdl)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -1544,6 +1560,8 @@ uint16_t R3_2_F30X_SetADCSampPointSect6(PWMC_Handle_t *pHdl)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -1579,6 +1597,8 @@ void *R3_2_F30X_TIMx_UP_IRQHandler(PWMC_Handle_t *pHdl)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -1609,6 +1629,8 @@ void *R3_2_F30X_BRK2_IRQHandler(PWMC_Handle_t *pHdl)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
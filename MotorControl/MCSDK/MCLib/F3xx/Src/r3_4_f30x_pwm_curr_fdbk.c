@@ -563,6 +563,8 @@ void R3_4_F30X_CurrentReadingCalibration(PWMC_Handle_t *pHdl)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -955,6 +957,8 @@ void R3_4_F30X_SwitchOffPWM(PWMC_Handle_t *pHdl)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -1012,6 +1016,8 @@ static uint16_t R3_4_F30X_WriteTIMRegisters(PWMC_Handle_t *pHdl)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -1041,6 +1047,8 @@ static uint16_t R3_4_F30X_SetADCSampPointCalibration(PWMC_Handle_t *pHdl)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -1143,6 +1151,8 @@ uint16_t R3_4_F30X_SetADCSampPointSect1(PWMC_Handle_t *pHdl)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -1243,6 +1253,8 @@ uint16_t R3_4_F30X_SetADCSampPointSect2(PWMC_Handle_t *pHdl)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -1344,6 +1356,8 @@ uint16_t R3_4_F30X_SetADCSampPointSect3(PWMC_Handle_t *pHdl)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -1444,6 +1458,8 @@ uint16_t R3_4_F30X_SetADCSampPointSect4(PWMC_Handle_t *pHdl)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -1544,6 +1560,8 @@ uint16_t R3_4_F30X_SetADCSampPointSect5(PWMC_Handle_t *pHdl)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -1644,6 +1662,8 @@ uint16_t R3_4_F30X_SetADCSampPointSect6(PWMC_Handle_t *pHdl)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -1662,6 +1682,8 @@ void *R3_4_F30X_TIMx_UP_IRQHandler(PWMC_Handle_t *pHdl)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -1692,6 +1714,8 @@ void *R3_4_F30X_BRK2_IRQHandler(PWMC_Handle_t *pHdl)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -2152,6 +2176,8 @@ uint16_t R3_4_F30X_RLDetectionModeSetDuty(PWMC_Handle_t *pHdl, uint16_t hDuty)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
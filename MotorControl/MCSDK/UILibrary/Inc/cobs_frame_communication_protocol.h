@@ -0,0 +1,153 @@
+/**
+  ******************************************************************************
+  * @file    cobs_frame_communication_protocol.h
+  * @author  Motor Control SDK Team, ST Microelectronics
+  * @brief   This file contains all definitions and functions prototypes for the
+  *          COBS framed Frame Communication Protocol on USART component of the Motor Control SDK.
+  *
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2018 STMicroelectronics International N.V.
+  * All rights reserved.</center></h2>
+  *
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted, provided that the following conditions are met:
+  *
+  * 1. Redistribution of source code must retain the above copyright notice,
+  *    this list of conditions and the following disclaimer.
+  * 2. Redistributions in binary form must reproduce the above copyright notice,
+  *    this list of conditions and the following disclaimer in the documentation
+  *    and/or other materials provided with the distribution.
+  * 3. Neither the name of STMicroelectronics nor the names of other
+  *    contributors to this software may be used to endorse or promote products
+  *    derived from this software without specific written permission.
+  * 4. This software, including modifications and/or derivative works of this
+  *    software, must execute solely and exclusively on microcontroller or
+  *    microprocessor devices manufactured by or for STMicroelectronics.
+  * 5. Redistribution and use of this software other than as permitted under
+  *    this license is void and will automatically terminate your rights under
+  *    this license.
+  *
+  * THIS SOFTWARE IS PROVIDED BY STMICROELECTRONICS AND CONTRIBUTORS "AS IS"
+  * AND ANY EXPRESS, IMPLIED OR STATUTORY WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+  * PARTICULAR PURPOSE AND NON-INFRINGEMENT OF THIRD PARTY INTELLECTUAL PROPERTY
+  * RIGHTS ARE DISCLAIMED TO THE FULLEST EXTENT PERMITTED BY LAW. IN NO EVENT
+  * SHALL STMICROELECTRONICS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+  * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __CFCP_H
+#define __CFCP_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif /* __cplusplus */
+
+/* Includes ------------------------------------------------------------------*/
+#include "frame_communication_protocol.h"
+
+/** @addtogroup MCSDK
+  * @{
+  */
+
+/**
+ * @addtogroup UILib
+ * @{
+ */
+
+/** @addtogroup CFCP
+  * @{
+  */
+
+/* Exported constants --------------------------------------------------------*/
+
+/** @brief Size of the header of a CFCP frame: sequence number and code */
+#define CFCP_HEADER_SIZE      2
+/** @brief Size of the CRC-16 of a CFCP frame */
+#define CFCP_CRC_SIZE         2
+/** @brief Maximum size of a decoded CFCP frame, all inclusive */
+#define CFCP_MAX_FRAME_SIZE   (CFCP_HEADER_SIZE + FCP_MAX_PAYLOAD_SIZE + CFCP_CRC_SIZE)
+/** @brief Maximum size of an encoded CFCP frame: COBS overhead and the zero delimiter */
+#define CFCP_MAX_ENCODED_SIZE (CFCP_MAX_FRAME_SIZE + CFCP_MAX_FRAME_SIZE / 254 + 2)
+
+/** @brief Number of received frames queued for the client (pipelined requests) */
+#ifndef CFCP_RX_SLOTS
+#define CFCP_RX_SLOTS         4
+#endif
+/** @brief Size of the encoded transmit ring, a power of 2 */
+#ifndef CFCP_TX_RING_SIZE
+#define CFCP_TX_RING_SIZE     512
+#endif
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct {
+  FCP_Handle_t _Super;
+
+  USART_TypeDef * USARTx;
+  IRQn_Type USARTIRQn;                    /**< USART interrupt, masked while a frame is queued for transmission */
+
+  uint8_t RxSlot[CFCP_RX_SLOTS][CFCP_MAX_FRAME_SIZE]; /**< Decoded frames waiting for the client */
+  uint8_t RxSlotLen[CFCP_RX_SLOTS];       /**< Length of the decoded frames */
+  volatile uint8_t RxHead;                /**< Slot being decoded */
+  volatile uint8_t RxTail;                /**< Next slot for the client */
+  uint8_t RxLen;                          /**< Bytes decoded in the current frame */
+  uint8_t RxRemain;                       /**< Data bytes left in the current COBS block, 0: a code byte follows */
+  uint8_t RxBlock;                        /**< Code byte of the current COBS block */
+  bool RxBad;                             /**< Current frame is discarded up to the next delimiter */
+  uint16_t RxCRC;                         /**< CRC-16 of the decoded bytes, 0 at the end of a valid frame */
+
+  uint8_t TxRing[CFCP_TX_RING_SIZE];      /**< Encoded frames to transmit */
+  volatile uint16_t TxHead;               /**< Write index of the transmit ring */
+  volatile uint16_t TxTail;               /**< Read index of the transmit ring */
+  uint8_t TxSeq;                          /**< Sequence number of the request being answered */
+
+  uint16_t RxFrames;                      /**< Valid frames received */
+  uint16_t RxErrors;                      /**< Frames discarded for CRC, length or overrun */
+  uint16_t RxDropped;                     /**< Valid frames discarded, all slots full */
+} CFCP_Handle_t;
+
+/* Exported functions ------------------------------------------------------- */
+
+void CFCP_Init( CFCP_Handle_t * pHandle );
+
+uint8_t CFCP_Receive( FCP_Handle_t * pHandle );
+
+uint8_t CFCP_Send( FCP_Handle_t * pHandle, uint8_t code, uint8_t *buffer, uint8_t size );
+
+void CFCP_AbortReceive( FCP_Handle_t * pHandle );
+
+void CFCP_RX_IRQ_Handler( CFCP_Handle_t * pHandle, uint8_t rx_byte );
+
+void CFCP_TX_IRQ_Handler( CFCP_Handle_t * pHandle );
+
+void CFCP_OVR_IRQ_Handler( CFCP_Handle_t * pHandle );
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif /* __cpluplus */
+
+#endif /* __CFCP_H */
+
+/******************* (C) COPYRIGHT 2018 STMicroelectronics *****END OF FILE****/
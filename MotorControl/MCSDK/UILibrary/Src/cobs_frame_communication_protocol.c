@@ -0,0 +1,412 @@
+/**
+  ******************************************************************************
+  * @file    cobs_frame_communication_protocol.c
+  * @author  Motor Control SDK Team, ST Microelectronics
+  * @brief   This file provides firmware functions that implement the features
+  *          of the COBS framed Frame Communication Protocol for USART component of the Motor Control SDK.
+  *          
+  *
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2018 STMicroelectronics International N.V.
+  * All rights reserved.</center></h2>
+  *
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted, provided that the following conditions are met:
+  *
+  * 1. Redistribution of source code must retain the above copyright notice,
+  *    this list of conditions and the following disclaimer.
+  * 2. Redistributions in binary form must reproduce the above copyright notice,
+  *    this list of conditions and the following disclaimer in the documentation
+  *    and/or other materials provided with the distribution.
+  * 3. Neither the name of STMicroelectronics nor the names of other
+  *    contributors to this software may be used to endorse or promote products
+  *    derived from this software without specific written permission.
+  * 4. This software, including modifications and/or derivative works of this
+  *    software, must execute solely and exclusively on microcontroller or
+  *    microprocessor devices manufactured by or for STMicroelectronics.
+  * 5. Redistribution and use of this software other than as permitted under
+  *    this license is void and will automatically terminate your rights under
+  *    this license.
+  *
+  * THIS SOFTWARE IS PROVIDED BY STMICROELECTRONICS AND CONTRIBUTORS "AS IS"
+  * AND ANY EXPRESS, IMPLIED OR STATUTORY WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+  * PARTICULAR PURPOSE AND NON-INFRINGEMENT OF THIRD PARTY INTELLECTUAL PROPERTY
+  * RIGHTS ARE DISCLAIMED TO THE FULLEST EXTENT PERMITTED BY LAW. IN NO EVENT
+  * SHALL STMICROELECTRONICS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+  * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "cobs_frame_communication_protocol.h"
+#include "crc16.h"
+
+/** @addtogroup MCSDK
+  * @{
+  */
+
+/** @defgroup CFCP COBS Frame Communication Protocol
+  * @brief Zero delimited USART transport of the Motor Control Protocol
+  *
+  * A frame is the sequence number, the code, the payload and the Modbus CRC-16
+  * (low byte first), encoded with Consistent Overhead Byte Stuffing and ended
+  * by a zero byte. Zero never occurs inside an encoded frame, so the receiver
+  * resynchronises on the next delimiter after any lost or corrupted byte,
+  * without a reception timeout. Frames with a bad CRC are discarded silently.
+  *
+  * Reception stays enabled: up to CFCP_RX_SLOTS decoded frames are queued,
+  * so the remote may pipeline requests. A queued frame is passed to the
+  * client as soon as it waits for a frame and the transmit ring has room for
+  * a full answer. The answer carries the sequence number of its request, so
+  * the remote matches answers by sequence number and not by order, and
+  * repeats only the requests whose answer is missing.
+  *
+  * Frames are encoded into a transmit ring as they are sent by the client,
+  * and the client is notified at once. Frames sent outside a request (ATR)
+  * carry the sequence number of the last request.
+  * @{
+  */
+
+/* Private macros ------------------------------------------------------------*/
+#define CFCP_TX_MASK          (CFCP_TX_RING_SIZE - 1u)
+
+/* Private functions ---------------------------------------------------------*/
+
+/*
+ * Starts the decoding of a new frame.
+ */
+static void CFCP_RxRestart( CFCP_Handle_t * pHandle )
+{
+  pHandle->RxLen = 0;
+  pHandle->RxRemain = 0;
+  pHandle->RxBlock = 0xFF;
+  pHandle->RxBad = false;
+  pHandle->RxCRC = CRC16InitVal;
+}
+
+/*
+ * Stores a decoded byte of the current frame.
+ */
+static void CFCP_RxStore( CFCP_Handle_t * pHandle, uint8_t data )
+{
+  if ( pHandle->RxLen < CFCP_MAX_FRAME_SIZE )
+  {
+    pHandle->RxSlot[pHandle->RxHead][pHandle->RxLen++] = data;
+    pHandle->RxCRC = crc16_update( pHandle->RxCRC, &data, 1 );
+  }
+  else
+  {
+    pHandle->RxBad = true;
+  }
+}
+
+/*
+ * Free space of the transmit ring.
+ */
+static uint16_t CFCP_TxFree( CFCP_Handle_t * pHandle )
+{
+  return (uint16_t)( CFCP_TX_MASK - ( ( pHandle->TxHead - pHandle->TxTail ) & CFCP_TX_MASK ) );
+}
+
+/*
+ * Passes the queued frames to the client, while it waits for a frame and the
+ * transmit ring has room for its answer. The client answers from its
+ * callback and waits again, so the loop serves all queued requests in turn.
+ */
+static void CFCP_Dispatch( CFCP_Handle_t * pHandle )
+{
+  FCP_Handle_t * pBaseHandle = & pHandle->_Super;
+  uint8_t * pSlot;
+  uint8_t size;
+  uint8_t idx;
+
+  while ( ( FCP_TRANSFER_IDLE != pBaseHandle->RxFrameState ) &&
+          ( pHandle->RxTail != pHandle->RxHead ) &&
+          ( CFCP_TxFree( pHandle ) >= CFCP_MAX_ENCODED_SIZE ) )
+  {
+    pSlot = pHandle->RxSlot[pHandle->RxTail];
+    size = pHandle->RxSlotLen[pHandle->RxTail] - ( CFCP_HEADER_SIZE + CFCP_CRC_SIZE );
+
+    pHandle->TxSeq = pSlot[0];
+    pBaseHandle->RxFrame.Code = pSlot[1];
+    pBaseHandle->RxFrame.Size = size;
+    for ( idx = 0; idx < size; idx++ )
+    {
+      pBaseHandle->RxFrame.Buffer[idx] = pSlot[CFCP_HEADER_SIZE + idx];
+    }
+    pHandle->RxTail = ( pHandle->RxTail + 1u ) % CFCP_RX_SLOTS;
+
+    pBaseHandle->RxFrameState = FCP_TRANSFER_IDLE;
+    pBaseHandle->ClientFrameReceivedCallback( pBaseHandle->ClientEntity,
+                                              pBaseHandle->RxFrame.Code,
+                                              pBaseHandle->RxFrame.Buffer,
+                                              pBaseHandle->RxFrame.Size );
+  }
+}
+
+/* Functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Initializes a CFCP component and enables the reception.
+  * @param  pHandle Pointer on the handle of the component.
+  */
+void CFCP_Init( CFCP_Handle_t * pHandle )
+{
+  /* Initialize generic component part */
+  FCP_Init( & pHandle->_Super );
+
+  pHandle->RxHead = 0;
+  pHandle->RxTail = 0;
+  CFCP_RxRestart( pHandle );
+  pHandle->TxHead = 0;
+  pHandle->TxTail = 0;
+  pHandle->TxSeq = 0;
+  pHandle->RxFrames = 0;
+  pHandle->RxErrors = 0;
+  pHandle->RxDropped = 0;
+
+  LL_USART_EnableIT_RXNE( pHandle->USARTx );
+}
+
+/**
+  * @brief  Decodes a received byte. A zero byte ends the frame, which is
+  *         queued if its CRC is valid and passed to a waiting client.
+  * @param  pHandle Pointer on the handle of the component.
+  * @param  rx_byte Received byte.
+  */
+void CFCP_RX_IRQ_Handler( CFCP_Handle_t * pHandle, uint8_t rx_byte )
+{
+  uint8_t next;
+
+  if ( 0u == rx_byte )
+  {
+    if ( 0u == pHandle->RxLen && 0u == pHandle->RxRemain && !pHandle->RxBad )
+    {
+      /* Empty frame, e.g. delimiters sent to flush the line */
+    }
+    else if ( pHandle->RxBad || ( pHandle->RxRemain != 0u ) || ( pHandle->RxCRC != 0u ) ||
+              ( pHandle->RxLen < CFCP_HEADER_SIZE + CFCP_CRC_SIZE ) )
+    {
+      pHandle->RxErrors++;
+    }
+    else
+    {
+      next = ( pHandle->RxHead + 1u ) % CFCP_RX_SLOTS;
+      if ( next != pHandle->RxTail )
+      {
+        pHandle->RxSlotLen[pHandle->RxHead] = pHandle->RxLen;
+        pHandle->RxHead = next;
+        pHandle->RxFrames++;
+      }
+      else
+      {
+        pHandle->RxDropped++;
+      }
+    }
+    CFCP_RxRestart( pHandle );
+    CFCP_Dispatch( pHandle );
+  }
+  else if ( !pHandle->RxBad )
+  {
+    if ( 0u == pHandle->RxRemain )
+    {
+      /* Code byte: the previous block ends with a zero, unless it was a full block */
+      if ( ( pHandle->RxBlock != 0xFFu ) )
+      {
+        CFCP_RxStore( pHandle, 0 );
+      }
+      pHandle->RxBlock = rx_byte;
+      pHandle->RxRemain = rx_byte - 1u;
+    }
+    else
+    {
+      CFCP_RxStore( pHandle, rx_byte );
+      pHandle->RxRemain--;
+    }
+  }
+  else
+  {
+    /* Wait for the next delimiter */
+  }
+}
+
+/**
+  * @brief  Sends the next byte of the transmit ring. Each sent delimiter may
+  *         make room for the answer of a queued request.
+  * @param  pHandle Pointer on the handle of the component.
+  */
+void CFCP_TX_IRQ_Handler( CFCP_Handle_t * pHandle )
+{
+  uint8_t tx_data;
+
+  if ( pHandle->TxTail != pHandle->TxHead )
+  {
+    tx_data = pHandle->TxRing[pHandle->TxTail];
+    LL_USART_TransmitData8( pHandle->USARTx, tx_data );
+    pHandle->TxTail = ( pHandle->TxTail + 1u ) & CFCP_TX_MASK;
+    if ( 0u == tx_data )
+    {
+      CFCP_Dispatch( pHandle );
+    }
+  }
+  else
+  {
+    LL_USART_DisableIT_TXE( pHandle->USARTx );
+  }
+}
+
+/**
+  * @brief  A byte was lost: the current frame is discarded, reception
+  *         resumes at the next delimiter.
+  * @param  pHandle Pointer on the handle of the component.
+  */
+void CFCP_OVR_IRQ_Handler( CFCP_Handle_t * pHandle )
+{
+  pHandle->RxBad = true;
+}
+
+/**
+  * @brief  The client waits for the next frame.
+  * @param  pHandle Pointer on the handle of the component.
+  * @retval FCP_STATUS_WAITING_TRANSFER or FCP_STATUS_TRANSFER_ONGOING if the
+  *         client was already waiting.
+  */
+uint8_t CFCP_Receive( FCP_Handle_t * pHandle )
+{
+  uint8_t ret_val;
+
+  if ( FCP_TRANSFER_IDLE == pHandle->RxFrameState )
+  {
+    pHandle->RxFrameState = FCP_TRANSFER_ONGOING;
+    ret_val = FCP_STATUS_WAITING_TRANSFER;
+  }
+  else
+  {
+    ret_val = FCP_STATUS_TRANSFER_ONGOING;
+  }
+
+  return ret_val;
+}
+
+/**
+  * @brief  Encodes a frame into the transmit ring and notifies the client.
+  * @param  pHandle Pointer on the handle of the component.
+  * @param  code Code of the frame.
+  * @param  buffer Payload of the frame.
+  * @param  size Size of the payload, at most FCP_MAX_PAYLOAD_SIZE.
+  * @retval FCP_STATUS_WAITING_TRANSFER, FCP_STATUS_INVALID_PARAMETER or
+  *         FCP_STATUS_TRANSFER_ONGOING if the transmit ring is full.
+  */
+uint8_t CFCP_Send( FCP_Handle_t * pHandle, uint8_t code, uint8_t *buffer, uint8_t size )
+{
+  CFCP_Handle_t * pActualHandle = (CFCP_Handle_t *) pHandle;
+  uint8_t * ring = pActualHandle->TxRing;
+  uint8_t header[CFCP_HEADER_SIZE];
+  uint8_t trailer[CFCP_CRC_SIZE];
+  uint8_t * pData;
+  uint16_t head;
+  uint16_t codePos;
+  uint16_t crc;
+  uint16_t idx;
+  uint8_t block;
+  uint8_t data;
+  uint8_t ret_val;
+
+  if ( size > FCP_MAX_PAYLOAD_SIZE )
+  {
+    return FCP_STATUS_INVALID_PARAMETER;
+  }
+
+  /* The ring is shared by the USART interrupt and the UI task */
+  NVIC_DisableIRQ( pActualHandle->USARTIRQn );
+  if ( CFCP_TxFree( pActualHandle ) < CFCP_MAX_ENCODED_SIZE )
+  {
+    ret_val = FCP_STATUS_TRANSFER_ONGOING;
+  }
+  else
+  {
+    header[0] = pActualHandle->TxSeq;
+    header[1] = code;
+    crc = crc16_update( CRC16InitVal, header, CFCP_HEADER_SIZE );
+    crc = crc16_update( crc, buffer, size );
+    trailer[0] = (uint8_t) crc;
+    trailer[1] = (uint8_t) ( crc >> 8 );
+
+    /* COBS: each block is a code byte (distance to the next zero) and the non zero bytes */
+    head = pActualHandle->TxHead;
+    codePos = head;
+    head = ( head + 1u ) & CFCP_TX_MASK;
+    block = 1;
+    for ( idx = 0; idx < CFCP_HEADER_SIZE + size + CFCP_CRC_SIZE; idx++ )
+    {
+      if ( idx < CFCP_HEADER_SIZE )
+      {
+        pData = & header[idx];
+      }
+      else if ( idx < CFCP_HEADER_SIZE + size )
+      {
+        pData = & buffer[idx - CFCP_HEADER_SIZE];
+      }
+      else
+      {
+        pData = & trailer[idx - CFCP_HEADER_SIZE - size];
+      }
+      data = *pData;
+      if ( data != 0u )
+      {
+        ring[head] = data;
+        head = ( head + 1u ) & CFCP_TX_MASK;
+        block++;
+      }
+      if ( ( 0u == data ) || ( 0xFFu == block ) )
+      {
+        ring[codePos] = block;
+        codePos = head;
+        head = ( head + 1u ) & CFCP_TX_MASK;
+        block = 1;
+      }
+    }
+    ring[codePos] = block;
+    ring[head] = 0;
+    pActualHandle->TxHead = ( head + 1u ) & CFCP_TX_MASK;
+
+    LL_USART_EnableIT_TXE( pActualHandle->USARTx );
+    ret_val = FCP_STATUS_WAITING_TRANSFER;
+  }
+  NVIC_EnableIRQ( pActualHandle->USARTIRQn );
+
+  if ( FCP_STATUS_WAITING_TRANSFER == ret_val )
+  {
+    pHandle->ClientFrameSentCallback( pHandle->ClientEntity );
+  }
+
+  return ret_val;
+}
+
+/**
+  * @brief  The client stops waiting for a frame. Queued frames are kept.
+  * @param  pHandle Pointer on the handle of the component.
+  */
+void CFCP_AbortReceive( FCP_Handle_t * pHandle )
+{
+  pHandle->RxFrameState = FCP_TRANSFER_IDLE;
+}
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/************************ (C) COPYRIGHT 2018 STMicroelectronics *****END OF FILE****/
@@ -131,6 +131,14 @@
 
 #define BLINKING_TIME   5  /* 5 * timebase_display_5 ms */
 
+/* Screen shadow: 10 lines of 20 characters, Font16x24 */
+#define LCDV_ROWS         (uint8_t)10
+#define LCDV_COLUMNS      (uint8_t)20
+#define LCDV_CELL_WIDTH   (uint16_t)16
+#define LCDV_CELL_HEIGHT  (uint16_t)24
+#define LCDV_BACK_COLOR   White
+#define LCDV_MAX_RECTS    (uint8_t)2
+
 #define VISUALIZATION_1   (uint8_t)1
 #define VISUALIZATION_2   (uint8_t)2
 #define VISUALIZATION_3   (uint8_t)3
@@ -246,12 +254,49 @@ static uint8_t bKey;
 static uint8_t bPrevious_key;
 static uint8_t bKey_Flag;
 
+/* Glyph cell of the screen shadow */
+typedef struct
+{
+  uint8_t bAscii;
+  uint16_t hColor;
+} LCDV_Cell_t;
+
+/* Decimal point drawn over the glyphs */
+typedef struct
+{
+  uint16_t hXpos;
+  uint16_t hYpos;
+  uint8_t bHeight;
+  uint16_t hWidth;
+  uint16_t hColor;
+  uint8_t bFirstRow;  /* Cells under the decimal point */
+  uint8_t bLastRow;
+  uint32_t wColumns;
+} LCDV_Rect_t;
+
+static LCDV_Cell_t LCDV_Screen[LCDV_ROWS][LCDV_COLUMNS]; /* Content of the panel after LCDV_Flush */
+static uint32_t wLCDV_Dirty[LCDV_ROWS];                  /* Cells changed since the last flush, bit per column */
+static LCDV_Rect_t LCDV_Rects[LCDV_MAX_RECTS];
+static uint8_t bLCDV_RectNum;
+static LCDV_Rect_t LCDV_ShownRects[LCDV_MAX_RECTS];      /* Decimal points on the panel after LCDV_Flush */
+static uint8_t bLCDV_ShownRectNum;
+static uint16_t hLCDV_TextColor = Black;
+
 
 static void Display_5DigitSignedNumber(uint8_t Line, uint8_t bFirstchar, int16_t number);
 static void Display_3DigitUnsignedNumber(uint8_t Line, uint8_t bFirstchar, int16_t number);
 static void Display_1DigitUnsignedNumber(uint8_t Line, uint8_t bFirstchar, uint8_t number);
 static void Display_5dot_line(uint16_t Line, uint16_t Column);
 static void DisplayChar(uint16_t Line, uint16_t Column, uint8_t Ascii);
+static void LCDV_SetTextColor(uint16_t Color);
+static void LCDV_DisplayStringLine(uint16_t Line, uint8_t *ptr);
+static void LCDV_ClearLine(uint16_t Line);
+static void LCDV_DrawRect(uint16_t Xpos, uint16_t Ypos, uint8_t Height, uint16_t Width);
+static bool LCDV_RectFound(const LCDV_Rect_t *pRect, const LCDV_Rect_t *pRects, uint8_t bRectNum);
+static uint16_t LCDV_CellXpos(uint8_t bColumn);
+static void LCDV_Invalidate(void);
+static void LCDV_Repaint(void);
+static void LCDV_Flush(void);
 static bool JOY_Pressed(InputKey inKey);
 static uint8_t ComputeVisualization(uint8_t bLocal_MenuIndex, State_t State);
 static uint8_t LCDV_DACIDToSel(MC_Protocol_REG_t ID);
@@ -334,10 +379,11 @@ void LCDV_Init(UI_Handle_t *pHandle, UI_Handle_t *pDAC, const char* s_fwVer)
   /* Initialize the LCD */
   LCD_HW_Init();
 
-  LCD_Clear(White);
+  LCD_Clear(LCDV_BACK_COLOR);
 
-  LCD_SetBackColor(White);
-  LCD_SetTextColor(Black);
+  LCD_SetBackColor(LCDV_BACK_COLOR);
+  LCDV_Invalidate();
+  LCDV_SetTextColor(Black);
 
   /* Initialize Joystick */
   STM_EVAL_JOYInit();
@@ -345,13 +391,13 @@ void LCDV_Init(UI_Handle_t *pHandle, UI_Handle_t *pDAC, const char* s_fwVer)
   /* Welcome message */
   ptr = " STM32 Motor Control";
 
-  LCD_DisplayStringLine(Line0, ptr);
+  LCDV_DisplayStringLine(Line0, ptr);
 
   ptr = "  PMSM FOC ver 5.0  ";
-  LCD_DisplayStringLine(Line1, ptr);
+  LCDV_DisplayStringLine(Line1, ptr);
 
   ptr = " <> Move  ^| Change ";
-  LCD_DisplayStringLine(Line9, ptr);
+  LCDV_DisplayStringLine(Line9, ptr);
 
   /* Initialize vars */
   pHdl->pDAC = (DAC_UI_Handle_t *)pDAC;
@@ -362,6 +408,8 @@ void LCDV_Init(UI_Handle_t *pHandle, UI_Handle_t *pDAC, const char* s_fwVer)
   pHdl->bDAC_Size = LCDV_DACIDToSel((MC_Protocol_REG_t)(GUI_DAC_ChID_LAST_ELEMENT));
 
   pHdl->Iqdref = STC_GetDefaultIqdref(pSTC);
+
+  LCDV_Flush();
 }
 
 /**
@@ -414,6 +462,7 @@ void LCDV_Exec(UI_Handle_t *pHandle,  UI_Handle_t *pDAC)
   */
 void LCDV_UpdateAll(UI_Handle_t *pHandle)
 {
+  LCDV_Repaint();
 }
 
 /**
@@ -531,65 +580,65 @@ void Display_LCD(UI_Handle_t *pHandle)
   case VISUALIZATION_1:
     if (bPresent_Visualization != bPrevious_Visualization)
     {
-      LCD_ClearLine(Line3);
+      LCDV_ClearLine(Line3);
 
-      LCD_ClearLine(Line4);
+      LCDV_ClearLine(Line4);
 
       ptr = " Target     Measured";
-      LCD_DisplayStringLine(Line5,ptr);
+      LCDV_DisplayStringLine(Line5,ptr);
 
       ptr = "       (rpm)        ";
-      LCD_DisplayStringLine(Line7,ptr);
+      LCDV_DisplayStringLine(Line7,ptr);
 
-      LCD_ClearLine(Line6);
+      LCDV_ClearLine(Line6);
 
-      LCD_ClearLine(Line8);
+      LCDV_ClearLine(Line8);
 
       ptr = " <> Move  ^| Change ";
-      LCD_DisplayStringLine(Line9, ptr);
+      LCDV_DisplayStringLine(Line9, ptr);
     }
 
     if (bMenu_index == MOTOR_SPD_MENU)
     {
-      LCD_SetTextColor(Red);
+      LCDV_SetTextColor(Red);
     }
     else
     {
-      LCD_SetTextColor(Blue);
+      LCDV_SetTextColor(Blue);
     }
 
     ptr = "      Motor ";
-    LCD_DisplayStringLine(Line2,ptr);
+    LCDV_DisplayStringLine(Line2,ptr);
 
     temp = pHandle->bSelectedDrive;
     Display_1DigitUnsignedNumber(Line2, CHAR_12, temp + 1); /* Zero based */
 
     if(bMenu_index == CONTROL_MODE_SPEED_MENU)
     {
-      LCD_SetTextColor(Red);
+      LCDV_SetTextColor(Red);
     }
     else
     {
-      LCD_SetTextColor(Blue);
+      LCDV_SetTextColor(Blue);
     }
 
     ptr = " Speed control mode";
-    LCD_DisplayStringLine(Line3,ptr);
+    LCDV_DisplayStringLine(Line3,ptr);
 
     if(bMenu_index == REF_SPEED_MENU)
     {
-      LCD_SetTextColor(Red);
+      LCDV_SetTextColor(Red);
     }
     else
     {
-      LCD_SetTextColor(Blue);
+      LCDV_SetTextColor(Blue);
     }
 
     /* Compute target speed in rpm */
     temp = (int16_t)(MCI_GetLastRampFinalSpeed(pMCI) * 6);
     Display_5DigitSignedNumber(Line7, CHAR_0, temp);
 
-    LCD_SetTextColor(Blue);
+    LCDV_SetTextColor(Blue);
 
     /* Compute measured speed in rpm */
     temp = (int16_t)(MCI_GetAvrgMecSpeed01Hz(pMCI) * 6);
@@ -601,33 +650,33 @@ void Display_LCD(UI_Handle_t *pHandle)
     if (bPresent_Visualization != bPrevious_Visualization)
     {
       ptr = "       Speed        ";
-      LCD_DisplayStringLine(Line2,ptr);
+      LCDV_DisplayStringLine(Line2,ptr);
 
       ptr = "    P     I     D   ";
-      LCD_DisplayStringLine(Line3,ptr);
+      LCDV_DisplayStringLine(Line3,ptr);
 
-      LCD_ClearLine(Line4);
-      LCD_ClearLine(Line5);
+      LCDV_ClearLine(Line4);
+      LCDV_ClearLine(Line5);
 
       ptr = " Target        (rpm)";
-      LCD_DisplayStringLine(Line6,ptr);
+      LCDV_DisplayStringLine(Line6,ptr);
 
       ptr = " Measured      (rpm)";
-      LCD_DisplayStringLine(Line7,ptr);
+      LCDV_DisplayStringLine(Line7,ptr);
 
-      LCD_ClearLine(Line8);
+      LCDV_ClearLine(Line8);
 
       ptr = " <> Move  ^| Change ";
-      LCD_DisplayStringLine(Line9, ptr);
+      LCDV_DisplayStringLine(Line9, ptr);
     }
 
     switch(bMenu_index)
     {
     case P_SPEED_MENU:
-      LCD_SetTextColor(Red);
+      LCDV_SetTextColor(Red);
       temp = PID_GetKP(pSpeedLoopPID);
       Display_5DigitSignedNumber(Line4, CHAR_1, temp);
-      LCD_SetTextColor(Blue);
+      LCDV_SetTextColor(Blue);
 
       temp = PID_GetKI(pSpeedLoopPID);
       Display_5DigitSignedNumber(Line4, CHAR_7, temp);
@@ -645,10 +694,10 @@ void Display_LCD(UI_Handle_t *pHandle)
       temp = PID_GetKP(pSpeedLoopPID);
       Display_5DigitSignedNumber(Line4, CHAR_1, temp);
 
-      LCD_SetTextColor(Red);
+      LCDV_SetTextColor(Red);
       temp = PID_GetKI(pSpeedLoopPID);
       Display_5DigitSignedNumber(Line4, CHAR_7, temp);
-      LCD_SetTextColor(Blue);
+      LCDV_SetTextColor(Blue);
 
 #ifdef DIFFERENTIAL_TERM_ENABLED
       temp = PID_GetKD((CPID_PI)pSpeedLoopPID);
@@ -666,10 +715,10 @@ void Display_LCD(UI_Handle_t *pHandle)
       temp = PID_GetKI(pSpeedLoopPID);
       Display_5DigitSignedNumber(Line4, CHAR_7, temp);
 
-      LCD_SetTextColor(Red);
+      LCDV_SetTextColor(Red);
       temp = PID_GetKD((CPID_PI)pSpeedLoopPID);
       Display_5DigitSignedNumber(Line4, CHAR_13, temp);
-      LCD_SetTextColor(Blue);
+      LCDV_SetTextColor(Blue);
 
       break;
 #endif
@@ -692,33 +741,33 @@ void Display_LCD(UI_Handle_t *pHandle)
     if (bPresent_Visualization != bPrevious_Visualization)
     {
       ptr = "       Torque       ";
-      LCD_DisplayStringLine(Line2,ptr);
+      LCDV_DisplayStringLine(Line2,ptr);
 
       ptr = "    P     I     D   ";
-      LCD_DisplayStringLine(Line3,ptr);
+      LCDV_DisplayStringLine(Line3,ptr);
 
-      LCD_ClearLine(Line4);
-      LCD_ClearLine(Line5);
+      LCDV_ClearLine(Line4);
+      LCDV_ClearLine(Line5);
 
       ptr = " Target         (Iq)";
-      LCD_DisplayStringLine(Line6,ptr);
+      LCDV_DisplayStringLine(Line6,ptr);
 
       ptr = " Measured       (Iq)";
-      LCD_DisplayStringLine(Line7,ptr);
+      LCDV_DisplayStringLine(Line7,ptr);
 
-      LCD_ClearLine(Line8);
+      LCDV_ClearLine(Line8);
 
       ptr = " <> Move  ^| Change ";
-      LCD_DisplayStringLine(Line9, ptr);
+      LCDV_DisplayStringLine(Line9, ptr);
     }
 
     switch(bMenu_index)
     {
     case P_TORQUE_MENU:
-      LCD_SetTextColor(Red);
+      LCDV_SetTextColor(Red);
       temp = PID_GetKP(pIqLoopPID);;
       Display_5DigitSignedNumber(Line4, CHAR_1, temp);
-      LCD_SetTextColor(Blue);
+      LCDV_SetTextColor(Blue);
 
       temp = PID_GetKI(pIqLoopPID);;
       Display_5DigitSignedNumber(Line4, CHAR_7, temp);
@@ -735,10 +784,10 @@ void Display_LCD(UI_Handle_t *pHandle)
       temp = PID_GetKP(pIqLoopPID);;
       Display_5DigitSignedNumber(Line4, CHAR_1, temp);
 
-      LCD_SetTextColor(Red);
+      LCDV_SetTextColor(Red);
       temp = PID_GetKI(pIqLoopPID);;
       Display_5DigitSignedNumber(Line4, CHAR_7, temp);
-      LCD_SetTextColor(Blue);
+      LCDV_SetTextColor(Blue);
 
 #ifdef DIFFERENTIAL_TERM_ENABLED
       temp = PID_GetKD((CPID_PI)pIqLoopPID);
@@ -756,10 +805,10 @@ void Display_LCD(UI_Handle_t *pHandle)
       temp = PID_GetKI(pIqLoopPID);;
       Display_5DigitSignedNumber(Line4, CHAR_7, temp);
 
-      LCD_SetTextColor(Red);
+      LCDV_SetTextColor(Red);
       temp = PID_GetKD((CPID_PI)pIqLoopPID);
       Display_5DigitSignedNumber(Line4, CHAR_13, temp);
-      LCD_SetTextColor(Blue);
+      LCDV_SetTextColor(Blue);
 
       break;
 #endif
@@ -780,33 +829,33 @@ void Display_LCD(UI_Handle_t *pHandle)
     if (bPresent_Visualization != bPrevious_Visualization)
     {
       ptr = "        Flux        ";
-      LCD_DisplayStringLine(Line2,ptr);
+      LCDV_DisplayStringLine(Line2,ptr);
 
       ptr = "    P     I     D   ";
-      LCD_DisplayStringLine(Line3,ptr);
+      LCDV_DisplayStringLine(Line3,ptr);
 
-      LCD_ClearLine(Line4);
-      LCD_ClearLine(Line5);
+      LCDV_ClearLine(Line4);
+      LCDV_ClearLine(Line5);
 
       ptr = " Target         (Id)";
-      LCD_DisplayStringLine(Line6,ptr);
+      LCDV_DisplayStringLine(Line6,ptr);
 
       ptr = " Measured       (Id)";
-      LCD_DisplayStringLine(Line7,ptr);
+      LCDV_DisplayStringLine(Line7,ptr);
 
-      LCD_ClearLine(Line8);
+      LCDV_ClearLine(Line8);
 
       ptr = " <> Move  ^| Change ";
-      LCD_DisplayStringLine(Line9, ptr);
+      LCDV_DisplayStringLine(Line9, ptr);
     }
 
     switch(bMenu_index)
     {
     case P_FLUX_MENU:
-      LCD_SetTextColor(Red);
+      LCDV_SetTextColor(Red);
       temp = PID_GetKP(pIdLoopPID);;
       Display_5DigitSignedNumber(Line4, CHAR_1, temp);
-      LCD_SetTextColor(Blue);
+      LCDV_SetTextColor(Blue);
 
       temp = PID_GetKI(pIdLoopPID);;
       Display_5DigitSignedNumber(Line4, CHAR_7, temp);
@@ -823,10 +872,10 @@ void Display_LCD(UI_Handle_t *pHandle)
       temp = PID_GetKP(pIdLoopPID);;
       Display_5DigitSignedNumber(Line4, CHAR_1, temp);
 
-      LCD_SetTextColor(Red);
+      LCDV_SetTextColor(Red);
       temp = PID_GetKI(pIdLoopPID);;
       Display_5DigitSignedNumber(Line4, CHAR_7, temp);
-      LCD_SetTextColor(Blue);
+      LCDV_SetTextColor(Blue);
 
 #ifdef DIFFERENTIAL_TERM_ENABLED
       temp = PID_GetKD((CPID_PI)pIdLoopPID);
@@ -844,10 +893,10 @@ void Display_LCD(UI_Handle_t *pHandle)
       temp = PID_GetKI(pIdLoopPID);;
       Display_5DigitSignedNumber(Line4, CHAR_7, temp);
 
-      LCD_SetTextColor(Red);
+      LCDV_SetTextColor(Red);
       temp = PID_GetKD((CPID_PI)pIdLoopPID);
       Display_5DigitSignedNumber(Line4, CHAR_13, temp);
-      LCD_SetTextColor(Blue);
+      LCDV_SetTextColor(Blue);
 
       break;
 #endif
@@ -869,39 +918,39 @@ void Display_LCD(UI_Handle_t *pHandle)
     if (bPresent_Visualization != bPrevious_Visualization)
     {
       ptr = "Flux Weakening Ctrl ";
-      LCD_DisplayStringLine(Line2,ptr);
+      LCDV_DisplayStringLine(Line2,ptr);
 
       ptr = "    P     I         ";
-      LCD_DisplayStringLine(Line3,ptr);
+      LCDV_DisplayStringLine(Line3,ptr);
 
-      LCD_ClearLine(Line4);
-      LCD_ClearLine(Line5);
+      LCDV_ClearLine(Line4);
+      LCDV_ClearLine(Line5);
 
       ptr = " Target        (Vs%)";
-      LCD_DisplayStringLine(Line6,ptr);
+      LCDV_DisplayStringLine(Line6,ptr);
 
       ptr = " Measured      (Vs%)";
-      LCD_DisplayStringLine(Line7,ptr);
+      LCDV_DisplayStringLine(Line7,ptr);
 
-      LCD_ClearLine(Line8);
+      LCDV_ClearLine(Line8);
 
       ptr = " <> Move  ^| Change ";
-      LCD_DisplayStringLine(Line9, ptr);
+      LCDV_DisplayStringLine(Line9, ptr);
     }
 
     switch(bMenu_index)
     {
     case P_VOLT_MENU:
-      LCD_SetTextColor(Red);
+      LCDV_SetTextColor(Red);
       temp = PID_GetKP(pFluxWeakeningLoopPID);
       Display_5DigitSignedNumber(Line4, CHAR_1, temp);
 
-      LCD_SetTextColor(Blue);
+      LCDV_SetTextColor(Blue);
       temp = PID_GetKI(pFluxWeakeningLoopPID);
       Display_5DigitSignedNumber(Line4, CHAR_7, temp);
       temp = FW_GetVref(pFWCtrl);
       Display_5DigitSignedNumber(Line6, CHAR_9, temp);
-      LCD_DrawRect(161,97,1,2);
+      LCDV_DrawRect(161,97,1,2);
 
       Display_5dot_line(Line4, 18);
 
@@ -913,23 +962,23 @@ void Display_LCD(UI_Handle_t *pHandle)
       temp = FW_GetVref(pFWCtrl);
       Display_5DigitSignedNumber(Line6, CHAR_9, temp);
 
-      LCD_SetTextColor(Red);
+      LCDV_SetTextColor(Red);
       temp = PID_GetKI(pFluxWeakeningLoopPID);
       Display_5DigitSignedNumber(Line4, CHAR_7, temp);
-      LCD_SetTextColor(Blue);
-      LCD_DrawRect(161,97,1,2);
+      LCDV_SetTextColor(Blue);
+      LCDV_DrawRect(161,97,1,2);
 
       Display_5dot_line(Line4, 18);
 
       break;
 
     case TARGET_VOLT_MENU:
-      LCD_SetTextColor(Red);
+      LCDV_SetTextColor(Red);
       temp = FW_GetVref(pFWCtrl);
       Display_5DigitSignedNumber(Line6, CHAR_9, temp);
-      LCD_DrawRect(161,97,1,2);
+      LCDV_DrawRect(161,97,1,2);
 
-      LCD_SetTextColor(Blue);
+      LCDV_SetTextColor(Blue);
       temp = PID_GetKP(pFluxWeakeningLoopPID);
       Display_5DigitSignedNumber(Line4, CHAR_1, temp);
       temp = PID_GetKI(pFluxWeakeningLoopPID);
@@ -948,32 +997,32 @@ void Display_LCD(UI_Handle_t *pHandle)
     //Compute applied voltage in int16_t
     temp = FW_GetAvVPercentage(pFWCtrl);
     Display_5DigitSignedNumber(Line7, CHAR_9, temp);
-    LCD_DrawRect(185,97,1,2);
+    LCDV_DrawRect(185,97,1,2);
     break;
 #endif
 
   case VISUALIZATION_5:
     if (bPresent_Visualization != bPrevious_Visualization)
     {
-      LCD_ClearLine(Line2);
+      LCDV_ClearLine(Line2);
 
       ptr = " Power Stage Status ";
-      LCD_DisplayStringLine(Line3, ptr);
+      LCDV_DisplayStringLine(Line3, ptr);
 
-      LCD_ClearLine(Line4);
+      LCDV_ClearLine(Line4);
 
       ptr = "  DC bus =     Volt ";
-      LCD_DisplayStringLine(Line5, ptr);
+      LCDV_DisplayStringLine(Line5, ptr);
 
-      LCD_ClearLine(Line6);
+      LCDV_ClearLine(Line6);
 
       ptr = "  T =      Celsius  ";
-      LCD_DisplayStringLine(Line7, ptr);
+      LCDV_DisplayStringLine(Line7, ptr);
 
-      LCD_ClearLine(Line8);
+      LCDV_ClearLine(Line8);
 
       ptr = " <> Move            ";
-      LCD_DisplayStringLine(Line9, ptr);
+      LCDV_DisplayStringLine(Line9, ptr);
     }
 
     temp = VBS_GetAvBusVoltage_V(pVBS);
@@ -987,74 +1036,74 @@ void Display_LCD(UI_Handle_t *pHandle)
   case VISUALIZATION_6:
     if (bPresent_Visualization != bPrevious_Visualization)
     {
-      LCD_ClearLine(Line3);
+      LCDV_ClearLine(Line3);
 
       ptr = "     Target Measured";
-      LCD_DisplayStringLine(Line4,ptr);
+      LCDV_DisplayStringLine(Line4,ptr);
 
       ptr = "Iq                  ";
-      LCD_DisplayStringLine(Line5,ptr);
+      LCDV_DisplayStringLine(Line5,ptr);
 
       ptr = "Id                  ";
-      LCD_DisplayStringLine(Line6,ptr);
+      LCDV_DisplayStringLine(Line6,ptr);
 
       ptr = "Speed (rpm)         ";
-      LCD_DisplayStringLine(Line7,ptr);
+      LCDV_DisplayStringLine(Line7,ptr);
 
-      LCD_ClearLine(Line8);
+      LCDV_ClearLine(Line8);
 
       ptr = " <> Move  ^| Change ";
-      LCD_DisplayStringLine(Line9, ptr);
+      LCDV_DisplayStringLine(Line9, ptr);
     }
     if (bMenu_index == MOTOR_TRQ_MENU)
     {
-      LCD_SetTextColor(Red);
+      LCDV_SetTextColor(Red);
     }
     else
     {
-      LCD_SetTextColor(Blue);
+      LCDV_SetTextColor(Blue);
     }
 
     ptr = "      Motor ";
-    LCD_DisplayStringLine(Line2,ptr);
+    LCDV_DisplayStringLine(Line2,ptr);
 
     temp = pHandle->bSelectedDrive;
     Display_1DigitUnsignedNumber(Line2, CHAR_12, temp + 1); /* Zero based */
 
     if (bMenu_index == CONTROL_MODE_TORQUE_MENU)
     {
-      LCD_SetTextColor(Red);
+      LCDV_SetTextColor(Red);
     }
     else
     {
-      LCD_SetTextColor(Blue);
+      LCDV_SetTextColor(Blue);
     }
     ptr = "Torque control mode ";
-    LCD_DisplayStringLine(Line3,ptr);
+    LCDV_DisplayStringLine(Line3,ptr);
 
     if (bMenu_index == IQ_REF_MENU)
     {
-      LCD_SetTextColor(Red);
+      LCDV_SetTextColor(Red);
     }
     else
     {
-      LCD_SetTextColor(Blue);
+      LCDV_SetTextColor(Blue);
     }
     temp = pHdl->Iqdref.qI_Component1;
     Display_5DigitSignedNumber(Line5, CHAR_5, temp);
 
     if (bMenu_index == ID_REF_MENU)
     {
-      LCD_SetTextColor(Red);
+      LCDV_SetTextColor(Red);
     }
     else
     {
-      LCD_SetTextColor(Blue);
+      LCDV_SetTextColor(Blue);
     }
     temp = pHdl->Iqdref.qI_Component2;
     Display_5DigitSignedNumber(Line6, CHAR_5, temp);
 
-    LCD_SetTextColor(Blue);
+    LCDV_SetTextColor(Blue);
 
     temp = MCI_GetIqd(pMCI).qI_Component1;
     Display_5DigitSignedNumber(Line5, CHAR_13, temp);
@@ -1070,60 +1119,60 @@ void Display_LCD(UI_Handle_t *pHandle)
   case VISUALIZATION_7:
     if (bPresent_Visualization != bPrevious_Visualization)
     {
-      LCD_SetTextColor(Red);
+      LCDV_SetTextColor(Red);
 
       ptr = "      Motor ";
-      LCD_DisplayStringLine(Line2,ptr);
+      LCDV_DisplayStringLine(Line2,ptr);
 
       temp = pHandle->bSelectedDrive;
       Display_1DigitUnsignedNumber(Line2, CHAR_12, temp + 1); /* Zero based */
 
       ptr = "    !!! FAULT !!!   ";
-      LCD_DisplayStringLine(Line3,ptr);
-      LCD_SetTextColor(Blue);
+      LCDV_DisplayStringLine(Line3,ptr);
+      LCDV_SetTextColor(Blue);
 
       if ( (hOccurredFault & MC_UNDER_VOLT) == MC_UNDER_VOLT)
       {
         ptr = " Bus Under Voltage  ";
-        LCD_DisplayStringLine(Line4, ptr);
+        LCDV_DisplayStringLine(Line4, ptr);
       }
       else if ( (hOccurredFault & MC_BREAK_IN) ==  MC_BREAK_IN)
       {
         ptr = "   Over Current    ";
-        LCD_DisplayStringLine(Line4, ptr);
+        LCDV_DisplayStringLine(Line4, ptr);
       }
       else if ( (hOccurredFault & MC_OVER_TEMP) ==  MC_OVER_TEMP)
       {
         ptr = "   Over Heating    ";
-        LCD_DisplayStringLine(Line4, ptr);
+        LCDV_DisplayStringLine(Line4, ptr);
       }
       else if ( (hOccurredFault & MC_OVER_VOLT) ==  MC_OVER_VOLT)
       {
         ptr = "  Bus Over Voltage  ";
-        LCD_DisplayStringLine(Line4, ptr);
+        LCDV_DisplayStringLine(Line4, ptr);
       }
       else if ( (hOccurredFault & MC_START_UP) ==  MC_START_UP)
       {
         ptr = "  Start-up failed   ";
-        LCD_DisplayStringLine(Line4, ptr);
+        LCDV_DisplayStringLine(Line4, ptr);
       }
       else if ( (hOccurredFault & MC_SPEED_FDBK) ==  MC_SPEED_FDBK)
       {
         ptr = "Error on speed fdbck";
-        LCD_DisplayStringLine(Line4, ptr);
+        LCDV_DisplayStringLine(Line4, ptr);
       }
-      LCD_ClearLine(Line5);
-      LCD_ClearLine(Line7);
+      LCDV_ClearLine(Line5);
+      LCDV_ClearLine(Line7);
     }
 
     if ((hCurrentFault & ( MC_OVER_TEMP | MC_UNDER_VOLT | MC_OVER_VOLT)) == 0)
     {
-      LCD_ClearLine(Line6);
+      LCDV_ClearLine(Line6);
       ptr = "   Press 'Key' to   ";
-      LCD_DisplayStringLine(Line8,ptr);
+      LCDV_DisplayStringLine(Line8,ptr);
 
       ptr = "   return to menu   ";
-      LCD_DisplayStringLine(Line9,ptr);
+      LCDV_DisplayStringLine(Line9,ptr);
     }
     else
     {
@@ -1132,11 +1181,11 @@ void Display_LCD(UI_Handle_t *pHandle)
         /* Under or over voltage */
         if (bPresent_Visualization != bPrevious_Visualization)
         {
-          LCD_ClearLine(Line6);
+          LCDV_ClearLine(Line6);
         }
         temp = NTC_GetAvTemp_C(pTNC);
         ptr = "       T =";
-        LCD_DisplayStringLine(Line6, ptr);
+        LCDV_DisplayStringLine(Line6, ptr);
         Display_3DigitUnsignedNumber(Line6, CHAR_11, temp);
         DisplayChar(Line6, CHAR_14, ' ');
         DisplayChar(Line6, CHAR_15, 'C');
@@ -1145,36 +1194,36 @@ void Display_LCD(UI_Handle_t *pHandle)
       {
         if (bPresent_Visualization != bPrevious_Visualization)
         {
-          LCD_ClearLine(Line6);
+          LCDV_ClearLine(Line6);
         }
         ptr = "  DC bus =";
-        LCD_DisplayStringLine(Line6, ptr);
+        LCDV_DisplayStringLine(Line6, ptr);
         temp = VBS_GetAvBusVoltage_V(pVBS);
         Display_3DigitUnsignedNumber(Line6, CHAR_11, temp);
         DisplayChar(Line6, CHAR_14, ' ');
         DisplayChar(Line6, CHAR_15, 'V');
       }
-      LCD_ClearLine(Line8);
-      LCD_ClearLine(Line9);
+      LCDV_ClearLine(Line8);
+      LCDV_ClearLine(Line9);
     }
     break;
 
   case VISUALIZATION_8:
     if (bPresent_Visualization != bPrevious_Visualization)
     {
-      LCD_ClearLine(Line2);
+      LCDV_ClearLine(Line2);
 
       ptr = " Motor is stopping  ";
-      LCD_DisplayStringLine(Line3,ptr);
+      LCDV_DisplayStringLine(Line3,ptr);
 
       ptr = "   please wait...   ";
-      LCD_DisplayStringLine(Line4,ptr);
+      LCDV_DisplayStringLine(Line4,ptr);
 
-      LCD_ClearLine(Line5);
-      LCD_ClearLine(Line6);
-      LCD_ClearLine(Line7);
-      LCD_ClearLine(Line8);
-      LCD_ClearLine(Line9);
+      LCDV_ClearLine(Line5);
+      LCDV_ClearLine(Line6);
+      LCDV_ClearLine(Line7);
+      LCDV_ClearLine(Line8);
+      LCDV_ClearLine(Line9);
     }
     break;
 
@@ -1183,35 +1232,35 @@ void Display_LCD(UI_Handle_t *pHandle)
     if (bPresent_Visualization != bPrevious_Visualization)
     {
       ptr = "   Observer Gains   ";
-      LCD_DisplayStringLine(Line2,ptr);
+      LCDV_DisplayStringLine(Line2,ptr);
 
       ptr = "     K1       K2    ";
-      LCD_DisplayStringLine(Line3,ptr);
+      LCDV_DisplayStringLine(Line3,ptr);
 
-      LCD_ClearLine(Line4);
+      LCDV_ClearLine(Line4);
 
       ptr = "      PLL Gains     ";
-      LCD_DisplayStringLine(Line5,ptr);
+      LCDV_DisplayStringLine(Line5,ptr);
 
       ptr = "     P        I     ";
-      LCD_DisplayStringLine(Line6,ptr);
+      LCDV_DisplayStringLine(Line6,ptr);
 
-      LCD_ClearLine(Line7);
+      LCDV_ClearLine(Line7);
 
-      LCD_ClearLine(Line8);
+      LCDV_ClearLine(Line8);
 
       ptr = " <> Move  ^| Change ";
-      LCD_DisplayStringLine(Line9, ptr);
+      LCDV_DisplayStringLine(Line9, ptr);
     }
 
     switch(bMenu_index)
     {
     case K1_MENU:
-      LCD_SetTextColor(Red);
+      LCDV_SetTextColor(Red);
       temp = UI_GetReg(pHandle, MC_PROTOCOL_REG_OBSERVER_C1);
       Display_5DigitSignedNumber(Line4, CHAR_3, temp);
 
-      LCD_SetTextColor(Blue);
+      LCDV_SetTextColor(Blue);
       temp = UI_GetReg(pHandle, MC_PROTOCOL_REG_OBSERVER_C2);
       Display_5DigitSignedNumber(Line4, CHAR_12, temp);
 
@@ -1226,11 +1275,11 @@ void Display_LCD(UI_Handle_t *pHandle)
       temp = UI_GetReg(pHandle, MC_PROTOCOL_REG_OBSERVER_C1);
       Display_5DigitSignedNumber(Line4, CHAR_3, temp);
 
-      LCD_SetTextColor(Red);
+      LCDV_SetTextColor(Red);
       temp = UI_GetReg(pHandle, MC_PROTOCOL_REG_OBSERVER_C2);
       Display_5DigitSignedNumber(Line4, CHAR_12, temp);
 
-      LCD_SetTextColor(Blue);
+      LCDV_SetTextColor(Blue);
       temp = UI_GetReg(pHandle, MC_PROTOCOL_REG_PLL_KP);
       Display_5DigitSignedNumber(Line7, CHAR_3, temp);
 
@@ -1245,11 +1294,11 @@ void Display_LCD(UI_Handle_t *pHandle)
       temp = UI_GetReg(pHandle, MC_PROTOCOL_REG_OBSERVER_C2);
       Display_5DigitSignedNumber(Line4, CHAR_12, temp);
 
-      LCD_SetTextColor(Red);
+      LCDV_SetTextColor(Red);
       temp = UI_GetReg(pHandle, MC_PROTOCOL_REG_PLL_KP);
       Display_5DigitSignedNumber(Line7, CHAR_3, temp);
 
-      LCD_SetTextColor(Blue);
+      LCDV_SetTextColor(Blue);
       temp = UI_GetReg(pHandle, MC_PROTOCOL_REG_PLL_KI);
       Display_5DigitSignedNumber(Line7, CHAR_12, temp);
       break;
@@ -1264,10 +1313,10 @@ void Display_LCD(UI_Handle_t *pHandle)
       temp = UI_GetReg(pHandle, MC_PROTOCOL_REG_PLL_KP);
       Display_5DigitSignedNumber(Line7, CHAR_3, temp);
 
-      LCD_SetTextColor(Red);
+      LCDV_SetTextColor(Red);
       temp = UI_GetReg(pHandle, MC_PROTOCOL_REG_PLL_KI);
       Display_5DigitSignedNumber(Line7, CHAR_12, temp);
-      LCD_SetTextColor(Blue);
+      LCDV_SetTextColor(Blue);
       break;
     default:
       break;
@@ -1279,46 +1328,46 @@ void Display_LCD(UI_Handle_t *pHandle)
   case VISUALIZATION_10:
     if (bPresent_Visualization != bPrevious_Visualization)
     {
-      LCD_ClearLine(Line2);
+      LCDV_ClearLine(Line2);
 
       ptr = "    Signal on PB0   ";
-      LCD_DisplayStringLine(Line3,ptr);
+      LCDV_DisplayStringLine(Line3,ptr);
 
-      LCD_ClearLine(Line4);
+      LCDV_ClearLine(Line4);
 
-      LCD_ClearLine(Line5);
+      LCDV_ClearLine(Line5);
 
       ptr = "    Signal on PB1   ";
-      LCD_DisplayStringLine(Line6,ptr);
+      LCDV_DisplayStringLine(Line6,ptr);
 
-      LCD_ClearLine(Line7);
+      LCDV_ClearLine(Line7);
 
-      LCD_ClearLine(Line8);
+      LCDV_ClearLine(Line8);
 
       ptr = " <> Move  ^| Change ";
-      LCD_DisplayStringLine(Line9, ptr);
+      LCDV_DisplayStringLine(Line9, ptr);
     }
 
     switch(bMenu_index)
     {
     case DAC_PB0_MENU:
-      LCD_SetTextColor(Red);
+      LCDV_SetTextColor(Red);
       ptr = (uint8_t*)(GUI_DAC_ChTxt[pHdl->bDAC_CH0_Sel]);
-      LCD_DisplayStringLine(Line4, ptr);
+      LCDV_DisplayStringLine(Line4, ptr);
 
-      LCD_SetTextColor(Blue);
+      LCDV_SetTextColor(Blue);
       ptr = (uint8_t*)(GUI_DAC_ChTxt[pHdl->bDAC_CH1_Sel]);
-      LCD_DisplayStringLine(Line7, ptr);
+      LCDV_DisplayStringLine(Line7, ptr);
       break;
 
     case DAC_PB1_MENU:
       ptr = (uint8_t*)(GUI_DAC_ChTxt[pHdl->bDAC_CH0_Sel]);
-      LCD_DisplayStringLine(Line4, ptr);
+      LCDV_DisplayStringLine(Line4, ptr);
 
-      LCD_SetTextColor(Red);
+      LCDV_SetTextColor(Red);
       ptr = (uint8_t*)(GUI_DAC_ChTxt[pHdl->bDAC_CH1_Sel]);
-      LCD_DisplayStringLine(Line7, ptr);
-      LCD_SetTextColor(Blue);
+      LCDV_DisplayStringLine(Line7, ptr);
+      LCDV_SetTextColor(Blue);
       break;
 
     default:
@@ -1329,6 +1378,9 @@ void Display_LCD(UI_Handle_t *pHandle)
   default:
     break;
   }
+
+  /* Send only the glyph cells changed by this refresh */
+  LCDV_Flush();
 }
 
 /*******************************************************************************
@@ -1405,7 +1457,9 @@ static void Display_5dot_line(uint16_t Line, uint16_t Column)
 
 /*******************************************************************************
 * Function Name  : DisplayChar
-* Description    : Wrapper function for the Std.lib.  LCD_DisplayChar
+* Description    : Puts the character with the present text color into the
+*                  screen shadow. The cell is sent to the panel by LCDV_Flush
+*                  only if it differs from what the panel shows.
 * Input          : Line, Column, Ascii
 *                  number
 * Output         : None
@@ -1413,12 +1467,281 @@ static void Display_5dot_line(uint16_t Line, uint16_t Column)
 *******************************************************************************/
 static void DisplayChar(uint16_t Line, uint16_t Column, uint8_t Ascii)
 {
-  uint16_t xpos = 16*Column;
+  uint8_t bRow = (uint8_t)(Line / LCDV_CELL_HEIGHT);
+  /* Color of a blank cell does not matter */
+  uint16_t hColor = (Ascii == ' ') ? LCDV_BACK_COLOR : hLCDV_TextColor;
+  LCDV_Cell_t *pCell;
+
+  if ((bRow < LCDV_ROWS) && (Column < LCDV_COLUMNS))
+  {
+    pCell = &LCDV_Screen[bRow][Column];
+    if ((pCell->bAscii != Ascii) || (pCell->hColor != hColor))
+    {
+      pCell->bAscii = Ascii;
+      pCell->hColor = hColor;
+      wLCDV_Dirty[bRow] |= (uint32_t)1 << Column;
+    }
+  }
+}
+
+/*******************************************************************************
+* Function Name  : LCDV_SetTextColor
+* Description    : Text color of the next characters put into the shadow
+* Input          : Color
+* Output         : None
+* Return         : None
+*******************************************************************************/
+static void LCDV_SetTextColor(uint16_t Color)
+{
+  hLCDV_TextColor = Color;
+}
+
+/*******************************************************************************
+* Function Name  : LCDV_DisplayStringLine
+* Description    : Puts the string into the shadow, starting from the first
+*                  character of the line, like LCD_DisplayStringLine
+* Input          : Line, ptr
+* Output         : None
+* Return         : None
+*******************************************************************************/
+static void LCDV_DisplayStringLine(uint16_t Line, uint8_t *ptr)
+{
+  uint16_t hColumn;
+
+  for (hColumn = 0; (hColumn < LCDV_COLUMNS) && (ptr[hColumn] != 0); hColumn++)
+  {
+    DisplayChar(Line, hColumn, ptr[hColumn]);
+  }
+}
+
+/*******************************************************************************
+* Function Name  : LCDV_ClearLine
+* Description    : Blanks the line in the shadow
+* Input          : Line
+* Output         : None
+* Return         : None
+*******************************************************************************/
+static void LCDV_ClearLine(uint16_t Line)
+{
+  uint16_t hColumn;
+
+  for (hColumn = 0; hColumn < LCDV_COLUMNS; hColumn++)
+  {
+    DisplayChar(Line, hColumn, ' ');
+  }
+}
+
+/*******************************************************************************
+* Function Name  : LCDV_DrawRect
+* Description    : Queues a decimal point, it is drawn by LCDV_Flush after the
+*                  glyphs, which would otherwise cover it. The cells under it
+*                  are those of the Xpos lines and of the glyphs overlapping
+*                  Ypos - Width + 1 to Ypos. LCD_DisplayChar draws a glyph
+*                  from its xpos toward lower panel columns, as LCD_DrawRect
+*                  draws from Ypos to Ypos - Width + 1.
+* Input          : Xpos, Ypos, Height, Width as LCD_DrawRect
+* Output         : None
+* Return         : None
+*******************************************************************************/
+static void LCDV_DrawRect(uint16_t Xpos, uint16_t Ypos, uint8_t Height, uint16_t Width)
+{
+  LCDV_Rect_t *pRect;
+  uint8_t bColumn;
+  int32_t wXpos;
+
+  if (bLCDV_RectNum < LCDV_MAX_RECTS)
+  {
+    pRect = &LCDV_Rects[bLCDV_RectNum];
+    pRect->hXpos = Xpos;
+    pRect->hYpos = Ypos;
+    pRect->bHeight = Height;
+    pRect->hWidth = Width;
+    pRect->hColor = hLCDV_TextColor;
+    pRect->bFirstRow = (uint8_t)(Xpos / LCDV_CELL_HEIGHT);
+    pRect->bLastRow = (uint8_t)((Xpos + Height) / LCDV_CELL_HEIGHT);
+    if (pRect->bLastRow >= LCDV_ROWS)
+    {
+      pRect->bLastRow = LCDV_ROWS - 1u;
+    }
+    pRect->wColumns = 0;
+    for (bColumn = 0; bColumn < LCDV_COLUMNS; bColumn++)
+    {
+      wXpos = (int32_t)LCDV_CellXpos(bColumn);
+      if ((wXpos + (int32_t)Width > (int32_t)Ypos) &&
+          (wXpos < (int32_t)Ypos + (int32_t)LCDV_CELL_WIDTH))
+      {
+        pRect->wColumns |= (uint32_t)1 << bColumn;
+      }
+    }
+    bLCDV_RectNum++;
+  }
+}
+
+/*******************************************************************************
+* Function Name  : LCDV_RectFound
+* Description    : Tells if the same decimal point, with the same color, is in
+*                  the list
+* Input          : pRect, pRects, bRectNum
+* Output         : None
+* Return         : true if found
+*******************************************************************************/
+static bool LCDV_RectFound(const LCDV_Rect_t *pRect, const LCDV_Rect_t *pRects, uint8_t bRectNum)
+{
+  bool bFound = false;
+  uint8_t bRect;
+
+  for (bRect = 0; bRect < bRectNum; bRect++)
+  {
+    if ((pRects[bRect].hXpos == pRect->hXpos) && (pRects[bRect].hYpos == pRect->hYpos) &&
+        (pRects[bRect].bHeight == pRect->bHeight) && (pRects[bRect].hWidth == pRect->hWidth) &&
+        (pRects[bRect].hColor == pRect->hColor))
+    {
+      bFound = true;
+    }
+  }
+  return (bFound);
+}
+
+/*******************************************************************************
+* Function Name  : LCDV_CellXpos
+* Description    : Column of the panel passed to LCD_DisplayChar for a cell
+* Input          : bColumn
+* Output         : None
+* Return         : xpos
+*******************************************************************************/
+static uint16_t LCDV_CellXpos(uint8_t bColumn)
+{
+  uint16_t xpos = LCDV_CELL_WIDTH * bColumn;
+
   if (LCD_GetXAxesDirection() == LCD_X_AXES_INVERTED)
   {
-    xpos = 320-xpos;
+    xpos = 320 - xpos;
+  }
+  return (xpos);
+}
+
+/*******************************************************************************
+* Function Name  : LCDV_Invalidate
+* Description    : The panel was cleared: shadow is blank and every cell is
+*                  sent again by the next LCDV_Flush
+* Input          : None
+* Output         : None
+* Return         : None
+*******************************************************************************/
+static void LCDV_Invalidate(void)
+{
+  uint8_t bRow, bColumn;
+
+  for (bRow = 0; bRow < LCDV_ROWS; bRow++)
+  {
+    for (bColumn = 0; bColumn < LCDV_COLUMNS; bColumn++)
+    {
+      LCDV_Screen[bRow][bColumn].bAscii = ' ';
+      LCDV_Screen[bRow][bColumn].hColor = LCDV_BACK_COLOR;
+    }
+  }
+  LCDV_Repaint();
+}
+
+/*******************************************************************************
+* Function Name  : LCDV_Repaint
+* Description    : Every cell of the shadow and every queued decimal point is
+*                  sent again by the next LCDV_Flush
+* Input          : None
+* Output         : None
+* Return         : None
+*******************************************************************************/
+static void LCDV_Repaint(void)
+{
+  uint8_t bRow;
+
+  for (bRow = 0; bRow < LCDV_ROWS; bRow++)
+  {
+    wLCDV_Dirty[bRow] = ((uint32_t)1 << LCDV_COLUMNS) - 1u;
+  }
+  bLCDV_ShownRectNum = 0;
+}
+
+/*******************************************************************************
+* Function Name  : LCDV_Flush
+* Description    : Sends the changed cells to the panel in one pass, line by
+*                  line, then the queued decimal points. Text color is set only
+*                  when it changes. A decimal point of the last flush, which is
+*                  not queued again, is erased by sending the cells under it.
+*                  A queued one is drawn if it is new or a cell under it is
+*                  sent.
+* Input          : None
+* Output         : None
+* Return         : None
+*******************************************************************************/
+static void LCDV_Flush(void)
+{
+  uint8_t bRow, bColumn, bRect;
+  uint8_t bRectsToDraw = 0;
+  uint16_t hColor = LCDV_BACK_COLOR;
+  uint32_t wDirty;
+  LCDV_Cell_t *pCell;
+  LCDV_Rect_t *pRect;
+
+  for (bRect = 0; bRect < bLCDV_ShownRectNum; bRect++)
+  {
+    pRect = &LCDV_ShownRects[bRect];
+    if (!LCDV_RectFound(pRect, LCDV_Rects, bLCDV_RectNum))
+    {
+      for (bRow = pRect->bFirstRow; bRow <= pRect->bLastRow; bRow++)
+      {
+        wLCDV_Dirty[bRow] |= pRect->wColumns;
+      }
+    }
+  }
+
+  for (bRect = 0; bRect < bLCDV_RectNum; bRect++)
+  {
+    pRect = &LCDV_Rects[bRect];
+    if (!LCDV_RectFound(pRect, LCDV_ShownRects, bLCDV_ShownRectNum))
+    {
+      bRectsToDraw |= (uint8_t)(1u << bRect);
+    }
+    for (bRow = pRect->bFirstRow; bRow <= pRect->bLastRow; bRow++)
+    {
+      if ((wLCDV_Dirty[bRow] & pRect->wColumns) != 0u)
+      {
+        bRectsToDraw |= (uint8_t)(1u << bRect);
+      }
+    }
+  }
+
+  for (bRow = 0; bRow < LCDV_ROWS; bRow++)
+  {
+    wDirty = wLCDV_Dirty[bRow];
+    wLCDV_Dirty[bRow] = 0;
+    for (bColumn = 0; wDirty != 0; bColumn++, wDirty >>= 1)
+    {
+      if (wDirty & 1u)
+      {
+        pCell = &LCDV_Screen[bRow][bColumn];
+        if (pCell->hColor != hColor)
+        {
+          hColor = pCell->hColor;
+          LCD_SetTextColor(hColor);
+        }
+        LCD_DisplayChar(LCDV_CELL_HEIGHT * bRow, LCDV_CellXpos(bColumn), pCell->bAscii);
+      }
+    }
+  }
+
+  for (bRect = 0; bRect < bLCDV_RectNum; bRect++)
+  {
+    pRect = &LCDV_Rects[bRect];
+    if ((bRectsToDraw & (1u << bRect)) != 0u)
+    {
+      LCD_SetTextColor(pRect->hColor);
+      LCD_DrawRect(pRect->hXpos, pRect->hYpos, pRect->bHeight, pRect->hWidth);
+    }
+    LCDV_ShownRects[bRect] = *pRect;
   }
-  LCD_DisplayChar(Line, xpos, Ascii);
+  bLCDV_ShownRectNum = bLCDV_RectNum;
+  bLCDV_RectNum = 0;
 }
 
 
@@ -1761,7 +2084,7 @@ uint8_t KEYS_Read ( void )
 * Output         : None
 * Return         : None
 *******************************************************************************/
-static void KEYS_process(UI_Handle_t *pHandle)
+void KEYS_process(UI_Handle_t *pHandle)
 {
 
   LCDV_Handle_t *pHdl = (LCDV_Handle_t *)pHandle;
@@ -21,6 +21,9 @@
 #include 		"crc16.h"
 #include 		"ModbusClient.h"
 #include 		"motor_control_protocol.h"
+#include 		"mc_api.h"
+#include 		"CO_Flash.h"
+#include 		"CO_FlashKV.h"
 
 #ifndef __MODBUS_USER_C
 #define __MODBUS_USER_C
@@ -46,6 +49,8 @@
 #define MB_FUN_RFQ			24			//24 (18Hex) Read FIFO Queue
 
 uint8_t mbAddr;
+static int32_t	mbSetpoint;						//本机待锁存的设定值
+static bool		mbSetpointPending;				//已收到设定值，等待触发
 //STR_MB_MODE mbMode;
 //*************************** private constant define ***************************
 
@@ -58,8 +63,105 @@ uint8_t mbAddr;
 **说    明：MODBUS协议初始化程序
 ************************************************************************/
 void  ModBus_CFGInit(void){
+	uint8_t	cfg[2];
+
     mbAddr = 1;
+	mbSetpointPending = false;
+	if(CO_FlashKV_read(CO_FLASH_KEY_MODBUS, cfg, sizeof(cfg)) == CO_ERROR_NO){
+		if((cfg[0] >= 1)&&(cfg[0] <= MB_SLAVE_ADDR_MAX)){
+			mbAddr = cfg[0];
+		}
+	}
+}
+
+/**********************************************************************
+**函数原型： uint32_t MB_GetLong(uint8_t *pData)
+**入口参数:	*pData 		:2个寄存器的数据，高字节在前
+**出口参数:	无
+**返 回 值：32位数值
+**说    明：取2个寄存器组成的32位数值
+************************************************************************/
+static uint32_t MB_GetLong(uint8_t *pData)
+{
+	return ((uint32_t)pData[0]<<24)|((uint32_t)pData[1]<<16)|((uint32_t)pData[2]<<8)|(uint32_t)pData[3];
+}
+
+/**********************************************************************
+**函数原型： bool MB_MotorIdle(void)
+**入口参数:	无
+**出口参数:	无
+**返 回 值：true PWM已关闭
+**说    明：flash编程时CPU停止，从机地址只在电机停止时保存
+************************************************************************/
+static bool MB_MotorIdle(void)
+{
+	State_t	state	=	MCI_GetSTMStateMotor1();
 
+	return (state == IDLE || state == STOP || state == STOP_IDLE ||
+			state == FAULT_NOW || state == FAULT_OVER) ? true : false;
+}
+
+/**********************************************************************
+**函数原型： uint8_t RTU_SYNC(MCP_Handle_t *pHandle,uint8_t *pRecvBuf,uint16_t regAddr,uint16_t dataLen)
+**入口参数:	*pRecvBuf 	:接收数据指针
+**			regAddr		:起始寄存器编号
+**			dataLen		:寄存器数量
+**出口参数:	无
+**返 回 值：0 成功，其它 异常
+**说    明：16功能码写多机同步寄存器。本机从设定值向量中取出自己的槽位，
+**			写触发寄存器时锁存待定的设定值并执行转速斜坡
+************************************************************************/
+static uint8_t RTU_SYNC(MCP_Handle_t *pHandle,uint8_t *pRecvBuf,uint16_t regAddr,uint16_t dataLen)
+{
+	uint8_t		*pData;
+	uint8_t		cfg[2];
+	uint16_t	slotReg;
+	uint32_t	wValue;
+	MCI_Handle_t	*pMCI;
+
+	pData = &pRecvBuf[7];
+	if(pRecvBuf[6] != (uint8_t)(dataLen*2)){
+		return ILLEGAL_DATA_VALUE;
+	}
+	if(regAddr == MB_REG_SLAVE_ADDR){
+		//广播写地址会使所有从机地址相同
+		if((pRecvBuf[0] == BROADCAST_ADDRESS)||(dataLen != 2)){
+			return ILLEGAL_DATA_ADDR;
+		}
+		wValue = MB_GetLong(pData);
+		if((wValue < 1)||(wValue > MB_SLAVE_ADDR_MAX)){
+			return ILLEGAL_DATA_VALUE;
+		}
+		if(!MB_MotorIdle()){
+			return SLAVE_DEVICE_BUSY;
+		}
+		cfg[0] = (uint8_t)wValue;
+		cfg[1] = 0;
+		if(CO_FlashKV_write(CO_FLASH_KEY_MODBUS, cfg, sizeof(cfg)) != CO_ERROR_NO){
+			return SLAVE_DEVICE_FAILURE;
+		}
+		mbAddr = (uint8_t)wValue;				//本次应答仍使用原地址
+		return MB_NO_ERR;
+	}
+	if((regAddr < MB_REG_SYNC_TRIGGER)||(regAddr & 1)||(dataLen & 1)){
+		return ILLEGAL_DATA_ADDR;
+	}
+	//设定值向量中本机的槽位，不在本帧范围内则保持原值
+	slotReg = MB_REG_SETPOINT_BASE + ((uint16_t)(mbAddr - 1) << 1);
+	if((slotReg >= regAddr)&&((uint32_t)slotReg + 2 <= (uint32_t)regAddr + dataLen)){
+		mbSetpoint = (int32_t)MB_GetLong(&pData[(slotReg - regAddr) << 1]);
+		mbSetpointPending = true;
+	}
+	//触发寄存器：向量先写入，所有从机在同一帧锁存
+	if(regAddr == MB_REG_SYNC_TRIGGER){
+		wValue = MB_GetLong(pData);
+		if(mbSetpointPending){
+			pMCI = pHandle->_Super.pMCI[pHandle->_Super.bSelectedDrive];
+			MCI_ExecSpeedRamp(pMCI,(int16_t)(mbSetpoint/6),(wValue > 0xFFFFu) ? 0xFFFFu : (uint16_t)wValue);
+			mbSetpointPending = false;
+		}
+	}
+	return MB_NO_ERR;
 }
 
 /**********************************************************************
@@ -129,6 +231,7 @@ static uint8_t RTU_PMR(MCP_Handle_t *pHandle,uint8_t *pRecvBuf,uint8_t *pSendBuf
 	uint8_t	*pSend;
 	uint8_t	*pRecv;
 	bool	res;
+	uint8_t	err;
 	uint16_t	regAddr;
 	uint16_t	dataLen;
 	uint32_t	wValue	=	0;
@@ -143,17 +246,23 @@ static uint8_t RTU_PMR(MCP_Handle_t *pHandle,uint8_t *pRecvBuf,uint8_t *pSendBuf
 		return ILLEGAL_LEN;
 	}
 	regAddr = pRecv[3] + (((uint16_t)pRecv[2]) << 8);
-	wValue	=	(uint32_t)pRecv[7]<<24 ;
-	wValue	|=	(uint32_t)pRecv[8]<<16 ;
-	wValue	|=	(uint32_t)pRecv[9]<<8 ;
-	wValue	|=	(uint32_t)pRecv[10]<<0 ;
-	res	=	UI_SetReg(&pHandle->_Super,(MC_Protocol_REG_t)(regAddr>>1),wValue);
-	if(!res)			//16预制多个寄存器，与03对应
+	if(regAddr >= MB_REG_SLAVE_ADDR){		//多机同步寄存器
+		err	=	RTU_SYNC(pHandle,pRecv,regAddr,dataLen);
+	}
+	else{
+		wValue	=	(uint32_t)pRecv[7]<<24 ;
+		wValue	|=	(uint32_t)pRecv[8]<<16 ;
+		wValue	|=	(uint32_t)pRecv[9]<<8 ;
+		wValue	|=	(uint32_t)pRecv[10]<<0 ;
+		res	=	UI_SetReg(&pHandle->_Super,(MC_Protocol_REG_t)(regAddr>>1),wValue);
+		err	=	res ? MB_NO_ERR : SLAVE_DEVICE_FAILURE;
+	}
+	if(err != MB_NO_ERR)			//16预制多个寄存器，与03对应
 	{
 		*pSend++ = pRecv[1] + 0x80;
-		*pSend++ = SLAVE_DEVICE_FAILURE;
+		*pSend++ = err;
 		*pLen = pSend-pSendBuf;
-		return SLAVE_DEVICE_FAILURE;
+		return err;
 	}
 	else{
 	  	*pSend++ = pRecv[1];			//功能码
@@ -208,12 +317,24 @@ uint8_t RtuModbusParse(MCP_Handle_t *pHandle,uint8_t *pRecvBuf,uint8_t *pSendBuf
 {
 	uint8_t err;
 	uint16_t crc;
+	if(*pLen < 4){							//地址+功能码+CRC
+		*pLen = 0;
+		return ILLEGAL_LEN;
+	}
 	crc = pRecvBuf[*pLen-2]+(((uint16_t)pRecvBuf[*pLen-1])<<8);
 	if(crc != crc16(pRecvBuf,*pLen-2))	{
 		*pLen = 0;
 		return ILLEGAL_CRC;
 	}
-	else if((*pRecvBuf == mbAddr)||(*pRecvBuf == BROADCAST_ADDRESS))
+	else if(*pRecvBuf == BROADCAST_ADDRESS)	{
+		//广播帧只执行写入，所有从机都不应答，避免总线冲突
+		if(pRecvBuf[1] == MB_FUN_PMR){
+			RTU_PMR(pHandle,pRecvBuf,pSendBuf,pLen);
+		}
+		*pLen = 0;
+		return MB_NO_REPLY;
+	}
+	else if(*pRecvBuf == mbAddr)
 	{
 		switch(pRecvBuf[1])					//功能码判断
 		{
@@ -52,6 +52,7 @@ extern "C" {
 //#define GATEWAY_TARGET_DEV_FAIL     0x0B
 #define ILLEGAL_MODBUS_ADDR         0x0C		//不是本机地址
 #define ILLEGAL_CRC                 0x0D									//crc错误
+#define MB_NO_REPLY                 0x0E									//广播帧已执行，不应答
 //#define MB_FUN_NOT_DEF              0x80		                 /*  未定义功能代码              */
 //#define MB_THE_CH_BUSY				0x81		                        /*  管道忙，正被使用            */
 //#define MB_RESPONSE_TIME_OUT		0x82		                        /*  应答超时                    */
@@ -66,6 +67,16 @@ extern "C" {
 *********************************************************************************************************/
 #define	BROADCAST_ADDRESS	0
 #define LOCAL_ADDRESS     255 
+#define MB_SLAVE_ADDR_MAX	247
+/*********************************************************************************************************
+    多机同步寄存器（modbus寄存器编号，每个值占2个寄存器，高字在前）
+    从机地址只能单播写入，写入后保存到flash；设定值向量和触发寄存器用16功能码广播写入。
+    从机n的设定值位于 MB_REG_SETPOINT_BASE+(n-1)*2，写触发寄存器时所有从机同时锁存各自的设定值。
+    触发寄存器紧邻在向量之前，一帧写入触发寄存器和向量即可同时更新全部从机。
+*********************************************************************************************************/
+#define MB_REG_SLAVE_ADDR		0x1000		//从机地址 1~MB_SLAVE_ADDR_MAX
+#define MB_REG_SYNC_TRIGGER		0x10FE		//锁存设定值，写入值为斜坡时间ms
+#define MB_REG_SETPOINT_BASE	0x1100		//设定值向量，斜坡最终转速rpm
 /*********************************************************************************************************
     Modbus 配置相关宏定义																   
 *********************************************************************************************************/
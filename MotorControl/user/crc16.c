@@ -8,62 +8,123 @@
 #include <stdio.h>
 #include "crc16.h"
 
-#define	CRC16InitVal		0xFFFF
-
-//=================== Table of ModbusCrc values for low–order byte ===================
-static uint8_t uchCRCLTable[] = {
-0x00,0xC1,0x81,0x40,0x01,0xC0,0x80,0x41,0x01,0xC0,0x80,0x41,0x00,0xC1,0x81,0x40,//00~0f
-0x01,0xC0,0x80,0x41,0x00,0xC1,0x81,0x40,0x00,0xC1,0x81,0x40,0x01,0xC0,0x80,0x41,//10~1f
-0x01,0xC0,0x80,0x41,0x00,0xC1,0x81,0x40,0x00,0xC1,0x81,0x40,0x01,0xC0,0x80,0x41,//20~2f
-0x00,0xC1,0x81,0x40,0x01,0xC0,0x80,0x41,0x01,0xC0,0x80,0x41,0x00,0xC1,0x81,0x40,//30~3f
-0x01,0xC0,0x80,0x41,0x00,0xC1,0x81,0x40,0x00,0xC1,0x81,0x40,0x01,0xC0,0x80,0x41,//40~4f
-0x00,0xC1,0x81,0x40,0x01,0xC0,0x80,0x41,0x01,0xC0,0x80,0x41,0x00,0xC1,0x81,0x40,//50~5f
-0x00,0xC1,0x81,0x40,0x01,0xC0,0x80,0x41,0x01,0xC0,0x80,0x41,0x00,0xC1,0x81,0x40,//60~6f
-0x01,0xC0,0x80,0x41,0x00,0xC1,0x81,0x40,0x00,0xC1,0x81,0x40,0x01,0xC0,0x80,0x41,//70~7f
-0x01,0xC0,0x80,0x41,0x00,0xC1,0x81,0x40,0x00,0xC1,0x81,0x40,0x01,0xC0,0x80,0x41,//80~8f
-0x00,0xC1,0x81,0x40,0x01,0xC0,0x80,0x41,0x01,0xC0,0x80,0x41,0x00,0xC1,0x81,0x40,//90~9f
-0x00,0xC1,0x81,0x40,0x01,0xC0,0x80,0x41,0x01,0xC0,0x80,0x41,0x00,0xC1,0x81,0x40,//a0~af
-0x01,0xC0,0x80,0x41,0x00,0xC1,0x81,0x40,0x00,0xC1,0x81,0x40,0x01,0xC0,0x80,0x41,//b0~bf
-0x00,0xC1,0x81,0x40,0x01,0xC0,0x80,0x41,0x01,0xC0,0x80,0x41,0x00,0xC1,0x81,0x40,//c0~cf
-0x01,0xC0,0x80,0x41,0x00,0xC1,0x81,0x40,0x00,0xC1,0x81,0x40,0x01,0xC0,0x80,0x41,//d0~df
-0x01,0xC0,0x80,0x41,0x00,0xC1,0x81,0x40,0x00,0xC1,0x81,0x40,0x01,0xC0,0x80,0x41,//e0~ef
-0x00,0xC1,0x81,0x40,0x01,0xC0,0x80,0x41,0x01,0xC0,0x80,0x41,0x00,0xC1,0x81,0x40 //f0~ff
+//=================== Slice-by-4 tables of the reflected Modbus polynomial 0xA001 ===================
+//  uiCRCTable[0][n]: CRC of byte n, uiCRCTable[k][n]: same byte followed by k zero bytes.
+//  4 bytes are folded into the CRC with 4 independent lookups, 2 KB of flash.
+static const uint16_t uiCRCTable[4][256] = {
+{
+0x0000,0xC0C1,0xC181,0x0140,0xC301,0x03C0,0x0280,0xC241,0xC601,0x06C0,0x0780,0xC741,0x0500,0xC5C1,0xC481,0x0440,//00~0f
+0xCC01,0x0CC0,0x0D80,0xCD41,0x0F00,0xCFC1,0xCE81,0x0E40,0x0A00,0xCAC1,0xCB81,0x0B40,0xC901,0x09C0,0x0880,0xC841,//10~1f
+0xD801,0x18C0,0x1980,0xD941,0x1B00,0xDBC1,0xDA81,0x1A40,0x1E00,0xDEC1,0xDF81,0x1F40,0xDD01,0x1DC0,0x1C80,0xDC41,//20~2f
+0x1400,0xD4C1,0xD581,0x1540,0xD701,0x17C0,0x1680,0xD641,0xD201,0x12C0,0x1380,0xD341,0x1100,0xD1C1,0xD081,0x1040,//30~3f
+0xF001,0x30C0,0x3180,0xF141,0x3300,0xF3C1,0xF281,0x3240,0x3600,0xF6C1,0xF781,0x3740,0xF501,0x35C0,0x3480,0xF441,//40~4f
+0x3C00,0xFCC1,0xFD81,0x3D40,0xFF01,0x3FC0,0x3E80,0xFE41,0xFA01,0x3AC0,0x3B80,0xFB41,0x3900,0xF9C1,0xF881,0x3840,//50~5f
+0x2800,0xE8C1,0xE981,0x2940,0xEB01,0x2BC0,0x2A80,0xEA41,0xEE01,0x2EC0,0x2F80,0xEF41,0x2D00,0xEDC1,0xEC81,0x2C40,//60~6f
+0xE401,0x24C0,0x2580,0xE541,0x2700,0xE7C1,0xE681,0x2640,0x2200,0xE2C1,0xE381,0x2340,0xE101,0x21C0,0x2080,0xE041,//70~7f
+0xA001,0x60C0,0x6180,0xA141,0x6300,0xA3C1,0xA281,0x6240,0x6600,0xA6C1,0xA781,0x6740,0xA501,0x65C0,0x6480,0xA441,//80~8f
+0x6C00,0xACC1,0xAD81,0x6D40,0xAF01,0x6FC0,0x6E80,0xAE41,0xAA01,0x6AC0,0x6B80,0xAB41,0x6900,0xA9C1,0xA881,0x6840,//90~9f
+0x7800,0xB8C1,0xB981,0x7940,0xBB01,0x7BC0,0x7A80,0xBA41,0xBE01,0x7EC0,0x7F80,0xBF41,0x7D00,0xBDC1,0xBC81,0x7C40,//a0~af
+0xB401,0x74C0,0x7580,0xB541,0x7700,0xB7C1,0xB681,0x7640,0x7200,0xB2C1,0xB381,0x7340,0xB101,0x71C0,0x7080,0xB041,//b0~bf
+0x5000,0x90C1,0x9181,0x5140,0x9301,0x53C0,0x5280,0x9241,0x9601,0x56C0,0x5780,0x9741,0x5500,0x95C1,0x9481,0x5440,//c0~cf
+0x9C01,0x5CC0,0x5D80,0x9D41,0x5F00,0x9FC1,0x9E81,0x5E40,0x5A00,0x9AC1,0x9B81,0x5B40,0x9901,0x59C0,0x5880,0x9841,//d0~df
+0x8801,0x48C0,0x4980,0x8941,0x4B00,0x8BC1,0x8A81,0x4A40,0x4E00,0x8EC1,0x8F81,0x4F40,0x8D01,0x4DC0,0x4C80,0x8C41,//e0~ef
+0x4400,0x84C1,0x8581,0x4540,0x8701,0x47C0,0x4680,0x8641,0x8201,0x42C0,0x4380,0x8341,0x4100,0x81C1,0x8081,0x4040 //f0~ff
+},
+{
+0x0000,0x9001,0x6001,0xF000,0xC002,0x5003,0xA003,0x3002,0xC007,0x5006,0xA006,0x3007,0x0005,0x9004,0x6004,0xF005,//00~0f
+0xC00D,0x500C,0xA00C,0x300D,0x000F,0x900E,0x600E,0xF00F,0x000A,0x900B,0x600B,0xF00A,0xC008,0x5009,0xA009,0x3008,//10~1f
+0xC019,0x5018,0xA018,0x3019,0x001B,0x901A,0x601A,0xF01B,0x001E,0x901F,0x601F,0xF01E,0xC01C,0x501D,0xA01D,0x301C,//20~2f
+0x0014,0x9015,0x6015,0xF014,0xC016,0x5017,0xA017,0x3016,0xC013,0x5012,0xA012,0x3013,0x0011,0x9010,0x6010,0xF011,//30~3f
+0xC031,0x5030,0xA030,0x3031,0x0033,0x9032,0x6032,0xF033,0x0036,0x9037,0x6037,0xF036,0xC034,0x5035,0xA035,0x3034,//40~4f
+0x003C,0x903D,0x603D,0xF03C,0xC03E,0x503F,0xA03F,0x303E,0xC03B,0x503A,0xA03A,0x303B,0x0039,0x9038,0x6038,0xF039,//50~5f
+0x0028,0x9029,0x6029,0xF028,0xC02A,0x502B,0xA02B,0x302A,0xC02F,0x502E,0xA02E,0x302F,0x002D,0x902C,0x602C,0xF02D,//60~6f
+0xC025,0x5024,0xA024,0x3025,0x0027,0x9026,0x6026,0xF027,0x0022,0x9023,0x6023,0xF022,0xC020,0x5021,0xA021,0x3020,//70~7f
+0xC061,0x5060,0xA060,0x3061,0x0063,0x9062,0x6062,0xF063,0x0066,0x9067,0x6067,0xF066,0xC064,0x5065,0xA065,0x3064,//80~8f
+0x006C,0x906D,0x606D,0xF06C,0xC06E,0x506F,0xA06F,0x306E,0xC06B,0x506A,0xA06A,0x306B,0x0069,0x9068,0x6068,0xF069,//90~9f
+0x0078,0x9079,0x6079,0xF078,0xC07A,0x507B,0xA07B,0x307A,0xC07F,0x507E,0xA07E,0x307F,0x007D,0x907C,0x607C,0xF07D,//a0~af
+0xC075,0x5074,0xA074,0x3075,0x0077,0x9076,0x6076,0xF077,0x0072,0x9073,0x6073,0xF072,0xC070,0x5071,0xA071,0x3070,//b0~bf
+0x0050,0x9051,0x6051,0xF050,0xC052,0x5053,0xA053,0x3052,0xC057,0x5056,0xA056,0x3057,0x0055,0x9054,0x6054,0xF055,//c0~cf
+0xC05D,0x505C,0xA05C,0x305D,0x005F,0x905E,0x605E,0xF05F,0x005A,0x905B,0x605B,0xF05A,0xC058,0x5059,0xA059,0x3058,//d0~df
+0xC049,0x5048,0xA048,0x3049,0x004B,0x904A,0x604A,0xF04B,0x004E,0x904F,0x604F,0xF04E,0xC04C,0x504D,0xA04D,0x304C,//e0~ef
+0x0044,0x9045,0x6045,0xF044,0xC046,0x5047,0xA047,0x3046,0xC043,0x5042,0xA042,0x3043,0x0041,0x9040,0x6040,0xF041 //f0~ff
+},
+{
+0x0000,0xC051,0xC0A1,0x00F0,0xC141,0x0110,0x01E0,0xC1B1,0xC281,0x02D0,0x0220,0xC271,0x03C0,0xC391,0xC361,0x0330,//00~0f
+0xC501,0x0550,0x05A0,0xC5F1,0x0440,0xC411,0xC4E1,0x04B0,0x0780,0xC7D1,0xC721,0x0770,0xC6C1,0x0690,0x0660,0xC631,//10~1f
+0xCA01,0x0A50,0x0AA0,0xCAF1,0x0B40,0xCB11,0xCBE1,0x0BB0,0x0880,0xC8D1,0xC821,0x0870,0xC9C1,0x0990,0x0960,0xC931,//20~2f
+0x0F00,0xCF51,0xCFA1,0x0FF0,0xCE41,0x0E10,0x0EE0,0xCEB1,0xCD81,0x0DD0,0x0D20,0xCD71,0x0CC0,0xCC91,0xCC61,0x0C30,//30~3f
+0xD401,0x1450,0x14A0,0xD4F1,0x1540,0xD511,0xD5E1,0x15B0,0x1680,0xD6D1,0xD621,0x1670,0xD7C1,0x1790,0x1760,0xD731,//40~4f
+0x1100,0xD151,0xD1A1,0x11F0,0xD041,0x1010,0x10E0,0xD0B1,0xD381,0x13D0,0x1320,0xD371,0x12C0,0xD291,0xD261,0x1230,//50~5f
+0x1E00,0xDE51,0xDEA1,0x1EF0,0xDF41,0x1F10,0x1FE0,0xDFB1,0xDC81,0x1CD0,0x1C20,0xDC71,0x1DC0,0xDD91,0xDD61,0x1D30,//60~6f
+0xDB01,0x1B50,0x1BA0,0xDBF1,0x1A40,0xDA11,0xDAE1,0x1AB0,0x1980,0xD9D1,0xD921,0x1970,0xD8C1,0x1890,0x1860,0xD831,//70~7f
+0xE801,0x2850,0x28A0,0xE8F1,0x2940,0xE911,0xE9E1,0x29B0,0x2A80,0xEAD1,0xEA21,0x2A70,0xEBC1,0x2B90,0x2B60,0xEB31,//80~8f
+0x2D00,0xED51,0xEDA1,0x2DF0,0xEC41,0x2C10,0x2CE0,0xECB1,0xEF81,0x2FD0,0x2F20,0xEF71,0x2EC0,0xEE91,0xEE61,0x2E30,//90~9f
+0x2200,0xE251,0xE2A1,0x22F0,0xE341,0x2310,0x23E0,0xE3B1,0xE081,0x20D0,0x2020,0xE071,0x21C0,0xE191,0xE161,0x2130,//a0~af
+0xE701,0x2750,0x27A0,0xE7F1,0x2640,0xE611,0xE6E1,0x26B0,0x2580,0xE5D1,0xE521,0x2570,0xE4C1,0x2490,0x2460,0xE431,//b0~bf
+0x3C00,0xFC51,0xFCA1,0x3CF0,0xFD41,0x3D10,0x3DE0,0xFDB1,0xFE81,0x3ED0,0x3E20,0xFE71,0x3FC0,0xFF91,0xFF61,0x3F30,//c0~cf
+0xF901,0x3950,0x39A0,0xF9F1,0x3840,0xF811,0xF8E1,0x38B0,0x3B80,0xFBD1,0xFB21,0x3B70,0xFAC1,0x3A90,0x3A60,0xFA31,//d0~df
+0xF601,0x3650,0x36A0,0xF6F1,0x3740,0xF711,0xF7E1,0x37B0,0x3480,0xF4D1,0xF421,0x3470,0xF5C1,0x3590,0x3560,0xF531,//e0~ef
+0x3300,0xF351,0xF3A1,0x33F0,0xF241,0x3210,0x32E0,0xF2B1,0xF181,0x31D0,0x3120,0xF171,0x30C0,0xF091,0xF061,0x3030 //f0~ff
+},
+{
+0x0000,0xFC01,0xB801,0x4400,0x3001,0xCC00,0x8800,0x7401,0x6002,0x9C03,0xD803,0x2402,0x5003,0xAC02,0xE802,0x1403,//00~0f
+0xC004,0x3C05,0x7805,0x8404,0xF005,0x0C04,0x4804,0xB405,0xA006,0x5C07,0x1807,0xE406,0x9007,0x6C06,0x2806,0xD407,//10~1f
+0xC00B,0x3C0A,0x780A,0x840B,0xF00A,0x0C0B,0x480B,0xB40A,0xA009,0x5C08,0x1808,0xE409,0x9008,0x6C09,0x2809,0xD408,//20~2f
+0x000F,0xFC0E,0xB80E,0x440F,0x300E,0xCC0F,0x880F,0x740E,0x600D,0x9C0C,0xD80C,0x240D,0x500C,0xAC0D,0xE80D,0x140C,//30~3f
+0xC015,0x3C14,0x7814,0x8415,0xF014,0x0C15,0x4815,0xB414,0xA017,0x5C16,0x1816,0xE417,0x9016,0x6C17,0x2817,0xD416,//40~4f
+0x0011,0xFC10,0xB810,0x4411,0x3010,0xCC11,0x8811,0x7410,0x6013,0x9C12,0xD812,0x2413,0x5012,0xAC13,0xE813,0x1412,//50~5f
+0x001E,0xFC1F,0xB81F,0x441E,0x301F,0xCC1E,0x881E,0x741F,0x601C,0x9C1D,0xD81D,0x241C,0x501D,0xAC1C,0xE81C,0x141D,//60~6f
+0xC01A,0x3C1B,0x781B,0x841A,0xF01B,0x0C1A,0x481A,0xB41B,0xA018,0x5C19,0x1819,0xE418,0x9019,0x6C18,0x2818,0xD419,//70~7f
+0xC029,0x3C28,0x7828,0x8429,0xF028,0x0C29,0x4829,0xB428,0xA02B,0x5C2A,0x182A,0xE42B,0x902A,0x6C2B,0x282B,0xD42A,//80~8f
+0x002D,0xFC2C,0xB82C,0x442D,0x302C,0xCC2D,0x882D,0x742C,0x602F,0x9C2E,0xD82E,0x242F,0x502E,0xAC2F,0xE82F,0x142E,//90~9f
+0x0022,0xFC23,0xB823,0x4422,0x3023,0xCC22,0x8822,0x7423,0x6020,0x9C21,0xD821,0x2420,0x5021,0xAC20,0xE820,0x1421,//a0~af
+0xC026,0x3C27,0x7827,0x8426,0xF027,0x0C26,0x4826,0xB427,0xA024,0x5C25,0x1825,0xE424,0x9025,0x6C24,0x2824,0xD425,//b0~bf
+0x003C,0xFC3D,0xB83D,0x443C,0x303D,0xCC3C,0x883C,0x743D,0x603E,0x9C3F,0xD83F,0x243E,0x503F,0xAC3E,0xE83E,0x143F,//c0~cf
+0xC038,0x3C39,0x7839,0x8438,0xF039,0x0C38,0x4838,0xB439,0xA03A,0x5C3B,0x183B,0xE43A,0x903B,0x6C3A,0x283A,0xD43B,//d0~df
+0xC037,0x3C36,0x7836,0x8437,0xF036,0x0C37,0x4837,0xB436,0xA035,0x5C34,0x1834,0xE435,0x9034,0x6C35,0x2835,0xD434,//e0~ef
+0x0033,0xFC32,0xB832,0x4433,0x3032,0xCC33,0x8833,0x7432,0x6031,0x9C30,0xD830,0x2431,0x5030,0xAC31,0xE831,0x1430 //f0~ff
+}
 };
-//=================== Table of ModbusCrc values for high–order byte ==================
-static uint8_t uchCRCHTable[] = {
-0x00,0xC0,0xC1,0x01,0xC3,0x03,0x02,0xC2,0xC6,0x06,0x07,0xC7,0x05,0xC5,0xC4,0x04,//00~0f
-0xCC,0x0C,0x0D,0xCD,0x0F,0xCF,0xCE,0x0E,0x0A,0xCA,0xCB,0x0B,0xC9,0x09,0x08,0xC8,//10~1f
-0xD8,0x18,0x19,0xD9,0x1B,0xDB,0xDA,0x1A,0x1E,0xDE,0xDF,0x1F,0xDD,0x1D,0x1C,0xDC,//20~2f
-0x14,0xD4,0xD5,0x15,0xD7,0x17,0x16,0xD6,0xD2,0x12,0x13,0xD3,0x11,0xD1,0xD0,0x10,//30~3f
-0xF0,0x30,0x31,0xF1,0x33,0xF3,0xF2,0x32,0x36,0xF6,0xF7,0x37,0xF5,0x35,0x34,0xF4,//40~4f
-0x3C,0xFC,0xFD,0x3D,0xFF,0x3F,0x3E,0xFE,0xFA,0x3A,0x3B,0xFB,0x39,0xF9,0xF8,0x38,//50~5f
-0x28,0xE8,0xE9,0x29,0xEB,0x2B,0x2A,0xEA,0xEE,0x2E,0x2F,0xEF,0x2D,0xED,0xEC,0x2C,//60~6f
-0xE4,0x24,0x25,0xE5,0x27,0xE7,0xE6,0x26,0x22,0xE2,0xE3,0x23,0xE1,0x21,0x20,0xE0,//70~7f
-0xA0,0x60,0x61,0xA1,0x63,0xA3,0xA2,0x62,0x66,0xA6,0xA7,0x67,0xA5,0x65,0x64,0xA4,//80~8f
-0x6C,0xAC,0xAD,0x6D,0xAF,0x6F,0x6E,0xAE,0xAA,0x6A,0x6B,0xAB,0x69,0xA9,0xA8,0x68,//90~9f
-0x78,0xB8,0xB9,0x79,0xBB,0x7B,0x7A,0xBA,0xBE,0x7E,0x7F,0xBF,0x7D,0xBD,0xBC,0x7C,//a0~af
-0xB4,0x74,0x75,0xB5,0x77,0xB7,0xB6,0x76,0x72,0xB2,0xB3,0x73,0xB1,0x71,0x70,0xB0,//b0~bf
-0x50,0x90,0x91,0x51,0x93,0x53,0x52,0x92,0x96,0x56,0x57,0x97,0x55,0x95,0x94,0x54,//c0~cf
-0x9C,0x5C,0x5D,0x9D,0x5F,0x9F,0x9E,0x5E,0x5A,0x9A,0x9B,0x5B,0x99,0x59,0x58,0x98,//d0~df
-0x88,0x48,0x49,0x89,0x4B,0x8B,0x8A,0x4A,0x4E,0x8E,0x8F,0x4F,0x8D,0x4D,0x4C,0x8C,//e0~ef
-0x44,0x84,0x85,0x45,0x87,0x47,0x46,0x86,0x82,0x42,0x43,0x83,0x41,0x81,0x80,0x40 //f0~ff
-} ;
 
 
 
-uint16_t crc16(uint8_t *puchHeadAddr,uint8_t uchLen)
+/**********************************************************************
+**函数原型： uint16_t crc16_update(uint16_t crc,const uint8_t *puchHeadAddr,size_t len)
+**入口参数:	crc 			:前面数据的CRC，第一段数据为CRC16InitVal
+**			*puchHeadAddr	:数据指针
+**			len				:字节数
+**出口参数:	无
+**返 回 值：包括本段数据的CRC
+**说    明：Modbus CRC分段计算，数据分多次到达时依次调用，每次4个字节查表
+************************************************************************/
+uint16_t crc16_update(uint16_t crc,const uint8_t *puchHeadAddr,size_t len)
 {
-	if (uchLen == 0)
-		return 0xFFFF;
-	uint8_t	uchCRCL = (uint8_t)CRC16InitVal;						//初始化低字节
-	uint8_t	uchCRCH = (CRC16InitVal&0xff00)>>8;			//初始化高字节
-	uint16_t	u16Index;								//CRC表索引
-	
-	while(uchLen--) 									/*通过数据缓冲器*/
+	uint16_t	x;
+
+	while(len >= 4)										//每次4个字节
+	{
+		x = crc ^ ((uint16_t)puchHeadAddr[0] | ((uint16_t)puchHeadAddr[1] << 8));
+		crc = uiCRCTable[3][x & 0xff] ^ uiCRCTable[2][x >> 8] ^
+			  uiCRCTable[1][puchHeadAddr[2]] ^ uiCRCTable[0][puchHeadAddr[3]];
+		puchHeadAddr += 4;
+		len -= 4;
+	}
+	while(len--) 										//剩余字节
 	{
-		u16Index = uchCRCL ^ *puchHeadAddr++;			//计算CRC
-		uchCRCL = uchCRCH ^ uchCRCLTable[u16Index];
-		uchCRCH = uchCRCHTable[u16Index];
+		crc = (crc >> 8) ^ uiCRCTable[0][(crc ^ *puchHeadAddr++) & 0xff];
 	}
-	return ((uint16_t)uchCRCH << 8 | uchCRCL) ;
+	return crc;
+}
+
+/**********************************************************************
+**函数原型： uint16_t crc16(const uint8_t *puchHeadAddr,size_t len)
+**入口参数:	*puchHeadAddr	:数据指针
+**			len				:字节数，0返回CRC16InitVal
+**出口参数:	无
+**返 回 值：Modbus CRC，低字节先发送
+**说    明：整帧计算Modbus CRC
+************************************************************************/
+uint16_t crc16(const uint8_t *puchHeadAddr,size_t len)
+{
+	return crc16_update(CRC16InitVal,puchHeadAddr,len);
 }
@@ -6,10 +6,13 @@ extern "C" {
 #endif
 
 #include <stdint.h>
+#include <stddef.h>
 
 
 //******************************************* public attribute ******************************************
-uint16_t crc16(uint8_t *puchHeadAddr,uint8_t uchLen);
+#define	CRC16InitVal		0xFFFF
+uint16_t crc16(const uint8_t *puchHeadAddr,size_t len);
+uint16_t crc16_update(uint16_t crc,const uint8_t *puchHeadAddr,size_t len);
 
 #ifdef __cplusplus
 }
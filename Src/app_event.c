@@ -0,0 +1,100 @@
+/**
+  ******************************************************************************
+  * @file    app_event.c
+  * @author  Motor Control SDK Team, ST Microelectronics
+  * @brief   Events from interrupts to the main loop. Any interrupt
+  *          posts events, only the main loop takes them. No interrupt
+  *          is disabled while an event is posted.
+  *
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2018 STMicroelectronics International N.V.
+  * All rights reserved.</center></h2>
+  *
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted, provided that the following conditions are met:
+  *
+  * 1. Redistribution of source code must retain the above copyright notice,
+  *    this list of conditions and the following disclaimer.
+  * 2. Redistributions in binary form must reproduce the above copyright notice,
+  *    this list of conditions and the following disclaimer in the documentation
+  *    and/or other materials provided with the distribution.
+  * 3. Neither the name of STMicroelectronics nor the names of other
+  *    contributors to this software may be used to endorse or promote products
+  *    derived from this software without specific written permission.
+  * 4. This software, including modifications and/or derivative works of this
+  *    software, must execute solely and exclusively on microcontroller or
+  *    microprocessor devices manufactured by or for STMicroelectronics.
+  * 5. Redistribution and use of this software other than as permitted under
+  *    this license is void and will automatically terminate your rights under
+  *    this license.
+  *
+  * THIS SOFTWARE IS PROVIDED BY STMICROELECTRONICS AND CONTRIBUTORS "AS IS"
+  * AND ANY EXPRESS, IMPLIED OR STATUTORY WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+  * PARTICULAR PURPOSE AND NON-INFRINGEMENT OF THIRD PARTY INTELLECTUAL PROPERTY
+  * RIGHTS ARE DISCLAIMED TO THE FULLEST EXTENT PERMITTED BY LAW. IN NO EVENT
+  * SHALL STMICROELECTRONICS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+  * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "app_event.h"
+#include "stm32f3xx.h"
+
+/* Private variables ---------------------------------------------------------*/
+static volatile uint32_t wAPP_Events;
+
+/**
+  * @brief  Posts events to the main loop. It can be called from interrupts of
+  *         any priority, exclusive access is retried if another interrupt
+  *         posted in between.
+  * @param  wEvents APP_EVENT_xxx flags
+  * @retval none
+  */
+void APP_EventPost(uint32_t wEvents)
+{
+  uint32_t wPending;
+
+  do
+  {
+    wPending = __LDREXW(&wAPP_Events);
+  } while (__STREXW(wPending | wEvents, &wAPP_Events) != 0u);
+}
+
+/**
+  * @brief  Sleeps until an interrupt occurs, if no events are pending, then
+  *         takes all pending events. Interrupts are disabled while checking,
+  *         a pending interrupt still wakes up WFI, so no event is missed. It
+  *         returns 0 after an interrupt, which didn't post an event (FOC).
+  * @param  none
+  * @retval uint32_t APP_EVENT_xxx flags
+  */
+uint32_t APP_EventWait(void)
+{
+  uint32_t wEvents;
+
+  __disable_irq();
+  if (wAPP_Events == 0u)
+  {
+    __WFI();
+  }
+  __enable_irq();
+
+  do
+  {
+    wEvents = __LDREXW(&wAPP_Events);
+  } while (__STREXW(0u, &wAPP_Events) != 0u);
+
+  return wEvents;
+}
+
+/************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
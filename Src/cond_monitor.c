@@ -0,0 +1,415 @@
+/**
+  ******************************************************************************
+  * @file    cond_monitor.c
+  * @author  Motor Control SDK Team, ST Microelectronics
+  * @brief   Condition monitoring from the spectrum of the motor current.
+  *          Iq is recorded by the FOC interrupt, the analysis runs in
+  *          small steps from the main loop, the FFT one chunk of
+  *          butterflies at a time.
+  *
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2018 STMicroelectronics International N.V.
+  * All rights reserved.</center></h2>
+  *
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted, provided that the following conditions are met:
+  *
+  * 1. Redistribution of source code must retain the above copyright notice,
+  *    this list of conditions and the following disclaimer.
+  * 2. Redistributions in binary form must reproduce the above copyright notice,
+  *    this list of conditions and the following disclaimer in the documentation
+  *    and/or other materials provided with the distribution.
+  * 3. Neither the name of STMicroelectronics nor the names of other
+  *    contributors to this software may be used to endorse or promote products
+  *    derived from this software without specific written permission.
+  * 4. This software, including modifications and/or derivative works of this
+  *    software, must execute solely and exclusively on microcontroller or
+  *    microprocessor devices manufactured by or for STMicroelectronics.
+  * 5. Redistribution and use of this software other than as permitted under
+  *    this license is void and will automatically terminate your rights under
+  *    this license.
+  *
+  * THIS SOFTWARE IS PROVIDED BY STMICROELECTRONICS AND CONTRIBUTORS "AS IS"
+  * AND ANY EXPRESS, IMPLIED OR STATUTORY WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+  * PARTICULAR PURPOSE AND NON-INFRINGEMENT OF THIRD PARTY INTELLECTUAL PROPERTY
+  * RIGHTS ARE DISCLAIMED TO THE FULLEST EXTENT PERMITTED BY LAW. IN NO EVENT
+  * SHALL STMICROELECTRONICS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+  * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "cond_monitor.h"
+#include "mc_api.h"
+#include "mc_math.h"
+#include "drive_parameters.h"
+#include "pmsm_motor_parameters.h"
+#include "arm_math.h"
+
+/* Private define ------------------------------------------------------------*/
+/* Iq is used rather than a phase current: in the rotor frame the electrical
+   frequency is removed and the mechanical signatures appear directly at their
+   own frequency (1x imbalance, 2x eccentricity, bearing defect frequencies). */
+#define CMON_SAMPLE_FREQ_HZ   (PWM_FREQUENCY / (REGULATION_EXECUTION_RATE * CMON_DECIMATION))
+#define CMON_INPUT_SHIFT      3u    /* Gain before the FFT, that scales down by CMON_FFT_LEN */
+#define CMON_FFT_STAGES       8u    /* log2(CMON_FFT_LEN) radix-2 stages */
+/* Chunks keep each CMON_Process call below about 64 MCM_Trig_Functions or
+   32 MCM_Sqrt calls, some 3500 cycles at 72 MHz, a twentieth of the 1 ms
+   tick. The bit reversal, 255 index steps, is the only other step. */
+#define CMON_WINDOW_CHUNK     64u   /* Samples windowed per CMON_Process call */
+#define CMON_FFT_CHUNK        32u   /* Butterflies per CMON_Process call */
+#define CMON_FLOOR_CHUNK      32u   /* Bins summed per CMON_Process call */
+#define CMON_EMA_SHIFT        3u    /* Feature averaging over records: 1/8 */
+#define CMON_BPFO_Q8          (uint32_t)(BEARING_BPFO_RATIO * 256)
+#define CMON_BPFI_Q8          (uint32_t)(BEARING_BPFI_RATIO * 256)
+
+typedef enum
+{
+  CMON_IDLE,
+  CMON_CAPTURE,
+  CMON_WINDOW,
+  CMON_FFT,
+  CMON_REORDER,
+  CMON_FLOOR,
+  CMON_FEATURES
+} CMON_State_t;
+
+/* Private variables ---------------------------------------------------------*/
+/* Complex buffer, samples are recorded in the real parts and transformed in place */
+static q15_t hCMON_Buffer[2u * CMON_FFT_LEN];
+static volatile uint16_t hCMON_Idx = CMON_FFT_LEN;
+static volatile int32_t wCMON_Sum;
+static uint8_t bCMON_Decim;
+static uint8_t bCMON_DecimRatio = CMON_DECIMATION;
+static CMON_State_t CMON_State;
+static uint16_t hCMON_Chunk;
+static uint8_t bCMON_Stage;
+static int16_t hCMON_Speed01Hz;
+static uint32_t wCMON_FloorSum;
+static uint16_t hCMON_Features[CMON_FEATURES_NBR];
+
+/* Private functions ---------------------------------------------------------*/
+static q15_t CMON_Sat(int32_t wValue)
+{
+  return ((q15_t)((wValue > INT16_MAX) ? INT16_MAX : ((wValue < -INT16_MAX) ? -INT16_MAX : wValue)));
+}
+
+/* Butterfly hIdx of a radix-2 decimation in frequency stage, which pairs
+   samples hSpan apart. Both outputs are halved, so the transform scales down
+   by CMON_FFT_LEN as arm_cfft_q15. */
+static void CMON_Butterfly(uint16_t hIdx, uint16_t hSpan, uint8_t bStage)
+{
+  uint16_t hTwiddle = hIdx & (hSpan - 1u);
+  uint16_t hTop = (2u * hIdx) - hTwiddle;
+  q15_t *pTop = &hCMON_Buffer[2u * hTop];
+  q15_t *pBottom = &hCMON_Buffer[2u * (hTop + hSpan)];
+  Trig_Components Trig = MCM_Trig_Functions((int16_t)(((uint32_t)hTwiddle << bStage) * (65536u / CMON_FFT_LEN)));
+  int32_t wRe = ((int32_t)pTop[0] - pBottom[0]) >> 1;
+  int32_t wIm = ((int32_t)pTop[1] - pBottom[1]) >> 1;
+
+  pTop[0] = (q15_t)(((int32_t)pTop[0] + pBottom[0]) >> 1);
+  pTop[1] = (q15_t)(((int32_t)pTop[1] + pBottom[1]) >> 1);
+  /* Difference times cos - j sin of the twiddle angle */
+  pBottom[0] = CMON_Sat(((wRe * Trig.hCos) + (wIm * Trig.hSin)) >> 15);
+  pBottom[1] = CMON_Sat(((wIm * Trig.hCos) - (wRe * Trig.hSin)) >> 15);
+}
+
+static uint16_t CMON_Magnitude(uint16_t hBin)
+{
+  int32_t wRe = hCMON_Buffer[2u * hBin];
+  int32_t wIm = hCMON_Buffer[(2u * hBin) + 1u];
+
+  return ((uint16_t)MCM_Sqrt((wRe * wRe) + (wIm * wIm)));
+}
+
+/* Highest magnitude around a frequency given in 0.1 Hz x 256, leakage of the
+   window spreads a tone over the neighbouring bins */
+static uint16_t CMON_PeakAt(uint32_t wFreq01HzQ8)
+{
+  uint32_t wBin = (((wFreq01HzQ8 * CMON_FFT_LEN) / 256u) + (5u * CMON_SAMPLE_FREQ_HZ)) /
+                  (10u * CMON_SAMPLE_FREQ_HZ);
+  uint16_t hPeak = 0u;
+  uint16_t hMag;
+  uint32_t wIdx;
+
+  if ((wBin == 0u) || (wBin >= (CMON_FFT_LEN / 2u) - 1u))
+  {
+    return (0u);
+  }
+  for (wIdx = wBin - 1u; wIdx <= wBin + 1u; wIdx++)
+  {
+    hMag = CMON_Magnitude((uint16_t)wIdx);
+    if (hMag > hPeak)
+    {
+      hPeak = hMag;
+    }
+  }
+  return (hPeak);
+}
+
+static void CMON_Average(uint8_t bFeature, uint16_t hValue)
+{
+  int32_t wDelta = (int32_t)hValue - (int32_t)hCMON_Features[bFeature];
+
+  if (hCMON_Features[CMON_FEAT_RECORDS] == 0u)
+  {
+    hCMON_Features[bFeature] = hValue;
+  }
+  else
+  {
+    hCMON_Features[bFeature] = (uint16_t)((int32_t)hCMON_Features[bFeature] + (wDelta / (1 << CMON_EMA_SHIFT)));
+  }
+}
+
+/**
+  * @brief  Resets the monitor, no record is in progress.
+  * @retval none
+  */
+void CMON_Init(void)
+{
+  uint8_t bIdx;
+
+  hCMON_Idx = CMON_FFT_LEN;
+  CMON_State = CMON_IDLE;
+  for (bIdx = 0u; bIdx < CMON_FEATURES_NBR; bIdx++)
+  {
+    hCMON_Features[bIdx] = 0u;
+  }
+}
+
+#if defined (CCMRAM)
+#if defined (__ICCARM__)
+#pragma location = ".ccmram"
+#elif defined (__CC_ARM)
+__attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
+#endif
+#endif
+/**
+  * @brief  Records Iq every bCMON_DecimRatio calls while a record is armed.
+  *         It is called by the FOC interrupt after the current controller.
+  * @param  hIq measured Iq, digit
+  * @retval none
+  */
+void CMON_Sample(int16_t hIq)
+{
+  uint16_t hIdx = hCMON_Idx;
+
+  if (hIdx < CMON_FFT_LEN)
+  {
+    if (++bCMON_Decim >= bCMON_DecimRatio)
+    {
+      bCMON_Decim = 0u;
+      hCMON_Buffer[2u * hIdx] = hIq;
+      wCMON_Sum += hIq;
+      hCMON_Idx = hIdx + 1u;
+    }
+  }
+}
+
+/**
+  * @brief  Adapts the decimation to a new FOC rate, so that the records keep
+  *         the CMON_SAMPLE_FREQ_HZ sampling rate. The FOC rate should be a
+  *         multiple of it. It is called while the motor is stopped, when no
+  *         record is in progress.
+  * @param  hFOCFrequencyHz new FOC rate in Hz
+  * @retval none
+  */
+void CMON_SetFOCFrequency(uint16_t hFOCFrequencyHz)
+{
+  uint16_t hRatio = (hFOCFrequencyHz + (CMON_SAMPLE_FREQ_HZ / 2u)) / CMON_SAMPLE_FREQ_HZ;
+
+  bCMON_DecimRatio = (hRatio == 0u) ? 1u : (uint8_t)hRatio;
+}
+
+/**
+  * @brief  Advances the analysis by one step: arming a record while the motor
+  *         runs, windowing, FFT stages, bit reversal, spectral floor and
+  *         signature bins. Each step is short so that it fits the idle time
+  *         of a main loop pass, a record takes some 40 calls.
+  * @retval bool true if the features were updated by this call
+  */
+bool CMON_Process(void)
+{
+  bool bUpdated = false;
+  uint16_t hIdx;
+  uint16_t hEnd;
+  int32_t wMean;
+  int32_t wSample;
+  int32_t wWindow;
+  int32_t wDrift;
+  uint32_t wShaft;
+  uint16_t hRev;
+  uint16_t hBit;
+  q15_t hSwap;
+
+  if (CMON_State != CMON_IDLE && MCI_GetSTMStateMotor1() != RUN)
+  {
+    hCMON_Idx = CMON_FFT_LEN;
+    CMON_State = CMON_IDLE;
+  }
+
+  switch (CMON_State)
+  {
+  case CMON_IDLE:
+    hCMON_Speed01Hz = MC_GetMecSpeedAverageMotor1();
+    if ((MCI_GetSTMStateMotor1() == RUN) && (hCMON_Speed01Hz != 0))
+    {
+      wCMON_Sum = 0;
+      bCMON_Decim = 0u;
+      hCMON_Idx = 0u;
+      CMON_State = CMON_CAPTURE;
+    }
+    break;
+
+  case CMON_CAPTURE:
+    if (hCMON_Idx >= CMON_FFT_LEN)
+    {
+      /* Only records at steady speed are analysed */
+      wDrift = (int32_t)MC_GetMecSpeedAverageMotor1() - hCMON_Speed01Hz;
+      wDrift = (wDrift < 0) ? -wDrift : wDrift;
+      if ((wDrift * 16) > ((hCMON_Speed01Hz < 0) ? -hCMON_Speed01Hz : hCMON_Speed01Hz))
+      {
+        CMON_State = CMON_IDLE;
+      }
+      else
+      {
+        hCMON_Chunk = 0u;
+        CMON_State = CMON_WINDOW;
+      }
+    }
+    break;
+
+  case CMON_WINDOW:
+    /* Mean removal and Hann window, w = (1 - cos(2pi n / N)) / 2 */
+    wMean = wCMON_Sum / (int32_t)CMON_FFT_LEN;
+    hEnd = hCMON_Chunk + CMON_WINDOW_CHUNK;
+    for (hIdx = hCMON_Chunk; hIdx < hEnd; hIdx++)
+    {
+      wWindow = (32768 - MCM_Trig_Functions((int16_t)(hIdx * (65536u / CMON_FFT_LEN))).hCos) / 2;
+      wSample = (((int32_t)hCMON_Buffer[2u * hIdx] - wMean) << CMON_INPUT_SHIFT);
+      hCMON_Buffer[2u * hIdx] = CMON_Sat((wSample * wWindow) >> 15);
+      hCMON_Buffer[(2u * hIdx) + 1u] = 0;
+    }
+    hCMON_Chunk = hEnd;
+    if (hCMON_Chunk >= CMON_FFT_LEN)
+    {
+      hCMON_Chunk = 0u;
+      bCMON_Stage = 0u;
+      CMON_State = CMON_FFT;
+    }
+    break;
+
+  case CMON_FFT:
+    /* Stage bCMON_Stage pairs samples CMON_FFT_LEN / 2^(bCMON_Stage + 1) apart */
+    hEnd = hCMON_Chunk + CMON_FFT_CHUNK;
+    for (hIdx = hCMON_Chunk; hIdx < hEnd; hIdx++)
+    {
+      CMON_Butterfly(hIdx, (uint16_t)((CMON_FFT_LEN / 2u) >> bCMON_Stage), bCMON_Stage);
+    }
+    hCMON_Chunk = hEnd;
+    if (hCMON_Chunk >= (CMON_FFT_LEN / 2u))
+    {
+      hCMON_Chunk = 0u;
+      bCMON_Stage++;
+      if (bCMON_Stage >= CMON_FFT_STAGES)
+      {
+        CMON_State = CMON_REORDER;
+      }
+    }
+    break;
+
+  case CMON_REORDER:
+    /* The stages leave bin k at the bit reversed index of k */
+    hRev = 0u;
+    for (hIdx = 0u; hIdx < (CMON_FFT_LEN - 1u); hIdx++)
+    {
+      if (hIdx < hRev)
+      {
+        hSwap = hCMON_Buffer[2u * hIdx];
+        hCMON_Buffer[2u * hIdx] = hCMON_Buffer[2u * hRev];
+        hCMON_Buffer[2u * hRev] = hSwap;
+        hSwap = hCMON_Buffer[(2u * hIdx) + 1u];
+        hCMON_Buffer[(2u * hIdx) + 1u] = hCMON_Buffer[(2u * hRev) + 1u];
+        hCMON_Buffer[(2u * hRev) + 1u] = hSwap;
+      }
+      hBit = CMON_FFT_LEN / 2u;
+      while (hBit <= hRev)
+      {
+        hRev -= hBit;
+        hBit >>= 1;
+      }
+      hRev += hBit;
+    }
+    wCMON_FloorSum = 0u;
+    hCMON_Chunk = 1u;
+    CMON_State = CMON_FLOOR;
+    break;
+
+  case CMON_FLOOR:
+    hEnd = hCMON_Chunk + CMON_FLOOR_CHUNK;
+    if (hEnd > (CMON_FFT_LEN / 2u))
+    {
+      hEnd = CMON_FFT_LEN / 2u;
+    }
+    for (hIdx = hCMON_Chunk; hIdx < hEnd; hIdx++)
+    {
+      wCMON_FloorSum += CMON_Magnitude(hIdx);
+    }
+    hCMON_Chunk = hEnd;
+    if (hCMON_Chunk >= (CMON_FFT_LEN / 2u))
+    {
+      CMON_State = CMON_FEATURES;
+    }
+    break;
+
+  case CMON_FEATURES:
+    wShaft = (uint32_t)((hCMON_Speed01Hz < 0) ? -hCMON_Speed01Hz : hCMON_Speed01Hz);
+    hCMON_Features[CMON_FEAT_SHAFT_FREQ] = (uint16_t)wShaft;
+    CMON_Average(CMON_FEAT_FLOOR, (uint16_t)(wCMON_FloorSum / ((CMON_FFT_LEN / 2u) - 1u)));
+    CMON_Average(CMON_FEAT_IMBALANCE, CMON_PeakAt(wShaft * 256u));
+    CMON_Average(CMON_FEAT_ECCENTRIC, CMON_PeakAt(wShaft * 512u));
+    CMON_Average(CMON_FEAT_BPFO, CMON_PeakAt(wShaft * CMON_BPFO_Q8));
+    CMON_Average(CMON_FEAT_BPFI, CMON_PeakAt(wShaft * CMON_BPFI_Q8));
+    if (hCMON_Features[CMON_FEAT_RECORDS] < UINT16_MAX)
+    {
+      hCMON_Features[CMON_FEAT_RECORDS]++;
+    }
+    bUpdated = true;
+    CMON_State = CMON_IDLE;
+    break;
+
+  default:
+    CMON_State = CMON_IDLE;
+    break;
+  }
+
+  return (bUpdated);
+}
+
+/**
+  * @brief  Copies the features, see CMON_FEAT_xxx for their layout.
+  * @param  pFeatures array of CMON_FEATURES_NBR elements
+  * @retval none
+  */
+void CMON_GetFeatures(uint16_t *pFeatures)
+{
+  uint8_t bIdx;
+
+  for (bIdx = 0u; bIdx < CMON_FEATURES_NBR; bIdx++)
+  {
+    pFeatures[bIdx] = hCMON_Features[bIdx];
+  }
+}
+
+/************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
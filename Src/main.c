@@ -61,6 +61,12 @@
 #include "user_config.h"
 #include "bsp_can.h"
 #include "CANopen.h"
+#include "CO_FwUpdate.h"
+#include "CO_Flash.h"
+#include "CO_FlashKV.h"
+#include "app_event.h"
+#include "cond_monitor.h"
+#include "stack_monitor.h"
 #include "user_debug.h"
 /* USER CODE END Includes */
 
@@ -76,6 +82,19 @@ TIM_HandleTypeDef htim2;
 
 /* USER CODE BEGIN PV */
 /* Private variables ---------------------------------------------------------*/
+/* CANopen node ID and bit rate [kbit/s]. LSS store configuration keeps them
+   in flash, see CANopen_LoadLSScfg(). Without stored configuration the drive
+   starts with node ID 5, or waits for the LSS master to assign the node ID,
+   see CO_LSSslave.h */
+/* #define CANOPEN_LSS_UNCONFIGURED_ENABLED to wait for the LSS master */
+#ifdef CANOPEN_LSS_UNCONFIGURED_ENABLED
+static uint8_t		CANopenNodeId	=	CO_LSS_NODE_ID_ASSIGNMENT;
+#else
+static uint8_t		CANopenNodeId	=	5;
+#endif
+static uint16_t		CANopenBitRate	=	500;
+/* Emergency error status bit of motor faults, see CANopen_MotorFault() */
+#define CANOPEN_EM_MOTOR_FAULT	CO_EM_MANUFACTURER_START
 
 /* USER CODE END PV */
 
@@ -96,6 +115,12 @@ void HAL_TIM_MspPostInit(TIM_HandleTypeDef *htim);
 
 /* USER CODE BEGIN PFP */
 /* Private function prototypes -----------------------------------------------*/
+static void CANopen_Init(MCP_Handle_t *pMCP);
+static void CANopen_CommunicationReset(MCP_Handle_t *pMCP);
+static bool_t CANopen_MotorIdle(void);
+static void CANopen_MotorFault(bool_t fault);
+static void CANopen_LoadLSScfg(void);
+static void MotorParam_Init(bool_t stored);
 
 /* USER CODE END PFP */
 
@@ -126,9 +151,13 @@ int main(void)
 */
 	
 	CO_NMT_reset_cmd_t reset;
-	CO_ReturnError_t err;
 	uint16_t timer1msPrevious;
 	uint16_t timer1msCopy, timer1msDiff;
+	CO_ReturnError_t odStatus;
+	uint32_t events;
+
+	/* paint the free stack for the high-water mark */
+	SMON_Init();
   /* USER CODE END 1 */
 
   /* MCU Configuration----------------------------------------------------------*/
@@ -137,6 +166,8 @@ int main(void)
   HAL_Init();
 
   /* USER CODE BEGIN Init */
+	/* staged firmware from CANopen program download replaces the application */
+	CO_FwUpdateBoot();
 
   /* USER CODE END Init */
 
@@ -144,7 +175,9 @@ int main(void)
   SystemClock_Config();
 
   /* USER CODE BEGIN SysInit */
-	
+	/* OD parameters, node ID and bit rate from flash key-value store */
+	odStatus	=	CO_FlashInit();
+	CANopen_LoadLSScfg();
 
   reset = CO_RESET_NOT;
   timer1msPrevious = CO_timer1ms;
@@ -161,7 +194,7 @@ int main(void)
   MX_USART3_UART_Init();
   MX_MotorControl_Init();
   MX_USART1_UART_Init();
-  MX_CAN_Init(&hcan,1000);
+  MX_CAN_Init(&hcan,CANopenBitRate);
 
   /* Initialize interrupts */
   MX_NVIC_Init();
@@ -178,14 +211,16 @@ int main(void)
 	LL_USART_EnableIT_RXNE(USART1);   // startup uart1 receive interrupt
 	LL_USART_EnableIT_PE(USART1);  
 		
+		/* unique LSS address of identical drives: serial number from the 96-bit device ID */
+		if(OD_identity.serialNumber == 0){
+			OD_identity.serialNumber	=	HAL_GetUIDw0() ^ HAL_GetUIDw1() ^ HAL_GetUIDw2();
+		}
+		/* PID gains: stored OD parameters or drive defaults */
+		MotorParam_Init((odStatus == CO_ERROR_NO) ? true : false);
 		/* initialize CANopen */
 		reset = CO_RESET_NOT;
-    err = CO_init((int32_t)&hcan , 5, 1000,&pMCP->_Super);		/*( CAN module address , NodeID , bit rate,UI_Handle_t ) */
-    if(err != CO_ERROR_NO){
-            while(1);
-            /* CO_errorReport(CO->em, CO_EM_MEMORY_ALLOCATION_ERROR, CO_EMC_SOFTWARE_INTERNAL, err); */
-    }
-  CO_CANsetNormalMode(CO->CANmodule[0]);		 /* start CAN */
+		CANopen_Init(pMCP);
+		CMON_Init();
 
   /* USER CODE END 2 */
 
@@ -193,7 +228,10 @@ int main(void)
   /* USER CODE BEGIN WHILE */
   while (1)
   {
-		 u1	=	UI_Serial1CommunicationTimeOutHasElapsed();
+		/* sleep until an interrupt posts an event */
+		events	=	APP_EventWait();
+
+		 u1	=	(events & APP_EVENT_MODBUS_FRAME) ? UI_Serial1CommunicationTimeOutHasElapsed() : false;
 		if(u1 ){//uart1 receive data timeout,has already frame data.
 			LL_USART_DisableIT_RXNE(USART1);
 			//memcpy((char*)&mBaseHandle,(char*)&pUSART1._Super,sizeof(mBaseHandle));
@@ -214,13 +252,38 @@ int main(void)
   /* USER CODE END WHILE */
 
   /* USER CODE BEGIN 3 */
-			CO_tmr_Task_thread();
+		if(events & (APP_EVENT_TICK | APP_EVENT_CAN_RX | APP_EVENT_MOTOR_FAULT | APP_EVENT_BACKGROUND)){
+			if(events & APP_EVENT_TICK){
+				/* PDOs and SYNC once per millisecond */
+				CO_tmr_Task_thread();
+				/* current spectrum analysis, one short step per millisecond */
+				if(CMON_Process()){
+					CMON_GetFeatures(OD_conditionMonitor);
+				}
+				/* stack high-water mark, one short scan per millisecond */
+				if(SMON_Process()){
+					SMON_GetMarks(OD_stackMonitor);
+				}
+				/* cycles of the FOC interrupt, measured on every interrupt */
+				SMON_GetCycles(OD_focCycles);
+			}
 			
 			timer1msCopy = CO_timer1ms;
       timer1msDiff = timer1msCopy - timer1msPrevious;
       timer1msPrevious = timer1msCopy;
-            /* CANopen process */
+            /* CANopen process, also right after a message was received */
       reset = CO_process(CO, timer1msDiff, NULL);
+			if(reset == CO_RESET_COMM){
+				/* node ID or bit rate from LSS master, or NMT reset communication */
+				CANopen_CommunicationReset(pMCP);
+			}
+			CANopen_MotorFault((events & APP_EVENT_MOTOR_FAULT) ? true : false);
+			if(CO_FwUpdateProcess(timer1msDiff)){
+				/* flash erase or programming continues without sleeping */
+				APP_EventPost(APP_EVENT_BACKGROUND);
+			}
+			CO_FlashProcess(timer1msDiff);
+		}
 			
 /*			
 			if ( CAN_RxStatus == 'R'){
@@ -700,6 +763,177 @@ static void MX_GPIO_Init(void)
 }
 
 /* USER CODE BEGIN 4 */
+/*
+*	Program download: flash erase and reset only with PWM off, FOC interrupt
+*	does not program the staging bank then.
+*/
+static bool_t CANopen_MotorIdle(void)
+{
+	State_t	state	=	MCI_GetSTMStateMotor1();
+
+	return (state == IDLE || state == STOP || state == STOP_IDLE ||
+			state == FAULT_NOW || state == FAULT_OVER) ? true : false;
+}
+
+/*
+*	Motor fault as CANopen emergency: error code from the first fault, MC fault
+*	flags as info code. It is reset after the fault is acknowledged.
+*/
+static void CANopen_MotorFault(bool_t fault)
+{
+	uint16_t	faults;
+	uint16_t	errorCode;
+	State_t		state;
+
+	if(CO->nodeIdUnconfigured){
+		return;
+	}
+	if(fault){
+		faults	=	MC_GetOccurredFaultsMotor1();
+		if(faults & MC_BREAK_IN){
+			errorCode	=	CO_EMC_CURRENT_OUTPUT;
+		}
+		else if(faults & (MC_OVER_VOLT | MC_UNDER_VOLT)){
+			errorCode	=	CO_EMC_VOLTAGE_INSIDE;
+		}
+		else if(faults & MC_OVER_TEMP){
+			errorCode	=	CO_EMC_TEMP_DEVICE;
+		}
+		else{
+			errorCode	=	CO_EMC_DEVICE_SPECIFIC;
+		}
+		CO_errorReport(CO->em, CANOPEN_EM_MOTOR_FAULT, errorCode, faults);
+	}
+	else if(CO_isError(CO->em, CANOPEN_EM_MOTOR_FAULT)){
+		state	=	MCI_GetSTMStateMotor1();
+		if(state != FAULT_NOW && state != FAULT_OVER){
+			CO_errorReset(CO->em, CANOPEN_EM_MOTOR_FAULT, 0);
+		}
+	}
+}
+
+#if CO_NO_LSS_SERVER == 1
+/*
+*	LSS configure bit timing: accept only bit rates, MX_CAN_Init() can set exactly.
+*/
+static bool_t CANopen_LSScheckBitRate(void *object, uint16_t bitRate)
+{
+	(void)object;
+	return MX_CAN_BitRateSupported(bitRate) ? true : false;
+}
+
+/*
+*	LSS store configuration: node ID and bit rate into flash, only with PWM
+*	off, CPU stalls while flash is programmed.
+*/
+static bool_t CANopen_LSScfgStore(void *object, uint8_t id, uint16_t bitRate)
+{
+	uint8_t	cfg[4];
+
+	(void)object;
+	if(!CANopen_MotorIdle()){
+		return false;
+	}
+	cfg[0]	=	id;
+	cfg[1]	=	0;
+	cfg[2]	=	(uint8_t)bitRate;
+	cfg[3]	=	(uint8_t)(bitRate >> 8);
+	return (CO_FlashKV_write(CO_FLASH_KEY_LSS, cfg, sizeof(cfg)) == CO_ERROR_NO) ? true : false;
+}
+#endif
+
+/*
+*	Node ID and bit rate, stored by LSS store configuration. Invalid or missing
+*	record keeps the defaults.
+*/
+static void CANopen_LoadLSScfg(void)
+{
+	uint8_t		cfg[4];
+	uint16_t	bitRate;
+
+	if(CO_FlashKV_read(CO_FLASH_KEY_LSS, cfg, sizeof(cfg)) != CO_ERROR_NO){
+		return;
+	}
+	bitRate	=	(uint16_t)cfg[2] | ((uint16_t)cfg[3] << 8);
+	if(CO_LSS_NODE_ID_VALID(cfg[0]) && MX_CAN_BitRateSupported(bitRate)){
+		CANopenNodeId	=	cfg[0];
+		CANopenBitRate	=	bitRate;
+	}
+}
+
+/*
+*	Speed and torque PID gains are persistent in CO_OD_EEPROM. If it was loaded
+*	from flash, it sets the regulators, otherwise it follows the drive defaults.
+*/
+static void MotorParam_Init(bool_t stored)
+{
+	if(stored){
+		PID_SetKP(&PIDSpeedHandle_M1, CO_OD_EEPROM.SPEED_KP);
+		PID_SetKI(&PIDSpeedHandle_M1, CO_OD_EEPROM.SPEED_KI);
+		PID_SetKD(&PIDSpeedHandle_M1, CO_OD_EEPROM.SPEED_KD);
+		PID_SetKP(&PIDIqHandle_M1, CO_OD_EEPROM.TORQUE_KP);
+		PID_SetKI(&PIDIqHandle_M1, CO_OD_EEPROM.TORQUE_KI);
+		PID_SetKD(&PIDIqHandle_M1, CO_OD_EEPROM.TORQUE_KD);
+	}
+	else{
+		CO_OD_EEPROM.SPEED_KP	=	PID_GetKP(&PIDSpeedHandle_M1);
+		CO_OD_EEPROM.SPEED_KI	=	PID_GetKI(&PIDSpeedHandle_M1);
+		CO_OD_EEPROM.SPEED_KD	=	PID_GetKD(&PIDSpeedHandle_M1);
+		CO_OD_EEPROM.TORQUE_KP	=	PID_GetKP(&PIDIqHandle_M1);
+		CO_OD_EEPROM.TORQUE_KI	=	PID_GetKI(&PIDIqHandle_M1);
+		CO_OD_EEPROM.TORQUE_KD	=	PID_GetKD(&PIDIqHandle_M1);
+	}
+}
+
+/**
+  * @brief  Initialize CANopen stack with CANopenNodeId and CANopenBitRate and start CAN.
+  * @param  pMCP motor control protocol, accessed by the SDO server
+  * @retval None
+  */
+static void CANopen_Init(MCP_Handle_t *pMCP)
+{
+	CO_ReturnError_t err;
+
+	err = CO_init((int32_t)&hcan , CANopenNodeId, CANopenBitRate,&pMCP->_Super);		/*( CAN module address , NodeID , bit rate,UI_Handle_t ) */
+	if(err != CO_ERROR_NO){
+		while(1);
+		/* CO_errorReport(CO->em, CO_EM_MEMORY_ALLOCATION_ERROR, CO_EMC_SOFTWARE_INTERNAL, err); */
+	}
+#if CO_NO_LSS_SERVER == 1
+	CO_LSSslave_initCheckBitRateCallback(CO->LSSslave, NULL, CANopen_LSScheckBitRate);
+	CO_LSSslave_initCfgStoreCallback(CO->LSSslave, NULL, CANopen_LSScfgStore);
+#endif
+	if(!CO->nodeIdUnconfigured){
+		CO_FlashRegisterODFunctions(CO, CANopen_MotorIdle);
+		CO_FwUpdateRegisterODFunctions(CO, CANopen_MotorIdle);
+	}
+	CO_CANsetNormalMode(CO->CANmodule[0]);		 /* start CAN */
+}
+
+/**
+  * @brief  CANopen communication reset. Node ID and bit rate are taken from
+  *         LSS slave, CAN stays silent for the LSS switch delay before and
+  *         after the bit rate is changed.
+  * @param  pMCP motor control protocol, accessed by the SDO server
+  * @retval None
+  */
+static void CANopen_CommunicationReset(MCP_Handle_t *pMCP)
+{
+	uint16_t	switchDelay	=	0;
+
+#if CO_NO_LSS_SERVER == 1
+	CANopenNodeId	=	CO->LSSslave->pendingNodeID;
+	if(CO->LSSslave->activeBitRate != CANopenBitRate){
+		CANopenBitRate	=	CO->LSSslave->activeBitRate;
+		switchDelay	=	CO->LSSslave->switchDelay;
+	}
+#endif
+	CO_delete((int32_t)&hcan);
+	HAL_Delay(switchDelay);
+	MX_CAN_Init(&hcan,CANopenBitRate);
+	HAL_Delay(switchDelay);
+	CANopen_Init(pMCP);
+}
 
 /* USER CODE END 4 */
 
@@ -54,6 +54,12 @@
 #include "speed_torq_ctrl.h"
 #include "revup_ctrl.h"
 #include "ntc_temperature_sensor.h"
+#include "thermal_model.h"
+#include "load_torque_observer.h"
+#include "notch_filter.h"
+#include "loss_min_ctrl.h"
+#include "deadbeat_curr_ctrl.h"
+#include "regen_brake_ctrl.h"
 #include "digital_output.h"
 #include "r_divider_bus_voltage_sensor.h"
 #include "virtual_bus_voltage_sensor.h"
@@ -64,6 +70,7 @@
 #include "dac_ui.h"
 #include "motor_control_protocol.h"
 #include "usart_frame_communication_protocol.h"
+#include "cobs_frame_communication_protocol.h"
 
 #include "UIIRQHandlerClass.h"
 
@@ -321,6 +328,8 @@ R3_1_F30XParams_t R3_1_F30XParamsM1 =
   .bRepetitionCounter = REP_COUNTER,                       
   .hTafter            = TW_AFTER,                          
   .hTbefore           = TW_BEFORE_R3_1,                    
+  .bOversamplingSectors = CURR_OVERSAMPLING_SECTORS,
+  .hToversampling     = TW_OVERSAMPLING_R3_1,
   .TIMx               = PWM_TIMER_SELECTION,               
                                      
 /* PWM Driving signals initialization ----------------------------------------*/
@@ -406,6 +415,7 @@ PWMC_R3_1_F3_Handle_t PWMC_R3_1_F3_Handle_M1 =
   .wPhaseBOffset = 0,   
   .wPhaseCOffset = 0,   
   .Half_PWMPeriod = PWM_PERIOD_CYCLES/2u,  
+  .bRepetitionCounter = REP_COUNTER,
   .hRegConv = 0,           
   .wADC1_JSQR = 0,      
   .wADC_JSQR_phA = 0,    
@@ -508,6 +518,117 @@ NTC_Handle_t TempSensorParamsM1 =
   .hT0                     = T0_C,											 
 };
 
+TM_Handle_t ThermalModelM1 =
+{
+  .hRatedCurrent       = (uint16_t)RATED_CURRENT,
+  .hPeakCurrent        = (uint16_t)NOMINAL_CURRENT,
+  .hWindingTau_s       = WINDING_THERMAL_TAU_S,
+  .hHousingTau_s       = HOUSING_THERMAL_TAU_S,
+  .hWindingShare       = (uint16_t)(WINDING_THERMAL_SHARE * 32768),
+  .hMaxWindingTemp_C   = WINDING_MAX_TEMP_C,
+  .hRatedAmbientTemp_C = RATED_AMBIENT_TEMP_C,
+  .hDerateBand         = (uint16_t)(WINDING_DERATE_BAND * 32768),
+  .hDecimation         = MEDIUM_FREQUENCY_TASK_RATE/10,  /* 100 ms model step */
+  .hMFTaskFrequencyHz  = MEDIUM_FREQUENCY_TASK_RATE,
+  .pNTC                = &TempSensorParamsM1,
+};
+
+#define LTO_OMEGA        (2.0 * 3.14159265 * LTO_BANDWIDTH_HZ)
+#define LTO_ACCEL_DIGIT  ((double)MOTOR_ACCEL_01HZ_S / NOMINAL_CURRENT)
+
+LTO_Handle_t LoadTorqueObsM1 =
+{
+  .wAccelGain       = (int32_t)(LTO_ACCEL_DIGIT * 16777216.0 / MEDIUM_FREQUENCY_TASK_RATE),
+  .hSpeedGain       = (int16_t)(2.0 * LTO_OMEGA / MEDIUM_FREQUENCY_TASK_RATE * 32768),
+  .wLoadGain        = (int32_t)(LTO_OMEGA * LTO_OMEGA / MEDIUM_FREQUENCY_TASK_RATE /
+                                LTO_ACCEL_DIGIT * 256),
+  .hFeedForwardGain = (int16_t)(LTO_FEEDFORWARD_GAIN * 32767),
+  .hMaxLoad         = (int16_t)IQMAX,
+};
+
+NF_Handle_t NotchFilterM1 =
+{
+  .Stage           =
+  {
+    {SPD_FILTER1_TYPE, SPD_FILTER1_FREQ_HZ, SPD_FILTER1_Q10},
+    {SPD_FILTER2_TYPE, SPD_FILTER2_FREQ_HZ, SPD_FILTER2_Q10},
+  },
+  .bNumStages      = 2,
+  .hSamplingFreqHz = MEDIUM_FREQUENCY_TASK_RATE,
+  .bAutoSearch     = SPD_NOTCH_SEARCH,
+  .bAutoStage      = 0,
+  .hSearchMinHz    = SPD_NOTCH_SEARCH_MIN_HZ,
+  .hSearchRatio    = SPD_NOTCH_SEARCH_RATIO,
+};
+
+LMC_Handle_t LossMinCtrlM1 =
+{
+  .hIdStep        = LMC_ID_STEP,
+  .hIdMin         = LMC_ID_MIN,
+  .hBandWidth01Hz = (uint16_t)((MAX_APPLICATION_SPEED / 6u) / LMC_SPEED_BANDS + 1u),
+  .hSettleTicks   = (uint16_t)((uint32_t)LMC_SETTLE_MS * MEDIUM_FREQUENCY_TASK_RATE / 1000),
+  .hAverageTicks  = (uint16_t)((uint32_t)LMC_AVERAGE_MS * MEDIUM_FREQUENCY_TASK_RATE / 1000),
+  .hHoldWindows   = LMC_HOLD_WINDOWS,
+  .hMinGain_dW    = LMC_MIN_GAIN_DW,
+  .hIqTolerance   = LMC_IQ_TOLERANCE,
+};
+
+/* Bus digit per digit of current and per ohm, Q16 format */
+#define DBC_MAX_BUS_VOLTAGE  (MCU_SUPPLY_VOLTAGE / BUS_ADC_CONV_RATIO)
+#define DBC_DIGIT_PER_OHM    (2.0 * MAX_CURRENT / DBC_MAX_BUS_VOLTAGE * 65536)
+
+DBC_Handle_t DeadbeatCurrCtrlM1 =
+{
+  .wResistGain   = (int32_t)(RS * DBC_DIGIT_PER_OHM),
+  .wInductGainD  = (int32_t)(LS * TF_REGULATION_RATE * DBC_DIGIT_PER_OHM), /* Ld = Lq for SM-PMSM */
+  .wInductGainQ  = (int32_t)(LS * TF_REGULATION_RATE * DBC_DIGIT_PER_OHM),
+  .wBemfGain     = (int32_t)(MOTOR_VOLTAGE_CONSTANT * SQRT_2 / SQRT_3 * 60.0 * TF_REGULATION_RATE /
+                             (1000.0 * POLE_PAIR_NUM * DBC_MAX_BUS_VOLTAGE) * 65536),
+  .hDeadbeatGain = (int16_t)(DBC_DEADBEAT_GAIN * 32767),
+  .hFOCFrequencyHz = TF_REGULATION_RATE,
+};
+
+/**
+  * @brief  PID bus voltage regulator while braking Motor 1, its output is the
+  *         regenerative Iq allowed
+  */
+PID_Handle_t PIDRegenHandle_M1 =
+{
+  .hDefKpGain          = (int16_t)PID_REGEN_KP_DEFAULT,
+  .hDefKiGain          = (int16_t)PID_REGEN_KI_DEFAULT,
+  .wUpperIntegralLimit = (int32_t)IQMAX * REGEN_KIDIV,
+  .wLowerIntegralLimit = 0,
+  .hUpperOutputLimit   = (int16_t)IQMAX,
+  .hLowerOutputLimit   = 0,
+  .hKpDivisor          = (uint16_t)REGEN_KPDIV,
+  .hKiDivisor          = (uint16_t)REGEN_KIDIV,
+  .hKpDivisorPOW2      = (uint16_t)REGEN_KPDIV_LOG,
+  .hKiDivisorPOW2      = (uint16_t)REGEN_KIDIV_LOG,
+  .hDefKdGain          = (int16_t)PID_REGEN_KD_DEFAULT,
+  .hKdDivisor          = (uint16_t)REGEN_KDDIV,
+  .hKdDivisorPOW2      = (uint16_t)REGEN_KDDIV_LOG,
+};
+
+RBC_Handle_t RegenBrakeCtrlM1 =
+{
+  .hVbusRef_d     = REGEN_VBUS_REF_d,
+  .hIdStart_d     = REGEN_ID_START_d,
+  .hBrakeStart_d  = R_BRAKE_SWITCH_OFF_THRES_d,
+  .hIdBrakeMax    = REGEN_ID_MAX,
+  .hMaxRegenIq    = (int16_t)IQMAX,
+  .wNominalSqCurr = (int32_t)NOMINAL_CURRENT * NOMINAL_CURRENT,
+};
+
+#if (ON_OVER_VOLTAGE == TURN_ON_R_BRAKE)
+DOUT_handle_t R_BrakeParamsM1 =
+{
+  .OutputState       = INACTIVE,
+  .hDOutputPort      = R_BRAKE_GPIO_PORT,
+  .hDOutputPin       = R_BRAKE_GPIO_PIN,
+  .bDOutputPolarity  = DISSIPATIVE_BRAKE_POLARITY
+};
+#endif
+
 RDivider_Handle_t RealBusVoltageSensorParamsM1 =
 {
   ._Super                =
@@ -600,6 +721,13 @@ CircleLimitation_Handle_t CircleLimitationM1 =
 												 start */
 };
 
+#ifdef SERIAL_COM_COBS_LINK
+CFCP_Handle_t pUSART =
+{
+    .USARTx              = USART,
+    .USARTIRQn           = USART_IRQ,
+};
+#else
 UFCP_Handle_t pUSART =
 {
     ._Super.RxTimeout = 0, 
@@ -607,5 +735,6 @@ UFCP_Handle_t pUSART =
     .USARTx              = USART,                
     .UIIRQn              = UI_IRQ_USART,         
 };
+#endif
 /******************* (C) COPYRIGHT 2018 STMicroelectronics *****END OF FILE****/
 
@@ -65,6 +65,7 @@
 #include "r_divider_bus_voltage_sensor.h"
 #include "virtual_bus_voltage_sensor.h"
 #include "ntc_temperature_sensor.h"
+#include "thermal_model.h"
 #include "mc_interface.h"
 #include "mc_tuning.h"
 #include "ramp_ext_mngr.h"
@@ -76,6 +77,8 @@
 /* USER CODE BEGIN Includes */
 
 #include "CANopen.h"
+#include "app_event.h"
+#include "cond_monitor.h"
 
 /* USER CODE END Includes */
 
@@ -95,10 +98,6 @@
 #define STOPPERMANENCY_TICKS   (uint16_t)((SYS_TICK_FREQUENCY * STOPPERMANENCY_MS)/ 1000)
 #define STOPPERMANENCY_TICKS2  (uint16_t)((SYS_TICK_FREQUENCY * STOPPERMANENCY_MS2)/ 1000)
 
-/* Un-Comment this macro define in order to activate the smooth
-   braking action on over voltage */
-/* #define  MC.SMOOTH_BRAKING_ACTION_ON_OVERVOLTAGE */
-
 /* USER CODE END Private define */
 
 /* Private variables----------------------------------------------------------*/
@@ -118,8 +117,15 @@ DOUT_handle_t *pR_Brake[NBR_OF_MOTORS];
 DOUT_handle_t *pOCPDisabling[NBR_OF_MOTORS];
 PQD_MotorPowMeas_Handle_t *pMPM[NBR_OF_MOTORS];
 CircleLimitation_Handle_t *pCLM[NBR_OF_MOTORS];
+DBC_Handle_t *pDBC[NBR_OF_MOTORS];             /*!< MC_NULL if the drive uses the PI current controllers */
 RampExtMngr_Handle_t *pREMNG[NBR_OF_MOTORS];   /*!< Ramp manager used to modify the Iq ref
                                                     during the start-up switch over.*/
+static uint16_t hFOCFrequencyHz[NBR_OF_MOTORS] = {TF_REGULATION_RATE}; /*!< FOC rate in use, it
+                                                    changes with FOC_SetPWMFrequency */
+#ifdef ANGLE_DELAY_COMPENSATION
+static uint16_t hFOCUpdateDelay[NBR_OF_MOTORS]; /*!< Averaged angle to PWM update delay,
+                                                    Q15 of the FOC period */
+#endif
 
 static volatile uint16_t hMFTaskCounterM1 = 0;
 static volatile uint16_t hBootCapDelayCounterM1 = 0;
@@ -140,6 +146,9 @@ static void FOC_Clear(uint8_t bMotor);
 static void FOC_InitAdditionalMethods(uint8_t bMotor);
 static void FOC_CalcCurrRef(uint8_t bMotor);
 static uint16_t FOC_CurrController(uint8_t bMotor);
+#ifdef PWM_POLICY_ENABLED
+static void FOC_PWMFrequencyPolicy(uint8_t bMotor);
+#endif
 void TSK_SetChargeBootCapDelayM1(uint16_t hTickCount);
 bool TSK_ChargeBootCapDelayHasElapsedM1(void);
 static void TSK_SetStopPermanencyTimeM1(uint16_t hTickCount);
@@ -203,6 +212,12 @@ void MCboot( MCI_Handle_t* pMCIList[NBR_OF_MOTORS],MCT_Handle_t* pMCTList[NBR_OF
   pPIDId[M1] = &PIDIdHandle_M1;
   pBusSensorM1 = &RealBusVoltageSensorParamsM1;
   RVBS_Init(pBusSensorM1, pwmcHandle[M1]);
+#ifdef DEADBEAT_CURR_CTRL_ENABLED
+  pDBC[M1] = &DeadbeatCurrCtrlM1;
+  DBC_Init(pDBC[M1], &(pBusSensorM1->_Super));
+#else
+  pDBC[M1] = MC_NULL;
+#endif
   
   //Power Measurement M1
   pMPM[M1] = &PQD_MotorPowMeasM1;
@@ -211,6 +226,19 @@ void MCboot( MCI_Handle_t* pMCIList[NBR_OF_MOTORS],MCT_Handle_t* pMCTList[NBR_OF
 
   NTC_Init(&TempSensorParamsM1,pwmcHandle[M1]);    
   pTemperatureSensor[M1] = &TempSensorParamsM1;
+  TM_Init(&ThermalModelM1);
+  LTO_Init(&LoadTorqueObsM1);
+  NF_Init(&NotchFilterM1);
+  LMC_Init(&LossMinCtrlM1);
+#ifdef REGEN_BRAKE_CTRL_ENABLED
+#if (ON_OVER_VOLTAGE == TURN_ON_R_BRAKE)
+  pR_Brake[M1] = &R_BrakeParamsM1;
+  DOUT_SetOutputState(pR_Brake[M1], INACTIVE);
+#else
+  pR_Brake[M1] = MC_NULL;
+#endif
+  RBC_Init(&RegenBrakeCtrlM1, &PIDRegenHandle_M1, pR_Brake[M1]);
+#endif
     
   pREMNG[M1] = &RampExtMngrHFParamsM1;
   REMNG_Init(pREMNG[M1]);
@@ -243,6 +271,7 @@ void MCboot( MCI_Handle_t* pMCIList[NBR_OF_MOTORS],MCT_Handle_t* pMCTList[NBR_OF
   MCT[M1].pFF = MC_NULL;
   MCT[M1].pSCC = MC_NULL;
   MCT[M1].pOTT = MC_NULL;
+  MCT[M1].pLTO = &LoadTorqueObsM1;
   pMCTList[M1] = &MCT[M1];
  
   bMCBootCompleted = 1;
@@ -309,13 +338,46 @@ void TSK_MediumFrequencyTaskM1(void)
   /* USER CODE END MediumFrequencyTask M1 0 */
   State_t StateM1;
   int16_t wAux = 0;
+  uint16_t hThermalLimit;
+  int16_t hUpperLimit;
+  int16_t hLowerLimit;
+#ifdef REGEN_BRAKE_CTRL_ENABLED
+  int32_t wSpeedIntegral;
+#endif
 
   (void) HALL_CalcAvrgMecSpeed01Hz(&HALL_M1,&wAux);
   PQD_CalcElMotorPower(pMPM[M1]);  
+
+  /* Winding thermal model: the dynamic limit saturates the torque ramp and the
+     speed PI, FOC_CalcCurrRef clamps the final Iq reference */
+  hThermalLimit = TM_CalcCurrentLimit(&ThermalModelM1, FOCVars[M1].Iqd);
+  STC_SetNominalCurrent(pSTC[M1], hThermalLimit);
+  hUpperLimit = (int16_t)hThermalLimit;
+  hLowerLimit = -(int16_t)hThermalLimit;
+#ifdef REGEN_BRAKE_CTRL_ENABLED
+  /* The braking side is also bounded by what the DC link can absorb */
+  if ((wAux > 0) && (RBC_GetRegenIqLimit(&RegenBrakeCtrlM1) < hUpperLimit))
+  {
+    hLowerLimit = -RBC_GetRegenIqLimit(&RegenBrakeCtrlM1);
+  }
+  else if ((wAux < 0) && (RBC_GetRegenIqLimit(&RegenBrakeCtrlM1) < hUpperLimit))
+  {
+    hUpperLimit = RBC_GetRegenIqLimit(&RegenBrakeCtrlM1);
+  }
+#endif
+  PID_SetUpperOutputLimit(pPIDSpeed[M1], hUpperLimit);
+  PID_SetLowerOutputLimit(pPIDSpeed[M1], hLowerLimit);
+  PID_SetUpperIntegralTermLimit(pPIDSpeed[M1],
+                                (int32_t)hUpperLimit * (int32_t)PID_GetKIDivisor(pPIDSpeed[M1]));
+  PID_SetLowerIntegralTermLimit(pPIDSpeed[M1],
+                                (int32_t)hLowerLimit * (int32_t)PID_GetKIDivisor(pPIDSpeed[M1]));
   StateM1 = STM_GetState(&STM[M1]);
   switch(StateM1)
   {
   case IDLE_START:
+#ifdef PWM_POLICY_ENABLED
+    FOC_PWMFrequencyPolicy(M1);
+#endif
     R3_1_F30X_TurnOnLowSides(pwmcHandle[M1]);
     TSK_SetChargeBootCapDelayM1(CHARGE_BOOT_CAP_TICKS);
     STM_NextState(&STM[M1],CHARGE_BOOT_CAP);
@@ -365,13 +427,46 @@ void TSK_MediumFrequencyTaskM1(void)
   case RUN:
     /* USER CODE BEGIN MediumFrequencyTask M1 2 */
 	  FOC_InitAdditionalMethods(M1);
+    /* Iqdref still holds the reference applied during the last period */
+    (void) LTO_CalcLoadTorque(&LoadTorqueObsM1, FOCVars[M1].Iqdref.qI_Component1, wAux);
+    if (STC_GetControlMode(pSTC[M1]) == STC_SPEED_MODE)
+    {
+      (void) NF_SearchNotch(&NotchFilterM1, STC_GetMecSpeedRef01Hz(pSTC[M1]) - wAux);
+    }
+#ifdef REGEN_BRAKE_CTRL_ENABLED
+    wSpeedIntegral = PID_GetIntegralTerm(pPIDSpeed[M1]);
+#endif
     /* USER CODE END MediumFrequencyTask M1 2 */
     MCI_ExecBufferedCommands(oMCInterface[M1]);
     FOC_CalcCurrRef(M1);
  
  
     /* USER CODE BEGIN MediumFrequencyTask M1 3 */
-
+#ifdef REGEN_BRAKE_CTRL_ENABLED
+    /* Braking held at its limit: the integral is frozen. The back calculation
+       of PI_Controller would load it with the proportional term, which stalls
+       the deceleration once the limit is released */
+    if (((wAux > 0) && (FOCVars[M1].hTeref <= hLowerLimit)) ||
+        ((wAux < 0) && (FOCVars[M1].hTeref >= hUpperLimit)))
+    {
+      PID_SetIntegralTerm(pPIDSpeed[M1], wSpeedIntegral);
+    }
+#endif
+#ifdef LOSS_MIN_CTRL_ENABLED
+    /* Id of minimum motor power, searched while the speed is settled */
+    if ((FOCVars[M1].bDriveInput == INTERNAL) &&
+        (STC_GetControlMode(pSTC[M1]) == STC_SPEED_MODE))
+    {
+      int16_t hSpeedError = STC_GetMecSpeedRef01Hz(pSTC[M1]) - wAux;
+      bool bSteady = (STC_RampCompleted(pSTC[M1]) == true) &&
+                     (hSpeedError < LMC_SPEED_TOLERANCE_01HZ) &&
+                     (hSpeedError > -LMC_SPEED_TOLERANCE_01HZ);
+
+      FOCVars[M1].Iqdref.qI_Component2 =
+        LMC_CalcIdref(&LossMinCtrlM1, wAux, FOCVars[M1].Iqdref.qI_Component1,
+                      MPM_GetElMotorPowerW(&pMPM[M1]->_super), bSteady);
+    }
+#endif
     /* USER CODE END MediumFrequencyTask M1 3 */
     break;
   case ANY_STOP:
@@ -432,16 +527,153 @@ void FOC_Clear(uint8_t bMotor)
 
   PID_SetIntegralTerm(pPIDIq[bMotor], (int32_t)0);
   PID_SetIntegralTerm(pPIDId[bMotor], (int32_t)0);
+  if (pDBC[bMotor] != MC_NULL)
+  {
+    DBC_Clear(pDBC[bMotor]);
+  }
 
   STC_Clear(pSTC[bMotor]);
 
   PWMC_SwitchOffPWM(pwmcHandle[bMotor]);
 
   /* USER CODE BEGIN FOC_Clear 1 */
+  LTO_Clear(&LoadTorqueObsM1);
+  NF_Clear(&NotchFilterM1);
+  LMC_Clear(&LossMinCtrlM1);
 
   /* USER CODE END FOC_Clear 1 */
 }
 
+/**
+  * @brief  It changes the PWM frequency and the FOC execution rate of a drive.
+  *         Everything derived from the FOC rate is recomputed: timer period,
+  *         repetition counter, integral gains of the current PI, Hall speed
+  *         conversion, HF ramp, deadbeat model and condition monitor
+  *         decimation. The integral gains in use are rescaled, so gains
+  *         restored from flash or set over SDO or Modbus are kept. The
+  *         sampling points are placed from the half period in use at each
+  *         FOC; their times TW_AFTER and TW_BEFORE_R3_1 are timer counts, so
+  *         they do not depend on the PWM frequency. The ADC interrupt is
+  *         disabled while the PWM is off, so the change is atomic with
+  *         respect to the FOC.
+  * @param  bMotor related motor it can be M1 or M2
+  * @param  hPWMFrequencyHz new PWM frequency in Hz
+  * @param  bRegulationRate new FOC execution rate in number of PWM cycles
+  * @retval bool true if applied, false if the drive is not idle or the FOC
+  *         rate exceeds TF_REGULATION_RATE, the rate the CPU load is sized for
+  */
+bool FOC_SetPWMFrequency(uint8_t bMotor, uint16_t hPWMFrequencyHz, uint8_t bRegulationRate)
+{
+  State_t State = STM_GetState(&STM[bMotor]);
+  uint16_t hOldFrequencyHz = hFOCFrequencyHz[bMotor];
+  uint16_t hNewFrequencyHz;
+  uint16_t hPWMPeriod;
+  bool bRetVal = false;
+
+  if (((State == IDLE) || (State == IDLE_START)) && (bRegulationRate != 0u) &&
+      (hPWMFrequencyHz >= bRegulationRate) &&
+      ((hPWMFrequencyHz / bRegulationRate) <= TF_REGULATION_RATE))
+  {
+    hNewFrequencyHz = hPWMFrequencyHz / bRegulationRate;
+    hPWMPeriod = (uint16_t)(((ADV_TIM_CLK_MHz * 1000000uL) / hPWMFrequencyHz) & ~1uL);
+
+    /* The integral gain is Ki * Ts. Rescaling back to the old rate is exact,
+       so a refused step restores the gains in use. */
+    if (PID_ScaleKI(pPIDIq[bMotor], hOldFrequencyHz, hNewFrequencyHz))
+    {
+      if (PID_ScaleKI(pPIDId[bMotor], hOldFrequencyHz, hNewFrequencyHz))
+      {
+        if (R3_1_F30X_SetPWMPeriod(pwmcHandle[bMotor], hPWMPeriod,
+                                   (uint8_t)((2u * bRegulationRate) - 1u)))
+        {
+          bRetVal = true;
+        }
+        else
+        {
+          (void)PID_ScaleKI(pPIDId[bMotor], hNewFrequencyHz, hOldFrequencyHz);
+        }
+      }
+      if (!bRetVal)
+      {
+        (void)PID_ScaleKI(pPIDIq[bMotor], hNewFrequencyHz, hOldFrequencyHz);
+      }
+    }
+
+    if (bRetVal)
+    {
+      hFOCFrequencyHz[bMotor] = hNewFrequencyHz;
+      HALL_SetMeasurementFrequency((HALL_Handle_t *)STC_GetSpeedSensor(pSTC[bMotor]),
+                                   hNewFrequencyHz);
+      pREMNG[bMotor]->FrequencyHz = hNewFrequencyHz;
+      DBC_SetFOCFrequency(&DeadbeatCurrCtrlM1, hNewFrequencyHz);
+      CMON_SetFOCFrequency(hNewFrequencyHz);
+    }
+  }
+  return (bRetVal);
+}
+
+#ifdef PWM_POLICY_ENABLED
+/**
+  * @brief  Selects the PWM frequency of the next run. A hot heatsink or
+  *         winding selects PWM_FREQUENCY_HOT to cut the switching losses, a
+  *         low speed target selects PWM_FREQUENCY_LOW_SPEED for a lower
+  *         current ripple, PWM_FREQUENCY is used otherwise. The winding
+  *         temperature of the thermal model stands for the recent load.
+  * @param  bMotor related motor it can be M1 or M2
+  * @retval none
+  */
+static void FOC_PWMFrequencyPolicy(uint8_t bMotor)
+{
+  static bool bHot = false;
+  static uint16_t hPWMFrequencyHz = PWM_FREQUENCY;
+  int16_t hHeatsinkTemp = NTC_GetAvTemp_C(pTemperatureSensor[bMotor]);
+  int16_t hWindingTemp = TM_GetWindingTemp_C(&ThermalModelM1);
+  int16_t hSpeed = MCI_GetLastRampFinalSpeed(oMCInterface[bMotor]);
+  uint16_t hNewFrequencyHz = PWM_FREQUENCY;
+  uint8_t bNewRate = REGULATION_EXECUTION_RATE;
+
+  if ((hHeatsinkTemp >= PWM_POLICY_HOT_HEATSINK_C) || (hWindingTemp >= PWM_POLICY_HOT_WINDING_C))
+  {
+    bHot = true;
+  }
+  else if ((hHeatsinkTemp < (PWM_POLICY_HOT_HEATSINK_C - PWM_POLICY_HYSTERESIS_C)) &&
+           (hWindingTemp < (PWM_POLICY_HOT_WINDING_C - PWM_POLICY_HYSTERESIS_C)))
+  {
+    bHot = false;
+  }
+  else
+  {
+  }
+
+  if (hSpeed < 0)
+  {
+    hSpeed = -hSpeed;
+  }
+
+  if (bHot)
+  {
+    hNewFrequencyHz = PWM_FREQUENCY_HOT;
+    bNewRate = REGULATION_EXECUTION_RATE_HOT;
+  }
+  else if (hSpeed < (PWM_POLICY_LOW_SPEED_RPM / 6))
+  {
+    hNewFrequencyHz = PWM_FREQUENCY_LOW_SPEED;
+    bNewRate = REGULATION_EXECUTION_RATE_LOW_SPEED;
+  }
+  else
+  {
+  }
+
+  if (hNewFrequencyHz != hPWMFrequencyHz)
+  {
+    if (FOC_SetPWMFrequency(bMotor, hNewFrequencyHz, bNewRate))
+    {
+      hPWMFrequencyHz = hNewFrequencyHz;
+    }
+  }
+}
+#endif
+
 /**
   * @brief  Use this method to initialize additional methods (if any) in
   *         START_TO_RUN state
@@ -468,14 +700,14 @@ void FOC_InitAdditionalMethods(uint8_t bMotor)
 	
 		if(oMCInterface[bMotor]->lastCommand	== MCI_EXECSPEEDRAMP){
 			if( oMCInterface[bMotor]->hFinalSpeed < 0 )
-					HALL_M1.PhaseShift	=	(int16_t)(CO_OD_RAM.HallPhaseN * 65536/360);	
+					HALL_M1.PhaseShift	=	(int16_t)(CO_OD_EEPROM.HallPhaseN * 65536/360);	
 			else
-					HALL_M1.PhaseShift	=	(int16_t)(CO_OD_RAM.HallPhaseP * 65536/360);
+					HALL_M1.PhaseShift	=	(int16_t)(CO_OD_EEPROM.HallPhaseP * 65536/360);
 	} else {
 			if( oMCInterface[bMotor]->hFinalTorque < 0 )
-					HALL_M1.PhaseShift	=	(int16_t)(CO_OD_RAM.HallPhaseN * 65536/360);	
+					HALL_M1.PhaseShift	=	(int16_t)(CO_OD_EEPROM.HallPhaseN * 65536/360);	
 			else
-					HALL_M1.PhaseShift	=	(int16_t)(CO_OD_RAM.HallPhaseP * 65536/360);
+					HALL_M1.PhaseShift	=	(int16_t)(CO_OD_EEPROM.HallPhaseP * 65536/360);
 	}
 	
   /* USER CODE END FOC_InitAdditionalMethods 0 */
@@ -502,6 +734,32 @@ void FOC_CalcCurrRef(uint8_t bMotor)
     FOCVars[bMotor].Iqdref.qI_Component1 = FOCVars[bMotor].hTeref;
   }
   /* USER CODE BEGIN FOC_CalcCurrRef 1 */
+  {
+    int16_t hThermalLimit = (int16_t)TM_GetCurrentLimit(&ThermalModelM1);
+
+    /* Load torque feed forward, the speed PI only corrects the residual,
+       then the resonance filters */
+    if ((FOCVars[bMotor].bDriveInput == INTERNAL) &&
+        (STC_GetControlMode(pSTC[bMotor]) == STC_SPEED_MODE))
+    {
+      int32_t wIqRef = (int32_t)FOCVars[bMotor].Iqdref.qI_Component1 +
+                       (int32_t)LTO_GetFeedForward(&LoadTorqueObsM1);
+
+      FOCVars[bMotor].Iqdref.qI_Component1 = (int16_t)((wIqRef > INT16_MAX) ? INT16_MAX :
+                                                      ((wIqRef < -INT16_MAX) ? -INT16_MAX : wIqRef));
+      FOCVars[bMotor].Iqdref.qI_Component1 = NF_Filter(&NotchFilterM1,
+                                                       FOCVars[bMotor].Iqdref.qI_Component1);
+    }
+
+    if (FOCVars[bMotor].Iqdref.qI_Component1 > hThermalLimit)
+    {
+      FOCVars[bMotor].Iqdref.qI_Component1 = hThermalLimit;
+    }
+    else if (FOCVars[bMotor].Iqdref.qI_Component1 < -hThermalLimit)
+    {
+      FOCVars[bMotor].Iqdref.qI_Component1 = -hThermalLimit;
+    }
+  }
 	/*
     FOCVars[bMotor].hTeref = 0x03e8;		//debug	test use 0x03e8
     FOCVars[bMotor].Iqdref.qI_Component1 = FOCVars[bMotor].hTeref;
@@ -568,6 +826,8 @@ bool TSK_StopPermanencyTimeHasElapsedM1(void)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -593,6 +853,7 @@ uint8_t TSK_HighFrequencyTask(void)
   /* USER CODE END HighFrequencyTask SINGLEDRIVE_1 */
   hFOCreturn = FOC_CurrController(M1);
   /* USER CODE BEGIN HighFrequencyTask SINGLEDRIVE_2 */
+  CMON_Sample(FOCVars[M1].Iqd.qI_Component1);
 
   /* USER CODE END HighFrequencyTask SINGLEDRIVE_2 */
   if(hFOCreturn == MC_FOC_DURATION)
@@ -616,6 +877,8 @@ uint8_t TSK_HighFrequencyTask(void)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -633,20 +896,48 @@ uint16_t FOC_CurrController(uint8_t bMotor)
   Curr_Components Iab, Ialphabeta, Iqd;
   Volt_Components Valphabeta, Vqd;
   int16_t hElAngledpp;
+  int16_t hElSpeedDpp;
   uint16_t hCodeError;
+#ifdef ANGLE_DELAY_COMPENSATION
+  int32_t wAux;
+#endif
 
   hElAngledpp = SPD_GetElAngle(STC_GetSpeedSensor(pSTC[bMotor]));
+  hElSpeedDpp = SPD_GetElSpeedDpp(STC_GetSpeedSensor(pSTC[bMotor]));
+#ifdef ANGLE_DELAY_COMPENSATION
+  /* Averaged over 8 FOC periods, the ISR latency changes from one to the next */
+  wAux = (int32_t)R3_1_F30X_GetUpdateDelay(pwmcHandle[bMotor]) - (int32_t)hFOCUpdateDelay[bMotor];
+  hFOCUpdateDelay[bMotor] = (uint16_t)((int32_t)hFOCUpdateDelay[bMotor] + (wAux / 8));
+#endif
   PWMC_GetPhaseCurrents(pwmcHandle[bMotor], &Iab);
   Ialphabeta = MCM_Clarke(Iab);
   Iqd = MCM_Park(Ialphabeta, hElAngledpp);
-  Vqd.qV_Component1 = PI_Controller(pPIDIq[bMotor],
-            (int32_t)(FOCVars[bMotor].Iqdref.qI_Component1) - Iqd.qI_Component1);
+  if (pDBC[bMotor] != MC_NULL)
+  {
+    Vqd = DBC_Controller(pDBC[bMotor], FOCVars[bMotor].Iqdref, Iqd, hElSpeedDpp);
+  }
+  else
+  {
+    Vqd.qV_Component1 = PI_Controller(pPIDIq[bMotor],
+              (int32_t)(FOCVars[bMotor].Iqdref.qI_Component1) - Iqd.qI_Component1);
 
-  Vqd.qV_Component2 = PI_Controller(pPIDId[bMotor],
-            (int32_t)(FOCVars[bMotor].Iqdref.qI_Component2) - Iqd.qI_Component2);
+    Vqd.qV_Component2 = PI_Controller(pPIDId[bMotor],
+              (int32_t)(FOCVars[bMotor].Iqdref.qI_Component2) - Iqd.qI_Component2);
+  }
   FOCVars[bMotor].Vqd = Vqd;
   Vqd = Circle_Limitation(pCLM[bMotor], Vqd);
+  if (pDBC[bMotor] != MC_NULL)
+  {
+    DBC_SetAppliedVoltage(pDBC[bMotor], Vqd);
+  }
+#ifdef ANGLE_DELAY_COMPENSATION
+  /* Vqd is applied from the next update event for one FOC period: inverse
+     Park at the angle the rotor has in the middle of it */
+  wAux = ((int32_t)hElSpeedDpp * ((int32_t)hFOCUpdateDelay[bMotor] + 16384)) >> 15;
+  Valphabeta = MCM_Rev_Park(Vqd, (int16_t)(hElAngledpp + wAux));
+#else
   Valphabeta = MCM_Rev_Park(Vqd, hElAngledpp);
+#endif
 	//----------debug circute----
 //	Valphabeta.qV_Component1	=	0x051a;
 //	Valphabeta.qV_Component2	=	0x00e2;
@@ -738,7 +1029,20 @@ void TSK_SafetyTask(void)
     UDC_State = UDRC_STATE_EOC;
   }
   /* USER CODE BEGIN TSK_SafetyTask 1 */
-
+#ifdef REGEN_BRAKE_CTRL_ENABLED
+  /* DC link regulation at the safety task rate, on top of the references just
+     computed by the medium frequency task */
+  if (STM_GetState(&STM[M1]) == RUN)
+  {
+    RBC_CalcBusVoltageCtrl(&RegenBrakeCtrlM1, VBS_GetBusVoltage_d(&(pBusSensorM1->_Super)));
+    FOCVars[M1].Iqdref = RBC_CalcCurrRef(&RegenBrakeCtrlM1, FOCVars[M1].Iqdref,
+                                         SPD_GetAvrgMecSpeed01Hz(STC_GetSpeedSensor(pSTC[M1])));
+  }
+  else
+  {
+    RBC_Clear(&RegenBrakeCtrlM1);
+  }
+#endif
   /* USER CODE END TSK_SafetyTask 1 */
   }
 }
@@ -774,6 +1078,7 @@ void TSK_SafetyTask_PWMOFF(uint8_t bMotor)
     FOC_Clear(bMotor);
     MPM_Clear((MotorPowMeas_Handle_t*)pMPM[bMotor]);
     /* USER CODE BEGIN TSK_SafetyTask_PWMOFF 1 */
+    APP_EventPost(APP_EVENT_MOTOR_FAULT);
 
     /* USER CODE END TSK_SafetyTask_PWMOFF 1 */
     break;
@@ -402,6 +402,7 @@ void MCP_ReceivedFrame(MCP_Handle_t *pHandle, uint8_t Code, uint8_t *buffer, uin
       case MC_PROTOCOL_REG_BUS_VOLTAGE:
       case MC_PROTOCOL_REG_HEATS_TEMP:
       case MC_PROTOCOL_REG_MOTOR_POWER:
+      case MC_PROTOCOL_REG_LOAD_TORQUE_EST:
       case MC_PROTOCOL_REG_TORQUE_MEAS:
       case MC_PROTOCOL_REG_FLUX_MEAS:
       case MC_PROTOCOL_REG_FLUXWK_BUS_MEAS:
@@ -0,0 +1,206 @@
+/**
+  ******************************************************************************
+  * @file    stack_monitor.c
+  * @author  Motor Control SDK Team, ST Microelectronics
+  * @brief   Stack painting and high-water mark of the main stack.
+  *          All interrupts and the main loop share MSP, so one mark covers
+  *          the worst nesting seen at run time. The static bound per
+  *          interrupt is computed by Utilities/stack_wcet.py.
+  *
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2018 STMicroelectronics International N.V.
+  * All rights reserved.</center></h2>
+  *
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted, provided that the following conditions are met:
+  *
+  * 1. Redistribution of source code must retain the above copyright notice,
+  *    this list of conditions and the following disclaimer.
+  * 2. Redistributions in binary form must reproduce the above copyright notice,
+  *    this list of conditions and the following disclaimer in the documentation
+  *    and/or other materials provided with the distribution.
+  * 3. Neither the name of STMicroelectronics nor the names of other
+  *    contributors to this software may be used to endorse or promote products
+  *    derived from this software without specific written permission.
+  * 4. This software, including modifications and/or derivative works of this
+  *    software, must execute solely and exclusively on microcontroller or
+  *    microprocessor devices manufactured by or for STMicroelectronics.
+  * 5. Redistribution and use of this software other than as permitted under
+  *    this license is void and will automatically terminate your rights under
+  *    this license.
+  *
+  * THIS SOFTWARE IS PROVIDED BY STMICROELECTRONICS AND CONTRIBUTORS "AS IS"
+  * AND ANY EXPRESS, IMPLIED OR STATUTORY WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+  * PARTICULAR PURPOSE AND NON-INFRINGEMENT OF THIRD PARTY INTELLECTUAL PROPERTY
+  * RIGHTS ARE DISCLAIMED TO THE FULLEST EXTENT PERMITTED BY LAW. IN NO EVENT
+  * SHALL STMICROELECTRONICS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+  * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+  * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+  * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+  * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "stack_monitor.h"
+#include "stm32f3xx.h"
+
+/* Private define ------------------------------------------------------------*/
+#define SMON_PATTERN          0xC5C5C5C5u /* Paint of the unused stack */
+#define SMON_SP_MARGIN        16u   /* Words below SP left unpainted by SMON_Init */
+#define SMON_SCAN_CHUNK       64u   /* Words checked per SMON_Process call */
+
+/* Private variables ---------------------------------------------------------*/
+#if defined (__ICCARM__)
+#pragma section = "CSTACK"
+#elif defined (__GNUC__) && !defined (__CC_ARM)
+extern uint32_t _ebss;              /* From the linker script */
+extern uint32_t _estack;
+#endif
+
+static uint32_t *pSMON_Bottom;
+static uint32_t *pSMON_Top;
+static uint32_t *pSMON_Mark;        /* Lowest word found used */
+static uint32_t *pSMON_Scan;
+static volatile uint16_t hSMON_Cycles[SMON_CYCLES_NBR];
+
+/**
+  * @brief  It paints the free stack, below the current stack pointer.
+  *         It must be called first in main, interrupts may be enabled.
+  * @retval none
+  */
+void SMON_Init(void)
+{
+  uint32_t *pWord;
+  uint32_t *pStop;
+
+#if defined (__ICCARM__)
+  pSMON_Bottom = (uint32_t *)__section_begin("CSTACK");
+  pSMON_Top = (uint32_t *)__section_end("CSTACK");
+#elif defined (__GNUC__) && !defined (__CC_ARM)
+  pSMON_Bottom = &_ebss;
+  pSMON_Top = &_estack;
+#else
+  /* No stack symbols for this tool chain: the marks stay 0 */
+  pSMON_Bottom = MC_NULL;
+  pSMON_Top = MC_NULL;
+#endif
+  pSMON_Mark = pSMON_Top;
+  pSMON_Scan = pSMON_Bottom;
+
+  /* Cycle counter of the FOC interrupt measurement */
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  if (pSMON_Bottom != MC_NULL)
+  {
+    pStop = (uint32_t *)__get_MSP() - SMON_SP_MARGIN;
+    for (pWord = pSMON_Bottom; pWord < pStop; pWord++)
+    {
+      *pWord = SMON_PATTERN;
+    }
+  }
+}
+
+/**
+  * @brief  It looks for the lowest used word of the stack, SMON_SCAN_CHUNK
+  *         words per call, from the bottom up to the last known mark.
+  *         It is called from the main loop once per millisecond.
+  * @retval bool true when a scan is complete and the marks are updated
+  */
+bool SMON_Process(void)
+{
+  uint32_t *pStop;
+  bool bDone = false;
+
+  if (pSMON_Bottom != MC_NULL)
+  {
+    pStop = pSMON_Scan + SMON_SCAN_CHUNK;
+    if (pStop > pSMON_Mark)
+    {
+      pStop = pSMON_Mark;
+    }
+    while ((pSMON_Scan < pStop) && (*pSMON_Scan == SMON_PATTERN))
+    {
+      pSMON_Scan++;
+    }
+    if (pSMON_Scan < pStop)
+    {
+      /* Used word below the mark: the stack went deeper */
+      pSMON_Mark = pSMON_Scan;
+      bDone = true;
+    }
+    else if (pSMON_Scan == pSMON_Mark)
+    {
+      bDone = true;
+    }
+    else
+    {
+    }
+    if (bDone == true)
+    {
+      pSMON_Scan = pSMON_Bottom;
+    }
+  }
+  return (bDone);
+}
+
+/**
+  * @brief  It copies the marks, in bytes, indexed by SMON_MARK_xxx.
+  * @param  pMarks: SMON_MARKS_NBR words
+  * @retval none
+  */
+void SMON_GetMarks(uint16_t *pMarks)
+{
+  pMarks[SMON_MARK_SIZE] = (uint16_t)((uint32_t)(pSMON_Top - pSMON_Bottom) * 4u);
+  pMarks[SMON_MARK_HIGH_WATER] = (uint16_t)((uint32_t)(pSMON_Top - pSMON_Mark) * 4u);
+}
+
+#if defined (CCMRAM)
+#if defined (__ICCARM__)
+#pragma location = ".ccmram"
+#elif defined (__CC_ARM)
+__attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
+#endif
+#endif
+/**
+  * @brief  It records the cycles of the FOC interrupt. It is called last in
+  *         the interrupt, with DWT->CYCCNT read first in the interrupt.
+  * @param  wStart: DWT->CYCCNT at the entry of the interrupt
+  * @retval none
+  */
+void SMON_FocCycles(uint32_t wStart)
+{
+  uint32_t wCycles = DWT->CYCCNT - wStart;
+
+  if (wCycles > 0xFFFFu)
+  {
+    wCycles = 0xFFFFu;
+  }
+  hSMON_Cycles[SMON_CYCLES_LAST] = (uint16_t)wCycles;
+  if (wCycles > hSMON_Cycles[SMON_CYCLES_MAX])
+  {
+    hSMON_Cycles[SMON_CYCLES_MAX] = (uint16_t)wCycles;
+  }
+}
+
+/**
+  * @brief  It copies the FOC interrupt cycles, indexed by SMON_CYCLES_xxx.
+  * @param  pCycles: SMON_CYCLES_NBR words
+  * @retval none
+  */
+void SMON_GetCycles(uint16_t *pCycles)
+{
+  pCycles[SMON_CYCLES_LAST] = hSMON_Cycles[SMON_CYCLES_LAST];
+  pCycles[SMON_CYCLES_MAX] = hSMON_Cycles[SMON_CYCLES_MAX];
+}
+
+/************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
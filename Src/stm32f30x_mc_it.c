@@ -60,12 +60,15 @@
 #include "r3_1_f30X_pwm_curr_fdbk.h"
 #include "Timebase.h"
 #include "stm32f3xx_hal.h"
+#include "CO_FwUpdate.h"
+#include "stack_monitor.h"
 #include "stm32f3xx.h"
 #include "stm32f3xx_it.h"
 #include "mc_config.h"
 
 /* USER CODE BEGIN Includes */
 #include "CANopen.h"
+#include "app_event.h"
 /* USER CODE END Includes */
 
 /** @addtogroup MCSDK
@@ -94,6 +97,8 @@
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -104,7 +109,7 @@ __attribute__((section ("ccmram")))
 void ADC1_2_IRQHandler(void)
 {
   /* USER CODE BEGIN ADC1_2_IRQn 0 */
-
+  uint32_t wFocStart = DWT->CYCCNT;
   /* USER CODE END ADC1_2_IRQn 0 */
   
   // Clear Flags Single or M1
@@ -115,7 +120,10 @@ void ADC1_2_IRQHandler(void)
 
  /* USER CODE END HighFreq M1 */  
   /* USER CODE BEGIN ADC1_2_IRQn 1 */
-
+  /* CANopen program download: one halfword per FOC cycle */
+  CO_FwUpdateProgramStep();
+  /* execution cycles, OD 0x2151 */
+  SMON_FocCycles(wFocStart);
   /* USER CODE END ADC1_2_IRQn 1 */
 }
 
@@ -124,6 +132,8 @@ void ADC1_2_IRQHandler(void)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -146,6 +156,8 @@ void ADC3_IRQHandler(void)
 #pragma location = ".ccmram"
 #elif defined (__CC_ARM)
 __attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
 #endif
 #endif
 /**
@@ -164,6 +176,15 @@ void ADC4_IRQHandler(void)
  /* USER CODE END  ADC4_IRQn 1 */ 
 }
 
+#if defined (CCMRAM)
+#if defined (__ICCARM__)
+#pragma location = ".ccmram"
+#elif defined (__CC_ARM)
+__attribute__((section ("ccmram")))
+#elif defined (__GNUC__)
+__attribute__((section (".ccmram")))
+#endif
+#endif
 /**
   * @brief  This function handles first motor TIMx Update interrupt request.
   * @param  None
@@ -259,6 +280,23 @@ void USART_IRQHandler(void)
  /* USER CODE BEGIN USART_IRQn 0 */
 
   /* USER CODE END USART_IRQn 0 */
+#ifdef SERIAL_COM_COBS_LINK
+  /* No reception timeout: a lost byte only discards the frame up to the next
+     delimiter. The overrun flag is checked first, it also sets RXNE */
+  if (LL_USART_IsActiveFlag_ORE(USART))
+  {
+    CFCP_OVR_IRQ_Handler(&pUSART);
+    LL_USART_ClearFlag_ORE(USART);
+  }
+  if (LL_USART_IsActiveFlag_RXNE(USART))
+  {
+    CFCP_RX_IRQ_Handler(&pUSART,LL_USART_ReceiveData8(USART));
+  }
+  if (LL_USART_IsActiveFlag_TXE(USART) && LL_USART_IsEnabledIT_TXE(USART))
+  {
+    CFCP_TX_IRQ_Handler(&pUSART);
+  }
+#else
   if (LL_USART_IsActiveFlag_RXNE(USART)) /* Valid data have been received */
   {
     uint16_t retVal;
@@ -293,6 +331,7 @@ void USART_IRQHandler(void)
 
     /* USER CODE END USART_ORE   */   
   }
+#endif
   /* USER CODE BEGIN USART_IRQn 1 */
   
   /* USER CODE END USART_IRQn 1 */
@@ -315,6 +354,21 @@ void HardFault_Handler(void)
   while (1)
   {
     {
+#ifdef SERIAL_COM_COBS_LINK
+      if (LL_USART_IsActiveFlag_ORE(USART))
+      {
+        CFCP_OVR_IRQ_Handler(&pUSART);
+        LL_USART_ClearFlag_ORE(USART);
+      }
+      if (LL_USART_IsActiveFlag_RXNE(USART))
+      {
+        CFCP_RX_IRQ_Handler(&pUSART,LL_USART_ReceiveData8(USART));
+      }
+      if (LL_USART_IsActiveFlag_TXE(USART) && LL_USART_IsEnabledIT_TXE(USART))
+      {
+        CFCP_TX_IRQ_Handler(&pUSART);
+      }
+#else
       if (LL_USART_IsActiveFlag_ORE(USART)) /* Overrun error occurs */
       {
         /* Send Overrun message */
@@ -342,6 +396,7 @@ void HardFault_Handler(void)
       else
       {
       }
+#endif
     }  
   }
  /* USER CODE BEGIN HardFault_IRQn 1 */
@@ -362,7 +417,13 @@ void SysTick_Handler(void)
   /* USER CODE END SysTick_IRQn 1 */
   TB_Scheduler();
   /* USER CODE BEGIN SysTick_IRQn 2 */
-	INCREMENT_1MS(CO_timer1ms);							/*	CANopen must be called cyclically	*/
+	/* SysTick runs at SYS_TICK_FREQUENCY, CANopen timers count milliseconds */
+	static uint8_t bCO_TickDivider = 0;
+	if(++bCO_TickDivider >= (uint8_t)(SYS_TICK_FREQUENCY / 1000)){
+		bCO_TickDivider	=	0;
+		INCREMENT_1MS(CO_timer1ms);							/*	CANopen must be called cyclically	*/
+		APP_EventPost(APP_EVENT_TICK);
+	}
   /* USER CODE END SysTick_IRQn 2 */
 }
 
@@ -54,6 +54,7 @@
 #include "ui_exported_functions.h"
 #include "parameters_conversion.h"
 #include "uart1_frame_communication_protocol.h"
+#include "app_event.h"
 #include "CO_motor_interface.h"
 
 
@@ -106,8 +107,13 @@ void UI_TaskInit( uint8_t cfg, uint32_t* pUICfg, uint8_t bMCNum, MCI_Handle_t* p
     pMCP = &MCP_UI_Params;
     pMCP->_Super = UI_Params;
 
+#ifdef SERIAL_COM_COBS_LINK
+    CFCP_Init( & pUSART );
+    MCP_Init(pMCP, (FCP_Handle_t *) & pUSART, & CFCP_Send, & CFCP_Receive, & CFCP_AbortReceive, pDAC, s_fwVer);
+#else
     UFCP_Init( & pUSART );
     MCP_Init(pMCP, (FCP_Handle_t *) & pUSART, & UFCP_Send, & UFCP_Receive, & UFCP_AbortReceive, pDAC, s_fwVer);
+#endif
     UI_Init(&pMCP->_Super, bMCNum, pMCIList, pMCTList, pUICfg); /* Initialize UI and link MC components */
     //UART1 PARAMENT
    // U1FCP_Init( & pUSART1 );
@@ -133,6 +139,11 @@ void UI_Scheduler(void)
   if(bCOM1TimeoutCounter > 1u)
   {
     bCOM1TimeoutCounter--;
+    if(bCOM1TimeoutCounter == 1u)
+    {
+      /* no byte for the timeout, Modbus frame complete */
+      APP_EventPost(APP_EVENT_MODBUS_FRAME);
+    }
   }else{
 //		LL_USART_EnableIT_TXE(USART1);
 	}
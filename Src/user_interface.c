@@ -466,6 +466,14 @@ int32_t UI_GetReg(UI_Handle_t *pHandle, MC_Protocol_REG_t bRegID)
         bRetVal = MPM_GetAvrgElMotorPowerW(pMCT->pMPM);
       }
       break;
+    case MC_PROTOCOL_REG_LOAD_TORQUE_EST:
+      {
+        if (pMCT->pLTO != MC_NULL)
+        {
+          bRetVal = (int32_t)LTO_GetLoadTorque(pMCT->pLTO);
+        }
+      }
+      break;
     case MC_PROTOCOL_REG_DAC_OUT1:
       {
         MC_Protocol_REG_t value = UI_GetDAC(pHandle, DAC_CH0);
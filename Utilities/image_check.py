@@ -0,0 +1,185 @@
+#!/usr/bin/env python3
+"""
+Size budgets and current loop placement of the linked GCC image.
+
+From the sections and symbols of the ELF:
+  - FLASH: every section loaded into FLASH, .data with its load copy, against
+    the application area of the linker script (30 KByte, see CO_FwUpdate.h)
+  - RAM: .data (it holds the loop code from _sccmram to _eccmram and the
+    .RamFunc code of CO_FwUpdate.c), .bss, _Min_Heap_Size and
+    _Min_Stack_Size against RAM
+
+From the disassembly, the call graph of the current loop interrupts
+(LOOP_ROOTS): every function reachable from them must be in RAM, except
+FLASH_ALLOWED and their callees. Calls through function pointers are
+followed with INDIRECT_CALLS of stack_wcet.py. The link time ASSERTs of the
+linker script only check the public functions by name, this walk also finds
+static helpers and functions added later.
+
+The static cycle bound of stack_wcet.py is printed for the image as linked
+and for the same code all in FLASH, the gain of the RAM placement. The
+measured cycles of the FOC interrupt (last, longest) are in OD 0x2151.
+
+Post-build step, the exit status is 1 when a budget is exceeded, a loop
+function is in FLASH or the call graph is incomplete:
+
+  LDFLAGS += -Wl,-Map=build/FOC.map
+  python3 Utilities/image_check.py --elf build/FOC.elf
+"""
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+
+import stack_wcet
+
+# Interrupts of the current loop: FOC and the TIM1 update of R3_1_F30X
+LOOP_ROOTS = ("ADC1_IRQHandler", "TIM1_UP_TIM16_IRQHandler")
+
+# Left in FLASH on purpose, with everything they call
+FLASH_ALLOWED = {
+    "STM_FaultProcessing": "fault path only",
+    "UI_DACUpdate": "debug DAC output",
+}
+
+
+def ld_value(script, name):
+    match = re.search(r"\b%s\s*=\s*(0x[0-9a-fA-F]+|\d+)" % name, script)
+    return int(match.group(1), 0)
+
+
+def ld_region(script, name):
+    match = re.search(r"\b%s\s*\([^)]*\)\s*:\s*ORIGIN\s*=\s*(0x[0-9a-fA-F]+|\d+)\s*,"
+                      r"\s*LENGTH\s*=\s*(\d+)([KM]?)" % name, script)
+    scale = {"": 1, "K": 1024, "M": 1024 * 1024}[match.group(3)]
+    return int(match.group(1), 0), int(match.group(2)) * scale
+
+
+def parse_sizes(text):
+    """size -A -d output: name, size and address of every section"""
+    sections = []
+    for line in text.splitlines():
+        fields = line.split()
+        if len(fields) == 3 and fields[0].startswith(".") and fields[1].isdigit():
+            sections.append((fields[0], int(fields[1]), int(fields[2])))
+    return sections
+
+
+def parse_symbols(text):
+    """objdump -t output: address of every symbol, address of every function"""
+    symbols = {}
+    functions = {}
+    entry = re.compile(r"^([0-9a-f]{8}) (.{7}) (\S+)\s+[0-9a-f]+\s+(\S+)$")
+    for line in text.splitlines():
+        match = entry.match(line)
+        if match:
+            address = int(match.group(1), 16)
+            symbols[match.group(4)] = address
+            if match.group(2)[6] == "F":
+                functions[address & ~1] = match.group(4)
+    return symbols, functions
+
+
+def rename_aliases(text, symbols, functions):
+    """Labels as _sccmram, which objdump may print for the function at the
+    same address, are replaced by the name of the function."""
+    aliases = dict((name, functions[address]) for name, address in symbols.items()
+                   if address in functions and functions[address] != name)
+    if not aliases:
+        return text
+    label = re.compile(r"<(%s)(\+0x[0-9a-f]+)?>" % "|".join(map(re.escape, aliases)))
+    return label.sub(lambda m: "<%s%s>" % (aliases[m.group(1)], m.group(2) or ""), text)
+
+
+def loop_functions(analysis):
+    reached = set()
+    pending = [name for name in LOOP_ROOTS if name in analysis.functions]
+    while pending:
+        name = pending.pop()
+        if name in reached or name in FLASH_ALLOWED or name not in analysis.functions:
+            continue
+        reached.add(name)
+        pending.extend(analysis.callees(name))
+    return reached
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--elf", required=True, help="linked image")
+    parser.add_argument("--ld", default=os.path.join(os.path.dirname(__file__),
+                        "..", "STM32F302R8Tx_FLASH.ld"), help="linker script")
+    parser.add_argument("--objdump", default="arm-none-eabi-objdump")
+    parser.add_argument("--size", default="arm-none-eabi-size")
+    args = parser.parse_args()
+
+    with open(args.ld) as ld:
+        script = ld.read()
+    flash_origin, flash_length = ld_region(script, "FLASH")
+    ram_origin, ram_length = ld_region(script, "RAM")
+    heap = ld_value(script, "_Min_Heap_Size")
+    stack = ld_value(script, "_Min_Stack_Size")
+
+    sections = parse_sizes(subprocess.check_output(
+        [args.size, "-A", "-d", args.elf]).decode())
+    symbols, functions = parse_symbols(subprocess.check_output(
+        [args.objdump, "-t", args.elf]).decode())
+    text = rename_aliases(subprocess.check_output(
+        [args.objdump, "-d", "--no-show-raw-insn", args.elf]).decode(),
+        symbols, functions)
+    failed = False
+
+    def in_flash(address):
+        return flash_origin <= address < flash_origin + flash_length
+
+    def in_ram(address):
+        return ram_origin <= address < ram_origin + ram_length
+
+    code = sum(size for name, size, address in sections if in_flash(address))
+    data = sum(size for name, size, address in sections if name == ".data")
+    bss = sum(size for name, size, address in sections if name == ".bss")
+    loop_code = symbols.get("_eccmram", 0) - symbols.get("_sccmram", 0)
+    flash_used = code + data
+    ram_used = data + bss + heap + stack
+
+    over = flash_used > flash_length
+    failed = failed or over
+    print("FLASH  %6d/%-6d  code and constants %d, .data load copy %d%s" % (
+        flash_used, flash_length, code, data, "  OVER BUDGET" if over else ""))
+    over = ram_used > ram_length
+    failed = failed or over
+    print("RAM    %6d/%-6d  .data %d (loop code %d), .bss %d, heap %d, stack %d%s" % (
+        ram_used, ram_length, data, loop_code, bss, heap, stack,
+        "  OVER BUDGET" if over else ""))
+
+    linked = stack_wcet.Analysis(stack_wcet.parse_disassembly(text, ram_origin=ram_origin), {}, set())
+    reached = loop_functions(linked)
+    left = sorted(name for name in reached if not in_ram(linked.functions[name].address))
+    print("loop   %d functions, %d in RAM, allowed in FLASH: %s" % (
+        len(reached), len(reached) - len(left),
+        ", ".join("%s (%s)" % item for item in sorted(FLASH_ALLOWED.items()))))
+    for name in left:
+        print("error: loop function in FLASH: %s at 0x%08x" % (
+            name, linked.functions[name].address))
+    failed = failed or bool(left)
+
+    all_flash = stack_wcet.Analysis(stack_wcet.parse_disassembly(text, ram_origin=0xFFFFFFFF), {}, set())
+    for name in LOOP_ROOTS:
+        if name not in linked.functions:
+            print("error: %s is not linked" % name)
+            failed = True
+            continue
+        cycles = linked.cycles(name)
+        flash_cycles = all_flash.cycles(name)
+        print("cycles %-26s %6d as linked, %6d all in FLASH (%.1f us, %.1f us)" % (
+            name, cycles, flash_cycles, cycles * 1e6 / stack_wcet.CORE_CLOCK_HZ,
+            flash_cycles * 1e6 / stack_wcet.CORE_CLOCK_HZ))
+
+    for error in sorted(linked.errors):
+        print("error: " + error)
+    return 1 if failed or linked.errors else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,377 @@
+#!/usr/bin/env python3
+"""
+Worst-case stack and execution time of every interrupt of the GCC build.
+
+Inputs:
+  - the .su files written by -fstack-usage: the own frame of every function
+  - the call graph, from the disassembly of the ELF (arm-none-eabi-objdump -d)
+    and its symbol table (arm-none-eabi-objdump -t): the first function of
+    .ccmram shares its address with _sdata and _sccmram, the sizes end the
+    functions before the padding
+  - the tables below: interrupts with priority and budgets, calls through
+    function pointers, loop bounds and library functions without .su
+
+The stack of an interrupt is its deepest call chain. The main stack bound is
+the stack of main plus, for every preemption level, the largest interrupt of
+that level and its exception frame. It is checked against _Min_Stack_Size of
+the linker script. At run time the painted high-water mark is in OD 0x2150.
+
+The execution time is a static upper bound for Cortex-M4 without cache:
+every instruction of a function counts once (every path is covered), a
+function with a backward branch counts LOOP_BOUNDS times, every call site
+adds the bound of the callee. Code in FLASH pays the wait states on taken
+branches and literal loads, code in RAM pays the bus contention on loads.
+
+Post-build step, the exit status is 1 when a budget is exceeded or the
+analysis is incomplete (missing frame, unknown indirect call, unbounded loop
+or recursion on an interrupt path):
+
+  CFLAGS  += -fstack-usage
+  python3 Utilities/stack_wcet.py --elf build/FOC.elf --su build
+
+The fixture of CANopen301/wcettest is checked by make wcettest.
+"""
+
+import argparse
+import bisect
+import os
+import re
+import subprocess
+import sys
+
+CORE_CLOCK_HZ = 72000000
+FLASH_WAIT_STATES = 2
+SRAM_CONTENTION = 1
+RAM_ORIGIN = 0x20000000
+
+# Exception frame with the FPU context (lazy stacking reserves it)
+EXCEPTION_FRAME = 104
+
+# Vector name, preemption priority (NVIC_PRIORITYGROUP_3, see MX_NVIC_Init),
+# stack budget [bytes], execution budget [cycles]
+ISRS = [
+    ("TIM1_BRK_TIM15_IRQHandler", 1, 128, 1500),
+    ("ADC1_IRQHandler",           2, 256, 5000),   # FOC, 7200 cycles at 10 kHz
+    ("TIM2_IRQHandler",           2, 128, 1500),   # Hall sensors
+    ("SysTick_Handler",           3, 320, 6000),   # medium frequency task
+    ("USB_HP_CAN_TX_IRQHandler",  4, 192, 2500),
+    ("USB_LP_CAN_RX0_IRQHandler", 4, 192, 2500),
+    ("CAN_RX1_IRQHandler",        4, 192, 2500),
+    ("USART1_IRQHandler",         4, 160, 1500),   # Modbus
+    ("USART3_IRQHandler",         4, 160, 1500),   # motor control protocol
+]
+
+# Calls through function pointers: caller -> possible targets
+INDIRECT_CALLS = {
+    "PWMC_GetPhaseCurrents": ["R3_1_F30X_GetPhaseCurrents",
+                              "R3_1_F30X_HFCurrentsCalibrationAB",
+                              "R3_1_F30X_HFCurrentsCalibrationC",
+                              "R3_1_F30X_RLGetPhaseCurrents"],
+    "PWMC_SetPhaseVoltage": ["R3_1_F30X_SetADCSampPointSect1",
+                             "R3_1_F30X_SetADCSampPointSect2",
+                             "R3_1_F30X_SetADCSampPointSect3",
+                             "R3_1_F30X_SetADCSampPointSect4",
+                             "R3_1_F30X_SetADCSampPointSect5",
+                             "R3_1_F30X_SetADCSampPointSect6",
+                             "R3_1_F30X_SetADCSampPointCalibration"],
+    "UI_DACExec": ["DAC_Exec"],
+}
+
+# Iterations of the loops of a function
+LOOP_BOUNDS = {
+    "MCM_Sqrt": 6,
+    "R3_1_F30X_SwitchOnPWM": 1,      # waits for an update event, not on a fast path
+}
+
+# Frames of library functions built without -fstack-usage
+LIBRARY_FRAMES = {
+    "memcpy": 16, "memset": 8, "memcmp": 16, "__aeabi_memcpy": 16,
+    "__aeabi_memcpy4": 16, "__aeabi_memset": 8, "__aeabi_memclr": 8,
+    "__aeabi_memclr4": 8, "__aeabi_uldivmod": 24, "__aeabi_ldivmod": 24,
+    "__udivmoddi4": 40, "__aeabi_f2d": 8, "__aeabi_d2f": 8,
+}
+
+CONDITIONS = ("eq", "ne", "cs", "cc", "hs", "lo", "mi", "pl", "vs", "vc",
+              "hi", "ls", "ge", "lt", "gt", "le", "al")
+
+
+class Function(object):
+    def __init__(self, name, address):
+        self.name = name
+        self.address = address
+        self.cycles = 0
+        self.calls = []         # direct callees, one entry per call site
+        self.indirect = 0       # call sites through a register
+        self.loop = False
+        self.end = None         # from the symbol size
+        self.target = None      # of a long branch veneer
+
+
+def parse_su(paths):
+    frames = {}
+    unbounded = set()
+    for top in paths:
+        for root, _dirs, files in os.walk(top):
+            for fname in files:
+                if not fname.endswith(".su"):
+                    continue
+                with open(os.path.join(root, fname)) as su:
+                    for line in su:
+                        fields = line.rstrip("\n").split("\t")
+                        if len(fields) < 3:
+                            continue
+                        name = fields[0].split(":")[-1].split("(")[0].split()[-1]
+                        frames[name] = max(frames.get(name, 0), int(fields[1]))
+                        if "dynamic" in fields[2] and "bounded" not in fields[2]:
+                            unbounded.add(name)
+    return frames, unbounded
+
+
+def instruction_cycles(mnemonic, operands, in_ram):
+    base = mnemonic.split(".")[0]
+    if base in ("udiv", "sdiv"):
+        return 12
+    if base in ("vdiv", "vsqrt") or base.startswith("vdiv") or base.startswith("vsqrt"):
+        return 14
+    if base in ("push", "pop", "ldm", "stm", "vpush", "vpop") or \
+       base.startswith("ldm") or base.startswith("stm"):
+        cycles = 1 + operands.count(",") + 1
+        if base == "pop" and "pc" in operands:
+            cycles += 3
+        return cycles
+    if base.startswith("ldr") or base.startswith("vldr"):
+        cycles = 3 if base.startswith("ldrd") else 2
+        if in_ram:
+            cycles += SRAM_CONTENTION
+        elif "[pc" in operands:
+            cycles += FLASH_WAIT_STATES
+        return cycles
+    if base.startswith("str") or base.startswith("vstr"):
+        return 3 if base.startswith("strd") else 2
+    if base in ("mla", "mls", "smlal", "umlal"):
+        return 2
+    return 1
+
+
+def parse_symbols(text):
+    """objdump -t output: address -> (name, size) of every function"""
+    symbols = {}
+    entry = re.compile(r"^([0-9a-f]{8}) (.{7}) (\S+)\s+([0-9a-f]+)\s+(\S+)$")
+    for line in text.splitlines():
+        match = entry.match(line)
+        if match and match.group(2)[6] == "F":
+            symbols[int(match.group(1), 16) & ~1] = (match.group(5), int(match.group(4), 16))
+    return symbols
+
+
+def is_branch(base):
+    if base in ("b", "bl", "blx", "bx", "cbz", "cbnz"):
+        return True
+    return base.startswith("b") and base[1:] in CONDITIONS
+
+
+def parse_disassembly(text, symbols=None, ram_origin=RAM_ORIGIN):
+    functions = {}
+    current = None
+    starts = sorted(symbols) if symbols else []
+    header = re.compile(r"^([0-9a-f]+) <([^>]+)>:$")
+    insn = re.compile(r"^\s*([0-9a-f]+):\s+([a-z][a-z0-9.]*)\s*(.*)$")
+    data = re.compile(r"(^|\s)\.(word|short|hword|byte|inst)")
+    target = re.compile(r"^(?:0x)?([0-9a-f]+)\s+<([^>+]+)(\+0x[0-9a-f]+)?>")
+    # long branch veneers of GNU ld and thunks of lld
+    veneer = re.compile(r"^__(\w+)_veneer$|^__\w+LongThunk_(\w+)$")
+
+    def function_at(address):
+        index = bisect.bisect_right(starts, address) - 1
+        if index >= 0:
+            name, size = symbols[starts[index]]
+            if address < starts[index] + size:
+                return name
+        return None
+
+    for line in text.splitlines():
+        match = header.match(line)
+        if match:
+            address = int(match.group(1), 16)
+            name = match.group(2)
+            if symbols:
+                if address not in symbols:
+                    # mapping symbol, label or linker symbol
+                    if current is not None and not current.address <= address < current.end:
+                        current = None
+                    continue
+                name = symbols[address][0]
+            elif name.startswith("$"):
+                continue
+            current = Function(name, address)
+            if symbols:
+                current.end = address + symbols[address][1]
+            through = veneer.match(name)
+            if through:
+                current.target = through.group(1) or through.group(2)
+                current.calls.append(current.target)
+            functions[current.name] = current
+            continue
+        match = insn.match(line)
+        if current is None or not match:
+            continue
+        address = int(match.group(1), 16)
+        mnemonic = match.group(2)
+        # comments of GNU (;) and LLVM (@) objdump
+        operands = re.split(r"[;@]", match.group(3))[0].strip()
+        # data of literal pools, printed after its bytes or word
+        if mnemonic.startswith(".") or data.search(match.group(3)) or \
+           (current.end is not None and address >= current.end):
+            continue
+        in_ram = current.address >= ram_origin
+        base = mnemonic.split(".")[0]
+        cycles = instruction_cycles(mnemonic, operands, in_ram)
+        if is_branch(base):
+            cycles += 3
+            if not in_ram:
+                cycles += FLASH_WAIT_STATES
+            dest = target.match(operands.split(",")[-1].strip())
+            if dest:
+                dest_address = int(dest.group(1), 16)
+                callee = function_at(dest_address) or dest.group(2)
+                if callee == current.name:
+                    if dest_address <= address:
+                        current.loop = True
+                else:
+                    # call, or tail call through a plain branch
+                    current.calls.append(callee)
+            elif base in ("blx", "bx") and operands != "lr" and current.target is None:
+                current.indirect += 1
+        current.cycles += cycles
+    return functions
+
+
+class Analysis(object):
+    def __init__(self, functions, frames, unbounded):
+        self.functions = functions
+        self.frames = frames
+        self.unbounded = unbounded
+        self.errors = set()
+        self.stack_memo = {}
+        self.cycle_memo = {}
+
+    def callees(self, name):
+        function = self.functions[name]
+        targets = list(function.calls)
+        if function.indirect:
+            if name in INDIRECT_CALLS:
+                targets += [t for t in INDIRECT_CALLS[name] if t in self.functions]
+            else:
+                self.errors.add("indirect call not in INDIRECT_CALLS: %s" % name)
+        return targets
+
+    def frame(self, name):
+        if name in self.frames:
+            if name in self.unbounded:
+                self.errors.add("dynamic stack: %s" % name)
+            return self.frames[name]
+        if name in LIBRARY_FRAMES:
+            return LIBRARY_FRAMES[name]
+        if name in self.functions and self.functions[name].target:
+            return 0
+        self.errors.add("no stack usage: %s" % name)
+        return 0
+
+    def stack(self, name, path=()):
+        if name in path:
+            self.errors.add("recursion: %s" % " -> ".join(path + (name,)))
+            return 0
+        if name not in self.stack_memo:
+            deepest = 0
+            if name in self.functions:
+                for callee in self.callees(name):
+                    deepest = max(deepest, self.stack(callee, path + (name,)))
+            self.stack_memo[name] = self.frame(name) + deepest
+        return self.stack_memo[name]
+
+    def cycles(self, name, path=()):
+        if name in path or name not in self.functions:
+            return 0
+        if name not in self.cycle_memo:
+            function = self.functions[name]
+            total = function.cycles
+            total += sum(self.cycles(c, path + (name,)) for c in function.calls)
+            if function.indirect and name in INDIRECT_CALLS:
+                targets = [self.cycles(t, path + (name,)) for t in INDIRECT_CALLS[name]]
+                total += function.indirect * max(targets + [0])
+            if function.loop:
+                if name in LOOP_BOUNDS:
+                    total *= LOOP_BOUNDS[name]
+                else:
+                    self.errors.add("loop without bound in LOOP_BOUNDS: %s" % name)
+            self.cycle_memo[name] = total
+        return self.cycle_memo[name]
+
+
+def min_stack_size(ld_path):
+    with open(ld_path) as ld:
+        match = re.search(r"_Min_Stack_Size\s*=\s*(0x[0-9a-fA-F]+|\d+)", ld.read())
+    return int(match.group(1), 0)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--elf", help="linked image")
+    parser.add_argument("--disasm", help="objdump -d output, instead of --elf")
+    parser.add_argument("--syms", help="objdump -t output, with --disasm")
+    parser.add_argument("--su", action="append", required=True,
+                        help="directory with the .su files, repeatable")
+    parser.add_argument("--ld", default=os.path.join(os.path.dirname(__file__),
+                        "..", "STM32F302R8Tx_FLASH.ld"), help="linker script")
+    parser.add_argument("--objdump", default="arm-none-eabi-objdump")
+    args = parser.parse_args()
+
+    symbols = None
+    if args.disasm:
+        with open(args.disasm) as disasm:
+            text = disasm.read()
+        if args.syms:
+            with open(args.syms) as syms:
+                symbols = parse_symbols(syms.read())
+    elif args.elf:
+        text = subprocess.check_output([args.objdump, "-d", "--no-show-raw-insn",
+                                        args.elf]).decode()
+        symbols = parse_symbols(subprocess.check_output(
+            [args.objdump, "-t", args.elf]).decode())
+    else:
+        parser.error("--elf or --disasm is required")
+
+    frames, unbounded = parse_su(args.su)
+    analysis = Analysis(parse_disassembly(text, symbols), frames, unbounded)
+    failed = False
+
+    print("%-28s %4s %14s %22s" % ("interrupt", "prio", "stack/budget", "cycles/budget [us]"))
+    level_stack = {}
+    for name, priority, stack_budget, cycle_budget in ISRS:
+        if name not in analysis.functions:
+            print("%-28s %4d   not linked" % (name, priority))
+            continue
+        stack = analysis.stack(name)
+        cycles = analysis.cycles(name)
+        over = stack > stack_budget or cycles > cycle_budget
+        failed = failed or over
+        print("%-28s %4d %6d/%-6d %8d/%-6d %5.1f%s" % (
+            name, priority, stack, stack_budget, cycles, cycle_budget,
+            cycles * 1e6 / CORE_CLOCK_HZ, "  OVER BUDGET" if over else ""))
+        level_stack[priority] = max(level_stack.get(priority, 0), stack + EXCEPTION_FRAME)
+
+    main_stack = analysis.stack("main") if "main" in analysis.functions else 0
+    total = main_stack + sum(level_stack.values())
+    budget = min_stack_size(args.ld)
+    print("main stack %d + interrupts %d = %d bytes, _Min_Stack_Size %d%s" % (
+        main_stack, total - main_stack, total, budget,
+        "  OVER BUDGET" if total > budget else ""))
+    failed = failed or total > budget
+
+    for error in sorted(analysis.errors):
+        print("error: " + error)
+    return 1 if failed or analysis.errors else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())